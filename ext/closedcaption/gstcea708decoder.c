@@ -20,7 +20,7 @@
  */
 #include <gst/gst.h>
 #include <pango/pangocairo.h>
-#include <gstcea708decoder.h>
+#include "gstcea708decoder.h"
 #include <string.h>
 
 #define GST_CAT_DEFAULT gst_cea708_decoder_debug
@@ -82,7 +82,9 @@ static const gunichar g2_table[CC_MAX_CODE_SET_SIZE] = {
 };
 
 static void gst_cea708dec_print_command_name (Cea708Dec * decoder, guint8 c);
-static void gst_cea708dec_render_pangocairo (cea708Window * window);
+static void gst_cea708dec_render_pangocairo (Cea708Dec * decoder,
+    cea708Window * window, gchar ** rows, PangoFontDescription * desc,
+    const gchar * font_desc);
 static void
 gst_cea708dec_adjust_values_with_fontdesc (cea708Window * window,
     PangoFontDescription * desc);
@@ -155,6 +157,26 @@ static void
 gst_cea708dec_process_dtvcc_byte (Cea708Dec * decoder,
     guint8 * dtvcc_buffer, int index);
 
+/* A rendered row of a window: the white text and, in a separate A8 surface
+ * with a margin of pad pixels, its drop shadow and outline */
+typedef struct
+{
+  cairo_surface_t *text;
+  cairo_surface_t *shadow;
+  gint width;
+  gint height;
+  gint pad;
+  guint generation;
+} Cea708RowImage;
+
+static void
+gst_cea708dec_row_image_free (Cea708RowImage * row)
+{
+  cairo_surface_destroy (row->text);
+  cairo_surface_destroy (row->shadow);
+  g_slice_free (Cea708RowImage, row);
+}
+
 /* For debug, print name of 708 command */
 Cea708Dec *
 gst_cea708dec_create (PangoContext * pango_context)
@@ -165,15 +187,35 @@ gst_cea708dec_create (PangoContext * pango_context)
 
   /* Initialize 708 variables */
   for (i = 0; i < MAX_708_WINDOWS; i++) {
-    decoder->cc_windows[i] = g_malloc (sizeof (cea708Window));
+    decoder->cc_windows[i] = g_malloc0 (sizeof (cea708Window));
     gst_cea708dec_init_window (decoder, i);
   }
   decoder->desired_service = 1;
   decoder->use_ARGB = FALSE;
   decoder->pango_context = pango_context;
+  decoder->row_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) gst_cea708dec_row_image_free);
   return decoder;
 }
 
+void
+gst_cea708dec_free (Cea708Dec * decoder)
+{
+  int i;
+
+  for (i = 0; i < MAX_708_WINDOWS; i++) {
+    g_free (decoder->cc_windows[i]->text_image);
+    g_free (decoder->cc_windows[i]->rendered_markup);
+    g_free (decoder->cc_windows[i]);
+  }
+  g_slist_free_full (decoder->text_list, g_free);
+  g_hash_table_unref (decoder->row_cache);
+  if (decoder->row_layout)
+    g_object_unref (decoder->row_layout);
+  g_free (decoder->default_font_desc);
+  g_free (decoder);
+}
+
 void
 gst_cea708dec_set_service_number (Cea708Dec * decoder, gint8 desired_service)
 {
@@ -397,20 +439,126 @@ gst_cea708dec_print_command_name (Cea708Dec * decoder, guint8 c)
   }
 }
 
+static Cea708RowImage *
+gst_cea708dec_get_row_image (Cea708Dec * decoder, cea708Window * window,
+    const gchar * markup, PangoFontDescription * desc, const gchar * font_desc)
+{
+  Cea708RowImage *row;
+  PangoLayout *layout;
+  PangoRectangle ink_rec, logical_rec;
+  cairo_t *cr;
+  gchar *key;
+
+  /* shadow and outline sizes only depend on the font */
+  key = g_strdup_printf ("%s\n%s", font_desc, markup);
+  row = g_hash_table_lookup (decoder->row_cache, key);
+  if (row) {
+    g_free (key);
+    row->generation = decoder->row_generation;
+    return row;
+  }
+
+  if (!decoder->row_layout)
+    decoder->row_layout = pango_layout_new (decoder->pango_context);
+  layout = decoder->row_layout;
+  pango_layout_set_font_description (layout, desc);
+  pango_layout_set_markup (layout, markup, -1);
+  pango_layout_get_pixel_extents (layout, &ink_rec, &logical_rec);
+
+  row = g_slice_new (Cea708RowImage);
+  row->width = logical_rec.width;
+  row->height = logical_rec.height + logical_rec.y;
+  /* the outline is stroked around the glyph edges */
+  row->pad = (gint) (window->outline_offset / 2) + 2;
+  row->generation = decoder->row_generation;
+
+  row->shadow = cairo_image_surface_create (CAIRO_FORMAT_A8,
+      row->width + window->shadow_offset + 2 * row->pad,
+      row->height + window->shadow_offset + 2 * row->pad);
+  cr = cairo_create (row->shadow);
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+  cairo_translate (cr, row->pad, row->pad);
+
+  /* draw shadow text */
+  cairo_save (cr);
+  cairo_set_source_rgba (cr, 0.0, 0.0, 0.0, 0.5);
+  cairo_translate (cr, window->shadow_offset, window->shadow_offset);
+  pango_cairo_show_layout (cr, layout);
+  cairo_restore (cr);
+
+  /* draw outline text */
+  cairo_save (cr);
+  cairo_set_source_rgb (cr, 0.0, 0.0, 0.0);
+  cairo_set_line_width (cr, window->outline_offset);
+  pango_cairo_layout_path (cr, layout);
+  cairo_stroke (cr);
+  cairo_restore (cr);
+  cairo_destroy (cr);
+
+  row->text = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+      row->width + window->shadow_offset, row->height + window->shadow_offset);
+  cr = cairo_create (row->text);
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+
+  /* set default color */
+  cairo_set_source_rgb (cr, 1.0, 1.0, 1.0);
+  pango_cairo_show_layout (cr, layout);
+  cairo_destroy (cr);
+
+  g_hash_table_insert (decoder->row_cache, key, row);
+
+  return row;
+}
+
+static gboolean
+gst_cea708dec_row_image_is_stale (gpointer key, Cea708RowImage * row,
+    Cea708Dec * decoder)
+{
+  return row->generation != decoder->row_generation;
+}
+
+static gint
+gst_cea708dec_get_row_x (cea708Window * window, gint width, gint row_width)
+{
+  switch (gst_cea708dec_get_align_mode (window->justify_mode)) {
+    case PANGO_ALIGN_CENTER:
+      return (width - row_width) / 2;
+    case PANGO_ALIGN_RIGHT:
+      return width - row_width;
+    default:
+      return 0;
+  }
+}
+
 static void
-gst_cea708dec_render_pangocairo (cea708Window * window)
+gst_cea708dec_render_pangocairo (Cea708Dec * decoder, cea708Window * window,
+    gchar ** rows, PangoFontDescription * desc, const gchar * font_desc)
 {
   cairo_t *crt;
   cairo_surface_t *surf;
   cairo_t *shadow;
   cairo_surface_t *surf_shadow;
-  PangoRectangle ink_rec, logical_rec;
-  gint width, height;
-
-  pango_layout_get_pixel_extents (window->layout, &ink_rec, &logical_rec);
-
-  width = logical_rec.width + window->shadow_offset;
-  height = logical_rec.height + logical_rec.y + window->shadow_offset;
+  Cea708RowImage **images;
+  guint i, n_rows = g_strv_length (rows);
+  gint text_width = 0, width, height = 0, x, y;
+
+  decoder->row_generation++;
+
+  /* Rows are rendered on their own and cached, only rows that were not
+   * displayed recently go through pango */
+  images = g_new (Cea708RowImage *, n_rows);
+  for (i = 0; i < n_rows; i++) {
+    images[i] =
+        gst_cea708dec_get_row_image (decoder, window, rows[i], desc, font_desc);
+    text_width = MAX (text_width, images[i]->width);
+    height += images[i]->height;
+  }
+  width = text_width + window->shadow_offset;
+  height += window->shadow_offset;
 
   surf_shadow = cairo_image_surface_create (CAIRO_FORMAT_A8, width, height);
   shadow = cairo_create (surf_shadow);
@@ -420,23 +568,6 @@ gst_cea708dec_render_pangocairo (cea708Window * window)
   cairo_paint (shadow);
   cairo_set_operator (shadow, CAIRO_OPERATOR_OVER);
 
-  /* draw shadow text */
-  cairo_save (shadow);
-  cairo_set_source_rgba (shadow, 0.0, 0.0, 0.0, 0.5);
-  cairo_translate (shadow, window->shadow_offset, window->shadow_offset);
-  pango_cairo_show_layout (shadow, window->layout);
-  cairo_restore (shadow);
-
-  /* draw outline text */
-  cairo_save (shadow);
-  cairo_set_source_rgb (shadow, 0.0, 0.0, 0.0);
-  cairo_set_line_width (shadow, window->outline_offset);
-  pango_cairo_layout_path (shadow, window->layout);
-  cairo_stroke (shadow);
-  cairo_restore (shadow);
-
-  cairo_destroy (shadow);
-
   window->text_image = g_realloc (window->text_image, 4 * width * height);
 
   surf = cairo_image_surface_create_for_data (window->text_image,
@@ -446,13 +577,18 @@ gst_cea708dec_render_pangocairo (cea708Window * window)
   cairo_paint (crt);
   cairo_set_operator (crt, CAIRO_OPERATOR_OVER);
 
-  /* set default color */
-  cairo_set_source_rgb (crt, 1.0, 1.0, 1.0);
+  /* stack the rows, aligned the way pango aligns the lines of a layout */
+  for (i = 0, y = 0; i < n_rows; y += images[i]->height, i++) {
+    x = gst_cea708dec_get_row_x (window, text_width, images[i]->width);
 
-  cairo_save (crt);
-  /* draw text */
-  pango_cairo_show_layout (crt, window->layout);
-  cairo_restore (crt);
+    cairo_set_source_surface (shadow, images[i]->shadow, x - images[i]->pad,
+        y - images[i]->pad);
+    cairo_paint (shadow);
+    cairo_set_source_surface (crt, images[i]->text, x, y);
+    cairo_paint (crt);
+  }
+  cairo_destroy (shadow);
+  g_free (images);
 
   /* composite shadow with offset */
   cairo_set_operator (crt, CAIRO_OPERATOR_DEST_OVER);
@@ -464,6 +600,11 @@ gst_cea708dec_render_pangocairo (cea708Window * window)
   cairo_surface_destroy (surf);
   window->image_width = width;
   window->image_height = height;
+  window->image_serial++;
+
+  if (g_hash_table_size (decoder->row_cache) > CEA708_ROW_CACHE_SIZE)
+    g_hash_table_foreach_remove (decoder->row_cache,
+        (GHRFunc) gst_cea708dec_row_image_is_stale, decoder);
 }
 
 static void
@@ -1361,12 +1502,15 @@ gst_cea708dec_init_window (Cea708Dec * decoder, guint window_id)
 
   window->v_offset = 0;
   window->h_offset = 0;
-  window->layout = NULL;
   window->shadow_offset = 0;
   window->outline_offset = 0;
   window->image_width = 0;
   window->image_height = 0;
+  g_free (window->text_image);
   window->text_image = NULL;
+  g_free (window->rendered_markup);
+  window->rendered_markup = NULL;
+  window->image_serial++;
 
 }
 
@@ -1586,9 +1730,10 @@ gst_cea708dec_render_text (Cea708Dec * decoder, GSList ** text_list,
     gint length, guint window_id)
 {
   gchar *out_str = NULL;
-  PangoAlignment align_mode;
+  gchar *rendered_markup;
   PangoFontDescription *desc;
   gchar *font_desc;
+  gchar **rows;
   cea708Window *window = decoder->cc_windows[window_id];
 
   if (length > 0) {
@@ -1598,23 +1743,37 @@ gst_cea708dec_render_text (Cea708Dec * decoder, GSList ** text_list,
     g_slist_foreach (*text_list, get_cea708dec_bufcat, out_str);
     GST_LOG ("rendering '%s'", out_str);
     g_slist_free (*text_list);
-    window->layout = pango_layout_new (decoder->pango_context);
-    align_mode = gst_cea708dec_get_align_mode (window->justify_mode);
-    pango_layout_set_alignment (window->layout, (PangoAlignment) align_mode);
-    pango_layout_set_markup (window->layout, out_str, length);
     if (!decoder->default_font_desc)
       font_desc = g_strdup_printf ("%s %s", font_names[0], pen_size_names[1]);
     else
       font_desc = g_strdup (decoder->default_font_desc);
+
+    /* windows are redisplayed a lot without their text changing */
+    rendered_markup = g_strdup_printf ("%d\n%s\n%s", window->justify_mode,
+        font_desc, out_str);
+    if (window->text_image
+        && g_strcmp0 (window->rendered_markup, rendered_markup) == 0) {
+      GST_LOG ("window %d unchanged, keeping its image", window_id);
+      g_free (rendered_markup);
+      g_free (font_desc);
+      g_free (out_str);
+      *text_list = NULL;
+      return TRUE;
+    }
+
     desc = pango_font_description_from_string (font_desc);
     if (desc) {
       GST_INFO ("font description set: %s", font_desc);
-      pango_layout_set_font_description (window->layout, desc);
       gst_cea708dec_adjust_values_with_fontdesc (window, desc);
+      rows = g_strsplit (out_str, "\n", -1);
+      gst_cea708dec_render_pangocairo (decoder, window, rows, desc, font_desc);
+      g_strfreev (rows);
       pango_font_description_free (desc);
-      gst_cea708dec_render_pangocairo (window);
+      g_free (window->rendered_markup);
+      window->rendered_markup = rendered_markup;
     } else {
       GST_ERROR ("font description parse failed: %s", font_desc);
+      g_free (rendered_markup);
     }
     g_free (font_desc);
     g_free (out_str);
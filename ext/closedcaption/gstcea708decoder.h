@@ -97,6 +97,8 @@ G_BEGIN_DECLS
 #define WINDOW_MAX_ROWS 15
 /* max column width */
 #define WINDOW_MAX_COLS 42
+/* rendered rows not used by the last render are dropped above this */
+#define CEA708_ROW_CACHE_SIZE 64
 /* The linebuffer contains text for 1 line pango text corresponding to 1 line of 708 text.
   * The linebuffer could be a lot larger than the window text because of required markup.
   * example <u> </u> for underline.
@@ -435,12 +437,15 @@ typedef struct
   /* The char array that text is written into, using the current pen position */
   cea708char text[WINDOW_MAX_ROWS][WINDOW_MAX_COLS];
 
-  PangoLayout *layout;
   gdouble shadow_offset;
   gdouble outline_offset;
   guchar *text_image;
   gint image_width;
   gint image_height;
+  /* markup, font and justification text_image was rendered from */
+  gchar *rendered_markup;
+  /* changes whenever text_image is rendered again */
+  guint image_serial;
   gboolean updated;
 } cea708Window;
 
@@ -455,6 +460,12 @@ struct _Cea708Dec
   gchar *default_font_desc;
   PangoContext *pango_context;
 
+  /* rendered rows by font and markup, shared by all windows. Roll-up
+   * captions only need to render the new row this way */
+  GHashTable *row_cache;
+  PangoLayout *row_layout;
+  guint row_generation;
+
   /* a counter used to ignore bytes in CC text stream following commands */
   gint8 output_ignore;
   /* most recent timestamp from userdata */
@@ -473,6 +484,7 @@ struct _Cea708Dec
 };
 
 Cea708Dec *gst_cea708dec_create (PangoContext * pango_context);
+void gst_cea708dec_free (Cea708Dec * decoder);
 void
 gst_cea708dec_set_service_number (Cea708Dec * decoder, gint8 desired_service);
 gboolean
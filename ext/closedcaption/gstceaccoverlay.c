@@ -287,6 +287,19 @@ gst_base_cea_cc_overlay_class_init (GstCeaCcOverlayClass * klass)
 
 }
 
+static void
+gst_cea_cc_overlay_clear_window_rects (GstCeaCcOverlay * overlay)
+{
+  guint i;
+
+  for (i = 0; i < MAX_708_WINDOWS; i++) {
+    if (overlay->window_rects[i]) {
+      gst_video_overlay_rectangle_unref (overlay->window_rects[i]);
+      overlay->window_rects[i] = NULL;
+    }
+  }
+}
+
 static void
 gst_cea_cc_overlay_finalize (GObject * object)
 {
@@ -300,6 +313,8 @@ gst_cea_cc_overlay_finalize (GObject * object)
     gst_video_overlay_composition_unref (overlay->next_composition);
     overlay->next_composition = NULL;
   }
+  gst_cea_cc_overlay_clear_window_rects (overlay);
+  gst_cea708dec_free (overlay->decoder);
 
   g_mutex_clear (&overlay->lock);
   g_cond_clear (&overlay->cond);
@@ -1264,6 +1279,7 @@ gst_cea_cc_overlay_create_and_push_buffer (GstCeaCcOverlay * overlay)
   cea708Window *window;
   guint v_anchor = 0;
   guint h_anchor = 0;
+  gint x, y;
   GstVideoOverlayComposition *comp = NULL;
   GstVideoOverlayRectangle *rect = NULL;
   GST_CEA_CC_OVERLAY_LOCK (overlay);
@@ -1275,28 +1291,6 @@ gst_cea_cc_overlay_create_and_push_buffer (GstCeaCcOverlay * overlay)
       continue;
     }
     if (!window->deleted && window->visible && window->text_image != NULL) {
-      GST_DEBUG_OBJECT (overlay, "Allocating buffer");
-      outbuf =
-          gst_buffer_new_and_alloc (window->image_width *
-          window->image_height * 4);
-      gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-      window_image = map.data;
-      if (decoder->use_ARGB) {
-        memset (window_image, 0,
-            window->image_width * window->image_height * 4);
-        gst_buffer_add_video_meta (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
-            GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB, window->image_width,
-            window->image_height);
-      } else {
-        for (n = 0; n < window->image_width * window->image_height; n++) {
-          window_image[n * 4] = window_image[n * 4 + 1] = 0;
-          window_image[n * 4 + 2] = window_image[n * 4 + 3] = 128;
-        }
-        gst_buffer_add_video_meta (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
-            GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, window->image_width,
-            window->image_height);
-      }
-
       v_anchor = window->screen_vertical * overlay->height / 100;
       switch (overlay->default_window_h_pos) {
         case GST_CEA_CC_OVERLAY_WIN_H_LEFT:
@@ -1355,10 +1349,46 @@ gst_cea_cc_overlay_create_and_push_buffer (GstCeaCcOverlay * overlay)
         default:
           break;
       }
+
+      /* the window is displayed again as it was, the rectangle can be shared
+       * with the previous composition */
+      rect = overlay->window_rects[window_id];
+      if (rect && overlay->window_serials[window_id] == window->image_serial) {
+        gst_video_overlay_rectangle_get_render_rectangle (rect, &x, &y, NULL,
+            NULL);
+        if (x == window->h_offset && y == window->v_offset) {
+          GST_LOG_OBJECT (overlay, "reusing rectangle of window %u", window_id);
+          if (comp == NULL) {
+            comp = gst_video_overlay_composition_new (rect);
+          } else {
+            gst_video_overlay_composition_add_rectangle (comp, rect);
+          }
+          continue;
+        }
+      }
+
+      GST_DEBUG_OBJECT (overlay, "Allocating buffer");
+      outbuf =
+          gst_buffer_new_and_alloc (window->image_width *
+          window->image_height * 4);
+      gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+      window_image = map.data;
       if (decoder->use_ARGB) {
+        memset (window_image, 0,
+            window->image_width * window->image_height * 4);
+        gst_buffer_add_video_meta (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
+            GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB, window->image_width,
+            window->image_height);
         gst_cea_cc_overlay_image_to_argb (window_image, window,
             window->image_width * 4);
       } else {
+        for (n = 0; n < window->image_width * window->image_height; n++) {
+          window_image[n * 4] = window_image[n * 4 + 1] = 0;
+          window_image[n * 4 + 2] = window_image[n * 4 + 3] = 128;
+        }
+        gst_buffer_add_video_meta (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
+            GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, window->image_width,
+            window->image_height);
         gst_cea_cc_overlay_image_to_ayuv (window_image, window,
             window->image_width * 4);
       }
@@ -1376,7 +1406,10 @@ gst_cea_cc_overlay_create_and_push_buffer (GstCeaCcOverlay * overlay)
       } else {
         gst_video_overlay_composition_add_rectangle (comp, rect);
       }
-      gst_video_overlay_rectangle_unref (rect);
+      if (overlay->window_rects[window_id])
+        gst_video_overlay_rectangle_unref (overlay->window_rects[window_id]);
+      overlay->window_rects[window_id] = rect;
+      overlay->window_serials[window_id] = window->image_serial;
       gst_buffer_unref (outbuf);
     }
   }
@@ -1947,6 +1980,7 @@ gst_cea_cc_overlay_change_state (GstElement * element,
       /* pop_text will broadcast on the GCond and thus also make the video
        * chain exit if it's waiting for a text buffer */
       gst_cea_cc_overlay_pop_text (overlay);
+      gst_cea_cc_overlay_clear_window_rects (overlay);
       GST_CEA_CC_OVERLAY_UNLOCK (overlay);
       break;
     default:
@@ -94,6 +94,10 @@ struct _GstCeaCcOverlay
   guint64 current_comp_start_time;
   GstVideoOverlayComposition *next_composition;
   guint64 next_comp_start_time;
+  /* last rectangle of each window and the image_serial it was made from,
+   * reused while a window neither changes nor moves */
+  GstVideoOverlayRectangle *window_rects[MAX_708_WINDOWS];
+  guint window_serials[MAX_708_WINDOWS];
   GstCeaCcOverlayWinHPos default_window_h_pos;
   gboolean cc_pad_linked;
   gboolean video_flushing;
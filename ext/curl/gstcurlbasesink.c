@@ -26,6 +26,11 @@
  * This is a network sink that uses libcurl as a client to upload data to
  * a server (e.g. a HTTP/FTP server).
  *
+ * Up to #GstCurlBaseSink:queue-size buffers are queued for the transfer
+ * thread, so the upload does not stop every time it has to wait for the
+ * next buffer. Subclasses that support it (FTP and SFTP) resume an upload
+ * that was interrupted by a connection loss from where the server left off.
+ *
  * ## Example launch line (upload a JPEG file to an HTTP server)
  * |[
  * gst-launch-1.0 filesrc location=image.jpg ! jpegparse ! curlsink  \
@@ -70,6 +75,11 @@
 #define DEFAULT_URL                    "localhost:5555"
 #define DEFAULT_TIMEOUT                30
 #define DEFAULT_QOS_DSCP               0
+#define DEFAULT_QUEUE_SIZE             16
+#define DEFAULT_RESUME_ATTEMPTS        3
+
+/* sent data kept for resuming, more than the server can have buffered */
+#define RESUME_WINDOW_SIZE             (8 * 1024 * 1024)
 
 #define DSCP_MIN                       0
 #define DSCP_MAX                       63
@@ -91,7 +101,9 @@ enum
   PROP_USER_PASSWD,
   PROP_FILE_NAME,
   PROP_TIMEOUT,
-  PROP_QOS_DSCP
+  PROP_QOS_DSCP,
+  PROP_QUEUE_SIZE,
+  PROP_RESUME_ATTEMPTS
 };
 
 /* Object class function declarations */
@@ -122,6 +134,8 @@ static size_t gst_curl_base_sink_transfer_read_cb (void *ptr, size_t size,
     size_t nmemb, void *stream);
 static size_t gst_curl_base_sink_transfer_write_cb (void *ptr, size_t size,
     size_t nmemb, void *stream);
+static int gst_curl_base_sink_transfer_seek_cb (void *stream,
+    curl_off_t offset, int origin);
 static size_t gst_curl_base_sink_transfer_data_buffer (GstCurlBaseSink * sink,
     void *curl_ptr, size_t block_size, guint * last_chunk);
 #ifndef GST_DISABLE_GST_DEBUG
@@ -138,8 +152,14 @@ static gboolean gst_curl_base_sink_wait_for_data_unlocked
     (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_new_file_notify_unlocked
     (GstCurlBaseSink * sink);
-static void gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked
+static gboolean gst_curl_base_sink_next_buffer_unlocked
     (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_buffer_done_unlocked (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_clear_sent_unlocked (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_clear_queue_unlocked (GstCurlBaseSink * sink);
+static gboolean gst_curl_base_sink_schedule_resume (GstCurlBaseSink * sink,
+    const gchar * reason);
+static void gst_curl_base_sink_resume_transfer (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_wait_for_response (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_got_response_notify (GstCurlBaseSink * sink);
@@ -154,7 +174,23 @@ G_DEFINE_TYPE (GstCurlBaseSink, gst_curl_base_sink, GST_TYPE_BASE_SINK);
 static gboolean
 gst_curl_base_sink_default_has_buffered_data_unlocked (GstCurlBaseSink * sink)
 {
-  return sink->transfer_buf->len > 0;
+  return sink->transfer_buf->len > 0 || !g_queue_is_empty (&sink->queue);
+}
+
+static gboolean
+gst_curl_base_sink_has_data_unlocked (GstCurlBaseSink * sink)
+{
+  return sink->transfer_cond->data_available || sink->transfer_buffer != NULL
+      || !g_queue_is_empty (&sink->queue);
+}
+
+static gboolean
+gst_curl_base_sink_can_resume_unlocked (GstCurlBaseSink * sink)
+{
+  GstCurlBaseSinkClass *klass = GST_CURL_BASE_SINK_GET_CLASS (sink);
+
+  return klass->prepare_resume_unlocked != NULL && sink->resume_attempts > 0
+      && !sink->buffer_per_transfer && !sink->is_live;
 }
 
 static gboolean
@@ -234,6 +270,17 @@ gst_curl_base_sink_class_init (GstCurlBaseSinkClass * klass)
           "Quality of Service, differentiated services code point (0 default)",
           DSCP_MIN, DSCP_MAX, DEFAULT_QOS_DSCP,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
+      g_param_spec_uint ("queue-size", "Queue size",
+          "Maximum number of buffers queued for the transfer thread",
+          1, G_MAXUINT, DEFAULT_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RESUME_ATTEMPTS,
+      g_param_spec_uint ("resume-attempts", "Resume attempts",
+          "Number of times the upload of a file is resumed after the "
+          "connection was lost, if the protocol allows it (0 = disabled)",
+          0, G_MAXUINT, DEFAULT_RESUME_ATTEMPTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_static_pad_template (element_class, &sinktemplate);
 }
@@ -244,7 +291,6 @@ gst_curl_base_sink_init (GstCurlBaseSink * sink)
   sink->transfer_buf = g_malloc (sizeof (TransferBuffer));
   sink->transfer_cond = g_malloc (sizeof (TransferCondition));
   g_cond_init (&sink->transfer_cond->cond);
-  sink->transfer_cond->data_sent = FALSE;
   sink->transfer_cond->data_available = FALSE;
   sink->transfer_cond->wait_for_response = FALSE;
   sink->timeout = DEFAULT_TIMEOUT;
@@ -255,6 +301,13 @@ gst_curl_base_sink_init (GstCurlBaseSink * sink)
   sink->error = NULL;
   sink->flow_ret = GST_FLOW_OK;
   sink->is_live = FALSE;
+  sink->flushing = FALSE;
+  sink->queue_size = DEFAULT_QUEUE_SIZE;
+  sink->resume_attempts = DEFAULT_RESUME_ATTEMPTS;
+  g_queue_init (&sink->queue);
+  g_queue_init (&sink->sent);
+  sink->transfer_buffer = NULL;
+  sink->sent_bytes = 0;
 }
 
 static void
@@ -268,6 +321,7 @@ gst_curl_base_sink_finalize (GObject * gobject)
   }
 
   gst_curl_base_sink_transfer_cleanup (this);
+  gst_curl_base_sink_clear_queue_unlocked (this);
   g_cond_clear (&this->transfer_cond->cond);
   g_free (this->transfer_cond);
   g_free (this->transfer_buf);
@@ -289,9 +343,8 @@ gst_curl_base_sink_transfer_thread_notify_unlocked (GstCurlBaseSink * sink)
   GST_LOG ("more data to send");
 
   sink->transfer_cond->data_available = TRUE;
-  sink->transfer_cond->data_sent = FALSE;
   sink->transfer_cond->wait_for_response = TRUE;
-  g_cond_signal (&sink->transfer_cond->cond);
+  g_cond_broadcast (&sink->transfer_cond->cond);
 }
 
 void
@@ -300,7 +353,7 @@ gst_curl_base_sink_transfer_thread_close (GstCurlBaseSink * sink)
   GST_OBJECT_LOCK (sink);
   GST_LOG_OBJECT (sink, "setting transfer thread close flag");
   sink->transfer_thread_close = TRUE;
-  g_cond_signal (&sink->transfer_cond->cond);
+  g_cond_broadcast (&sink->transfer_cond->cond);
   GST_OBJECT_UNLOCK (sink);
 
   if (sink->transfer_thread != NULL) {
@@ -310,6 +363,21 @@ gst_curl_base_sink_transfer_thread_close (GstCurlBaseSink * sink)
   }
 }
 
+/* Waits until everything queued so far has been handed to curl, or the
+ * transfer failed */
+void
+gst_curl_base_sink_wait_for_queue_drain_unlocked (GstCurlBaseSink * sink)
+{
+  GST_LOG ("waiting for queued buffers to be sent");
+
+  while (sink->transfer_thread != NULL && sink->flow_ret == GST_FLOW_OK &&
+      !sink->flushing && (sink->transfer_buffer != NULL ||
+          !g_queue_is_empty (&sink->queue))) {
+    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+  }
+  GST_LOG ("queue drained");
+}
+
 void
 gst_curl_base_sink_set_live (GstCurlBaseSink * sink, gboolean live)
 {
@@ -338,9 +406,6 @@ static GstFlowReturn
 gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 {
   GstCurlBaseSink *sink;
-  GstMapInfo map;
-  guint8 *data;
-  size_t size;
   GstFlowReturn ret;
   gchar *error;
 
@@ -348,12 +413,7 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 
   sink = GST_CURL_BASE_SINK (bsink);
 
-  gst_buffer_map (buf, &map, GST_MAP_READ);
-  data = map.data;
-  size = map.size;
-
-  if (size == 0) {
-    gst_buffer_unmap (buf, &map);
+  if (gst_buffer_get_size (buf) == 0) {
     return GST_FLOW_OK;
   }
 
@@ -365,8 +425,6 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     goto done;
   }
 
-  g_assert (sink->transfer_cond->data_available == FALSE);
-
   /* if there is no transfer thread created, lets create one */
   if (sink->transfer_thread == NULL) {
     if (!gst_curl_base_sink_transfer_start_unlocked (sink)) {
@@ -375,24 +433,38 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     }
   }
 
-  /* make data available for the transfer thread and notify */
-  sink->transfer_buf->ptr = data;
-  sink->transfer_buf->len = size;
-  sink->transfer_buf->offset = 0;
-  gst_curl_base_sink_transfer_thread_notify_unlocked (sink);
+  /* wait for room in the queue. The transfer thread notifies whenever it
+   * takes a buffer, and when an error has occurred. */
+  while (g_queue_get_length (&sink->queue) >= sink->queue_size &&
+      sink->flow_ret == GST_FLOW_OK && !sink->flushing) {
+    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+  }
+  if (sink->flow_ret != GST_FLOW_OK || sink->flushing) {
+    goto done;
+  }
+
+  /* queue the data for the transfer thread and notify */
+  GST_LOG ("queueing buffer of %" G_GSIZE_FORMAT " bytes",
+      gst_buffer_get_size (buf));
+  g_queue_push_tail (&sink->queue, gst_buffer_ref (buf));
+  sink->transfer_cond->wait_for_response = TRUE;
+  g_cond_broadcast (&sink->transfer_cond->cond);
 
-  /* wait for the transfer thread to send the data. This will be notified
-   * either when transfer is completed by the curl read callback or by
-   * the thread function if an error has occurred. */
-  gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked (sink);
+  /* only start queueing once the first buffer is on its way, so problems
+   * setting up the transfer are reported for that buffer */
+  while (!sink->transfer_established && sink->flow_ret == GST_FLOW_OK &&
+      !sink->flushing) {
+    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+  }
 
 done:
-  gst_buffer_unmap (buf, &map);
-
   /* Hand over error from transfer thread to streaming thread */
   error = sink->error;
   sink->error = NULL;
   ret = sink->flow_ret;
+  if (ret == GST_FLOW_OK && sink->flushing) {
+    ret = GST_FLOW_FLUSHING;
+  }
   GST_OBJECT_UNLOCK (sink);
 
   if (error != NULL) {
@@ -440,12 +512,13 @@ gst_curl_base_sink_start (GstBaseSink * bsink)
   sink = GST_CURL_BASE_SINK (bsink);
 
   /* reset flags */
-  sink->transfer_cond->data_sent = FALSE;
   sink->transfer_cond->data_available = FALSE;
   sink->transfer_cond->wait_for_response = FALSE;
   sink->transfer_thread_close = FALSE;
   sink->new_file = TRUE;
   sink->flow_ret = GST_FLOW_OK;
+  sink->flushing = FALSE;
+  sink->resume_pending = FALSE;
 
   if ((sink->fdset = gst_poll_new (TRUE)) == NULL) {
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
@@ -469,6 +542,10 @@ gst_curl_base_sink_stop (GstBaseSink * bsink)
     sink->fdset = NULL;
   }
 
+  GST_OBJECT_LOCK (sink);
+  gst_curl_base_sink_clear_queue_unlocked (sink);
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -482,6 +559,12 @@ gst_curl_base_sink_unlock (GstBaseSink * bsink)
   GST_LOG_OBJECT (sink, "Flushing");
   gst_poll_set_flushing (sink->fdset, TRUE);
 
+  /* wake up render waiting for the transfer thread */
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = TRUE;
+  g_cond_broadcast (&sink->transfer_cond->cond);
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -495,6 +578,10 @@ gst_curl_base_sink_unlock_stop (GstBaseSink * bsink)
   GST_LOG_OBJECT (sink, "No longer flushing");
   gst_poll_set_flushing (sink->fdset, FALSE);
 
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = FALSE;
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -542,6 +629,15 @@ gst_curl_base_sink_set_property (GObject * object, guint prop_id,
         gst_curl_base_sink_setup_dscp_unlocked (sink);
         GST_DEBUG_OBJECT (sink, "dscp set to %d", sink->qos_dscp);
         break;
+      case PROP_QUEUE_SIZE:
+        sink->queue_size = g_value_get_uint (value);
+        GST_DEBUG_OBJECT (sink, "queue size set to %u", sink->queue_size);
+        break;
+      case PROP_RESUME_ATTEMPTS:
+        sink->resume_attempts = g_value_get_uint (value);
+        GST_DEBUG_OBJECT (sink, "resume attempts set to %u",
+            sink->resume_attempts);
+        break;
       default:
         GST_DEBUG_OBJECT (sink, "invalid property id %d", prop_id);
         break;
@@ -557,6 +653,8 @@ gst_curl_base_sink_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_FILE_NAME:
+      /* the buffers queued before belong to the previous file */
+      gst_curl_base_sink_wait_for_queue_drain_unlocked (sink);
       g_free (sink->file_name);
       sink->file_name = g_value_dup_string (value);
       GST_DEBUG_OBJECT (sink, "file_name set to %s", sink->file_name);
@@ -607,6 +705,12 @@ gst_curl_base_sink_get_property (GObject * object, guint prop_id,
     case PROP_QOS_DSCP:
       g_value_set_int (value, sink->qos_dscp);
       break;
+    case PROP_QUEUE_SIZE:
+      g_value_set_uint (value, sink->queue_size);
+      break;
+    case PROP_RESUME_ATTEMPTS:
+      g_value_set_uint (value, sink->resume_attempts);
+      break;
     default:
       GST_DEBUG_OBJECT (sink, "invalid property id");
       break;
@@ -705,6 +809,23 @@ gst_curl_base_sink_transfer_set_common_options_unlocked (GstCurlBaseSink * sink)
         curl_easy_strerror (res));
     return FALSE;
   }
+  /* resuming needs to rewind to the offset the server reports */
+  if (klass->prepare_resume_unlocked) {
+    res = curl_easy_setopt (sink->curl, CURLOPT_SEEKDATA, sink);
+    if (res != CURLE_OK) {
+      sink->error = g_strdup_printf ("failed to set seek user data: %s",
+          curl_easy_strerror (res));
+      return FALSE;
+    }
+    res = curl_easy_setopt (sink->curl, CURLOPT_SEEKFUNCTION,
+        gst_curl_base_sink_transfer_seek_cb);
+    if (res != CURLE_OK) {
+      sink->error = g_strdup_printf ("failed to set seek function: %s",
+          curl_easy_strerror (res));
+      return FALSE;
+    }
+  }
+
   /* Time out in case transfer speed in bytes per second stay below
    * CURLOPT_LOW_SPEED_LIMIT during CURLOPT_LOW_SPEED_TIME */
   res = curl_easy_setopt (sink->curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
@@ -786,6 +907,8 @@ gst_curl_base_sink_transfer_data_buffer (GstCurlBaseSink * sink,
     void *curl_ptr, size_t block_size, guint * last_chunk)
 {
   TransferBuffer *buffer;
+  size_t bytes_sent = 0;
+  gboolean more;
 
   buffer = sink->transfer_buf;
   GST_LOG ("write buf len=%" G_GSIZE_FORMAT ", offset=%" G_GSIZE_FORMAT,
@@ -797,8 +920,26 @@ gst_curl_base_sink_transfer_data_buffer (GstCurlBaseSink * sink,
     return 0;
   }
 
-  /* more data in buffer(s) */
-  return transfer_data_buffer (curl_ptr, buffer, block_size, last_chunk);
+  /* fill the block from as many queued buffers as there are, small buffers
+   * would otherwise end up as small packets (or chunks with chunked
+   * transfer encoding) */
+  while (TRUE) {
+    bytes_sent += transfer_data_buffer ((guint8 *) curl_ptr + bytes_sent,
+        buffer, block_size - bytes_sent, last_chunk);
+    if (!*last_chunk || bytes_sent == block_size || sink->buffer_per_transfer)
+      break;
+
+    GST_OBJECT_LOCK (sink);
+    gst_curl_base_sink_buffer_done_unlocked (sink);
+    more = gst_curl_base_sink_next_buffer_unlocked (sink);
+    GST_OBJECT_UNLOCK (sink);
+
+    *last_chunk = 0;
+    if (!more)
+      break;
+  }
+
+  return bytes_sent;
 }
 
 static size_t
@@ -845,6 +986,9 @@ gst_curl_base_sink_transfer_read_cb (void *curl_ptr, size_t size, size_t nmemb,
     return 0;
   }
 
+  if (sink->transfer_buffer == NULL) {
+    gst_curl_base_sink_next_buffer_unlocked (sink);
+  }
   GST_OBJECT_UNLOCK (sink);
 
   bytes_to_send = klass->transfer_data_buffer (sink, curl_ptr,
@@ -883,6 +1027,75 @@ gst_curl_base_sink_transfer_write_cb (void G_GNUC_UNUSED * ptr, size_t size,
   return realsize;
 }
 
+/* Called when resuming, with the amount of data the server already has */
+static int
+gst_curl_base_sink_transfer_seek_cb (void *stream, curl_off_t offset,
+    int origin)
+{
+  GstCurlBaseSink *sink = (GstCurlBaseSink *) stream;
+  GstBuffer *buf;
+  guint64 pos;
+  gsize size;
+  int ret = CURL_SEEKFUNC_OK;
+
+  if (origin != SEEK_SET || offset < 0)
+    return CURL_SEEKFUNC_FAIL;
+
+  GST_OBJECT_LOCK (sink);
+  GST_DEBUG_OBJECT (sink, "seeking to %" G_GINT64_FORMAT " of %"
+      G_GUINT64_FORMAT " bytes sent", (gint64) offset,
+      sink->buffer_file_offset + sink->transfer_buf->offset);
+
+  if (offset > sink->buffer_file_offset + sink->transfer_buf->offset) {
+    GST_WARNING_OBJECT (sink, "server has more data than was sent");
+    ret = CURL_SEEKFUNC_FAIL;
+    goto done;
+  }
+
+  if (sink->transfer_buffer != NULL) {
+    if (offset >= sink->buffer_file_offset) {
+      sink->transfer_buf->offset = offset - sink->buffer_file_offset;
+      sink->transfer_buf->len =
+          sink->transfer_map.size - sink->transfer_buf->offset;
+      goto done;
+    }
+
+    /* back into the queue, the sent data before it is needed too */
+    buf = sink->transfer_buffer;
+    gst_buffer_unmap (buf, &sink->transfer_map);
+    sink->transfer_buffer = NULL;
+    sink->transfer_buf->len = 0;
+    sink->transfer_buf->offset = 0;
+    g_queue_push_head (&sink->queue, buf);
+  }
+
+  pos = sink->buffer_file_offset;
+  while (pos > offset && (buf = g_queue_pop_tail (&sink->sent))) {
+    size = gst_buffer_get_size (buf);
+    sink->sent_bytes -= size;
+    pos -= size;
+    g_queue_push_head (&sink->queue, buf);
+  }
+  sink->buffer_file_offset = pos;
+
+  if (pos > offset) {
+    GST_WARNING_OBJECT (sink, "data at %" G_GINT64_FORMAT " not kept anymore",
+        (gint64) offset);
+    ret = CURL_SEEKFUNC_FAIL;
+    goto done;
+  }
+
+  if (offset > pos && gst_curl_base_sink_next_buffer_unlocked (sink)) {
+    sink->transfer_buf->offset = offset - pos;
+    sink->transfer_buf->len -= offset - pos;
+  }
+
+done:
+  GST_OBJECT_UNLOCK (sink);
+
+  return ret;
+}
+
 CURLcode
 gst_curl_base_sink_transfer_check (GstCurlBaseSink * sink)
 {
@@ -962,6 +1175,9 @@ handle_transfer (GstCurlBaseSink * sink)
         goto fail;
       }
     } else if (G_UNLIKELY (activated_fds == 0)) {
+      if (gst_curl_base_sink_schedule_resume (sink, "poll timed out")) {
+        return;
+      }
       sink->error = g_strdup_printf ("poll timed out after %" GST_TIME_FORMAT,
           GST_TIME_ARGS (timeout * GST_SECOND));
       retval = GST_FLOW_ERROR;
@@ -985,6 +1201,24 @@ handle_transfer (GstCurlBaseSink * sink)
   /* problems still might have occurred on individual transfers even when
    * curl_multi_perform returns CURLM_OK */
   if ((e_code = gst_curl_base_sink_transfer_check (sink)) != CURLE_OK) {
+    switch (e_code) {
+      case CURLE_COULDNT_CONNECT:
+      case CURLE_SEND_ERROR:
+      case CURLE_RECV_ERROR:
+      case CURLE_PARTIAL_FILE:
+      case CURLE_GOT_NOTHING:
+      case CURLE_OPERATION_TIMEDOUT:
+      case CURLE_UPLOAD_FAILED:
+      case CURLE_SSH:
+        /* connection lost */
+        if (gst_curl_base_sink_schedule_resume (sink,
+                curl_easy_strerror (e_code))) {
+          return;
+        }
+        break;
+      default:
+        break;
+    }
     sink->error = g_strdup_printf ("failed to transfer data: %s",
         curl_easy_strerror (e_code));
     retval = GST_FLOW_ERROR;
@@ -1129,6 +1363,7 @@ gst_curl_base_sink_transfer_start_unlocked (GstCurlBaseSink * sink)
   GST_LOG ("creating transfer thread");
   sink->transfer_thread_close = FALSE;
   sink->new_file = TRUE;
+  sink->transfer_established = FALSE;
   sink->transfer_thread =
       g_thread_try_new ("Curl Transfer Thread", (GThreadFunc)
       gst_curl_base_sink_transfer_thread_func, sink, &error);
@@ -1162,7 +1397,10 @@ gst_curl_base_sink_transfer_thread_func (gpointer data)
     goto done;
   }
 
-  while (!sink->transfer_thread_close && sink->flow_ret == GST_FLOW_OK) {
+  /* buffers queued before EOS are still sent after the close flag is set */
+  while ((!sink->transfer_thread_close ||
+          gst_curl_base_sink_has_data_unlocked (sink)) &&
+      sink->flow_ret == GST_FLOW_OK) {
     /* we are working on a new file, clearing flag and setting a new file
      * name */
     sink->new_file = FALSE;
@@ -1172,6 +1410,15 @@ gst_curl_base_sink_transfer_thread_func (gpointer data)
      * for this file and go directly to the new file */
     data_available = gst_curl_base_sink_wait_for_data_unlocked (sink);
     if (data_available) {
+      /* the upload starts at the beginning of the file, and the options
+       * may depend on the first buffer */
+      gst_curl_base_sink_clear_sent_unlocked (sink);
+      sink->buffer_file_offset = 0;
+      sink->resume_count = 0;
+      if (sink->transfer_buffer == NULL) {
+        gst_curl_base_sink_next_buffer_unlocked (sink);
+      }
+
       if (G_UNLIKELY (!klass->set_protocol_dynamic_options_unlocked (sink))) {
         sink->error = g_strdup ("unexpected state");
         sink->flow_ret = GST_FLOW_ERROR;
@@ -1206,6 +1453,7 @@ gst_curl_base_sink_transfer_thread_func (gpointer data)
       if (!gst_curl_base_sink_is_live (sink)) {
         GST_LOG ("removing handle");
         curl_multi_remove_handle (sink->multi_handle, sink->curl);
+        gst_curl_base_sink_resume_transfer (sink);
       }
     } else {
       GST_LOG ("have no data yet");
@@ -1297,45 +1545,192 @@ gst_curl_base_sink_wait_for_data_unlocked (GstCurlBaseSink * sink)
   gboolean data_available = FALSE;
 
   GST_LOG ("waiting for data");
-  while (!sink->transfer_cond->data_available &&
+  while (!gst_curl_base_sink_has_data_unlocked (sink) &&
       !sink->transfer_thread_close && !sink->new_file) {
     g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
   }
 
-  if (sink->transfer_thread_close) {
-    GST_LOG ("wait for data aborted due to thread close");
-  } else if (sink->new_file) {
+  /* data queued before the thread close flag was set is still sent, data
+   * queued after a new file name belongs to the next file */
+  if (sink->new_file) {
     GST_LOG ("wait for data aborted due to new file name");
-  } else {
+  } else if (gst_curl_base_sink_has_data_unlocked (sink)) {
     GST_LOG ("wait for data completed");
     data_available = TRUE;
+  } else {
+    GST_LOG ("wait for data aborted due to thread close");
   }
 
   return data_available;
 }
 
+/* makes transfer_buf point into the next queued buffer */
+static gboolean
+gst_curl_base_sink_next_buffer_unlocked (GstCurlBaseSink * sink)
+{
+  GstBuffer *buf;
+
+  g_assert (sink->transfer_buffer == NULL);
+
+  buf = g_queue_pop_head (&sink->queue);
+  if (buf == NULL) {
+    return FALSE;
+  }
+
+  /* room for another buffer */
+  g_cond_broadcast (&sink->transfer_cond->cond);
+
+  if (!gst_buffer_map (buf, &sink->transfer_map, GST_MAP_READ)) {
+    GST_WARNING_OBJECT (sink, "could not map buffer, skipping");
+    gst_buffer_unref (buf);
+    return FALSE;
+  }
+
+  sink->transfer_buffer = buf;
+  sink->transfer_buf->ptr = sink->transfer_map.data;
+  sink->transfer_buf->len = sink->transfer_map.size;
+  sink->transfer_buf->offset = 0;
+
+  return TRUE;
+}
+
+/* called when all of transfer_buf has been handed to curl */
 static void
-gst_curl_base_sink_new_file_notify_unlocked (GstCurlBaseSink * sink)
+gst_curl_base_sink_buffer_done_unlocked (GstCurlBaseSink * sink)
 {
-  GST_LOG ("new file name");
-  sink->new_file = TRUE;
-  g_cond_signal (&sink->transfer_cond->cond);
+  GstBuffer *buf = sink->transfer_buffer;
+  gsize size;
+
+  sink->transfer_cond->data_available = FALSE;
+  sink->transfer_established = TRUE;
+  g_cond_broadcast (&sink->transfer_cond->cond);
+
+  if (buf == NULL) {
+    return;
+  }
+
+  size = sink->transfer_map.size;
+  gst_buffer_unmap (buf, &sink->transfer_map);
+  sink->transfer_buffer = NULL;
+  sink->transfer_buf->ptr = NULL;
+  sink->transfer_buf->len = 0;
+  sink->transfer_buf->offset = 0;
+  sink->buffer_file_offset += size;
+
+  if (!gst_curl_base_sink_can_resume_unlocked (sink)) {
+    gst_buffer_unref (buf);
+    return;
+  }
+
+  /* keep the data the server might not have received yet */
+  g_queue_push_tail (&sink->sent, buf);
+  sink->sent_bytes += size;
+  while (sink->sent_bytes > RESUME_WINDOW_SIZE &&
+      g_queue_get_length (&sink->sent) > 1) {
+    buf = g_queue_pop_head (&sink->sent);
+    sink->sent_bytes -= gst_buffer_get_size (buf);
+    gst_buffer_unref (buf);
+  }
 }
 
 static void
-    gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked
-    (GstCurlBaseSink * sink)
+gst_curl_base_sink_clear_sent_unlocked (GstCurlBaseSink * sink)
 {
-  GST_LOG ("waiting for buffer send to complete");
+  g_queue_foreach (&sink->sent, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&sink->sent);
+  sink->sent_bytes = 0;
+}
 
-  /* this function should not check if the transfer thread is set to be closed
-   * since that flag only can be set by the EOS event (by the pipeline thread).
-   * This can therefore never happen while this function is running since this
-   * function also is called by the pipeline thread (in the render function) */
-  while (!sink->transfer_cond->data_sent) {
-    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+static void
+gst_curl_base_sink_clear_queue_unlocked (GstCurlBaseSink * sink)
+{
+  if (sink->transfer_buffer != NULL) {
+    gst_buffer_unmap (sink->transfer_buffer, &sink->transfer_map);
+    gst_buffer_unref (sink->transfer_buffer);
+    sink->transfer_buffer = NULL;
   }
-  GST_LOG ("buffer send completed");
+  sink->transfer_buf->ptr = NULL;
+  sink->transfer_buf->len = 0;
+  sink->transfer_buf->offset = 0;
+
+  g_queue_foreach (&sink->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&sink->queue);
+  gst_curl_base_sink_clear_sent_unlocked (sink);
+}
+
+static gboolean
+gst_curl_base_sink_schedule_resume (GstCurlBaseSink * sink,
+    const gchar * reason)
+{
+  gboolean ret = FALSE;
+
+  GST_OBJECT_LOCK (sink);
+  if (sink->flow_ret == GST_FLOW_OK && !sink->flushing &&
+      gst_curl_base_sink_can_resume_unlocked (sink) &&
+      sink->resume_count < sink->resume_attempts) {
+    sink->resume_count++;
+    sink->resume_pending = TRUE;
+    GST_WARNING_OBJECT (sink, "%s, resuming upload (attempt %u of %u)",
+        reason, sink->resume_count, sink->resume_attempts);
+    ret = TRUE;
+  }
+  GST_OBJECT_UNLOCK (sink);
+
+  return ret;
+}
+
+/* Reconnects after the connection was lost and lets curl continue the
+ * upload from what the server has received */
+static void
+gst_curl_base_sink_resume_transfer (GstCurlBaseSink * sink)
+{
+  GstCurlBaseSinkClass *klass = GST_CURL_BASE_SINK_GET_CLASS (sink);
+  gboolean resumed = FALSE;
+  gint64 end_time;
+
+  GST_OBJECT_LOCK (sink);
+  while (sink->resume_pending && sink->flow_ret == GST_FLOW_OK) {
+    sink->resume_pending = FALSE;
+    resumed = TRUE;
+
+    /* give the network or the server some time to recover */
+    end_time = g_get_monotonic_time () +
+        (sink->resume_count - 1) * G_TIME_SPAN_SECOND;
+    while (!sink->flushing && g_cond_wait_until (&sink->transfer_cond->cond,
+            GST_OBJECT_GET_LOCK (sink), end_time));
+    if (sink->flushing) {
+      sink->flow_ret = GST_FLOW_FLUSHING;
+      break;
+    }
+
+    if (!klass->prepare_resume_unlocked (sink)) {
+      sink->flow_ret = GST_FLOW_ERROR;
+      break;
+    }
+    GST_OBJECT_UNLOCK (sink);
+
+    GST_LOG ("adding handle");
+    curl_multi_add_handle (sink->multi_handle, sink->curl);
+    klass->handle_transfer (sink);
+    GST_LOG ("removing handle");
+    curl_multi_remove_handle (sink->multi_handle, sink->curl);
+
+    GST_OBJECT_LOCK (sink);
+  }
+  GST_OBJECT_UNLOCK (sink);
+
+  /* the next file starts from the beginning again */
+  if (resumed) {
+    curl_easy_setopt (sink->curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t) 0);
+  }
+}
+
+static void
+gst_curl_base_sink_new_file_notify_unlocked (GstCurlBaseSink * sink)
+{
+  GST_LOG ("new file name");
+  sink->new_file = TRUE;
+  g_cond_broadcast (&sink->transfer_cond->cond);
 }
 
 static void
@@ -1343,9 +1738,7 @@ gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink)
 {
   GST_LOG ("transfer completed");
   GST_OBJECT_LOCK (sink);
-  sink->transfer_cond->data_available = FALSE;
-  sink->transfer_cond->data_sent = TRUE;
-  g_cond_signal (&sink->transfer_cond->cond);
+  gst_curl_base_sink_buffer_done_unlocked (sink);
   GST_OBJECT_UNLOCK (sink);
 }
 
@@ -1370,7 +1763,7 @@ gst_curl_base_sink_got_response_notify (GstCurlBaseSink * sink)
 
   GST_OBJECT_LOCK (sink);
   sink->transfer_cond->wait_for_response = FALSE;
-  g_cond_signal (&sink->transfer_cond->cond);
+  g_cond_broadcast (&sink->transfer_cond->cond);
   GST_OBJECT_UNLOCK (sink);
 }
 
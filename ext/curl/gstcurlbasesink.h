@@ -53,7 +53,7 @@ struct _TransferBuffer
 struct _TransferCondition
 {
   GCond cond;
-  gboolean data_sent;
+  /* data to send besides the queued buffers */
   gboolean data_available;
   gboolean wait_for_response;
 };
@@ -83,6 +83,28 @@ struct _GstCurlBaseSink
   gboolean transfer_thread_close;
   gboolean new_file;
   gboolean is_live;
+  gboolean flushing;
+
+  /* buffers waiting for the transfer thread */
+  GQueue queue;
+  guint queue_size;
+  /* the buffer transfer_buf points into, owned by the transfer thread */
+  GstBuffer *transfer_buffer;
+  GstMapInfo transfer_map;
+  /* every buffer is uploaded in a transfer of its own */
+  gboolean buffer_per_transfer;
+  /* the first buffer was handed to curl */
+  gboolean transfer_established;
+
+  /* resuming interrupted uploads */
+  guint resume_attempts;
+  guint resume_count;
+  gboolean resume_pending;
+  /* buffers already handed to curl, kept to send them again */
+  GQueue sent;
+  gsize sent_bytes;
+  /* position of transfer_buf in the uploaded file */
+  guint64 buffer_file_offset;
 };
 
 struct _GstCurlBaseSinkClass
@@ -105,6 +127,7 @@ struct _GstCurlBaseSinkClass
     size_t (*flush_data_unlocked) (GstCurlBaseSink * sink, void *curl_ptr,
       size_t block_size, gboolean new_file, gboolean close_transfer);
     gboolean (*has_buffered_data_unlocked) (GstCurlBaseSink * sink);
+    gboolean (*prepare_resume_unlocked) (GstCurlBaseSink * sink);
 };
 
 GType gst_curl_base_sink_get_type (void);
@@ -112,6 +135,7 @@ GType gst_curl_base_sink_get_type (void);
 void gst_curl_base_sink_transfer_thread_notify_unlocked
     (GstCurlBaseSink * sink);
 void gst_curl_base_sink_transfer_thread_close (GstCurlBaseSink * sink);
+void gst_curl_base_sink_wait_for_queue_drain_unlocked (GstCurlBaseSink * sink);
 void gst_curl_base_sink_set_live (GstCurlBaseSink * sink, gboolean live);
 gboolean gst_curl_base_sink_is_live (GstCurlBaseSink * sink);
 
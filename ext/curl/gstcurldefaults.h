@@ -133,6 +133,28 @@
 #define GSTCURL_DEFAULT_CONNECTIONS_SERVER 5
 #define GSTCURL_DEFAULT_CONNECTIONS_PROXY 30
 #define GSTCURL_DEFAULT_CONNECTIONS_GLOBAL 255
+
+/*
+ * Number of curl multi loop threads transfers are spread over, can be changed
+ * with the GST_CURL_LOOP_THREADS environment variable.
+ */
+#define GSTCURL_DEFAULT_LOOP_THREADS 1
+#define GSTCURL_MAX_LOOP_THREADS 16
+
+/*
+ * Size of the pooled blocks body data is received into. libcurl hands us at
+ * most CURL_MAX_WRITE_SIZE bytes per write callback, so a block usually
+ * collects a few of them before it is pushed.
+ */
+#define GSTCURL_BLOCK_SIZE (4 * CURL_MAX_WRITE_SIZE)
+
+/* Parallel byte range downloads, a single stream by default */
+#define GSTCURL_MIN_PARALLEL_RANGES 1
+#define GSTCURL_MAX_PARALLEL_RANGES 16
+#define GSTCURL_DEFAULT_PARALLEL_RANGES 1
+#define GSTCURL_MIN_RANGE_SIZE (64 * 1024)
+#define GSTCURL_MAX_RANGE_SIZE (64 * 1024 * 1024)
+#define GSTCURL_DEFAULT_RANGE_SIZE (1024 * 1024)
 #define GSTCURL_INFO_RESPONSE(x) ((x >= 100) && (x <= 199))
 #define GSTCURL_SUCCESS_RESPONSE(x) ((x >= 200) && (x <=299))
 #define GSTCURL_REDIRECT_RESPONSE(x) ((x >= 300) && (x <= 399))
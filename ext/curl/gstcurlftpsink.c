@@ -99,6 +99,7 @@ static void gst_curl_ftp_sink_finalize (GObject * gobject);
 static gboolean set_ftp_options_unlocked (GstCurlBaseSink * curlbasesink);
 static gboolean set_ftp_dynamic_options_unlocked
     (GstCurlBaseSink * curlbasesink);
+static gboolean prepare_ftp_resume_unlocked (GstCurlBaseSink * curlbasesink);
 
 #define gst_curl_ftp_sink_parent_class parent_class
 G_DEFINE_TYPE (GstCurlFtpSink, gst_curl_ftp_sink, GST_TYPE_CURL_TLS_SINK);
@@ -128,6 +129,8 @@ gst_curl_ftp_sink_class_init (GstCurlFtpSinkClass * klass)
   gstcurlbasesink_class->set_protocol_dynamic_options_unlocked =
       set_ftp_dynamic_options_unlocked;
   gstcurlbasesink_class->set_options_unlocked = set_ftp_options_unlocked;
+  gstcurlbasesink_class->prepare_resume_unlocked =
+      prepare_ftp_resume_unlocked;
 
   g_object_class_install_property (gobject_class, PROP_FTP_PORT_ARG,
       g_param_spec_string ("ftp-port", "IP address for FTP PORT instruction",
@@ -257,6 +260,23 @@ set_ftp_dynamic_options_unlocked (GstCurlBaseSink * basesink)
   return TRUE;
 }
 
+/* continue the upload at the size of the remote file, APPE for FTP */
+static gboolean
+prepare_ftp_resume_unlocked (GstCurlBaseSink * basesink)
+{
+  CURLcode res;
+
+  res = curl_easy_setopt (basesink->curl, CURLOPT_RESUME_FROM_LARGE,
+      (curl_off_t) - 1);
+  if (res != CURLE_OK) {
+    basesink->error = g_strdup_printf ("failed to set resume offset: %s",
+        curl_easy_strerror (res));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 set_ftp_options_unlocked (GstCurlBaseSink * basesink)
 {
@@ -321,6 +321,9 @@ gst_curl_http_sink_set_header_unlocked (GstCurlBaseSink * bcsink)
   gchar *tmp;
   CURLcode res;
 
+  /* with a content length every buffer is sent in a request of its own */
+  bcsink->buffer_per_transfer = sink->use_content_length;
+
   if (sink->header_list) {
     curl_slist_free_all (sink->header_list);
     sink->header_list = NULL;
@@ -59,6 +59,18 @@
  * If the "http_proxy" environment variable is set, its value is used.
  * The #GstCurlHttpSrc:proxy property can be used to override the default.
  *
+ * All curlhttpsrc instances in a process share a small number of libcurl
+ * multi loop threads. By default there is one, the "GST_CURL_LOOP_THREADS"
+ * environment variable sets a different number. New transfers are put on the
+ * loop with the fewest users.
+ *
+ * Setting #GstCurlHttpSrc:parallel-ranges above 1 splits a transfer into
+ * byte ranges of #GstCurlHttpSrc:range-size bytes that are fetched over
+ * several connections at once, which helps on lossy links with a high
+ * bandwidth-delay product. The ranges are put back in order before they are
+ * pushed. If the server doesn't answer the first range request with a partial
+ * response, the body is received as a single stream.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -131,13 +143,27 @@ static gboolean gst_curl_http_src_urihandler_set_uri (GstURIHandler * handler,
 
 /* GstTask functions */
 static void gst_curl_http_src_curl_multi_loop (gpointer thread_data);
-static CURL *gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s);
+static CURL *gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s,
+    GstCurlHttpSrcRange * range);
 static inline void gst_curl_http_src_destroy_easy_handle (GstCurlHttpSrc * src);
 static size_t gst_curl_http_src_get_header (void *header, size_t size,
     size_t nmemb, void *src);
 static size_t gst_curl_http_src_get_chunks (void *chunk, size_t size,
     size_t nmemb, void *src);
 static void gst_curl_http_src_request_remove (GstCurlHttpSrc * src);
+static GstBuffer *gst_curl_http_src_take_block (GstCurlHttpSrc * src);
+static void gst_curl_http_src_drop_blocks (GstCurlHttpSrc * src);
+static GstStructure *gst_curl_http_src_get_stats (GstCurlHttpSrc * src);
+static size_t gst_curl_http_src_get_range_chunks (void *chunk, size_t size,
+    size_t nmemb, void *range);
+static void gst_curl_http_src_parse_content_range (GstCurlHttpSrc * s,
+    const gchar * value);
+static GstFlowReturn gst_curl_http_src_check_ranges (GstCurlHttpSrc * src);
+static gboolean gst_curl_http_src_start_ranges (GstCurlHttpSrc * src);
+static GstFlowReturn gst_curl_http_src_create_from_ranges (GstCurlHttpSrc *
+    src, GstBuffer ** outbuf);
+static void gst_curl_http_src_free_range (GstCurlHttpSrcRange * range);
+static void gst_curl_http_src_clear_ranges (GstCurlHttpSrc * src);
 static char *gst_curl_http_src_strcasestr (const char *haystack,
     const char *needle);
 
@@ -178,7 +204,9 @@ gst_curl_http_src_class_init (GstCurlHttpSrcClass * klass)
   GstBaseSrcClass *gstbasesrc_class;
   GstPushSrcClass *gstpushsrc_class;
   const gchar *http_env;
+  const gchar *loop_env;
   GstCurlHttpVersion default_http_version;
+  guint i, n_loops;
 
   gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
@@ -382,6 +410,28 @@ gst_curl_http_src_class_init (GstCurlHttpSrcClass * klass)
           GST_TYPE_CURL_HTTP_VERSION, pref_http_ver,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_PARALLEL_RANGES,
+      g_param_spec_uint ("parallel-ranges", "Parallel-Ranges",
+          "Number of byte ranges of a resource to fetch at the same time, "
+          "1 to receive it as a single stream",
+          GSTCURL_MIN_PARALLEL_RANGES, GSTCURL_MAX_PARALLEL_RANGES,
+          GSTCURL_DEFAULT_PARALLEL_RANGES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_RANGE_SIZE,
+      g_param_spec_uint ("range-size", "Range-Size",
+          "Size in bytes of the byte ranges fetched in parallel. At most "
+          "parallel-ranges ranges are buffered for reordering",
+          GSTCURL_MIN_RANGE_SIZE, GSTCURL_MAX_RANGE_SIZE,
+          GSTCURL_DEFAULT_RANGE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Transfer statistics: requests, bytes received, time to first byte "
+          "and stalls", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   /* Add a debugging task so it's easier to debug in the Multi worker thread */
   GST_DEBUG_CATEGORY_INIT (gst_curl_loop_debug, "curl_multi_loop", 0,
       "libcURL loop thread debugging");
@@ -390,9 +440,23 @@ gst_curl_http_src_class_init (GstCurlHttpSrcClass * klass)
       __LINE__, NULL, "Testing the curl_multi_loop debugging prints");
 #endif
 
-  g_mutex_init (&klass->multi_task_context.mutex);
-  g_cond_init (&klass->multi_task_context.signal);
-  g_rec_mutex_init (&klass->multi_task_context.task_rec_mutex);
+  n_loops = GSTCURL_DEFAULT_LOOP_THREADS;
+  loop_env = g_getenv ("GST_CURL_LOOP_THREADS");
+  if (loop_env != NULL) {
+    GST_INFO_OBJECT (klass, "Seen env var GST_CURL_LOOP_THREADS with value %s",
+        loop_env);
+    n_loops = (guint) g_ascii_strtoull (loop_env, NULL, 10);
+    n_loops = CLAMP (n_loops, 1, GSTCURL_MAX_LOOP_THREADS);
+  }
+
+  klass->n_multi_task_contexts = n_loops;
+  klass->multi_task_contexts =
+      g_new0 (GstCurlHttpSrcMultiTaskContext, n_loops);
+  for (i = 0; i < n_loops; i++) {
+    g_mutex_init (&klass->multi_task_contexts[i].mutex);
+    g_cond_init (&klass->multi_task_contexts[i].signal);
+    g_rec_mutex_init (&klass->multi_task_contexts[i].task_rec_mutex);
+  }
 
   gst_element_class_set_static_metadata (gstelement_class,
       "HTTP Client Source using libcURL",
@@ -489,6 +553,12 @@ gst_curl_http_src_set_property (GObject * object, guint prop_id,
     case PROP_HTTPVERSION:
       source->preferred_http_version = g_value_get_enum (value);
       break;
+    case PROP_PARALLEL_RANGES:
+      source->parallel_ranges = g_value_get_uint (value);
+      break;
+    case PROP_RANGE_SIZE:
+      source->range_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -570,6 +640,15 @@ gst_curl_http_src_get_property (GObject * object, guint prop_id,
     case PROP_HTTPVERSION:
       g_value_set_enum (value, source->preferred_http_version);
       break;
+    case PROP_PARALLEL_RANGES:
+      g_value_set_uint (value, source->parallel_ranges);
+      break;
+    case PROP_RANGE_SIZE:
+      g_value_set_uint (value, source->range_size);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_curl_http_src_get_stats (source));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -580,6 +659,8 @@ gst_curl_http_src_get_property (GObject * object, guint prop_id,
 static void
 gst_curl_http_src_init (GstCurlHttpSrc * source)
 {
+  GstStructure *config;
+
   GSTCURL_FUNCTION_ENTRY (source);
 
   /* Assume everything is already free'd */
@@ -608,6 +689,8 @@ gst_curl_http_src_init (GstCurlHttpSrc * source)
   source->total_retries = GSTCURL_HANDLE_DEFAULT_RETRIES;
   source->retries_remaining = source->total_retries;
   source->slist = NULL;
+  source->parallel_ranges = GSTCURL_DEFAULT_PARALLEL_RANGES;
+  source->range_size = GSTCURL_DEFAULT_RANGE_SIZE;
 
   gst_caps_replace (&source->caps, NULL);
   gst_base_src_set_automatic_eos (GST_BASE_SRC (source), FALSE);
@@ -619,8 +702,26 @@ gst_curl_http_src_init (GstCurlHttpSrc * source)
   g_mutex_init (&source->buffer_mutex);
   g_cond_init (&source->signal);
 
-  source->buffer = NULL;
+  /* The pool only grows to the number of blocks in flight downstream */
+  source->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (source->pool);
+  gst_buffer_pool_config_set_params (config, NULL, GSTCURL_BLOCK_SIZE, 0, 0);
+  gst_buffer_pool_set_config (source->pool, config);
+  gst_buffer_pool_set_active (source->pool, TRUE);
+
+  g_queue_init (&source->ready_blocks);
+  source->block = NULL;
+  source->block_filled = 0;
   source->buffer_len = 0;
+  source->multi_task_context = NULL;
+
+  source->range_requested = FALSE;
+  source->ranges_checked = FALSE;
+  source->ranges_active = FALSE;
+  source->range_end = 0;
+  source->content_size = 0;
+  source->next_range_start = 0;
+  g_queue_init (&source->ranges);
   source->state = GSTCURL_NONE;
   source->pending_state = GSTCURL_NONE;
   source->status_code = 0;
@@ -630,6 +731,14 @@ gst_curl_http_src_init (GstCurlHttpSrc * source)
 
   source->curl_result = CURLE_OK;
 
+  source->request_start = 0;
+  source->first_byte_received = FALSE;
+  source->requests = 0;
+  source->bytes_received = 0;
+  source->ttfb = GST_CLOCK_TIME_NONE;
+  source->stalls = 0;
+  source->stall_time = 0;
+
   GSTCURL_FUNCTION_EXIT (source);
 }
 
@@ -641,6 +750,8 @@ static void
 gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
 {
   GstCurlHttpSrcClass *klass;
+  GstCurlHttpSrcMultiTaskContext *context;
+  guint i;
 
   GSTCURL_FUNCTION_ENTRY (src);
 
@@ -648,30 +759,42 @@ gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
   klass = G_TYPE_INSTANCE_GET_CLASS (src, GST_TYPE_CURL_HTTP_SRC,
       GstCurlHttpSrcClass);
 
-  g_mutex_lock (&klass->multi_task_context.mutex);
-  if (klass->multi_task_context.refcount == 0) {
+  /* Put the instance on the loop with the fewest users. The refcounts are only
+   * peeked at, being off by one under contention doesn't matter. */
+  context = &klass->multi_task_contexts[0];
+  for (i = 1; i < klass->n_multi_task_contexts; i++) {
+    if (g_atomic_int_get (&klass->multi_task_contexts[i].refcount) <
+        g_atomic_int_get (&context->refcount))
+      context = &klass->multi_task_contexts[i];
+  }
+  src->multi_task_context = context;
+
+  g_mutex_lock (&context->mutex);
+  if (context->refcount == 0) {
     /* Set up various in-task properties */
 
     /* NULL is treated as the start of the list, no need to allocate. */
-    klass->multi_task_context.queue = NULL;
+    context->queue = NULL;
+    /* The loop may have been stopped by its previous users */
+    context->state = GSTCURL_MULTI_LOOP_STATE_WAIT;
 
     /* set up curl */
-    klass->multi_task_context.multi_handle = curl_multi_init ();
+    context->multi_handle = curl_multi_init ();
 
-    curl_multi_setopt (klass->multi_task_context.multi_handle,
+    curl_multi_setopt (context->multi_handle,
         CURLMOPT_PIPELINING, 1);
 #ifdef CURLMOPT_MAX_HOST_CONNECTIONS
-    curl_multi_setopt (klass->multi_task_context.multi_handle,
+    curl_multi_setopt (context->multi_handle,
         CURLMOPT_MAX_HOST_CONNECTIONS, 1);
 #endif
 
     /* Start the thread */
-    klass->multi_task_context.task = gst_task_new (
+    context->task = gst_task_new (
         (GstTaskFunction) gst_curl_http_src_curl_multi_loop,
-        (gpointer) & klass->multi_task_context, NULL);
-    gst_task_set_lock (klass->multi_task_context.task,
-        &klass->multi_task_context.task_rec_mutex);
-    if (gst_task_start (klass->multi_task_context.task) == FALSE) {
+        (gpointer) context, NULL);
+    gst_task_set_lock (context->task,
+        &context->task_rec_mutex);
+    if (gst_task_start (context->task) == FALSE) {
       /*
        * This is a pretty critical failure and is not recoverable, so commit
        * sudoku and run away.
@@ -679,10 +802,11 @@ gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
       GSTCURL_ERROR_PRINT ("Couldn't start curl_multi task! Aborting.");
       abort ();
     }
-    GSTCURL_INFO_PRINT ("Curl multi loop has been correctly initialised!");
+    GSTCURL_INFO_PRINT ("Curl multi loop %u has been correctly initialised!",
+        (guint) (context - klass->multi_task_contexts));
   }
-  klass->multi_task_context.refcount++;
-  g_mutex_unlock (&klass->multi_task_context.mutex);
+  context->refcount++;
+  g_mutex_unlock (&context->mutex);
 
   GSTCURL_FUNCTION_EXIT (src);
 }
@@ -697,29 +821,38 @@ gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
 static void
 gst_curl_http_src_unref_multi (GstCurlHttpSrc * src)
 {
-  GstCurlHttpSrcClass *klass;
+  GstCurlHttpSrcMultiTaskContext *context = src->multi_task_context;
 
   GSTCURL_FUNCTION_ENTRY (src);
 
-  klass = G_TYPE_INSTANCE_GET_CLASS (src, GST_TYPE_CURL_HTTP_SRC,
-      GstCurlHttpSrcClass);
+  if (context == NULL)
+    goto out;
 
-  g_mutex_lock (&klass->multi_task_context.mutex);
-  klass->multi_task_context.refcount--;
+  g_mutex_lock (&context->mutex);
+  context->refcount--;
+  src->multi_task_context = NULL;
   GST_INFO_OBJECT (src, "Closing instance, worker thread refcount is now %u",
-      klass->multi_task_context.refcount);
+      context->refcount);
 
-  if (klass->multi_task_context.refcount <= 0) {
+  if (context->refcount <= 0) {
     /* Everything's done! Clean up. */
-    gst_task_pause (klass->multi_task_context.task);
-    klass->multi_task_context.state = GSTCURL_MULTI_LOOP_STATE_STOP;
-    g_cond_signal (&klass->multi_task_context.signal);
-    g_mutex_unlock (&klass->multi_task_context.mutex);
-    gst_task_join (klass->multi_task_context.task);
+    GstTask *task = context->task;
+    CURLM *multi_handle = context->multi_handle;
+
+    gst_task_pause (task);
+    context->state = GSTCURL_MULTI_LOOP_STATE_STOP;
+    /* The next user of this loop starts a new task and multi handle */
+    context->task = NULL;
+    g_cond_signal (&context->signal);
+    g_mutex_unlock (&context->mutex);
+    gst_task_join (task);
+    gst_object_unref (task);
+    curl_multi_cleanup (multi_handle);
   } else {
-    g_mutex_unlock (&klass->multi_task_context.mutex);
+    g_mutex_unlock (&context->mutex);
   }
 
+out:
   GSTCURL_FUNCTION_EXIT (src);
 }
 
@@ -746,11 +879,9 @@ gst_curl_http_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 {
   GstFlowReturn ret;
   GstCurlHttpSrc *src = GST_CURLHTTPSRC (psrc);
-  GstCurlHttpSrcClass *klass;
+  GstCurlHttpSrcMultiTaskContext *context = src->multi_task_context;
   GstStructure *empty_headers;
-
-  klass = G_TYPE_INSTANCE_GET_CLASS (src, GST_TYPE_CURL_HTTP_SRC,
-      GstCurlHttpSrcClass);
+  gint64 stall_start = -1;
 
   GSTCURL_FUNCTION_ENTRY (src);
   ret = GST_FLOW_OK;
@@ -764,30 +895,38 @@ gst_curl_http_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 retry:
   if (!src->transfer_begun) {
     GST_DEBUG_OBJECT (src, "Starting new request for URI %s", src->uri);
+    /* Ranges left over from an aborted transfer */
+    gst_curl_http_src_clear_ranges (src);
+    src->ranges_checked = FALSE;
+    src->content_size = 0;
+
     /* Create the Easy Handle and set up the session. */
-    src->curl_handle = gst_curl_http_src_create_easy_handle (src);
+    src->curl_handle = gst_curl_http_src_create_easy_handle (src, NULL);
     if (src->curl_handle == NULL) {
       ret = GST_FLOW_ERROR;
       goto escape;
     }
 
-    g_mutex_lock (&klass->multi_task_context.mutex);
+    g_mutex_lock (&context->mutex);
 
-    if (gst_curl_http_src_add_queue_item (&klass->multi_task_context.queue, src)
-        == FALSE) {
+    if (gst_curl_http_src_add_queue_item (&context->queue, src,
+            src->curl_handle, NULL) == FALSE) {
       GST_ERROR_OBJECT (src, "Couldn't create new queue item! Aborting...");
       ret = GST_FLOW_ERROR;
       goto escape;
     }
 
     /* Signal the worker thread */
-    klass->multi_task_context.state = GSTCURL_MULTI_LOOP_STATE_QUEUE_EVENT;
-    g_cond_signal (&klass->multi_task_context.signal);
-    g_mutex_unlock (&klass->multi_task_context.mutex);
+    context->state = GSTCURL_MULTI_LOOP_STATE_QUEUE_EVENT;
+    g_cond_signal (&context->signal);
+    g_mutex_unlock (&context->mutex);
 
     src->state = GSTCURL_OK;
     src->transfer_begun = TRUE;
     src->data_received = FALSE;
+    src->request_start = g_get_monotonic_time ();
+    src->first_byte_received = FALSE;
+    src->requests++;
 
     GST_DEBUG_OBJECT (src, "Submitted request for URI %s to curl", src->uri);
 
@@ -800,17 +939,22 @@ retry:
     GST_INFO_OBJECT (src, "Created a new headers object");
   }
 
-  /* Wait for data to become available, then punt it downstream */
+  /* Wait for data to become available, then punt it downstream. Running dry
+   * once the body has started flowing counts as a stall. */
+  if ((src->buffer_len == 0) && (src->state == GSTCURL_OK) &&
+      src->first_byte_received) {
+    stall_start = g_get_monotonic_time ();
+  }
   while ((src->buffer_len == 0) && (src->state == GSTCURL_OK)) {
     g_cond_wait (&src->signal, &src->buffer_mutex);
   }
+  if ((stall_start != -1) && (src->buffer_len > 0)) {
+    src->stalls++;
+    src->stall_time += (g_get_monotonic_time () - stall_start) * GST_USECOND;
+  }
 
   if (src->state == GSTCURL_UNLOCK) {
-    if (src->buffer_len > 0) {
-      g_free (src->buffer);
-      src->buffer = NULL;
-      src->buffer_len = 0;
-    }
+    gst_curl_http_src_drop_blocks (src);
     ret = GST_FLOW_FLUSHING;
     goto escape;
   }
@@ -859,18 +1003,31 @@ retry:
   if (((src->state == GSTCURL_OK) || (src->state == GSTCURL_DONE)) &&
       (src->buffer_len > 0)) {
 
-    GST_DEBUG_OBJECT (src, "Pushing %u bytes of transfer for URI %s to pad",
-        src->buffer_len, src->uri);
-    *outbuf = gst_buffer_new_allocate (NULL, src->buffer_len, NULL);
-    gst_buffer_fill (*outbuf, 0, src->buffer, src->buffer_len);
+    if (src->range_requested && !src->ranges_checked) {
+      ret = gst_curl_http_src_check_ranges (src);
+      if (ret != GST_FLOW_OK) {
+        goto escape;
+      }
+    }
 
-    g_free (src->buffer);
-    src->buffer = NULL;
-    src->buffer_len = 0;
+    *outbuf = gst_curl_http_src_take_block (src);
+    GST_DEBUG_OBJECT (src, "Pushing %" G_GSIZE_FORMAT " bytes of transfer for "
+        "URI %s to pad", gst_buffer_get_size (*outbuf), src->uri);
     src->data_received = TRUE;
 
     /* ret should still be GST_FLOW_OK */
   } else if ((src->state == GSTCURL_DONE) && (src->buffer_len == 0)) {
+    if (src->ranges_active) {
+      /* The main transfer is done, continue with the ranges in order */
+      ret = gst_curl_http_src_create_from_ranges (src, outbuf);
+      if (ret == GST_FLOW_OK) {
+        src->data_received = TRUE;
+      }
+      if (ret != GST_FLOW_EOS) {
+        goto escape;
+      }
+      src->ranges_active = FALSE;
+    }
     GST_INFO_OBJECT (src, "Full body received, signalling EOS for URI %s.",
         src->uri);
     src->state = GSTCURL_NONE;
@@ -936,7 +1093,8 @@ _headers_to_curl_slist (GQuark field_id, const GValue * value, gpointer ptr)
  * options with the URL, proxy data, login options, cookies,
  */
 static CURL *
-gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
+gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s,
+    GstCurlHttpSrcRange * range)
 {
   CURL *handle;
   gint i;
@@ -968,10 +1126,13 @@ gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
     gst_curl_setopt_str (s, handle, CURLOPT_COOKIELIST, s->cookies[i]);
   }
 
-  /* curl_slist_append dynamically allocates memory, but I need to free it */
+  /* curl_slist_append dynamically allocates memory, but I need to free it. The
+   * list is shared by the main transfer and its ranges. */
   if (s->request_headers != NULL) {
-    gst_structure_foreach (s->request_headers, _headers_to_curl_slist,
-        &s->slist);
+    if (s->slist == NULL) {
+      gst_structure_foreach (s->request_headers, _headers_to_curl_slist,
+          &s->slist);
+    }
     if (curl_easy_setopt (handle, CURLOPT_HTTPHEADER, s->slist) != CURLE_OK) {
       GST_WARNING_OBJECT (s, "Failed to set HTTP headers!");
     }
@@ -1029,6 +1190,39 @@ gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
           "Supplied a bogus HTTP version, using curl default!");
   }
 
+  if (range != NULL) {
+    /* Only the body matters for a range, headers were handled by the main
+     * transfer. Anything but a 2xx response fails the range. */
+    gchar *range_str = g_strdup_printf ("%" G_GUINT64_FORMAT "-%"
+        G_GUINT64_FORMAT, range->start, range->start + range->size - 1);
+    gst_curl_setopt_str (s, handle, CURLOPT_RANGE, range_str);
+    g_free (range_str);
+    /* Ranges are offsets into the encoded body, so don't let curl decode it */
+    gst_curl_setopt_str (s, handle, CURLOPT_ACCEPT_ENCODING, "identity");
+    gst_curl_setopt_bool (s, handle, CURLOPT_FAILONERROR, TRUE);
+    gst_curl_setopt_generic (s, handle, CURLOPT_WRITEFUNCTION,
+        gst_curl_http_src_get_range_chunks);
+    gst_curl_setopt_str (s, handle, CURLOPT_WRITEDATA, range);
+
+    GSTCURL_FUNCTION_EXIT (s);
+    return handle;
+  }
+
+  /*
+   * In parallel range mode the main transfer only asks for the first range,
+   * unless the application asked for a range itself.
+   */
+  s->range_requested = FALSE;
+  if ((s->parallel_ranges > 1) && ((s->request_headers == NULL) ||
+          (!gst_structure_has_field (s->request_headers, "Range") &&
+              !gst_structure_has_field (s->request_headers, "range")))) {
+    gchar *range_str = g_strdup_printf ("0-%u", s->range_size - 1);
+    gst_curl_setopt_str (s, handle, CURLOPT_RANGE, range_str);
+    g_free (range_str);
+    gst_curl_setopt_str (s, handle, CURLOPT_ACCEPT_ENCODING, "identity");
+    s->range_requested = TRUE;
+  }
+
   gst_curl_setopt_generic (s, handle, CURLOPT_HEADERFUNCTION,
       gst_curl_http_src_get_header);
   gst_curl_setopt_str (s, handle, CURLOPT_HEADERDATA, s);
@@ -1318,8 +1512,15 @@ gst_curl_http_src_cleanup_instance (GstCurlHttpSrc * src)
 
   g_cond_clear (&src->signal);
 
-  g_free (src->buffer);
-  src->buffer = NULL;
+  gst_curl_http_src_drop_blocks (src);
+  while (!g_queue_is_empty (&src->ranges)) {
+    gst_curl_http_src_free_range (g_queue_pop_head (&src->ranges));
+  }
+  if (src->pool != NULL) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+  }
 
   if (src->http_headers != NULL) {
     gst_structure_free (src->http_headers);
@@ -1360,6 +1561,11 @@ gst_curl_http_src_get_content_length (GstBaseSrc * bsrc, guint64 * size)
   const GValue *response_headers;
   gboolean ret = FALSE;
 
+  if (src->ranges_active) {
+    *size = src->content_size;
+    return TRUE;
+  }
+
   if (src->http_headers == NULL) {
     return FALSE;
   }
@@ -1470,7 +1676,7 @@ gst_curl_http_src_unlock (GstBaseSrc * bsrc)
 
   g_mutex_lock (&src->buffer_mutex);
   if (src->state != GSTCURL_UNLOCK) {
-    if (src->state == GSTCURL_OK) {
+    if ((src->state == GSTCURL_OK) || !g_queue_is_empty (&src->ranges)) {
       /* A transfer is running, cancel it */
       gst_curl_http_src_request_remove (src);
     }
@@ -1546,7 +1752,7 @@ gst_curl_http_src_curl_multi_loop (gpointer thread_data)
       if (g_mutex_trylock (&qelement->running) == TRUE) {
         GSTCURL_DEBUG_PRINT ("Adding easy handle for URI %s", qelement->p->uri);
         cond = TRUE;
-        curl_multi_add_handle (context->multi_handle, qelement->p->curl_handle);
+        curl_multi_add_handle (context->multi_handle, qelement->handle);
       }
       qelement = qelement->next;
     }
@@ -1658,13 +1864,16 @@ gst_curl_http_src_curl_multi_loop (gpointer thread_data)
       qnext = qelement->next;
       if (qelement->p == context->request_removal_element) {
         g_mutex_lock (&qelement->p->buffer_mutex);
-        curl_multi_remove_handle (context->multi_handle,
-            context->request_removal_element->curl_handle);
+        curl_multi_remove_handle (context->multi_handle, qelement->handle);
         if (qelement->p->state == GSTCURL_UNLOCK) {
           qelement->p->pending_state = GSTCURL_REMOVED;
         } else {
           qelement->p->state = GSTCURL_REMOVED;
         }
+        if (qelement->range != NULL) {
+          qelement->range->done = TRUE;
+          qelement->range->result = CURLE_ABORTED_BY_CALLBACK;
+        }
         g_cond_signal (&qelement->p->signal);
         g_mutex_unlock (&qelement->p->buffer_mutex);
         gst_curl_http_src_remove_queue_item (&context->queue, qelement->p);
@@ -1720,6 +1929,9 @@ gst_curl_http_src_get_header (void *header, size_t size, size_t nmemb,
     /* We have a status line! */
     gchar **status_line_fields;
 
+    /* A Content-Range of an earlier response (redirect) doesn't count */
+    s->content_size = 0;
+
     /* Have we already seen a status line? If so, delete any response headers */
     if (s->status_code > 0) {
       GstStructure *empty_headers =
@@ -1777,6 +1989,8 @@ gst_curl_http_src_get_header (void *header, size_t size, size_t nmemb,
       /* We have some special cases - deal with them here */
       if (g_strcmp0 (header_key, "content-type") == 0) {
         gst_curl_http_src_negotiate_caps (src);
+      } else if (g_strcmp0 (header_key, "content-range") == 0) {
+        gst_curl_http_src_parse_content_range (s, header_tpl[1]);
       }
 
       g_free (header_key);
@@ -1828,13 +2042,16 @@ gst_curl_http_src_strcasestr (const char *haystack, const char *needle)
 
 /*
  * Receive chunks of the requested body and pass these back to the ::create()
- * loop
+ * loop. The data is written straight into pooled blocks, which are pushed
+ * downstream as they are without any further copy.
  */
 static size_t
 gst_curl_http_src_get_chunks (void *chunk, size_t size, size_t nmemb, void *src)
 {
   GstCurlHttpSrc *s = src;
+  const guint8 *data = chunk;
   size_t chunk_len = size * nmemb;
+  size_t left = chunk_len;
   GST_TRACE_OBJECT (s,
       "Received curl chunk for URI %s of size %d", s->uri, (int) chunk_len);
   g_mutex_lock (&s->buffer_mutex);
@@ -1842,32 +2059,404 @@ gst_curl_http_src_get_chunks (void *chunk, size_t size, size_t nmemb, void *src)
     g_mutex_unlock (&s->buffer_mutex);
     return chunk_len;
   }
-  s->buffer =
-      g_realloc (s->buffer, (s->buffer_len + chunk_len + 1) * sizeof (char));
-  if (s->buffer == NULL) {
-    GST_ERROR_OBJECT (s, "Realloc for cURL response message failed!\n");
-    return 0;
+  if (s->first_byte_received == FALSE) {
+    s->ttfb = (g_get_monotonic_time () - s->request_start) * GST_USECOND;
+    s->first_byte_received = TRUE;
+    GST_DEBUG_OBJECT (s, "First body data for URI %s after %" GST_TIME_FORMAT,
+        s->uri, GST_TIME_ARGS (s->ttfb));
+  }
+  while (left > 0) {
+    gsize len;
+
+    if (s->block == NULL) {
+      if (gst_buffer_pool_acquire_buffer (s->pool, &s->block,
+              NULL) != GST_FLOW_OK) {
+        GST_ERROR_OBJECT (s, "Couldn't get a block for the cURL response!");
+        s->block = NULL;
+        g_mutex_unlock (&s->buffer_mutex);
+        return 0;
+      }
+      if (!gst_buffer_map (s->block, &s->block_map, GST_MAP_WRITE)) {
+        GST_ERROR_OBJECT (s, "Couldn't map a block for the cURL response!");
+        gst_buffer_unref (s->block);
+        s->block = NULL;
+        g_mutex_unlock (&s->buffer_mutex);
+        return 0;
+      }
+      s->block_filled = 0;
+    }
+
+    len = MIN (left, s->block_map.size - s->block_filled);
+    memcpy (s->block_map.data + s->block_filled, data, len);
+    s->block_filled += len;
+    data += len;
+    left -= len;
+
+    if (s->block_filled == s->block_map.size) {
+      gst_buffer_unmap (s->block, &s->block_map);
+      g_queue_push_tail (&s->ready_blocks, s->block);
+      s->block = NULL;
+      s->block_filled = 0;
+    }
   }
-  memcpy (s->buffer + s->buffer_len, chunk, chunk_len);
   s->buffer_len += chunk_len;
+  s->bytes_received += chunk_len;
   g_cond_signal (&s->signal);
   g_mutex_unlock (&s->buffer_mutex);
   return chunk_len;
 }
 
 /*
- * Request a cancellation of a currently running curl handle.
+ * Hand out the oldest block of received data. If no block is full yet, the one
+ * being filled is cut down to what it holds so far. Called with the
+ * buffer_mutex held and buffer_len > 0.
+ */
+static GstBuffer *
+gst_curl_http_src_take_block (GstCurlHttpSrc * src)
+{
+  GstBuffer *buf;
+
+  buf = g_queue_pop_head (&src->ready_blocks);
+  if (buf == NULL) {
+    gst_buffer_unmap (src->block, &src->block_map);
+    gst_buffer_set_size (src->block, src->block_filled);
+    buf = src->block;
+    src->block = NULL;
+    src->block_filled = 0;
+  }
+  src->buffer_len -= gst_buffer_get_size (buf);
+
+  return buf;
+}
+
+/*
+ * Throw away any received data that hasn't been pushed yet. Called with the
+ * buffer_mutex held.
  */
 static void
-gst_curl_http_src_request_remove (GstCurlHttpSrc * src)
+gst_curl_http_src_drop_blocks (GstCurlHttpSrc * src)
+{
+  GstBuffer *buf;
+
+  while ((buf = g_queue_pop_head (&src->ready_blocks)) != NULL) {
+    gst_buffer_unref (buf);
+  }
+  if (src->block != NULL) {
+    gst_buffer_unmap (src->block, &src->block_map);
+    gst_buffer_unref (src->block);
+    src->block = NULL;
+  }
+  src->block_filled = 0;
+  src->buffer_len = 0;
+}
+
+static GstStructure *
+gst_curl_http_src_get_stats (GstCurlHttpSrc * src)
 {
   GstCurlHttpSrcClass *klass = G_TYPE_INSTANCE_GET_CLASS (src,
       GST_TYPE_CURL_HTTP_SRC,
       GstCurlHttpSrcClass);
-  g_mutex_lock (&klass->multi_task_context.mutex);
+  GstStructure *stats;
+  gint loop = -1;
+
+  g_mutex_lock (&src->buffer_mutex);
+  if (src->multi_task_context != NULL) {
+    loop = (gint) (src->multi_task_context - klass->multi_task_contexts);
+  }
+  stats = gst_structure_new ("application/x-curlhttpsrc-stats",
+      "requests", G_TYPE_UINT, src->requests,
+      "bytes-received", G_TYPE_UINT64, src->bytes_received,
+      "ttfb", G_TYPE_UINT64, src->ttfb,
+      "stalls", G_TYPE_UINT, src->stalls,
+      "stall-time", G_TYPE_UINT64, src->stall_time,
+      "pending-bytes", G_TYPE_UINT, src->buffer_len,
+      "loop-thread", G_TYPE_INT, loop, NULL);
+  g_mutex_unlock (&src->buffer_mutex);
+
+  return stats;
+}
+
+/*
+ * Receive chunks of one of the byte ranges. The range memory was allocated for
+ * the whole range, so the data is written into place.
+ */
+static size_t
+gst_curl_http_src_get_range_chunks (void *chunk, size_t size, size_t nmemb,
+    void *range)
+{
+  GstCurlHttpSrcRange *r = range;
+  GstCurlHttpSrc *s = r->src;
+  size_t chunk_len = size * nmemb;
+
+  g_mutex_lock (&s->buffer_mutex);
+  if (s->state == GSTCURL_UNLOCK) {
+    g_mutex_unlock (&s->buffer_mutex);
+    return chunk_len;
+  }
+  if (chunk_len > r->size - r->filled) {
+    /* Fails the transfer of this range */
+    GST_WARNING_OBJECT (s, "Got more than the %" G_GSIZE_FORMAT " bytes "
+        "asked for at offset %" G_GUINT64_FORMAT, r->size, r->start);
+    g_mutex_unlock (&s->buffer_mutex);
+    return 0;
+  }
+  memcpy (r->map.data + r->filled, chunk, chunk_len);
+  r->filled += chunk_len;
+  s->bytes_received += chunk_len;
+  g_cond_signal (&s->signal);
+  g_mutex_unlock (&s->buffer_mutex);
+  return chunk_len;
+}
+
+/*
+ * Parse a "bytes first-last/total" Content-Range header value. Anything else,
+ * including an unknown total size, leaves content_size at 0.
+ */
+static void
+gst_curl_http_src_parse_content_range (GstCurlHttpSrc * s, const gchar * value)
+{
+  guint64 first, last, total;
+  gchar *end;
+
+  s->content_size = 0;
+
+  if (value == NULL || g_ascii_strncasecmp (value, "bytes ", 6) != 0) {
+    return;
+  }
+  first = g_ascii_strtoull (value + 6, &end, 10);
+  if (*end != '-') {
+    return;
+  }
+  last = g_ascii_strtoull (end + 1, &end, 10);
+  if (*end != '/' || !g_ascii_isdigit (end[1])) {
+    return;
+  }
+  total = g_ascii_strtoull (end + 1, &end, 10);
+  if (first != 0 || last < first || last >= total) {
+    return;
+  }
+
+  s->range_end = last;
+  s->content_size = total;
+}
+
+/*
+ * Called with the first data of a main transfer that asked for a range. A 206
+ * response starts the parallel range transfers for the rest of the body,
+ * anything else means the server sends the whole body in one go.
+ */
+static GstFlowReturn
+gst_curl_http_src_check_ranges (GstCurlHttpSrc * src)
+{
+  GstBaseSrc *basesrc = GST_BASE_SRC_CAST (src);
+
+  src->ranges_checked = TRUE;
+
+  if (src->status_code != 206) {
+    GST_INFO_OBJECT (src, "Server doesn't do ranges for URI %s (status %u), "
+        "receiving a single stream", src->uri, src->status_code);
+    return GST_FLOW_OK;
+  }
+
+  if (src->content_size == 0) {
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("Partial response without a usable Content-Range for URI %s",
+            src->uri));
+    return GST_FLOW_ERROR;
+  }
+
+  if (src->range_end + 1 == src->content_size) {
+    GST_DEBUG_OBJECT (src, "Whole body fits in the first range");
+    return GST_FLOW_OK;
+  }
+
+  GST_INFO_OBJECT (src, "Fetching %" G_GUINT64_FORMAT " bytes of URI %s in "
+      "%u parallel ranges", src->content_size, src->uri, src->parallel_ranges);
+  src->ranges_active = TRUE;
+  src->next_range_start = src->range_end + 1;
+
+  /* The Content-Length of the response was only the one of the first range */
+  basesrc->segment.duration = src->content_size;
+  gst_element_post_message (GST_ELEMENT (src),
+      gst_message_new_duration_changed (GST_OBJECT (src)));
+
+  if (!gst_curl_http_src_start_ranges (src)) {
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("Couldn't start range transfers for URI %s", src->uri));
+    return GST_FLOW_ERROR;
+  }
+
+  return GST_FLOW_OK;
+}
+
+/*
+ * Top up the range transfers to parallel_ranges - 1. Called with the
+ * buffer_mutex held.
+ */
+static gboolean
+gst_curl_http_src_start_ranges (GstCurlHttpSrc * src)
+{
+  GstCurlHttpSrcMultiTaskContext *context = src->multi_task_context;
+  GstCurlHttpSrcRange *range;
+  gboolean added = FALSE, ret = TRUE;
+
+  g_mutex_lock (&context->mutex);
+  while ((g_queue_get_length (&src->ranges) < src->parallel_ranges - 1) &&
+      (src->next_range_start < src->content_size)) {
+    range = g_slice_new0 (GstCurlHttpSrcRange);
+    range->src = src;
+    range->start = src->next_range_start;
+    range->size = MIN (src->range_size, src->content_size - range->start);
+    /* Kept mapped while curl writes into it. Only the part that has been
+     * written is shared downstream, see ::create_from_ranges() */
+    range->mem = gst_allocator_alloc (NULL, range->size, NULL);
+    gst_memory_map (range->mem, &range->map, GST_MAP_WRITE);
+
+    range->handle = gst_curl_http_src_create_easy_handle (src, range);
+    if ((range->handle == NULL) ||
+        !gst_curl_http_src_add_queue_item (&context->queue, src,
+            range->handle, range)) {
+      gst_curl_http_src_free_range (range);
+      ret = FALSE;
+      break;
+    }
+
+    GST_DEBUG_OBJECT (src, "Requesting range %" G_GUINT64_FORMAT "-%"
+        G_GUINT64_FORMAT, range->start, range->start + range->size - 1);
+    g_queue_push_tail (&src->ranges, range);
+    src->next_range_start += range->size;
+    added = TRUE;
+  }
+
+  if (added) {
+    context->state = GSTCURL_MULTI_LOOP_STATE_QUEUE_EVENT;
+    g_cond_signal (&context->signal);
+  }
+  g_mutex_unlock (&context->mutex);
+
+  return ret;
+}
+
+/*
+ * Hand out the data of the oldest range as it arrives. Once a range has been
+ * handed out completely it is freed and the next one is started, so no more
+ * than parallel_ranges - 1 ranges are ever buffered. Called with the
+ * buffer_mutex held.
+ */
+static GstFlowReturn
+gst_curl_http_src_create_from_ranges (GstCurlHttpSrc * src,
+    GstBuffer ** outbuf)
+{
+  GstCurlHttpSrcRange *range;
+  gint64 stall_start = -1;
+  gsize len;
+
+  while ((range = g_queue_peek_head (&src->ranges)) != NULL) {
+    if (src->state == GSTCURL_UNLOCK) {
+      return GST_FLOW_FLUSHING;
+    }
+    if (range->pushed < range->filled) {
+      break;
+    }
+    if (range->done) {
+      if ((range->result != CURLE_OK) || (range->filled != range->size)) {
+        GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+            ("Range at offset %" G_GUINT64_FORMAT " of URI %s failed: %s",
+                range->start, src->uri, curl_easy_strerror (range->result)));
+        return GST_FLOW_ERROR;
+      }
+      g_queue_pop_head (&src->ranges);
+      gst_curl_http_src_free_range (range);
+      if (!gst_curl_http_src_start_ranges (src)) {
+        GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+            ("Couldn't start range transfers for URI %s", src->uri));
+        return GST_FLOW_ERROR;
+      }
+      continue;
+    }
+    if (stall_start == -1) {
+      stall_start = g_get_monotonic_time ();
+    }
+    g_cond_wait (&src->signal, &src->buffer_mutex);
+  }
+
+  if (range == NULL) {
+    return GST_FLOW_EOS;
+  }
+
+  if (stall_start != -1) {
+    src->stalls++;
+    src->stall_time += (g_get_monotonic_time () - stall_start) * GST_USECOND;
+  }
+
+  len = range->filled - range->pushed;
+  *outbuf = gst_buffer_new ();
+  gst_buffer_append_memory (*outbuf,
+      gst_memory_share (range->mem, range->pushed, len));
+  range->pushed += len;
+
+  GST_DEBUG_OBJECT (src, "Pushing %" G_GSIZE_FORMAT " bytes of range at "
+      "offset %" G_GUINT64_FORMAT, len, range->start);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_curl_http_src_free_range (GstCurlHttpSrcRange * range)
+{
+  if (range->handle != NULL) {
+    curl_easy_cleanup (range->handle);
+  }
+  gst_memory_unmap (range->mem, &range->map);
+  gst_memory_unref (range->mem);
+  g_slice_free (GstCurlHttpSrcRange, range);
+}
+
+/*
+ * Free the ranges of an earlier transfer. Those the multi loop is still busy
+ * with were asked to be removed when the transfer got unlocked, wait for that
+ * to happen. Called with the buffer_mutex held.
+ */
+static void
+gst_curl_http_src_clear_ranges (GstCurlHttpSrc * src)
+{
+  GstCurlHttpSrcRange *range;
+  gint64 end_time;
+
+  while ((range = g_queue_peek_head (&src->ranges)) != NULL) {
+    if (!range->done) {
+      end_time = g_get_monotonic_time () + G_TIME_SPAN_SECOND;
+      if (!g_cond_wait_until (&src->signal, &src->buffer_mutex, end_time)) {
+        /* The request may have been overridden by another instance using
+         * the same loop, so ask again. */
+        GST_DEBUG_OBJECT (src, "Still waiting for ranges to be removed");
+        g_mutex_unlock (&src->buffer_mutex);
+        gst_curl_http_src_request_remove (src);
+        g_mutex_lock (&src->buffer_mutex);
+      }
+      continue;
+    }
+    g_queue_pop_head (&src->ranges);
+    gst_curl_http_src_free_range (range);
+  }
+  src->ranges_active = FALSE;
+}
+
+/*
+ * Request a cancellation of a currently running curl handle.
+ */
+static void
+gst_curl_http_src_request_remove (GstCurlHttpSrc * src)
+{
+  GstCurlHttpSrcMultiTaskContext *context = src->multi_task_context;
+
+  if (context == NULL)
+    return;
+
+  g_mutex_lock (&context->mutex);
 
-  klass->multi_task_context.state = GSTCURL_MULTI_LOOP_STATE_REQUEST_REMOVAL;
-  klass->multi_task_context.request_removal_element = src;
-  g_cond_signal (&klass->multi_task_context.signal);
-  g_mutex_unlock (&klass->multi_task_context.mutex);
+  context->state = GSTCURL_MULTI_LOOP_STATE_REQUEST_REMOVAL;
+  context->request_removal_element = src;
+  g_cond_signal (&context->signal);
+  g_mutex_unlock (&context->mutex);
 }
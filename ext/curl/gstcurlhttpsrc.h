@@ -83,6 +83,7 @@ typedef struct _GstCurlHttpSrc GstCurlHttpSrc;
 typedef struct _GstCurlHttpSrcClass GstCurlHttpSrcClass;
 typedef struct _GstCurlHttpSrcMultiTaskContext GstCurlHttpSrcMultiTaskContext;
 typedef struct _GstCurlHttpSrcQueueElement GstCurlHttpSrcQueueElement;
+typedef struct _GstCurlHttpSrcRange GstCurlHttpSrcRange;
 
 #define HTTP_HEADERS_NAME       "http-headers"
 #define HTTP_STATUS_CODE        "http-status-code"
@@ -102,6 +103,25 @@ typedef enum
     GSTCURL_HTTP_VERSION_MAX
   } GstCurlHttpVersion;
 
+/*
+ * One of the byte ranges a transfer is split into when parallel-ranges is
+ * above 1. The curl write callback fills mem through map, ::create() hands out
+ * the filled part in body order.
+ */
+struct _GstCurlHttpSrcRange
+{
+  GstCurlHttpSrc *src;
+  CURL *handle;
+  guint64 start;
+  gsize size;
+  GstMemory *mem;
+  GstMapInfo map;
+  gsize filled;                 /* Bytes written by curl */
+  gsize pushed;                 /* Bytes handed out by ::create() */
+  gboolean done;
+  CURLcode result;
+};
+
 struct _GstCurlHttpSrcMultiTaskContext
 {
   GstTask     *task;
@@ -132,7 +152,10 @@ struct _GstCurlHttpSrcClass
 {
   GstPushSrcClass parent_class;
 
-  GstCurlHttpSrcMultiTaskContext multi_task_context;
+  /* Transfers are spread over several multi loops, each running in its own
+   * thread. An instance sticks to the loop it was given in ::ref_multi() */
+  GstCurlHttpSrcMultiTaskContext *multi_task_contexts;
+  guint n_multi_task_contexts;
 };
 
 /*
@@ -176,6 +199,10 @@ struct _GstCurlHttpSrc
   gint total_retries;
   gint retries_remaining;
 
+  /* Parallel range mode */
+  guint parallel_ranges;
+  guint range_size;
+
   /*TODO As the following are all multi options, move these to curl task */
   guint max_connection_time;    /* */
   guint max_conns_per_server;   /* CURLMOPT_MAX_HOST_CONNECTIONS */
@@ -199,13 +226,48 @@ struct _GstCurlHttpSrc
     GSTCURL_MAX
   } state, pending_state;
   CURL *curl_handle;
+  GstCurlHttpSrcMultiTaskContext *multi_task_context;
   GMutex buffer_mutex;
   GCond signal;
-  gchar *buffer;
-  guint buffer_len;
+  /*
+   * Body data is written by the curl write callback straight into blocks from
+   * the pool. Full blocks wait in ready_blocks, the block being filled is kept
+   * mapped until ::create() takes it.
+   */
+  GstBufferPool *pool;
+  GQueue ready_blocks;
+  GstBuffer *block;
+  GstMapInfo block_map;
+  gsize block_filled;
+  guint buffer_len;             /* Bytes waiting in ready_blocks + block */
   gboolean transfer_begun;
   gboolean data_received;
 
+  /*
+   * Parallel range mode: the main transfer only asks for the first range. If
+   * the server answers with 206 the rest is fetched by up to
+   * parallel_ranges - 1 range transfers, which also bounds the memory spent on
+   * reordering. Protected by buffer_mutex.
+   */
+  gboolean range_requested;     /* Main transfer asked for the first range */
+  gboolean ranges_checked;      /* Its response has been looked at */
+  gboolean ranges_active;
+  guint64 range_end;            /* Last byte of the main transfer */
+  guint64 content_size;         /* Total size from Content-Range */
+  guint64 next_range_start;     /* First byte not requested yet */
+  GQueue ranges;                /* Range transfers in body order */
+
+  /*
+   * Transfer statistics, protected by buffer_mutex
+   */
+  gint64 request_start;         /* Monotonic time the request was submitted */
+  gboolean first_byte_received;
+  guint requests;
+  guint64 bytes_received;
+  GstClockTime ttfb;            /* Time to first body byte of the last request */
+  guint stalls;                 /* ::create() waits for data mid-transfer */
+  GstClockTime stall_time;
+
   /*
    * Response Headers
    */
@@ -245,6 +307,9 @@ enum
   PROP_MAXCONCURRENT_PROXY,
   PROP_MAXCONCURRENT_GLOBAL,
   PROP_HTTPVERSION,
+  PROP_PARALLEL_RANGES,
+  PROP_RANGE_SIZE,
+  PROP_STATS,
   PROP_MAX
 };
 
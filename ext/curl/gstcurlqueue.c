@@ -53,11 +53,13 @@
  * the entry there.
  * @param queue The queue to add an item to. Can be NULL.
  * @param s The item to be added to the queue.
+ * @param handle The curl handle doing the transfer for s.
+ * @param range The byte range handle fetches, NULL for the main transfer.
  * @return Returns TRUE (0) on success, FALSE (!0) is an error.
  */
 gboolean
 gst_curl_http_src_add_queue_item (GstCurlHttpSrcQueueElement ** queue,
-    GstCurlHttpSrc * s)
+    GstCurlHttpSrc * s, CURL * handle, GstCurlHttpSrcRange * range)
 {
   GstCurlHttpSrcQueueElement *insert_point;
 
@@ -83,6 +85,8 @@ gst_curl_http_src_add_queue_item (GstCurlHttpSrcQueueElement ** queue,
   }
 
   insert_point->p = s;
+  insert_point->handle = handle;
+  insert_point->range = range;
   g_mutex_init (&insert_point->running);
   insert_point->next = NULL;
   return TRUE;
@@ -137,7 +141,8 @@ gst_curl_http_src_remove_queue_item (GstCurlHttpSrcQueueElement ** queue,
  * handle. Only ever called from within the multi loop when the CURL handle
  * returns, so it's safe to assume that the transfer completed and the result
  * can be set as GSTCURL_RETURN_DONE (which doesn't necessarily mean that the
- * transfer was a success, just that CURL is finished with it)
+ * transfer was a success, just that CURL is finished with it). For the handle
+ * of a byte range only that range is marked as done.
  * @param queue The queue to remove an item from.
  * @param s The item to be removed.
  * @return Returns TRUE if item removed, FALSE if item couldn't be found.
@@ -150,7 +155,7 @@ gst_curl_http_src_remove_queue_handle (GstCurlHttpSrcQueueElement ** queue,
 
   prev_qelement = NULL;
   this_qelement = *queue;
-  while (this_qelement && (this_qelement->p->curl_handle != handle)) {
+  while (this_qelement && (this_qelement->handle != handle)) {
     prev_qelement = this_qelement;
     this_qelement = this_qelement->next;
   }
@@ -165,12 +170,17 @@ gst_curl_http_src_remove_queue_handle (GstCurlHttpSrcQueueElement ** queue,
   /* First, signal the transfer owner thread to wake up */
   g_mutex_lock (&this_qelement->p->buffer_mutex);
   g_cond_signal (&this_qelement->p->signal);
-  if (this_qelement->p->state != GSTCURL_UNLOCK) {
-    this_qelement->p->state = GSTCURL_DONE;
+  if (this_qelement->range != NULL) {
+    this_qelement->range->done = TRUE;
+    this_qelement->range->result = result;
   } else {
-    this_qelement->p->pending_state = GSTCURL_DONE;
+    if (this_qelement->p->state != GSTCURL_UNLOCK) {
+      this_qelement->p->state = GSTCURL_DONE;
+    } else {
+      this_qelement->p->pending_state = GSTCURL_DONE;
+    }
+    this_qelement->p->curl_result = result;
   }
-  this_qelement->p->curl_result = result;
   g_mutex_unlock (&this_qelement->p->buffer_mutex);
 
   /* First queue item matched. */
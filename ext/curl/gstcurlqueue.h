@@ -51,12 +51,14 @@
 struct _GstCurlHttpSrcQueueElement
 {
   GstCurlHttpSrc *p;
+  CURL *handle;
+  GstCurlHttpSrcRange *range;   /* NULL for the main transfer of p */
   GMutex running;
   GstCurlHttpSrcQueueElement *next;
 };
 
 gboolean gst_curl_http_src_add_queue_item (GstCurlHttpSrcQueueElement **queue,
-    GstCurlHttpSrc *s);
+    GstCurlHttpSrc *s, CURL *handle, GstCurlHttpSrcRange *range);
 gboolean gst_curl_http_src_remove_queue_item (
     GstCurlHttpSrcQueueElement **queue, GstCurlHttpSrc *s);
 gboolean gst_curl_http_src_remove_queue_handle (
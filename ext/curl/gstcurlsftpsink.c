@@ -89,6 +89,7 @@ static void gst_curl_sftp_sink_finalize (GObject * gobject);
 static gboolean set_sftp_options_unlocked (GstCurlBaseSink * curlbasesink);
 static gboolean set_sftp_dynamic_options_unlocked (GstCurlBaseSink *
     curlbasesink);
+static gboolean prepare_sftp_resume_unlocked (GstCurlBaseSink * curlbasesink);
 
 
 #define gst_curl_sftp_sink_parent_class parent_class
@@ -120,6 +121,8 @@ gst_curl_sftp_sink_class_init (GstCurlSftpSinkClass * klass)
   gstcurlbasesink_class->set_protocol_dynamic_options_unlocked =
       set_sftp_dynamic_options_unlocked;
   gstcurlbasesink_class->set_options_unlocked = set_sftp_options_unlocked;
+  gstcurlbasesink_class->prepare_resume_unlocked =
+      prepare_sftp_resume_unlocked;
 
   g_object_class_install_property (gobject_class, PROP_CREATE_DIRS,
       g_param_spec_boolean ("create-dirs", "Create missing directories",
@@ -156,6 +159,23 @@ set_sftp_dynamic_options_unlocked (GstCurlBaseSink * basesink)
   return TRUE;
 }
 
+/* continue the upload at the size of the remote file */
+static gboolean
+prepare_sftp_resume_unlocked (GstCurlBaseSink * basesink)
+{
+  CURLcode res;
+
+  res = curl_easy_setopt (basesink->curl, CURLOPT_RESUME_FROM_LARGE,
+      (curl_off_t) - 1);
+  if (res != CURLE_OK) {
+    basesink->error = g_strdup_printf ("failed to set resume offset: %s",
+        curl_easy_strerror (res));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 set_sftp_options_unlocked (GstCurlBaseSink * basesink)
 {
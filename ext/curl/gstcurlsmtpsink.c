@@ -204,6 +204,8 @@ gst_curl_smtp_sink_event (GstBaseSink * bsink, GstEvent * event)
       gst_curl_base_sink_set_live (bcsink, FALSE);
 
       GST_OBJECT_LOCK (sink);
+      /* the final boundary goes after the buffers still queued */
+      gst_curl_base_sink_wait_for_queue_drain_unlocked (bcsink);
       sink->eos = TRUE;
       if (bcsink->flow_ret == GST_FLOW_OK && sink->base64_chunk != NULL
           && !sink->final_boundary_added) {
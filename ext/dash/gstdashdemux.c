@@ -369,6 +369,7 @@ static void gst_dash_demux_set_property (GObject * object, guint prop_id,
 static void gst_dash_demux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static void gst_dash_demux_dispose (GObject * obj);
+static void gst_dash_demux_finalize (GObject * obj);
 
 /* GstAdaptiveDemux */
 static GstClockTime gst_dash_demux_get_duration (GstAdaptiveDemux * ademux);
@@ -438,6 +439,8 @@ SIDX_ENTRY (GstDashDemuxStream * s, gint i)
 
 static void gst_dash_demux_send_content_protection_event (gpointer cp_data,
     gpointer stream);
+static void gst_dash_demux_cancel_sidx_prefetch (GstDashDemux * demux);
+static void gst_dash_demux_sidx_cache_entry_free (gpointer entry);
 
 #define gst_dash_demux_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (GstDashDemux, gst_dash_demux, GST_TYPE_ADAPTIVE_DEMUX,
@@ -465,6 +468,19 @@ gst_dash_demux_dispose (GObject * obj)
   G_OBJECT_CLASS (parent_class)->dispose (obj);
 }
 
+static void
+gst_dash_demux_finalize (GObject * obj)
+{
+  GstDashDemux *demux = GST_DASH_DEMUX (obj);
+
+  /* Not in dispose, the reset there uses them and dispose can run twice */
+  g_hash_table_unref (demux->sidx_cache);
+  g_mutex_clear (&demux->sidx_cache_lock);
+  gst_object_unref (demux->sidx_downloader);
+
+  G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
 static gboolean
 gst_dash_demux_get_live_seek_range (GstAdaptiveDemux * demux, gint64 * start,
     gint64 * stop)
@@ -546,6 +562,7 @@ gst_dash_demux_class_init (GstDashDemuxClass * klass)
   gobject_class->set_property = gst_dash_demux_set_property;
   gobject_class->get_property = gst_dash_demux_get_property;
   gobject_class->dispose = gst_dash_demux_dispose;
+  gobject_class->finalize = gst_dash_demux_finalize;
 
 #ifndef GST_REMOVE_DEPRECATED
   g_object_class_install_property (gobject_class, PROP_MAX_BUFFERING_TIME,
@@ -667,6 +684,11 @@ gst_dash_demux_init (GstDashDemux * demux)
 
   g_mutex_init (&demux->client_lock);
 
+  g_mutex_init (&demux->sidx_cache_lock);
+  demux->sidx_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      gst_dash_demux_sidx_cache_entry_free);
+  demux->sidx_downloader = gst_uri_downloader_new ();
+
   gst_adaptive_demux_set_stream_struct_size (GST_ADAPTIVE_DEMUX_CAST (demux),
       sizeof (GstDashDemuxStream));
 }
@@ -1106,6 +1128,8 @@ gst_dash_demux_reset (GstAdaptiveDemux * ademux)
   demux->end_of_period = FALSE;
   demux->end_of_manifest = FALSE;
 
+  gst_dash_demux_cancel_sidx_prefetch (demux);
+
   if (demux->client) {
     gst_mpd_client_free (demux->client);
     demux->client = NULL;
@@ -1238,6 +1262,10 @@ gst_dash_demux_stream_update_headers_info (GstAdaptiveDemuxStream * stream)
     path = NULL;
   }
 
+  /* Known already, e.g. from the cache after a representation switch */
+  if (dashstream->sidx_parser.status == GST_ISOFF_SIDX_PARSER_FINISHED)
+    return;
+
   gst_mpd_client_get_next_header_index (dashdemux->client,
       &path, dashstream->index,
       &stream->fragment.index_range_start, &stream->fragment.index_range_end);
@@ -1459,6 +1487,305 @@ gst_dash_demux_stream_sidx_seek (GstDashDemuxStream * dashstream,
   return ret;
 }
 
+typedef struct
+{
+  GstSidxBox sidx;
+  guint64 base_offset;
+} GstDashDemuxSidxCacheEntry;
+
+typedef struct
+{
+  gchar *key;
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+} GstDashDemuxSidxPrefetch;
+
+static void
+gst_dash_demux_sidx_cache_entry_free (gpointer data)
+{
+  GstDashDemuxSidxCacheEntry *entry = data;
+
+  if (entry) {
+    g_free (entry->sidx.entries);
+    g_slice_free (GstDashDemuxSidxCacheEntry, entry);
+  }
+}
+
+static void
+gst_dash_demux_sidx_prefetch_free (GstDashDemuxSidxPrefetch * prefetch)
+{
+  g_free (prefetch->key);
+  g_free (prefetch->uri);
+  g_slice_free (GstDashDemuxSidxPrefetch, prefetch);
+}
+
+/* Only representations made of a single segment have a single SIDX that
+ * stays valid for the whole period */
+static gchar *
+gst_dash_demux_stream_sidx_key (GstDashDemuxStream * dashstream,
+    GstRepresentationNode * rep)
+{
+  GstDashDemux *demux = GST_DASH_DEMUX_CAST (dashstream->parent.demux);
+  GstActiveStream *active_stream = dashstream->active_stream;
+
+  if (rep == NULL || rep->id == NULL || active_stream->cur_segment_list
+      || active_stream->cur_seg_template)
+    return NULL;
+
+  return g_strdup_printf ("%u/%s",
+      gst_mpd_client_get_period_index (demux->client), rep->id);
+}
+
+static gboolean
+gst_dash_demux_sidx_entries_supported (const GstSidxBox * sidx)
+{
+  gint i;
+
+  for (i = 0; i < sidx->entries_count; i++) {
+    if (sidx->entries[i].ref_type != 0)
+      return FALSE;
+  }
+
+  return sidx->entries_count > 0;
+}
+
+static void
+gst_dash_demux_sidx_prefetch_func (gpointer data, gpointer user_data)
+{
+  GstDashDemuxSidxPrefetch *prefetch = data;
+  GstDashDemux *demux = user_data;
+  GstDashDemuxSidxCacheEntry *entry = NULL;
+  GstFragment *download = NULL;
+  GstSidxParser parser;
+  GstBuffer *buffer;
+  gboolean cancelled;
+  guint consumed;
+
+  g_mutex_lock (&demux->sidx_cache_lock);
+  cancelled = demux->sidx_prefetch_cancelled;
+  g_mutex_unlock (&demux->sidx_cache_lock);
+
+  if (!cancelled) {
+    GST_DEBUG_OBJECT (demux, "Prefetching index %s %" G_GINT64_FORMAT "-%"
+        G_GINT64_FORMAT, prefetch->uri, prefetch->range_start,
+        prefetch->range_end);
+    download = gst_uri_downloader_fetch_uri_with_range (demux->sidx_downloader,
+        prefetch->uri, NULL, FALSE, FALSE, TRUE, prefetch->range_start,
+        prefetch->range_end, NULL);
+  }
+
+  if (download) {
+    buffer = gst_fragment_get_buffer (download);
+    g_object_unref (download);
+
+    gst_isoff_sidx_parser_init (&parser);
+    if (buffer && gst_isoff_sidx_parser_add_buffer (&parser, buffer,
+            &consumed) == GST_ISOFF_PARSER_DONE
+        && gst_dash_demux_sidx_entries_supported (&parser.sidx)) {
+      entry = g_slice_new (GstDashDemuxSidxCacheEntry);
+      entry->sidx = parser.sidx;
+      entry->base_offset =
+          prefetch->range_start + parser.size + parser.sidx.first_offset;
+      parser.sidx.entries = NULL;
+    }
+    gst_isoff_sidx_parser_clear (&parser);
+    if (buffer)
+      gst_buffer_unref (buffer);
+  }
+
+  GST_DEBUG_OBJECT (demux, "Index of %s %s", prefetch->key,
+      entry ? "prefetched" : "not available");
+
+  /* Failures keep their NULL entry, the index is then downloaded as usual
+   * when switching and not retried in the background */
+  g_mutex_lock (&demux->sidx_cache_lock);
+  if (entry && !demux->sidx_prefetch_cancelled
+      && g_hash_table_lookup_extended (demux->sidx_cache, prefetch->key, NULL,
+          NULL)) {
+    g_hash_table_replace (demux->sidx_cache, prefetch->key, entry);
+    prefetch->key = NULL;
+    entry = NULL;
+  }
+  g_mutex_unlock (&demux->sidx_cache_lock);
+
+  gst_dash_demux_sidx_cache_entry_free (entry);
+  gst_dash_demux_sidx_prefetch_free (prefetch);
+}
+
+static void
+gst_dash_demux_cancel_sidx_prefetch (GstDashDemux * demux)
+{
+  GThreadPool *pool;
+
+  g_mutex_lock (&demux->sidx_cache_lock);
+  pool = demux->sidx_prefetch_pool;
+  demux->sidx_prefetch_pool = NULL;
+  demux->sidx_prefetch_cancelled = TRUE;
+  g_mutex_unlock (&demux->sidx_cache_lock);
+
+  if (pool) {
+    gst_uri_downloader_cancel (demux->sidx_downloader);
+    /* The queued prefetches only free themselves now */
+    g_thread_pool_free (pool, FALSE, TRUE);
+    gst_uri_downloader_reset (demux->sidx_downloader);
+  }
+
+  g_mutex_lock (&demux->sidx_cache_lock);
+  g_hash_table_remove_all (demux->sidx_cache);
+  demux->sidx_prefetch_cancelled = FALSE;
+  g_mutex_unlock (&demux->sidx_cache_lock);
+}
+
+/* Downloads the index of the representations with the next lower and next
+ * higher bandwidth, the likely targets of the next switch */
+static void
+gst_dash_demux_stream_prefetch_sidx (GstDashDemuxStream * dashstream)
+{
+  GstDashDemux *demux = GST_DASH_DEMUX_CAST (dashstream->parent.demux);
+  GstActiveStream *active_stream = dashstream->active_stream;
+  GstRepresentationNode *cur = active_stream->cur_representation;
+  GstRepresentationNode *lower = NULL, *higher = NULL, *targets[2];
+  GstDashDemuxSidxPrefetch *prefetch;
+  GList *list;
+  gchar *key;
+  guint i;
+
+  if (cur == NULL || active_stream->cur_adapt_set == NULL)
+    return;
+
+  for (list = active_stream->cur_adapt_set->Representations; list;
+      list = list->next) {
+    GstRepresentationNode *rep = list->data;
+
+    if (rep == cur)
+      continue;
+    if (rep->bandwidth <= cur->bandwidth) {
+      if (!lower || rep->bandwidth > lower->bandwidth)
+        lower = rep;
+    } else if (!higher || rep->bandwidth < higher->bandwidth) {
+      higher = rep;
+    }
+  }
+
+  targets[0] = higher;
+  targets[1] = lower;
+  for (i = 0; i < G_N_ELEMENTS (targets); i++) {
+    key = gst_dash_demux_stream_sidx_key (dashstream, targets[i]);
+    if (key == NULL)
+      continue;
+
+    g_mutex_lock (&demux->sidx_cache_lock);
+    if (g_hash_table_contains (demux->sidx_cache, key)) {
+      g_mutex_unlock (&demux->sidx_cache_lock);
+      g_free (key);
+      continue;
+    }
+
+    prefetch = g_slice_new0 (GstDashDemuxSidxPrefetch);
+    if (!gst_mpd_client_get_representation_index (demux->client,
+            active_stream, targets[i], &prefetch->uri, &prefetch->range_start,
+            &prefetch->range_end)) {
+      /* Not indexRange based, remember that */
+      g_hash_table_insert (demux->sidx_cache, key, NULL);
+      g_mutex_unlock (&demux->sidx_cache_lock);
+      gst_dash_demux_sidx_prefetch_free (prefetch);
+      continue;
+    }
+
+    if (demux->sidx_prefetch_pool == NULL)
+      demux->sidx_prefetch_pool =
+          g_thread_pool_new (gst_dash_demux_sidx_prefetch_func, demux, 1,
+          FALSE, NULL);
+
+    g_hash_table_insert (demux->sidx_cache, g_strdup (key), NULL);
+    prefetch->key = key;
+    g_thread_pool_push (demux->sidx_prefetch_pool, prefetch, NULL);
+    g_mutex_unlock (&demux->sidx_cache_lock);
+  }
+}
+
+/* Keeps the SIDX of the current representation for later switches back to
+ * it */
+static void
+gst_dash_demux_stream_cache_sidx (GstDashDemuxStream * dashstream)
+{
+  GstDashDemux *demux = GST_DASH_DEMUX_CAST (dashstream->parent.demux);
+  GstDashDemuxSidxCacheEntry *entry;
+  GstSidxBox *sidx = SIDX (dashstream);
+  gchar *key;
+
+  key = gst_dash_demux_stream_sidx_key (dashstream,
+      dashstream->active_stream->cur_representation);
+  if (key == NULL)
+    return;
+
+  entry = g_slice_new (GstDashDemuxSidxCacheEntry);
+  entry->sidx = *sidx;
+  entry->sidx.entries =
+      g_memdup (sidx->entries, sidx->entries_count * sizeof (GstSidxBoxEntry));
+  entry->base_offset = dashstream->sidx_base_offset;
+
+  g_mutex_lock (&demux->sidx_cache_lock);
+  g_hash_table_replace (demux->sidx_cache, key, entry);
+  g_mutex_unlock (&demux->sidx_cache_lock);
+
+  gst_dash_demux_stream_prefetch_sidx (dashstream);
+}
+
+/* Sets up the SIDX of the current representation from the cache, if it was
+ * parsed or prefetched before, and positions it at sidx_position */
+static gboolean
+gst_dash_demux_stream_restore_sidx (GstDashDemuxStream * dashstream)
+{
+  GstDashDemux *demux = GST_DASH_DEMUX_CAST (dashstream->parent.demux);
+  GstDashDemuxSidxCacheEntry *entry;
+  GstSidxBox *sidx = SIDX (dashstream);
+  gchar *key;
+
+  key = gst_dash_demux_stream_sidx_key (dashstream,
+      dashstream->active_stream->cur_representation);
+  if (key == NULL)
+    return FALSE;
+
+  g_mutex_lock (&demux->sidx_cache_lock);
+  entry = g_hash_table_lookup (demux->sidx_cache, key);
+  if (entry) {
+    gst_isoff_sidx_parser_clear (&dashstream->sidx_parser);
+    *sidx = entry->sidx;
+    sidx->entries = g_memdup (entry->sidx.entries,
+        entry->sidx.entries_count * sizeof (GstSidxBoxEntry));
+    dashstream->sidx_parser.status = GST_ISOFF_SIDX_PARSER_FINISHED;
+    dashstream->sidx_base_offset = entry->base_offset;
+  }
+  g_mutex_unlock (&demux->sidx_cache_lock);
+  g_free (key);
+
+  if (entry == NULL)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (dashstream->parent.pad, "Using cached index");
+  dashstream->allow_sidx = FALSE;
+
+  if (dashstream->sidx_position == GST_CLOCK_TIME_NONE) {
+    sidx->entry_index = 0;
+  } else if (gst_dash_demux_stream_sidx_seek (dashstream,
+          demux->parent.segment.rate >= 0, GST_SEEK_FLAG_SNAP_BEFORE,
+          dashstream->sidx_position, NULL) != GST_FLOW_OK) {
+    GST_WARNING_OBJECT (dashstream->parent.pad,
+        "Couldn't find position in cached index");
+    gst_isoff_sidx_parser_clear (&dashstream->sidx_parser);
+    dashstream->sidx_base_offset = 0;
+    dashstream->allow_sidx = TRUE;
+    return FALSE;
+  }
+  dashstream->sidx_position = sidx->entries[sidx->entry_index].pts;
+
+  gst_dash_demux_stream_prefetch_sidx (dashstream);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_dash_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
     GstSeekFlags flags, GstClockTime ts, GstClockTime * final_ts)
@@ -2254,6 +2581,10 @@ gst_dash_demux_stream_select_bitrate (GstAdaptiveDemuxStream * stream,
     dashstream->sidx_base_offset = 0;
     dashstream->allow_sidx = TRUE;
 
+    /* Avoid downloading the index again if we had it before */
+    if (gst_mpd_client_has_isoff_ondemand_profile (demux->client))
+      gst_dash_demux_stream_restore_sidx (dashstream);
+
     /* Reset ISOBMFF box parsing state */
     dashstream->isobmff_parser.current_fourcc = 0;
     dashstream->isobmff_parser.current_start_offset = 0;
@@ -2930,6 +3261,8 @@ gst_dash_demux_parse_isobmff (GstAdaptiveDemux * demux,
 
         /* We might've cleared the index above */
         if (sidx->entries_count > 0) {
+          gst_dash_demux_stream_cache_sidx (dash_stream);
+
           if (GST_CLOCK_TIME_IS_VALID (dash_stream->pending_seek_ts)) {
             /* FIXME, preserve seek flags */
             if (gst_dash_demux_stream_sidx_seek (dash_stream,
@@ -146,6 +146,15 @@ struct _GstDashDemux
 
   gboolean trickmode_no_audio;
   gboolean allow_trickmode_key_units;
+
+  /* Parsed SIDX of single segment representations by period and
+   * representation id, NULL while the index is being prefetched */
+  GMutex sidx_cache_lock;
+  GHashTable *sidx_cache;
+  /* Downloads the index of the representations next to the current one */
+  GThreadPool *sidx_prefetch_pool;
+  GstUriDownloader *sidx_downloader;
+  gboolean sidx_prefetch_cancelled;
 };
 
 struct _GstDashDemuxClass
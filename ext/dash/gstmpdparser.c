@@ -5518,6 +5518,54 @@ gst_mpd_client_get_next_header_index (GstMpdClient * client, gchar ** uri,
   return *uri == NULL ? FALSE : TRUE;
 }
 
+/* Index of a representation of the adaptation set of @stream, which need
+ * not be the active one. Only for a single segment with an indexRange. */
+gboolean
+gst_mpd_client_get_representation_index (GstMpdClient * client,
+    GstActiveStream * stream, GstRepresentationNode * representation,
+    gchar ** uri, gint64 * range_start, gint64 * range_end)
+{
+  GstStreamPeriod *stream_period;
+  GstSegmentBaseType *segment_base;
+  GstActiveStream tmp = { 0, };
+  gchar *base_url, *query = NULL;
+
+  g_return_val_if_fail (stream != NULL, FALSE);
+  g_return_val_if_fail (representation != NULL, FALSE);
+  stream_period = gst_mpdparser_get_stream_period (client);
+  g_return_val_if_fail (stream_period != NULL, FALSE);
+  g_return_val_if_fail (stream_period->period != NULL, FALSE);
+
+  *uri = NULL;
+
+  if (representation->SegmentList || representation->SegmentTemplate ||
+      stream->cur_adapt_set->SegmentList ||
+      stream->cur_adapt_set->SegmentTemplate)
+    return FALSE;
+
+  segment_base = gst_mpdparser_get_segment_base (stream_period->period,
+      stream->cur_adapt_set, representation);
+  if (segment_base == NULL || segment_base->indexRange == NULL)
+    return FALSE;
+
+  /* Resolve the base URL as if the representation was the active one */
+  tmp.baseURL_idx = stream->baseURL_idx;
+  tmp.cur_adapt_set = stream->cur_adapt_set;
+  tmp.cur_representation = representation;
+  base_url = gst_mpdparser_parse_baseURL (client, &tmp, &query);
+  g_free (query);
+  tmp.baseURL = base_url;
+
+  *uri = gst_uri_join_strings (base_url,
+      gst_mpdparser_get_initializationURL (&tmp,
+          segment_base->RepresentationIndex));
+  *range_start = segment_base->indexRange->first_byte_pos;
+  *range_end = segment_base->indexRange->last_byte_pos;
+  g_free (base_url);
+
+  return *uri != NULL;
+}
+
 GstClockTime
 gst_mpd_client_get_next_fragment_duration (GstMpdClient * client,
     GstActiveStream * stream)
@@ -320,6 +320,7 @@ gst_hls_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek)
   GList *walk;
   GstClockTime current_pos, target_pos, final_pos;
   guint64 bitrate;
+  gboolean want_iframe;
 
   gst_event_parse_seek (seek, &rate, &format, &flags, &start_type, &start,
       &stop_type, &stop);
@@ -333,35 +334,38 @@ gst_hls_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek)
 
   bitrate = gst_hls_demux_get_bitrate (hlsdemux);
 
-  /* Use I-frame variants for trick modes */
-  if (hlsdemux->master->iframe_variants != NULL
-      && rate < -1.0 && old_rate >= -1.0 && old_rate <= 1.0) {
+  /* Use I-frame variants for fast reverse playback and for key unit trick
+   * modes in both directions */
+  want_iframe = hlsdemux->master->iframe_variants != NULL &&
+      (rate < -1.0 || (rate > 1.0
+          && (flags & GST_SEEK_FLAG_TRICKMODE_KEY_UNITS)));
+
+  if (want_iframe != hlsdemux->current_variant->iframe) {
+    GstHLSVariantStream *variant;
     GError *err = NULL;
 
-    /* Switch to I-frame variant */
-    gst_hls_demux_set_current_variant (hlsdemux,
-        hlsdemux->master->iframe_variants->data);
-    gst_uri_downloader_reset (demux->downloader);
-    if (!gst_hls_demux_update_playlist (hlsdemux, FALSE, &err)) {
-      GST_ELEMENT_ERROR_FROM_ERROR (hlsdemux, "Could not switch playlist", err);
-      return FALSE;
-    }
-    //hlsdemux->discont = TRUE;
+    /* Go straight to the variant matching the bitrate we can afford at the
+     * new rate instead of loading the lowest one first */
+    if (want_iframe)
+      variant = gst_hls_master_playlist_get_variant_for_bitrate
+          (hlsdemux->master, hlsdemux->master->iframe_variants->data,
+          bitrate / ABS (rate));
+    else
+      variant = gst_hls_master_playlist_get_variant_for_bitrate
+          (hlsdemux->master, NULL, bitrate);
 
-    gst_hls_demux_change_playlist (hlsdemux, bitrate / ABS (rate), NULL);
-  } else if (rate > -1.0 && rate <= 1.0 && (old_rate < -1.0 || old_rate > 1.0)) {
-    GError *err = NULL;
-    /* Switch to normal variant */
-    gst_hls_demux_set_current_variant (hlsdemux,
-        hlsdemux->master->variants->data);
+    GST_DEBUG_OBJECT (hlsdemux, "Switching to %s variant with bandwidth %d",
+        want_iframe ? "I-frame" : "normal", variant->bandwidth);
+
+    gst_hls_demux_set_current_variant (hlsdemux, variant);
     gst_uri_downloader_reset (demux->downloader);
     if (!gst_hls_demux_update_playlist (hlsdemux, FALSE, &err)) {
       GST_ELEMENT_ERROR_FROM_ERROR (hlsdemux, "Could not switch playlist", err);
       return FALSE;
     }
-    //hlsdemux->discont = TRUE;
-    /* TODO why not continue using the same? that was being used up to now? */
-    gst_hls_demux_change_playlist (hlsdemux, bitrate, NULL);
+  } else if (want_iframe && rate != old_rate) {
+    /* Still in trick mode, but at a different rate */
+    gst_hls_demux_change_playlist (hlsdemux, bitrate / ABS (rate), NULL);
   }
 
   target_pos = rate < 0 ? stop : start;
@@ -449,6 +453,7 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
   GST_DEBUG_OBJECT (stream->pad, "seeking to sequence %u",
       (guint) current_sequence);
   hls_stream->reset_pts = TRUE;
+  hls_stream->average_download_time = GST_CLOCK_TIME_NONE;
   hls_stream->playlist->sequence = current_sequence;
   hls_stream->playlist->current_file = walk;
   hls_stream->playlist->sequence_position = current_pos;
@@ -505,6 +510,7 @@ create_stream_for_playlist (GstAdaptiveDemux * demux, GstM3U8 * playlist,
 
   hlsdemux_stream->do_typefind = TRUE;
   hlsdemux_stream->reset_pts = TRUE;
+  hlsdemux_stream->average_download_time = GST_CLOCK_TIME_NONE;
 }
 
 static gboolean
@@ -1053,17 +1059,68 @@ gst_hls_demux_stream_has_next_fragment (GstAdaptiveDemuxStream * stream)
   return has_next;
 }
 
+/* In key unit trick mode every fragment of an I-frame playlist is a single
+ * keyframe. At high rates more of them are listed than can be downloaded
+ * in time, so skip ahead until the next one starts at least one download
+ * time (scaled by the rate) after the one just downloaded. */
+static void
+gst_hls_demux_stream_skip_iframes (GstAdaptiveDemuxStream * stream,
+    GstM3U8 * m3u8, gboolean forward)
+{
+  GstHLSDemuxStream *hlsdemux_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstClockTime distance, skipped;
+  GstM3U8MediaFile *file;
+
+  if (GST_CLOCK_TIME_IS_VALID (stream->last_download_time)) {
+    if (GST_CLOCK_TIME_IS_VALID (hlsdemux_stream->average_download_time))
+      hlsdemux_stream->average_download_time =
+          (3 * hlsdemux_stream->average_download_time +
+          stream->last_download_time) / 4;
+    else
+      hlsdemux_stream->average_download_time = stream->last_download_time;
+  }
+
+  if (!GST_CLOCK_TIME_IS_VALID (hlsdemux_stream->average_download_time))
+    return;
+
+  distance = ABS (stream->demux->segment.rate) *
+      hlsdemux_stream->average_download_time;
+  skipped = stream->fragment.duration;
+
+  while (skipped < distance && gst_m3u8_has_next_fragment (m3u8, forward)) {
+    file = gst_m3u8_get_next_fragment (m3u8, forward, NULL, NULL);
+    if (file == NULL)
+      break;
+    skipped += file->duration;
+    gst_m3u8_media_file_unref (file);
+
+    gst_m3u8_advance_fragment (m3u8, forward);
+    hlsdemux_stream->reset_pts = TRUE;
+  }
+
+  GST_LOG_OBJECT (stream->pad, "Skipped %" GST_TIME_FORMAT " for a download "
+      "time of %" GST_TIME_FORMAT, GST_TIME_ARGS (skipped),
+      GST_TIME_ARGS (hlsdemux_stream->average_download_time));
+}
+
 static GstFlowReturn
 gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream * stream)
 {
   GstHLSDemuxStream *hlsdemux_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (stream->demux);
+  gboolean forward = stream->demux->segment.rate > 0;
   GstM3U8 *m3u8;
 
   m3u8 = gst_hls_demux_stream_get_m3u8 (hlsdemux_stream);
 
-  gst_m3u8_advance_fragment (m3u8, stream->demux->segment.rate > 0);
+  gst_m3u8_advance_fragment (m3u8, forward);
   hlsdemux_stream->reset_pts = FALSE;
 
+  if (hlsdemux_stream->is_primary_playlist && hlsdemux->current_variant &&
+      hlsdemux->current_variant->iframe &&
+      GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (stream->demux))
+    gst_hls_demux_stream_skip_iframes (stream, m3u8, forward);
+
   return GST_FLOW_OK;
 }
 
@@ -99,6 +99,10 @@ struct _GstHLSDemuxStream
   guint64 current_offset;              /* offset we're currently at */
   gboolean reset_pts;
 
+  /* smoothed fragment download time, for skipping I-frames in key unit
+   * trick mode */
+  GstClockTime average_download_time;
+
   /* decryption tooling */
 #if defined(HAVE_OPENSSL)
 # if OPENSSL_VERSION_NUMBER < 0x10100000L
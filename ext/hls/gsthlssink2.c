@@ -29,6 +29,32 @@
  * gst-launch-1.0 videotestsrc is-live=true ! x264enc ! hlssink max-files=5
  * ]|
  *
+ * With #GstHlsSink2:part-duration set, hlssink2 writes a low-latency HLS
+ * playlist: the segments are published while they are written, as
+ * EXT-X-PART partial segments that are byte ranges of the segment files,
+ * followed by an EXT-X-PRELOAD-HINT for the next one. An HTTP server can
+ * answer blocking playlist reloads with the #GstHlsSink2::get-playlist
+ * action signal.
+ *
+ * Requesting video_%u pads instead of the video and audio pads switches to
+ * ladder mode, in which each pad takes one encoded variant of the same
+ * stream. Every variant gets its own segments and media playlist, an audio
+ * pad then becomes an audio rendition shared by all variants, and a master
+ * playlist lists them all. All variants are split with the same target
+ * duration and request key frames at the same running times, so with
+ * encoders that honour these requests the segments of all variants are
+ * aligned. The playlists are written together once all variants finished
+ * a segment: each is first written to a temporary file, then all of them
+ * are renamed into place.
+ *
+ * ## Example ladder
+ * |[
+ * gst-launch-1.0 hlssink2 name=hls target-duration=2 \
+ *   videotestsrc is-live=true ! tee name=t \
+ *   t. ! queue ! x264enc bitrate=3000 ! hls.video_0 \
+ *   t. ! queue ! videoscale ! video/x-raw,width=640,height=360 ! \
+ *     x264enc bitrate=800 ! hls.video_1
+ * ]|
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -39,6 +65,7 @@
 #include <gst/video/video.h>
 #include <glib/gstdio.h>
 #include <memory.h>
+#include <errno.h>
 
 
 GST_DEBUG_CATEGORY_STATIC (gst_hls_sink2_debug);
@@ -47,11 +74,17 @@ GST_DEBUG_CATEGORY_STATIC (gst_hls_sink2_debug);
 #define DEFAULT_LOCATION "segment%05d.ts"
 #define DEFAULT_PLAYLIST_LOCATION "playlist.m3u8"
 #define DEFAULT_PLAYLIST_ROOT NULL
+#define DEFAULT_MASTER_PLAYLIST_LOCATION "master.m3u8"
 #define DEFAULT_MAX_FILES 10
 #define DEFAULT_TARGET_DURATION 15
 #define DEFAULT_PLAYLIST_LENGTH 5
+#define DEFAULT_PART_DURATION 0
 
 #define GST_M3U8_PLAYLIST_VERSION 3
+#define GST_M3U8_PLAYLIST_LL_VERSION 6
+
+/* segment boundaries of the variants further apart than this are reported */
+#define ALIGNMENT_TOLERANCE (GST_MSECOND)
 
 enum
 {
@@ -61,9 +94,26 @@ enum
   PROP_PLAYLIST_ROOT,
   PROP_MAX_FILES,
   PROP_TARGET_DURATION,
-  PROP_PLAYLIST_LENGTH
+  PROP_PLAYLIST_LENGTH,
+  PROP_PART_DURATION,
+  PROP_MASTER_PLAYLIST_LOCATION
+};
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_LOCATION,
+  PROP_PAD_PLAYLIST_LOCATION
 };
 
+enum
+{
+  SIGNAL_GET_PLAYLIST,
+  SIGNAL_LAST
+};
+
+static guint signals[SIGNAL_LAST];
+
 static GstStaticPadTemplate video_template = GST_STATIC_PAD_TEMPLATE ("video",
     GST_PAD_SINK,
     GST_PAD_REQUEST,
@@ -72,6 +122,13 @@ static GstStaticPadTemplate audio_template = GST_STATIC_PAD_TEMPLATE ("audio",
     GST_PAD_SINK,
     GST_PAD_REQUEST,
     GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate variant_template =
+GST_STATIC_PAD_TEMPLATE ("video_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS_ANY);
+
+G_DEFINE_TYPE (GstHlsSink2Pad, gst_hls_sink2_pad, GST_TYPE_GHOST_PAD);
 
 #define gst_hls_sink2_parent_class parent_class
 G_DEFINE_TYPE (GstHlsSink2, gst_hls_sink2, GST_TYPE_BIN);
@@ -87,6 +144,204 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans);
 static GstPad *gst_hls_sink2_request_new_pad (GstElement * element,
     GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
 static void gst_hls_sink2_release_pad (GstElement * element, GstPad * pad);
+static GstPadProbeReturn gst_hls_sink2_part_probe (GstPad * pad,
+    GstPadProbeInfo * info, gpointer user_data);
+static gchar *gst_hls_sink2_get_playlist (GstHlsSink2 * sink, guint variant,
+    guint msn, gint part, gboolean skip, GstClockTime timeout);
+
+static void
+gst_hls_sink2_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstHlsSink2Variant *variant = GST_HLS_SINK2_PAD (object)->variant;
+
+  switch (prop_id) {
+    case PROP_PAD_LOCATION:
+      g_free (variant->location);
+      variant->location = g_value_dup_string (value);
+      g_object_set (variant->splitmuxsink, "location", variant->location,
+          NULL);
+      break;
+    case PROP_PAD_PLAYLIST_LOCATION:
+      g_free (variant->playlist_location);
+      variant->playlist_location = g_value_dup_string (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_hls_sink2_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstHlsSink2Variant *variant = GST_HLS_SINK2_PAD (object)->variant;
+
+  switch (prop_id) {
+    case PROP_PAD_LOCATION:
+      g_value_set_string (value, variant->location);
+      break;
+    case PROP_PAD_PLAYLIST_LOCATION:
+      g_value_set_string (value, variant->playlist_location);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_hls_sink2_pad_class_init (GstHlsSink2PadClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_hls_sink2_pad_set_property;
+  gobject_class->get_property = gst_hls_sink2_pad_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_PAD_LOCATION,
+      g_param_spec_string ("location", "File Location",
+          "Location of the segment files of this variant, "
+          "<pad name>_segment%05d.ts by default", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PAD_PLAYLIST_LOCATION,
+      g_param_spec_string ("playlist-location", "Playlist Location",
+          "Location of the media playlist of this variant, "
+          "<pad name>.m3u8 by default", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_hls_sink2_pad_init (GstHlsSink2Pad * pad)
+{
+}
+
+static void
+gst_hls_sink2_variant_reset (GstHlsSink2Variant * variant)
+{
+  GstHlsSink2 *sink = variant->sink;
+
+  variant->index = 0;
+  variant->eos = FALSE;
+  variant->dirty = FALSE;
+  variant->max_bitrate = 0;
+  variant->last_end_time = GST_CLOCK_TIME_NONE;
+
+  if (variant->playlist)
+    gst_m3u8_playlist_free (variant->playlist);
+  variant->playlist =
+      gst_m3u8_playlist_new (GST_M3U8_PLAYLIST_VERSION, sink->playlist_length,
+      FALSE);
+
+  g_queue_foreach (&variant->old_locations, (GFunc) g_free, NULL);
+  g_queue_clear (&variant->old_locations);
+
+  gst_segment_init (&variant->part_segment, GST_FORMAT_TIME);
+  variant->part_start = GST_CLOCK_TIME_NONE;
+}
+
+/* Creates a splitmuxsink writing MPEG-TS segments to @location and adds it
+ * to the bin */
+static GstHlsSink2Variant *
+gst_hls_sink2_variant_new (GstHlsSink2 * sink, const gchar * location,
+    const gchar * playlist_location)
+{
+  GstHlsSink2Variant *variant;
+  GstElement *mux;
+  GstPad *pad;
+
+  variant = g_new0 (GstHlsSink2Variant, 1);
+  variant->sink = sink;
+  variant->location = g_strdup (location);
+  variant->playlist_location = g_strdup (playlist_location);
+  g_queue_init (&variant->old_locations);
+
+  variant->splitmuxsink = gst_element_factory_make ("splitmuxsink", NULL);
+  if (!variant->splitmuxsink) {
+    g_free (variant->location);
+    g_free (variant->playlist_location);
+    g_free (variant);
+    return NULL;
+  }
+  gst_bin_add (GST_BIN (sink), variant->splitmuxsink);
+
+  mux = gst_element_factory_make ("mpegtsmux", NULL);
+  g_object_set (variant->splitmuxsink, "location", variant->location,
+      "max-size-time", ((GstClockTime) sink->target_duration * GST_SECOND),
+      "send-keyframe-requests", TRUE, "muxer", mux, "reset-muxer", FALSE, NULL);
+
+  /* The partial segments are cut from the muxed data on its way to the
+   * files */
+  variant->filesink = gst_element_factory_make ("filesink", NULL);
+  if (sink->part_duration > 0)
+    gst_util_set_object_arg (G_OBJECT (variant->filesink), "buffer-mode",
+        "unbuffered");
+  g_object_set (variant->splitmuxsink, "sink", variant->filesink, NULL);
+  pad = gst_element_get_static_pad (variant->filesink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_BUFFER_LIST | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      gst_hls_sink2_part_probe, variant, NULL);
+  gst_object_unref (pad);
+
+  gst_hls_sink2_variant_reset (variant);
+
+  g_mutex_lock (&sink->lock);
+  sink->variants = g_list_append (sink->variants, variant);
+  g_mutex_unlock (&sink->lock);
+
+  return variant;
+}
+
+static void
+gst_hls_sink2_variant_free (GstHlsSink2Variant * variant)
+{
+  g_free (variant->location);
+  g_free (variant->playlist_location);
+  g_free (variant->current_location);
+  g_free (variant->current_entry_location);
+  if (variant->playlist)
+    gst_m3u8_playlist_free (variant->playlist);
+
+  g_queue_foreach (&variant->old_locations, (GFunc) g_free, NULL);
+  g_queue_clear (&variant->old_locations);
+
+  g_free (variant);
+}
+
+/* Takes the variant out of the bin and frees it */
+static void
+gst_hls_sink2_variant_remove (GstHlsSink2 * sink, GstHlsSink2Variant * variant)
+{
+  g_mutex_lock (&sink->lock);
+  sink->variants = g_list_remove (sink->variants, variant);
+  if (sink->main == variant)
+    sink->main = NULL;
+  /* wake up get-playlist, the playlist it may wait for is gone */
+  sink->generation++;
+  g_cond_broadcast (&sink->playlist_cond);
+  g_mutex_unlock (&sink->lock);
+
+  gst_element_set_locked_state (variant->splitmuxsink, TRUE);
+  gst_element_set_state (variant->splitmuxsink, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN (sink), variant->splitmuxsink);
+
+  gst_hls_sink2_variant_free (variant);
+}
+
+static GstHlsSink2Variant *
+gst_hls_sink2_find_variant (GstHlsSink2 * sink, GstObject * splitmuxsink)
+{
+  GList *l;
+
+  for (l = sink->variants; l; l = l->next) {
+    GstHlsSink2Variant *variant = l->data;
+
+    if (GST_OBJECT_CAST (variant->splitmuxsink) == splitmuxsink)
+      return variant;
+  }
+
+  return NULL;
+}
 
 static void
 gst_hls_sink2_dispose (GObject * object)
@@ -104,11 +359,14 @@ gst_hls_sink2_finalize (GObject * object)
   g_free (sink->location);
   g_free (sink->playlist_location);
   g_free (sink->playlist_root);
-  if (sink->playlist)
-    gst_m3u8_playlist_free (sink->playlist);
+  g_free (sink->master_playlist_location);
+
+  /* the splitmuxsinks went with the children of the bin */
+  g_list_free_full (sink->variants,
+      (GDestroyNotify) gst_hls_sink2_variant_free);
 
-  g_queue_foreach (&sink->old_locations, (GFunc) g_free, NULL);
-  g_queue_clear (&sink->old_locations);
+  g_mutex_clear (&sink->lock);
+  g_cond_clear (&sink->playlist_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize ((GObject *) sink);
 }
@@ -126,6 +384,8 @@ gst_hls_sink2_class_init (GstHlsSink2Class * klass)
 
   gst_element_class_add_static_pad_template (element_class, &video_template);
   gst_element_class_add_static_pad_template (element_class, &audio_template);
+  gst_element_class_add_static_pad_template_with_gtype (element_class,
+      &variant_template, GST_TYPE_HLS_SINK2_PAD);
 
   gst_element_class_set_static_metadata (element_class,
       "HTTP Live Streaming sink", "Sink", "HTTP Live Streaming sink",
@@ -176,28 +436,64 @@ gst_hls_sink2_class_init (GstHlsSink2Class * klass)
           "the playlist will be infinite.",
           0, G_MAXUINT, DEFAULT_PLAYLIST_LENGTH,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PART_DURATION,
+      g_param_spec_uint64 ("part-duration", "Part duration",
+          "Target duration in nanoseconds of the partial segments of a "
+          "low-latency HLS playlist (0 - disabled)",
+          0, G_MAXUINT64, DEFAULT_PART_DURATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class,
+      PROP_MASTER_PLAYLIST_LOCATION,
+      g_param_spec_string ("master-playlist-location",
+          "Master Playlist Location",
+          "Location of the master playlist to write in ladder mode",
+          DEFAULT_MASTER_PLAYLIST_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHlsSink2::get-playlist:
+   * @sink: the #GstHlsSink2
+   * @variant: the variant in the order the pads were requested, 0 without
+   *     ladder
+   * @msn: media sequence number of the segment to wait for
+   * @part: partial segment of @msn to wait for, or -1 for the whole segment
+   * @skip: whether to render a delta update of the playlist
+   * @timeout: the maximum time to wait, or %GST_CLOCK_TIME_NONE
+   *
+   * Blocks until the media playlist contains the requested segment or
+   * partial segment and returns it, as needed for the _HLS_msn, _HLS_part
+   * and _HLS_skip query parameters of a blocking playlist reload. The
+   * playlist is returned right away once the stream has ended.
+   *
+   * Returns: the rendered playlist, or %NULL on timeout or if the element
+   *     was stopped while waiting.
+   */
+  signals[SIGNAL_GET_PLAYLIST] =
+      g_signal_new ("get-playlist", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstHlsSink2Class, get_playlist), NULL, NULL,
+      g_cclosure_marshal_generic, G_TYPE_STRING, 5, G_TYPE_UINT, G_TYPE_UINT,
+      G_TYPE_INT, G_TYPE_BOOLEAN, G_TYPE_UINT64);
+
+  klass->get_playlist = gst_hls_sink2_get_playlist;
 }
 
 static void
 gst_hls_sink2_init (GstHlsSink2 * sink)
 {
-  GstElement *mux;
-
   sink->location = g_strdup (DEFAULT_LOCATION);
   sink->playlist_location = g_strdup (DEFAULT_PLAYLIST_LOCATION);
   sink->playlist_root = g_strdup (DEFAULT_PLAYLIST_ROOT);
+  sink->master_playlist_location = g_strdup (DEFAULT_MASTER_PLAYLIST_LOCATION);
   sink->playlist_length = DEFAULT_PLAYLIST_LENGTH;
   sink->max_files = DEFAULT_MAX_FILES;
   sink->target_duration = DEFAULT_TARGET_DURATION;
-  g_queue_init (&sink->old_locations);
+  sink->part_duration = DEFAULT_PART_DURATION;
+  g_mutex_init (&sink->lock);
+  g_cond_init (&sink->playlist_cond);
 
-  sink->splitmuxsink = gst_element_factory_make ("splitmuxsink", NULL);
-  gst_bin_add (GST_BIN (sink), sink->splitmuxsink);
-
-  mux = gst_element_factory_make ("mpegtsmux", NULL);
-  g_object_set (sink->splitmuxsink, "location", sink->location, "max-size-time",
-      ((GstClockTime) sink->target_duration * GST_SECOND),
-      "send-keyframe-requests", TRUE, "muxer", mux, "reset-muxer", FALSE, NULL);
+  sink->main = gst_hls_sink2_variant_new (sink, sink->location,
+      sink->playlist_location);
 
   GST_OBJECT_FLAG_SET (sink, GST_ELEMENT_FLAG_SINK);
 
@@ -207,94 +503,505 @@ gst_hls_sink2_init (GstHlsSink2 * sink)
 static void
 gst_hls_sink2_reset (GstHlsSink2 * sink)
 {
-  sink->index = 0;
+  GList *l;
 
-  if (sink->playlist)
-    gst_m3u8_playlist_free (sink->playlist);
-  sink->playlist =
-      gst_m3u8_playlist_new (GST_M3U8_PLAYLIST_VERSION, sink->playlist_length,
-      FALSE);
+  g_mutex_lock (&sink->lock);
+  for (l = sink->variants; l; l = l->next)
+    gst_hls_sink2_variant_reset (l->data);
+  sink->segments_written = 0;
+
+  /* wake up get-playlist, the playlist it waits for is gone */
+  sink->generation++;
+  g_cond_broadcast (&sink->playlist_cond);
+  g_mutex_unlock (&sink->lock);
+}
+
+static gchar *
+gst_hls_sink2_get_entry_location (GstHlsSink2 * sink, const gchar * location)
+{
+  gchar *name, *entry_location;
+
+  name = g_path_get_basename (location);
+  if (sink->playlist_root == NULL)
+    return name;
+
+  entry_location = g_build_filename (sink->playlist_root, name, NULL);
+  g_free (name);
+
+  return entry_location;
+}
+
+/* Call with the lock */
+static gchar *
+gst_hls_sink2_render_master_playlist (GstHlsSink2 * sink)
+{
+  GstHlsSink2Variant *audio = NULL;
+  GString *str;
+  GList *l;
+
+  str = g_string_new ("#EXTM3U\n");
+  g_string_append_printf (str, "#EXT-X-VERSION:%d\n",
+      sink->part_duration > 0 ? GST_M3U8_PLAYLIST_LL_VERSION :
+      GST_M3U8_PLAYLIST_VERSION);
+
+  for (l = sink->variants; l; l = l->next) {
+    GstHlsSink2Variant *variant = l->data;
+
+    if (variant->is_audio) {
+      gchar *uri =
+          gst_hls_sink2_get_entry_location (sink, variant->playlist_location);
+
+      audio = variant;
+      g_string_append_printf (str, "#EXT-X-MEDIA:TYPE=AUDIO,"
+          "GROUP-ID=\"audio\",NAME=\"audio\",DEFAULT=YES,AUTOSELECT=YES,"
+          "URI=\"%s\"\n", uri);
+      g_free (uri);
+    }
+  }
+
+  for (l = sink->variants; l; l = l->next) {
+    GstHlsSink2Variant *variant = l->data;
+    GstCaps *caps;
+    gchar *uri;
+
+    if (variant->is_audio)
+      continue;
+
+    /* the peak bitrate of all media of the variant */
+    g_string_append_printf (str, "#EXT-X-STREAM-INF:BANDWIDTH=%"
+        G_GUINT64_FORMAT, variant->max_bitrate +
+        (audio ? audio->max_bitrate : 0));
+
+    caps = gst_pad_get_current_caps (variant->pad);
+    if (caps) {
+      GstStructure *s = gst_caps_get_structure (caps, 0);
+      gint width, height;
+
+      if (gst_structure_get_int (s, "width", &width)
+          && gst_structure_get_int (s, "height", &height))
+        g_string_append_printf (str, ",RESOLUTION=%dx%d", width, height);
+      gst_caps_unref (caps);
+    }
 
-  g_queue_foreach (&sink->old_locations, (GFunc) g_free, NULL);
-  g_queue_clear (&sink->old_locations);
+    if (audio)
+      g_string_append (str, ",AUDIO=\"audio\"");
+
+    uri = gst_hls_sink2_get_entry_location (sink, variant->playlist_location);
+    g_string_append_printf (str, "\n%s\n", uri);
+    g_free (uri);
+  }
+
+  return g_string_free (str, FALSE);
 }
 
+/* Writes the playlist of @variant, or all changed playlists if it is %NULL,
+ * together with the master playlist in ladder mode. Each file is written
+ * to a temporary file first and all of them are renamed once they are
+ * complete, so readers never see a half written playlist or playlists of
+ * different segment boundaries. Call with the lock. */
 static void
-gst_hls_sink2_write_playlist (GstHlsSink2 * sink)
+gst_hls_sink2_write_playlists (GstHlsSink2 * sink,
+    GstHlsSink2Variant * variant)
 {
-  char *playlist_content;
+  GPtrArray *locations = g_ptr_array_new_with_free_func (g_free);
   GError *error = NULL;
+  gchar *content = NULL, *tmp = NULL;
+  GList *l;
+  guint i;
+
+  for (l = sink->variants; l; l = l->next) {
+    GstHlsSink2Variant *v = l->data;
+
+    if (variant ? v != variant : !v->dirty)
+      continue;
+
+    content = gst_m3u8_playlist_render (v->playlist);
+    tmp = g_strconcat (v->playlist_location, ".tmp", NULL);
+    v->dirty = FALSE;
+
+    if (!g_file_set_contents (tmp, content, -1, &error))
+      goto write_error;
+    g_ptr_array_add (locations, tmp);
+    g_ptr_array_add (locations, g_strdup (v->playlist_location));
+    g_free (content);
+  }
 
-  playlist_content = gst_m3u8_playlist_render (sink->playlist);
-  if (!g_file_set_contents (sink->playlist_location,
-          playlist_content, -1, &error)) {
+  if (!variant && !sink->main) {
+    content = gst_hls_sink2_render_master_playlist (sink);
+    tmp = g_strconcat (sink->master_playlist_location, ".tmp", NULL);
+
+    if (!g_file_set_contents (tmp, content, -1, &error))
+      goto write_error;
+    g_ptr_array_add (locations, tmp);
+    g_ptr_array_add (locations, g_strdup (sink->master_playlist_location));
+    g_free (content);
+  }
+
+  for (i = 0; i < locations->len; i += 2) {
+    const gchar *from = g_ptr_array_index (locations, i);
+    const gchar *to = g_ptr_array_index (locations, i + 1);
+
+    if (g_rename (from, to) != 0) {
+      GST_ERROR_OBJECT (sink, "Failed to rename playlist to %s: %s", to,
+          g_strerror (errno));
+      GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
+          (("Failed to write playlist '%s'."), to), (NULL));
+      break;
+    }
+  }
+
+  g_ptr_array_unref (locations);
+  g_cond_broadcast (&sink->playlist_cond);
+  return;
+
+write_error:
+  {
     GST_ERROR ("Failed to write playlist: %s", error->message);
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
         (("Failed to write playlist '%s'."), error->message), (NULL));
     g_error_free (error);
-    error = NULL;
+    g_free (content);
+    g_free (tmp);
+    for (i = 0; i < locations->len; i += 2)
+      g_remove (g_ptr_array_index (locations, i));
+    g_ptr_array_unref (locations);
+    g_cond_broadcast (&sink->playlist_cond);
+    return;
+  }
+}
+
+/* Removes the segments that dropped out of the playlists. Only call after
+ * the playlists have been written, a reader can still be fetching what the
+ * previous ones listed. Call with the lock. */
+static void
+gst_hls_sink2_delete_old_segments (GstHlsSink2 * sink)
+{
+  GList *l;
+
+  for (l = sink->variants; l; l = l->next) {
+    GstHlsSink2Variant *variant = l->data;
+
+    while (g_queue_get_length (&variant->old_locations) >
+        g_queue_get_length (variant->playlist->entries)) {
+      gchar *old_location = g_queue_pop_head (&variant->old_locations);
+      g_remove (old_location);
+      g_free (old_location);
+    }
+  }
+}
+
+/* Writes the playlists once every variant finished the segments written
+ * so far, then deletes the segments they no longer list. Call with the
+ * lock. */
+static void
+gst_hls_sink2_check_segment_boundary (GstHlsSink2 * sink)
+{
+  GstClockTime first = GST_CLOCK_TIME_NONE;
+  guint done = G_MAXUINT, last = 0;
+  GList *l;
+
+  for (l = sink->variants; l; l = l->next) {
+    GstHlsSink2Variant *variant = l->data;
+
+    last = MAX (last, variant->index);
+    if (!variant->eos)
+      done = MIN (done, variant->index);
+  }
+  /* all ended, write what is left */
+  if (done == G_MAXUINT)
+    done = last + 1;
+
+  if (done <= sink->segments_written)
+    return;
+
+  for (l = sink->variants; l; l = l->next) {
+    GstHlsSink2Variant *variant = l->data;
+
+    if (variant->index != done || variant->is_audio)
+      continue;
+
+    if (!GST_CLOCK_TIME_IS_VALID (first)) {
+      first = variant->last_end_time;
+    } else if (GST_CLOCK_TIME_IS_VALID (variant->last_end_time)
+        && ABS (GST_CLOCK_DIFF (first, variant->last_end_time)) >
+        ALIGNMENT_TOLERANCE) {
+      GST_WARNING_OBJECT (sink, "segment %u of %s ends at %" GST_TIME_FORMAT
+          " instead of %" GST_TIME_FORMAT ", the encoders do not follow the "
+          "key frame requests", done - 1, variant->playlist_location,
+          GST_TIME_ARGS (variant->last_end_time), GST_TIME_ARGS (first));
+    }
   }
-  g_free (playlist_content);
 
+  GST_DEBUG_OBJECT (sink, "all variants finished %u segments", done);
+  gst_hls_sink2_write_playlists (sink, NULL);
+  sink->segments_written = done;
+  gst_hls_sink2_delete_old_segments (sink);
+}
+
+/* Call with the lock */
+static void
+gst_hls_sink2_add_part (GstHlsSink2Variant * variant, guint64 end_offset,
+    GstClockTime end_time)
+{
+  GST_LOG_OBJECT (variant->sink, "part of %" GST_TIME_FORMAT " at %"
+      G_GUINT64_FORMAT " in %s", GST_TIME_ARGS (end_time - variant->part_start),
+      variant->part_offset, variant->current_location);
+
+  gst_m3u8_playlist_add_part (variant->playlist,
+      variant->current_entry_location, end_time - variant->part_start,
+      variant->part_offset, end_offset - variant->part_offset,
+      variant->part_independent);
+
+  variant->part_offset = end_offset;
+  variant->part_start = end_time;
+}
+
+/* Publishes the part that is complete once data of @running_time arrives.
+ * Parts end at buffer boundaries, preferably at the last one that keeps
+ * them within the part duration. Call with the lock. */
+static gboolean
+gst_hls_sink2_cut_parts (GstHlsSink2Variant * variant,
+    GstClockTime running_time, gboolean independent)
+{
+  GstClockTime part_duration = variant->sink->part_duration;
+  gboolean ret = FALSE;
+
+  if (running_time > variant->part_start + part_duration
+      && variant->boundary_offset > variant->part_offset) {
+    gst_hls_sink2_add_part (variant, variant->boundary_offset,
+        variant->boundary_time);
+    variant->part_independent = variant->boundary_independent;
+    ret = TRUE;
+  }
+
+  if (running_time >= variant->part_start + part_duration
+      && variant->fragment_offset > variant->part_offset) {
+    gst_hls_sink2_add_part (variant, variant->fragment_offset, running_time);
+    variant->part_independent = independent;
+    ret = TRUE;
+  }
+
+  return ret;
+}
+
+/* Call with the lock */
+static gboolean
+gst_hls_sink2_add_part_data (GstHlsSink2Variant * variant, GstBuffer * buffer)
+{
+  GstClockTime running_time = GST_CLOCK_TIME_NONE;
+  gboolean independent, ret = FALSE;
+
+  independent = !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  if (GST_BUFFER_PTS_IS_VALID (buffer))
+    running_time = gst_segment_to_running_time (&variant->part_segment,
+        GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+
+  if (variant->sink->part_duration > 0
+      && GST_CLOCK_TIME_IS_VALID (running_time)
+      && GST_CLOCK_TIME_IS_VALID (variant->part_start)
+      && running_time >= variant->part_start) {
+    ret = gst_hls_sink2_cut_parts (variant, running_time, independent);
+
+    if (!GST_CLOCK_TIME_IS_VALID (variant->boundary_time)
+        || running_time >= variant->boundary_time) {
+      variant->boundary_offset = variant->fragment_offset;
+      variant->boundary_time = running_time;
+      variant->boundary_independent = independent;
+    }
+  }
+
+  variant->fragment_offset += gst_buffer_get_size (buffer);
+
+  return ret;
+}
+
+static GstPadProbeReturn
+gst_hls_sink2_part_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstHlsSink2Variant *variant = user_data;
+  GstHlsSink2 *sink = variant->sink;
+  gboolean published = FALSE;
+
+  g_mutex_lock (&sink->lock);
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT)
+      gst_event_copy_segment (event, &variant->part_segment);
+  } else if (variant->current_entry_location) {
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+      published = gst_hls_sink2_add_part_data (variant,
+          GST_PAD_PROBE_INFO_BUFFER (info));
+    } else {
+      GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+      guint i, len = gst_buffer_list_length (list);
+
+      for (i = 0; i < len; i++)
+        published |= gst_hls_sink2_add_part_data (variant,
+            gst_buffer_list_get (list, i));
+    }
+  }
+
+  /* parts are not batched with the other variants, that would delay them
+   * to the segment boundary */
+  if (published) {
+    gst_m3u8_playlist_set_preload_hint (variant->playlist,
+        variant->current_entry_location, variant->part_offset);
+    gst_hls_sink2_write_playlists (sink, variant);
+  }
+
+  g_mutex_unlock (&sink->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static gchar *
+gst_hls_sink2_get_playlist (GstHlsSink2 * sink, guint n, guint msn,
+    gint part, gboolean skip, GstClockTime timeout)
+{
+  GstHlsSink2Variant *variant;
+  gint64 end_time = 0;
+  guint generation;
+  gchar *ret = NULL;
+
+  g_mutex_lock (&sink->lock);
+
+  if (GST_CLOCK_TIME_IS_VALID (timeout))
+    end_time = g_get_monotonic_time () + timeout / GST_USECOND;
+
+  variant = g_list_nth_data (sink->variants, n);
+  if (!variant) {
+    g_mutex_unlock (&sink->lock);
+    return NULL;
+  }
+
+  generation = sink->generation;
+  while (sink->generation == generation && !variant->playlist->end_list
+      && !gst_m3u8_playlist_has_part (variant->playlist, msn, part)) {
+    if (!GST_CLOCK_TIME_IS_VALID (timeout)) {
+      g_cond_wait (&sink->playlist_cond, &sink->lock);
+    } else if (!g_cond_wait_until (&sink->playlist_cond, &sink->lock,
+            end_time)) {
+      GST_DEBUG_OBJECT (sink, "timeout waiting for part %d of segment %u",
+          part, msn);
+      break;
+    }
+  }
+
+  if (sink->generation == generation && (variant->playlist->end_list
+          || gst_m3u8_playlist_has_part (variant->playlist, msn, part))) {
+    if (skip)
+      ret = gst_m3u8_playlist_render_delta (variant->playlist);
+    else
+      ret = gst_m3u8_playlist_render (variant->playlist);
+  }
+
+  g_mutex_unlock (&sink->lock);
+
+  return ret;
+}
+
+/* Call with the lock */
+static void
+gst_hls_sink2_fragment_opened (GstHlsSink2Variant * variant,
+    const GstStructure * s)
+{
+  GstHlsSink2 *sink = variant->sink;
+
+  g_free (variant->current_location);
+  variant->current_location =
+      g_strdup (gst_structure_get_string (s, "location"));
+  gst_structure_get_clock_time (s, "running-time",
+      &variant->current_running_time_start);
+
+  g_free (variant->current_entry_location);
+  variant->current_entry_location =
+      gst_hls_sink2_get_entry_location (sink, variant->current_location);
+  variant->fragment_offset = variant->part_offset = 0;
+  variant->part_start = variant->current_running_time_start;
+  variant->part_independent = TRUE;
+  variant->boundary_offset = 0;
+  variant->boundary_time = GST_CLOCK_TIME_NONE;
+
+  if (sink->part_duration > 0) {
+    gst_m3u8_playlist_set_preload_hint (variant->playlist,
+        variant->current_entry_location, 0);
+    gst_hls_sink2_write_playlists (sink, variant);
+  }
+}
+
+/* Call with the lock */
+static void
+gst_hls_sink2_fragment_closed (GstHlsSink2Variant * variant,
+    const GstStructure * s)
+{
+  GstHlsSink2 *sink = variant->sink;
+  GstClockTime running_time, duration;
+
+  g_assert (strcmp (variant->current_location, gst_structure_get_string (s,
+              "location")) == 0);
+
+  gst_structure_get_clock_time (s, "running-time", &running_time);
+
+  if (sink->part_duration > 0) {
+    gst_hls_sink2_cut_parts (variant, running_time, FALSE);
+    if (variant->fragment_offset > variant->part_offset)
+      gst_hls_sink2_add_part (variant, variant->fragment_offset, running_time);
+  }
+
+  duration = running_time - variant->current_running_time_start;
+  if (duration > 0)
+    variant->max_bitrate = MAX (variant->max_bitrate,
+        gst_util_uint64_scale (variant->fragment_offset, 8 * GST_SECOND,
+            duration));
+  variant->last_end_time = running_time;
+
+  GST_INFO_OBJECT (sink, "COUNT %d", variant->index);
+  gst_m3u8_playlist_add_entry (variant->playlist,
+      variant->current_entry_location, NULL, duration, variant->index++, FALSE);
+  variant->dirty = TRUE;
+
+  g_queue_push_tail (&variant->old_locations,
+      g_strdup (variant->current_location));
+
+  gst_hls_sink2_check_segment_boundary (sink);
 }
 
 static void
 gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
 {
   GstHlsSink2 *sink = GST_HLS_SINK2_CAST (bin);
+  GstHlsSink2Variant *variant;
 
   switch (message->type) {
     case GST_MESSAGE_ELEMENT:
     {
       const GstStructure *s = gst_message_get_structure (message);
-      if (message->src == GST_OBJECT_CAST (sink->splitmuxsink)) {
-        if (gst_structure_has_name (s, "splitmuxsink-fragment-opened")) {
-          g_free (sink->current_location);
-          sink->current_location =
-              g_strdup (gst_structure_get_string (s, "location"));
-          gst_structure_get_clock_time (s, "running-time",
-              &sink->current_running_time_start);
-        } else if (gst_structure_has_name (s, "splitmuxsink-fragment-closed")) {
-          GstClockTime running_time;
-          gchar *entry_location;
-
-          g_assert (strcmp (sink->current_location, gst_structure_get_string (s,
-                      "location")) == 0);
-
-          gst_structure_get_clock_time (s, "running-time", &running_time);
-
-          GST_INFO_OBJECT (sink, "COUNT %d", sink->index);
-          if (sink->playlist_root == NULL) {
-            entry_location = g_path_get_basename (sink->current_location);
-          } else {
-            gchar *name = g_path_get_basename (sink->current_location);
-            entry_location = g_build_filename (sink->playlist_root, name, NULL);
-            g_free (name);
-          }
-
-          gst_m3u8_playlist_add_entry (sink->playlist, entry_location,
-              NULL, running_time - sink->current_running_time_start,
-              sink->index++, FALSE);
-          g_free (entry_location);
-
-          gst_hls_sink2_write_playlist (sink);
-
-          g_queue_push_tail (&sink->old_locations,
-              g_strdup (sink->current_location));
-
-          while (g_queue_get_length (&sink->old_locations) >
-              g_queue_get_length (sink->playlist->entries)) {
-            gchar *old_location = g_queue_pop_head (&sink->old_locations);
-            g_remove (old_location);
-            g_free (old_location);
-          }
-        }
+
+      g_mutex_lock (&sink->lock);
+      variant = gst_hls_sink2_find_variant (sink, message->src);
+      if (variant) {
+        if (gst_structure_has_name (s, "splitmuxsink-fragment-opened"))
+          gst_hls_sink2_fragment_opened (variant, s);
+        else if (gst_structure_has_name (s, "splitmuxsink-fragment-closed"))
+          gst_hls_sink2_fragment_closed (variant, s);
       }
+      g_mutex_unlock (&sink->lock);
       break;
     }
     case GST_MESSAGE_EOS:{
-      sink->playlist->end_list = TRUE;
-      gst_hls_sink2_write_playlist (sink);
+      g_mutex_lock (&sink->lock);
+      variant = gst_hls_sink2_find_variant (sink, message->src);
+      if (variant) {
+        variant->eos = TRUE;
+        variant->playlist->end_list = TRUE;
+        variant->dirty = TRUE;
+        gst_hls_sink2_check_segment_boundary (sink);
+      }
+      g_mutex_unlock (&sink->lock);
       break;
     }
     default:
@@ -309,33 +1016,112 @@ gst_hls_sink2_request_new_pad (GstElement * element, GstPadTemplate * templ,
     const gchar * name, const GstCaps * caps)
 {
   GstHlsSink2 *sink = GST_HLS_SINK2_CAST (element);
+  GstHlsSink2Variant *variant;
   GstPad *pad, *peer;
-  gboolean is_audio;
+  gboolean is_audio, is_ladder;
+  gchar *pad_name, *location, *playlist_location;
 
   g_return_val_if_fail (strcmp (templ->name_template, "audio") == 0
-      || strcmp (templ->name_template, "video") == 0, NULL);
+      || strcmp (templ->name_template, "video") == 0
+      || strcmp (templ->name_template, "video_%u") == 0, NULL);
   g_return_val_if_fail (strcmp (templ->name_template, "audio") != 0
       || !sink->audio_sink, NULL);
   g_return_val_if_fail (strcmp (templ->name_template, "video") != 0
       || !sink->video_sink, NULL);
 
   is_audio = strcmp (templ->name_template, "audio") == 0;
+  is_ladder = strcmp (templ->name_template, "video_%u") == 0;
+
+  if (!is_ladder && (!is_audio || sink->main)) {
+    /* the single playlist of the video and audio pads */
+    if (!sink->main) {
+      GST_ERROR_OBJECT (sink, "can't mix the video and video_%%u pads");
+      return NULL;
+    }
+
+    peer =
+        gst_element_get_request_pad (sink->main->splitmuxsink,
+        is_audio ? "audio_0" : "video");
+    if (!peer)
+      return NULL;
+
+    pad = gst_ghost_pad_new_from_template (templ->name_template, peer, templ);
+    gst_pad_set_active (pad, TRUE);
+    gst_element_add_pad (element, pad);
+    gst_object_unref (peer);
+
+    if (is_audio)
+      sink->audio_sink = pad;
+    else
+      sink->video_sink = pad;
+
+    return pad;
+  }
+
+  if (sink->main) {
+    if (sink->audio_sink || sink->video_sink) {
+      GST_ERROR_OBJECT (sink, "can't mix the video and video_%%u pads, "
+          "request the video_%%u pads before the audio pad");
+      return NULL;
+    }
+
+    /* switch to ladder mode */
+    gst_hls_sink2_variant_remove (sink, sink->main);
+  }
+
+  if (is_audio) {
+    pad_name = g_strdup ("audio");
+  } else if (name) {
+    pad_name = g_strdup (name);
+  } else {
+    GstPad *existing;
+    guint i;
+
+    for (i = 0;; i++) {
+      pad_name = g_strdup_printf ("video_%u", i);
+      existing = gst_element_get_static_pad (element, pad_name);
+      if (!existing)
+        break;
+      gst_object_unref (existing);
+      g_free (pad_name);
+    }
+  }
+
+  location = g_strdup_printf ("%s_segment%%05d.ts", pad_name);
+  playlist_location = g_strdup_printf ("%s.m3u8", pad_name);
+  variant = gst_hls_sink2_variant_new (sink, location, playlist_location);
+  g_free (location);
+  g_free (playlist_location);
+  if (!variant) {
+    g_free (pad_name);
+    return NULL;
+  }
+  variant->is_audio = is_audio;
 
   peer =
-      gst_element_get_request_pad (sink->splitmuxsink,
+      gst_element_get_request_pad (variant->splitmuxsink,
       is_audio ? "audio_0" : "video");
-  if (!peer)
+  if (!peer) {
+    gst_hls_sink2_variant_remove (sink, variant);
+    g_free (pad_name);
     return NULL;
+  }
 
-  pad = gst_ghost_pad_new_from_template (templ->name_template, peer, templ);
-  gst_pad_set_active (pad, TRUE);
-  gst_element_add_pad (element, pad);
+  pad = g_object_new (GST_TYPE_HLS_SINK2_PAD, "name", pad_name, "direction",
+      GST_PAD_SINK, "template", templ, NULL);
+  GST_HLS_SINK2_PAD (pad)->variant = variant;
+  gst_ghost_pad_construct (GST_GHOST_PAD (pad));
+  gst_ghost_pad_set_target (GST_GHOST_PAD (pad), peer);
   gst_object_unref (peer);
+  g_free (pad_name);
 
+  variant->pad = pad;
   if (is_audio)
     sink->audio_sink = pad;
-  else
-    sink->video_sink = pad;
+
+  gst_element_sync_state_with_parent (variant->splitmuxsink);
+  gst_pad_set_active (pad, TRUE);
+  gst_element_add_pad (element, pad);
 
   return pad;
 }
@@ -344,14 +1130,21 @@ static void
 gst_hls_sink2_release_pad (GstElement * element, GstPad * pad)
 {
   GstHlsSink2 *sink = GST_HLS_SINK2_CAST (element);
-  GstPad *peer;
+  GstHlsSink2Variant *variant = NULL;
+  GstPad *target;
 
-  g_return_if_fail (pad == sink->audio_sink || pad == sink->video_sink);
+  g_return_if_fail (pad == sink->audio_sink || pad == sink->video_sink
+      || GST_IS_HLS_SINK2_PAD (pad));
 
-  peer = gst_pad_get_peer (pad);
-  if (peer) {
-    gst_element_release_request_pad (sink->splitmuxsink, pad);
-    gst_object_unref (peer);
+  if (GST_IS_HLS_SINK2_PAD (pad))
+    variant = GST_HLS_SINK2_PAD (pad)->variant;
+  else
+    variant = sink->main;
+
+  target = gst_ghost_pad_get_target (GST_GHOST_PAD (pad));
+  if (target) {
+    gst_element_release_request_pad (variant->splitmuxsink, target);
+    gst_object_unref (target);
   }
 
   gst_object_ref (pad);
@@ -359,9 +1152,12 @@ gst_hls_sink2_release_pad (GstElement * element, GstPad * pad)
   gst_pad_set_active (pad, FALSE);
   if (pad == sink->audio_sink)
     sink->audio_sink = NULL;
-  else
+  else if (pad == sink->video_sink)
     sink->video_sink = NULL;
 
+  if (variant != sink->main)
+    gst_hls_sink2_variant_remove (sink, variant);
+
   gst_object_unref (pad);
 }
 
@@ -370,13 +1166,25 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans)
 {
   GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
   GstHlsSink2 *sink = GST_HLS_SINK2_CAST (element);
+  GList *l;
 
   switch (trans) {
     case GST_STATE_CHANGE_NULL_TO_READY:
-      if (!sink->splitmuxsink) {
+      if (!sink->variants) {
         return GST_STATE_CHANGE_FAILURE;
       }
       break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      g_mutex_lock (&sink->lock);
+      for (l = sink->variants; l; l = l->next) {
+        GstHlsSink2Variant *variant = l->data;
+
+        variant->playlist->part_target = sink->part_duration;
+        if (sink->part_duration > 0)
+          variant->playlist->version = GST_M3U8_PLAYLIST_LL_VERSION;
+      }
+      g_mutex_unlock (&sink->lock);
+      break;
     default:
       break;
   }
@@ -402,35 +1210,65 @@ gst_hls_sink2_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
   GstHlsSink2 *sink = GST_HLS_SINK2_CAST (object);
+  GList *l;
 
   switch (prop_id) {
     case PROP_LOCATION:
       g_free (sink->location);
       sink->location = g_value_dup_string (value);
-      if (sink->splitmuxsink)
-        g_object_set (sink->splitmuxsink, "location", sink->location, NULL);
+      if (sink->main) {
+        g_free (sink->main->location);
+        sink->main->location = g_strdup (sink->location);
+        g_object_set (sink->main->splitmuxsink, "location", sink->location,
+            NULL);
+      }
       break;
     case PROP_PLAYLIST_LOCATION:
       g_free (sink->playlist_location);
       sink->playlist_location = g_value_dup_string (value);
+      if (sink->main) {
+        g_free (sink->main->playlist_location);
+        sink->main->playlist_location = g_strdup (sink->playlist_location);
+      }
       break;
     case PROP_PLAYLIST_ROOT:
       g_free (sink->playlist_root);
       sink->playlist_root = g_value_dup_string (value);
       break;
+    case PROP_MASTER_PLAYLIST_LOCATION:
+      g_free (sink->master_playlist_location);
+      sink->master_playlist_location = g_value_dup_string (value);
+      break;
     case PROP_MAX_FILES:
       sink->max_files = g_value_get_uint (value);
       break;
     case PROP_TARGET_DURATION:
       sink->target_duration = g_value_get_uint (value);
-      if (sink->splitmuxsink) {
-        g_object_set (sink->splitmuxsink, "max-size-time",
+      for (l = sink->variants; l; l = l->next) {
+        GstHlsSink2Variant *variant = l->data;
+
+        g_object_set (variant->splitmuxsink, "max-size-time",
             ((GstClockTime) sink->target_duration * GST_SECOND), NULL);
       }
       break;
     case PROP_PLAYLIST_LENGTH:
       sink->playlist_length = g_value_get_uint (value);
-      sink->playlist->window_size = sink->playlist_length;
+      for (l = sink->variants; l; l = l->next) {
+        GstHlsSink2Variant *variant = l->data;
+
+        variant->playlist->window_size = sink->playlist_length;
+      }
+      break;
+    case PROP_PART_DURATION:
+      sink->part_duration = g_value_get_uint64 (value);
+      /* parts are announced as soon as they are cut, so their data must
+       * not linger in the write buffer */
+      for (l = sink->variants; l; l = l->next) {
+        GstHlsSink2Variant *variant = l->data;
+
+        gst_util_set_object_arg (G_OBJECT (variant->filesink), "buffer-mode",
+            sink->part_duration > 0 ? "unbuffered" : "default");
+      }
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -454,6 +1292,9 @@ gst_hls_sink2_get_property (GObject * object, guint prop_id,
     case PROP_PLAYLIST_ROOT:
       g_value_set_string (value, sink->playlist_root);
       break;
+    case PROP_MASTER_PLAYLIST_LOCATION:
+      g_value_set_string (value, sink->master_playlist_location);
+      break;
     case PROP_MAX_FILES:
       g_value_set_uint (value, sink->max_files);
       break;
@@ -463,6 +1304,9 @@ gst_hls_sink2_get_property (GObject * object, guint prop_id,
     case PROP_PLAYLIST_LENGTH:
       g_value_set_uint (value, sink->playlist_length);
       break;
+    case PROP_PART_DURATION:
+      g_value_set_uint64 (value, sink->part_duration);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -33,35 +33,110 @@ G_BEGIN_DECLS
 
 typedef struct _GstHlsSink2 GstHlsSink2;
 typedef struct _GstHlsSink2Class GstHlsSink2Class;
+typedef struct _GstHlsSink2Variant GstHlsSink2Variant;
+
+#define GST_TYPE_HLS_SINK2_PAD   (gst_hls_sink2_pad_get_type())
+#define GST_HLS_SINK2_PAD(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_HLS_SINK2_PAD,GstHlsSink2Pad))
+#define GST_IS_HLS_SINK2_PAD(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_HLS_SINK2_PAD))
+
+typedef struct _GstHlsSink2Pad GstHlsSink2Pad;
+typedef struct _GstHlsSink2PadClass GstHlsSink2PadClass;
+
+/* One media playlist with its segments, written by its own splitmuxsink */
+struct _GstHlsSink2Variant
+{
+  GstHlsSink2 *sink;
+
+  GstElement *splitmuxsink;
+  GstElement *filesink;
+  /* the request pad of a rendition of a ladder, NULL for the single
+   * playlist of the video and audio pads */
+  GstPad *pad;
+  gboolean is_audio;
+
+  gchar *location;
+  gchar *playlist_location;
+
+  GstM3U8Playlist *playlist;
+  guint index;
+  gboolean eos;
+  /* the playlist changed since it was last written */
+  gboolean dirty;
+
+  gchar *current_location;
+  gchar *current_entry_location;
+  GstClockTime current_running_time_start;
+  GstClockTime last_end_time;
+  GQueue old_locations;
+
+  /* peak bitrate of the segments, for the master playlist */
+  guint64 max_bitrate;
+
+  /* partial segments of the current fragment, in bytes written to it */
+  GstSegment part_segment;
+  guint64 fragment_offset;
+  guint64 part_offset;
+  GstClockTime part_start;
+  gboolean part_independent;
+
+  /* start of the latest buffer that can end the current part */
+  guint64 boundary_offset;
+  GstClockTime boundary_time;
+  gboolean boundary_independent;
+};
+
+struct _GstHlsSink2Pad
+{
+  GstGhostPad ghost_pad;
+
+  GstHlsSink2Variant *variant;
+};
+
+struct _GstHlsSink2PadClass
+{
+  GstGhostPadClass ghost_pad_class;
+};
 
 struct _GstHlsSink2
 {
   GstBin bin;
 
-  GstElement *splitmuxsink;
   GstPad *audio_sink, *video_sink;
 
   gchar *location;
   gchar *playlist_location;
   gchar *playlist_root;
+  gchar *master_playlist_location;
   guint playlist_length;
   gint max_files;
   gint target_duration;
+  GstClockTime part_duration;
 
-  GstM3U8Playlist *playlist;
-  guint index;
+  /* protects the variants and their playlists */
+  GMutex lock;
+  GCond playlist_cond;
+  guint generation;
 
-  gchar *current_location;
-  GstClockTime current_running_time_start;
-  GQueue old_locations;
+  /* all variants in the order they were requested. main is the one of the
+   * video and audio pads, it is replaced by the variants of the video_%u
+   * pads in ladder mode. */
+  GList *variants;
+  GstHlsSink2Variant *main;
+  /* number of segments all variants have finished and that were written */
+  guint segments_written;
 };
 
 struct _GstHlsSink2Class
 {
   GstBinClass bin_class;
+
+  /* actions */
+  gchar * (*get_playlist) (GstHlsSink2 * sink, guint variant, guint msn,
+      gint part, gboolean skip, GstClockTime timeout);
 };
 
 GType gst_hls_sink2_get_type (void);
+GType gst_hls_sink2_pad_get_type (void);
 gboolean gst_hls_sink2_plugin_init (GstPlugin * plugin);
 
 G_END_DECLS
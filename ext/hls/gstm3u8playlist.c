@@ -20,6 +20,7 @@
  */
 
 #include <glib.h>
+#include <string.h>
 
 #include "gsthls.h"
 #include "gstm3u8playlist.h"
@@ -40,6 +41,10 @@ struct _GstM3U8Entry
   gchar *title;
   gchar *url;
   gboolean discontinuous;
+
+  /* rendered segment and, while still listed, its partial segments */
+  gchar *text;
+  gchar *parts_text;
 };
 
 static GstM3U8Entry *
@@ -65,9 +70,36 @@ gst_m3u8_entry_free (GstM3U8Entry * entry)
 
   g_free (entry->url);
   g_free (entry->title);
+  g_free (entry->text);
+  g_free (entry->parts_text);
   g_free (entry);
 }
 
+static gchar *
+gst_m3u8_entry_render (GstM3U8Entry * entry, guint version)
+{
+  GString *str = g_string_new (NULL);
+
+  if (entry->discontinuous)
+    g_string_append (str, "#EXT-X-DISCONTINUITY\n");
+
+  if (version < 3) {
+    g_string_append_printf (str, "#EXTINF:%d,%s\n",
+        (gint) ((entry->duration + 500 * GST_MSECOND) / GST_SECOND),
+        entry->title ? entry->title : "");
+  } else {
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    g_string_append_printf (str, "#EXTINF:%s,%s\n",
+        g_ascii_dtostr (buf, sizeof (buf), entry->duration / GST_SECOND),
+        entry->title ? entry->title : "");
+  }
+
+  g_string_append_printf (str, "%s\n", entry->url);
+
+  return g_string_free (str, FALSE);
+}
+
 GstM3U8Playlist *
 gst_m3u8_playlist_new (guint version, guint window_size, gboolean allow_cache)
 {
@@ -80,6 +112,9 @@ gst_m3u8_playlist_new (guint version, guint window_size, gboolean allow_cache)
   playlist->type = GST_M3U8_PLAYLIST_TYPE_EVENT;
   playlist->end_list = FALSE;
   playlist->entries = g_queue_new ();
+  playlist->segments = g_string_new (NULL);
+  playlist->recent = g_string_new (NULL);
+  playlist->parts = g_string_new (NULL);
 
   return playlist;
 }
@@ -91,9 +126,76 @@ gst_m3u8_playlist_free (GstM3U8Playlist * playlist)
 
   g_queue_foreach (playlist->entries, (GFunc) gst_m3u8_entry_free, NULL);
   g_queue_free (playlist->entries);
+  g_string_free (playlist->segments, TRUE);
+  g_string_free (playlist->recent, TRUE);
+  g_string_free (playlist->parts, TRUE);
+  g_free (playlist->preload_hint);
   g_free (playlist);
 }
 
+static guint
+gst_m3u8_playlist_target_duration (GstM3U8Playlist * playlist)
+{
+  guint64 target_duration = 0;
+  GList *l;
+
+  for (l = playlist->entries->head; l != NULL; l = l->next) {
+    GstM3U8Entry *entry = l->data;
+
+    if (entry->duration > target_duration)
+      target_duration = entry->duration;
+  }
+
+  return (guint) ((target_duration + 500 * GST_MSECOND) / GST_SECOND);
+}
+
+static void
+gst_m3u8_playlist_remove_head (GstM3U8Playlist * playlist)
+{
+  GstM3U8Entry *entry = g_queue_pop_head (playlist->entries);
+
+  if (playlist->n_without_parts > 0) {
+    g_string_erase (playlist->segments, 0, strlen (entry->text));
+    playlist->n_without_parts--;
+  } else {
+    g_string_erase (playlist->recent, 0, strlen (entry->text) +
+        (entry->parts_text ? strlen (entry->parts_text) : 0));
+  }
+
+  gst_m3u8_entry_free (entry);
+}
+
+/* Partial segments are only listed for the segments of the last three
+ * target durations, older entries move from @recent to @segments */
+static void
+gst_m3u8_playlist_drop_old_parts (GstM3U8Playlist * playlist)
+{
+  gfloat limit = 3.0 * gst_m3u8_playlist_target_duration (playlist) *
+      GST_SECOND;
+  gfloat after = 0;
+  GList *l, *first;
+
+  first = g_queue_peek_nth_link (playlist->entries, playlist->n_without_parts);
+  for (l = first; l != NULL; l = l->next) {
+    GstM3U8Entry *entry = l->data;
+    after += entry->duration;
+  }
+
+  for (l = first; l != NULL; l = l->next) {
+    GstM3U8Entry *entry = l->data;
+
+    after -= entry->duration;
+    if (entry->parts_text && after <= limit)
+      break;
+
+    g_string_erase (playlist->recent, 0, strlen (entry->text) +
+        (entry->parts_text ? strlen (entry->parts_text) : 0));
+    g_string_append (playlist->segments, entry->text);
+    g_free (entry->parts_text);
+    entry->parts_text = NULL;
+    playlist->n_without_parts++;
+  }
+}
 
 gboolean
 gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
@@ -109,51 +211,133 @@ gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
     return FALSE;
 
   entry = gst_m3u8_entry_new (url, title, duration, discontinuous);
+  entry->text = gst_m3u8_entry_render (entry, playlist->version);
+
+  /* the partial segments written so far belong to this entry */
+  if (playlist->n_parts > 0) {
+    entry->parts_text = g_strndup (playlist->parts->str, playlist->parts->len);
+    g_string_truncate (playlist->parts, 0);
+    playlist->n_parts = 0;
+  }
+  g_free (playlist->preload_hint);
+  playlist->preload_hint = NULL;
 
   if (playlist->window_size > 0) {
     /* Delete old entries from the playlist */
-    while (playlist->entries->length >= playlist->window_size) {
-      GstM3U8Entry *old_entry;
-
-      old_entry = g_queue_pop_head (playlist->entries);
-      gst_m3u8_entry_free (old_entry);
-    }
+    while (playlist->entries->length >= playlist->window_size)
+      gst_m3u8_playlist_remove_head (playlist);
   }
 
   playlist->sequence_number = index + 1;
   g_queue_push_tail (playlist->entries, entry);
+  if (entry->parts_text)
+    g_string_append (playlist->recent, entry->parts_text);
+  g_string_append (playlist->recent, entry->text);
+
+  gst_m3u8_playlist_drop_old_parts (playlist);
 
   return TRUE;
 }
 
-static guint
-gst_m3u8_playlist_target_duration (GstM3U8Playlist * playlist)
+/**
+ * gst_m3u8_playlist_add_part:
+ * @url: the resource of the partial segment, usually the file of the
+ *    segment being written
+ * @offset: byte offset of the partial segment in @url
+ * @length: length in bytes, or 0 if the partial segment is all of @url
+ * @independent: whether the partial segment starts with a key frame
+ *
+ * Appends a partial segment to the segment being written, the next
+ * gst_m3u8_playlist_add_entry() completes that segment.
+ */
+gboolean
+gst_m3u8_playlist_add_part (GstM3U8Playlist * playlist, const gchar * url,
+    gfloat duration, guint64 offset, guint64 length, gboolean independent)
 {
-  guint64 target_duration = 0;
-  GList *l;
+  gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
 
-  for (l = playlist->entries->head; l != NULL; l = l->next) {
-    GstM3U8Entry *entry = l->data;
+  g_return_val_if_fail (playlist != NULL, FALSE);
+  g_return_val_if_fail (url != NULL, FALSE);
 
-    if (entry->duration > target_duration)
-      target_duration = entry->duration;
-  }
+  if (playlist->type == GST_M3U8_PLAYLIST_TYPE_VOD)
+    return FALSE;
 
-  return (guint) ((target_duration + 500 * GST_MSECOND) / GST_SECOND);
+  g_string_append_printf (playlist->parts, "#EXT-X-PART:DURATION=%s,URI=\"%s\"",
+      g_ascii_formatd (buf, sizeof (buf), "%.3f", duration / GST_SECOND), url);
+  if (length > 0)
+    g_string_append_printf (playlist->parts,
+        ",BYTERANGE=\"%" G_GUINT64_FORMAT "@%" G_GUINT64_FORMAT "\"", length,
+        offset);
+  if (independent)
+    g_string_append (playlist->parts, ",INDEPENDENT=YES");
+  g_string_append_c (playlist->parts, '\n');
+  playlist->n_parts++;
+
+  return TRUE;
 }
 
-gchar *
-gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
+/**
+ * gst_m3u8_playlist_set_preload_hint:
+ * @url: (allow-none): the resource of the next partial segment, or %NULL
+ * @offset: byte offset at which the next partial segment starts in @url
+ *
+ * Announces the next partial segment so that clients can request it before
+ * it is complete.
+ */
+void
+gst_m3u8_playlist_set_preload_hint (GstM3U8Playlist * playlist,
+    const gchar * url, guint64 offset)
+{
+  g_return_if_fail (playlist != NULL);
+
+  g_free (playlist->preload_hint);
+  playlist->preload_hint = NULL;
+
+  if (url == NULL)
+    return;
+
+  if (offset > 0)
+    playlist->preload_hint =
+        g_strdup_printf ("#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"%s\","
+        "BYTERANGE-START=%" G_GUINT64_FORMAT "\n", url, offset);
+  else
+    playlist->preload_hint =
+        g_strdup_printf ("#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"%s\"\n", url);
+}
+
+/**
+ * gst_m3u8_playlist_has_part:
+ * @msn: media sequence number of a segment
+ * @part: index of a partial segment of @msn, or -1 for the whole segment
+ *
+ * Checks whether a request for the given segment or partial segment, as in
+ * the _HLS_msn and _HLS_part query parameters of a blocking playlist
+ * reload, can be answered with the current playlist.
+ */
+gboolean
+gst_m3u8_playlist_has_part (GstM3U8Playlist * playlist, guint msn, gint part)
+{
+  g_return_val_if_fail (playlist != NULL, FALSE);
+
+  /* sequence_number is the one of the segment being written */
+  if (msn < playlist->sequence_number)
+    return TRUE;
+
+  return msn == playlist->sequence_number && part >= 0
+      && part < playlist->n_parts;
+}
+
+static GString *
+gst_m3u8_playlist_render_header (GstM3U8Playlist * playlist, guint version)
 {
   GString *playlist_str;
-  GList *l;
+  guint target_duration;
 
-  g_return_val_if_fail (playlist != NULL, NULL);
+  target_duration = gst_m3u8_playlist_target_duration (playlist);
 
   playlist_str = g_string_new ("#EXTM3U\n");
 
-  g_string_append_printf (playlist_str, "#EXT-X-VERSION:%d\n",
-      playlist->version);
+  g_string_append_printf (playlist_str, "#EXT-X-VERSION:%d\n", version);
 
   g_string_append_printf (playlist_str, "#EXT-X-ALLOW-CACHE:%s\n",
       playlist->allow_cache ? "YES" : "NO");
@@ -162,32 +346,108 @@ gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
       playlist->sequence_number - playlist->entries->length);
 
   g_string_append_printf (playlist_str, "#EXT-X-TARGETDURATION:%u\n",
-      gst_m3u8_playlist_target_duration (playlist));
+      target_duration);
+
+  if (playlist->part_target > 0) {
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    g_string_append (playlist_str,
+        "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES");
+    if (target_duration > 0)
+      g_string_append_printf (playlist_str, ",CAN-SKIP-UNTIL=%u",
+          6 * target_duration);
+    g_string_append_printf (playlist_str, ",PART-HOLD-BACK=%s\n",
+        g_ascii_formatd (buf, sizeof (buf), "%.3f",
+            3 * playlist->part_target / GST_SECOND));
+    g_string_append_printf (playlist_str, "#EXT-X-PART-INF:PART-TARGET=%s\n",
+        g_ascii_formatd (buf, sizeof (buf), "%.3f",
+            playlist->part_target / GST_SECOND));
+  }
   g_string_append (playlist_str, "\n");
 
-  /* Entries */
+  return playlist_str;
+}
+
+static void
+gst_m3u8_playlist_render_tail (GstM3U8Playlist * playlist,
+    GString * playlist_str)
+{
+  g_string_append_len (playlist_str, playlist->recent->str,
+      playlist->recent->len);
+  g_string_append_len (playlist_str, playlist->parts->str,
+      playlist->parts->len);
+
+  if (playlist->end_list)
+    g_string_append (playlist_str, "#EXT-X-ENDLIST");
+  else if (playlist->preload_hint)
+    g_string_append (playlist_str, playlist->preload_hint);
+}
+
+gchar *
+gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
+{
+  GString *playlist_str;
+
+  g_return_val_if_fail (playlist != NULL, NULL);
+
+  playlist_str = gst_m3u8_playlist_render_header (playlist, playlist->version);
+  g_string_append_len (playlist_str, playlist->segments->str,
+      playlist->segments->len);
+  gst_m3u8_playlist_render_tail (playlist, playlist_str);
+
+  return g_string_free (playlist_str, FALSE);
+}
+
+/**
+ * gst_m3u8_playlist_render_delta:
+ *
+ * Renders the playlist as a delta update, for requests with the _HLS_skip
+ * query parameter: the segments that start more than the CAN-SKIP-UNTIL
+ * duration before the end of the playlist are replaced by an EXT-X-SKIP tag.
+ * Without partial segments this is the same as gst_m3u8_playlist_render().
+ */
+gchar *
+gst_m3u8_playlist_render_delta (GstM3U8Playlist * playlist)
+{
+  GString *playlist_str;
+  gfloat skip_until, remaining = 0;
+  guint skipped = 0;
+  gsize offset = 0;
+  GList *l;
+
+  g_return_val_if_fail (playlist != NULL, NULL);
+
+  if (playlist->part_target <= 0)
+    return gst_m3u8_playlist_render (playlist);
+
+  skip_until = 6.0 * gst_m3u8_playlist_target_duration (playlist) * GST_SECOND;
+
   for (l = playlist->entries->head; l != NULL; l = l->next) {
-    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
     GstM3U8Entry *entry = l->data;
+    remaining += entry->duration;
+  }
 
-    if (entry->discontinuous)
-      g_string_append (playlist_str, "#EXT-X-DISCONTINUITY\n");
+  /* only entries without partial segments are old enough to be skipped */
+  for (l = playlist->entries->head; skipped < playlist->n_without_parts;
+      l = l->next) {
+    GstM3U8Entry *entry = l->data;
 
-    if (playlist->version < 3) {
-      g_string_append_printf (playlist_str, "#EXTINF:%d,%s\n",
-          (gint) ((entry->duration + 500 * GST_MSECOND) / GST_SECOND),
-          entry->title ? entry->title : "");
-    } else {
-      g_string_append_printf (playlist_str, "#EXTINF:%s,%s\n",
-          g_ascii_dtostr (buf, sizeof (buf), entry->duration / GST_SECOND),
-          entry->title ? entry->title : "");
-    }
+    if (remaining <= skip_until)
+      break;
 
-    g_string_append_printf (playlist_str, "%s\n", entry->url);
+    remaining -= entry->duration;
+    offset += strlen (entry->text);
+    skipped++;
   }
 
-  if (playlist->end_list)
-    g_string_append (playlist_str, "#EXT-X-ENDLIST");
+  playlist_str =
+      gst_m3u8_playlist_render_header (playlist, MAX (playlist->version, 9));
+  if (skipped > 0)
+    g_string_append_printf (playlist_str,
+        "#EXT-X-SKIP:SKIPPED-SEGMENTS=%u\n", skipped);
+  g_string_append_len (playlist_str, playlist->segments->str + offset,
+      playlist->segments->len - offset);
+  gst_m3u8_playlist_render_tail (playlist, playlist_str);
 
   return g_string_free (playlist_str, FALSE);
 }
@@ -36,9 +36,24 @@ struct _GstM3U8Playlist
   gint type;
   gboolean end_list;
   guint sequence_number;
+  /* Low-latency HLS: target duration of the partial segments in
+   * nanoseconds, 0 to write whole segments only */
+  gfloat part_target;
 
   /*< Private >*/
   GQueue *entries;
+
+  /* The entries are kept rendered, the playlist is only reassembled from
+   * these strings. @segments holds the first @n_without_parts entries,
+   * whose partial segments are no longer listed, @recent the others. */
+  guint n_without_parts;
+  GString *segments;
+  GString *recent;
+
+  /* partial segments of the segment being written */
+  GString *parts;
+  guint n_parts;
+  gchar *preload_hint;
 };
 
 
@@ -55,8 +70,25 @@ gboolean          gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
                                                guint             index,
                                                gboolean          discontinuous);
 
+gboolean          gst_m3u8_playlist_add_part (GstM3U8Playlist * playlist,
+                                              const gchar     * url,
+                                              gfloat            duration,
+                                              guint64           offset,
+                                              guint64           length,
+                                              gboolean          independent);
+
+void              gst_m3u8_playlist_set_preload_hint (GstM3U8Playlist * playlist,
+                                                      const gchar     * url,
+                                                      guint64           offset);
+
+gboolean          gst_m3u8_playlist_has_part (GstM3U8Playlist * playlist,
+                                              guint             msn,
+                                              gint              part);
+
 gchar *           gst_m3u8_playlist_render (GstM3U8Playlist * playlist);
 
+gchar *           gst_m3u8_playlist_render_delta (GstM3U8Playlist * playlist);
+
 G_END_DECLS
 
 #endif /* __M3U8_H__ */
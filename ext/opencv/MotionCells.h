@@ -126,7 +126,7 @@ public:
   MotionCells ();
   virtual ~ MotionCells ();
 
-  int performDetectionMotionCells (IplImage * p_frame, double p_sensitivity,
+  int performDetectionMotionCells (cv::Mat & p_frame, double p_sensitivity,
       double p_framerate, int p_gridx, int p_gridy, gint64 timestamp_millisec,
       bool p_isVisble, bool p_useAlpha, int motionmaskcoord_count,
       motionmaskcoordrect * motionmaskcoords, int motionmaskcells_count,
@@ -134,9 +134,9 @@ public:
       int motioncells_count, motioncellidx * motioncellsidx, gint64 starttime,
       char *datafile, bool p_changed_datafile, int p_thickness);
 
-  void setPrevFrame (IplImage * p_prevframe)
+  void setPrevFrame (cv::Mat & p_prevframe)
   {
-    m_pprevFrame = cvCloneImage (p_prevframe);
+    downscaleToGrey (p_prevframe, m_prevGreyImage);
   }
   char *getMotionCellsIdx ()
   {
@@ -194,30 +194,9 @@ private:
       p_motionmaskcellsidx, int p_motionmaskcells_count = 0);
   int saveMotionCells (gint64 timestamp_millisec);
   int initDataFile (char *p_datafile, gint64 starttime);
-  void blendImages (IplImage * p_actFrame, IplImage * p_cellsFrame,
+  void blendImages (cv::Mat & p_actFrame, cv::Mat & p_cellsFrame,
       float p_alpha, float p_beta);
-
-  void setData (IplImage * img, int lin, int col, uchar valor)
-  {
-    ((uchar *) (img->imageData + img->widthStep * lin))[col] = valor;
-  }
-
-  uchar getData (IplImage * img, int lin, int col)
-  {
-    return ((uchar *) (img->imageData + img->widthStep * lin))[col];
-  }
-
-  bool getIsNonZero (IplImage * img)
-  {
-    int lin, col;
-
-    for (lin = 0; lin < img->height; lin++)
-      for (col = 0; col < img->width; col++) {
-        if ((((uchar *) (img->imageData + img->widthStep * lin))[col]) > 0)
-          return true;
-      }
-    return false;
-  }
+  void downscaleToGrey (cv::Mat & p_frame, cv::Mat & p_grey);
 
   void setMotionCells (int p_frameWidth, int p_frameHeight)
   {
@@ -239,8 +218,10 @@ private:
       }
   }
 
-  IplImage *m_pcurFrame, *m_pprevFrame, *m_pdifferenceImage,
-      *m_pbwImage,*transparencyimg;
+  //the detection runs on half size grey images, these are reused between
+  //frames so only a change of the frame size reallocates them
+  cv::Mat m_prevGreyImage, m_curGreyImage, m_curDownImage,
+      m_differenceImage, m_bwImage, transparencyimg;
   bool m_isVisible, m_changed_datafile, m_useAlpha, m_saveInDatafile;
   Cell **m_pCells;
   vector < MotionCellsIdx > m_MotionCells;
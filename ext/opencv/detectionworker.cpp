@@ -0,0 +1,300 @@
+/* GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "detectionworker.hpp"
+
+#include <gst/video/video.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_detection_worker_debug);
+#define GST_CAT_DEFAULT gst_detection_worker_debug
+
+struct _GstDetectionWorker
+{
+  GstElement *element;
+  GstDetectionWorkerFunc func;
+
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+  gboolean running;
+  /* the worker thread is analysing a frame */
+  gboolean busy;
+  /* bumped on reset, analyses started before are thrown away */
+  guint epoch;
+
+  /* newest frame waiting for the worker, replaced by newer ones */
+  cv::Mat pending;
+  GstBuffer *pending_info;
+  /* frame under analysis, only used by the worker thread */
+  cv::Mat current;
+
+  /* outcome of the newest finished analysis */
+  GstBuffer *result;
+
+  guint64 processed;
+  guint64 dropped;
+};
+
+static gpointer
+gst_detection_worker_loop (gpointer data)
+{
+  GstDetectionWorker *worker = (GstDetectionWorker *) data;
+
+  g_mutex_lock (&worker->lock);
+  while (worker->running) {
+    GstBuffer *info, *old;
+    guint epoch;
+
+    if (!worker->pending_info) {
+      g_cond_wait (&worker->cond, &worker->lock);
+      continue;
+    }
+
+    info = worker->pending_info;
+    worker->pending_info = NULL;
+    cv::swap (worker->pending, worker->current);
+    epoch = worker->epoch;
+    worker->busy = TRUE;
+    g_mutex_unlock (&worker->lock);
+
+    worker->func (worker->element, info, worker->current);
+
+    g_mutex_lock (&worker->lock);
+    worker->busy = FALSE;
+    worker->processed++;
+    if (epoch == worker->epoch) {
+      old = worker->result;
+      worker->result = info;
+    } else {
+      old = info;
+    }
+    g_cond_broadcast (&worker->cond);
+    g_mutex_unlock (&worker->lock);
+
+    if (old)
+      gst_buffer_unref (old);
+
+    g_mutex_lock (&worker->lock);
+  }
+  g_mutex_unlock (&worker->lock);
+
+  return NULL;
+}
+
+/**
+ * gst_detection_worker_new:
+ * @element: the element doing the analysis, not reffed
+ * @func: the analysis
+ *
+ * Starts a thread that runs @func on the frames passed to
+ * gst_detection_worker_push().
+ *
+ * Returns: the new worker or %NULL if the thread could not be created
+ */
+GstDetectionWorker *
+gst_detection_worker_new (GstElement * element, GstDetectionWorkerFunc func)
+{
+  static gsize debug_init = 0;
+  GstDetectionWorker *worker;
+  GError *err = NULL;
+  gchar *name;
+
+  if (g_once_init_enter (&debug_init)) {
+    GST_DEBUG_CATEGORY_INIT (gst_detection_worker_debug, "detectionworker", 0,
+        "OpenCV detection worker thread");
+    g_once_init_leave (&debug_init, 1);
+  }
+
+  worker = new GstDetectionWorker ();
+  worker->element = element;
+  worker->func = func;
+  worker->running = TRUE;
+  worker->busy = FALSE;
+  worker->epoch = 0;
+  worker->pending_info = NULL;
+  worker->result = NULL;
+  worker->processed = 0;
+  worker->dropped = 0;
+  g_mutex_init (&worker->lock);
+  g_cond_init (&worker->cond);
+
+  name = g_strdup_printf ("%s:detect", GST_ELEMENT_NAME (element));
+  worker->thread = g_thread_try_new (name, gst_detection_worker_loop, worker,
+      &err);
+  g_free (name);
+
+  if (!worker->thread) {
+    GST_ERROR_OBJECT (element, "Failed to start detection thread: %s",
+        err->message);
+    g_error_free (err);
+    g_mutex_clear (&worker->lock);
+    g_cond_clear (&worker->cond);
+    delete worker;
+    return NULL;
+  }
+
+  return worker;
+}
+
+/**
+ * gst_detection_worker_free:
+ * @worker: a #GstDetectionWorker
+ *
+ * Waits for a running analysis to finish, stops the thread and frees
+ * @worker.
+ */
+void
+gst_detection_worker_free (GstDetectionWorker * worker)
+{
+  g_mutex_lock (&worker->lock);
+  worker->running = FALSE;
+  g_cond_broadcast (&worker->cond);
+  g_mutex_unlock (&worker->lock);
+
+  g_thread_join (worker->thread);
+
+  GST_DEBUG_OBJECT (worker->element, "analysed %" G_GUINT64_FORMAT
+      " frames, dropped %" G_GUINT64_FORMAT, worker->processed,
+      worker->dropped);
+
+  if (worker->pending_info)
+    gst_buffer_unref (worker->pending_info);
+  if (worker->result)
+    gst_buffer_unref (worker->result);
+  g_mutex_clear (&worker->lock);
+  g_cond_clear (&worker->cond);
+  delete worker;
+}
+
+/**
+ * gst_detection_worker_push:
+ * @worker: a #GstDetectionWorker
+ * @buf: the buffer of @frame
+ * @frame: the frame to analyse
+ *
+ * Copies @frame for analysis, a frame that is still waiting for the worker
+ * is dropped. @buf is not kept, only its timestamps are.
+ */
+void
+gst_detection_worker_push (GstDetectionWorker * worker, GstBuffer * buf,
+    cv::Mat & frame)
+{
+  GstBuffer *info;
+
+  info = gst_buffer_new ();
+  gst_buffer_copy_into (info, buf, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+
+  g_mutex_lock (&worker->lock);
+  if (worker->pending_info) {
+    GST_LOG_OBJECT (worker->element, "dropping stale frame %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (GST_BUFFER_PTS (worker->pending_info)));
+    gst_buffer_unref (worker->pending_info);
+    worker->dropped++;
+  }
+  /* reuses the memory of the previous frame if the size didn't change */
+  frame.copyTo (worker->pending);
+  worker->pending_info = info;
+  g_cond_broadcast (&worker->cond);
+  g_mutex_unlock (&worker->lock);
+}
+
+/**
+ * gst_detection_worker_attach:
+ * @worker: a #GstDetectionWorker
+ * @buf: a writable buffer
+ * @max_latency: maximum age of the analysed frame relative to @buf
+ *
+ * Adds the regions found in the newest analysed frame to @buf, if that frame
+ * is not older than @max_latency and not newer than @buf.
+ *
+ * Returns: the number of regions added
+ */
+guint
+gst_detection_worker_attach (GstDetectionWorker * worker, GstBuffer * buf,
+    GstClockTime max_latency)
+{
+  GstVideoRegionOfInterestMeta *meta;
+  GstBuffer *result = NULL;
+  GstClockTime pts, result_pts;
+  gpointer state = NULL;
+  guint n = 0;
+
+  g_mutex_lock (&worker->lock);
+  if (worker->result)
+    result = gst_buffer_ref (worker->result);
+  g_mutex_unlock (&worker->lock);
+
+  if (!result)
+    return 0;
+
+  pts = GST_BUFFER_PTS (buf);
+  result_pts = GST_BUFFER_PTS (result);
+  if (GST_CLOCK_TIME_IS_VALID (pts) && GST_CLOCK_TIME_IS_VALID (result_pts)
+      && (pts < result_pts || pts - result_pts > max_latency)) {
+    GST_LOG_OBJECT (worker->element, "result of %" GST_TIME_FORMAT
+        " too old for %" GST_TIME_FORMAT, GST_TIME_ARGS (result_pts),
+        GST_TIME_ARGS (pts));
+    gst_buffer_unref (result);
+    return 0;
+  }
+
+  while ((meta = (GstVideoRegionOfInterestMeta *)
+          gst_buffer_iterate_meta_filtered (result, &state,
+              GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE))) {
+    gst_buffer_add_video_region_of_interest_meta_id (buf, meta->roi_type,
+        meta->x, meta->y, meta->w, meta->h);
+    n++;
+  }
+  gst_buffer_unref (result);
+
+  return n;
+}
+
+/**
+ * gst_detection_worker_reset:
+ * @worker: a #GstDetectionWorker
+ *
+ * Drops the waiting frame and the last result and waits for a running
+ * analysis to finish. Its outcome is discarded. Afterwards the caller can
+ * safely change the state the analysis function uses.
+ */
+void
+gst_detection_worker_reset (GstDetectionWorker * worker)
+{
+  GstBuffer *pending, *result;
+
+  g_mutex_lock (&worker->lock);
+  pending = worker->pending_info;
+  result = worker->result;
+  worker->pending_info = NULL;
+  worker->result = NULL;
+  worker->epoch++;
+  while (worker->busy)
+    g_cond_wait (&worker->cond, &worker->lock);
+  g_mutex_unlock (&worker->lock);
+
+  if (pending)
+    gst_buffer_unref (pending);
+  if (result)
+    gst_buffer_unref (result);
+}
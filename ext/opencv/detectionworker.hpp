@@ -0,0 +1,57 @@
+/* GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_DETECTION_WORKER_H__
+#define __GST_DETECTION_WORKER_H__
+
+#include <gst/gst.h>
+#include <opencv2/core.hpp>
+
+G_BEGIN_DECLS
+
+#define GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY (500 * GST_MSECOND)
+
+typedef struct _GstDetectionWorker GstDetectionWorker;
+
+/* Called from the worker thread with a private copy of a frame. @info only
+ * carries the timestamps of the frame, the analysis adds the regions it
+ * found to it as GstVideoRegionOfInterestMeta. */
+typedef void (*GstDetectionWorkerFunc) (GstElement * element,
+    GstBuffer * info, cv::Mat & frame);
+
+/* analysis of frames in a separate thread, only the newest frame is kept
+ * when the analysis can't keep up and the outcome is attached to the frames
+ * that pass through in the meantime */
+
+GstDetectionWorker *gst_detection_worker_new (GstElement * element,
+    GstDetectionWorkerFunc func);
+
+void gst_detection_worker_free (GstDetectionWorker * worker);
+
+void gst_detection_worker_push (GstDetectionWorker * worker, GstBuffer * buf,
+    cv::Mat & frame);
+
+guint gst_detection_worker_attach (GstDetectionWorker * worker,
+    GstBuffer * buf, GstClockTime max_latency);
+
+void gst_detection_worker_reset (GstDetectionWorker * worker);
+
+G_END_DECLS
+
+#endif /* __GST_DETECTION_WORKER_H__ */
@@ -63,6 +63,15 @@
  * |[
  * gst-launch-1.0 autovideosrc ! video/x-raw,width=320,height=240 ! videoconvert ! facedetect min-size-width=60 min-size-height=60 ! colorspace ! xvimagesink
  * ]| Detect large faces on a smaller image
+ * |[
+ * gst-launch-1.0 autovideosrc ! videoconvert ! facedetect detection-scale=0.5 detection-interval=3 ! videoconvert ! xvimagesink
+ * ]| Search for faces on a half size image every third frame, the faces in
+ * the frames in between are extrapolated from the last two detections
+ * |[
+ * gst-launch-1.0 v4l2src ! videoconvert ! facedetect async=true ! videoconvert ! x264enc ! mp4mux ! filesink location=out.mp4
+ * ]| Search for faces in a separate thread, the video is not held up when the
+ * detection can't keep up. The faces are attached to the frames as
+ * GstVideoRegionOfInterestMeta only.
  *
  * </refsect2>
  */
@@ -81,6 +90,7 @@
 using namespace std;
 
 #include "gstfacedetect.h"
+#include "detectionworker.hpp"
 #include <opencv2/imgproc.hpp>
 
 GST_DEBUG_CATEGORY_STATIC (gst_face_detect_debug);
@@ -99,6 +109,10 @@ GST_DEBUG_CATEGORY_STATIC (gst_face_detect_debug);
 #define DEFAULT_MIN_SIZE_WIDTH 30
 #define DEFAULT_MIN_SIZE_HEIGHT 30
 #define DEFAULT_MIN_STDDEV 0
+#define DEFAULT_DETECTION_SCALE 1.0
+#define DEFAULT_DETECTION_INTERVAL 1
+#define DEFAULT_ASYNC FALSE
+#define DEFAULT_MAX_LATENCY GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY
 
 using namespace cv;
 /* Filter signals and args */
@@ -122,7 +136,11 @@ enum
   PROP_MIN_SIZE_WIDTH,
   PROP_MIN_SIZE_HEIGHT,
   PROP_UPDATES,
-  PROP_MIN_STDDEV
+  PROP_MIN_STDDEV,
+  PROP_DETECTION_SCALE,
+  PROP_DETECTION_INTERVAL,
+  PROP_ASYNC,
+  PROP_MAX_LATENCY
 };
 
 
@@ -232,7 +250,9 @@ static gboolean gst_face_detect_set_caps (GstOpencvVideoFilter * transform,
     gint in_width, gint in_height, gint in_depth, gint in_channels,
     gint out_width, gint out_height, gint out_depth, gint out_channels);
 static GstFlowReturn gst_face_detect_transform_ip (GstOpencvVideoFilter * base,
-    GstBuffer * buf, IplImage * img);
+    GstBuffer * buf, Mat & img);
+static gboolean gst_face_detect_start (GstBaseTransform * trans);
+static gboolean gst_face_detect_stop (GstBaseTransform * trans);
 
 static CascadeClassifier *gst_face_detect_load_profile (GstFaceDetect *
     filter, gchar * profile);
@@ -243,8 +263,10 @@ gst_face_detect_finalize (GObject * obj)
 {
   GstFaceDetect *filter = GST_FACE_DETECT (obj);
 
-  if (filter->cvGray)
-    cvReleaseImage (&filter->cvGray);
+  delete filter->cvGray;
+  delete filter->cvDetectGray;
+  delete filter->faces;
+  delete filter->prev_faces;
 
   g_free (filter->face_profile);
   g_free (filter->nose_profile);
@@ -269,17 +291,22 @@ gst_face_detect_class_init (GstFaceDetectClass * klass)
 {
   GObjectClass *gobject_class;
   GstOpencvVideoFilterClass *gstopencvbasefilter_class;
+  GstBaseTransformClass *btrans_class;
 
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   gobject_class = (GObjectClass *) klass;
   gstopencvbasefilter_class = (GstOpencvVideoFilterClass *) klass;
+  btrans_class = (GstBaseTransformClass *) klass;
 
   gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_face_detect_finalize);
   gobject_class->set_property = gst_face_detect_set_property;
   gobject_class->get_property = gst_face_detect_get_property;
 
-  gstopencvbasefilter_class->cv_trans_ip_func = gst_face_detect_transform_ip;
+  gstopencvbasefilter_class->cv_trans_ip_mat_func =
+      gst_face_detect_transform_ip;
   gstopencvbasefilter_class->cv_set_caps = gst_face_detect_set_caps;
+  btrans_class->start = GST_DEBUG_FUNCPTR (gst_face_detect_start);
+  btrans_class->stop = GST_DEBUG_FUNCPTR (gst_face_detect_stop);
 
   g_object_class_install_property (gobject_class, PROP_DISPLAY,
       g_param_spec_boolean ("display", "Display",
@@ -344,6 +371,32 @@ gst_face_detect_class_init (GstFaceDetectClass * klass)
           "false positives not performing face detection on images with "
           "little changes", 0, 255, DEFAULT_MIN_STDDEV,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  g_object_class_install_property (gobject_class, PROP_DETECTION_SCALE,
+      g_param_spec_double ("detection-scale", "Detection scale",
+          "Scale the frame by this factor before searching for faces. "
+          "Smaller values are faster but miss small faces, the minimum face "
+          "size is scaled accordingly", 0.1, 1.0, DEFAULT_DETECTION_SCALE,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  g_object_class_install_property (gobject_class, PROP_DETECTION_INTERVAL,
+      g_param_spec_uint ("detection-interval", "Detection interval",
+          "Search for faces only every N frames, the positions in the frames "
+          "in between are extrapolated from the last two detections. Facial "
+          "features are only reported for frames where the detection ran",
+          1, G_MAXUINT, DEFAULT_DETECTION_INTERVAL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  g_object_class_install_property (gobject_class, PROP_ASYNC,
+      g_param_spec_boolean ("async", "Asynchronous",
+          "Search for faces in a separate thread and pass frames on without "
+          "waiting for it. Only the newest frame is analysed, the faces are "
+          "attached to later frames as region of interest meta and not drawn",
+          DEFAULT_ASYNC, (GParamFlags) (G_PARAM_READWRITE |
+              G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+  g_object_class_install_property (gobject_class, PROP_MAX_LATENCY,
+      g_param_spec_uint64 ("max-latency", "Maximum latency",
+          "In async mode, faces found in a frame are not attached to frames "
+          "more than this much later (in nanoseconds)", 0, G_MAXUINT64,
+          DEFAULT_MAX_LATENCY,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
   gst_element_class_set_static_metadata (element_class,
       "facedetect",
@@ -373,6 +426,14 @@ gst_face_detect_init (GstFaceDetect * filter)
   filter->min_size_width = DEFAULT_MIN_SIZE_WIDTH;
   filter->min_size_height = DEFAULT_MIN_SIZE_HEIGHT;
   filter->min_stddev = DEFAULT_MIN_STDDEV;
+  filter->detection_scale = DEFAULT_DETECTION_SCALE;
+  filter->detection_interval = DEFAULT_DETECTION_INTERVAL;
+  filter->async = DEFAULT_ASYNC;
+  filter->max_latency = DEFAULT_MAX_LATENCY;
+  filter->cvGray = new Mat ();
+  filter->cvDetectGray = new Mat ();
+  filter->faces = new vector < Rect > ();
+  filter->prev_faces = new vector < Rect > ();
   filter->cvFaceDetect =
       gst_face_detect_load_profile (filter, filter->face_profile);
   filter->cvNoseDetect =
@@ -450,6 +511,18 @@ gst_face_detect_set_property (GObject * object, guint prop_id,
     case PROP_UPDATES:
       filter->updates = g_value_get_enum (value);
       break;
+    case PROP_DETECTION_SCALE:
+      filter->detection_scale = g_value_get_double (value);
+      break;
+    case PROP_DETECTION_INTERVAL:
+      filter->detection_interval = g_value_get_uint (value);
+      break;
+    case PROP_ASYNC:
+      filter->async = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_LATENCY:
+      filter->max_latency = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -499,6 +572,18 @@ gst_face_detect_get_property (GObject * object, guint prop_id,
     case PROP_UPDATES:
       g_value_set_enum (value, filter->updates);
       break;
+    case PROP_DETECTION_SCALE:
+      g_value_set_double (value, filter->detection_scale);
+      break;
+    case PROP_DETECTION_INTERVAL:
+      g_value_set_uint (value, filter->detection_interval);
+      break;
+    case PROP_ASYNC:
+      g_value_set_boolean (value, filter->async);
+      break;
+    case PROP_MAX_LATENCY:
+      g_value_set_uint64 (value, filter->max_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -517,11 +602,15 @@ gst_face_detect_set_caps (GstOpencvVideoFilter * transform, gint in_width,
 
   filter = GST_FACE_DETECT (transform);
 
-  if (filter->cvGray)
-    cvReleaseImage (&filter->cvGray);
+  /* the worker may be using the buffers */
+  if (filter->worker)
+    gst_detection_worker_reset (filter->worker);
 
-  filter->cvGray = cvCreateImage (cvSize (in_width, in_height), IPL_DEPTH_8U,
-      1);
+  filter->cvGray->create (in_height, in_width, CV_8UC1);
+
+  filter->frame_count = 0;
+  filter->faces->clear ();
+  filter->prev_faces->clear ();
 
   return TRUE;
 }
@@ -549,20 +638,20 @@ gst_face_detect_message_new (GstFaceDetect * filter, GstBuffer * buf)
 
 static void
 gst_face_detect_run_detector (GstFaceDetect * filter,
-    CascadeClassifier * detector, gint min_size_width,
+    CascadeClassifier * detector, Mat & gray, gint min_size_width,
     gint min_size_height, Rect r, vector < Rect > &faces)
 {
   double img_stddev = 0;
   if (filter->min_stddev > 0) {
-    CvScalar mean, stddev;
-    cvAvgSdv (filter->cvGray, &mean, &stddev, NULL);
+    Scalar mean, stddev;
+    meanStdDev (gray, mean, stddev);
     img_stddev = stddev.val[0];
   }
   if (img_stddev >= filter->min_stddev) {
-    Mat roi (cv::cvarrToMat (filter->cvGray), r);
+    Mat roi (gray, r);
     detector->detectMultiScale (roi, faces, filter->scale_factor,
-        filter->min_neighbors, filter->flags, cvSize (min_size_width,
-            min_size_height), cvSize (0, 0));
+        filter->min_neighbors, filter->flags, Size (min_size_width,
+            min_size_height), Size (0, 0));
   } else {
     GST_LOG_OBJECT (filter,
         "Calculated stddev %f lesser than min_stddev %d, detection not performed",
@@ -570,15 +659,97 @@ gst_face_detect_run_detector (GstFaceDetect * filter,
   }
 }
 
+/* Searches for faces in the gray frame, optionally on a downscaled copy of
+ * it. The returned rectangles are in frame coordinates. */
+static void
+gst_face_detect_detect_faces (GstFaceDetect * filter, vector < Rect > &faces)
+{
+  gdouble scale = filter->detection_scale;
+  Mat *gray = filter->cvGray;
+
+  if (scale < 1.0) {
+    resize (*filter->cvGray, *filter->cvDetectGray, Size (), scale, scale,
+        INTER_AREA);
+    gray = filter->cvDetectGray;
+  }
+
+  gst_face_detect_run_detector (filter, filter->cvFaceDetect, *gray,
+      MAX (1, cvRound (filter->min_size_width * scale)),
+      MAX (1, cvRound (filter->min_size_height * scale)),
+      Rect (0, 0, gray->cols, gray->rows), faces);
+
+  if (scale < 1.0) {
+    Rect bounds (0, 0, filter->cvGray->cols, filter->cvGray->rows);
+
+    for (unsigned int i = 0; i < faces.size (); ++i) {
+      Rect r = faces[i];
+
+      faces[i] = Rect (cvRound (r.x / scale), cvRound (r.y / scale),
+          cvRound (r.width / scale), cvRound (r.height / scale)) & bounds;
+    }
+  }
+}
+
+/* Moves the faces of the last detection along the way they moved between
+ * the last two detections. Faces are paired with the nearest face of the
+ * previous detection, faces without a partner stay where they are. */
+static void
+gst_face_detect_predict_faces (GstFaceDetect * filter, guint64 frame,
+    Size size, vector < Rect > &faces)
+{
+  const vector < Rect > &last = *filter->faces;
+  const vector < Rect > &prev = *filter->prev_faces;
+  gdouble distance = filter->last_detection_frame -
+      filter->prev_detection_frame;
+  gdouble f;
+  Rect bounds (0, 0, size.width, size.height);
+
+  faces = last;
+  if (prev.empty () || distance <= 0)
+    return;
+
+  f = (frame - filter->last_detection_frame) / distance;
+
+  for (unsigned int i = 0; i < last.size (); ++i) {
+    Point2d c = (Point2d (last[i].tl ()) + Point2d (last[i].br ())) * 0.5;
+    double best = MAX (last[i].width, last[i].height);
+    const Rect *match = NULL;
+
+    for (unsigned int j = 0; j < prev.size (); ++j) {
+      Point2d pc = (Point2d (prev[j].tl ()) + Point2d (prev[j].br ())) * 0.5;
+      double d = norm (c - pc);
+
+      if (d < best) {
+        best = d;
+        match = &prev[j];
+      }
+    }
+    if (!match)
+      continue;
+
+    faces[i] = Rect (last[i].x + cvRound ((last[i].x - match->x) * f),
+        last[i].y + cvRound ((last[i].y - match->y) * f),
+        last[i].width + cvRound ((last[i].width - match->width) * f),
+        last[i].height + cvRound ((last[i].height - match->height) * f))
+        & bounds;
+  }
+
+  for (vector < Rect >::iterator it = faces.begin (); it != faces.end ();) {
+    if (it->area () <= 0)
+      it = faces.erase (it);
+    else
+      ++it;
+  }
+}
+
 /*
- * Performs the face detection
+ * Performs the face detection, from the streaming thread or in async mode
+ * from the worker thread on a copy of the frame
  */
-static GstFlowReturn
-gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
-    IplImage * img)
+static void
+gst_face_detect_process (GstFaceDetect * filter, GstBuffer * buf, Mat & img,
+    gboolean display)
 {
-  GstFaceDetect *filter = GST_FACE_DETECT (base);
-
   if (filter->cvFaceDetect) {
     GstMessage *msg = NULL;
     GstStructure *s;
@@ -589,15 +760,23 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     vector < Rect > nose;
     vector < Rect > eyes;
     gboolean post_msg = FALSE;
-
-    Mat mtxOrg (cv::cvarrToMat (img));
-
-    cvCvtColor (img, filter->cvGray, CV_RGB2GRAY);
-
-    gst_face_detect_run_detector (filter, filter->cvFaceDetect,
-        filter->min_size_width, filter->min_size_height,
-        Rect (filter->cvGray->origin, filter->cvGray->origin,
-            filter->cvGray->width, filter->cvGray->height), faces);
+    gboolean detect;
+    guint64 frame;
+
+    frame = filter->frame_count++;
+    detect = (frame % filter->detection_interval) == 0;
+
+    if (detect) {
+      cvtColor (img, *filter->cvGray, COLOR_RGB2GRAY);
+      gst_face_detect_detect_faces (filter, faces);
+
+      filter->prev_faces->swap (*filter->faces);
+      *filter->faces = faces;
+      filter->prev_detection_frame = filter->last_detection_frame;
+      filter->last_detection_frame = frame;
+    } else {
+      gst_face_detect_predict_faces (filter, frame, img.size (), faces);
+    }
 
     switch (filter->updates) {
       case GST_FACEDETECT_UPDATES_EVERY_FRAME:
@@ -647,36 +826,38 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
 
       /* detect face features */
 
-      if (filter->cvNoseDetect) {
+      if (detect && filter->cvNoseDetect) {
         rnx = r.x + r.width / 4;
         rny = r.y + r.height / 4;
         rnw = r.width / 2;
         rnh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvNoseDetect, mw, mh,
+        gst_face_detect_run_detector (filter, filter->cvNoseDetect,
+            *filter->cvGray, mw, mh,
             Rect (rnx, rny, rnw, rnh), nose);
         have_nose = !nose.empty ();
       } else {
         have_nose = FALSE;
       }
 
-      if (filter->cvMouthDetect) {
+      if (detect && filter->cvMouthDetect) {
         rmx = r.x;
         rmy = r.y + r.height / 2;
         rmw = r.width;
         rmh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvMouthDetect, mw,
-            mh, Rect (rmx, rmy, rmw, rmh), mouth);
+        gst_face_detect_run_detector (filter, filter->cvMouthDetect,
+            *filter->cvGray, mw, mh, Rect (rmx, rmy, rmw, rmh), mouth);
         have_mouth = !mouth.empty ();
       } else {
         have_mouth = FALSE;
       }
 
-      if (filter->cvEyesDetect) {
+      if (detect && filter->cvEyesDetect) {
         rex = r.x;
         rey = r.y;
         rew = r.width;
         reh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvEyesDetect, mw, mh,
+        gst_face_detect_run_detector (filter, filter->cvEyesDetect,
+            *filter->cvGray, mw, mh,
             Rect (rex, rey, rew, reh), eyes);
         have_eyes = !eyes.empty ();
       } else {
@@ -708,8 +889,8 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
         s = NULL;
       }
 
-      if (filter->display) {
-        CvPoint center;
+      if (display) {
+        Point center;
         Size axes;
         gdouble w, h;
         gint cb = 255 - ((i & 3) << 7);
@@ -722,7 +903,7 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
         center.y = cvRound ((r.y + h));
         axes.width = w;
         axes.height = h * 1.25; /* tweak for face form */
-        ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 3, 8, 0);
+        ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 3, 8, 0);
 
         if (have_nose) {
           Rect sr = nose[0];
@@ -733,7 +914,7 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
           center.y = cvRound ((rny + sr.y + h));
           axes.width = w;
           axes.height = h * 1.25;       /* tweak for nose form */
-          ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
+          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
               0);
         }
         if (have_mouth) {
@@ -745,7 +926,7 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
           center.y = cvRound ((rmy + sr.y + h));
           axes.width = w * 1.5; /* tweak for mouth form */
           axes.height = h;
-          ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
+          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
               0);
         }
         if (have_eyes) {
@@ -757,7 +938,7 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
           center.y = cvRound ((rey + sr.y + h));
           axes.width = w * 1.5; /* tweak for eyes form */
           axes.height = h;
-          ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
+          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
               0);
         }
       }
@@ -771,12 +952,62 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
       g_value_unset (&facelist);
       gst_element_post_message (GST_ELEMENT (filter), msg);
     }
-    mtxOrg.release ();
+  }
+}
+
+static void
+gst_face_detect_analyse (GstElement * element, GstBuffer * info, Mat & frame)
+{
+  gst_face_detect_process (GST_FACE_DETECT (element), info, frame, FALSE);
+}
+
+static GstFlowReturn
+gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
+    Mat & img)
+{
+  GstFaceDetect *filter = GST_FACE_DETECT (base);
+
+  if (filter->worker) {
+    gst_detection_worker_push (filter->worker, buf, img);
+    gst_detection_worker_attach (filter->worker, buf, filter->max_latency);
+  } else {
+    gst_face_detect_process (filter, buf, img, filter->display);
   }
 
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_face_detect_start (GstBaseTransform * trans)
+{
+  GstFaceDetect *filter = GST_FACE_DETECT (trans);
+
+  if (filter->async) {
+    filter->worker = gst_detection_worker_new (GST_ELEMENT (filter),
+        gst_face_detect_analyse);
+    if (!filter->worker) {
+      GST_ELEMENT_ERROR (filter, RESOURCE, FAILED, (NULL),
+          ("Failed to start the detection thread"));
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_face_detect_stop (GstBaseTransform * trans)
+{
+  GstFaceDetect *filter = GST_FACE_DETECT (trans);
+
+  if (filter->worker) {
+    gst_detection_worker_free (filter->worker);
+    filter->worker = NULL;
+  }
+
+  return TRUE;
+}
+
 
 static CascadeClassifier *
 gst_face_detect_load_profile (GstFaceDetect * filter, gchar * profile)
@@ -51,6 +51,7 @@
 #include <gst/gst.h>
 #include <gst/opencv/gstopencvvideofilter.h>
 
+#include <vector>
 #include <opencv2/core.hpp>
 #include <opencv2/objdetect.hpp>
 
@@ -103,8 +104,25 @@ struct _GstFaceDetect
   gint min_size_height;
   gint min_stddev;
   gint updates;
+  gdouble detection_scale;
+  guint detection_interval;
+  gboolean async;
+  guint64 max_latency;
 
-  IplImage *cvGray;
+  /* analysis thread in async mode */
+  struct _GstDetectionWorker *worker;
+
+  /* faces found by the last two detections, the ones in between are
+   * extrapolated from these */
+  guint64 frame_count;
+  guint64 last_detection_frame;
+  guint64 prev_detection_frame;
+  std::vector < cv::Rect > *faces;
+  std::vector < cv::Rect > *prev_faces;
+
+  /* conversion buffers, kept around to avoid allocations per frame */
+  cv::Mat *cvGray;
+  cv::Mat *cvDetectGray;
   cv::CascadeClassifier *cvFaceDetect;
   cv::CascadeClassifier *cvNoseDetect;
   cv::CascadeClassifier *cvMouthDetect;
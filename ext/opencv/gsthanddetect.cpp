@@ -53,6 +53,10 @@
  * gst-launch-1.0 autovideosrc ! videoconvert ! "video/x-raw, format=RGB, width=320, height=240" ! \
  * videoscale ! handdetect ! videoconvert ! xvimagesink
  * ]|
+ * |[
+ * gst-launch-1.0 v4l2src ! videoconvert ! handdetect async=true ! videoconvert ! x264enc ! mp4mux ! filesink location=out.mp4
+ * ]| Detect hands in a separate thread without holding up the video, the
+ * hands are attached to the frames as GstVideoRegionOfInterestMeta
  * </refsect2>
  */
 
@@ -62,6 +66,7 @@
 
 /* element header */
 #include "gsthanddetect.h"
+#include "detectionworker.hpp"
 #include <opencv2/imgproc.hpp>
 
 GST_DEBUG_CATEGORY_STATIC (gst_handdetect_debug);
@@ -71,6 +76,9 @@ GST_DEBUG_CATEGORY_STATIC (gst_handdetect_debug);
 #define HAAR_FILE_FIST GST_HAAR_CASCADES_DIR G_DIR_SEPARATOR_S "fist.xml"
 #define HAAR_FILE_PALM GST_HAAR_CASCADES_DIR G_DIR_SEPARATOR_S "palm.xml"
 
+#define DEFAULT_ASYNC FALSE
+#define DEFAULT_MAX_LATENCY GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY
+
 using namespace cv;
 using namespace std;
 /* Filter signals and args */
@@ -89,7 +97,9 @@ enum
   PROP_ROI_X,
   PROP_ROI_Y,
   PROP_ROI_WIDTH,
-  PROP_ROI_HEIGHT
+  PROP_ROI_HEIGHT,
+  PROP_ASYNC,
+  PROP_MAX_LATENCY
 };
 
 /* the capabilities of the inputs and outputs */
@@ -112,7 +122,9 @@ static gboolean gst_handdetect_set_caps (GstOpencvVideoFilter * transform,
     gint in_width, gint in_height, gint in_depth, gint in_channels,
     gint out_width, gint out_height, gint out_depth, gint out_channels);
 static GstFlowReturn gst_handdetect_transform_ip (GstOpencvVideoFilter *
-    transform, GstBuffer * buffer, IplImage * img);
+    transform, GstBuffer * buffer, Mat & img);
+static gboolean gst_handdetect_start (GstBaseTransform * trans);
+static gboolean gst_handdetect_stop (GstBaseTransform * trans);
 
 static CascadeClassifier *gst_handdetect_load_profile (GstHanddetect * filter,
     gchar * profile);
@@ -159,8 +171,7 @@ gst_handdetect_finalize (GObject * obj)
 {
   GstHanddetect *filter = GST_HANDDETECT (obj);
 
-  if (filter->cvGray)
-    cvReleaseImage (&filter->cvGray);
+  delete filter->cvGray;
   g_free (filter->profile_fist);
   g_free (filter->profile_palm);
   delete (filter->best_r);
@@ -174,13 +185,18 @@ gst_handdetect_class_init (GstHanddetectClass * klass)
 {
   GObjectClass *gobject_class;
   GstOpencvVideoFilterClass *gstopencvbasefilter_class;
+  GstBaseTransformClass *btrans_class;
 
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   gobject_class = (GObjectClass *) klass;
   gstopencvbasefilter_class = (GstOpencvVideoFilterClass *) klass;
+  btrans_class = (GstBaseTransformClass *) klass;
 
-  gstopencvbasefilter_class->cv_trans_ip_func = gst_handdetect_transform_ip;
+  gstopencvbasefilter_class->cv_trans_ip_mat_func =
+      gst_handdetect_transform_ip;
   gstopencvbasefilter_class->cv_set_caps = gst_handdetect_set_caps;
+  btrans_class->start = GST_DEBUG_FUNCPTR (gst_handdetect_start);
+  btrans_class->stop = GST_DEBUG_FUNCPTR (gst_handdetect_stop);
 
   gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_handdetect_finalize);
   gobject_class->set_property = gst_handdetect_set_property;
@@ -239,6 +255,19 @@ gst_handdetect_class_init (GstHanddetectClass * klass)
           "HEIGHT of left-top pointer in region of interest \nGestures in the defined region of interest will emit messages",
           0, INT_MAX, 0, (GParamFlags)G_PARAM_READWRITE)
       );
+  g_object_class_install_property (gobject_class, PROP_ASYNC,
+      g_param_spec_boolean ("async", "Asynchronous",
+          "Detect hands in a separate thread and pass frames on without "
+          "waiting for it. Only the newest frame is analysed, the hands are "
+          "attached to later frames as region of interest meta and not drawn",
+          DEFAULT_ASYNC, (GParamFlags) (G_PARAM_READWRITE |
+              G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+  g_object_class_install_property (gobject_class, PROP_MAX_LATENCY,
+      g_param_spec_uint64 ("max-latency", "Maximum latency",
+          "In async mode, hands found in a frame are not attached to frames "
+          "more than this much later (in nanoseconds)", 0, G_MAXUINT64,
+          DEFAULT_MAX_LATENCY,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
   gst_element_class_set_static_metadata (element_class,
       "handdetect",
@@ -275,6 +304,9 @@ gst_handdetect_init (GstHanddetect * filter)
   filter->roi_width = 0;
   filter->roi_height = 0;
   filter->display = TRUE;
+  filter->async = DEFAULT_ASYNC;
+  filter->max_latency = DEFAULT_MAX_LATENCY;
+  filter->cvGray = new Mat ();
 
   filter->cvCascade_fist =
       gst_handdetect_load_profile (filter, filter->profile_fist);
@@ -323,6 +355,12 @@ gst_handdetect_set_property (GObject * object, guint prop_id,
     case PROP_ROI_HEIGHT:
       filter->roi_height = g_value_get_int (value);
       break;
+    case PROP_ASYNC:
+      filter->async = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_LATENCY:
+      filter->max_latency = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -357,6 +395,12 @@ gst_handdetect_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_ROI_HEIGHT:
       g_value_set_int (value, filter->roi_height);
       break;
+    case PROP_ASYNC:
+      g_value_set_boolean (value, filter->async);
+      break;
+    case PROP_MAX_LATENCY:
+      g_value_set_uint64 (value, filter->max_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -378,22 +422,24 @@ gst_handdetect_set_caps (GstOpencvVideoFilter * transform,
     GST_WARNING_OBJECT (filter,
         "resize to 320 x 240 to have best detect accuracy.\n");
 
-  if (filter->cvGray)
-    cvReleaseImage (&filter->cvGray);
-  filter->cvGray =
-      cvCreateImage (cvSize (in_width, in_height), IPL_DEPTH_8U, 1);
+  /* the worker may be using the buffers */
+  if (filter->worker)
+    gst_detection_worker_reset (filter->worker);
+
+  filter->cvGray->create (in_height, in_width, CV_8UC1);
 
   return TRUE;
 }
 
 /* Hand detection function
- * This function does the actual processing 'of hand detect and display'
+ * This function does the actual processing 'of hand detect and display',
+ * from the streaming thread or in async mode from the worker thread on a
+ * copy of the frame
  */
-static GstFlowReturn
-gst_handdetect_transform_ip (GstOpencvVideoFilter * transform,
-    GstBuffer * buffer, IplImage * img)
+static void
+gst_handdetect_process (GstHanddetect * filter, GstBuffer * buffer,
+    Mat & img, gboolean display)
 {
-  GstHanddetect *filter = GST_HANDDETECT (transform);
   Rect *r;
   GstStructure *s;
   GstMessage *m;
@@ -403,29 +449,26 @@ gst_handdetect_transform_ip (GstOpencvVideoFilter * transform,
   /* check detection cascades */
   if (filter->cvCascade_fist && filter->cvCascade_palm) {
   /* cvt to gray colour space for hand detect */
-    cvCvtColor (img, filter->cvGray, CV_RGB2GRAY);
+    cvtColor (img, *filter->cvGray, COLOR_RGB2GRAY);
 
     /* detect FIST gesture fist */
-    Mat image = cvarrToMat(filter->cvGray);
-    Mat roi (image, Rect (filter->cvGray->origin,
-            filter->cvGray->origin, filter->cvGray->width,
-            filter->cvGray->height));
+    Mat & roi = *filter->cvGray;
     filter->cvCascade_fist->detectMultiScale (roi, hands, 1.1, 2,
-        CV_HAAR_DO_CANNY_PRUNING, cvSize (24, 24), cvSize (0, 0));
+        CV_HAAR_DO_CANNY_PRUNING, Size (24, 24), Size (0, 0));
 
     /* if FIST gesture detected */
     if (!hands.empty ()) {
 
       int min_distance, distance;
       Rect temp_r;
-      CvPoint c;
+      Point c;
 
       /* Go through all detected FIST gestures to get the best one
        * prev_r => previous hand
        * best_r => best hand in this frame
        */
       /* set min_distance for init comparison */
-      min_distance = img->width + img->height;
+      min_distance = img.cols + img.rows;
       /* Init filter->prev_r */
       temp_r = Rect (0, 0, 0, 0);
       if (filter->prev_r == NULL)
@@ -446,7 +489,7 @@ gst_handdetect_transform_ip (GstOpencvVideoFilter * transform,
 
       /* send msg to app/bus if the detected gesture falls in the region of interest */
       /* get center point of gesture */
-      c = cvPoint (filter->best_r->x + filter->best_r->width / 2,
+      c = Point (filter->best_r->x + filter->best_r->width / 2,
           filter->best_r->y + filter->best_r->height / 2);
       /* send message:
        * if the center point is in the region of interest, OR,
@@ -485,26 +528,30 @@ gst_handdetect_transform_ip (GstOpencvVideoFilter * transform,
 
 #endif
       }
+      gst_buffer_add_video_region_of_interest_meta (buffer, "fist",
+          filter->best_r->x, filter->best_r->y, filter->best_r->width,
+          filter->best_r->height);
+
       /* Check filter->display,
        * If TRUE, displaying red circle marker in the out frame */
-      if (filter->display) {
-        CvPoint center;
+      if (display) {
+        Point center;
         int radius;
         center.x = cvRound ((filter->best_r->x + filter->best_r->width * 0.5));
         center.y = cvRound ((filter->best_r->y + filter->best_r->height * 0.5));
         radius =
             cvRound ((filter->best_r->width + filter->best_r->height) * 0.25);
-        cvCircle (img, center, radius, CV_RGB (0, 0, 200), 1, 8, 0);
+        circle (img, center, radius, CV_RGB (0, 0, 200), 1, 8, 0);
       }
     } else {
      /* if NO FIST gesture, detecting PALM gesture */
       filter->cvCascade_palm->detectMultiScale (roi, hands, 1.1, 2,
-          CV_HAAR_DO_CANNY_PRUNING, cvSize (24, 24), cvSize (0, 0));
+          CV_HAAR_DO_CANNY_PRUNING, Size (24, 24), Size (0, 0));
       /* if PALM detected */
       if (!hands.empty ()) {
         int min_distance, distance;
         Rect temp_r;
-        CvPoint c;
+        Point c;
 
         if (filter->display) {
           GST_DEBUG_OBJECT (filter, "%d PALM gestures detected\n",
@@ -515,7 +562,7 @@ gst_handdetect_transform_ip (GstOpencvVideoFilter * transform,
          * best_r => best hand in this frame
          */
         /* suppose a min_distance for init comparison */
-        min_distance = img->width + img->height;
+        min_distance = img.cols + img.rows;
         /* Init filter->prev_r */
         temp_r = Rect (0, 0, 0, 0);
        if (filter->prev_r == NULL)
@@ -536,7 +583,7 @@ gst_handdetect_transform_ip (GstOpencvVideoFilter * transform,
 
         /* send msg to app/bus if the detected gesture falls in the region of interest */
         /* get center point of gesture */
-        c = cvPoint (filter->best_r->x + filter->best_r->width / 2,
+        c = Point (filter->best_r->x + filter->best_r->width / 2,
             filter->best_r->y + filter->best_r->height / 2);
         /* send message:
          * if the center point is in the region of interest, OR,
@@ -589,10 +636,14 @@ gst_handdetect_transform_ip (GstOpencvVideoFilter * transform,
            */
 #endif
         }
+        gst_buffer_add_video_region_of_interest_meta (buffer, "palm",
+            filter->best_r->x, filter->best_r->y, filter->best_r->width,
+            filter->best_r->height);
+
         /* Check filter->display,
          * If TRUE, displaying red circle marker in the out frame */
-        if (filter->display) {
-          CvPoint center;
+        if (display) {
+          Point center;
           int radius;
           center.x =
               cvRound ((filter->best_r->x + filter->best_r->width * 0.5));
@@ -600,16 +651,67 @@ gst_handdetect_transform_ip (GstOpencvVideoFilter * transform,
               cvRound ((filter->best_r->y + filter->best_r->height * 0.5));
           radius =
               cvRound ((filter->best_r->width + filter->best_r->height) * 0.25);
-          cvCircle (img, center, radius, CV_RGB (0, 0, 200), 1, 8, 0);
+          circle (img, center, radius, CV_RGB (0, 0, 200), 1, 8, 0);
         }
       }
     }
   }
+}
+
+static void
+gst_handdetect_analyse (GstElement * element, GstBuffer * info, Mat & frame)
+{
+  gst_handdetect_process (GST_HANDDETECT (element), info, frame, FALSE);
+}
+
+static GstFlowReturn
+gst_handdetect_transform_ip (GstOpencvVideoFilter * transform,
+    GstBuffer * buffer, Mat & img)
+{
+  GstHanddetect *filter = GST_HANDDETECT (transform);
+
+  if (filter->worker) {
+    gst_detection_worker_push (filter->worker, buffer, img);
+    gst_detection_worker_attach (filter->worker, buffer, filter->max_latency);
+  } else {
+    gst_handdetect_process (filter, buffer, img, filter->display);
+  }
 
   /* Push out the incoming buffer */
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_handdetect_start (GstBaseTransform * trans)
+{
+  GstHanddetect *filter = GST_HANDDETECT (trans);
+
+  if (filter->async) {
+    filter->worker = gst_detection_worker_new (GST_ELEMENT (filter),
+        gst_handdetect_analyse);
+    if (!filter->worker) {
+      GST_ELEMENT_ERROR (filter, RESOURCE, FAILED, (NULL),
+          ("Failed to start the detection thread"));
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_handdetect_stop (GstBaseTransform * trans)
+{
+  GstHanddetect *filter = GST_HANDDETECT (trans);
+
+  if (filter->worker) {
+    gst_detection_worker_free (filter->worker);
+    filter->worker = NULL;
+  }
+
+  return TRUE;
+}
+
 static CascadeClassifier *
 gst_handdetect_load_profile (GstHanddetect * filter, gchar * profile)
 {
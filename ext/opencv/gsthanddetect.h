@@ -79,11 +79,16 @@ struct _GstHanddetect
   gint roi_y;
   gint roi_width;
   gint roi_height;
+  gboolean async;
+  guint64 max_latency;
+
+  /* analysis thread in async mode */
+  struct _GstDetectionWorker *worker;
 
   /* opencv
    * cvGray - image to gray colour
    */
-  IplImage *cvGray;
+  cv::Mat *cvGray;
   cv::CascadeClassifier *cvCascade_fist;
   cv::CascadeClassifier *cvCascade_palm;
   cv::Rect *prev_r;
@@ -52,6 +52,11 @@
  * |[
  * gst-launch-1.0 videotestsrc pattern=18 ! videorate ! videoscale ! video/x-raw,width=320,height=240,framerate=5/1 ! videoconvert ! motioncells ! videoconvert ! xvimagesink
  * ]|
+ * |[
+ * gst-launch-1.0 v4l2src ! videoconvert ! motioncells async=true ! videoconvert ! x264enc ! mp4mux ! filesink location=out.mp4
+ * ]| Detect motion in a separate thread without holding up the video, the
+ * cells with motion are attached to the frames as
+ * GstVideoRegionOfInterestMeta
  * </refsect2>
  */
 
@@ -60,6 +65,7 @@
 #endif
 
 #include "gstmotioncells.h"
+#include "detectionworker.hpp"
 
 GST_DEBUG_CATEGORY_STATIC (gst_motion_cells_debug);
 #define GST_CAT_DEFAULT gst_motion_cells_debug
@@ -89,6 +95,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_motion_cells_debug);
 #define DATE_DEF 1
 #define DATE_MAX LONG_MAX
 #define DEF_DATAFILEEXT "vamc"
+#define ASYNC_DEF FALSE
+#define MAX_LATENCY_DEF GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY
 #define MSGLEN 6
 #define BUSMSGLEN 20
 
@@ -126,7 +134,9 @@ enum
   PROP_CALCULATEMOTION,
   PROP_POSTALLMOTION,
   PROP_USEALPHA,
-  PROP_MOTIONCELLTHICKNESS
+  PROP_MOTIONCELLTHICKNESS,
+  PROP_ASYNC,
+  PROP_MAX_LATENCY
 };
 
 /* the capabilities of the inputs and outputs.
@@ -151,8 +161,10 @@ static void gst_motion_cells_get_property (GObject * object, guint prop_id,
 static gboolean gst_motion_cells_handle_sink_event (GstPad * pad,
     GstObject * parent, GstEvent * event);
 static GstFlowReturn gst_motion_cells_transform_ip (GstOpencvVideoFilter *
-    filter, GstBuffer * buf, IplImage * img);
+    filter, GstBuffer * buf, cv::Mat & img);
 
+static gboolean gst_motion_cells_start (GstBaseTransform * trans);
+static gboolean gst_motion_cells_stop (GstBaseTransform * trans);
 static void gst_motioncells_update_motion_cells (GstMotioncells * filter);
 static void gst_motioncells_update_motion_masks (GstMotioncells * filter);
 
@@ -191,16 +203,21 @@ gst_motion_cells_class_init (GstMotioncellsClass * klass)
 {
   GObjectClass *gobject_class;
   GstOpencvVideoFilterClass *gstopencvbasefilter_class;
+  GstBaseTransformClass *btrans_class;
 
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   gobject_class = (GObjectClass *) klass;
   gstopencvbasefilter_class = (GstOpencvVideoFilterClass *) klass;
+  btrans_class = (GstBaseTransformClass *) klass;
 
   gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_motion_cells_finalize);
   gobject_class->set_property = gst_motion_cells_set_property;
   gobject_class->get_property = gst_motion_cells_get_property;
 
-  gstopencvbasefilter_class->cv_trans_ip_func = gst_motion_cells_transform_ip;
+  gstopencvbasefilter_class->cv_trans_ip_mat_func =
+      gst_motion_cells_transform_ip;
+  btrans_class->start = GST_DEBUG_FUNCPTR (gst_motion_cells_start);
+  btrans_class->stop = GST_DEBUG_FUNCPTR (gst_motion_cells_stop);
 
   g_object_class_install_property (gobject_class, PROP_GRID_X,
       g_param_spec_int ("gridx", "Number of Horizontal Grids",
@@ -301,6 +318,20 @@ gst_motion_cells_class_init (GstMotioncellsClass * klass)
           "Motion Cell Border Thickness. Set to -1 to fill motion cell",
           THICKNESS_MIN, THICKNESS_MAX, THICKNESS_DEF,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  g_object_class_install_property (gobject_class, PROP_ASYNC,
+      g_param_spec_boolean ("async", "Asynchronous",
+          "Detect motion in a separate thread and pass frames on without "
+          "waiting for it. Only the newest frame is analysed, the cells with "
+          "motion are attached to later frames as region of interest meta "
+          "and not drawn", ASYNC_DEF,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+              GST_PARAM_MUTABLE_READY)));
+  g_object_class_install_property (gobject_class, PROP_MAX_LATENCY,
+      g_param_spec_uint64 ("max-latency", "Maximum latency",
+          "In async mode, motion found in a frame is not attached to frames "
+          "more than this much later (in nanoseconds)", 0, G_MAXUINT64,
+          MAX_LATENCY_DEF,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
   gst_element_class_set_static_metadata (element_class,
       "motioncells",
@@ -325,6 +356,8 @@ gst_motion_cells_init (GstMotioncells * filter)
 
   filter->display = TRUE;
   filter->calculate_motion = TRUE;
+  filter->async = ASYNC_DEF;
+  filter->max_latency = MAX_LATENCY_DEF;
 
   filter->prevgridx = 0;
   filter->prevgridy = 0;
@@ -450,6 +483,12 @@ gst_motion_cells_set_property (GObject * object, guint prop_id,
     case PROP_DISPLAY:
       filter->display = g_value_get_boolean (value);
       break;
+    case PROP_ASYNC:
+      filter->async = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_LATENCY:
+      filter->max_latency = g_value_get_uint64 (value);
+      break;
     case PROP_POSTALLMOTION:
       filter->postallmotion = g_value_get_boolean (value);
       break;
@@ -653,6 +692,12 @@ gst_motion_cells_get_property (GObject * object, guint prop_id,
     case PROP_DISPLAY:
       g_value_set_boolean (value, filter->display);
       break;
+    case PROP_ASYNC:
+      g_value_set_boolean (value, filter->async);
+      break;
+    case PROP_MAX_LATENCY:
+      g_value_set_uint64 (value, filter->max_latency);
+      break;
     case PROP_POSTALLMOTION:
       g_value_set_boolean (value, filter->postallmotion);
       break;
@@ -836,6 +881,10 @@ gst_motion_cells_handle_sink_event (GstPad * pad, GstObject * parent,
       gst_event_parse_caps (event, &caps);
       gst_video_info_from_caps (&info, caps);
 
+      /* the worker may be analysing a frame of the old size */
+      if (filter->worker)
+        gst_detection_worker_reset (filter->worker);
+
       filter->width = info.width;
       filter->height = info.height;
 
@@ -861,15 +910,38 @@ gst_motion_cells_handle_sink_event (GstPad * pad, GstObject * parent,
   return res;
 }
 
-/* chain function
- * this function does the actual processing
- */
-static GstFlowReturn
-gst_motion_cells_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
-    IplImage * img)
+/* attaches the cells of a "l:c,l:c,..." index list as region of interest
+ * meta to @buf */
+static void
+gst_motion_cells_add_roi_metas (GstBuffer * buf, const char *cells,
+    int gridx, int gridy, int width, int height)
 {
-  GstMotioncells *filter = gst_motion_cells (base);
+  gchar **idx;
+  guint i;
+
+  idx = g_strsplit (cells, ",", -1);
+  for (i = 0; idx[i]; i++) {
+    int line, col, x, y;
 
+    if (sscanf (idx[i], "%d:%d", &line, &col) != 2)
+      continue;
+
+    x = col * width / gridx;
+    y = line * height / gridy;
+    gst_buffer_add_video_region_of_interest_meta (buf, "motion", x, y,
+        (col + 1) * width / gridx - x, (line + 1) * height / gridy - y);
+  }
+  g_strfreev (idx);
+}
+
+/* this function does the actual processing, from the streaming thread or in
+ * async mode from the worker thread on a copy of the frame. Cells are only
+ * drawn on the frame when @draw is TRUE.
+ */
+static void
+gst_motion_cells_process (GstMotioncells * filter, GstBuffer * buf,
+    cv::Mat & img, gboolean draw)
+{
   GST_OBJECT_LOCK (filter);
   if (filter->calculate_motion) {
     double sensitivity;
@@ -898,7 +970,7 @@ gst_motion_cells_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     framerate = filter->framerate;
     gridx = filter->gridx;
     gridy = filter->gridy;
-    display = filter->display;
+    display = filter->display && draw;
     motionmaskcoord_count = filter->motionmaskcoord_count;
     motionmaskcoords =
         g_new0 (motionmaskcoordrect, filter->motionmaskcoord_count);
@@ -1011,7 +1083,7 @@ gst_motion_cells_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
       GFREE (motionmaskcellsidx);
       GFREE (motioncellsidx);
       GST_OBJECT_UNLOCK (filter);
-      return GST_FLOW_OK;
+      return;
     }
 
     filter->changed_datafile = getChangedDataFile (filter->id);
@@ -1030,6 +1102,8 @@ gst_motion_cells_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
       filter->last_motion_timestamp = GST_BUFFER_TIMESTAMP (buf);
       detectedmotioncells = getMotionCellsIdx (filter->id);
       if (detectedmotioncells) {
+        gst_motion_cells_add_roi_metas (buf, detectedmotioncells, gridx, gridy,
+            img.cols, img.rows);
         filter->consecutive_motion++;
         if ((filter->previous_motion == FALSE)
             && (filter->consecutive_motion >= minimum_motion_frames)) {
@@ -1115,9 +1189,69 @@ gst_motion_cells_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     GST_WARNING_OBJECT (filter, "Motion detection disabled");
     GST_OBJECT_UNLOCK (filter);
   }
+}
+
+static void
+gst_motion_cells_analyse (GstElement * element, GstBuffer * info,
+    cv::Mat & frame)
+{
+  gst_motion_cells_process (gst_motion_cells (element), info, frame, FALSE);
+}
+
+/* chain function */
+static GstFlowReturn
+gst_motion_cells_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
+    cv::Mat & img)
+{
+  GstMotioncells *filter = gst_motion_cells (base);
+
+  if (filter->worker) {
+    GstClockTime max_latency;
+
+    GST_OBJECT_LOCK (filter);
+    max_latency = filter->max_latency;
+    GST_OBJECT_UNLOCK (filter);
+
+    gst_detection_worker_push (filter->worker, buf, img);
+    gst_detection_worker_attach (filter->worker, buf, max_latency);
+  } else {
+    gst_motion_cells_process (filter, buf, img, TRUE);
+  }
+
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_motion_cells_start (GstBaseTransform * trans)
+{
+  GstMotioncells *filter = gst_motion_cells (trans);
+
+  if (filter->async) {
+    filter->worker = gst_detection_worker_new (GST_ELEMENT (filter),
+        gst_motion_cells_analyse);
+    if (!filter->worker) {
+      GST_ELEMENT_ERROR (filter, RESOURCE, FAILED, (NULL),
+          ("Failed to start the detection thread"));
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_motion_cells_stop (GstBaseTransform * trans)
+{
+  GstMotioncells *filter = gst_motion_cells (trans);
+
+  if (filter->worker) {
+    gst_detection_worker_free (filter->worker);
+    filter->worker = NULL;
+  }
+
+  return TRUE;
+}
+
 /* entry point to initialize the plug-in
  * initialize the plug-in itself
  * register the element factories and other features
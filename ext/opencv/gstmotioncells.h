@@ -93,6 +93,9 @@ struct _GstMotioncells
   //Video width and height are known in "gst_motion_cells_handle_sink_event",
   // but not when setting the "motionmaskcoords".
   gchar has_delayed_mask;
+  gboolean async;
+  guint64 max_latency;
+  struct _GstDetectionWorker *worker;
 };
 
 struct _GstMotioncellsClass
@@ -54,6 +54,10 @@
  * |[
  * gst-launch-1.0 videotestsrc ! decodebin ! videoconvert ! templatematch template=/path/to/file.jpg ! videoconvert ! xvimagesink
  * ]|
+ * |[
+ * gst-launch-1.0 v4l2src ! videoconvert ! templatematch template=/path/to/file.jpg detection-scale=0.5 detection-interval=4 ! videoconvert ! xvimagesink
+ * ]| Match on a half size frame every fourth frame, the position in the
+ * frames in between is extrapolated from the last two matches
  * </refsect2>
  */
 
@@ -64,12 +68,16 @@
 #include "../../gst-libs/gst/gst-i18n-plugin.h"
 #include "gsttemplatematch.h"
 #include <opencv2/imgproc.hpp>
-#include <opencv2/imgcodecs/imgcodecs_c.h>
+#include <opencv2/imgcodecs.hpp>
 
 GST_DEBUG_CATEGORY_STATIC (gst_template_match_debug);
 #define GST_CAT_DEFAULT gst_template_match_debug
 
 #define DEFAULT_METHOD (3)
+#define DEFAULT_DETECTION_SCALE 1.0
+#define DEFAULT_DETECTION_INTERVAL 1
+
+using namespace cv;
 
 /* Filter signals and args */
 enum
@@ -84,6 +92,8 @@ enum
   PROP_METHOD,
   PROP_TEMPLATE,
   PROP_DISPLAY,
+  PROP_DETECTION_SCALE,
+  PROP_DETECTION_INTERVAL
 };
 
 /* the capabilities of the inputs and outputs.
@@ -110,7 +120,7 @@ static void gst_template_match_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_template_match_transform_ip (GstOpencvVideoFilter *
-    filter, GstBuffer * buf, IplImage * img);
+    filter, GstBuffer * buf, Mat & img);
 
 /* initialize the templatematch's class */
 static void
@@ -127,7 +137,8 @@ gst_template_match_class_init (GstTemplateMatchClass * klass)
   gobject_class->set_property = gst_template_match_set_property;
   gobject_class->get_property = gst_template_match_get_property;
 
-  gstopencvbasefilter_class->cv_trans_ip_func = gst_template_match_transform_ip;
+  gstopencvbasefilter_class->cv_trans_ip_mat_func =
+      gst_template_match_transform_ip;
 
   g_object_class_install_property (gobject_class, PROP_METHOD,
       g_param_spec_int ("method", "Method",
@@ -141,6 +152,18 @@ gst_template_match_class_init (GstTemplateMatchClass * klass)
       g_param_spec_boolean ("display", "Display",
           "Sets whether the detected template should be highlighted in the output",
           TRUE, (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  g_object_class_install_property (gobject_class, PROP_DETECTION_SCALE,
+      g_param_spec_double ("detection-scale", "Detection scale",
+          "Scale the frame and the template by this factor before matching. "
+          "Smaller values are faster but less precise", 0.1, 1.0,
+          DEFAULT_DETECTION_SCALE,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  g_object_class_install_property (gobject_class, PROP_DETECTION_INTERVAL,
+      g_param_spec_uint ("detection-interval", "Detection interval",
+          "Match the template only every N frames, the position in the frames "
+          "in between is extrapolated from the last two matches", 1,
+          G_MAXUINT, DEFAULT_DETECTION_INTERVAL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
   gst_element_class_set_static_metadata (element_class,
       "templatematch",
@@ -163,8 +186,12 @@ gst_template_match_init (GstTemplateMatch * filter)
   filter->templ = NULL;
   filter->display = TRUE;
   filter->cvTemplateImage = NULL;
-  filter->cvDistImage = NULL;
+  filter->cvDistImage = new Mat ();
+  filter->cvScaledImage = new Mat ();
+  filter->cvScaledTemplateImage = new Mat ();
   filter->method = DEFAULT_METHOD;
+  filter->detection_scale = DEFAULT_DETECTION_SCALE;
+  filter->detection_interval = DEFAULT_DETECTION_INTERVAL;
 
   gst_opencv_video_filter_set_in_place (GST_OPENCV_VIDEO_FILTER_CAST (filter),
       TRUE);
@@ -175,17 +202,18 @@ static void
 gst_template_match_load_template (GstTemplateMatch * filter, gchar * templ)
 {
   gchar *oldTemplateFilename = NULL;
-  IplImage *oldTemplateImage = NULL, *newTemplateImage = NULL, *oldDistImage =
-      NULL;
+  Mat *oldTemplateImage = NULL, *newTemplateImage = NULL;
 
   if (templ) {
-    newTemplateImage = cvLoadImage (templ, CV_LOAD_IMAGE_COLOR);
-    if (!newTemplateImage) {
+    newTemplateImage = new Mat (imread (templ, IMREAD_COLOR));
+    if (newTemplateImage->empty ()) {
       /* Unfortunately OpenCV doesn't seem to provide any way of finding out
          why the image load failed, so we can't be more specific than FAILED: */
       GST_ELEMENT_WARNING (filter, RESOURCE, FAILED,
           (_("OpenCV failed to load template image")),
           ("While attempting to load template '%s'", templ));
+      delete newTemplateImage;
+      newTemplateImage = NULL;
       g_free (templ);
       templ = NULL;
     }
@@ -196,13 +224,12 @@ gst_template_match_load_template (GstTemplateMatch * filter, gchar * templ)
   filter->templ = templ;
   oldTemplateImage = filter->cvTemplateImage;
   filter->cvTemplateImage = newTemplateImage;
-  oldDistImage = filter->cvDistImage;
-  /* This will be recreated in the chain function as required: */
-  filter->cvDistImage = NULL;
+  /* the scaled template is recreated in the chain function as required */
+  filter->template_scale = 0.0;
+  filter->match_count = 0;
   GST_OBJECT_UNLOCK (filter);
 
-  cvReleaseImage (&oldDistImage);
-  cvReleaseImage (&oldTemplateImage);
+  delete oldTemplateImage;
   g_free (oldTemplateFilename);
 }
 
@@ -245,6 +272,16 @@ gst_template_match_set_property (GObject * object, guint prop_id,
       filter->display = g_value_get_boolean (value);
       GST_OBJECT_UNLOCK (filter);
       break;
+    case PROP_DETECTION_SCALE:
+      GST_OBJECT_LOCK (filter);
+      filter->detection_scale = g_value_get_double (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_DETECTION_INTERVAL:
+      GST_OBJECT_LOCK (filter);
+      filter->detection_interval = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -267,6 +304,12 @@ gst_template_match_get_property (GObject * object, guint prop_id,
     case PROP_DISPLAY:
       g_value_set_boolean (value, filter->display);
       break;
+    case PROP_DETECTION_SCALE:
+      g_value_set_double (value, filter->detection_scale);
+      break;
+    case PROP_DETECTION_INTERVAL:
+      g_value_set_uint (value, filter->detection_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -283,24 +326,22 @@ gst_template_match_finalize (GObject * object)
 
   g_free (filter->templ);
 
-  if (filter->cvDistImage) {
-    cvReleaseImage (&filter->cvDistImage);
-  }
-  if (filter->cvTemplateImage) {
-    cvReleaseImage (&filter->cvTemplateImage);
-  }
+  delete filter->cvDistImage;
+  delete filter->cvScaledImage;
+  delete filter->cvScaledTemplateImage;
+  delete filter->cvTemplateImage;
 
   G_OBJECT_CLASS (gst_template_match_parent_class)->finalize (object);
 }
 
 static void
-gst_template_match_match (IplImage * input, IplImage * templ,
-    IplImage * dist_image, double *best_res, CvPoint * best_pos, int method)
+gst_template_match_match (Mat & input, Mat & templ, Mat & dist_image,
+    double *best_res, Point * best_pos, int method)
 {
   double dist_min = 0, dist_max = 0;
-  CvPoint min_pos, max_pos;
-  cvMatchTemplate (input, templ, dist_image, method);
-  cvMinMaxLoc (dist_image, &dist_min, &dist_max, &min_pos, &max_pos, NULL);
+  Point min_pos, max_pos;
+  matchTemplate (input, templ, dist_image, method);
+  minMaxLoc (dist_image, &dist_min, &dist_max, &min_pos, &max_pos);
   if ((CV_TM_SQDIFF_NORMED == method) || (CV_TM_SQDIFF == method)) {
     *best_res = dist_min;
     *best_pos = min_pos;
@@ -313,15 +354,49 @@ gst_template_match_match (IplImage * input, IplImage * templ,
   }
 }
 
+/* Matches on a downscaled copy of the frame and the template, the returned
+ * position is in frame coordinates */
+static void
+gst_template_match_match_scaled (GstTemplateMatch * filter, Mat & img,
+    double *best_res, Point * best_pos)
+{
+  gdouble scale = filter->detection_scale;
+  Mat & templ = *filter->cvScaledTemplateImage;
+
+  if (filter->template_scale != scale) {
+    resize (*filter->cvTemplateImage, templ,
+        Size (MAX (1, cvRound (filter->cvTemplateImage->cols * scale)),
+            MAX (1, cvRound (filter->cvTemplateImage->rows * scale))), 0, 0,
+        INTER_AREA);
+    filter->template_scale = scale;
+  }
+  resize (img, *filter->cvScaledImage, Size (), scale, scale, INTER_AREA);
+
+  if (templ.cols > filter->cvScaledImage->cols
+      || templ.rows > filter->cvScaledImage->rows) {
+    /* rounding made the template too big, match in full size instead */
+    gst_template_match_match (img, *filter->cvTemplateImage,
+        *filter->cvDistImage, best_res, best_pos, filter->method);
+    return;
+  }
+
+  gst_template_match_match (*filter->cvScaledImage, templ,
+      *filter->cvDistImage, best_res, best_pos, filter->method);
+  best_pos->x = MIN (cvRound (best_pos->x / scale),
+      img.cols - filter->cvTemplateImage->cols);
+  best_pos->y = MIN (cvRound (best_pos->y / scale),
+      img.rows - filter->cvTemplateImage->rows);
+}
+
 /* chain function
  * this function does the actual processing
  */
 static GstFlowReturn
 gst_template_match_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
-    IplImage * img)
+    Mat & img)
 {
   GstTemplateMatch *filter;
-  CvPoint best_pos;
+  Point best_pos;
   double best_res;
   GstMessage *m = NULL;
 
@@ -330,62 +405,74 @@ gst_template_match_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
   GST_LOG_OBJECT (filter, "Buffer size %u", (guint) gst_buffer_get_size (buf));
 
   GST_OBJECT_LOCK (filter);
-  if (filter->cvTemplateImage && !filter->cvDistImage) {
-    if (filter->cvTemplateImage->width > img->width) {
+  if (filter->cvTemplateImage) {
+    if (filter->cvTemplateImage->cols > img.cols) {
       GST_WARNING ("Template Image is wider than input image");
-    } else if (filter->cvTemplateImage->height > img->height) {
+    } else if (filter->cvTemplateImage->rows > img.rows) {
       GST_WARNING ("Template Image is taller than input image");
     } else {
-
-      GST_DEBUG_OBJECT (filter, "cvCreateImage (Size(%d-%d+1,%d) %d, %d)",
-          img->width, filter->cvTemplateImage->width,
-          img->height - filter->cvTemplateImage->height + 1, IPL_DEPTH_32F, 1);
-      filter->cvDistImage =
-          cvCreateImage (cvSize (img->width -
-              filter->cvTemplateImage->width + 1,
-              img->height - filter->cvTemplateImage->height + 1),
-          IPL_DEPTH_32F, 1);
-      if (!filter->cvDistImage) {
-        GST_WARNING ("Couldn't create dist image.");
-      }
-    }
-  }
-  if (filter->cvTemplateImage && filter->cvDistImage) {
-    GstStructure *s;
-
-    gst_template_match_match (img, filter->cvTemplateImage,
-        filter->cvDistImage, &best_res, &best_pos, filter->method);
-
-    s = gst_structure_new ("template_match",
-        "x", G_TYPE_UINT, best_pos.x,
-        "y", G_TYPE_UINT, best_pos.y,
-        "width", G_TYPE_UINT, filter->cvTemplateImage->width,
-        "height", G_TYPE_UINT, filter->cvTemplateImage->height,
-        "result", G_TYPE_DOUBLE, best_res, NULL);
-
-    m = gst_message_new_element (GST_OBJECT (filter), s);
-
-    if (filter->display) {
-      CvPoint corner = best_pos;
-      CvScalar color;
-      if (filter->method == CV_TM_SQDIFF_NORMED
-          || filter->method == CV_TM_CCORR_NORMED
-          || filter->method == CV_TM_CCOEFF_NORMED) {
-        /* Yellow growing redder as match certainty approaches 1.0.  This can
-           only be applied with method == *_NORMED as the other match methods
-           aren't normalized to be in range 0.0 - 1.0 */
-        color = CV_RGB (255, 255 - pow (255, best_res), 32);
+      GstStructure *s;
+      guint64 frame = filter->frame_count++;
+
+      if (filter->match_count == 0
+          || frame % filter->detection_interval == 0) {
+        if (filter->detection_scale < 1.0)
+          gst_template_match_match_scaled (filter, img, &best_res, &best_pos);
+        else
+          gst_template_match_match (img, *filter->cvTemplateImage,
+              *filter->cvDistImage, &best_res, &best_pos, filter->method);
+
+        filter->prev_pos = filter->last_pos;
+        filter->prev_match_frame = filter->last_match_frame;
+        filter->last_pos = best_pos;
+        filter->last_match_frame = frame;
+        filter->last_res = best_res;
+        filter->match_count++;
       } else {
-        color = CV_RGB (255, 32, 32);
+        best_pos = filter->last_pos;
+        best_res = filter->last_res;
+
+        if (filter->match_count > 1) {
+          gdouble f = (gdouble) (frame - filter->last_match_frame) /
+              (filter->last_match_frame - filter->prev_match_frame);
+
+          best_pos.x += cvRound ((filter->last_pos.x - filter->prev_pos.x) * f);
+          best_pos.y += cvRound ((filter->last_pos.y - filter->prev_pos.y) * f);
+          best_pos.x = CLAMP (best_pos.x, 0,
+              img.cols - filter->cvTemplateImage->cols);
+          best_pos.y = CLAMP (best_pos.y, 0,
+              img.rows - filter->cvTemplateImage->rows);
+        }
       }
 
-      buf = gst_buffer_make_writable (buf);
-
-      corner.x += filter->cvTemplateImage->width;
-      corner.y += filter->cvTemplateImage->height;
-      cvRectangle (img, best_pos, corner, color, 3, 8, 0);
+      s = gst_structure_new ("template_match",
+          "x", G_TYPE_UINT, best_pos.x,
+          "y", G_TYPE_UINT, best_pos.y,
+          "width", G_TYPE_UINT, filter->cvTemplateImage->cols,
+          "height", G_TYPE_UINT, filter->cvTemplateImage->rows,
+          "result", G_TYPE_DOUBLE, best_res, NULL);
+
+      m = gst_message_new_element (GST_OBJECT (filter), s);
+
+      if (filter->display) {
+        Point corner = best_pos;
+        Scalar color;
+        if (filter->method == CV_TM_SQDIFF_NORMED
+            || filter->method == CV_TM_CCORR_NORMED
+            || filter->method == CV_TM_CCOEFF_NORMED) {
+          /* Yellow growing redder as match certainty approaches 1.0.  This can
+             only be applied with method == *_NORMED as the other match methods
+             aren't normalized to be in range 0.0 - 1.0 */
+          color = Scalar (32, 255 - pow (255, best_res), 255);
+        } else {
+          color = Scalar (32, 32, 255);
+        }
+
+        corner.x += filter->cvTemplateImage->cols;
+        corner.y += filter->cvTemplateImage->rows;
+        rectangle (img, best_pos, corner, color, 3, 8, 0);
+      }
     }
-
   }
   GST_OBJECT_UNLOCK (filter);
 
@@ -47,6 +47,7 @@
 #define __GST_TEMPLATE_MATCH_H__
 
 #include <gst/opencv/gstopencvvideofilter.h>
+#include <opencv2/core.hpp>
 
 G_BEGIN_DECLS
 /* #defines don't like whitespacey bits */
@@ -70,9 +71,22 @@ struct _GstTemplateMatch
   gint method;
   gboolean display;
 
+  gdouble detection_scale;
+  guint detection_interval;
+
   gchar *templ;
 
-  IplImage *cvGray, *cvTemplateImage, *cvDistImage;
+  cv::Mat *cvTemplateImage, *cvDistImage;
+  /* downscaled frame and template when detection_scale < 1.0 */
+  cv::Mat *cvScaledImage, *cvScaledTemplateImage;
+  gdouble template_scale;
+
+  /* the last two matches, positions in between are extrapolated from them */
+  guint64 frame_count;
+  guint match_count;
+  guint64 last_match_frame, prev_match_frame;
+  cv::Point last_pos, prev_pos;
+  gdouble last_res;
 };
 
 struct _GstTemplateMatchClass
@@ -82,7 +82,7 @@ motion_cells_init ()
 }
 
 int
-perform_detection_motion_cells (IplImage * p_image, double p_sensitivity,
+perform_detection_motion_cells (cv::Mat & p_image, double p_sensitivity,
     double p_framerate, int p_gridx, int p_gridy, long int p_timestamp_millisec,
     bool p_isVisible, bool p_useAlpha, int motionmaskcoord_count,
     motionmaskcoordrect * motionmaskcoords, int motionmaskcells_count,
@@ -105,7 +105,7 @@ perform_detection_motion_cells (IplImage * p_image, double p_sensitivity,
 
 
 void
-setPrevFrame (IplImage * p_prevFrame, int p_id)
+setPrevFrame (cv::Mat & p_prevFrame, int p_id)
 {
   int idx = 0;
   idx = searchIdx (p_id);
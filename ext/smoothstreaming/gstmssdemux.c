@@ -147,6 +147,9 @@ static GstFlowReturn gst_mss_demux_data_received (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream, GstBuffer * buffer);
 static gboolean
 gst_mss_demux_requires_periodical_playlist_update (GstAdaptiveDemux * demux);
+static GstFlowReturn gst_mss_demux_finish_fragment (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream);
+static void gst_mss_demux_stream_free (GstAdaptiveDemuxStream * stream);
 
 static void
 gst_mss_demux_class_init (GstMssDemuxClass * klass)
@@ -206,6 +209,8 @@ gst_mss_demux_class_init (GstMssDemuxClass * klass)
   gstadaptivedemux_class->get_live_seek_range =
       gst_mss_demux_get_live_seek_range;
   gstadaptivedemux_class->data_received = gst_mss_demux_data_received;
+  gstadaptivedemux_class->finish_fragment = gst_mss_demux_finish_fragment;
+  gstadaptivedemux_class->stream_free = gst_mss_demux_stream_free;
   gstadaptivedemux_class->requires_periodical_playlist_update =
       gst_mss_demux_requires_periodical_playlist_update;
 
@@ -308,6 +313,11 @@ gst_mss_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream)
   gst_adaptive_demux_stream_fragment_clear (&stream->fragment);
   ret = gst_mss_stream_get_fragment_url (mssstream->manifest_stream, &path);
 
+  gst_adapter_clear (mssstream->adapter);
+  gst_mss_fragment_parser_clear (&mssstream->fragment_parser);
+  gst_mss_fragment_parser_init (&mssstream->fragment_parser);
+  mssstream->sync_sample_end = 0;
+
   if (ret == GST_FLOW_OK) {
     stream->fragment.uri = g_strdup_printf ("%s/%s", mssdemux->base_url, path);
     stream->fragment.timestamp =
@@ -328,18 +338,57 @@ gst_mss_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
 
   gst_mss_stream_seek (mssstream->manifest_stream, forward, flags, ts,
       final_ts);
+  mssstream->average_download_time = GST_CLOCK_TIME_NONE;
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_mss_demux_stream_in_key_unit_trickmode (GstAdaptiveDemuxStream * stream)
+{
+  GstMssDemuxStream *mssstream = (GstMssDemuxStream *) stream;
+
+  return GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (stream->demux) &&
+      gst_mss_stream_get_type (mssstream->manifest_stream) ==
+      MSS_STREAM_TYPE_VIDEO;
+}
+
+/* In key unit trick mode only one keyframe per fragment is shown, so at
+ * high rates skip the fragments that could not be downloaded in time: the
+ * next one has to start at least one download time (scaled by the rate)
+ * after the current one. */
 static GstFlowReturn
 gst_mss_demux_stream_advance_fragment (GstAdaptiveDemuxStream * stream)
 {
   GstMssDemuxStream *mssstream = (GstMssDemuxStream *) stream;
+  GstClockTime distance = 0, skipped = 0;
+  GstFlowReturn ret;
 
-  if (stream->demux->segment.rate >= 0)
-    return gst_mss_stream_advance_fragment (mssstream->manifest_stream);
-  else
-    return gst_mss_stream_regress_fragment (mssstream->manifest_stream);
+  if (gst_mss_demux_stream_in_key_unit_trickmode (stream)) {
+    if (GST_CLOCK_TIME_IS_VALID (stream->last_download_time)) {
+      if (GST_CLOCK_TIME_IS_VALID (mssstream->average_download_time))
+        mssstream->average_download_time =
+            (3 * mssstream->average_download_time +
+            stream->last_download_time) / 4;
+      else
+        mssstream->average_download_time = stream->last_download_time;
+    }
+
+    if (GST_CLOCK_TIME_IS_VALID (mssstream->average_download_time))
+      distance = ABS (stream->demux->segment.rate) *
+          mssstream->average_download_time;
+  }
+
+  do {
+    skipped +=
+        gst_mss_stream_get_fragment_gst_duration (mssstream->manifest_stream);
+
+    if (stream->demux->segment.rate >= 0)
+      ret = gst_mss_stream_advance_fragment (mssstream->manifest_stream);
+    else
+      ret = gst_mss_stream_regress_fragment (mssstream->manifest_stream);
+  } while (ret == GST_FLOW_OK && skipped < distance);
+
+  return ret;
 }
 
 static GstCaps *
@@ -455,6 +504,9 @@ gst_mss_demux_setup_streams (GstAdaptiveDemux * demux)
         gst_adaptive_demux_stream_new (GST_ADAPTIVE_DEMUX_CAST (mssdemux),
         srcpad);
     stream->manifest_stream = manifeststream;
+    stream->adapter = gst_adapter_new ();
+    gst_mss_fragment_parser_init (&stream->fragment_parser);
+    stream->average_download_time = GST_CLOCK_TIME_NONE;
     gst_mss_stream_set_active (manifeststream, TRUE);
     active_streams = g_slist_prepend (active_streams, stream);
   }
@@ -691,20 +743,78 @@ gst_mss_demux_get_live_seek_range (GstAdaptiveDemux * demux, gint64 * start,
   return gst_mss_manifest_get_live_seek_range (mssdemux->manifest, start, stop);
 }
 
+/* Collects the start of the fragment until the moof and the first sample
+ * are complete, pushes them and stops the download of the rest */
 static GstFlowReturn
-gst_mss_demux_data_received (GstAdaptiveDemux * demux,
+gst_mss_demux_stream_push_sync_sample (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream, GstBuffer * buffer)
 {
-  GstMssDemux *mssdemux = GST_MSS_DEMUX_CAST (demux);
   GstMssDemuxStream *mssstream = (GstMssDemuxStream *) stream;
+  GstFlowReturn ret;
   gsize available;
 
-  if (!gst_mss_manifest_is_live (mssdemux->manifest)) {
+  if (mssstream->sync_sample_end == G_MAXUINT64)
     return GST_ADAPTIVE_DEMUX_CLASS (parent_class)->data_received (demux,
         stream, buffer);
+
+  gst_adapter_push (mssstream->adapter, buffer);
+  available = gst_adapter_available (mssstream->adapter);
+
+  if (mssstream->sync_sample_end == 0) {
+    if (!gst_mss_fragment_parser_add_adapter (&mssstream->fragment_parser,
+            mssstream->adapter)) {
+      GST_DEBUG_OBJECT (stream->pad,
+          "Failed to parse the fragment, downloading all of it");
+      mssstream->sync_sample_end = G_MAXUINT64;
+      return GST_ADAPTIVE_DEMUX_CLASS (parent_class)->data_received (demux,
+          stream, gst_adapter_take_buffer (mssstream->adapter, available));
+    }
+
+    /* The moof isn't complete yet */
+    if (mssstream->fragment_parser.status !=
+        GST_MSS_FRAGMENT_HEADER_PARSER_FINISHED)
+      return GST_FLOW_OK;
+
+    if (!gst_mss_fragment_parser_get_sync_sample_end
+        (&mssstream->fragment_parser, &mssstream->sync_sample_end)) {
+      GST_DEBUG_OBJECT (stream->pad,
+          "Can't locate the sync sample, downloading the whole fragment");
+      mssstream->sync_sample_end = G_MAXUINT64;
+      return GST_ADAPTIVE_DEMUX_CLASS (parent_class)->data_received (demux,
+          stream, gst_adapter_take_buffer (mssstream->adapter, available));
+    }
+
+    GST_LOG_OBJECT (stream->pad, "Sync sample ends at offset %"
+        G_GUINT64_FORMAT, mssstream->sync_sample_end);
   }
 
-  if (gst_mss_stream_fragment_parsing_needed (mssstream->manifest_stream)) {
+  if (available < mssstream->sync_sample_end)
+    return GST_FLOW_OK;
+
+  buffer = gst_adapter_take_buffer (mssstream->adapter,
+      mssstream->sync_sample_end);
+  gst_adapter_clear (mssstream->adapter);
+
+  ret = GST_ADAPTIVE_DEMUX_CLASS (parent_class)->data_received (demux, stream,
+      buffer);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  /* The mdat is cut short, let downstream resync on the next moof */
+  stream->discont = TRUE;
+  return GST_ADAPTIVE_DEMUX_FLOW_END_OF_FRAGMENT;
+}
+
+static GstFlowReturn
+gst_mss_demux_data_received (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstBuffer * buffer)
+{
+  GstMssDemux *mssdemux = GST_MSS_DEMUX_CAST (demux);
+  GstMssDemuxStream *mssstream = (GstMssDemuxStream *) stream;
+  gsize available;
+
+  if (gst_mss_manifest_is_live (mssdemux->manifest) &&
+      gst_mss_stream_fragment_parsing_needed (mssstream->manifest_stream)) {
     gst_mss_manifest_live_adapter_push (mssstream->manifest_stream, buffer);
     available =
         gst_mss_manifest_live_adapter_available (mssstream->manifest_stream);
@@ -720,10 +830,46 @@ gst_mss_demux_data_received (GstAdaptiveDemux * demux,
     }
   }
 
+  if (gst_mss_demux_stream_in_key_unit_trickmode (stream))
+    return gst_mss_demux_stream_push_sync_sample (demux, stream, buffer);
+
   return GST_ADAPTIVE_DEMUX_CLASS (parent_class)->data_received (demux, stream,
       buffer);
 }
 
+static GstFlowReturn
+gst_mss_demux_finish_fragment (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstMssDemuxStream *mssstream = (GstMssDemuxStream *) stream;
+  gsize available = gst_adapter_available (mssstream->adapter);
+  GstFlowReturn ret;
+
+  /* The fragment ended before the sync sample could be located, pass on
+   * what we have */
+  if (available > 0) {
+    ret = GST_ADAPTIVE_DEMUX_CLASS (parent_class)->data_received (demux,
+        stream, gst_adapter_take_buffer (mssstream->adapter, available));
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  return GST_ADAPTIVE_DEMUX_CLASS (parent_class)->finish_fragment (demux,
+      stream);
+}
+
+static void
+gst_mss_demux_stream_free (GstAdaptiveDemuxStream * stream)
+{
+  GstMssDemuxStream *mssstream = (GstMssDemuxStream *) stream;
+
+  if (mssstream->adapter) {
+    g_object_unref (mssstream->adapter);
+    mssstream->adapter = NULL;
+  }
+  gst_mss_fragment_parser_clear (&mssstream->fragment_parser);
+}
+
 static gboolean
 gst_mss_demux_requires_periodical_playlist_update (GstAdaptiveDemux * demux)
 {
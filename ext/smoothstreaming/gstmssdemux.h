@@ -29,6 +29,7 @@
 #include <gst/base/gstdataqueue.h>
 #include <gst/gstprotection.h>
 #include "gstmssmanifest.h"
+#include "gstmssfragmentparser.h"
 
 G_BEGIN_DECLS
 
@@ -56,6 +57,13 @@ struct _GstMssDemuxStream {
   GstAdaptiveDemuxStream parent;
 
   GstMssStream *manifest_stream;
+
+  /* key unit trick mode: only the leading sync sample of each fragment is
+   * downloaded and pushed */
+  GstAdapter *adapter;
+  GstMssFragmentParser fragment_parser;
+  guint64 sync_sample_end;
+  GstClockTime average_download_time;
 };
 
 struct _GstMssDemux {
@@ -42,7 +42,9 @@ gst_mss_fragment_parser_clear (GstMssFragmentParser * parser)
   if (parser->moof)
     gst_isoff_moof_box_free (parser->moof);
   parser->moof = NULL;
+  parser->moof_offset = 0;
   parser->current_fourcc = 0;
+  parser->box_offset = 0;
 }
 
 gboolean
@@ -82,7 +84,11 @@ gst_mss_fragment_parser_add_buffer (GstMssFragmentParser * parser,
       GstByteReader sub_reader;
 
       g_assert (parser->moof == NULL);
-      gst_byte_reader_get_sub_reader (&reader, &sub_reader, size - header_size);
+      /* Not complete yet, wait for more data */
+      if (!gst_byte_reader_get_sub_reader (&reader, &sub_reader,
+              size - header_size))
+        break;
+      parser->moof_offset = gst_byte_reader_get_pos (&reader) - size;
       parser->moof = gst_isoff_moof_box_parse (&sub_reader);
       if (parser->moof == NULL) {
         GST_ERROR ("Failed to parse moof");
@@ -102,17 +108,6 @@ beach:
       parser->moof->traf->len == 0)
     error = TRUE;
 
-  if (!error) {
-    GstTrafBox *traf = &g_array_index (parser->moof->traf, GstTrafBox, 0);
-    if (!traf->tfxd) {
-      GST_ERROR ("no tfxd box");
-      error = TRUE;
-    } else if (!traf->tfrf) {
-      GST_ERROR ("no tfrf box");
-      error = TRUE;
-    }
-  }
-
   if (!error)
     parser->status = GST_MSS_FRAGMENT_HEADER_PARSER_FINISHED;
 
@@ -120,3 +115,146 @@ beach:
   gst_buffer_unmap (buffer, &info);
   return !error;
 }
+
+/* Largest box header: size, type, 64 bit size and uuid extended type */
+#define MAX_BOX_HEADER_SIZE 32
+
+/* Parses the fragment held in @adapter, from its start. Meant to be called
+ * again every time more data was pushed into the adapter: only the box
+ * headers that weren't seen yet are looked at, and the moof is copied out
+ * and parsed once, when it is complete. Returns FALSE on errors, the status
+ * switches to finished once the moof was parsed and the mdat is reached. */
+gboolean
+gst_mss_fragment_parser_add_adapter (GstMssFragmentParser * parser,
+    GstAdapter * adapter)
+{
+  guint8 header[MAX_BOX_HEADER_SIZE];
+  GstByteReader reader;
+  gsize available;
+  guint64 size;
+  guint32 fourcc;
+  guint header_size, n;
+
+  if (parser->status == GST_MSS_FRAGMENT_HEADER_PARSER_FINISHED)
+    return TRUE;
+
+  available = gst_adapter_available (adapter);
+
+  while (parser->box_offset < available) {
+    n = MIN (available - parser->box_offset, MAX_BOX_HEADER_SIZE);
+    gst_adapter_copy (adapter, header, parser->box_offset, n);
+    gst_byte_reader_init (&reader, header, n);
+
+    if (!gst_isoff_parse_box_header (&reader, &fourcc, NULL, &header_size,
+            &size)) {
+      if (n < MAX_BOX_HEADER_SIZE)
+        return TRUE;
+      goto error;
+    }
+
+    parser->current_fourcc = fourcc;
+
+    GST_LOG ("box %" GST_FOURCC_FORMAT " size %" G_GUINT64_FORMAT
+        " at offset %" G_GUINT64_FORMAT, GST_FOURCC_ARGS (fourcc), size,
+        parser->box_offset);
+
+    if (fourcc == GST_ISOFF_FOURCC_MDAT) {
+      /* Do sanity check */
+      if (!parser->moof || parser->moof->traf->len == 0)
+        goto error;
+
+      parser->status = GST_MSS_FRAGMENT_HEADER_PARSER_FINISHED;
+      GST_LOG ("Fragment parsing successful");
+      return TRUE;
+    }
+
+    if (size < header_size)
+      goto error;
+
+    if (fourcc == GST_ISOFF_FOURCC_MOOF) {
+      GstByteReader sub_reader;
+      guint8 *data;
+
+      if (parser->moof != NULL)
+        goto error;
+      /* Not complete yet, wait for more data */
+      if (available - parser->box_offset < size)
+        return TRUE;
+
+      data = g_malloc (size);
+      gst_adapter_copy (adapter, data, parser->box_offset, size);
+      gst_byte_reader_init (&sub_reader, data + header_size,
+          size - header_size);
+      parser->moof = gst_isoff_moof_box_parse (&sub_reader);
+      g_free (data);
+
+      if (parser->moof == NULL) {
+        GST_ERROR ("Failed to parse moof");
+        goto error;
+      }
+      parser->moof_offset = parser->box_offset;
+    }
+
+    parser->box_offset += size;
+  }
+
+  return TRUE;
+
+error:
+  GST_LOG ("Fragment parsing successful: no");
+  return FALSE;
+}
+
+/* Gets the offset, relative to the start of the parsed data, right after the
+ * first sample of the fragment, if that sample is a sync sample. */
+gboolean
+gst_mss_fragment_parser_get_sync_sample_end (GstMssFragmentParser * parser,
+    guint64 * end_offset)
+{
+  GstTrafBox *traf;
+  GstTrunBox *trun;
+  GstTrunSample *sample;
+  guint64 offset;
+  guint32 size, flags;
+
+  if (parser->status != GST_MSS_FRAGMENT_HEADER_PARSER_FINISHED)
+    return FALSE;
+
+  traf = &g_array_index (parser->moof->traf, GstTrafBox, 0);
+  if (traf->trun->len == 0)
+    return FALSE;
+  trun = &g_array_index (traf->trun, GstTrunBox, 0);
+  if (trun->samples->len == 0
+      || !(trun->flags & GST_TRUN_FLAGS_DATA_OFFSET_PRESENT))
+    return FALSE;
+  sample = &g_array_index (trun->samples, GstTrunSample, 0);
+
+  if (traf->tfhd.flags & GST_TFHD_FLAGS_BASE_DATA_OFFSET_PRESENT)
+    offset = traf->tfhd.base_data_offset;
+  else
+    offset = parser->moof_offset;
+  offset += trun->data_offset;
+
+  if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT)
+    size = sample->sample_size;
+  else if (traf->tfhd.flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_SIZE_PRESENT)
+    size = traf->tfhd.default_sample_size;
+  else
+    return FALSE;
+
+  /* Fragments start with a keyframe, unless the flags tell otherwise */
+  if (trun->flags & GST_TRUN_FLAGS_FIRST_SAMPLE_FLAGS_PRESENT)
+    flags = trun->first_sample_flags;
+  else if (trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT)
+    flags = sample->sample_flags;
+  else if (traf->tfhd.flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_FLAGS_PRESENT)
+    flags = traf->tfhd.default_sample_flags;
+  else
+    flags = 0;
+
+  if (GST_ISOFF_SAMPLE_FLAGS_SAMPLE_IS_NON_SYNC_SAMPLE (flags))
+    return FALSE;
+
+  *end_offset = offset + size;
+  return TRUE;
+}
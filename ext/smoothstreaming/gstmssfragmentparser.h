@@ -27,6 +27,7 @@
 #define __GST_MSS_FRAGMENT_PARSER_H__
 
 #include <gst/gst.h>
+#include <gst/base/gstadapter.h>
 #include <gst/isoff/gstisoff.h>
 
 G_BEGIN_DECLS
@@ -41,12 +42,18 @@ typedef struct _GstMssFragmentParser
 {
   GstFragmentHeaderParserStatus status;
   GstMoofBox *moof;
+  guint64 moof_offset;
   guint32 current_fourcc;
+
+  /* offset of the next box header for gst_mss_fragment_parser_add_adapter() */
+  guint64 box_offset;
 } GstMssFragmentParser;
 
 void gst_mss_fragment_parser_init (GstMssFragmentParser * parser);
 void gst_mss_fragment_parser_clear (GstMssFragmentParser * parser);
 gboolean gst_mss_fragment_parser_add_buffer (GstMssFragmentParser * parser, GstBuffer * buf);
+gboolean gst_mss_fragment_parser_add_adapter (GstMssFragmentParser * parser, GstAdapter * adapter);
+gboolean gst_mss_fragment_parser_get_sync_sample_end (GstMssFragmentParser * parser, guint64 * end_offset);
 
 G_END_DECLS
 
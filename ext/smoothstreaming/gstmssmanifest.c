@@ -54,6 +54,8 @@ GST_DEBUG_CATEGORY_EXTERN (mssdemux_debug);
 #define MSS_PROP_TIMESCALE            "TimeScale"
 #define MSS_PROP_URL                  "Url"
 
+/* A run of @repetitions fragments of the same @duration, starting at @time.
+ * Consecutive fragments of the same duration are merged into one run. */
 typedef struct _GstMssStreamFragment
 {
   guint number;
@@ -62,6 +64,8 @@ typedef struct _GstMssStreamFragment
   guint repetitions;
 } GstMssStreamFragment;
 
+#define FRAGMENT_END(f) ((f)->time + (f)->duration * (f)->repetitions)
+
 typedef struct _GstMssStreamQuality
 {
   xmlNodePtr xmlnode;
@@ -80,7 +84,7 @@ struct _GstMssStream
   gboolean has_live_fragments;
   GstAdapter *live_adapter;
 
-  GList *fragments;
+  GArray *fragments;            /* GstMssStreamFragment, sorted by time */
   GList *qualities;
 
   gchar *url;
@@ -89,7 +93,7 @@ struct _GstMssStream
   GstMssFragmentParser fragment_parser;
 
   guint fragment_repetition_index;
-  GList *current_fragment;
+  guint current_fragment;       /* index in fragments, len once over */
   GList *current_quality;
 
   /* TODO move this to somewhere static */
@@ -112,12 +116,39 @@ struct _GstMssManifest
   GSList *streams;
 };
 
+/* Appends a run of fragments, extending the last run instead if it has the
+ * same duration and ends where the new one starts */
+static void
+gst_mss_fragments_append (GArray * fragments, guint number, guint64 time,
+    guint64 duration, guint repetitions)
+{
+  GstMssStreamFragment fragment;
+
+  if (fragments->len > 0) {
+    GstMssStreamFragment *last =
+        &g_array_index (fragments, GstMssStreamFragment, fragments->len - 1);
+
+    if (last->duration == duration && FRAGMENT_END (last) == time) {
+      last->repetitions += repetitions;
+      return;
+    }
+  }
+
+  fragment.number = number;
+  fragment.time = time;
+  fragment.duration = duration;
+  fragment.repetitions = repetitions;
+  g_array_append_val (fragments, fragment);
+}
+
 /* For parsing and building a fragments list */
 typedef struct _GstMssFragmentListBuilder
 {
-  GList *fragments;
+  GArray *fragments;
 
-  GstMssStreamFragment *previous_fragment;
+  /* last fragment, while its duration is unknown */
+  gboolean pending;
+  GstMssStreamFragment previous_fragment;
   guint fragment_number;
   guint64 fragment_time_accum;
 } GstMssFragmentListBuilder;
@@ -125,8 +156,9 @@ typedef struct _GstMssFragmentListBuilder
 static void
 gst_mss_fragment_list_builder_init (GstMssFragmentListBuilder * builder)
 {
-  builder->fragments = NULL;
-  builder->previous_fragment = NULL;
+  builder->fragments =
+      g_array_new (FALSE, FALSE, sizeof (GstMssStreamFragment));
+  builder->pending = FALSE;
   builder->fragment_time_accum = 0;
   builder->fragment_number = 0;
 }
@@ -139,7 +171,7 @@ gst_mss_fragment_list_builder_add (GstMssFragmentListBuilder * builder,
   gchar *time_str;
   gchar *seqnum_str;
   gchar *repetition_str;
-  GstMssStreamFragment *fragment = g_new (GstMssStreamFragment, 1);
+  GstMssStreamFragment fragment;
 
   duration_str = (gchar *) xmlGetProp (node, (xmlChar *) MSS_PROP_DURATION);
   time_str = (gchar *) xmlGetProp (node, (xmlChar *) MSS_PROP_TIME);
@@ -149,54 +181,71 @@ gst_mss_fragment_list_builder_add (GstMssFragmentListBuilder * builder,
 
   /* use the node's seq number or use the previous + 1 */
   if (seqnum_str) {
-    fragment->number = g_ascii_strtoull (seqnum_str, NULL, 10);
+    fragment.number = g_ascii_strtoull (seqnum_str, NULL, 10);
     xmlFree (seqnum_str);
-    builder->fragment_number = fragment->number;
+    builder->fragment_number = fragment.number;
   } else {
-    fragment->number = builder->fragment_number;
+    fragment.number = builder->fragment_number;
   }
-  builder->fragment_number = fragment->number + 1;
+  builder->fragment_number = fragment.number + 1;
 
   if (repetition_str) {
-    fragment->repetitions = g_ascii_strtoull (repetition_str, NULL, 10);
+    fragment.repetitions = g_ascii_strtoull (repetition_str, NULL, 10);
     xmlFree (repetition_str);
   } else {
-    fragment->repetitions = 1;
+    fragment.repetitions = 1;
   }
+  if (fragment.repetitions == 0)
+    fragment.repetitions = 1;
 
   if (time_str) {
-    fragment->time = g_ascii_strtoull (time_str, NULL, 10);
+    fragment.time = g_ascii_strtoull (time_str, NULL, 10);
 
     xmlFree (time_str);
-    builder->fragment_time_accum = fragment->time;
+    builder->fragment_time_accum = fragment.time;
   } else {
-    fragment->time = builder->fragment_time_accum;
+    fragment.time = builder->fragment_time_accum;
   }
 
   /* if we have a previous fragment, means we need to set its duration */
-  if (builder->previous_fragment)
-    builder->previous_fragment->duration =
-        (fragment->time -
-        builder->previous_fragment->time) /
-        builder->previous_fragment->repetitions;
+  if (builder->pending) {
+    GstMssStreamFragment *previous = &builder->previous_fragment;
+
+    previous->duration = (fragment.time - previous->time) /
+        previous->repetitions;
+    gst_mss_fragments_append (builder->fragments, previous->number,
+        previous->time, previous->duration, previous->repetitions);
+    builder->pending = FALSE;
+  }
 
   if (duration_str) {
-    fragment->duration = g_ascii_strtoull (duration_str, NULL, 10);
+    fragment.duration = g_ascii_strtoull (duration_str, NULL, 10);
 
-    builder->previous_fragment = NULL;
-    builder->fragment_time_accum += fragment->duration * fragment->repetitions;
+    builder->fragment_time_accum += fragment.duration * fragment.repetitions;
     xmlFree (duration_str);
+    gst_mss_fragments_append (builder->fragments, fragment.number,
+        fragment.time, fragment.duration, fragment.repetitions);
   } else {
     /* store to set the duration at the next iteration */
     builder->previous_fragment = fragment;
+    builder->pending = TRUE;
   }
 
-  /* we reverse it later */
-  builder->fragments = g_list_prepend (builder->fragments, fragment);
   GST_LOG ("Adding fragment number: %u, time: %" G_GUINT64_FORMAT
       ", duration: %" G_GUINT64_FORMAT ", repetitions: %u",
-      fragment->number, fragment->time, fragment->duration,
-      fragment->repetitions);
+      fragment.number, fragment.time,
+      builder->pending ? G_GUINT64_CONSTANT (0) : fragment.duration,
+      fragment.repetitions);
+}
+
+/* Returns the fragments, the last one without duration is dropped */
+static GArray *
+gst_mss_fragment_list_builder_finish (GstMssFragmentListBuilder * builder)
+{
+  if (builder->pending)
+    GST_WARNING ("Dropping last fragment without duration");
+
+  return builder->fragments;
 }
 
 static GstBuffer *gst_buffer_from_hex_string (const gchar * s);
@@ -284,10 +333,8 @@ _gst_mss_stream_init (GstMssManifest * manifest, GstMssStream * stream,
     stream->live_adapter = gst_adapter_new ();
   }
 
-  if (builder.fragments) {
-    stream->fragments = g_list_reverse (builder.fragments);
-    stream->current_fragment = stream->fragments;
-  }
+  stream->fragments = gst_mss_fragment_list_builder_finish (&builder);
+  stream->current_fragment = 0;
 
   /* order them from smaller to bigger based on bitrates */
   stream->qualities =
@@ -422,7 +469,7 @@ gst_mss_stream_free (GstMssStream * stream)
     g_object_unref (stream->live_adapter);
   }
 
-  g_list_free_full (stream->fragments, g_free);
+  g_array_free (stream->fragments, TRUE);
   g_list_free_full (stream->qualities,
       (GDestroyNotify) gst_mss_stream_quality_free);
   xmlFree (stream->url);
@@ -956,14 +1003,11 @@ gst_mss_manifest_get_duration (GstMssManifest * manifest)
     for (iter = manifest->streams; iter; iter = g_slist_next (iter)) {
       GstMssStream *stream = iter->data;
 
-      if (stream->active) {
-        if (stream->fragments) {
-          GList *l = g_list_last (stream->fragments);
-          GstMssStreamFragment *fragment = (GstMssStreamFragment *) l->data;
-          guint64 frag_dur =
-              fragment->time + fragment->duration * fragment->repetitions;
-          max_dur = MAX (frag_dur, max_dur);
-        }
+      if (stream->active && stream->fragments->len > 0) {
+        GstMssStreamFragment *fragment = &g_array_index (stream->fragments,
+            GstMssStreamFragment, stream->fragments->len - 1);
+
+        max_dur = MAX (FRAGMENT_END (fragment), max_dur);
       }
     }
 
@@ -1034,6 +1078,16 @@ gst_mss_stream_get_caps (GstMssStream * stream)
   return caps;
 }
 
+static GstMssStreamFragment *
+gst_mss_stream_get_current_fragment (GstMssStream * stream)
+{
+  if (stream->current_fragment >= stream->fragments->len)
+    return NULL;
+
+  return &g_array_index (stream->fragments, GstMssStreamFragment,
+      stream->current_fragment);
+}
+
 GstFlowReturn
 gst_mss_stream_get_fragment_url (GstMssStream * stream, gchar ** url)
 {
@@ -1045,11 +1099,10 @@ gst_mss_stream_get_fragment_url (GstMssStream * stream, gchar ** url)
 
   g_return_val_if_fail (stream->active, GST_FLOW_ERROR);
 
-  if (stream->current_fragment == NULL) /* stream is over */
+  fragment = gst_mss_stream_get_current_fragment (stream);
+  if (fragment == NULL)         /* stream is over */
     return GST_FLOW_EOS;
 
-  fragment = stream->current_fragment->data;
-
   time =
       fragment->time + fragment->duration * stream->fragment_repetition_index;
   start_time_str = g_strdup_printf ("%" G_GUINT64_FORMAT, time);
@@ -1077,15 +1130,15 @@ gst_mss_stream_get_fragment_gst_timestamp (GstMssStream * stream)
 
   g_return_val_if_fail (stream->active, GST_CLOCK_TIME_NONE);
 
-  if (!stream->current_fragment) {
-    GList *last = g_list_last (stream->fragments);
-    if (last == NULL)
+  fragment = gst_mss_stream_get_current_fragment (stream);
+  if (fragment == NULL) {
+    if (stream->fragments->len == 0)
       return GST_CLOCK_TIME_NONE;
 
-    fragment = last->data;
-    time = fragment->time + (fragment->duration * fragment->repetitions);
+    fragment = &g_array_index (stream->fragments, GstMssStreamFragment,
+        stream->fragments->len - 1);
+    time = FRAGMENT_END (fragment);
   } else {
-    fragment = stream->current_fragment->data;
     time =
         fragment->time +
         (fragment->duration * stream->fragment_repetition_index);
@@ -1105,11 +1158,10 @@ gst_mss_stream_get_fragment_gst_duration (GstMssStream * stream)
 
   g_return_val_if_fail (stream->active, GST_FLOW_ERROR);
 
-  if (!stream->current_fragment)
+  fragment = gst_mss_stream_get_current_fragment (stream);
+  if (fragment == NULL)
     return GST_CLOCK_TIME_NONE;
 
-  fragment = stream->current_fragment->data;
-
   dur = fragment->duration;
   timescale = gst_mss_stream_get_timescale (stream);
   return (GstClockTime) gst_util_uint64_scale_round (dur, GST_SECOND,
@@ -1121,10 +1173,7 @@ gst_mss_stream_has_next_fragment (GstMssStream * stream)
 {
   g_return_val_if_fail (stream->active, FALSE);
 
-  if (stream->current_fragment == NULL)
-    return FALSE;
-
-  return TRUE;
+  return gst_mss_stream_get_current_fragment (stream) != NULL;
 }
 
 GstFlowReturn
@@ -1136,20 +1185,20 @@ gst_mss_stream_advance_fragment (GstMssStream * stream)
 
   g_return_val_if_fail (stream->active, GST_FLOW_ERROR);
 
-  if (stream->current_fragment == NULL)
+  fragment = gst_mss_stream_get_current_fragment (stream);
+  if (fragment == NULL)
     return GST_FLOW_EOS;
 
-  fragment = stream->current_fragment->data;
   stream->fragment_repetition_index++;
   if (stream->fragment_repetition_index < fragment->repetitions)
     goto beach;
 
   stream->fragment_repetition_index = 0;
-  stream->current_fragment = g_list_next (stream->current_fragment);
+  stream->current_fragment++;
 
   GST_DEBUG ("Advanced to fragment #%d on %s stream", fragment->number,
       stream_type_name);
-  if (stream->current_fragment == NULL)
+  if (stream->current_fragment >= stream->fragments->len)
     return GST_FLOW_EOS;
 
 beach:
@@ -1164,15 +1213,16 @@ gst_mss_stream_regress_fragment (GstMssStream * stream)
   GstMssStreamFragment *fragment;
   g_return_val_if_fail (stream->active, GST_FLOW_ERROR);
 
-  if (stream->current_fragment == NULL)
+  if (gst_mss_stream_get_current_fragment (stream) == NULL)
     return GST_FLOW_EOS;
 
-  fragment = stream->current_fragment->data;
   if (stream->fragment_repetition_index == 0) {
-    stream->current_fragment = g_list_previous (stream->current_fragment);
-    if (stream->current_fragment == NULL)
+    if (stream->current_fragment == 0) {
+      stream->current_fragment = stream->fragments->len;
       return GST_FLOW_EOS;
-    fragment = stream->current_fragment->data;
+    }
+    stream->current_fragment--;
+    fragment = gst_mss_stream_get_current_fragment (stream);
     stream->fragment_repetition_index = fragment->repetitions - 1;
   } else {
     stream->fragment_repetition_index--;
@@ -1224,50 +1274,64 @@ void
 gst_mss_stream_seek (GstMssStream * stream, gboolean forward,
     GstSeekFlags flags, guint64 time, guint64 * final_time)
 {
-  GList *iter;
   guint64 timescale;
   GstMssStreamFragment *fragment = NULL;
+  guint lo, hi;
 
   timescale = gst_mss_stream_get_timescale (stream);
   time = gst_util_uint64_scale_round (time, timescale, GST_SECOND);
 
   GST_DEBUG ("Stream %s seeking to %" G_GUINT64_FORMAT, stream->url, time);
-  for (iter = stream->fragments; iter; iter = g_list_next (iter)) {
-    fragment = iter->data;
-    if (fragment->time + fragment->repetitions * fragment->duration > time) {
-      stream->current_fragment = iter;
+
+  /* find the first run that ends after the target */
+  lo = 0;
+  hi = stream->fragments->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    fragment = &g_array_index (stream->fragments, GstMssStreamFragment, mid);
+    if (FRAGMENT_END (fragment) > time)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  if (lo < stream->fragments->len) {
+    fragment = &g_array_index (stream->fragments, GstMssStreamFragment, lo);
+    stream->current_fragment = lo;
+
+    if (time <= fragment->time) {
+      stream->fragment_repetition_index = 0;
+      /* for reverse playback, start from the previous fragment when we are
+       * exactly at a limit */
+      if (time == fragment->time && !forward)
+        stream->fragment_repetition_index--;
+    } else {
       stream->fragment_repetition_index =
           (time - fragment->time) / fragment->duration;
       if (((time - fragment->time) % fragment->duration) == 0) {
-
-        /* for reverse playback, start from the previous fragment when we are
-         * exactly at a limit */
         if (!forward)
           stream->fragment_repetition_index--;
       } else if (SNAP_AFTER (forward, flags))
         stream->fragment_repetition_index++;
+    }
 
-      if (stream->fragment_repetition_index == fragment->repetitions) {
-        /* move to the next one */
+    if (stream->fragment_repetition_index == fragment->repetitions) {
+      /* move to the next one */
+      stream->fragment_repetition_index = 0;
+      stream->current_fragment++;
+      fragment = gst_mss_stream_get_current_fragment (stream);
+    } else if (stream->fragment_repetition_index == -1) {
+      if (stream->current_fragment > 0) {
+        stream->current_fragment--;
+        fragment = gst_mss_stream_get_current_fragment (stream);
+        stream->fragment_repetition_index = fragment->repetitions - 1;
+      } else {
         stream->fragment_repetition_index = 0;
-        stream->current_fragment = g_list_next (iter);
-        fragment =
-            stream->current_fragment ? stream->current_fragment->data : NULL;
-
-      } else if (stream->fragment_repetition_index == -1) {
-        if (g_list_previous (iter)) {
-          stream->current_fragment = g_list_previous (iter);
-          fragment = stream->current_fragment->data;
-          g_assert (fragment);
-          stream->fragment_repetition_index = fragment->repetitions - 1;
-        } else {
-          stream->fragment_repetition_index = 0;
-        }
       }
-
-      break;
     }
-
+  } else {
+    fragment = NULL;
   }
 
   GST_DEBUG ("Stream %s seeked to fragment time %" G_GUINT64_FORMAT
@@ -1279,11 +1343,13 @@ gst_mss_stream_seek (GstMssStream * stream, gboolean forward,
       *final_time = gst_util_uint64_scale_round (fragment->time +
           stream->fragment_repetition_index * fragment->duration,
           GST_SECOND, timescale);
-    } else {
-      GstMssStreamFragment *last_fragment = g_list_last (iter)->data;
-      *final_time = gst_util_uint64_scale_round (last_fragment->time +
-          last_fragment->repetitions * last_fragment->duration,
+    } else if (stream->fragments->len > 0) {
+      GstMssStreamFragment *last_fragment = &g_array_index (stream->fragments,
+          GstMssStreamFragment, stream->fragments->len - 1);
+      *final_time = gst_util_uint64_scale_round (FRAGMENT_END (last_fragment),
           GST_SECOND, timescale);
+    } else {
+      *final_time = 0;
     }
   }
 }
@@ -1313,20 +1379,100 @@ gst_mss_manifest_is_live (GstMssManifest * manifest)
   return manifest->is_live;
 }
 
+/* Merges the fragments of a refreshed live manifest: the runs that left
+ * the DVR window are dropped and only the fragments after the end of the
+ * current list are appended, so the position in the list is kept without
+ * seeking again */
+static void
+gst_mss_stream_merge_fragments (GstMssStream * stream, GArray * fragments)
+{
+  GstMssStreamFragment *first, *last;
+  guint64 last_end;
+  guint i, removed = 0;
+
+  if (fragments->len == 0)
+    return;
+
+  /* when past the end, point after the last run's fragments instead, as
+   * that run might be extended */
+  if (stream->current_fragment >= stream->fragments->len &&
+      stream->fragments->len > 0) {
+    stream->current_fragment = stream->fragments->len - 1;
+    last = gst_mss_stream_get_current_fragment (stream);
+    stream->fragment_repetition_index = last->repetitions;
+  }
+
+  first = &g_array_index (fragments, GstMssStreamFragment, 0);
+  while (removed < stream->fragments->len &&
+      FRAGMENT_END (&g_array_index (stream->fragments, GstMssStreamFragment,
+                  removed)) <= first->time)
+    removed++;
+
+  if (removed > 0) {
+    g_array_remove_range (stream->fragments, 0, removed);
+    if (stream->current_fragment >= removed) {
+      stream->current_fragment -= removed;
+    } else {
+      GST_DEBUG ("Current fragment left the DVR window");
+      stream->current_fragment = 0;
+      stream->fragment_repetition_index = 0;
+    }
+  }
+
+  if (stream->fragments->len > 0) {
+    last = &g_array_index (stream->fragments, GstMssStreamFragment,
+        stream->fragments->len - 1);
+    last_end = FRAGMENT_END (last);
+  } else {
+    last_end = 0;
+  }
+
+  for (i = 0; i < fragments->len; i++) {
+    GstMssStreamFragment *f =
+        &g_array_index (fragments, GstMssStreamFragment, i);
+    guint64 skip;
+
+    if (FRAGMENT_END (f) <= last_end)
+      continue;
+
+    if (f->time >= last_end) {
+      gst_mss_fragments_append (stream->fragments, f->number, f->time,
+          f->duration, f->repetitions);
+      continue;
+    }
+
+    /* the run was extended since the last refresh */
+    if (f->duration == 0 || (last_end - f->time) % f->duration != 0) {
+      GST_WARNING ("Fragment at %" G_GUINT64_FORMAT " overlaps the known "
+          "ones, ignoring it", f->time);
+      continue;
+    }
+    skip = (last_end - f->time) / f->duration;
+    gst_mss_fragments_append (stream->fragments, f->number + skip, last_end,
+        f->duration, f->repetitions - skip);
+  }
+
+  last = gst_mss_stream_get_current_fragment (stream);
+  if (last && stream->fragment_repetition_index >= last->repetitions) {
+    stream->current_fragment++;
+    stream->fragment_repetition_index = 0;
+  }
+
+  GST_DEBUG ("Dropped %u runs, now %u runs until %" G_GUINT64_FORMAT, removed,
+      stream->fragments->len, stream->fragments->len > 0 ?
+      FRAGMENT_END (&g_array_index (stream->fragments, GstMssStreamFragment,
+              stream->fragments->len - 1)) : G_GUINT64_CONSTANT (0));
+}
+
 static void
 gst_mss_stream_reload_fragments (GstMssStream * stream, xmlNodePtr streamIndex)
 {
   xmlNodePtr iter;
-  guint64 current_gst_time;
   GstMssFragmentListBuilder builder;
-
-  current_gst_time = gst_mss_stream_get_fragment_gst_timestamp (stream);
+  GArray *fragments;
 
   gst_mss_fragment_list_builder_init (&builder);
 
-  GST_DEBUG ("Current position: %" GST_TIME_FORMAT,
-      GST_TIME_ARGS (current_gst_time));
-
   for (iter = streamIndex->children; iter; iter = iter->next) {
     if (node_has_type (iter, MSS_NODE_STREAM_FRAGMENT)) {
       gst_mss_fragment_list_builder_add (&builder, iter);
@@ -1335,15 +1481,9 @@ gst_mss_stream_reload_fragments (GstMssStream * stream, xmlNodePtr streamIndex)
     }
   }
 
-  /* store the new fragments list */
-  if (builder.fragments) {
-    g_list_free_full (stream->fragments, g_free);
-    stream->fragments = g_list_reverse (builder.fragments);
-    stream->current_fragment = stream->fragments;
-    /* TODO Verify how repositioning here works for reverse
-     * playback - it might start from the wrong fragment */
-    gst_mss_stream_seek (stream, TRUE, 0, current_gst_time, NULL);
-  }
+  fragments = gst_mss_fragment_list_builder_finish (&builder);
+  gst_mss_stream_merge_fragments (stream, fragments);
+  g_array_free (fragments, TRUE);
 }
 
 static void
@@ -1530,21 +1670,22 @@ static gboolean
 gst_mss_stream_get_live_seek_range (GstMssStream * stream, gint64 * start,
     gint64 * stop)
 {
-  GList *l;
   GstMssStreamFragment *fragment;
   guint64 timescale = gst_mss_stream_get_timescale (stream);
 
   g_return_val_if_fail (stream->active, FALSE);
 
+  if (stream->fragments->len == 0)
+    return FALSE;
+
   /* XXX: assumes all the data in the stream is still available */
-  l = g_list_first (stream->fragments);
-  fragment = (GstMssStreamFragment *) l->data;
+  fragment = &g_array_index (stream->fragments, GstMssStreamFragment, 0);
   *start = gst_util_uint64_scale_round (fragment->time, GST_SECOND, timescale);
 
-  l = g_list_last (stream->fragments);
-  fragment = (GstMssStreamFragment *) l->data;
-  *stop = gst_util_uint64_scale_round (fragment->time + fragment->duration *
-      fragment->repetitions, GST_SECOND, timescale);
+  fragment = &g_array_index (stream->fragments, GstMssStreamFragment,
+      stream->fragments->len - 1);
+  *stop = gst_util_uint64_scale_round (FRAGMENT_END (fragment), GST_SECOND,
+      timescale);
 
   return TRUE;
 }
@@ -1618,6 +1759,13 @@ gst_mss_stream_parse_fragment (GstMssStream * stream, GstBuffer * buffer)
 
   moof = stream->fragment_parser.moof;
   traf = &g_array_index (moof->traf, GstTrafBox, 0);
+  if (!traf->tfxd) {
+    GST_ERROR ("no tfxd box");
+    return;
+  } else if (!traf->tfrf) {
+    GST_ERROR ("no tfrf box");
+    return;
+  }
 
   stream_type_name =
       gst_mss_stream_type_name (gst_mss_stream_get_type (stream));
@@ -1625,32 +1773,23 @@ gst_mss_stream_parse_fragment (GstMssStream * stream, GstBuffer * buffer)
   for (index = 0; index < traf->tfrf->entries_count; index++) {
     GstTfrfBoxEntry *entry =
         &g_array_index (traf->tfrf->entries, GstTfrfBoxEntry, index);
-    GList *l = g_list_last (stream->fragments);
     GstMssStreamFragment *last;
-    GstMssStreamFragment *fragment;
-    guint64 parsed_time = entry->time;
-    guint64 parsed_duration = entry->duration;
 
-    if (l == NULL)
+    if (stream->fragments->len == 0)
       break;
 
-    last = (GstMssStreamFragment *) l->data;
+    last = &g_array_index (stream->fragments, GstMssStreamFragment,
+        stream->fragments->len - 1);
 
     /* only add the fragment to the list if it's outside the time in the
      * current list */
-    if (last->time >= entry->time)
+    if (FRAGMENT_END (last) > entry->time)
       continue;
 
-    fragment = g_new (GstMssStreamFragment, 1);
-    fragment->number = last->number + 1;
-    fragment->repetitions = 1;
-    fragment->time = parsed_time;
-    fragment->duration = parsed_duration;
-
-    stream->fragments = g_list_append (stream->fragments, fragment);
-    GST_LOG ("Adding fragment number: %u to %s stream, time: %"
-        G_GUINT64_FORMAT ", duration: %" G_GUINT64_FORMAT ", repetitions: %u",
-        fragment->number, stream_type_name, fragment->time,
-        fragment->duration, fragment->repetitions);
+    gst_mss_fragments_append (stream->fragments,
+        last->number + last->repetitions, entry->time, entry->duration, 1);
+    GST_LOG ("Adding fragment to %s stream, time: %" G_GUINT64_FORMAT
+        ", duration: %" G_GUINT64_FORMAT, stream_type_name, entry->time,
+        entry->duration);
   }
 }
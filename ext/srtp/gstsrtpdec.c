@@ -200,6 +200,10 @@ static GstFlowReturn gst_srtp_dec_chain_rtp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
 static GstFlowReturn gst_srtp_dec_chain_rtcp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_srtp_dec_chain_list_rtp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
+static GstFlowReturn gst_srtp_dec_chain_list_rtcp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
 
 static GstStateChangeReturn gst_srtp_dec_change_state (GstElement * element,
     GstStateChange transition);
@@ -363,6 +367,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtp));
   gst_pad_set_chain_function (filter->rtp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtp));
+  gst_pad_set_chain_list_function (filter->rtp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtp));
 
   filter->rtp_srcpad =
       gst_pad_new_from_static_template (&rtp_src_template, "rtp_src");
@@ -386,6 +392,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtcp));
   gst_pad_set_chain_function (filter->rtcp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtcp));
+  gst_pad_set_chain_list_function (filter->rtcp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtcp));
 
   filter->rtcp_srcpad =
       gst_pad_new_from_static_template (&rtcp_src_template, "rtcp_src");
@@ -503,6 +511,7 @@ gst_srtp_dec_remove_stream (GstSrtpDec * filter, guint ssrc)
   if (stream) {
     srtp_remove_stream (filter->session, ssrc);
     g_hash_table_remove (filter->streams, GUINT_TO_POINTER (ssrc));
+    filter->streams_cookie++;
   }
 }
 
@@ -788,6 +797,7 @@ gst_srtp_dec_clear_streams (GstSrtpDec * filter)
 
   if (filter->streams)
     nb = g_hash_table_foreach_remove (filter->streams, remove_yes, NULL);
+  filter->streams_cookie++;
 
   filter->first_session = TRUE;
 
@@ -1136,12 +1146,17 @@ gst_srtp_dec_push_early_events (GstSrtpDec * filter, GstPad * pad,
 }
 
 /*
- * This function should be called while holding the filter lock
+ * This function should be called while holding the filter lock. The lock is
+ * only released when a new key has to be requested.
+ *
+ * The buffer is unprotected in place, @buf_ptr is updated if it had to be
+ * made writable first.
  */
 static gboolean
-gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
-    gboolean is_rtcp, guint32 ssrc)
+gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad,
+    GstBuffer ** buf_ptr, gboolean is_rtcp, guint32 ssrc)
 {
+  GstBuffer *buf = *buf_ptr;
   GstMapInfo map;
   srtp_err_status_t err;
   gint size;
@@ -1151,7 +1166,7 @@ gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
       ssrc);
 
   /* Change buffer to remove protection */
-  buf = gst_buffer_make_writable (buf);
+  buf = *buf_ptr = gst_buffer_make_writable (buf);
 
   gst_buffer_map (buf, &map, GST_MAP_READWRITE);
   size = map.size;
@@ -1192,8 +1207,6 @@ unprotect:
     err = srtp_unprotect (filter->session, map.data, &size);
   }
 
-  GST_OBJECT_UNLOCK (filter);
-
   if (err != srtp_err_status_ok) {
     GST_WARNING_OBJECT (pad,
         "Unable to unprotect buffer (unprotect failed code %d)", err);
@@ -1201,8 +1214,6 @@ unprotect:
     /* Signal user depending on type of error */
     switch (err) {
       case srtp_err_status_key_expired:
-        GST_OBJECT_LOCK (filter);
-
         /* Update stream */
         if (find_stream_by_ssrc (filter, ssrc)) {
           GST_OBJECT_UNLOCK (filter);
@@ -1212,6 +1223,7 @@ unprotect:
           } else {
             GST_WARNING_OBJECT (filter, "Hard limit reached, no new key, "
                 "dropping");
+            GST_OBJECT_LOCK (filter);
           }
         } else {
           GST_WARNING_OBJECT (filter, "Could not find matching stream, "
@@ -1231,7 +1243,6 @@ unprotect:
 
     gst_buffer_unmap (buf, &map);
 
-    GST_OBJECT_LOCK (filter);
     return FALSE;
   }
 
@@ -1239,10 +1250,25 @@ unprotect:
 
   gst_buffer_set_size (buf, size);
 
-  GST_OBJECT_LOCK (filter);
   return TRUE;
 }
 
+static GstPad *
+gst_srtp_dec_get_output_pad (GstSrtpDec * filter, gboolean is_rtcp)
+{
+  if (is_rtcp) {
+    if (!filter->rtcp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
+          filter->rtp_srcpad, TRUE);
+    return filter->rtcp_srcpad;
+  } else {
+    if (!filter->rtp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
+          filter->rtcp_srcpad, FALSE);
+    return filter->rtp_srcpad;
+  }
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     gboolean is_rtcp)
@@ -1268,7 +1294,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     goto push_out;
   }
 
-  if (!gst_srtp_dec_decode_buffer (filter, pad, buf, is_rtcp, ssrc)) {
+  if (!gst_srtp_dec_decode_buffer (filter, pad, &buf, is_rtcp, ssrc)) {
     GST_OBJECT_UNLOCK (filter);
     goto drop_buffer;
   }
@@ -1281,17 +1307,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
 push_out:
   /* Push buffer to source pad */
-  if (is_rtcp) {
-    otherpad = filter->rtcp_srcpad;
-    if (!filter->rtcp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
-          filter->rtp_srcpad, TRUE);
-  } else {
-    otherpad = filter->rtp_srcpad;
-    if (!filter->rtp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
-          filter->rtcp_srcpad, FALSE);
-  }
+  otherpad = gst_srtp_dec_get_output_pad (filter, is_rtcp);
   ret = gst_pad_push (otherpad, buf);
 
   return ret;
@@ -1304,6 +1320,159 @@ drop_buffer:
   return ret;
 }
 
+typedef struct
+{
+  GstSrtpDec *filter;
+  GstPad *pad;
+  gboolean is_rtcp;
+
+  /* stream of the previous packet, valid as long as the streams_cookie
+   * didn't change */
+  GstSrtpDecSsrcStream *stream;
+  guint32 ssrc;
+  gboolean stream_is_rtcp;
+  guint streams_cookie;
+
+  /* SSRCs that reached the soft limit, signalled once the list is done */
+  GArray *soft_limit_ssrcs;
+  /* packets of the other kind than the pad (e.g. muxed RTCP), they go out
+   * on the other source pad */
+  GstBufferList *other_list;
+} DecodeBufferItData;
+
+/* Quick look at the RTP header without a full gst_rtp_buffer_map(), only
+ * used to check whether a packet belongs to the same stream as the previous
+ * one in a list */
+static gboolean
+peek_rtp_ssrc (GstBuffer * buf, guint32 * ssrc)
+{
+  guint8 header[12];
+  guint8 pt;
+
+  if (gst_buffer_extract (buf, 0, header, 12) != 12)
+    return FALSE;
+
+  if ((header[0] >> 6) != 2)
+    return FALSE;
+
+  pt = header[1] & 0x7f;
+  if (pt >= 64 && pt <= 80)
+    return FALSE;
+
+  *ssrc = GST_READ_UINT32_BE (&header[8]);
+  return TRUE;
+}
+
+static gboolean
+decode_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
+{
+  DecodeBufferItData *data = user_data;
+  GstSrtpDec *filter = data->filter;
+  GstSrtpDecSsrcStream *stream;
+  gboolean is_rtcp = data->is_rtcp;
+  guint32 ssrc = 0;
+
+  if (data->stream && data->streams_cookie == filter->streams_cookie &&
+      !data->stream_is_rtcp && peek_rtp_ssrc (*buffer, &ssrc) &&
+      ssrc == data->ssrc) {
+    stream = data->stream;
+    is_rtcp = FALSE;
+  } else if ((stream = validate_buffer (filter, *buffer, &ssrc, &is_rtcp))) {
+    data->stream = stream;
+    data->ssrc = ssrc;
+    data->stream_is_rtcp = is_rtcp;
+    data->streams_cookie = filter->streams_cookie;
+  } else {
+    GST_WARNING_OBJECT (filter, "Invalid buffer, dropping");
+    gst_buffer_unref (*buffer);
+    *buffer = NULL;
+    return TRUE;
+  }
+
+  if (STREAM_HAS_CRYPTO (stream)) {
+    if (!gst_srtp_dec_decode_buffer (filter, data->pad, buffer, is_rtcp,
+            ssrc)) {
+      gst_buffer_unref (*buffer);
+      *buffer = NULL;
+      return TRUE;
+    }
+
+    if (gst_srtp_get_soft_limit_reached ()) {
+      guint i;
+
+      /* signal each stream only once per list */
+      for (i = 0; i < data->soft_limit_ssrcs->len; i++) {
+        if (g_array_index (data->soft_limit_ssrcs, guint32, i) == ssrc)
+          break;
+      }
+      if (i == data->soft_limit_ssrcs->len)
+        g_array_append_val (data->soft_limit_ssrcs, ssrc);
+    }
+  }
+
+  if (is_rtcp != data->is_rtcp) {
+    if (!data->other_list)
+      data->other_list = gst_buffer_list_new ();
+    gst_buffer_list_add (data->other_list, *buffer);
+    *buffer = NULL;
+  }
+
+  return TRUE;
+}
+
+/* Unprotects all the packets of the list in place while holding the lock
+ * only once, and pushes them out as a list again */
+static GstFlowReturn
+gst_srtp_dec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list, gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
+  GstFlowReturn ret = GST_FLOW_OK, other_ret = GST_FLOW_OK;
+  DecodeBufferItData data = { 0, };
+  GstPad *otherpad;
+  guint i;
+
+  GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
+      gst_buffer_list_length (buf_list));
+
+  buf_list = gst_buffer_list_make_writable (buf_list);
+
+  data.filter = filter;
+  data.pad = pad;
+  data.is_rtcp = is_rtcp;
+  data.soft_limit_ssrcs = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  GST_OBJECT_LOCK (filter);
+  gst_buffer_list_foreach (buf_list, decode_buffer_it, &data);
+  GST_OBJECT_UNLOCK (filter);
+
+  /* If all is well, we may have reached soft limit */
+  for (i = 0; i < data.soft_limit_ssrcs->len; i++)
+    request_key_with_signal (filter,
+        g_array_index (data.soft_limit_ssrcs, guint32, i), SIGNAL_SOFT_LIMIT);
+  g_array_free (data.soft_limit_ssrcs, TRUE);
+
+  if (data.other_list) {
+    otherpad = gst_srtp_dec_get_output_pad (filter, !is_rtcp);
+    other_ret = gst_pad_push_list (otherpad, data.other_list);
+  }
+
+  if (gst_buffer_list_length (buf_list) == 0) {
+    gst_buffer_list_unref (buf_list);
+    return other_ret;
+  }
+
+  otherpad = gst_srtp_dec_get_output_pad (filter, is_rtcp);
+  ret = gst_pad_push_list (otherpad, buf_list);
+
+  /* like gst_srtp_dec_chain() would have for the buffer that went out on
+   * the other pad, report its flow return if the list went out fine */
+  if (ret == GST_FLOW_OK)
+    ret = other_ret;
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain_rtp (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -1316,6 +1485,20 @@ gst_srtp_dec_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return gst_srtp_dec_chain (pad, parent, buf, TRUE);
 }
 
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, FALSE);
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtcp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, TRUE);
+}
+
 static GstStateChangeReturn
 gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
 {
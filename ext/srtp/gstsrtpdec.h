@@ -79,6 +79,8 @@ struct _GstSrtpDec
   srtp_t session;
   gboolean first_session;
   GHashTable *streams;
+  /* incremented whenever a stream is freed */
+  guint streams_cookie;
 
   gboolean rtp_has_segment;
   gboolean rtcp_has_segment;
@@ -133,6 +133,9 @@ GST_DEBUG_CATEGORY_STATIC (gst_srtp_enc_debug);
       filter->rtp_auth != GST_SRTP_AUTH_NULL ||                           \
       filter->rtcp_auth != GST_SRTP_AUTH_NULL)
 
+/* Room needed after the packet data for the authentication tag and MKI */
+#define SRTP_TRAILER_SPACE (SRTP_MAX_TRAILER_LEN + 10)
+
 /* Filter signals and args */
 enum
 {
@@ -159,8 +162,7 @@ typedef struct ProcessBufferItData
 {
   GstSrtpEnc *filter;
   GstPad *pad;
-  GstBufferList *out_list;
-  GstFlowReturn flowret;
+  srtp_err_status_t err;
   gboolean is_rtcp;
 } ProcessBufferItData;
 
@@ -908,6 +910,28 @@ gst_srtp_enc_sink_query (GstPad * pad, GstObject * parent, GstQuery * query,
 
       return TRUE;
     }
+    case GST_QUERY_ALLOCATION:
+    {
+      GstAllocator *allocator = NULL;
+      GstAllocationParams params;
+
+      gst_pad_query_default (pad, parent, query);
+
+      /* Ask for room after the data so buffers can be protected in place */
+      if (gst_query_get_n_allocation_params (query) > 0) {
+        gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
+        params.padding = MAX (params.padding, SRTP_TRAILER_SPACE);
+        gst_query_set_nth_allocation_param (query, 0, allocator, &params);
+        if (allocator)
+          gst_object_unref (allocator);
+      } else {
+        gst_allocation_params_init (&params);
+        params.padding = SRTP_TRAILER_SPACE;
+        gst_query_add_allocation_param (query, NULL, &params);
+      }
+
+      return TRUE;
+    }
     default:
       return gst_pad_query_default (pad, parent, query);
   }
@@ -1030,34 +1054,56 @@ gst_srtp_enc_check_set_caps (GstSrtpEnc * filter, GstPad * pad,
   return GST_FLOW_OK;
 }
 
-static GstFlowReturn
-gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
-    GstBuffer * buf, gboolean is_rtcp, GstBuffer ** outbuf_ptr)
+/* Returns TRUE if @buf can be protected without copying: it must be ours
+ * only, consist of a single writable memory and have enough room after the
+ * data for the SRTP trailer */
+static gboolean
+gst_srtp_enc_can_protect_in_place (GstBuffer * buf)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint size_max, size;
-  GstBuffer *bufout = NULL;
-  GstMapInfo mapout;
-  srtp_err_status_t err;
+  GstMemory *mem;
+  gsize size, offset, maxsize;
 
-  /* Create a bigger buffer to add protection */
-  size = gst_buffer_get_size (buf);
-  size_max = size + SRTP_MAX_TRAILER_LEN + 10;
-  bufout = gst_buffer_new_allocate (NULL, size_max, NULL);
+  if (!gst_buffer_is_writable (buf) || gst_buffer_n_memory (buf) != 1)
+    return FALSE;
 
-  gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  if (!gst_buffer_is_memory_range_writable (buf, 0, 1))
+    return FALSE;
 
-  gst_buffer_extract (buf, 0, mapout.data, size);
+  mem = gst_buffer_peek_memory (buf, 0);
+  if (GST_MEMORY_IS_READONLY (mem))
+    return FALSE;
 
-  GST_OBJECT_LOCK (filter);
+  size = gst_memory_get_sizes (mem, &offset, &maxsize);
 
-  gst_srtp_init_event_reporter ();
+  return maxsize - offset - size >= SRTP_TRAILER_SPACE;
+}
 
-  if (filter->session == NULL) {
-    /* The rtcp session disappeared (element shutting down) */
-    GST_OBJECT_UNLOCK (filter);
-    ret = GST_FLOW_FLUSHING;
-    goto fail;
+/* Protects @buf and returns the protected buffer in @outbuf_ptr, re-using the
+ * memory of @buf when possible. @buf is consumed in all cases.
+ *
+ * Must be called with the object lock held and a valid session */
+static srtp_err_status_t
+gst_srtp_enc_protect_buffer (GstSrtpEnc * filter, GstPad * pad,
+    GstBuffer * buf, gboolean is_rtcp, GstBuffer ** outbuf_ptr)
+{
+  GstBuffer *bufout;
+  GstMapInfo mapout;
+  srtp_err_status_t err;
+  gint size;
+
+  size = gst_buffer_get_size (buf);
+
+  if (gst_srtp_enc_can_protect_in_place (buf)) {
+    bufout = buf;
+    gst_buffer_set_size (bufout, size + SRTP_TRAILER_SPACE);
+    gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  } else {
+    /* Create a bigger buffer to add protection */
+    bufout = gst_buffer_new_allocate (NULL, size + SRTP_TRAILER_SPACE, NULL);
+    gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+    gst_buffer_extract (buf, 0, mapout.data, size);
+    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+    gst_buffer_unref (buf);
   }
 
   if (is_rtcp)
@@ -1065,40 +1111,55 @@ gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
   else
     err = srtp_protect (filter->session, mapout.data, &size);
 
-  GST_OBJECT_UNLOCK (filter);
-
   gst_buffer_unmap (bufout, &mapout);
 
-  if (err == srtp_err_status_ok) {
-    /* Buffer protected */
-    gst_buffer_set_size (bufout, size);
-    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+  if (err != srtp_err_status_ok) {
+    gst_buffer_unref (bufout);
+    *outbuf_ptr = NULL;
+    return err;
+  }
+
+  /* Buffer protected */
+  gst_buffer_set_size (bufout, size);
 
-    GST_LOG_OBJECT (pad, "Encoding %s buffer of size %d",
-        is_rtcp ? "RTCP" : "RTP", size);
+  GST_LOG_OBJECT (pad, "Encoding %s buffer of size %d%s",
+      is_rtcp ? "RTCP" : "RTP", size, bufout == buf ? " in place" : "");
 
-  } else if (err == srtp_err_status_key_expired) {
+  *outbuf_ptr = bufout;
+  return err;
+}
 
+/* Must be called without the object lock */
+static GstFlowReturn
+gst_srtp_enc_handle_protect_error (GstSrtpEnc * filter, srtp_err_status_t err)
+{
+  if (err == srtp_err_status_key_expired) {
     GST_ELEMENT_ERROR (GST_ELEMENT_CAST (filter), STREAM, ENCODE,
         ("Key usage limit has been reached"),
         ("Unable to protect buffer (hard key usage limit reached)"));
-    ret = GST_FLOW_ERROR;
-    goto fail;
-
   } else {
     /* srtp_protect failed */
     GST_ELEMENT_ERROR (filter, LIBRARY, FAILED, (NULL),
         ("Unable to protect buffer (protect failed) code %d", err));
-    ret = GST_FLOW_ERROR;
-    goto fail;
   }
 
-  *outbuf_ptr = bufout;
-  return ret;
+  return GST_FLOW_ERROR;
+}
 
-fail:
-  gst_buffer_unref (bufout);
-  return ret;
+static void
+gst_srtp_enc_check_soft_limit (GstSrtpEnc * filter)
+{
+  GST_OBJECT_LOCK (filter);
+
+  if (gst_srtp_get_soft_limit_reached ()) {
+    GST_OBJECT_UNLOCK (filter);
+    g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
+    GST_OBJECT_LOCK (filter);
+    if (filter->random_key && !filter->key_changed)
+      gst_srtp_enc_replace_random_key (filter);
+  }
+
+  GST_OBJECT_UNLOCK (filter);
 }
 
 static GstFlowReturn
@@ -1109,47 +1170,43 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *otherpad;
   GstBuffer *bufout = NULL;
+  srtp_err_status_t err;
 
   if ((ret = gst_srtp_enc_check_set_caps (filter, pad, is_rtcp)) != GST_FLOW_OK) {
-    goto out;
+    gst_buffer_unref (buf);
+    return ret;
   }
 
+  otherpad = get_rtp_other_pad (pad);
+
   GST_OBJECT_LOCK (filter);
 
   if (!HAS_CRYPTO (filter)) {
     GST_OBJECT_UNLOCK (filter);
-    otherpad = get_rtp_other_pad (pad);
     return gst_pad_push (otherpad, buf);
   }
 
+  if (filter->session == NULL) {
+    /* The session disappeared (element shutting down) */
+    GST_OBJECT_UNLOCK (filter);
+    gst_buffer_unref (buf);
+    return GST_FLOW_FLUSHING;
+  }
+
+  gst_srtp_init_event_reporter ();
+  err = gst_srtp_enc_protect_buffer (filter, pad, buf, is_rtcp, &bufout);
+
   GST_OBJECT_UNLOCK (filter);
 
-  ret = gst_srtp_enc_process_buffer (filter, pad, buf, is_rtcp, &bufout);
-  if (ret != GST_FLOW_OK)
-    goto out;
+  if (err != srtp_err_status_ok)
+    return gst_srtp_enc_handle_protect_error (filter, err);
 
   /* Push buffer to source pad */
-  otherpad = get_rtp_other_pad (pad);
   ret = gst_pad_push (otherpad, bufout);
-  bufout = NULL;
-
-  if (ret != GST_FLOW_OK)
-    goto out;
 
-  GST_OBJECT_LOCK (filter);
+  if (ret == GST_FLOW_OK)
+    gst_srtp_enc_check_soft_limit (filter);
 
-  if (gst_srtp_get_soft_limit_reached ()) {
-    GST_OBJECT_UNLOCK (filter);
-    g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
-    GST_OBJECT_LOCK (filter);
-    if (filter->random_key && !filter->key_changed)
-      gst_srtp_enc_replace_random_key (filter);
-  }
-
-  GST_OBJECT_UNLOCK (filter);
-
-out:
-  gst_buffer_unref (buf);
   return ret;
 }
 
@@ -1157,21 +1214,16 @@ static gboolean
 process_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
 {
   ProcessBufferItData *data = user_data;
-  GstBuffer *bufout;
-  GstFlowReturn ret;
-
-  ret = gst_srtp_enc_process_buffer (data->filter, data->pad, *buffer,
-      data->is_rtcp, &bufout);
-  if (ret != GST_FLOW_OK) {
-    data->flowret = ret;
-    return FALSE;
-  }
 
-  gst_buffer_list_add (data->out_list, bufout);
+  data->err = gst_srtp_enc_protect_buffer (data->filter, data->pad, *buffer,
+      data->is_rtcp, buffer);
 
-  return TRUE;
+  return data->err == srtp_err_status_ok;
 }
 
+/* Protects the whole list in place: the session is looked up and the lock
+ * taken only once, and every buffer that has room for the trailer is
+ * re-used as is */
 static GstFlowReturn
 gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
     GstBufferList * buf_list, gboolean is_rtcp)
@@ -1179,7 +1231,6 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   GstSrtpEnc *filter = GST_SRTP_ENC (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *otherpad;
-  GstBufferList *out_list = NULL;
   ProcessBufferItData process_data;
 
   GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
@@ -1191,56 +1242,48 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   if ((ret = gst_srtp_enc_check_set_caps (filter, pad, is_rtcp)) != GST_FLOW_OK)
     goto out;
 
+  otherpad = get_rtp_other_pad (pad);
+
   GST_OBJECT_LOCK (filter);
 
   if (!HAS_CRYPTO (filter)) {
     GST_OBJECT_UNLOCK (filter);
-    otherpad = get_rtp_other_pad (pad);
     return gst_pad_push_list (otherpad, buf_list);
   }
 
-  GST_OBJECT_UNLOCK (filter);
+  if (filter->session == NULL) {
+    /* The session disappeared (element shutting down) */
+    GST_OBJECT_UNLOCK (filter);
+    ret = GST_FLOW_FLUSHING;
+    goto out;
+  }
 
-  out_list = gst_buffer_list_new ();
+  buf_list = gst_buffer_list_make_writable (buf_list);
 
   process_data.filter = filter;
   process_data.pad = pad;
   process_data.is_rtcp = is_rtcp;
-  process_data.out_list = out_list;
-  process_data.flowret = GST_FLOW_OK;
+  process_data.err = srtp_err_status_ok;
 
-  if (!gst_buffer_list_foreach (buf_list, process_buffer_it, &process_data)) {
-    ret = process_data.flowret;
-    goto out;
-  }
+  gst_srtp_init_event_reporter ();
+  gst_buffer_list_foreach (buf_list, process_buffer_it, &process_data);
+
+  GST_OBJECT_UNLOCK (filter);
 
-  if (!gst_buffer_list_length (out_list)) {
-    gst_buffer_list_unref (out_list);
-    ret = GST_FLOW_OK;
+  if (process_data.err != srtp_err_status_ok) {
+    ret = gst_srtp_enc_handle_protect_error (filter, process_data.err);
     goto out;
   }
 
   /* Push buffer to source pad */
-  otherpad = get_rtp_other_pad (pad);
   GST_LOG_OBJECT (pad, "Pushing buffer chain of %d",
       gst_buffer_list_length (buf_list));
-  ret = gst_pad_push_list (otherpad, out_list);
-
-  if (ret != GST_FLOW_OK) {
-    goto out;
-  }
+  ret = gst_pad_push_list (otherpad, buf_list);
 
-  GST_OBJECT_LOCK (filter);
+  if (ret == GST_FLOW_OK)
+    gst_srtp_enc_check_soft_limit (filter);
 
-  if (gst_srtp_get_soft_limit_reached ()) {
-    GST_OBJECT_UNLOCK (filter);
-    g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
-    GST_OBJECT_LOCK (filter);
-    if (filter->random_key && !filter->key_changed)
-      gst_srtp_enc_replace_random_key (filter);
-  }
-
-  GST_OBJECT_UNLOCK (filter);
+  return ret;
 
 out:
 
@@ -142,6 +142,18 @@ typedef struct
 } UnifiedBlock;
 
 
+/* An entry of the render cache. Entries are keyed by a string describing
+ * everything the image or composition was rendered from and hold either a
+ * rendered image or a composition. */
+typedef struct
+{
+  GstTtmlRenderRenderedImage *image;
+  GstVideoOverlayComposition *composition;
+  /* value of cache_generation when the entry was last used */
+  guint generation;
+} CacheEntry;
+
+
 static GstElementClass *parent_class = NULL;
 static void gst_ttml_render_base_init (gpointer g_class);
 static void gst_ttml_render_class_init (GstTtmlRenderClass * klass);
@@ -196,6 +208,7 @@ static GstTtmlRenderRenderedImage *gst_ttml_render_stitch_images (GPtrArray *
     images, GstTtmlDirection direction);
 
 static gboolean gst_ttml_render_color_is_transparent (GstSubtitleColor * color);
+static void gst_ttml_render_cache_entry_free (CacheEntry * entry);
 
 GType
 gst_ttml_render_get_type (void)
@@ -294,6 +307,9 @@ gst_ttml_render_finalize (GObject * object)
     render->layout = NULL;
   }
 
+  g_hash_table_unref (render->cache);
+  g_hash_table_unref (render->font_metrics_cache);
+
   g_mutex_clear (&render->lock);
   g_cond_clear (&render->cond);
 
@@ -357,6 +373,12 @@ gst_ttml_render_init (GstTtmlRender * render, GstTtmlRenderClass * klass)
   render->layout =
       pango_layout_new (GST_TTML_RENDER_GET_CLASS (render)->pango_context);
 
+  render->cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) gst_ttml_render_cache_entry_free);
+  render->font_metrics_cache = g_hash_table_new_full (g_str_hash,
+      g_str_equal, g_free, g_free);
+  render->cache_generation = 0;
+
   g_mutex_init (&render->lock);
   g_cond_init (&render->cond);
   gst_segment_init (&render->segment, GST_FORMAT_TIME);
@@ -1430,17 +1452,31 @@ gst_ttml_render_get_pango_font_metrics (GstTtmlRender * render,
 {
   PangoRectangle ink_rect;
   gchar *string;
-  FontMetrics ret;
+  FontMetrics ret, *cached;
 
   string = gst_ttml_render_generate_pango_markup (style_set, font_size,
       "Áĺľď¿gqy");
+
+  /* Only depends on the font, which is shared by most of the text */
+  cached = g_hash_table_lookup (render->font_metrics_cache, string);
+  if (cached) {
+    g_free (string);
+    return *cached;
+  }
+
   pango_layout_set_markup (render->layout, string, strlen (string));
   pango_layout_get_pixel_extents (render->layout, &ink_rect, NULL);
-  g_free (string);
 
   ret.height = ink_rect.height;
   ret.baseline = PANGO_PIXELS (pango_layout_get_baseline (render->layout))
       - ink_rect.y;
+
+  if (g_hash_table_size (render->font_metrics_cache) >=
+      GST_TTML_RENDER_CACHE_SIZE)
+    g_hash_table_remove_all (render->font_metrics_cache);
+  g_hash_table_insert (render->font_metrics_cache, string,
+      g_memdup (&ret, sizeof (FontMetrics)));
+
   return ret;
 }
 
@@ -1930,20 +1966,105 @@ gst_ttml_render_split_block (UnifiedBlock * block, GPtrArray * char_ranges)
 }
 
 
+static void
+gst_ttml_render_cache_entry_free (CacheEntry * entry)
+{
+  gst_ttml_render_rendered_image_free (entry->image);
+  if (entry->composition)
+    gst_video_overlay_composition_unref (entry->composition);
+  g_slice_free (CacheEntry, entry);
+}
+
+
+static CacheEntry *
+gst_ttml_render_cache_lookup (GstTtmlRender * render, const gchar * key)
+{
+  CacheEntry *entry = g_hash_table_lookup (render->cache, key);
+
+  if (entry)
+    entry->generation = render->cache_generation;
+  return entry;
+}
+
+
+/* Returns a copy of the image cached under @key, sharing its pixels, or NULL
+ * if there is none. */
+static GstTtmlRenderRenderedImage *
+gst_ttml_render_cache_lookup_image (GstTtmlRender * render, const gchar * key)
+{
+  CacheEntry *entry = gst_ttml_render_cache_lookup (render, key);
+
+  if (!entry || !entry->image)
+    return NULL;
+
+  GST_CAT_LOG (ttmlrender_debug, "Reusing cached image for %s", key);
+  return gst_ttml_render_rendered_image_copy (entry->image);
+}
+
+
+/* Takes ownership of @key and caches a copy of @image under it. */
+static void
+gst_ttml_render_cache_insert_image (GstTtmlRender * render, gchar * key,
+    GstTtmlRenderRenderedImage * image)
+{
+  CacheEntry *entry;
+
+  if (!image || !image->image) {
+    g_free (key);
+    return;
+  }
+
+  entry = g_slice_new0 (CacheEntry);
+  entry->image = gst_ttml_render_rendered_image_copy (image);
+  entry->generation = render->cache_generation;
+  g_hash_table_replace (render->cache, key, entry);
+}
+
+
+static gboolean
+gst_ttml_render_cache_entry_is_stale (gpointer key, CacheEntry * entry,
+    GstTtmlRender * render)
+{
+  return entry->generation != render->cache_generation;
+}
+
+
+/* Drops the entries that weren't used for the current cue once the cache
+ * has grown too big. */
+static void
+gst_ttml_render_cache_prune (GstTtmlRender * render)
+{
+  if (g_hash_table_size (render->cache) > GST_TTML_RENDER_CACHE_SIZE) {
+    g_hash_table_foreach_remove (render->cache,
+        (GHRFunc) gst_ttml_render_cache_entry_is_stale, render);
+    GST_CAT_DEBUG (ttmlrender_debug, "%u entries left in render cache",
+        g_hash_table_size (render->cache));
+  }
+}
+
+
 /* Render the text in a pango-markup string. */
 static GstTtmlRenderRenderedImage *
 gst_ttml_render_draw_text (GstTtmlRender * render, const gchar * text,
     guint line_height, guint baseline_offset)
 {
   GstTtmlRenderRenderedImage *ret;
-  cairo_surface_t *surface, *cropped_surface;
-  cairo_t *cairo_state, *cropped_state;
+  cairo_surface_t *surface;
+  cairo_t *cairo_state;
   GstMapInfo map;
   PangoRectangle logical_rect, ink_rect;
   guint buf_width, buf_height;
   gint stride;
-  gint bounding_box_x1, bounding_box_x2, bounding_box_y1, bounding_box_y2;
+  gint bounding_box_x1, bounding_box_x2;
   gint baseline;
+  gchar *key;
+
+  key = g_strdup_printf ("text:%u:%s", baseline_offset, text);
+  ret = gst_ttml_render_cache_lookup_image (render, key);
+  if (ret) {
+    g_free (key);
+    return ret;
+  }
 
   ret = gst_ttml_render_rendered_image_new_empty ();
 
@@ -1959,20 +2080,6 @@ gst_ttml_render_draw_text (GstTtmlRender * render, const gchar * text,
   bounding_box_x1 = MIN (logical_rect.x, ink_rect.x);
   bounding_box_x2 = MAX (logical_rect.x + logical_rect.width,
       ink_rect.x + ink_rect.width);
-  bounding_box_y1 = MIN (logical_rect.y, ink_rect.y);
-  bounding_box_y2 = MAX (logical_rect.y + logical_rect.height,
-      ink_rect.y + ink_rect.height);
-
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-      (bounding_box_x2 - bounding_box_x1), (bounding_box_y2 - bounding_box_y1));
-  cairo_state = cairo_create (surface);
-  cairo_set_operator (cairo_state, CAIRO_OPERATOR_CLEAR);
-  cairo_paint (cairo_state);
-  cairo_set_operator (cairo_state, CAIRO_OPERATOR_OVER);
-
-  cairo_save (cairo_state);
-  pango_cairo_show_layout (cairo_state, render->layout);
-  cairo_restore (cairo_state);
 
   buf_width = bounding_box_x2 - bounding_box_x1;
   buf_height = ink_rect.height;
@@ -1983,26 +2090,25 @@ gst_ttml_render_draw_text (GstTtmlRender * render, const gchar * text,
   gst_buffer_memset (ret->image, 0, 0U, 4 * buf_width * buf_height);
   gst_buffer_map (ret->image, &map, GST_MAP_READWRITE);
 
+  /* Draw straight into the output buffer, which only covers the vertical ink
+   * extents of the layout. */
   stride = cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, buf_width);
-  cropped_surface =
-      cairo_image_surface_create_for_data (map.data, CAIRO_FORMAT_ARGB32,
-      (bounding_box_x2 - bounding_box_x1), ink_rect.height, stride);
-  cropped_state = cairo_create (cropped_surface);
-  cairo_set_source_surface (cropped_state, surface, -bounding_box_x1,
-      -ink_rect.y);
-  cairo_rectangle (cropped_state, 0, 0, buf_width, buf_height);
-  cairo_fill (cropped_state);
+  surface = cairo_image_surface_create_for_data (map.data,
+      CAIRO_FORMAT_ARGB32, buf_width, buf_height, stride);
+  cairo_state = cairo_create (surface);
+  cairo_translate (cairo_state, -bounding_box_x1, -ink_rect.y);
+  pango_cairo_show_layout (cairo_state, render->layout);
 
   cairo_destroy (cairo_state);
   cairo_surface_destroy (surface);
-  cairo_destroy (cropped_state);
-  cairo_surface_destroy (cropped_surface);
   gst_buffer_unmap (ret->image, &map);
 
   ret->width = buf_width;
   ret->height = buf_height;
   ret->x = 0;
   ret->y = MAX (0, (gint) baseline_offset - (baseline - ink_rect.y));
+
+  gst_ttml_render_cache_insert_image (render, key, ret);
   return ret;
 }
 
@@ -2016,20 +2122,44 @@ gst_ttml_render_render_block_elements (GstTtmlRender * render,
   GstTtmlRenderRenderedImage *ret = NULL;
   guint line_padding =
       (guint) ceil (block->style_set->line_padding * render->width);
+  guint n_elements = gst_ttml_render_unified_block_element_count (block);
+  gchar **markups = g_new0 (gchar *, n_elements + 1);
+  GString *key;
   gint i;
 
-  for (i = 0; i < gst_ttml_render_unified_block_element_count (block); ++i) {
+  /* A line only depends on the markup and background of its elements, so
+   * lines that didn't change since an earlier cue are reused. */
+  key = g_string_new (NULL);
+  g_string_append_printf (key, "line:%u:%u:%u:%d", line_padding,
+      block_metrics.line_height, block_metrics.baseline_offset,
+      block->style_set->fill_line_gap);
+  for (i = 0; i < n_elements; ++i) {
+    UnifiedElement *ue = gst_ttml_render_unified_block_get_element (block, i);
+    GstSubtitleColor bg = ue->element->style_set->background_color;
+
+    markups[i] = gst_ttml_render_generate_pango_markup (ue->element->style_set,
+        ue->pango_font_size, ue->text);
+    g_string_append_printf (key, "|%02x%02x%02x%02x:%u:%u:%s", bg.r, bg.g,
+        bg.b, bg.a, ue->pango_font_metrics.baseline,
+        ue->pango_font_metrics.height, markups[i]);
+  }
+
+  ret = gst_ttml_render_cache_lookup_image (render, key->str);
+  if (ret) {
+    g_string_free (key, TRUE);
+    g_strfreev (markups);
+    g_ptr_array_unref (inline_images);
+    return ret;
+  }
+
+  for (i = 0; i < n_elements; ++i) {
     UnifiedElement *ue = gst_ttml_render_unified_block_get_element (block, i);
-    gchar *markup;
     GstTtmlRenderRenderedImage *text_image, *bg_image, *combined_image;
     guint bg_offset, bg_width, bg_height;
     GstBuffer *background;
 
-    markup = gst_ttml_render_generate_pango_markup (ue->element->style_set,
-        ue->pango_font_size, ue->text);
-    text_image = gst_ttml_render_draw_text (render, markup,
+    text_image = gst_ttml_render_draw_text (render, markups[i],
         block_metrics.line_height, block_metrics.baseline_offset);
-    g_free (markup);
 
     if (!block->style_set->fill_line_gap) {
       bg_offset =
@@ -2046,7 +2176,7 @@ gst_ttml_render_render_block_elements (GstTtmlRender * render,
         text_image->x += line_padding;
         bg_width += line_padding;
       }
-      if (i == (gst_ttml_render_unified_block_element_count (block) - 1))
+      if (i == (n_elements - 1))
         bg_width += line_padding;
     }
 
@@ -2067,6 +2197,9 @@ gst_ttml_render_render_block_elements (GstTtmlRender * render,
       "Stitched line image - x:%d  y:%d  w:%u  h:%u",
       ret->x, ret->y, ret->width, ret->height);
   g_ptr_array_unref (inline_images);
+  g_strfreev (markups);
+
+  gst_ttml_render_cache_insert_image (render, g_string_free (key, FALSE), ret);
   return ret;
 }
 
@@ -2608,6 +2741,62 @@ gst_ttml_render_compose_overlay (GstTtmlRenderRenderedImage * image)
 }
 
 
+static void
+gst_ttml_render_append_style_key (GString * key,
+    const GstSubtitleStyleSet * style)
+{
+  g_string_append_printf (key, "{%d,%s,%g,%g,%d,%02x%02x%02x%02x,"
+      "%02x%02x%02x%02x,%d,%d,%d,%d,%d,%d,%g,%g,%g,%g,%g,%d,%g,%g,%g,%g,%d,%d,"
+      "%d,%d}", style->text_direction, GST_STR_NULL (style->font_family),
+      style->font_size, style->line_height, style->text_align, style->color.r,
+      style->color.g, style->color.b, style->color.a,
+      style->background_color.r, style->background_color.g,
+      style->background_color.b, style->background_color.a,
+      style->font_style, style->font_weight, style->text_decoration,
+      style->unicode_bidi, style->wrap_option, style->multi_row_align,
+      style->line_padding, style->origin_x, style->origin_y, style->extent_w,
+      style->extent_h, style->display_align, style->padding_start,
+      style->padding_end, style->padding_before, style->padding_after,
+      style->writing_mode, style->show_background, style->overflow,
+      style->fill_line_gap);
+}
+
+
+/* Describes everything the rendering of @region depends on. */
+static gchar *
+gst_ttml_render_region_cache_key (GstTtmlRender * render,
+    GstSubtitleRegion * region, GstBuffer * text_buf)
+{
+  GString *key = g_string_new (NULL);
+  guint i, j;
+
+  g_string_append_printf (key, "region:%dx%d", render->width, render->height);
+  gst_ttml_render_append_style_key (key, region->style_set);
+
+  for (i = 0; i < gst_subtitle_region_get_block_count (region); ++i) {
+    const GstSubtitleBlock *block = gst_subtitle_region_get_block (region, i);
+
+    g_string_append_c (key, '[');
+    gst_ttml_render_append_style_key (key, block->style_set);
+    for (j = 0; j < gst_subtitle_block_get_element_count (block); ++j) {
+      const GstSubtitleElement *element =
+          gst_subtitle_block_get_element (block, j);
+      gchar *text =
+          gst_ttml_render_get_text_from_buffer (text_buf, element->text_index);
+
+      gst_ttml_render_append_style_key (key, element->style_set);
+      g_string_append_printf (key, "%d:%" G_GSIZE_FORMAT ":%s",
+          element->suppress_whitespace, text ? strlen (text) : 0,
+          GST_STR_NULL (text));
+      g_free (text);
+    }
+    g_string_append_c (key, ']');
+  }
+
+  return g_string_free (key, FALSE);
+}
+
+
 static GstVideoOverlayComposition *
 gst_ttml_render_render_text_region (GstTtmlRender * render,
     GstSubtitleRegion * region, GstBuffer * text_buf)
@@ -2620,8 +2809,22 @@ gst_ttml_render_render_text_region (GstTtmlRender * render,
       (GDestroyNotify) gst_ttml_render_rendered_image_free);
   GstTtmlRenderRenderedImage *region_image = NULL;
   GstVideoOverlayComposition *ret = NULL;
+  CacheEntry *entry;
+  gchar *key;
   guint i;
 
+  /* Regions that didn't change keep their composition, and with it their
+   * overlay rectangles, so downstream can reuse what it made of them. */
+  key = gst_ttml_render_region_cache_key (render, region, text_buf);
+  entry = gst_ttml_render_cache_lookup (render, key);
+  if (entry) {
+    GST_CAT_DEBUG (ttmlrender_debug, "Region unchanged, reusing composition");
+    g_free (key);
+    g_ptr_array_unref (rendered_blocks);
+    return entry->composition ?
+        gst_video_overlay_composition_ref (entry->composition) : NULL;
+  }
+
   region_width = (guint) (round (region->style_set->extent_w * render->width));
   region_height =
       (guint) (round (region->style_set->extent_h * render->height));
@@ -2750,6 +2953,12 @@ gst_ttml_render_render_text_region (GstTtmlRender * render,
     gst_ttml_render_rendered_image_free (region_image);
   }
 
+  /* also remember regions that have nothing to show */
+  entry = g_slice_new0 (CacheEntry);
+  entry->composition = ret ? gst_video_overlay_composition_ref (ret) : NULL;
+  entry->generation = render->cache_generation;
+  g_hash_table_replace (render->cache, key, entry);
+
   g_ptr_array_unref (rendered_blocks);
   return ret;
 }
@@ -2905,6 +3114,7 @@ wait_for_text_buf:
           render->compositions = NULL;
         }
 
+        render->cache_generation++;
         subtitle_meta = gst_buffer_get_subtitle_meta (render->text_buffer);
         if (!subtitle_meta) {
           GST_CAT_WARNING (ttmlrender_debug, "Failed to get subtitle meta.");
@@ -2920,6 +3130,7 @@ wait_for_text_buf:
             }
           }
         }
+        gst_ttml_render_cache_prune (render);
         render->need_render = FALSE;
       }
 
@@ -3043,6 +3254,12 @@ gst_ttml_render_change_state (GstElement * element, GstStateChange transition)
     return ret;
 
   switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_TTML_RENDER_LOCK (render);
+      g_hash_table_remove_all (render->cache);
+      g_hash_table_remove_all (render->font_metrics_cache);
+      GST_TTML_RENDER_UNLOCK (render);
+      break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       GST_TTML_RENDER_LOCK (render);
       render->text_flushing = FALSE;
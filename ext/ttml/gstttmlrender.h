@@ -46,6 +46,10 @@ G_BEGIN_DECLS
 #define GST_IS_TTML_RENDER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass),\
                                          GST_TYPE_TTML_RENDER))
 
+/* Entries of the render cache that weren't used for the current cue are
+ * dropped once the cache holds more than this */
+#define GST_TTML_RENDER_CACHE_SIZE 256
+
 typedef struct _GstTtmlRender GstTtmlRender;
 typedef struct _GstTtmlRenderClass GstTtmlRenderClass;
 typedef struct _GstTtmlRenderRenderedImage GstTtmlRenderRenderedImage;
@@ -93,6 +97,11 @@ struct _GstTtmlRender {
 
     PangoLayout             *layout;
     GList * compositions;
+
+    /* rendered regions, lines and text runs, reused across cues */
+    GHashTable              *cache;
+    GHashTable              *font_metrics_cache;
+    guint                    cache_generation;
 };
 
 struct _GstTtmlRenderClass {
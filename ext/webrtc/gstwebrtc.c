@@ -22,6 +22,7 @@
 #endif
 
 #include "gstwebrtcbin.h"
+#include "webrtcfanout.h"
 
 static gboolean
 plugin_init (GstPlugin * plugin)
@@ -29,6 +30,9 @@ plugin_init (GstPlugin * plugin)
   if (!gst_element_register (plugin, "webrtcbin", GST_RANK_PRIMARY,
           GST_TYPE_WEBRTC_BIN))
     return FALSE;
+  if (!gst_element_register (plugin, "webrtcfanout", GST_RANK_NONE,
+          GST_TYPE_WEBRTC_FANOUT))
+    return FALSE;
   return TRUE;
 }
 
@@ -0,0 +1,740 @@
+/* GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-webrtcfanout
+ * @title: webrtcfanout
+ *
+ * webrtcfanout distributes one already payloaded RTP stream to any number of
+ * webrtcbin peers so that a single encoder/payloader can feed many peer
+ * connections.
+ *
+ * Every src pad is an independent RTP sender: it gets its own random SSRC,
+ * sequence number offset and timestamp offset, so every peer sees a
+ * well-formed stream starting at the moment it was attached.  Only the RTP
+ * header is rewritten per peer, the payload memory is shared between all
+ * outgoing buffers.  SRTP protection is then done by each webrtcbin's own
+ * DTLS-SRTP transport.
+ *
+ * A newly added peer does not receive anything until the next key unit.
+ * Key unit requests coming from the peers (e.g. PLI/FIR translated by
+ * rtpsession) are aggregated: only one request is forwarded upstream until
+ * a key unit has been seen, and never more often than
+ * #GstWebRTCFanout:min-keyframe-interval.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 videotestsrc ! vp8enc ! rtpvp8pay ! webrtcfanout name=f \
+ *     f. ! queue ! webrtcbin name=peer0  f. ! queue ! webrtcbin name=peer1
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "webrtcfanout.h"
+
+#include <gst/rtp/rtp.h>
+#include <gst/video/video.h>
+
+#include <string.h>
+
+#define GST_CAT_DEFAULT gst_webrtc_fanout_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+/* Requests that have not been answered with a key unit are retried after
+ * this long, in case the first one got lost upstream */
+#define KEYFRAME_RETRY_INTERVAL (1 * GST_SECOND)
+
+#define DEFAULT_MIN_KEYFRAME_INTERVAL (200 * GST_MSECOND)
+
+enum
+{
+  PROP_0,
+  PROP_MIN_KEYFRAME_INTERVAL,
+  PROP_NUM_PEERS,
+  PROP_STATS,
+};
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_SSRC,
+  PROP_PAD_SEQNUM_OFFSET,
+  PROP_PAD_TIMESTAMP_OFFSET,
+  PROP_PAD_PACKETS_SENT,
+  PROP_PAD_BYTES_SENT,
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+G_DEFINE_TYPE (GstWebRTCFanoutPad, gst_webrtc_fanout_pad, GST_TYPE_PAD);
+
+static void
+gst_webrtc_fanout_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstWebRTCFanoutPad *pad = GST_WEBRTC_FANOUT_PAD (object);
+  GstObject *parent = gst_object_get_parent (GST_OBJECT (pad));
+
+  if (parent)
+    GST_OBJECT_LOCK (parent);
+  switch (prop_id) {
+    case PROP_PAD_SSRC:
+      g_value_set_uint (value, pad->ssrc);
+      break;
+    case PROP_PAD_SEQNUM_OFFSET:
+      g_value_set_uint (value, pad->seqnum_offset);
+      break;
+    case PROP_PAD_TIMESTAMP_OFFSET:
+      g_value_set_uint (value, pad->timestamp_offset);
+      break;
+    case PROP_PAD_PACKETS_SENT:
+      g_value_set_uint64 (value, pad->packets_sent);
+      break;
+    case PROP_PAD_BYTES_SENT:
+      g_value_set_uint64 (value, pad->bytes_sent);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  if (parent) {
+    GST_OBJECT_UNLOCK (parent);
+    gst_object_unref (parent);
+  }
+}
+
+static void
+gst_webrtc_fanout_pad_class_init (GstWebRTCFanoutPadClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->get_property = gst_webrtc_fanout_pad_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_PAD_SSRC,
+      g_param_spec_uint ("ssrc", "SSRC",
+          "The SSRC used for the packets sent to this peer",
+          0, G_MAXUINT32, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_SEQNUM_OFFSET,
+      g_param_spec_uint ("seqnum-offset", "Sequence number offset",
+          "Offset added to the incoming RTP sequence numbers for this peer",
+          0, G_MAXUINT16, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_TIMESTAMP_OFFSET,
+      g_param_spec_uint ("timestamp-offset", "Timestamp offset",
+          "Offset added to the incoming RTP timestamps for this peer",
+          0, G_MAXUINT32, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_PACKETS_SENT,
+      g_param_spec_uint64 ("packets-sent", "Packets sent",
+          "Number of packets sent to this peer", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_BYTES_SENT,
+      g_param_spec_uint64 ("bytes-sent", "Bytes sent",
+          "Number of bytes sent to this peer", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_webrtc_fanout_pad_init (GstWebRTCFanoutPad * pad)
+{
+  pad->ssrc = g_random_int ();
+  pad->seqnum_offset = g_random_int_range (0, G_MAXUINT16);
+  pad->timestamp_offset = g_random_int ();
+  pad->waiting_for_keyframe = TRUE;
+  pad->needs_sticky = TRUE;
+}
+
+#define gst_webrtc_fanout_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstWebRTCFanout, gst_webrtc_fanout, GST_TYPE_ELEMENT,
+    GST_DEBUG_CATEGORY_INIT (gst_webrtc_fanout_debug, "webrtcfanout", 0,
+        "webrtcfanout"););
+
+/* must be called with the object lock */
+static gboolean
+_ssrc_in_use (GstWebRTCFanout * fanout, guint32 ssrc)
+{
+  GList *l;
+
+  for (l = fanout->srcpads; l; l = l->next) {
+    if (GST_WEBRTC_FANOUT_PAD (l->data)->ssrc == ssrc)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* The upstream seqnum/timestamp bases don't apply to any peer, only the SSRC
+ * is advertised so the caps stay stable for the lifetime of the peer */
+static GstCaps *
+_rewrite_caps (GstWebRTCFanoutPad * pad, GstCaps * caps)
+{
+  GstStructure *s;
+
+  caps = gst_caps_make_writable (caps);
+  s = gst_caps_get_structure (caps, 0);
+
+  gst_structure_remove_fields (s, "seqnum-offset", "timestamp-offset", NULL);
+  gst_structure_set (s, "ssrc", G_TYPE_UINT, pad->ssrc, NULL);
+
+  return caps;
+}
+
+static gboolean
+_store_sticky_event (GstPad * pad, GstEvent ** event, gpointer user_data)
+{
+  GstWebRTCFanoutPad *srcpad = user_data;
+  GstEvent *ev = gst_event_ref (*event);
+
+  if (GST_EVENT_TYPE (ev) == GST_EVENT_CAPS) {
+    GstCaps *caps;
+
+    gst_event_parse_caps (ev, &caps);
+    caps = _rewrite_caps (srcpad, gst_caps_ref (caps));
+    gst_event_unref (ev);
+    ev = gst_event_new_caps (caps);
+    gst_caps_unref (caps);
+  }
+
+  gst_pad_store_sticky_event (GST_PAD (srcpad), ev);
+  gst_event_unref (ev);
+
+  return TRUE;
+}
+
+/* Returns a new buffer that shares all the payload memory with @inbuf and only
+ * carries its own copy of the RTP header */
+static GstBuffer *
+_rewrite_buffer (GstWebRTCFanoutPad * pad, GstBuffer * inbuf, guint hdrlen,
+    const guint8 * header, guint16 seqnum, guint32 rtptime)
+{
+  GstBuffer *outbuf;
+  GstMapInfo map;
+
+  outbuf = gst_buffer_new_allocate (NULL, hdrlen, NULL);
+  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+  memcpy (map.data, header, hdrlen);
+  GST_WRITE_UINT16_BE (&map.data[2], (guint16) (seqnum + pad->seqnum_offset));
+  GST_WRITE_UINT32_BE (&map.data[4], rtptime + pad->timestamp_offset);
+  GST_WRITE_UINT32_BE (&map.data[8], pad->ssrc);
+  gst_buffer_unmap (outbuf, &map);
+
+  gst_buffer_copy_into (outbuf, inbuf, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_copy_into (outbuf, inbuf, GST_BUFFER_COPY_MEMORY, hdrlen, -1);
+
+  return outbuf;
+}
+
+/* must be called with the object lock */
+static gboolean
+_should_forward_keyframe_request (GstWebRTCFanout * fanout)
+{
+  GstClockTime now = g_get_monotonic_time () * GST_USECOND;
+  GstClockTime since_last;
+
+  fanout->keyframe_requests_received++;
+
+  if (!GST_CLOCK_TIME_IS_VALID (fanout->last_keyframe_request))
+    goto forward;
+
+  since_last = now - fanout->last_keyframe_request;
+  if (since_last < fanout->min_keyframe_interval)
+    return FALSE;
+  if (fanout->keyframe_pending && since_last < KEYFRAME_RETRY_INTERVAL)
+    return FALSE;
+
+forward:
+  fanout->last_keyframe_request = now;
+  fanout->keyframe_pending = TRUE;
+  fanout->keyframe_requests_forwarded++;
+  return TRUE;
+}
+
+static void
+_request_keyframe (GstWebRTCFanout * fanout)
+{
+  gboolean forward;
+
+  GST_OBJECT_LOCK (fanout);
+  forward = _should_forward_keyframe_request (fanout);
+  GST_OBJECT_UNLOCK (fanout);
+
+  if (forward) {
+    GST_DEBUG_OBJECT (fanout, "requesting key unit for new peer");
+    gst_pad_push_event (fanout->sinkpad,
+        gst_video_event_new_upstream_force_key_unit (GST_CLOCK_TIME_NONE,
+            TRUE, 0));
+  }
+}
+
+static GstFlowReturn
+gst_webrtc_fanout_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstWebRTCFanout *fanout = GST_WEBRTC_FANOUT (parent);
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint8 header[12 + 15 * 4];
+  guint hdrlen, n_pads = 0, n_not_linked = 0, i;
+  GstWebRTCFanoutPad **pads;
+  GstBuffer **outbufs;
+  gboolean is_keyframe, need_keyframe = FALSE;
+  guint16 seqnum;
+  guint32 rtptime;
+  GList *l;
+
+  if (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp)) {
+    GST_ELEMENT_WARNING (fanout, STREAM, DECODE, (NULL),
+        ("Received invalid RTP packet, dropping"));
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  }
+  /* the fixed header and CSRCs, the extension header is shared with the
+   * payload as it's not modified */
+  hdrlen = 12 + gst_rtp_buffer_get_csrc_count (&rtp) * 4;
+  memcpy (header, rtp.data[0], hdrlen);
+  seqnum = gst_rtp_buffer_get_seq (&rtp);
+  rtptime = gst_rtp_buffer_get_timestamp (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  is_keyframe = !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  GST_OBJECT_LOCK (fanout);
+  fanout->packets_received++;
+  if (is_keyframe)
+    fanout->keyframe_pending = FALSE;
+
+  pads = g_newa (GstWebRTCFanoutPad *, g_list_length (fanout->srcpads));
+  outbufs = g_newa (GstBuffer *, g_list_length (fanout->srcpads));
+  for (l = fanout->srcpads; l; l = l->next) {
+    GstWebRTCFanoutPad *srcpad = l->data;
+
+    if (srcpad->waiting_for_keyframe) {
+      if (!is_keyframe) {
+        need_keyframe = TRUE;
+        continue;
+      }
+      GST_DEBUG_OBJECT (srcpad, "starting on key unit with seqnum %u", seqnum);
+      srcpad->waiting_for_keyframe = FALSE;
+    }
+
+    if (srcpad->needs_sticky) {
+      srcpad->needs_sticky = FALSE;
+      gst_pad_sticky_events_foreach (fanout->sinkpad, _store_sticky_event,
+          srcpad);
+    }
+
+    outbufs[n_pads] = _rewrite_buffer (srcpad, buffer, hdrlen, header, seqnum,
+        rtptime);
+    srcpad->packets_sent++;
+    srcpad->bytes_sent += gst_buffer_get_size (outbufs[n_pads]);
+    pads[n_pads++] = gst_object_ref (srcpad);
+  }
+  GST_OBJECT_UNLOCK (fanout);
+
+  gst_buffer_unref (buffer);
+
+  if (need_keyframe)
+    _request_keyframe (fanout);
+
+  for (i = 0; i < n_pads; i++) {
+    GstFlowReturn ret = gst_pad_push (GST_PAD (pads[i]), outbufs[i]);
+
+    /* a single misbehaving peer must not stop the other ones */
+    if (ret == GST_FLOW_NOT_LINKED)
+      n_not_linked++;
+    else if (ret != GST_FLOW_OK && ret != GST_FLOW_FLUSHING)
+      GST_DEBUG_OBJECT (pads[i], "peer returned %s", gst_flow_get_name (ret));
+    gst_object_unref (pads[i]);
+  }
+
+  if (n_pads > 0 && n_not_linked == n_pads)
+    return GST_FLOW_NOT_LINKED;
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_webrtc_fanout_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstWebRTCFanout *fanout = GST_WEBRTC_FANOUT (parent);
+  GList *l, *pads = NULL;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+    case GST_EVENT_STREAM_START:
+    case GST_EVENT_SEGMENT:
+      /* sticky events are handed to every peer with its own caps the next
+       * time a buffer is sent to it */
+      GST_OBJECT_LOCK (fanout);
+      for (l = fanout->srcpads; l; l = l->next)
+        GST_WEBRTC_FANOUT_PAD (l->data)->needs_sticky = TRUE;
+      GST_OBJECT_UNLOCK (fanout);
+      gst_event_unref (event);
+      return TRUE;
+    case GST_EVENT_FLUSH_STOP:
+      GST_OBJECT_LOCK (fanout);
+      for (l = fanout->srcpads; l; l = l->next)
+        GST_WEBRTC_FANOUT_PAD (l->data)->needs_sticky = TRUE;
+      GST_OBJECT_UNLOCK (fanout);
+      break;
+    default:
+      break;
+  }
+
+  GST_OBJECT_LOCK (fanout);
+  for (l = fanout->srcpads; l; l = l->next) {
+    GstWebRTCFanoutPad *srcpad = l->data;
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS && srcpad->needs_sticky) {
+      srcpad->needs_sticky = FALSE;
+      gst_pad_sticky_events_foreach (fanout->sinkpad, _store_sticky_event,
+          srcpad);
+    } else if (GST_EVENT_IS_STICKY (event) && srcpad->needs_sticky) {
+      /* a peer that hasn't started yet picks up the sticky state later */
+      continue;
+    }
+    pads = g_list_prepend (pads, gst_object_ref (srcpad));
+  }
+  GST_OBJECT_UNLOCK (fanout);
+
+  for (l = pads; l; l = l->next)
+    gst_pad_push_event (GST_PAD (l->data), gst_event_ref (event));
+  g_list_free_full (pads, gst_object_unref);
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static gboolean
+gst_webrtc_fanout_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps;
+
+      /* every peer gets its own rewritten caps, any RTP stream will do */
+      gst_query_parse_caps (query, &filter);
+      caps = gst_pad_get_pad_template_caps (pad);
+      if (filter) {
+        GstCaps *tmp = gst_caps_intersect_full (filter, caps,
+            GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    }
+    case GST_QUERY_ALLOCATION:
+      /* our buffers are never written to, don't let the peers' pools
+       * influence upstream */
+      return FALSE;
+    default:
+      return gst_pad_query_default (pad, parent, query);
+  }
+}
+
+static gboolean
+gst_webrtc_fanout_src_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstWebRTCFanout *fanout = GST_WEBRTC_FANOUT (parent);
+
+  if (gst_video_event_is_force_key_unit (event)) {
+    gboolean forward;
+
+    GST_OBJECT_LOCK (fanout);
+    forward = _should_forward_keyframe_request (fanout);
+    GST_OBJECT_UNLOCK (fanout);
+
+    if (!forward) {
+      GST_LOG_OBJECT (pad, "aggregating key unit request");
+      gst_event_unref (event);
+      return TRUE;
+    }
+    GST_DEBUG_OBJECT (pad, "forwarding key unit request");
+    return gst_pad_push_event (fanout->sinkpad, event);
+  }
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_RECONFIGURE:
+    case GST_EVENT_QOS:
+    case GST_EVENT_LATENCY:
+      /* peers come and go independently, none of them gets to reconfigure
+       * or throttle the shared stream */
+      gst_event_unref (event);
+      return TRUE;
+    default:
+      return gst_pad_event_default (pad, parent, event);
+  }
+}
+
+static gboolean
+gst_webrtc_fanout_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:
+      return gst_webrtc_fanout_sink_query (pad, parent, query);
+    default:
+      return gst_pad_query_default (pad, parent, query);
+  }
+}
+
+static GstPad *
+gst_webrtc_fanout_request_new_pad (GstElement * element, GstPadTemplate * templ,
+    const gchar * name, const GstCaps * caps)
+{
+  GstWebRTCFanout *fanout = GST_WEBRTC_FANOUT (element);
+  GstWebRTCFanoutPad *pad;
+  gchar *pad_name;
+  guint32 ssrc;
+
+  GST_OBJECT_LOCK (fanout);
+  if (name == NULL || strlen (name) < 5 || !g_str_has_prefix (name, "src_")) {
+    pad_name = g_strdup_printf ("src_%u", fanout->next_pad_id++);
+  } else {
+    guint serial = g_ascii_strtoull (&name[4], NULL, 10);
+    if (serial >= fanout->next_pad_id)
+      fanout->next_pad_id = serial + 1;
+    pad_name = g_strdup (name);
+  }
+  GST_OBJECT_UNLOCK (fanout);
+
+  pad = g_object_new (GST_TYPE_WEBRTC_FANOUT_PAD, "name", pad_name,
+      "direction", templ->direction, "template", templ, NULL);
+  g_free (pad_name);
+
+  gst_pad_set_event_function (GST_PAD (pad),
+      GST_DEBUG_FUNCPTR (gst_webrtc_fanout_src_event));
+  gst_pad_set_query_function (GST_PAD (pad),
+      GST_DEBUG_FUNCPTR (gst_webrtc_fanout_src_query));
+
+  gst_pad_set_active (GST_PAD (pad), TRUE);
+
+  if (!gst_element_add_pad (element, GST_PAD (pad))) {
+    gst_object_unref (pad);
+    return NULL;
+  }
+
+  GST_OBJECT_LOCK (fanout);
+  /* each peer is a separate RTP session, but keep the SSRCs unique anyway
+   * so stats and logs can be told apart */
+  ssrc = pad->ssrc;
+  while (_ssrc_in_use (fanout, ssrc))
+    ssrc = g_random_int ();
+  pad->ssrc = ssrc;
+  fanout->srcpads = g_list_append (fanout->srcpads, pad);
+  GST_OBJECT_UNLOCK (fanout);
+
+  GST_DEBUG_OBJECT (fanout, "added peer %" GST_PTR_FORMAT " with ssrc %u", pad,
+      ssrc);
+
+  return GST_PAD (pad);
+}
+
+static void
+gst_webrtc_fanout_release_pad (GstElement * element, GstPad * pad)
+{
+  GstWebRTCFanout *fanout = GST_WEBRTC_FANOUT (element);
+
+  GST_OBJECT_LOCK (fanout);
+  fanout->srcpads = g_list_remove (fanout->srcpads, pad);
+  GST_OBJECT_UNLOCK (fanout);
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+}
+
+static GstStructure *
+gst_webrtc_fanout_create_stats (GstWebRTCFanout * fanout)
+{
+  GstStructure *s;
+
+  GST_OBJECT_LOCK (fanout);
+  s = gst_structure_new ("application/x-webrtc-fanout-stats",
+      "num-peers", G_TYPE_UINT, g_list_length (fanout->srcpads),
+      "packets-received", G_TYPE_UINT64, fanout->packets_received,
+      "keyframe-requests-received", G_TYPE_UINT64,
+      fanout->keyframe_requests_received,
+      "keyframe-requests-forwarded", G_TYPE_UINT64,
+      fanout->keyframe_requests_forwarded, NULL);
+  GST_OBJECT_UNLOCK (fanout);
+
+  return s;
+}
+
+static GstStateChangeReturn
+gst_webrtc_fanout_change_state (GstElement * element, GstStateChange transition)
+{
+  GstWebRTCFanout *fanout = GST_WEBRTC_FANOUT (element);
+  GstStateChangeReturn ret;
+  GList *l;
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_OBJECT_LOCK (fanout);
+      fanout->last_keyframe_request = GST_CLOCK_TIME_NONE;
+      fanout->keyframe_pending = FALSE;
+      for (l = fanout->srcpads; l; l = l->next) {
+        GstWebRTCFanoutPad *pad = l->data;
+
+        pad->waiting_for_keyframe = TRUE;
+        pad->needs_sticky = TRUE;
+      }
+      GST_OBJECT_UNLOCK (fanout);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_webrtc_fanout_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstWebRTCFanout *fanout = GST_WEBRTC_FANOUT (object);
+
+  GST_OBJECT_LOCK (fanout);
+  switch (prop_id) {
+    case PROP_MIN_KEYFRAME_INTERVAL:
+      fanout->min_keyframe_interval = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (fanout);
+}
+
+static void
+gst_webrtc_fanout_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstWebRTCFanout *fanout = GST_WEBRTC_FANOUT (object);
+
+  switch (prop_id) {
+    case PROP_MIN_KEYFRAME_INTERVAL:
+      GST_OBJECT_LOCK (fanout);
+      g_value_set_uint64 (value, fanout->min_keyframe_interval);
+      GST_OBJECT_UNLOCK (fanout);
+      break;
+    case PROP_NUM_PEERS:
+      GST_OBJECT_LOCK (fanout);
+      g_value_set_uint (value, g_list_length (fanout->srcpads));
+      GST_OBJECT_UNLOCK (fanout);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_webrtc_fanout_create_stats (fanout));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_webrtc_fanout_finalize (GObject * object)
+{
+  GstWebRTCFanout *fanout = GST_WEBRTC_FANOUT (object);
+
+  g_list_free (fanout->srcpads);
+  fanout->srcpads = NULL;
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_webrtc_fanout_class_init (GstWebRTCFanoutClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_webrtc_fanout_request_new_pad);
+  element_class->release_pad = GST_DEBUG_FUNCPTR (gst_webrtc_fanout_release_pad);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_webrtc_fanout_change_state);
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template_with_gtype (element_class,
+      &src_template, GST_TYPE_WEBRTC_FANOUT_PAD);
+
+  gst_element_class_set_metadata (element_class, "WebRTC RTP fan-out",
+      "Filter/Network/WebRTC",
+      "Distributes one RTP stream to many webrtcbin peers",
+      "The GStreamer developers <gstreamer-devel@lists.freedesktop.org>");
+
+  gobject_class->get_property = gst_webrtc_fanout_get_property;
+  gobject_class->set_property = gst_webrtc_fanout_set_property;
+  gobject_class->finalize = gst_webrtc_fanout_finalize;
+
+  g_object_class_install_property (gobject_class,
+      PROP_MIN_KEYFRAME_INTERVAL,
+      g_param_spec_uint64 ("min-keyframe-interval", "Min keyframe interval",
+          "Minimum time between two key unit requests forwarded upstream, "
+          "requests from all peers in between are aggregated (in ns)",
+          0, G_MAXUINT64, DEFAULT_MIN_KEYFRAME_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_NUM_PEERS,
+      g_param_spec_uint ("num-peers", "Number of peers",
+          "The number of currently attached peers", 0, G_MAXUINT, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Various statistics about the fan-out", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_webrtc_fanout_init (GstWebRTCFanout * fanout)
+{
+  fanout->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (fanout->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_webrtc_fanout_chain));
+  gst_pad_set_event_function (fanout->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_webrtc_fanout_sink_event));
+  gst_pad_set_query_function (fanout->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_webrtc_fanout_sink_query));
+  gst_element_add_pad (GST_ELEMENT (fanout), fanout->sinkpad);
+
+  fanout->min_keyframe_interval = DEFAULT_MIN_KEYFRAME_INTERVAL;
+  fanout->last_keyframe_request = GST_CLOCK_TIME_NONE;
+}
@@ -0,0 +1,98 @@
+/* GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_WEBRTC_FANOUT_H__
+#define __GST_WEBRTC_FANOUT_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+GType gst_webrtc_fanout_pad_get_type(void);
+#define GST_TYPE_WEBRTC_FANOUT_PAD            (gst_webrtc_fanout_pad_get_type())
+#define GST_WEBRTC_FANOUT_PAD(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_WEBRTC_FANOUT_PAD,GstWebRTCFanoutPad))
+#define GST_IS_WEBRTC_FANOUT_PAD(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_WEBRTC_FANOUT_PAD))
+#define GST_WEBRTC_FANOUT_PAD_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_WEBRTC_FANOUT_PAD,GstWebRTCFanoutPadClass))
+#define GST_IS_WEBRTC_FANOUT_PAD_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_WEBRTC_FANOUT_PAD))
+#define GST_WEBRTC_FANOUT_PAD_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_WEBRTC_FANOUT_PAD,GstWebRTCFanoutPadClass))
+
+typedef struct _GstWebRTCFanoutPad GstWebRTCFanoutPad;
+typedef struct _GstWebRTCFanoutPadClass GstWebRTCFanoutPadClass;
+
+struct _GstWebRTCFanoutPad
+{
+  GstPad                parent;
+
+  /* all protected by the element's object lock */
+  guint32               ssrc;
+  guint16               seqnum_offset;
+  guint32               timestamp_offset;
+
+  /* peer has not seen a key unit yet, everything is dropped until then */
+  gboolean              waiting_for_keyframe;
+  /* sticky events from the sinkpad need to be (re)stored with our caps */
+  gboolean              needs_sticky;
+
+  guint64               packets_sent;
+  guint64               bytes_sent;
+};
+
+struct _GstWebRTCFanoutPadClass
+{
+  GstPadClass           parent_class;
+};
+
+GType gst_webrtc_fanout_get_type(void);
+#define GST_TYPE_WEBRTC_FANOUT            (gst_webrtc_fanout_get_type())
+#define GST_WEBRTC_FANOUT(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_WEBRTC_FANOUT,GstWebRTCFanout))
+#define GST_IS_WEBRTC_FANOUT(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_WEBRTC_FANOUT))
+#define GST_WEBRTC_FANOUT_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_WEBRTC_FANOUT,GstWebRTCFanoutClass))
+#define GST_IS_WEBRTC_FANOUT_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_WEBRTC_FANOUT))
+#define GST_WEBRTC_FANOUT_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_WEBRTC_FANOUT,GstWebRTCFanoutClass))
+
+typedef struct _GstWebRTCFanout GstWebRTCFanout;
+typedef struct _GstWebRTCFanoutClass GstWebRTCFanoutClass;
+
+struct _GstWebRTCFanout
+{
+  GstElement            parent;
+
+  GstPad               *sinkpad;
+
+  /* protected by the object lock */
+  GList                *srcpads;
+  guint                 next_pad_id;
+
+  GstClockTime          min_keyframe_interval;
+  GstClockTime          last_keyframe_request;
+  gboolean              keyframe_pending;
+
+  guint64               packets_received;
+  guint64               keyframe_requests_received;
+  guint64               keyframe_requests_forwarded;
+};
+
+struct _GstWebRTCFanoutClass
+{
+  GstElementClass       parent_class;
+};
+
+G_END_DECLS
+
+#endif /* __GST_WEBRTC_FANOUT_H__ */
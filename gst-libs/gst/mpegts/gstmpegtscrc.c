@@ -0,0 +1,290 @@
+/* GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * CRC-32/MPEG-2: polynomial 0x04c11db7, most significant bit first,
+ * initial value 0xffffffff and no final xor.
+ *
+ * The portable version processes 8 bytes per step with 8 lookup tables
+ * ("slicing-by-8"). Where carry-less multiplication is available the bulk
+ * of the data is instead folded 64 bytes at a time: each 128 bit lane is
+ * multiplied by x^512 mod P and added to the data 64 bytes further on,
+ * which keeps the value congruent to the message modulo P. The 16 bytes
+ * left after folding and the tail then go through the tables. The
+ * multiplications by x^n mod P are split in two 64x32 bit products, one
+ * for each half of the lane.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mpegts.h"
+#include "gstmpegts-private.h"
+
+#define CRC32_POLY 0x04c11db7
+
+/* x^n mod P, for the folding distances of 512 and 128 bits */
+#define CRC32_X576 0x8833794c
+#define CRC32_X512 0xe6228b11
+#define CRC32_X192 0xc5b9cd4c
+#define CRC32_X128 0xe8a45605
+
+/* Below this the setup of the folding costs more than it saves */
+#define CRC32_FOLD_MIN_SIZE 128
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 6))
+/* Built with target attributes, selected at runtime */
+#define HAVE_CRC32_PCLMUL 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+/* PMULL is only available with the crypto extension, which has to be
+ * enabled for the whole build */
+#define HAVE_CRC32_PMULL 1
+#include <arm_neon.h>
+#endif
+
+typedef guint32 (*Crc32Func) (guint32 crc, const guint8 * data, gsize size);
+
+static guint32 crc_tables[8][256];
+static Crc32Func crc32_func;
+
+static guint32
+crc32_slice8 (guint32 crc, const guint8 * data, gsize size)
+{
+  while (size >= 8) {
+    guint32 a = GST_READ_UINT32_BE (data) ^ crc;
+
+    crc = crc_tables[7][a >> 24] ^ crc_tables[6][(a >> 16) & 0xff] ^
+        crc_tables[5][(a >> 8) & 0xff] ^ crc_tables[4][a & 0xff] ^
+        crc_tables[3][data[4]] ^ crc_tables[2][data[5]] ^
+        crc_tables[1][data[6]] ^ crc_tables[0][data[7]];
+    data += 8;
+    size -= 8;
+  }
+
+  while (size--)
+    crc = (crc << 8) ^ crc_tables[0][(crc >> 24) ^ *data++];
+
+  return crc;
+}
+
+#if defined(HAVE_CRC32_PCLMUL)
+
+#define PCLMUL_FUNC __attribute__ ((target ("pclmul,ssse3")))
+#define PCLMUL_INLINE static inline \
+    __attribute__ ((always_inline, target ("pclmul,ssse3")))
+
+/* Loads 16 bytes with the first one in the most significant position */
+PCLMUL_INLINE __m128i
+load_pclmul (const guint8 * data, __m128i bswap)
+{
+  return _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) data), bswap);
+}
+
+/* s * x^n + d, @k holds x^(n + 64) mod P in the low and x^n mod P in the
+ * high half */
+PCLMUL_INLINE __m128i
+fold_pclmul (__m128i s, __m128i k, __m128i d)
+{
+  return _mm_xor_si128 (_mm_xor_si128 (_mm_clmulepi64_si128 (s, k, 0x01),
+          _mm_clmulepi64_si128 (s, k, 0x10)), d);
+}
+
+PCLMUL_FUNC static guint32
+crc32_pclmul (guint32 crc, const guint8 * data, gsize size)
+{
+  const __m128i bswap = _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+      12, 13, 14, 15);
+  const __m128i k512 = _mm_set_epi64x (CRC32_X512, CRC32_X576);
+  const __m128i k128 = _mm_set_epi64x (CRC32_X128, CRC32_X192);
+  __m128i x0, x1, x2, x3;
+  guint8 rest[16];
+
+  if (size < CRC32_FOLD_MIN_SIZE)
+    return crc32_slice8 (crc, data, size);
+
+  x0 = _mm_xor_si128 (load_pclmul (data, bswap),
+      _mm_set_epi32 ((gint) crc, 0, 0, 0));
+  x1 = load_pclmul (data + 16, bswap);
+  x2 = load_pclmul (data + 32, bswap);
+  x3 = load_pclmul (data + 48, bswap);
+  data += 64;
+  size -= 64;
+
+  while (size >= 64) {
+    x0 = fold_pclmul (x0, k512, load_pclmul (data, bswap));
+    x1 = fold_pclmul (x1, k512, load_pclmul (data + 16, bswap));
+    x2 = fold_pclmul (x2, k512, load_pclmul (data + 32, bswap));
+    x3 = fold_pclmul (x3, k512, load_pclmul (data + 48, bswap));
+    data += 64;
+    size -= 64;
+  }
+
+  x1 = fold_pclmul (x0, k128, x1);
+  x2 = fold_pclmul (x1, k128, x2);
+  x3 = fold_pclmul (x2, k128, x3);
+
+  while (size >= 16) {
+    x3 = fold_pclmul (x3, k128, load_pclmul (data, bswap));
+    data += 16;
+    size -= 16;
+  }
+
+  _mm_storeu_si128 ((__m128i *) rest, _mm_shuffle_epi8 (x3, bswap));
+  crc = crc32_slice8 (0, rest, 16);
+
+  return crc32_slice8 (crc, data, size);
+}
+
+static gboolean
+crc32_have_pclmul (void)
+{
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("pclmul") &&
+      __builtin_cpu_supports ("ssse3");
+}
+
+#elif defined(HAVE_CRC32_PMULL)
+
+/* Loads 16 bytes with the first one in the most significant position */
+static inline uint8x16_t
+load_pmull (const guint8 * data)
+{
+  uint8x16_t v = vrev64q_u8 (vld1q_u8 (data));
+
+  return vextq_u8 (v, v, 8);
+}
+
+/* s * x^n + d, with @k_hi = x^(n + 64) mod P and @k_lo = x^n mod P */
+static inline uint8x16_t
+fold_pmull (uint8x16_t s, poly64_t k_hi, poly64_t k_lo, uint8x16_t d)
+{
+  poly64x2_t p = vreinterpretq_p64_u8 (s);
+  uint8x16_t h = vreinterpretq_u8_p128 (vmull_p64 (vgetq_lane_p64 (p, 1),
+          k_hi));
+  uint8x16_t l = vreinterpretq_u8_p128 (vmull_p64 (vgetq_lane_p64 (p, 0),
+          k_lo));
+
+  return veorq_u8 (veorq_u8 (h, l), d);
+}
+
+static guint32
+crc32_pmull (guint32 crc, const guint8 * data, gsize size)
+{
+  uint8x16_t x0, x1, x2, x3;
+  guint8 rest[16];
+
+  if (size < CRC32_FOLD_MIN_SIZE)
+    return crc32_slice8 (crc, data, size);
+
+  x0 = veorq_u8 (load_pmull (data),
+      vreinterpretq_u8_u32 (vsetq_lane_u32 (crc, vdupq_n_u32 (0), 3)));
+  x1 = load_pmull (data + 16);
+  x2 = load_pmull (data + 32);
+  x3 = load_pmull (data + 48);
+  data += 64;
+  size -= 64;
+
+  while (size >= 64) {
+    x0 = fold_pmull (x0, CRC32_X576, CRC32_X512, load_pmull (data));
+    x1 = fold_pmull (x1, CRC32_X576, CRC32_X512, load_pmull (data + 16));
+    x2 = fold_pmull (x2, CRC32_X576, CRC32_X512, load_pmull (data + 32));
+    x3 = fold_pmull (x3, CRC32_X576, CRC32_X512, load_pmull (data + 48));
+    data += 64;
+    size -= 64;
+  }
+
+  x1 = fold_pmull (x0, CRC32_X192, CRC32_X128, x1);
+  x2 = fold_pmull (x1, CRC32_X192, CRC32_X128, x2);
+  x3 = fold_pmull (x2, CRC32_X192, CRC32_X128, x3);
+
+  while (size >= 16) {
+    x3 = fold_pmull (x3, CRC32_X192, CRC32_X128, load_pmull (data));
+    data += 16;
+    size -= 16;
+  }
+
+  x3 = vrev64q_u8 (x3);
+  vst1q_u8 (rest, vextq_u8 (x3, x3, 8));
+  crc = crc32_slice8 (0, rest, 16);
+
+  return crc32_slice8 (crc, data, size);
+}
+
+#endif
+
+static void
+crc32_init (void)
+{
+  guint32 c;
+  guint i, j;
+
+  for (i = 0; i < 256; i++) {
+    c = i << 24;
+    for (j = 0; j < 8; j++)
+      c = (c << 1) ^ ((c & 0x80000000) ? CRC32_POLY : 0);
+    crc_tables[0][i] = c;
+  }
+
+  for (i = 0; i < 256; i++) {
+    c = crc_tables[0][i];
+    for (j = 1; j < 8; j++) {
+      c = (c << 8) ^ crc_tables[0][c >> 24];
+      crc_tables[j][i] = c;
+    }
+  }
+
+  crc32_func = crc32_slice8;
+#if defined(HAVE_CRC32_PCLMUL)
+  if (crc32_have_pclmul ())
+    crc32_func = crc32_pclmul;
+#elif defined(HAVE_CRC32_PMULL)
+  crc32_func = crc32_pmull;
+#endif
+}
+
+/**
+ * gst_mpegts_crc32:
+ * @data: (array length=size): the data
+ * @size: the size of @data
+ *
+ * Calculates the CRC-32 used by MPEG-TS and MPEG-PS sections and tables
+ * (CRC-32/MPEG-2). Over a whole section including its trailing CRC_32 field
+ * the result is 0 if the section is intact.
+ *
+ * Returns: the CRC of @data
+ *
+ * Since: 1.16
+ */
+guint32
+gst_mpegts_crc32 (const guint8 * data, gsize size)
+{
+  static gsize initialized = 0;
+
+  g_return_val_if_fail (data != NULL || size == 0, 0);
+
+  if (g_once_init_enter (&initialized)) {
+    crc32_init ();
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return crc32_func (0xffffffff, data, size);
+}
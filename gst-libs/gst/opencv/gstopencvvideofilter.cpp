@@ -126,6 +126,24 @@ gst_opencv_video_filter_init (GstOpencvVideoFilter * transform)
 {
 }
 
+/* Wraps the first plane of @frame without copying, rows are @stride
+ * bytes apart which need not be width * pixel size */
+static inline cv::Mat
+gst_opencv_video_filter_frame_to_mat (GstVideoFrame * frame, gint cv_type)
+{
+  return cv::Mat (GST_VIDEO_FRAME_HEIGHT (frame), GST_VIDEO_FRAME_WIDTH (frame),
+      cv_type, GST_VIDEO_FRAME_PLANE_DATA (frame, 0),
+      GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0));
+}
+
+static inline void
+gst_opencv_video_filter_wrap_iplimage (IplImage * image, GstVideoFrame * frame)
+{
+  image->imageData = (char *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  image->widthStep = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+  image->imageSize = image->widthStep * GST_VIDEO_FRAME_HEIGHT (frame);
+}
+
 static GstFlowReturn
 gst_opencv_video_filter_transform_frame (GstVideoFilter *trans,
         GstVideoFrame *inframe, GstVideoFrame *outframe)
@@ -137,17 +155,22 @@ gst_opencv_video_filter_transform_frame (GstVideoFilter *trans,
   transform = GST_OPENCV_VIDEO_FILTER (trans);
   fclass = GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
 
+  if (fclass->cv_trans_mat_func) {
+    cv::Mat img = gst_opencv_video_filter_frame_to_mat (inframe,
+        transform->in_cv_type);
+    cv::Mat outimg = gst_opencv_video_filter_frame_to_mat (outframe,
+        transform->out_cv_type);
+
+    return fclass->cv_trans_mat_func (transform, inframe->buffer, img,
+        outframe->buffer, outimg);
+  }
+
   g_return_val_if_fail (fclass->cv_trans_func != NULL, GST_FLOW_ERROR);
   g_return_val_if_fail (transform->cvImage != NULL, GST_FLOW_ERROR);
   g_return_val_if_fail (transform->out_cvImage != NULL, GST_FLOW_ERROR);
 
-  transform->cvImage->imageData = (char *) inframe->data[0];
-  transform->cvImage->imageSize = inframe->info.size;
-  transform->cvImage->widthStep = inframe->info.stride[0];
-
-  transform->out_cvImage->imageData = (char *) outframe->data[0];
-  transform->out_cvImage->imageSize = outframe->info.size;
-  transform->out_cvImage->widthStep = outframe->info.stride[0];
+  gst_opencv_video_filter_wrap_iplimage (transform->cvImage, inframe);
+  gst_opencv_video_filter_wrap_iplimage (transform->out_cvImage, outframe);
 
   ret = fclass->cv_trans_func (transform, inframe->buffer, transform->cvImage,
       outframe->buffer, transform->out_cvImage);
@@ -166,12 +189,17 @@ gst_opencv_video_filter_transform_frame_ip (GstVideoFilter * trans,
   transform = GST_OPENCV_VIDEO_FILTER (trans);
   fclass = GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
 
+  if (fclass->cv_trans_ip_mat_func) {
+    cv::Mat img = gst_opencv_video_filter_frame_to_mat (frame,
+        transform->in_cv_type);
+
+    return fclass->cv_trans_ip_mat_func (transform, frame->buffer, img);
+  }
+
   g_return_val_if_fail (fclass->cv_trans_ip_func != NULL, GST_FLOW_ERROR);
   g_return_val_if_fail (transform->cvImage != NULL, GST_FLOW_ERROR);
 
-  transform->cvImage->imageData = (char *) frame->data[0];
-  transform->cvImage->imageSize = frame->info.size;
-  transform->cvImage->widthStep = frame->info.stride[0];
+  gst_opencv_video_filter_wrap_iplimage (transform->cvImage, frame);
 
   ret = fclass->cv_trans_ip_func (transform, frame->buffer, transform->cvImage);
 
@@ -208,6 +236,12 @@ gst_opencv_video_filter_set_info (GstVideoFilter * trans, GstCaps * incaps,
     return FALSE;
   }
 
+  if (!gst_opencv_cv_image_type_from_video_format (GST_VIDEO_INFO_FORMAT
+          (in_info), &transform->in_cv_type, NULL) ||
+      !gst_opencv_cv_image_type_from_video_format (GST_VIDEO_INFO_FORMAT
+          (out_info), &transform->out_cv_type, NULL))
+    return FALSE;
+
   if (klass->cv_set_caps) {
     if (!klass->cv_set_caps (transform, in_width, in_height, in_depth,
             in_channels, out_width, out_height, out_depth, out_channels))
@@ -48,9 +48,14 @@
 #include <gst/video/gstvideofilter.h>
 #include <gst/opencv/opencv-prelude.h>
 
+/* forward declare opencv types to avoid exposing them in this API */
+namespace cv
+{
+  class Mat;
+}
+
 G_BEGIN_DECLS
 
-/* forward declare opencv type to avoid exposing them in this API */
 typedef struct _IplImage IplImage;
 
 /* #defines don't like whitespacey bits */
@@ -77,6 +82,14 @@ typedef GstFlowReturn (*GstOpencvVideoFilterTransformFunc)
     (GstOpencvVideoFilter * transform, GstBuffer * buffer, IplImage * img,
     GstBuffer * outbuf, IplImage * outimg);
 
+/* cv::Mat variants, the images are views on the mapped video frame data
+ * using the frame's stride, no pixels are copied */
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformIPMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::Mat & img);
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::Mat & img,
+    GstBuffer * outbuf, cv::Mat & outimg);
+
 typedef gboolean (*GstOpencvVideoFilterSetCaps)
     (GstOpencvVideoFilter * transform, gint in_width, gint in_height,
     gint in_depth, gint in_channels, gint out_width, gint out_height,
@@ -90,6 +103,10 @@ struct _GstOpencvVideoFilter
 
   IplImage *cvImage;
   IplImage *out_cvImage;
+
+  /* opencv matrix type (CV_8UC3, ...) of the input and output frames */
+  gint in_cv_type;
+  gint out_cv_type;
 };
 
 struct _GstOpencvVideoFilterClass
@@ -100,6 +117,12 @@ struct _GstOpencvVideoFilterClass
   GstOpencvVideoFilterTransformIPFunc cv_trans_ip_func;
 
   GstOpencvVideoFilterSetCaps cv_set_caps;
+
+  /* Since 1.16. Preferred over the IplImage functions above when set.
+   * Appended so the older fields keep their offsets, but the class structure
+   * is bigger now: subclasses have to be rebuilt against this header. */
+  GstOpencvVideoFilterTransformMatFunc cv_trans_mat_func;
+  GstOpencvVideoFilterTransformIPMatFunc cv_trans_ip_mat_func;
 };
 
 GST_OPENCV_API
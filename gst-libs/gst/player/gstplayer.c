@@ -46,6 +46,7 @@
 #include "gstplayer.h"
 #include "gstplayer-signal-dispatcher-private.h"
 #include "gstplayer-video-renderer-private.h"
+#include "gstplayer-video-overlay-video-renderer.h"
 #include "gstplayer-media-info-private.h"
 
 #include <gst/gst.h>
@@ -67,6 +68,9 @@ GST_DEBUG_CATEGORY_STATIC (gst_player_debug);
 #define DEFAULT_RATE 1.0
 #define DEFAULT_POSITION_UPDATE_INTERVAL_MS 100
 #define DEFAULT_AUDIO_VIDEO_OFFSET 0
+#define DEFAULT_PRELOAD_MAX_URIS 1
+#define DEFAULT_PRELOAD_BUFFER_SIZE -1
+#define DEFAULT_PRELOAD_BUFFER_DURATION -1
 
 GQuark
 gst_player_error_quark (void)
@@ -82,6 +86,9 @@ typedef enum
   CONFIG_QUARK_USER_AGENT = 0,
   CONFIG_QUARK_POSITION_INTERVAL_UPDATE,
   CONFIG_QUARK_ACCURATE_SEEK,
+  CONFIG_QUARK_PRELOAD_MAX_URIS,
+  CONFIG_QUARK_PRELOAD_BUFFER_SIZE,
+  CONFIG_QUARK_PRELOAD_BUFFER_DURATION,
 
   CONFIG_QUARK_MAX
 } ConfigQuarkId;
@@ -90,6 +97,9 @@ static const gchar *_config_quark_strings[] = {
   "user-agent",
   "position-interval-update",
   "accurate-seek",
+  "preload-max-uris",
+  "preload-buffer-size",
+  "preload-buffer-duration",
 };
 
 GQuark _config_quark_table[CONFIG_QUARK_MAX];
@@ -134,6 +144,7 @@ enum
   SIGNAL_VOLUME_CHANGED,
   SIGNAL_MUTE_CHANGED,
   SIGNAL_SEEK_DONE,
+  SIGNAL_TIME_TO_FIRST_FRAME,
   SIGNAL_LAST
 };
 
@@ -164,6 +175,7 @@ struct _GstPlayer
 
   GstElement *playbin;
   GstBus *bus;
+  GSource *bus_source;
   GstState target_state, current_state;
   gboolean is_live, is_eos;
   GSource *tick_source, *ready_timeout_source;
@@ -198,8 +210,36 @@ struct _GstPlayer
   gchar *audio_sid;
   gchar *subtitle_sid;
   gulong stream_notify_id;
+
+  /* Standby pipelines, most recently preloaded first. Only used from the
+   * main context */
+  GList *preloads;
+  /* Time to first frame of a new URI, measured from the first play or
+   * pause request after it was set */
+  gboolean ttff_pending;
+  gboolean ttff_preloaded;
+  GstClockTime ttff_start;
 };
 
+/* A playbin prerolling a URI, to be swapped in by gst_player_set_uri() */
+typedef struct
+{
+  GstPlayer *player;
+  gchar *uri;
+  GstElement *playbin;
+  GSource *bus_source;
+  GstClockTime start_time;
+  /* video sinks with show-preroll-frame disabled, protected by player lock */
+  GList *sinks;
+  /* PRELOAD_REPLAY_MESSAGES posted in standby, for the player's handlers */
+  GQueue messages;
+} GstPlayerPreload;
+
+/* What the player needs to know about a pipeline that prerolled without it */
+#define PRELOAD_REPLAY_MESSAGES (GST_MESSAGE_TAG | \
+    GST_MESSAGE_DURATION_CHANGED | GST_MESSAGE_STREAM_COLLECTION | \
+    GST_MESSAGE_STREAMS_SELECTED)
+
 struct _GstPlayerClass
 {
   GstObjectClass parent_class;
@@ -270,6 +310,15 @@ static void *get_from_tags (GstPlayer * self, GstPlayerMediaInfo * media_info,
 static void *get_cover_sample (GstTagList * tags);
 
 static void remove_seek_source (GstPlayer * self);
+static void remove_ready_timeout_source (GstPlayer * self);
+static GstElement *gst_player_create_playbin (GstPlayer * self,
+    const gchar * name);
+static void gst_player_attach_playbin (GstPlayer * self,
+    GstElement * playbin);
+static void gst_player_detach_playbin (GstPlayer * self);
+static void pipeline_prerolled (GstPlayer * self);
+static void source_setup_cb (GstElement * playbin, GstElement * source,
+    GstPlayer * self);
 
 static void
 gst_player_init (GstPlayer * self)
@@ -295,6 +344,7 @@ gst_player_init (GstPlayer * self)
   self->seek_position = GST_CLOCK_TIME_NONE;
   self->last_seek_time = GST_CLOCK_TIME_NONE;
   self->inhibit_sigs = FALSE;
+  self->ttff_start = GST_CLOCK_TIME_NONE;
 
   GST_TRACE_OBJECT (self, "Initialized");
 }
@@ -479,6 +529,20 @@ gst_player_class_init (GstPlayerClass * klass)
       G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
       NULL, NULL, G_TYPE_NONE, 1, GST_TYPE_CLOCK_TIME);
 
+  /**
+   * GstPlayer::time-to-first-frame:
+   * @player: the #GstPlayer
+   * @time: time from the first play or pause request for a new URI until it
+   *   reached that state
+   * @preloaded: whether the URI was prepared by gst_player_preload_uri()
+   *
+   * Since: 1.16
+   */
+  signals[SIGNAL_TIME_TO_FIRST_FRAME] =
+      g_signal_new ("time-to-first-frame", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, GST_TYPE_CLOCK_TIME, G_TYPE_BOOLEAN);
+
   config_quark_initialize ();
 }
 
@@ -555,6 +619,404 @@ gst_player_constructed (GObject * object)
   G_OBJECT_CLASS (parent_class)->constructed (object);
 }
 
+/* Settings of the current pipeline that the next one has to take over */
+static const gchar *playbin_settings[] = {
+  "flags", "volume", "mute", "av-offset", "video-multiview-mode",
+  "video-multiview-flags"
+};
+
+static void
+copy_playbin_settings (GstElement * from, GstElement * to)
+{
+  GValue value = G_VALUE_INIT;
+  GParamSpec *pspec;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (playbin_settings); i++) {
+    pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (from),
+        playbin_settings[i]);
+    if (!pspec)
+      continue;
+
+    g_value_init (&value, pspec->value_type);
+    g_object_get_property (G_OBJECT (from), pspec->name, &value);
+    g_object_set_property (G_OBJECT (to), pspec->name, &value);
+    g_value_unset (&value);
+  }
+}
+
+/* A new sink of the same type and configuration as @sink, for a standby
+ * pipeline */
+static GstElement *
+clone_sink (GstElement * sink)
+{
+  GstElementFactory *factory = gst_element_get_factory (sink);
+  GValue value = G_VALUE_INIT;
+  GParamSpec **pspecs;
+  GstElement *clone;
+  guint i, n_pspecs;
+
+  if (!factory || !(clone = gst_element_factory_create (factory, NULL)))
+    return NULL;
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (sink),
+      &n_pspecs);
+  for (i = 0; i < n_pspecs; i++) {
+    GParamSpec *pspec = pspecs[i];
+
+    if ((pspec->flags & G_PARAM_READWRITE) != G_PARAM_READWRITE
+        || (pspec->flags & G_PARAM_CONSTRUCT_ONLY)
+        || G_TYPE_IS_OBJECT (pspec->value_type)
+        || G_TYPE_IS_INTERFACE (pspec->value_type)
+        || pspec->value_type == G_TYPE_POINTER
+        || pspec->owner_type == GST_TYPE_OBJECT)
+      continue;
+
+    g_value_init (&value, pspec->value_type);
+    g_object_get_property (G_OBJECT (sink), pspec->name, &value);
+    g_object_set_property (G_OBJECT (clone), pspec->name, &value);
+    g_value_unset (&value);
+  }
+  g_free (pspecs);
+
+  return clone;
+}
+
+static GstPlayerPreload *
+gst_player_find_preload (GstPlayer * self, const gchar * uri)
+{
+  GList *l;
+
+  for (l = self->preloads; l; l = l->next) {
+    GstPlayerPreload *preload = l->data;
+
+    if (g_strcmp0 (preload->uri, uri) == 0)
+      return preload;
+  }
+
+  return NULL;
+}
+
+static void
+gst_player_preload_free (GstPlayerPreload * preload)
+{
+  if (preload->bus_source) {
+    g_source_destroy (preload->bus_source);
+    g_source_unref (preload->bus_source);
+  }
+  if (preload->playbin) {
+    gst_element_set_state (preload->playbin, GST_STATE_NULL);
+    gst_object_unref (preload->playbin);
+  }
+  g_list_free_full (preload->sinks, gst_object_unref);
+  g_queue_foreach (&preload->messages, (GFunc) gst_message_unref, NULL);
+  g_queue_clear (&preload->messages);
+  g_free (preload->uri);
+  g_free (preload);
+}
+
+static void
+gst_player_cancel_preloads (GstPlayer * self, const gchar * uri)
+{
+  GList *l, *next;
+
+  for (l = self->preloads; l; l = next) {
+    GstPlayerPreload *preload = l->data;
+
+    next = l->next;
+    if (uri && g_strcmp0 (preload->uri, uri) != 0)
+      continue;
+
+    GST_DEBUG_OBJECT (self, "Cancelling preload of '%s'", preload->uri);
+    self->preloads = g_list_delete_link (self->preloads, l);
+    gst_player_preload_free (preload);
+  }
+}
+
+/* Keeps the prerolled frame off the screen until the pipeline is used */
+static void
+preload_element_setup_cb (G_GNUC_UNUSED GstElement * playbin,
+    GstElement * element, GstPlayerPreload * preload)
+{
+  if (!g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+          "show-preroll-frame"))
+    return;
+
+  g_mutex_lock (&preload->player->lock);
+  if (!g_list_find (preload->sinks, element)) {
+    g_object_set (element, "show-preroll-frame", FALSE, NULL);
+    preload->sinks = g_list_prepend (preload->sinks,
+        gst_object_ref (element));
+  }
+  g_mutex_unlock (&preload->player->lock);
+}
+
+static gboolean
+preload_bus_cb (G_GNUC_UNUSED GstBus * bus, GstMessage * msg,
+    gpointer user_data)
+{
+  GstPlayerPreload *preload = user_data;
+  GstPlayer *self = preload->player;
+
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *err = NULL;
+
+      gst_message_parse_error (msg, &err, NULL);
+      GST_WARNING_OBJECT (self, "Preloading '%s' failed: %s", preload->uri,
+          err->message);
+      g_clear_error (&err);
+
+      self->preloads = g_list_remove (self->preloads, preload);
+      gst_player_preload_free (preload);
+      return G_SOURCE_REMOVE;
+    }
+    case GST_MESSAGE_ASYNC_DONE:
+      GST_DEBUG_OBJECT (self, "Preloaded '%s' in %" GST_TIME_FORMAT,
+          preload->uri, GST_TIME_ARGS (gst_util_get_timestamp () -
+              preload->start_time));
+      break;
+    default:
+      if (GST_MESSAGE_TYPE (msg) & PRELOAD_REPLAY_MESSAGES)
+        g_queue_push_tail (&preload->messages, gst_message_ref (msg));
+      break;
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* The window of the video overlay renderer has to be known before the
+ * standby pipeline creates its sink and prerolls */
+static void
+gst_player_preload_set_window (GstPlayer * self, GstElement * playbin)
+{
+  GstPlayerVideoOverlayVideoRenderer *renderer;
+  gint x, y, width, height;
+
+  if (!GST_IS_PLAYER_VIDEO_OVERLAY_VIDEO_RENDERER (self->video_renderer))
+    return;
+
+  renderer = GST_PLAYER_VIDEO_OVERLAY_VIDEO_RENDERER (self->video_renderer);
+  gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (playbin),
+      (guintptr)
+      gst_player_video_overlay_video_renderer_get_window_handle (renderer));
+
+  gst_player_video_overlay_video_renderer_get_render_rectangle (renderer, &x,
+      &y, &width, &height);
+  if (width != -1 || height != -1)
+    gst_video_overlay_set_render_rectangle (GST_VIDEO_OVERLAY (playbin), x, y,
+        width, height);
+}
+
+static void
+gst_player_preload_internal (GstPlayer * self, const gchar * uri)
+{
+  GstPlayerPreload *preload;
+  GstElement *sink, *clone;
+  GstStateChangeReturn state_ret;
+  GstBus *bus;
+  guint max_uris;
+  gint buffer_size;
+  gint64 buffer_duration;
+  GList *last;
+
+  g_mutex_lock (&self->lock);
+  max_uris = gst_player_config_get_preload_max_uris (self->config);
+  buffer_size = gst_player_config_get_preload_buffer_size (self->config);
+  buffer_duration =
+      gst_player_config_get_preload_buffer_duration (self->config);
+  g_mutex_unlock (&self->lock);
+
+  if ((preload = gst_player_find_preload (self, uri))) {
+    GST_DEBUG_OBJECT (self, "'%s' is already preloaded", uri);
+    self->preloads = g_list_remove (self->preloads, preload);
+    self->preloads = g_list_prepend (self->preloads, preload);
+    return;
+  }
+
+  /* make room by cancelling the least recently preloaded URIs */
+  while (self->preloads && g_list_length (self->preloads) >= max_uris) {
+    last = g_list_last (self->preloads);
+    preload = last->data;
+
+    GST_DEBUG_OBJECT (self, "Cancelling preload of '%s'", preload->uri);
+    self->preloads = g_list_delete_link (self->preloads, last);
+    gst_player_preload_free (preload);
+  }
+
+  if (max_uris == 0)
+    return;
+
+  GST_DEBUG_OBJECT (self, "Preloading '%s'", uri);
+
+  preload = g_new0 (GstPlayerPreload, 1);
+  preload->player = self;
+  preload->uri = g_strdup (uri);
+  preload->start_time = gst_util_get_timestamp ();
+  preload->playbin = gst_player_create_playbin (self, NULL);
+  if (!preload->playbin) {
+    gst_player_preload_free (preload);
+    return;
+  }
+
+  g_signal_connect (preload->playbin, "element-setup",
+      G_CALLBACK (preload_element_setup_cb), preload);
+  g_signal_connect (preload->playbin, "source-setup",
+      G_CALLBACK (source_setup_cb), self);
+
+  /* sinks like the ones of the current pipeline, as set by the application
+   * or the video renderer */
+  g_object_get (self->playbin, "video-sink", &sink, NULL);
+  if (sink) {
+    if ((clone = clone_sink (sink))) {
+      preload_element_setup_cb (preload->playbin, clone, preload);
+      g_object_set (preload->playbin, "video-sink", clone, NULL);
+    }
+    gst_object_unref (sink);
+  }
+  g_object_get (self->playbin, "audio-sink", &sink, NULL);
+  if (sink) {
+    if ((clone = clone_sink (sink)))
+      g_object_set (preload->playbin, "audio-sink", clone, NULL);
+    gst_object_unref (sink);
+  }
+
+  copy_playbin_settings (self->playbin, preload->playbin);
+  gst_player_preload_set_window (self, preload->playbin);
+  g_object_set (preload->playbin, "uri", uri, "buffer-size", buffer_size,
+      "buffer-duration", buffer_duration, NULL);
+
+  bus = gst_element_get_bus (preload->playbin);
+  preload->bus_source = gst_bus_create_watch (bus);
+  g_source_set_callback (preload->bus_source, (GSourceFunc) preload_bus_cb,
+      preload, NULL);
+  g_source_attach (preload->bus_source, self->context);
+  gst_object_unref (bus);
+
+  self->preloads = g_list_prepend (self->preloads, preload);
+
+  state_ret = gst_element_set_state (preload->playbin, GST_STATE_PAUSED);
+  if (state_ret == GST_STATE_CHANGE_FAILURE) {
+    GST_WARNING_OBJECT (self, "Failed to preload '%s'", uri);
+    gst_player_cancel_preloads (self, uri);
+  }
+}
+
+/* Replaces the stopped pipeline by the standby one of @preload */
+static void
+gst_player_switch_to_preload (GstPlayer * self, GstPlayerPreload * preload)
+{
+  GstElement *old_playbin = self->playbin;
+  GstElement *playbin = preload->playbin;
+  GstStateChangeReturn state_ret;
+  GstMessage *msg;
+  GstBus *bus;
+  GList *l;
+
+  GST_DEBUG_OBJECT (self, "Switching to preloaded '%s'", preload->uri);
+
+  self->preloads = g_list_remove (self->preloads, preload);
+
+  g_source_destroy (preload->bus_source);
+  g_source_unref (preload->bus_source);
+  preload->bus_source = NULL;
+  g_signal_handlers_disconnect_by_data (playbin, preload);
+  g_signal_handlers_disconnect_by_data (playbin, self);
+
+  g_mutex_lock (&self->lock);
+  for (l = preload->sinks; l; l = l->next)
+    g_object_set (l->data, "show-preroll-frame", TRUE, NULL);
+  g_mutex_unlock (&self->lock);
+
+  /* the messages up to now were for the preload watch, anything from now on
+   * goes to the player's. The state is taken from the pipeline below, the
+   * rest of what the watch did not get to is replayed with the others */
+  bus = gst_element_get_bus (playbin);
+  while ((msg = gst_bus_pop (bus))) {
+    if (GST_MESSAGE_TYPE (msg) & (PRELOAD_REPLAY_MESSAGES | GST_MESSAGE_ERROR
+            | GST_MESSAGE_WARNING))
+      g_queue_push_tail (&preload->messages, msg);
+    else
+      gst_message_unref (msg);
+  }
+  gst_object_unref (bus);
+  state_ret = gst_element_get_state (playbin, NULL, NULL, 0);
+
+  copy_playbin_settings (old_playbin, playbin);
+
+  gst_player_detach_playbin (self);
+  gst_element_set_state (old_playbin, GST_STATE_NULL);
+  gst_object_unref (old_playbin);
+
+  gst_player_attach_playbin (self, playbin);
+  preload->playbin = NULL;
+
+  /* in posting order, before the preroll is handled as it would have been
+   * with the player's own pipeline */
+  while ((msg = g_queue_pop_head (&preload->messages))) {
+    gst_bus_async_signal_func (self->bus, msg, NULL);
+    gst_message_unref (msg);
+  }
+  gst_player_preload_free (preload);
+
+  if (self->current_vis_element)
+    g_object_set (playbin, "vis-plugin", self->current_vis_element, NULL);
+
+  /* lets the renderer bind its window to the new pipeline. That prerolled
+   * with a clone of the renderer's sink, which is only used again from the
+   * next URI on, as in a new pipeline */
+  if (self->video_renderer) {
+    GstElement *video_sink =
+        gst_player_video_renderer_create_video_sink (self->video_renderer,
+        self);
+
+    if (video_sink)
+      g_object_set (playbin, "video-sink", video_sink, NULL);
+  }
+
+  if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
+    self->is_live = TRUE;
+    self->current_state = GST_STATE_PAUSED;
+  } else if (state_ret == GST_STATE_CHANGE_SUCCESS) {
+    self->current_state = GST_STATE_PAUSED;
+    pipeline_prerolled (self);
+  }
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  gchar *uri;
+} PreloadData;
+
+static void
+preload_data_free (PreloadData * data)
+{
+  g_object_unref (data->player);
+  g_free (data->uri);
+  g_free (data);
+}
+
+static gboolean
+gst_player_preload_uri_dispatch (gpointer user_data)
+{
+  PreloadData *data = user_data;
+
+  gst_player_preload_internal (data->player, data->uri);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gst_player_cancel_preload_dispatch (gpointer user_data)
+{
+  PreloadData *data = user_data;
+
+  gst_player_cancel_preloads (data->player, data->uri);
+
+  return G_SOURCE_REMOVE;
+}
+
 typedef struct
 {
   GstPlayer *player;
@@ -581,14 +1043,30 @@ static gboolean
 gst_player_set_uri_internal (gpointer user_data)
 {
   GstPlayer *self = user_data;
+  GstPlayerPreload *preload;
+  gchar *uri;
 
   gst_player_stop_internal (self, FALSE);
 
+  g_mutex_lock (&self->lock);
+  uri = g_strdup (self->uri);
+  g_mutex_unlock (&self->lock);
+
+  preload = gst_player_find_preload (self, uri);
+  if (preload)
+    gst_player_switch_to_preload (self, preload);
+  self->ttff_pending = TRUE;
+  self->ttff_preloaded = preload != NULL;
+  g_free (uri);
+
   g_mutex_lock (&self->lock);
 
   GST_DEBUG_OBJECT (self, "Changing URI to '%s'", GST_STR_NULL (self->uri));
 
-  g_object_set (self->playbin, "uri", self->uri, NULL);
+  /* a preloaded pipeline already plays it, setting it again would queue it
+   * as the next URI */
+  if (!preload)
+    g_object_set (self->playbin, "uri", self->uri, NULL);
 
   if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
           signals[SIGNAL_URI_LOADED], 0, NULL, NULL, NULL) != 0) {
@@ -601,7 +1079,8 @@ gst_player_set_uri_internal (gpointer user_data)
         (GDestroyNotify) uri_loaded_signal_data_free);
   }
 
-  g_object_set (self->playbin, "suburi", NULL, NULL);
+  if (!preload)
+    g_object_set (self->playbin, "suburi", NULL, NULL);
 
   g_mutex_unlock (&self->lock);
 
@@ -1569,6 +2048,89 @@ emit_seek_done (GstPlayer * self)
   }
 }
 
+typedef struct
+{
+  GstPlayer *player;
+  GstClockTime time;
+  gboolean preloaded;
+} TimeToFirstFrameSignalData;
+
+static void
+time_to_first_frame_dispatch (gpointer user_data)
+{
+  TimeToFirstFrameSignalData *data = user_data;
+
+  if (data->player->inhibit_sigs)
+    return;
+
+  g_signal_emit (data->player, signals[SIGNAL_TIME_TO_FIRST_FRAME], 0,
+      data->time, data->preloaded);
+}
+
+static void
+time_to_first_frame_signal_data_free (TimeToFirstFrameSignalData * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+static void
+emit_time_to_first_frame (GstPlayer * self)
+{
+  GstClockTime time = gst_util_get_timestamp () - self->ttff_start;
+
+  GST_DEBUG_OBJECT (self, "Time to first frame %" GST_TIME_FORMAT
+      " (preloaded %d)", GST_TIME_ARGS (time), self->ttff_preloaded);
+  self->ttff_start = GST_CLOCK_TIME_NONE;
+
+  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_TIME_TO_FIRST_FRAME], 0, NULL, NULL, NULL) != 0) {
+    TimeToFirstFrameSignalData *data = g_new (TimeToFirstFrameSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->time = time;
+    data->preloaded = self->ttff_preloaded;
+    gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+        time_to_first_frame_dispatch, data,
+        (GDestroyNotify) time_to_first_frame_signal_data_free);
+  }
+}
+
+static void
+pipeline_prerolled (GstPlayer * self)
+{
+  GstElement *video_sink;
+  GstPad *video_sink_pad;
+  gint64 duration = -1;
+
+  g_mutex_lock (&self->lock);
+  if (self->media_info)
+    g_object_unref (self->media_info);
+  self->media_info = gst_player_media_info_create (self);
+  g_mutex_unlock (&self->lock);
+  emit_media_info_updated_signal (self);
+
+  g_object_get (self->playbin, "video-sink", &video_sink, NULL);
+
+  if (video_sink) {
+    video_sink_pad = gst_element_get_static_pad (video_sink, "sink");
+
+    if (video_sink_pad) {
+      g_signal_connect (video_sink_pad, "notify::caps",
+          (GCallback) notify_caps_cb, self);
+      gst_object_unref (video_sink_pad);
+    }
+    gst_object_unref (video_sink);
+  }
+
+  check_video_dimensions_changed (self);
+  if (gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration)) {
+    emit_duration_changed (self, duration);
+  } else {
+    self->cached_duration = GST_CLOCK_TIME_NONE;
+  }
+}
+
 static void
 state_changed_cb (G_GNUC_UNUSED GstBus * bus, GstMessage * msg,
     gpointer user_data)
@@ -1594,41 +2156,15 @@ state_changed_cb (G_GNUC_UNUSED GstBus * bus, GstMessage * msg,
 
     self->current_state = new_state;
 
+    if (new_state == self->target_state && new_state >= GST_STATE_PAUSED
+        && pending_state == GST_STATE_VOID_PENDING
+        && GST_CLOCK_TIME_IS_VALID (self->ttff_start))
+      emit_time_to_first_frame (self);
+
     if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED
         && pending_state == GST_STATE_VOID_PENDING) {
-      GstElement *video_sink;
-      GstPad *video_sink_pad;
-      gint64 duration = -1;
-
       GST_DEBUG_OBJECT (self, "Initial PAUSED - pre-rolled");
-
-      g_mutex_lock (&self->lock);
-      if (self->media_info)
-        g_object_unref (self->media_info);
-      self->media_info = gst_player_media_info_create (self);
-      g_mutex_unlock (&self->lock);
-      emit_media_info_updated_signal (self);
-
-      g_object_get (self->playbin, "video-sink", &video_sink, NULL);
-
-      if (video_sink) {
-        video_sink_pad = gst_element_get_static_pad (video_sink, "sink");
-
-        if (video_sink_pad) {
-          g_signal_connect (video_sink_pad, "notify::caps",
-              (GCallback) notify_caps_cb, self);
-          gst_object_unref (video_sink_pad);
-        }
-        gst_object_unref (video_sink);
-      }
-
-      check_video_dimensions_changed (self);
-      if (gst_element_query_duration (self->playbin, GST_FORMAT_TIME,
-              &duration)) {
-        emit_duration_changed (self, duration);
-      } else {
-        self->cached_duration = GST_CLOCK_TIME_NONE;
-      }
+      pipeline_prerolled (self);
     }
 
     if (new_state == GST_STATE_PAUSED
@@ -2856,58 +3392,42 @@ source_setup_cb (GstElement * playbin, GstElement * source, GstPlayer * self)
   }
 }
 
-static gpointer
-gst_player_main (gpointer data)
+static GstElement *
+gst_player_create_playbin (GstPlayer * self, const gchar * name)
 {
-  GstPlayer *self = GST_PLAYER (data);
-  GstBus *bus;
-  GSource *source;
-  GSource *bus_source;
-  GstElement *scaletempo;
-  const gchar *env;
-
-  GST_TRACE_OBJECT (self, "Starting main thread");
-
-  g_main_context_push_thread_default (self->context);
-
-  source = g_idle_source_new ();
-  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
-      NULL);
-  g_source_attach (source, self->context);
-  g_source_unref (source);
-
-  env = g_getenv ("GST_PLAYER_USE_PLAYBIN3");
-  if (env && g_str_has_prefix (env, "1"))
-    self->use_playbin3 = TRUE;
+  GstElement *playbin, *scaletempo;
 
-  if (self->use_playbin3) {
-    GST_DEBUG_OBJECT (self, "playbin3 enabled");
-    self->playbin = gst_element_factory_make ("playbin3", "playbin3");
-  } else
-    self->playbin = gst_element_factory_make ("playbin", "playbin");
-
-  if (self->video_renderer) {
-    GstElement *video_sink =
-        gst_player_video_renderer_create_video_sink (self->video_renderer,
-        self);
+  if (self->use_playbin3)
+    playbin = gst_element_factory_make ("playbin3", name);
+  else
+    playbin = gst_element_factory_make ("playbin", name);
 
-    if (video_sink)
-      g_object_set (self->playbin, "video-sink", video_sink, NULL);
-  }
+  if (!playbin)
+    return NULL;
 
   scaletempo = gst_element_factory_make ("scaletempo", NULL);
   if (scaletempo) {
-    g_object_set (self->playbin, "audio-filter", scaletempo, NULL);
-  } else {
+    g_object_set (playbin, "audio-filter", scaletempo, NULL);
+  } else if (!self->playbin) {
     g_warning ("GstPlayer: scaletempo element not available. Audio pitch "
         "will not be preserved during trick modes");
   }
 
+  return playbin;
+}
+
+static void
+gst_player_attach_playbin (GstPlayer * self, GstElement * playbin)
+{
+  GstBus *bus;
+
+  self->playbin = playbin;
+
   self->bus = bus = gst_element_get_bus (self->playbin);
-  bus_source = gst_bus_create_watch (bus);
-  g_source_set_callback (bus_source, (GSourceFunc) gst_bus_async_signal_func,
-      NULL, NULL);
-  g_source_attach (bus_source, self->context);
+  self->bus_source = gst_bus_create_watch (bus);
+  g_source_set_callback (self->bus_source,
+      (GSourceFunc) gst_bus_async_signal_func, NULL, NULL);
+  g_source_attach (self->bus_source, self->context);
 
   g_signal_connect (G_OBJECT (bus), "message::error", G_CALLBACK (error_cb),
       self);
@@ -2957,6 +3477,61 @@ gst_player_main (gpointer data)
       G_CALLBACK (mute_notify_cb), self);
   g_signal_connect (self->playbin, "source-setup",
       G_CALLBACK (source_setup_cb), self);
+}
+
+/* Disconnects from the pipeline, which stays owned by the caller */
+static void
+gst_player_detach_playbin (GstPlayer * self)
+{
+  g_source_destroy (self->bus_source);
+  g_source_unref (self->bus_source);
+  self->bus_source = NULL;
+
+  g_signal_handlers_disconnect_by_data (self->bus, self);
+  gst_object_unref (self->bus);
+  self->bus = NULL;
+
+  g_signal_handlers_disconnect_by_data (self->playbin, self);
+}
+
+static gpointer
+gst_player_main (gpointer data)
+{
+  GstPlayer *self = GST_PLAYER (data);
+  GSource *source;
+  GstElement *playbin;
+  const gchar *env;
+
+  GST_TRACE_OBJECT (self, "Starting main thread");
+
+  g_main_context_push_thread_default (self->context);
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
+      NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+
+  env = g_getenv ("GST_PLAYER_USE_PLAYBIN3");
+  if (env && g_str_has_prefix (env, "1"))
+    self->use_playbin3 = TRUE;
+
+  if (self->use_playbin3) {
+    GST_DEBUG_OBJECT (self, "playbin3 enabled");
+    playbin = gst_player_create_playbin (self, "playbin3");
+  } else
+    playbin = gst_player_create_playbin (self, "playbin");
+
+  gst_player_attach_playbin (self, playbin);
+
+  if (self->video_renderer) {
+    GstElement *video_sink =
+        gst_player_video_renderer_create_video_sink (self->video_renderer,
+        self);
+
+    if (video_sink)
+      g_object_set (self->playbin, "video-sink", video_sink, NULL);
+  }
 
   self->target_state = GST_STATE_NULL;
   self->current_state = GST_STATE_NULL;
@@ -2970,9 +3545,8 @@ gst_player_main (gpointer data)
   g_main_loop_run (self->loop);
   GST_TRACE_OBJECT (self, "Stopped main loop");
 
-  g_source_destroy (bus_source);
-  g_source_unref (bus_source);
-  gst_object_unref (bus);
+  gst_player_cancel_preloads (self, NULL);
+  gst_player_detach_playbin (self);
 
   remove_tick_source (self);
   remove_ready_timeout_source (self);
@@ -3067,6 +3641,11 @@ gst_player_play_internal (gpointer user_data)
   remove_ready_timeout_source (self);
   self->target_state = GST_STATE_PLAYING;
 
+  if (self->ttff_pending) {
+    self->ttff_pending = FALSE;
+    self->ttff_start = gst_util_get_timestamp ();
+  }
+
   if (self->current_state < GST_STATE_PAUSED)
     change_state (self, GST_PLAYER_STATE_BUFFERING);
 
@@ -3145,6 +3724,11 @@ gst_player_pause_internal (gpointer user_data)
 
   self->target_state = GST_STATE_PAUSED;
 
+  if (self->ttff_pending) {
+    self->ttff_pending = FALSE;
+    self->ttff_start = gst_util_get_timestamp ();
+  }
+
   if (self->current_state < GST_STATE_PAUSED)
     change_state (self, GST_PLAYER_STATE_BUFFERING);
 
@@ -3209,6 +3793,7 @@ gst_player_stop_internal (GstPlayer * self, gboolean transient)
   self->current_state = GST_STATE_READY;
   self->is_live = FALSE;
   self->is_eos = FALSE;
+  self->ttff_start = GST_CLOCK_TIME_NONE;
   gst_bus_set_flushing (self->bus, TRUE);
   gst_element_set_state (self->playbin, GST_STATE_READY);
   gst_bus_set_flushing (self->bus, FALSE);
@@ -3502,6 +4087,67 @@ gst_player_set_uri (GstPlayer * self, const gchar * val)
   g_object_set (self, "uri", val, NULL);
 }
 
+/**
+ * gst_player_preload_uri:
+ * @player: #GstPlayer instance
+ * @uri: a URI that is likely to be played next
+ *
+ * Prepares playback of @uri in a standby pipeline, which connects and
+ * prerolls to PAUSED while the current URI keeps playing. A later
+ * gst_player_set_uri() with the same URI swaps that pipeline in instead of
+ * starting from scratch, so that playback starts with the already decoded
+ * first frame. The standby pipeline uses sinks of the same type and
+ * configuration as the current one.
+ *
+ * Up to gst_player_config_get_preload_max_uris() URIs are kept preloaded,
+ * the least recently preloaded one is cancelled to make room for another.
+ * The data buffered by each is bounded by the preload-buffer-size and
+ * preload-buffer-duration configuration. Failing preloads are dropped
+ * silently, setting their URI then starts it normally. Live sources do not
+ * preroll, for them only the connection is set up ahead.
+ *
+ * Since: 1.16
+ */
+void
+gst_player_preload_uri (GstPlayer * self, const gchar * uri)
+{
+  PreloadData *data;
+
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (uri != NULL);
+
+  data = g_new (PreloadData, 1);
+  data->player = g_object_ref (self);
+  data->uri = g_strdup (uri);
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_preload_uri_dispatch, data,
+      (GDestroyNotify) preload_data_free);
+}
+
+/**
+ * gst_player_cancel_preload:
+ * @player: #GstPlayer instance
+ * @uri: (allow-none): a URI passed to gst_player_preload_uri(), or %NULL
+ *
+ * Shuts down the standby pipeline of @uri, or all of them if @uri is %NULL.
+ *
+ * Since: 1.16
+ */
+void
+gst_player_cancel_preload (GstPlayer * self, const gchar * uri)
+{
+  PreloadData *data;
+
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  data = g_new (PreloadData, 1);
+  data->player = g_object_ref (self);
+  data->uri = g_strdup (uri);
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_cancel_preload_dispatch, data,
+      (GDestroyNotify) preload_data_free);
+}
+
 /**
  * gst_player_set_subtitle_uri:
  * @player: #GstPlayer instance
@@ -4669,6 +5315,130 @@ gst_player_config_get_seek_accurate (const GstStructure * config)
   return accurate;
 }
 
+/**
+ * gst_player_config_set_preload_max_uris:
+ * @config: a #GstPlayer configuration
+ * @max_uris: maximum number of standby pipelines
+ *
+ * Set how many URIs gst_player_preload_uri() keeps preloaded at the same
+ * time. 0 disables preloading. The default is 1.
+ *
+ * Since: 1.16
+ */
+void
+gst_player_config_set_preload_max_uris (GstStructure * config, guint max_uris)
+{
+  g_return_if_fail (config != NULL);
+
+  gst_structure_id_set (config,
+      CONFIG_QUARK (PRELOAD_MAX_URIS), G_TYPE_UINT, max_uris, NULL);
+}
+
+/**
+ * gst_player_config_get_preload_max_uris:
+ * @config: a #GstPlayer configuration
+ *
+ * Returns: the maximum number of preloaded URIs
+ *
+ * Since: 1.16
+ */
+guint
+gst_player_config_get_preload_max_uris (const GstStructure * config)
+{
+  guint max_uris = DEFAULT_PRELOAD_MAX_URIS;
+
+  g_return_val_if_fail (config != NULL, DEFAULT_PRELOAD_MAX_URIS);
+
+  gst_structure_id_get (config,
+      CONFIG_QUARK (PRELOAD_MAX_URIS), G_TYPE_UINT, &max_uris, NULL);
+
+  return max_uris;
+}
+
+/**
+ * gst_player_config_set_preload_buffer_size:
+ * @config: a #GstPlayer configuration
+ * @size: maximum bytes buffered, or -1 for the playbin default
+ *
+ * Set the amount of network data each standby pipeline buffers while it
+ * waits to be used.
+ *
+ * Since: 1.16
+ */
+void
+gst_player_config_set_preload_buffer_size (GstStructure * config, gint size)
+{
+  g_return_if_fail (config != NULL);
+  g_return_if_fail (size >= -1);
+
+  gst_structure_id_set (config,
+      CONFIG_QUARK (PRELOAD_BUFFER_SIZE), G_TYPE_INT, size, NULL);
+}
+
+/**
+ * gst_player_config_get_preload_buffer_size:
+ * @config: a #GstPlayer configuration
+ *
+ * Returns: the buffer size of standby pipelines in bytes, or -1
+ *
+ * Since: 1.16
+ */
+gint
+gst_player_config_get_preload_buffer_size (const GstStructure * config)
+{
+  gint size = DEFAULT_PRELOAD_BUFFER_SIZE;
+
+  g_return_val_if_fail (config != NULL, DEFAULT_PRELOAD_BUFFER_SIZE);
+
+  gst_structure_id_get (config,
+      CONFIG_QUARK (PRELOAD_BUFFER_SIZE), G_TYPE_INT, &size, NULL);
+
+  return size;
+}
+
+/**
+ * gst_player_config_set_preload_buffer_duration:
+ * @config: a #GstPlayer configuration
+ * @duration: maximum duration buffered in nanoseconds, or -1 for the
+ *   playbin default
+ *
+ * Set the duration of network data each standby pipeline buffers while it
+ * waits to be used.
+ *
+ * Since: 1.16
+ */
+void
+gst_player_config_set_preload_buffer_duration (GstStructure * config,
+    gint64 duration)
+{
+  g_return_if_fail (config != NULL);
+  g_return_if_fail (duration >= -1);
+
+  gst_structure_id_set (config,
+      CONFIG_QUARK (PRELOAD_BUFFER_DURATION), G_TYPE_INT64, duration, NULL);
+}
+
+/**
+ * gst_player_config_get_preload_buffer_duration:
+ * @config: a #GstPlayer configuration
+ *
+ * Returns: the buffer duration of standby pipelines in nanoseconds, or -1
+ *
+ * Since: 1.16
+ */
+gint64
+gst_player_config_get_preload_buffer_duration (const GstStructure * config)
+{
+  gint64 duration = DEFAULT_PRELOAD_BUFFER_DURATION;
+
+  g_return_val_if_fail (config != NULL, DEFAULT_PRELOAD_BUFFER_DURATION);
+
+  gst_structure_id_get (config,
+      CONFIG_QUARK (PRELOAD_BUFFER_DURATION), G_TYPE_INT64, &duration, NULL);
+
+  return duration;
+}
+
 /**
  * gst_player_get_video_snapshot:
  * @player: #GstPlayer instance
@@ -134,6 +134,14 @@ gdouble      gst_player_get_rate                      (GstPlayer    * player);
 GST_PLAYER_API
 gchar *      gst_player_get_uri                       (GstPlayer    * player);
 
+GST_PLAYER_API
+void         gst_player_preload_uri                   (GstPlayer    * player,
+                                                       const gchar  * uri);
+
+GST_PLAYER_API
+void         gst_player_cancel_preload                (GstPlayer    * player,
+                                                       const gchar  * uri);
+
 GST_PLAYER_API
 void         gst_player_set_uri                       (GstPlayer    * player,
                                                        const gchar  * uri);
@@ -278,6 +286,27 @@ void           gst_player_config_set_seek_accurate (GstStructure * config, gbool
 GST_PLAYER_API
 gboolean       gst_player_config_get_seek_accurate (const GstStructure * config);
 
+GST_PLAYER_API
+void           gst_player_config_set_preload_max_uris (GstStructure * config,
+                                                       guint          max_uris);
+
+GST_PLAYER_API
+guint          gst_player_config_get_preload_max_uris (const GstStructure * config);
+
+GST_PLAYER_API
+void           gst_player_config_set_preload_buffer_size (GstStructure * config,
+                                                          gint           size);
+
+GST_PLAYER_API
+gint           gst_player_config_get_preload_buffer_size (const GstStructure * config);
+
+GST_PLAYER_API
+void           gst_player_config_set_preload_buffer_duration (GstStructure * config,
+                                                              gint64         duration);
+
+GST_PLAYER_API
+gint64         gst_player_config_get_preload_buffer_duration (const GstStructure * config);
+
 typedef enum
 {
   GST_PLAYER_THUMBNAIL_RAW_NATIVE = 0,
@@ -26,6 +26,15 @@
  * @title: bayer2rgb
  *
  * Decodes raw camera bayer (fourcc BA81) to RGB.
+ *
+ * Besides 8 bit bayer, 10, 12, 14 and 16 bit little endian samples
+ * (e.g. bggr12le) are accepted. Those are best decoded to ARGB64, which
+ * keeps the full precision, but can be decoded to the 8 bit formats too.
+ *
+ * The default bilinear #GstBayer2RGB:method is fastest, the edge-directed
+ * method gives sharper edges without colour fringes at a higher cost. With
+ * #GstBayer2RGB:n-threads the frame is split into horizontal slices that are
+ * decoded in parallel.
  */
 
 /*
@@ -87,6 +96,7 @@
 #endif
 
 #include "gstbayerorc.h"
+#include "gstbayerdemosaic.h"
 
 #define GST_CAT_DEFAULT gst_bayer2rgb_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
@@ -111,6 +121,15 @@ typedef struct _GstBayer2RGBClass GstBayer2RGBClass;
 
 typedef void (*GstBayer2RGBProcessFunc) (GstBayer2RGB *, guint8 *, guint);
 
+typedef enum
+{
+  GST_BAYER_2_RGB_METHOD_BILINEAR,
+  GST_BAYER_2_RGB_METHOD_EDGE_DIRECTED
+} GstBayer2RGBMethod;
+
+#define DEFAULT_METHOD GST_BAYER_2_RGB_METHOD_BILINEAR
+#define DEFAULT_N_THREADS 1
+
 struct _GstBayer2RGB
 {
   GstBaseTransform basetransform;
@@ -123,6 +142,25 @@ struct _GstBayer2RGB
   int g_off;                    /* offset for green */
   int b_off;                    /* offset for blue */
   int format;
+  int depth;                    /* bits per bayer sample */
+  int r_x;                      /* column parity of red */
+  int r_y;                      /* row parity of red */
+  gboolean out16;               /* ARGB64 output */
+
+  GstBayer2RGBMethod method;
+  guint n_threads;
+
+  /* slices of a frame are decoded in parallel, the streaming thread takes
+   * the first one */
+  GThreadPool *pool;
+  guint n_slices;
+  guint8 *dest;
+  int dest_stride;
+  const guint8 *src;
+  int src_stride;
+  GMutex slice_lock;
+  GCond slice_cond;
+  guint slices_pending;
 };
 
 struct _GstBayer2RGBClass
@@ -130,17 +168,45 @@ struct _GstBayer2RGBClass
   GstBaseTransformClass parent;
 };
 
+#define SRC_FORMATS_8 "RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR"
+
 #define	SRC_CAPS                                 \
-  GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR }")
+  GST_VIDEO_CAPS_MAKE ("{ " SRC_FORMATS_8 ", ARGB64 }")
+
+#define SINK_FORMATS(depth) \
+  "bggr" depth ",grbg" depth ",gbrg" depth ",rggb" depth
 
-#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb}," \
+#define SINK_CAPS "video/x-bayer,format=(string){" SINK_FORMATS ("") "," \
+  SINK_FORMATS ("10le") "," SINK_FORMATS ("12le") "," \
+  SINK_FORMATS ("14le") "," SINK_FORMATS ("16le") "}," \
   "width=(int)[1,MAX],height=(int)[1,MAX],framerate=(fraction)[0/1,MAX]"
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_METHOD,
+  PROP_N_THREADS
 };
 
+#define GST_TYPE_BAYER2RGB_METHOD (gst_bayer2rgb_method_get_type ())
+static GType
+gst_bayer2rgb_method_get_type (void)
+{
+  static GType method_type = 0;
+
+  static const GEnumValue method_types[] = {
+    {GST_BAYER_2_RGB_METHOD_BILINEAR, "Bilinear interpolation", "bilinear"},
+    {GST_BAYER_2_RGB_METHOD_EDGE_DIRECTED,
+        "Edge-directed interpolation (Hamilton-Adams)", "edge-directed"},
+    {0, NULL, NULL},
+  };
+
+  if (!method_type) {
+    method_type = g_enum_register_static ("GstBayer2RGBMethod", method_types);
+  }
+  return method_type;
+}
+
 GType gst_bayer2rgb_get_type (void);
 
 #define gst_bayer2rgb_parent_class parent_class
@@ -160,6 +226,9 @@ static GstCaps *gst_bayer2rgb_transform_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static gboolean gst_bayer2rgb_get_unit_size (GstBaseTransform * base,
     GstCaps * caps, gsize * size);
+static gboolean gst_bayer2rgb_start (GstBaseTransform * base);
+static gboolean gst_bayer2rgb_stop (GstBaseTransform * base);
+static void gst_bayer2rgb_finalize (GObject * object);
 
 
 static void
@@ -173,6 +242,18 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 
   gobject_class->set_property = gst_bayer2rgb_set_property;
   gobject_class->get_property = gst_bayer2rgb_get_property;
+  gobject_class->finalize = gst_bayer2rgb_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method", "Demosaicing method",
+          GST_TYPE_BAYER2RGB_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Number of threads decoding slices of a frame in parallel "
+          "(0 = number of processors)", 0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Bayer to RGB decoder for cameras", "Filter/Converter/Video",
@@ -194,6 +275,10 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_set_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->transform =
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_transform);
+  GST_BASE_TRANSFORM_CLASS (klass)->start =
+      GST_DEBUG_FUNCPTR (gst_bayer2rgb_start);
+  GST_BASE_TRANSFORM_CLASS (klass)->stop =
+      GST_DEBUG_FUNCPTR (gst_bayer2rgb_stop);
 
   GST_DEBUG_CATEGORY_INIT (gst_bayer2rgb_debug, "bayer2rgb", 0,
       "bayer2rgb element");
@@ -202,17 +287,38 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 static void
 gst_bayer2rgb_init (GstBayer2RGB * filter)
 {
+  filter->method = DEFAULT_METHOD;
+  filter->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&filter->slice_lock);
+  g_cond_init (&filter->slice_cond);
   gst_bayer2rgb_reset (filter);
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (filter), TRUE);
 }
 
-/* No properties are implemented, so only a warning is produced */
+static void
+gst_bayer2rgb_finalize (GObject * object)
+{
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
+
+  g_mutex_clear (&filter->slice_lock);
+  g_cond_clear (&filter->slice_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_bayer2rgb_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      filter->method = g_value_get_enum (value);
+      break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -223,14 +329,58 @@ static void
 gst_bayer2rgb_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      g_value_set_enum (value, filter->method);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* Parses a bayer format like "bggr" or "rggb12le" */
+static gboolean
+gst_bayer2rgb_parse_format (const gchar * format, int *pattern, int *depth)
+{
+  if (format == NULL || strlen (format) < 4)
+    return FALSE;
+
+  if (g_str_has_prefix (format, "bggr")) {
+    *pattern = GST_BAYER_2_RGB_FORMAT_BGGR;
+  } else if (g_str_has_prefix (format, "gbrg")) {
+    *pattern = GST_BAYER_2_RGB_FORMAT_GBRG;
+  } else if (g_str_has_prefix (format, "grbg")) {
+    *pattern = GST_BAYER_2_RGB_FORMAT_GRBG;
+  } else if (g_str_has_prefix (format, "rggb")) {
+    *pattern = GST_BAYER_2_RGB_FORMAT_RGGB;
+  } else {
+    return FALSE;
+  }
+
+  format += 4;
+  if (*format == '\0') {
+    *depth = 8;
+  } else if (g_str_equal (format, "10le")) {
+    *depth = 10;
+  } else if (g_str_equal (format, "12le")) {
+    *depth = 12;
+  } else if (g_str_equal (format, "14le")) {
+    *depth = 14;
+  } else if (g_str_equal (format, "16le")) {
+    *depth = 16;
+  } else {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
     GstCaps * outcaps)
@@ -249,23 +399,23 @@ gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
   gst_structure_get_int (structure, "height", &bayer2rgb->height);
 
   format = gst_structure_get_string (structure, "format");
-  if (g_str_equal (format, "bggr")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_BGGR;
-  } else if (g_str_equal (format, "gbrg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GBRG;
-  } else if (g_str_equal (format, "grbg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GRBG;
-  } else if (g_str_equal (format, "rggb")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_RGGB;
-  } else {
+  if (!gst_bayer2rgb_parse_format (format, &bayer2rgb->format,
+          &bayer2rgb->depth)) {
     return FALSE;
   }
 
+  /* where red is in the 2x2 pattern, blue is diagonally opposite */
+  bayer2rgb->r_x = (bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_BGGR ||
+      bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_GRBG);
+  bayer2rgb->r_y = (bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_BGGR ||
+      bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_GBRG);
+
   /* To cater for different RGB formats, we need to set params for later */
   gst_video_info_from_caps (&info, outcaps);
   bayer2rgb->r_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 0);
   bayer2rgb->g_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 1);
   bayer2rgb->b_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 2);
+  bayer2rgb->out16 = GST_VIDEO_INFO_FORMAT (&info) == GST_VIDEO_FORMAT_ARGB64;
 
   bayer2rgb->info = info;
 
@@ -280,6 +430,8 @@ gst_bayer2rgb_reset (GstBayer2RGB * filter)
   filter->r_off = 0;
   filter->g_off = 0;
   filter->b_off = 0;
+  filter->depth = 8;
+  filter->out16 = FALSE;
   gst_video_info_init (&filter->info);
 }
 
@@ -299,8 +451,23 @@ gst_bayer2rgb_transform_caps (GstBaseTransform * base,
   for (i = 0; i < caps_size; i++) {
     structure = gst_caps_get_structure (res_caps, i);
     if (direction == GST_PAD_SINK) {
+      const gchar *format = gst_structure_get_string (structure, "format");
+      int pattern, depth;
+
       gst_structure_set_name (structure, "video/x-raw");
       gst_structure_remove_field (structure, "format");
+
+      /* prefer the output that keeps the precision of the input */
+      if (gst_bayer2rgb_parse_format (format, &pattern, &depth)) {
+        GstCaps *formats = gst_caps_from_string (depth > 8 ?
+            "video/x-raw,format={ ARGB64, " SRC_FORMATS_8 " }" :
+            "video/x-raw,format={ " SRC_FORMATS_8 ", ARGB64 }");
+
+        gst_structure_set_value (structure, "format",
+            gst_structure_get_value (gst_caps_get_structure (formats, 0),
+                "format"));
+        gst_caps_unref (formats);
+      }
     } else {
       gst_structure_set_name (structure, "video/x-bayer");
       gst_structure_remove_fields (structure, "format", "colorimetry",
@@ -326,19 +493,27 @@ gst_bayer2rgb_get_unit_size (GstBaseTransform * base, GstCaps * caps,
   int width;
   int height;
   const char *name;
+  const char *format;
 
   structure = gst_caps_get_structure (caps, 0);
 
   if (gst_structure_get_int (structure, "width", &width) &&
       gst_structure_get_int (structure, "height", &height)) {
     name = gst_structure_get_name (structure);
+    format = gst_structure_get_string (structure, "format");
     /* Our name must be either video/x-bayer video/x-raw */
     if (strcmp (name, "video/x-raw")) {
-      *size = GST_ROUND_UP_4 (width) * height;
+      int pattern, depth = 8;
+
+      gst_bayer2rgb_parse_format (format, &pattern, &depth);
+      *size = GST_ROUND_UP_4 (width * (depth > 8 ? 2 : 1)) * height;
       return TRUE;
     } else {
-      /* For output, calculate according to format (always 32 bits) */
-      *size = width * height * 4;
+      /* For output, calculate according to format (32 or 64 bits) */
+      if (format != NULL && g_str_equal (format, "ARGB64"))
+        *size = width * height * 8;
+      else
+        *size = width * height * 4;
       return TRUE;
     }
 
@@ -369,7 +544,7 @@ gst_bayer2rgb_split_and_upsample_horiz (guint8 * dest0, guint8 * dest1,
   for (i = n - 2; i < n; i++) {
     if ((i & 1) == 0) {
       dest0[i] = src[i];
-      dest1[i] = src[i - 1];
+      dest1[i] = i + 1 < n ? (src[i - 1] + src[i + 1] + 1) >> 1 : src[i - 1];
     } else {
       dest0[i] = src[i - 1];
       dest1[i] = src[i];
@@ -381,10 +556,26 @@ typedef void (*process_func) (guint8 * d0, const guint8 * s0, const guint8 * s1,
     const guint8 * s2, const guint8 * s3, const guint8 * s4, const guint8 * s5,
     int n);
 
+/* Mirrors rows outside of the frame, which keeps the bayer pattern */
+static int
+gst_bayer2rgb_mirror_row (int y, int height)
+{
+  if (y < 0)
+    y = -y;
+  if (y >= height)
+    y = 2 * (height - 1) - y;
+
+  return CLAMP (y, 0, height - 1);
+}
+
+/* 8 bit bilinear decoding of the rows @y0 to @y1 with the Orc functions */
 static void
-gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
-    int dest_stride, uint8_t * src, int src_stride)
+gst_bayer2rgb_process_orc (GstBayer2RGB * bayer2rgb, int y0, int y1)
 {
+  const guint8 *src = bayer2rgb->src;
+  int src_stride = bayer2rgb->src_stride;
+  guint8 *dest = bayer2rgb->dest;
+  int dest_stride = bayer2rgb->dest_stride;
   int j;
   guint8 *tmp;
   process_func merge[2] = { NULL, NULL };
@@ -425,30 +616,250 @@ gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
 
   tmp = g_malloc (2 * 4 * bayer2rgb->width);
 #define LINE(x) (tmp + ((x)&7) * bayer2rgb->width)
+#define SRC_ROW(y) \
+  (src + gst_bayer2rgb_mirror_row ((y), bayer2rgb->height) * src_stride)
 
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (3 * 2 + 0), LINE (3 * 2 + 1),
-      src + 1 * src_stride, bayer2rgb->width);
-  j = 0;
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
-      src + j * src_stride, bayer2rgb->width);
+  /* the row above the slice, mirrored at the top of the frame */
+  gst_bayer2rgb_split_and_upsample_horiz (LINE ((y0 - 1) * 2 + 0),
+      LINE ((y0 - 1) * 2 + 1), SRC_ROW (y0 - 1), bayer2rgb->width);
+  gst_bayer2rgb_split_and_upsample_horiz (LINE (y0 * 2 + 0),
+      LINE (y0 * 2 + 1), SRC_ROW (y0), bayer2rgb->width);
 
-  for (j = 0; j < bayer2rgb->height; j++) {
-    if (j < bayer2rgb->height - 1) {
-      gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
-          LINE ((j + 1) * 2 + 1), src + (j + 1) * src_stride, bayer2rgb->width);
-    }
+  for (j = y0; j < y1; j++) {
+    gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
+        LINE ((j + 1) * 2 + 1), SRC_ROW (j + 1), bayer2rgb->width);
 
     merge[j & 1] (dest + j * dest_stride,
         LINE (j * 2 - 2), LINE (j * 2 - 1),
         LINE (j * 2 + 0), LINE (j * 2 + 1),
         LINE (j * 2 + 2), LINE (j * 2 + 3), bayer2rgb->width >> 1);
   }
+#undef SRC_ROW
+#undef LINE
 
   g_free (tmp);
 }
 
+/* Reads bayer row @y into @line as 16 bit samples and mirrors the pixels at
+ * both ends into the padding */
+static void
+gst_bayer2rgb_load_line (GstBayer2RGB * bayer2rgb, guint16 * line, int y)
+{
+  const guint8 *src = bayer2rgb->src +
+      gst_bayer2rgb_mirror_row (y, bayer2rgb->height) * bayer2rgb->src_stride;
+  int width = bayer2rgb->width;
+  guint16 max = (1 << bayer2rgb->depth) - 1;
+  int x;
+
+  if (bayer2rgb->depth == 8) {
+    for (x = 0; x < width; x++)
+      line[x] = src[x];
+  } else {
+    for (x = 0; x < width; x++)
+      line[x] = GST_READ_UINT16_LE (src + 2 * x) & max;
+  }
+
+  for (x = 1; x <= BAYER16_PAD; x++) {
+    line[-x] = line[MIN (x, width - 1)];
+    line[width - 1 + x] = line[MAX (width - 1 - x, 0)];
+  }
+}
+
+/* Decoding of the rows @y0 to @y1 on 16 bit samples, for high bit depth
+ * input or output and for the edge-directed method */
+static void
+gst_bayer2rgb_process_16 (GstBayer2RGB * bayer2rgb, int y0, int y1)
+{
+  int width = bayer2rgb->width;
+  int len = width + 2 * BAYER16_PAD;
+  int max = (1 << bayer2rgb->depth) - 1;
+  guint16 *mem, *raw[8], *split[8], *green[4], *out[2];
+  const guint16 *s[5], *g[3];
+  const guint16 *r, *gr, *b;
+  guint8 *dest;
+  int i, y, next, gnext, own_odd;
+  gboolean red_row;
+
+  /* ring buffers of lines, indexed by row */
+  mem = g_malloc (22 * len * sizeof (guint16));
+  for (i = 0; i < 8; i++) {
+    raw[i] = mem + i * len + BAYER16_PAD;
+    split[i] = mem + (8 + i) * len + BAYER16_PAD;
+  }
+  for (i = 0; i < 4; i++)
+    green[i] = mem + (16 + i) * len + BAYER16_PAD;
+  out[0] = mem + 20 * len + BAYER16_PAD;
+  out[1] = mem + 21 * len + BAYER16_PAD;
+#define RAW(y) raw[(y) & 7]
+#define SPLIT(y,i) split[((y) & 3) * 2 + (i)]
+#define GREEN(y) green[(y) & 3]
+
+  next = y0 - (bayer2rgb->method == GST_BAYER_2_RGB_METHOD_BILINEAR ? 1 : 3);
+  gnext = y0 - 1;
+
+  for (y = y0; y < y1; y++) {
+    red_row = (y & 1) == bayer2rgb->r_y;
+    /* column parity of the red or blue samples of this row */
+    own_odd = red_row ? bayer2rgb->r_x : !bayer2rgb->r_x;
+
+    if (bayer2rgb->method == GST_BAYER_2_RGB_METHOD_BILINEAR) {
+      for (; next <= y + 1; next++) {
+        gst_bayer2rgb_load_line (bayer2rgb, RAW (next), next);
+        bayer16_split_and_upsample_horiz (SPLIT (next, 0), SPLIT (next, 1),
+            RAW (next), width);
+      }
+
+      /* the rows above and below have green where this row has red or
+       * blue, and the other color where this row has green */
+      bayer16_merge (out[0], out[1], SPLIT (y - 1, !own_odd),
+          SPLIT (y + 1, !own_odd), SPLIT (y - 1, own_odd),
+          SPLIT (y, !own_odd), SPLIT (y + 1, own_odd), !own_odd, width);
+      gr = out[1];
+      r = red_row ? SPLIT (y, own_odd) : out[0];
+      b = red_row ? out[0] : SPLIT (y, own_odd);
+    } else {
+      for (; gnext <= y + 1; gnext++) {
+        gboolean gnext_red = (gnext & 1) == bayer2rgb->r_y;
+
+        for (; next <= gnext + 2; next++)
+          gst_bayer2rgb_load_line (bayer2rgb, RAW (next), next);
+
+        for (i = 0; i < 5; i++)
+          s[i] = RAW (gnext - 2 + i);
+        bayer16_edge_green (GREEN (gnext), s,
+            gnext_red ? !bayer2rgb->r_x : bayer2rgb->r_x, max, width);
+      }
+
+      for (i = 0; i < 3; i++) {
+        s[i] = RAW (y - 1 + i);
+        g[i] = GREEN (y - 1 + i);
+      }
+      bayer16_edge_rb (out[0], out[1], s, g, own_odd, max, width);
+      gr = GREEN (y);
+      r = red_row ? out[0] : out[1];
+      b = red_row ? out[1] : out[0];
+    }
+
+    dest = bayer2rgb->dest + y * bayer2rgb->dest_stride;
+    if (bayer2rgb->out16) {
+      bayer16_pack_argb64 ((guint16 *) dest, r, gr, b, bayer2rgb->depth,
+          width);
+    } else {
+      bayer16_pack_8 (dest, r, gr, b, bayer2rgb->r_off, bayer2rgb->g_off,
+          bayer2rgb->b_off, bayer2rgb->depth - 8, width);
+    }
+  }
+#undef GREEN
+#undef SPLIT
+#undef RAW
+
+  g_free (mem);
+}
+
+/* Decodes slice @slice out of @n_slices of the current frame */
+static void
+gst_bayer2rgb_process_slice (GstBayer2RGB * bayer2rgb, guint slice,
+    guint n_slices)
+{
+  int y0 = (gint64) bayer2rgb->height * slice / n_slices;
+  int y1 = (gint64) bayer2rgb->height * (slice + 1) / n_slices;
+
+  if (y0 >= y1)
+    return;
+
+  if (bayer2rgb->depth == 8 && !bayer2rgb->out16 &&
+      bayer2rgb->method == GST_BAYER_2_RGB_METHOD_BILINEAR) {
+    gst_bayer2rgb_process_orc (bayer2rgb, y0, y1);
+  } else {
+    gst_bayer2rgb_process_16 (bayer2rgb, y0, y1);
+  }
+}
 
+static void
+gst_bayer2rgb_process_worker (gpointer data, gpointer user_data)
+{
+  GstBayer2RGB *bayer2rgb = GST_BAYER2RGB (user_data);
 
+  gst_bayer2rgb_process_slice (bayer2rgb, GPOINTER_TO_UINT (data) - 1,
+      bayer2rgb->n_slices);
+
+  g_mutex_lock (&bayer2rgb->slice_lock);
+  if (--bayer2rgb->slices_pending == 0)
+    g_cond_signal (&bayer2rgb->slice_cond);
+  g_mutex_unlock (&bayer2rgb->slice_lock);
+}
+
+static void
+gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, guint8 * dest,
+    int dest_stride, const guint8 * src, int src_stride)
+{
+  guint i;
+
+  bayer2rgb->dest = dest;
+  bayer2rgb->dest_stride = dest_stride;
+  bayer2rgb->src = src;
+  bayer2rgb->src_stride = src_stride;
+
+  if (!bayer2rgb->pool || bayer2rgb->n_slices < 2) {
+    gst_bayer2rgb_process_slice (bayer2rgb, 0, 1);
+    return;
+  }
+
+  /* The pool takes all slices but the first, which is done here */
+  g_mutex_lock (&bayer2rgb->slice_lock);
+  bayer2rgb->slices_pending = bayer2rgb->n_slices - 1;
+  g_mutex_unlock (&bayer2rgb->slice_lock);
+  for (i = 1; i < bayer2rgb->n_slices; i++)
+    g_thread_pool_push (bayer2rgb->pool, GUINT_TO_POINTER (i + 1), NULL);
+
+  gst_bayer2rgb_process_slice (bayer2rgb, 0, bayer2rgb->n_slices);
+
+  g_mutex_lock (&bayer2rgb->slice_lock);
+  while (bayer2rgb->slices_pending > 0)
+    g_cond_wait (&bayer2rgb->slice_cond, &bayer2rgb->slice_lock);
+  g_mutex_unlock (&bayer2rgb->slice_lock);
+}
+
+static gboolean
+gst_bayer2rgb_start (GstBaseTransform * base)
+{
+  GstBayer2RGB *bayer2rgb = GST_BAYER2RGB (base);
+  GError *err = NULL;
+  guint n_threads = bayer2rgb->n_threads;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  bayer2rgb->n_slices = 1;
+  if (n_threads > 1) {
+    bayer2rgb->pool = g_thread_pool_new (gst_bayer2rgb_process_worker,
+        bayer2rgb, n_threads - 1, TRUE, &err);
+    if (bayer2rgb->pool) {
+      bayer2rgb->n_slices = n_threads;
+    } else {
+      GST_WARNING_OBJECT (bayer2rgb, "Failed to start threads, decoding in "
+          "the streaming thread: %s", err->message);
+      g_clear_error (&err);
+    }
+  }
+
+  GST_DEBUG_OBJECT (bayer2rgb, "decoding in %u slices", bayer2rgb->n_slices);
+
+  return TRUE;
+}
+
+static gboolean
+gst_bayer2rgb_stop (GstBaseTransform * base)
+{
+  GstBayer2RGB *bayer2rgb = GST_BAYER2RGB (base);
+
+  if (bayer2rgb->pool) {
+    g_thread_pool_free (bayer2rgb->pool, FALSE, TRUE);
+    bayer2rgb->pool = NULL;
+  }
+
+  return TRUE;
+}
 
 static GstFlowReturn
 gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
@@ -471,7 +882,7 @@ gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
 
   output = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
   gst_bayer2rgb_process (filter, output, frame.info.stride[0],
-      map.data, GST_ROUND_UP_4 (filter->width));
+      map.data, GST_ROUND_UP_4 (filter->width * (filter->depth > 8 ? 2 : 1)));
 
   gst_video_frame_unmap (&frame);
   gst_buffer_unmap (inbuf, &map);
@@ -0,0 +1,236 @@
+/* GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The bilinear functions do the same as the Orc functions of the 8 bit
+ * path, on 16 bit samples. Their inner loops have SSE2 and NEON versions,
+ * both part of the baseline instruction set of the respective 64 bit
+ * architectures, so no runtime detection is needed.
+ *
+ * The edge-directed functions implement the gradient corrected
+ * interpolation of Hamilton and Adams: green is interpolated along the
+ * direction in which it changes least, corrected by the second derivative
+ * of the red or blue samples, and red and blue are interpolated as
+ * differences to green, which keeps colour fringes off edges.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstbayerdemosaic.h"
+
+#include <stdlib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_BAYER16_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_BAYER16_NEON 1
+#endif
+
+#define AVG(a,b) (((a) + (b) + 1) >> 1)
+
+void
+bayer16_split_and_upsample_horiz (guint16 * dest0, guint16 * dest1,
+    const guint16 * src, int n)
+{
+  int x = 0;
+
+#if defined(HAVE_BAYER16_SSE2)
+  const __m128i even = _mm_set1_epi32 (0x0000ffff);
+
+  for (; x + 8 <= n; x += 8) {
+    __m128i s = _mm_loadu_si128 ((const __m128i *) (src + x));
+    __m128i a = _mm_avg_epu16 (_mm_loadu_si128 ((const __m128i *) (src + x -
+                1)), _mm_loadu_si128 ((const __m128i *) (src + x + 1)));
+
+    _mm_storeu_si128 ((__m128i *) (dest0 + x),
+        _mm_or_si128 (_mm_and_si128 (even, s), _mm_andnot_si128 (even, a)));
+    _mm_storeu_si128 ((__m128i *) (dest1 + x),
+        _mm_or_si128 (_mm_and_si128 (even, a), _mm_andnot_si128 (even, s)));
+  }
+#elif defined(HAVE_BAYER16_NEON)
+  const uint16x8_t even = vreinterpretq_u16_u32 (vdupq_n_u32 (0x0000ffff));
+
+  for (; x + 8 <= n; x += 8) {
+    uint16x8_t s = vld1q_u16 (src + x);
+    uint16x8_t a = vrhaddq_u16 (vld1q_u16 (src + x - 1),
+        vld1q_u16 (src + x + 1));
+
+    vst1q_u16 (dest0 + x, vbslq_u16 (even, s, a));
+    vst1q_u16 (dest1 + x, vbslq_u16 (even, a, s));
+  }
+#endif
+
+  for (; x < n; x++) {
+    guint16 a = AVG (src[x - 1], src[x + 1]);
+
+    if ((x & 1) == 0) {
+      dest0[x] = src[x];
+      dest1[x] = a;
+    } else {
+      dest0[x] = a;
+      dest1[x] = src[x];
+    }
+  }
+}
+
+void
+bayer16_merge (guint16 * other, guint16 * green, const guint16 * other0,
+    const guint16 * other2, const guint16 * g0, const guint16 * g1,
+    const guint16 * g2, int green_odd, int n)
+{
+  int x = 0;
+
+#if defined(HAVE_BAYER16_SSE2)
+  const __m128i keep = _mm_set1_epi32 (green_odd ? 0xffff0000 : 0x0000ffff);
+
+  for (; x + 8 <= n; x += 8) {
+    __m128i c = _mm_loadu_si128 ((const __m128i *) (g1 + x));
+    __m128i v = _mm_avg_epu16 (_mm_loadu_si128 ((const __m128i *) (g0 + x)),
+        _mm_loadu_si128 ((const __m128i *) (g2 + x)));
+
+    v = _mm_avg_epu16 (v, c);
+    _mm_storeu_si128 ((__m128i *) (green + x),
+        _mm_or_si128 (_mm_and_si128 (keep, c), _mm_andnot_si128 (keep, v)));
+    _mm_storeu_si128 ((__m128i *) (other + x),
+        _mm_avg_epu16 (_mm_loadu_si128 ((const __m128i *) (other0 + x)),
+            _mm_loadu_si128 ((const __m128i *) (other2 + x))));
+  }
+#elif defined(HAVE_BAYER16_NEON)
+  const uint16x8_t keep = vreinterpretq_u16_u32 (vdupq_n_u32 (green_odd ?
+          0xffff0000 : 0x0000ffff));
+
+  for (; x + 8 <= n; x += 8) {
+    uint16x8_t c = vld1q_u16 (g1 + x);
+    uint16x8_t v = vrhaddq_u16 (vld1q_u16 (g0 + x), vld1q_u16 (g2 + x));
+
+    vst1q_u16 (green + x, vbslq_u16 (keep, c, vrhaddq_u16 (v, c)));
+    vst1q_u16 (other + x, vrhaddq_u16 (vld1q_u16 (other0 + x),
+            vld1q_u16 (other2 + x)));
+  }
+#endif
+
+  for (; x < n; x++) {
+    other[x] = AVG (other0[x], other2[x]);
+    if ((x & 1) == green_odd)
+      green[x] = g1[x];
+    else
+      green[x] = AVG (AVG (g0[x], g2[x]), g1[x]);
+  }
+}
+
+void
+bayer16_edge_green (guint16 * green, const guint16 * const *s, int green_odd,
+    int max, int n)
+{
+  const guint16 *up2 = s[0], *up = s[1], *c = s[2], *down = s[3];
+  const guint16 *down2 = s[4];
+  int x, gh, gv, lh, lv, dh, dv, v;
+
+  for (x = 0; x < n; x++) {
+    if ((x & 1) == green_odd) {
+      green[x] = c[x];
+      continue;
+    }
+
+    gh = c[x - 1] + c[x + 1];
+    gv = up[x] + down[x];
+    lh = 2 * c[x] - c[x - 2] - c[x + 2];
+    lv = 2 * c[x] - up2[x] - down2[x];
+    dh = abs (c[x - 1] - c[x + 1]) + abs (lh);
+    dv = abs (up[x] - down[x]) + abs (lv);
+
+    if (dh < dv)
+      v = (2 * gh + lh) / 4;
+    else if (dv < dh)
+      v = (2 * gv + lv) / 4;
+    else
+      v = (2 * (gh + gv) + lh + lv) / 8;
+
+    green[x] = CLAMP (v, 0, max);
+  }
+
+  /* the red and blue pass needs a neighbour on each side */
+  for (x = 1; x <= BAYER16_PAD; x++) {
+    green[-x] = green[MIN (x, n - 1)];
+    green[n - 1 + x] = green[MAX (n - 1 - x, 0)];
+  }
+}
+
+void
+bayer16_edge_rb (guint16 * own, guint16 * other, const guint16 * const *s,
+    const guint16 * const *g, int own_odd, int max, int n)
+{
+  const guint16 *s0 = s[0], *s1 = s[1], *s2 = s[2];
+  const guint16 *g0 = g[0], *g1 = g[1], *g2 = g[2];
+  int x, v;
+
+  for (x = 0; x < n; x++) {
+    if ((x & 1) == own_odd) {
+      own[x] = s1[x];
+      v = g1[x] + ((s0[x - 1] - g0[x - 1]) + (s0[x + 1] - g0[x + 1]) +
+          (s2[x - 1] - g2[x - 1]) + (s2[x + 1] - g2[x + 1])) / 4;
+      other[x] = CLAMP (v, 0, max);
+    } else {
+      v = g1[x] + ((s1[x - 1] - g1[x - 1]) + (s1[x + 1] - g1[x + 1])) / 2;
+      own[x] = CLAMP (v, 0, max);
+      v = g1[x] + ((s0[x] - g0[x]) + (s2[x] - g2[x])) / 2;
+      other[x] = CLAMP (v, 0, max);
+    }
+  }
+}
+
+void
+bayer16_pack_8 (guint8 * dest, const guint16 * r, const guint16 * g,
+    const guint16 * b, int r_off, int g_off, int b_off, int shift, int n)
+{
+  /* the offsets are a permutation of 0..3, the remaining one is alpha */
+  int a_off = 6 - r_off - g_off - b_off;
+  int x;
+
+  for (x = 0; x < n; x++) {
+    dest[r_off] = r[x] >> shift;
+    dest[g_off] = g[x] >> shift;
+    dest[b_off] = b[x] >> shift;
+    dest[a_off] = 0xff;
+    dest += 4;
+  }
+}
+
+void
+bayer16_pack_argb64 (guint16 * dest, const guint16 * r, const guint16 * g,
+    const guint16 * b, int depth, int n)
+{
+  /* scale to the full 16 bit range by repeating the top bits */
+  int up = 16 - depth, down = depth - up;
+  int x;
+
+#define SCALE(v) (up ? ((v) << up) | ((v) >> down) : (v))
+  for (x = 0; x < n; x++) {
+    dest[0] = 0xffff;
+    dest[1] = SCALE (r[x]);
+    dest[2] = SCALE (g[x]);
+    dest[3] = SCALE (b[x]);
+    dest += 4;
+  }
+#undef SCALE
+}
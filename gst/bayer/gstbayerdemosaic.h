@@ -0,0 +1,64 @@
+/* GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_BAYER_DEMOSAIC_H__
+#define __GST_BAYER_DEMOSAIC_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Line functions on 16 bit samples, used for everything the 8 bit Orc
+ * path does not handle. Lines hold one sample per pixel and have
+ * BAYER16_PAD mirrored samples before and after the @n pixels. */
+#define BAYER16_PAD 2
+
+/* Bilinear: splits a bayer line into its two colors, each upsampled to the
+ * full width */
+void bayer16_split_and_upsample_horiz (guint16 * dest0, guint16 * dest1,
+    const guint16 * src, int n);
+
+/* Bilinear: averages the color missing from a line from the lines above and
+ * below and completes the green line, which has its samples at the odd
+ * pixels if @green_odd is set */
+void bayer16_merge (guint16 * other, guint16 * green, const guint16 * other0,
+    const guint16 * other2, const guint16 * g0, const guint16 * g1,
+    const guint16 * g2, int green_odd, int n);
+
+/* Edge-directed: interpolates green along the direction of the smaller
+ * gradient, @s are the bayer lines from two above to two below */
+void bayer16_edge_green (guint16 * green, const guint16 * const *s,
+    int green_odd, int max, int n);
+
+/* Edge-directed: red and blue from the color differences to the green lines
+ * @g, @s are the bayer lines from the one above to the one below. @own gets
+ * the color of this line, which has its samples at the odd pixels if
+ * @own_odd is set, @other the color of the lines above and below. */
+void bayer16_edge_rb (guint16 * own, guint16 * other, const guint16 * const *s,
+    const guint16 * const *g, int own_odd, int max, int n);
+
+void bayer16_pack_8 (guint8 * dest, const guint16 * r, const guint16 * g,
+    const guint16 * b, int r_off, int g_off, int b_off, int shift, int n);
+
+void bayer16_pack_argb64 (guint16 * dest, const guint16 * r,
+    const guint16 * g, const guint16 * b, int depth, int n);
+
+G_END_DECLS
+
+#endif /* __GST_BAYER_DEMOSAIC_H__ */
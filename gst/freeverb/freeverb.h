@@ -0,0 +1,66 @@
+/*
+ * GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __FREEVERB_H__
+#define __FREEVERB_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* number of parallel comb filters per channel, one lane each */
+#define FREEVERB_NUM_COMBS 8
+
+/* Runs @n samples of @in through a bank of comb filters that share their
+ * coefficients. @delayed points to the first delay line output of each
+ * comb, the following ones are FREEVERB_NUM_COMBS values apart. @lines
+ * receives the values to feed back, one row of FREEVERB_NUM_COMBS values
+ * per sample, and @out the sum of the delay line outputs. */
+typedef void (*FreeverbCombKernel) (const gfloat ** delayed, gfloat * lines,
+    const gfloat * in, gfloat * out, guint n, gfloat * filterstore,
+    gfloat feedback, gfloat damp1, gfloat damp2);
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define HAVE_FREEVERB_SSE 1
+void freeverb_comb_kernel_sse (const gfloat ** delayed, gfloat * lines,
+    const gfloat * in, gfloat * out, guint n, gfloat * filterstore,
+    gfloat feedback, gfloat damp1, gfloat damp2);
+
+/* Built with target attributes, no compiler flags needed */
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || \
+    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define HAVE_FREEVERB_AVX 1
+gboolean freeverb_have_avx (void);
+void freeverb_comb_kernel_avx (const gfloat ** delayed, gfloat * lines,
+    const gfloat * in, gfloat * out, guint n, gfloat * filterstore,
+    gfloat feedback, gfloat damp1, gfloat damp2);
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_FREEVERB_NEON 1
+void freeverb_comb_kernel_neon (const gfloat ** delayed, gfloat * lines,
+    const gfloat * in, gfloat * out, guint n, gfloat * filterstore,
+    gfloat feedback, gfloat damp1, gfloat damp2);
+#endif
+
+G_END_DECLS
+
+#endif /* __FREEVERB_H__ */
@@ -0,0 +1,166 @@
+/*
+ * GStreamer
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* SSE, AVX and NEON versions of the comb bank kernel of gstfreeverb.c. The
+ * eight combs of a bank are the lanes and the per lane arithmetic is the
+ * same as in the C version. Only the sum over the combs is done in a
+ * different order, so the output stays within float rounding of it. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "freeverb.h"
+
+#ifdef HAVE_FREEVERB_SSE
+
+#include <emmintrin.h>
+
+void
+freeverb_comb_kernel_sse (const gfloat ** delayed, gfloat * lines,
+    const gfloat * in, gfloat * out, guint n, gfloat * filterstore,
+    gfloat feedback, gfloat damp1, gfloat damp2)
+{
+  __m128 fs0 = _mm_loadu_ps (filterstore);
+  __m128 fs1 = _mm_loadu_ps (filterstore + 4);
+  __m128 fb = _mm_set1_ps (feedback);
+  __m128 d1 = _mm_set1_ps (damp1);
+  __m128 d2 = _mm_set1_ps (damp2);
+  guint k, o;
+
+  for (k = 0, o = 0; k < n; k++, o += FREEVERB_NUM_COMBS) {
+    __m128 t0 = _mm_set_ps (delayed[3][o], delayed[2][o], delayed[1][o],
+        delayed[0][o]);
+    __m128 t1 = _mm_set_ps (delayed[7][o], delayed[6][o], delayed[5][o],
+        delayed[4][o]);
+    __m128 x = _mm_set1_ps (in[k]);
+    __m128 s;
+
+    fs0 = _mm_add_ps (_mm_mul_ps (t0, d2), _mm_mul_ps (fs0, d1));
+    fs1 = _mm_add_ps (_mm_mul_ps (t1, d2), _mm_mul_ps (fs1, d1));
+    _mm_storeu_ps (lines + o, _mm_add_ps (x, _mm_mul_ps (fs0, fb)));
+    _mm_storeu_ps (lines + o + 4, _mm_add_ps (x, _mm_mul_ps (fs1, fb)));
+
+    s = _mm_add_ps (t0, t1);
+    s = _mm_add_ps (s, _mm_movehl_ps (s, s));
+    s = _mm_add_ss (s, _mm_shuffle_ps (s, s, 1));
+    out[k] = _mm_cvtss_f32 (s);
+  }
+
+  _mm_storeu_ps (filterstore, fs0);
+  _mm_storeu_ps (filterstore + 4, fs1);
+}
+
+#endif /* HAVE_FREEVERB_SSE */
+
+#ifdef HAVE_FREEVERB_AVX
+
+#include <immintrin.h>
+
+#define AVX_FUNC __attribute__ ((target ("avx")))
+
+gboolean
+freeverb_have_avx (void)
+{
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("avx");
+}
+
+AVX_FUNC void
+freeverb_comb_kernel_avx (const gfloat ** delayed, gfloat * lines,
+    const gfloat * in, gfloat * out, guint n, gfloat * filterstore,
+    gfloat feedback, gfloat damp1, gfloat damp2)
+{
+  __m256 fs = _mm256_loadu_ps (filterstore);
+  __m256 fb = _mm256_set1_ps (feedback);
+  __m256 d1 = _mm256_set1_ps (damp1);
+  __m256 d2 = _mm256_set1_ps (damp2);
+  guint k, o;
+
+  for (k = 0, o = 0; k < n; k++, o += FREEVERB_NUM_COMBS) {
+    __m256 t = _mm256_set_ps (delayed[7][o], delayed[6][o], delayed[5][o],
+        delayed[4][o], delayed[3][o], delayed[2][o], delayed[1][o],
+        delayed[0][o]);
+    __m128 s;
+
+    fs = _mm256_add_ps (_mm256_mul_ps (t, d2), _mm256_mul_ps (fs, d1));
+    _mm256_storeu_ps (lines + o, _mm256_add_ps (_mm256_set1_ps (in[k]),
+            _mm256_mul_ps (fs, fb)));
+
+    s = _mm_add_ps (_mm256_castps256_ps128 (t), _mm256_extractf128_ps (t, 1));
+    s = _mm_add_ps (s, _mm_movehl_ps (s, s));
+    s = _mm_add_ss (s, _mm_shuffle_ps (s, s, 1));
+    out[k] = _mm_cvtss_f32 (s);
+  }
+
+  _mm256_storeu_ps (filterstore, fs);
+  /* avoid the AVX to SSE transition penalty in the caller */
+  _mm256_zeroupper ();
+}
+
+#endif /* HAVE_FREEVERB_AVX */
+
+#ifdef HAVE_FREEVERB_NEON
+
+#include <arm_neon.h>
+
+void
+freeverb_comb_kernel_neon (const gfloat ** delayed, gfloat * lines,
+    const gfloat * in, gfloat * out, guint n, gfloat * filterstore,
+    gfloat feedback, gfloat damp1, gfloat damp2)
+{
+  float32x4_t fs0 = vld1q_f32 (filterstore);
+  float32x4_t fs1 = vld1q_f32 (filterstore + 4);
+  float32x4_t fb = vdupq_n_f32 (feedback);
+  float32x4_t d1 = vdupq_n_f32 (damp1);
+  float32x4_t d2 = vdupq_n_f32 (damp2);
+  guint k, o;
+
+  for (k = 0, o = 0; k < n; k++, o += FREEVERB_NUM_COMBS) {
+    float32x4_t t0 = vdupq_n_f32 (0.0f), t1 = vdupq_n_f32 (0.0f);
+    float32x4_t x = vdupq_n_f32 (in[k]);
+    float32x4_t s;
+    float32x2_t s2;
+
+    t0 = vld1q_lane_f32 (delayed[0] + o, t0, 0);
+    t0 = vld1q_lane_f32 (delayed[1] + o, t0, 1);
+    t0 = vld1q_lane_f32 (delayed[2] + o, t0, 2);
+    t0 = vld1q_lane_f32 (delayed[3] + o, t0, 3);
+    t1 = vld1q_lane_f32 (delayed[4] + o, t1, 0);
+    t1 = vld1q_lane_f32 (delayed[5] + o, t1, 1);
+    t1 = vld1q_lane_f32 (delayed[6] + o, t1, 2);
+    t1 = vld1q_lane_f32 (delayed[7] + o, t1, 3);
+
+    fs0 = vaddq_f32 (vmulq_f32 (t0, d2), vmulq_f32 (fs0, d1));
+    fs1 = vaddq_f32 (vmulq_f32 (t1, d2), vmulq_f32 (fs1, d1));
+    vst1q_f32 (lines + o, vaddq_f32 (x, vmulq_f32 (fs0, fb)));
+    vst1q_f32 (lines + o + 4, vaddq_f32 (x, vmulq_f32 (fs1, fb)));
+
+    s = vaddq_f32 (t0, t1);
+    s2 = vadd_f32 (vget_low_f32 (s), vget_high_f32 (s));
+    s2 = vpadd_f32 (s2, s2);
+    out[k] = vget_lane_f32 (s2, 0);
+  }
+
+  vst1q_f32 (filterstore, fs0);
+  vst1q_f32 (filterstore + 4, fs1);
+}
+
+#endif /* HAVE_FREEVERB_NEON */
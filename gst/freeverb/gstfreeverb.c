@@ -58,6 +58,7 @@
 #include <gst/base/gstbasetransform.h>
 
 #include "gstfreeverb.h"
+#include "freeverb.h"
 
 #define GST_CAT_DEFAULT gst_freeverb_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
@@ -135,17 +136,77 @@ static const GstFreeverbProcessFunc process_functions[2][2] = {
 
 /* Denormalising:
  *
- * Another method fixes the problem cheaper: Use a small DC-offset in
- * the filter calculations.  Now the signals converge not against 0,
- * but against the offset.  The constant offset is invisible from the
- * outside world (i.e. it does not appear at the output.  There is a
- * very small turn-on transient response, which should not cause
- * problems.
+ * The feedback loops decay into denormal numbers which are extremely slow
+ * to compute with on most CPUs. Where we can, the CPU is told to flush them
+ * to zero while a buffer is processed, which costs nothing per sample.
+ *
+ * Elsewhere a small DC-offset is used in the filter calculations. Now the
+ * signals converge not against 0, but against the offset.  The constant
+ * offset is invisible from the outside world (i.e. it does not appear at
+ * the output.  There is a very small turn-on transient response, which
+ * should not cause problems.
  */
 
-//#define DC_OFFSET 0
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+
+/* flush-to-zero and denormals-are-zero */
+#define FREEVERB_MXCSR_FTZ_DAZ 0x8040
+
+typedef guint freeverb_fpstate;
+
+static inline freeverb_fpstate
+freeverb_denormals_disable (void)
+{
+  guint csr = _mm_getcsr ();
+
+  _mm_setcsr (csr | FREEVERB_MXCSR_FTZ_DAZ);
+  return csr;
+}
+
+static inline void
+freeverb_denormals_restore (freeverb_fpstate csr)
+{
+  _mm_setcsr (csr);
+}
+
+#define DC_OFFSET 0
+#elif defined(__aarch64__) && defined(__GNUC__)
+/* flush-to-zero bit of the FPCR */
+#define FREEVERB_FPCR_FZ (1 << 24)
+
+typedef guint64 freeverb_fpstate;
+
+static inline freeverb_fpstate
+freeverb_denormals_disable (void)
+{
+  guint64 fpcr;
+
+  __asm__ __volatile__ ("mrs %0, fpcr":"=r" (fpcr));
+  __asm__ __volatile__ ("msr fpcr, %0"::"r" (fpcr | FREEVERB_FPCR_FZ));
+  return fpcr;
+}
+
+static inline void
+freeverb_denormals_restore (freeverb_fpstate fpcr)
+{
+  __asm__ __volatile__ ("msr fpcr, %0"::"r" (fpcr));
+}
+
+#define DC_OFFSET 0
+#else
+typedef gint freeverb_fpstate;
+
+#define freeverb_denormals_disable() 0
+#define freeverb_denormals_restore(state) (void) (state)
+
 #define DC_OFFSET 1e-8
-//#define DC_OFFSET 0.001f
+#endif
+
+/* Samples are processed in blocks of at most this many samples. A block
+ * never spans more than the shortest allpass delay line, so all values read
+ * from an allpass in a block were written before the block started. */
+#define FREEVERB_BLOCK_SIZE 64
 
 /* all pass filter */
 
@@ -161,14 +222,16 @@ static void
 freeverb_allpass_setbuffer (freeverb_allpass * allpass, gint size)
 {
   allpass->bufidx = 0;
-  allpass->buffer = g_new (gfloat, size);
-  allpass->bufsize = size;
+  allpass->bufsize = MAX (size, 1);
+  allpass->buffer = g_new (gfloat, allpass->bufsize);
 }
 
 static void
 freeverb_allpass_release (freeverb_allpass * allpass)
 {
   g_free (allpass->buffer);
+  allpass->buffer = NULL;
+  allpass->bufsize = 0;
 }
 
 static void
@@ -188,104 +251,166 @@ freeverb_allpass_setfeedback (freeverb_allpass * allpass, gfloat val)
   allpass->feedback = val;
 }
 
-/*
-static gfloat
-freeverb_allpass_getfeedback(freeverb_allpass* allpass)
+/* Runs a block of @n samples through the allpass in place. As the block
+ * is not longer than the delay line, each sample only depends on the delay
+ * line contents from before the block and the loop vectorizes. */
+static void
+freeverb_allpass_process (freeverb_allpass * allpass, gfloat * io, guint n)
 {
-  return allpass->feedback;
-}*/
+  gfloat feedback = allpass->feedback;
+
+  while (n > 0) {
+    guint k, len = MIN (n, allpass->bufsize - allpass->bufidx);
+    gfloat *buf = allpass->buffer + allpass->bufidx;
 
-#define freeverb_allpass_process(_allpass, _input_1) \
-{ \
-  gfloat output; \
-  gfloat bufout; \
-  bufout = _allpass.buffer[_allpass.bufidx]; \
-  output = bufout-_input_1; \
-  _allpass.buffer[_allpass.bufidx] = _input_1 + (bufout * _allpass.feedback); \
-  if (++_allpass.bufidx >= _allpass.bufsize) { \
-    _allpass.bufidx = 0; \
-  } \
-  _input_1 = output; \
+    for (k = 0; k < len; k++) {
+      gfloat bufout = buf[k];
+
+      buf[k] = io[k] + (bufout * feedback);
+      io[k] = bufout - io[k];
+    }
+
+    allpass->bufidx += len;
+    if (allpass->bufidx >= allpass->bufsize)
+      allpass->bufidx = 0;
+    io += len;
+    n -= len;
+  }
 }
 
-/* comb filter */
+/* comb filters
+ *
+ * The eight parallel combs of a channel are kept together in a bank. They
+ * share their coefficients and are computed side by side, one comb per SIMD
+ * lane. The delay lines are interleaved in a single ring of rows with one
+ * value per comb, so each sample writes a whole row at once. Comb i reads
+ * its lane delay[i] rows behind the write position.
+ */
 
-typedef struct _freeverb_comb
+typedef struct _freeverb_comb_bank
 {
   gfloat feedback;
-  gfloat filterstore;
   gfloat damp1;
   gfloat damp2;
-  gfloat *buffer;
-  gint bufsize;
-  gint bufidx;
-} freeverb_comb;
+  gfloat filterstore[FREEVERB_NUM_COMBS];
+  gint delay[FREEVERB_NUM_COMBS];
+  gfloat *lines;
+  gint rows;
+  gint pos;
+} freeverb_comb_bank;
 
 static void
-freeverb_comb_setbuffer (freeverb_comb * comb, gint size)
+freeverb_comb_setdelay (freeverb_comb_bank * bank, gint comb, gint size)
 {
-  comb->filterstore = 0;
-  comb->bufidx = 0;
-  comb->buffer = g_new (gfloat, size);
-  comb->bufsize = size;
+  bank->delay[comb] = MAX (size, 1);
 }
 
+/* allocates the ring for the delays set with freeverb_comb_setdelay() */
 static void
-freeverb_comb_release (freeverb_comb * comb)
+freeverb_comb_bank_setbuffer (freeverb_comb_bank * bank)
 {
-  g_free (comb->buffer);
+  gint i;
+
+  bank->rows = 0;
+  for (i = 0; i < FREEVERB_NUM_COMBS; i++)
+    bank->rows = MAX (bank->rows, bank->delay[i] + 1);
+  bank->lines = g_new (gfloat, bank->rows * FREEVERB_NUM_COMBS);
+  bank->pos = 0;
 }
 
 static void
-freeverb_comb_init (freeverb_comb * comb)
+freeverb_comb_bank_release (freeverb_comb_bank * bank)
 {
-  gint i, len = comb->bufsize;
-  gfloat *buf = comb->buffer;
+  g_free (bank->lines);
+  bank->lines = NULL;
+  bank->rows = 0;
+}
+
+static void
+freeverb_comb_bank_init (freeverb_comb_bank * bank)
+{
+  gint i, len = bank->rows * FREEVERB_NUM_COMBS;
+  gfloat *buf = bank->lines;
 
   for (i = 0; i < len; i++) {
     buf[i] = (gfloat) DC_OFFSET;        /* This is not 100 % correct. */
   }
+  for (i = 0; i < FREEVERB_NUM_COMBS; i++)
+    bank->filterstore[i] = 0;
 }
 
 static void
-freeverb_comb_setdamp (freeverb_comb * comb, gfloat val)
+freeverb_comb_bank_setdamp (freeverb_comb_bank * bank, gfloat val)
 {
-  comb->damp1 = val;
-  comb->damp2 = 1 - val;
+  bank->damp1 = val;
+  bank->damp2 = 1 - val;
 }
 
-/*
-static gfloat
-freeverb_comb_getdamp(freeverb_comb* comb)
+static void
+freeverb_comb_bank_setfeedback (freeverb_comb_bank * bank, gfloat val)
 {
-  return comb->damp1;
-}*/
+  bank->feedback = val;
+}
 
 static void
-freeverb_comb_setfeedback (freeverb_comb * comb, gfloat val)
+freeverb_comb_kernel_c (const gfloat ** delayed, gfloat * lines,
+    const gfloat * in, gfloat * out, guint n, gfloat * filterstore,
+    gfloat feedback, gfloat damp1, gfloat damp2)
 {
-  comb->feedback = val;
+  guint i, k;
+
+  for (k = 0; k < n; k++) {
+    gfloat *row = lines + k * FREEVERB_NUM_COMBS;
+    gfloat sum = 0.0f;
+
+    for (i = 0; i < FREEVERB_NUM_COMBS; i++) {
+      gfloat _tmp = delayed[i][k * FREEVERB_NUM_COMBS];
+
+      filterstore[i] = (_tmp * damp2) + (filterstore[i] * damp1);
+      row[i] = in[k] + (filterstore[i] * feedback);
+      sum += _tmp;
+    }
+    out[k] = sum;
+  }
 }
 
-/*
-static gfloat
-freeverb_comb_getfeedback(freeverb_comb* comb)
+/* picked in class_init depending on the CPU */
+static FreeverbCombKernel freeverb_comb_kernel = freeverb_comb_kernel_c;
+
+/* Runs @n samples through all combs of @bank and stores the sum of their
+ * outputs in @out */
+static void
+freeverb_comb_bank_process (freeverb_comb_bank * bank, const gfloat * in,
+    gfloat * out, guint n)
 {
-  return comb->feedback;
-}*/
+  const gfloat *delayed[FREEVERB_NUM_COMBS];
+  gint i, row, len;
+
+  /* split where the write position or one of the read positions wraps, so
+   * the kernel can walk the ring linearly */
+  while (n > 0) {
+    len = MIN (n, bank->rows - bank->pos);
+    for (i = 0; i < FREEVERB_NUM_COMBS; i++) {
+      row = bank->pos - bank->delay[i];
+      if (row < 0)
+        row += bank->rows;
+      len = MIN (len, bank->rows - row);
+      delayed[i] = bank->lines + row * FREEVERB_NUM_COMBS + i;
+    }
 
-#define freeverb_comb_process(_comb, _input_1, _output) \
-{ \
-  gfloat _tmp = _comb.buffer[_comb.bufidx]; \
-  _comb.filterstore = (_tmp * _comb.damp2) + (_comb.filterstore * _comb.damp1); \
-  _comb.buffer[_comb.bufidx] = _input_1 + (_comb.filterstore * _comb.feedback); \
-  if (++_comb.bufidx >= _comb.bufsize) { \
-    _comb.bufidx = 0; \
-  } \
-  _output += _tmp; \
+    freeverb_comb_kernel (delayed, bank->lines +
+        bank->pos * FREEVERB_NUM_COMBS, in, out, len, bank->filterstore,
+        bank->feedback, bank->damp1, bank->damp2);
+
+    bank->pos += len;
+    if (bank->pos >= bank->rows)
+      bank->pos = 0;
+    in += len;
+    out += len;
+    n -= len;
+  }
 }
 
-#define numcombs 8
 #define numallpasses 4
 #define	fixedgain 0.015f
 #define scalewet 1.0f
@@ -331,14 +456,16 @@ struct _GstFreeverbPrivate
   gfloat wet, wet1, wet2, dry;
   gfloat width;
   gfloat gain;
+  /* largest block that fits all allpass delay lines */
+  guint block_size;
   /*
      The following are all declared inline
      to remove the need for dynamic allocation
      with its subsequent error-checking messiness
    */
   /* Comb filters */
-  freeverb_comb combL[numcombs];
-  freeverb_comb combR[numcombs];
+  freeverb_comb_bank combL;
+  freeverb_comb_bank combR;
   /* Allpass filters */
   freeverb_allpass allpassL[numallpasses];
   freeverb_allpass allpassR[numallpasses];
@@ -354,10 +481,8 @@ freeverb_revmodel_init (GstFreeverb * filter)
   GstFreeverbPrivate *priv = filter->priv;
   gint i;
 
-  for (i = 0; i < numcombs; i++) {
-    freeverb_comb_init (&priv->combL[i]);
-    freeverb_comb_init (&priv->combR[i]);
-  }
+  freeverb_comb_bank_init (&priv->combL);
+  freeverb_comb_bank_init (&priv->combR);
   for (i = 0; i < numallpasses; i++) {
     freeverb_allpass_init (&priv->allpassL[i]);
     freeverb_allpass_init (&priv->allpassR[i]);
@@ -370,10 +495,8 @@ freeverb_revmodel_free (GstFreeverb * filter)
   GstFreeverbPrivate *priv = filter->priv;
   gint i;
 
-  for (i = 0; i < numcombs; i++) {
-    freeverb_comb_release (&priv->combL[i]);
-    freeverb_comb_release (&priv->combR[i]);
-  }
+  freeverb_comb_bank_release (&priv->combL);
+  freeverb_comb_bank_release (&priv->combR);
   for (i = 0; i < numallpasses; i++) {
     freeverb_allpass_release (&priv->allpassL[i]);
     freeverb_allpass_release (&priv->allpassR[i]);
@@ -391,6 +514,17 @@ gst_freeverb_class_init (GstFreeverbClass * klass)
   GST_DEBUG_CATEGORY_INIT (gst_freeverb_debug, "freeverb", 0,
       "freeverb element");
 
+#if defined(HAVE_FREEVERB_AVX)
+  if (freeverb_have_avx ())
+    freeverb_comb_kernel = freeverb_comb_kernel_avx;
+  else
+    freeverb_comb_kernel = freeverb_comb_kernel_sse;
+#elif defined(HAVE_FREEVERB_SSE)
+  freeverb_comb_kernel = freeverb_comb_kernel_sse;
+#elif defined(HAVE_FREEVERB_NEON)
+  freeverb_comb_kernel = freeverb_comb_kernel_neon;
+#endif
+
   gobject_class = (GObjectClass *) klass;
   element_class = (GstElementClass *) klass;
 
@@ -483,27 +617,30 @@ gst_freeverb_init_rev_model (GstFreeverb * filter)
 {
   gfloat srfactor = GST_AUDIO_INFO_RATE (&filter->info) / 44100.0f;
   GstFreeverbPrivate *priv = filter->priv;
+  gint i;
 
   freeverb_revmodel_free (filter);
 
   priv->gain = fixedgain;
 
-  freeverb_comb_setbuffer (&priv->combL[0], combtuningL1 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[0], combtuningR1 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[1], combtuningL2 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[1], combtuningR2 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[2], combtuningL3 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[2], combtuningR3 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[3], combtuningL4 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[3], combtuningR4 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[4], combtuningL5 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[4], combtuningR5 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[5], combtuningL6 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[5], combtuningR6 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[6], combtuningL7 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[6], combtuningR7 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[7], combtuningL8 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[7], combtuningR8 * srfactor);
+  freeverb_comb_setdelay (&priv->combL, 0, combtuningL1 * srfactor);
+  freeverb_comb_setdelay (&priv->combR, 0, combtuningR1 * srfactor);
+  freeverb_comb_setdelay (&priv->combL, 1, combtuningL2 * srfactor);
+  freeverb_comb_setdelay (&priv->combR, 1, combtuningR2 * srfactor);
+  freeverb_comb_setdelay (&priv->combL, 2, combtuningL3 * srfactor);
+  freeverb_comb_setdelay (&priv->combR, 2, combtuningR3 * srfactor);
+  freeverb_comb_setdelay (&priv->combL, 3, combtuningL4 * srfactor);
+  freeverb_comb_setdelay (&priv->combR, 3, combtuningR4 * srfactor);
+  freeverb_comb_setdelay (&priv->combL, 4, combtuningL5 * srfactor);
+  freeverb_comb_setdelay (&priv->combR, 4, combtuningR5 * srfactor);
+  freeverb_comb_setdelay (&priv->combL, 5, combtuningL6 * srfactor);
+  freeverb_comb_setdelay (&priv->combR, 5, combtuningR6 * srfactor);
+  freeverb_comb_setdelay (&priv->combL, 6, combtuningL7 * srfactor);
+  freeverb_comb_setdelay (&priv->combR, 6, combtuningR7 * srfactor);
+  freeverb_comb_setdelay (&priv->combL, 7, combtuningL8 * srfactor);
+  freeverb_comb_setdelay (&priv->combR, 7, combtuningR8 * srfactor);
+  freeverb_comb_bank_setbuffer (&priv->combL);
+  freeverb_comb_bank_setbuffer (&priv->combR);
   freeverb_allpass_setbuffer (&priv->allpassL[0], allpasstuningL1 * srfactor);
   freeverb_allpass_setbuffer (&priv->allpassR[0], allpasstuningR1 * srfactor);
   freeverb_allpass_setbuffer (&priv->allpassL[1], allpasstuningL2 * srfactor);
@@ -513,6 +650,12 @@ gst_freeverb_init_rev_model (GstFreeverb * filter)
   freeverb_allpass_setbuffer (&priv->allpassL[3], allpasstuningL4 * srfactor);
   freeverb_allpass_setbuffer (&priv->allpassR[3], allpasstuningR4 * srfactor);
 
+  priv->block_size = FREEVERB_BLOCK_SIZE;
+  for (i = 0; i < numallpasses; i++) {
+    priv->block_size = MIN (priv->block_size, priv->allpassL[i].bufsize);
+    priv->block_size = MIN (priv->block_size, priv->allpassR[i].bufsize);
+  }
+
   /* clear buffers */
   freeverb_revmodel_init (filter);
 
@@ -533,24 +676,19 @@ gst_freeverb_set_property (GObject * object, guint prop_id,
 {
   GstFreeverb *filter = GST_FREEVERB (object);
   GstFreeverbPrivate *priv = filter->priv;
-  gint i;
 
   switch (prop_id) {
     case PROP_ROOM_SIZE:
       filter->room_size = g_value_get_float (value);
       priv->roomsize = (filter->room_size * scaleroom) + offsetroom;
-      for (i = 0; i < numcombs; i++) {
-        freeverb_comb_setfeedback (&priv->combL[i], priv->roomsize);
-        freeverb_comb_setfeedback (&priv->combR[i], priv->roomsize);
-      }
+      freeverb_comb_bank_setfeedback (&priv->combL, priv->roomsize);
+      freeverb_comb_bank_setfeedback (&priv->combR, priv->roomsize);
       break;
     case PROP_DAMPING:
       filter->damping = g_value_get_float (value);
       priv->damp = filter->damping * scaledamp;
-      for (i = 0; i < numcombs; i++) {
-        freeverb_comb_setdamp (&priv->combL[i], priv->damp);
-        freeverb_comb_setdamp (&priv->combR[i], priv->damp);
-      }
+      freeverb_comb_bank_setdamp (&priv->combL, priv->damp);
+      freeverb_comb_bank_setdamp (&priv->combR, priv->damp);
       break;
     case PROP_PAN_WIDTH:
       filter->pan_width = g_value_get_float (value);
@@ -685,52 +823,74 @@ no_format:
   }
 }
 
+/* Runs a block of @n samples through the reverb. @in_l and @in_r are
+ * scaled by the gain already, @out_l and @out_r receive the wet signal. */
+static void
+freeverb_revmodel_process (GstFreeverbPrivate * priv, const gfloat * in_l,
+    const gfloat * in_r, gfloat * out_l, gfloat * out_r, guint n)
+{
+  gint i;
+
+  /* Accumulate comb filters in parallel */
+  freeverb_comb_bank_process (&priv->combL, in_l, out_l, n);
+  freeverb_comb_bank_process (&priv->combR, in_r, out_r, n);
+
+  /* Feed through allpasses in series */
+  for (i = 0; i < numallpasses; i++) {
+    freeverb_allpass_process (&priv->allpassL[i], out_l, n);
+    freeverb_allpass_process (&priv->allpassR[i], out_r, n);
+  }
+}
+
 static gboolean
 gst_freeverb_transform_m2s_int (GstFreeverb * filter,
     gint16 * idata, gint16 * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1;
+  gfloat input_1[FREEVERB_BLOCK_SIZE];
+  gfloat out_l1[FREEVERB_BLOCK_SIZE], out_r1[FREEVERB_BLOCK_SIZE];
   gfloat out_l2, out_r2, input_2;
+  freeverb_fpstate fpstate;
   gboolean drained = TRUE;
+  guint j, k, n;
+
+  fpstate = freeverb_denormals_disable ();
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  for (k = 0; k < num_samples; k += n) {
+    n = MIN (num_samples - k, priv->block_size);
 
     /* The original Freeverb code expects a stereo signal and 'input_1'
      * is set to the sum of the left and right input_1 sample. Since
      * this code works on a mono signal, 'input_1' is set to twice the
      * input_1 sample. */
-    input_2 = (gfloat) * idata++;
-    input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
-
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
+    for (j = 0; j < n; j++)
+      input_1[j] = (2.0f * (gfloat) idata[j] + DC_OFFSET) * priv->gain;
+
+    freeverb_revmodel_process (priv, input_1, input_1, out_l1, out_r1, n);
+
+    for (j = 0; j < n; j++) {
+      input_2 = (gfloat) * idata++;
+
+      /* Remove the DC offset */
+      out_l1[j] -= (gfloat) DC_OFFSET;
+      out_r1[j] -= (gfloat) DC_OFFSET;
+
+      /* Calculate output */
+      out_l2 = out_l1[j] * priv->wet1 + out_r1[j] * priv->wet2 +
+          input_2 * priv->dry;
+      out_r2 = out_r1[j] * priv->wet1 + out_l1[j] * priv->wet2 +
+          input_2 * priv->dry;
+      out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
+      out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
+      *odata++ = (gint16) out_l2;
+      *odata++ = (gint16) out_r2;
+
+      if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
+        drained = FALSE;
     }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
-    }
-
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
-
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2 * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2 * priv->dry;
-    out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
-    out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
-    *odata++ = (gint16) out_l2;
-    *odata++ = (gint16) out_r2;
-
-    if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
-      drained = FALSE;
   }
+
+  freeverb_denormals_restore (fpstate);
   return drained;
 }
 
@@ -739,45 +899,49 @@ gst_freeverb_transform_s2s_int (GstFreeverb * filter,
     gint16 * idata, gint16 * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1l, input_1r;
+  gfloat input_1l[FREEVERB_BLOCK_SIZE], input_1r[FREEVERB_BLOCK_SIZE];
+  gfloat out_l1[FREEVERB_BLOCK_SIZE], out_r1[FREEVERB_BLOCK_SIZE];
   gfloat out_l2, out_r2, input_2l, input_2r;
+  freeverb_fpstate fpstate;
   gboolean drained = TRUE;
+  guint j, k, n;
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  fpstate = freeverb_denormals_disable ();
 
-    input_2l = (gfloat) * idata++;
-    input_2r = (gfloat) * idata++;
-    input_1l = (input_2l + DC_OFFSET) * priv->gain;
-    input_1r = (input_2r + DC_OFFSET) * priv->gain;
+  for (k = 0; k < num_samples; k += n) {
+    n = MIN (num_samples - k, priv->block_size);
 
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    for (j = 0; j < n; j++) {
+      input_1l[j] = ((gfloat) idata[2 * j] + DC_OFFSET) * priv->gain;
+      input_1r[j] = ((gfloat) idata[2 * j + 1] + DC_OFFSET) * priv->gain;
     }
 
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
+    freeverb_revmodel_process (priv, input_1l, input_1r, out_l1, out_r1, n);
 
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2l * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2r * priv->dry;
-    out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
-    out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
-    *odata++ = (gint16) out_l2;
-    *odata++ = (gint16) out_r2;
+    for (j = 0; j < n; j++) {
+      input_2l = (gfloat) * idata++;
+      input_2r = (gfloat) * idata++;
 
-    if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
-      drained = FALSE;
+      /* Remove the DC offset */
+      out_l1[j] -= (gfloat) DC_OFFSET;
+      out_r1[j] -= (gfloat) DC_OFFSET;
+
+      /* Calculate output */
+      out_l2 = out_l1[j] * priv->wet1 + out_r1[j] * priv->wet2 +
+          input_2l * priv->dry;
+      out_r2 = out_r1[j] * priv->wet1 + out_l1[j] * priv->wet2 +
+          input_2r * priv->dry;
+      out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
+      out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
+      *odata++ = (gint16) out_l2;
+      *odata++ = (gint16) out_r2;
+
+      if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
+        drained = FALSE;
+    }
   }
+
+  freeverb_denormals_restore (fpstate);
   return drained;
 }
 
@@ -786,45 +950,48 @@ gst_freeverb_transform_m2s_float (GstFreeverb * filter,
     gfloat * idata, gfloat * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1;
+  gfloat input_1[FREEVERB_BLOCK_SIZE];
+  gfloat out_l1[FREEVERB_BLOCK_SIZE], out_r1[FREEVERB_BLOCK_SIZE];
   gfloat out_l2, out_r2, input_2;
+  freeverb_fpstate fpstate;
   gboolean drained = TRUE;
+  guint j, k, n;
+
+  fpstate = freeverb_denormals_disable ();
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  for (k = 0; k < num_samples; k += n) {
+    n = MIN (num_samples - k, priv->block_size);
 
     /* The original Freeverb code expects a stereo signal and 'input_1'
      * is set to the sum of the left and right input_1 sample. Since
      * this code works on a mono signal, 'input_1' is set to twice the
      * input_1 sample. */
-    input_2 = *idata++;
-    input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
+    for (j = 0; j < n; j++)
+      input_1[j] = (2.0f * idata[j] + DC_OFFSET) * priv->gain;
 
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
-    }
+    freeverb_revmodel_process (priv, input_1, input_1, out_l1, out_r1, n);
+
+    for (j = 0; j < n; j++) {
+      input_2 = *idata++;
 
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
+      /* Remove the DC offset */
+      out_l1[j] -= (gfloat) DC_OFFSET;
+      out_r1[j] -= (gfloat) DC_OFFSET;
 
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2 * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2 * priv->dry;
-    *odata++ = out_l2;
-    *odata++ = out_r2;
+      /* Calculate output */
+      out_l2 = out_l1[j] * priv->wet1 + out_r1[j] * priv->wet2 +
+          input_2 * priv->dry;
+      out_r2 = out_r1[j] * priv->wet1 + out_l1[j] * priv->wet2 +
+          input_2 * priv->dry;
+      *odata++ = out_l2;
+      *odata++ = out_r2;
 
-    if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
-      drained = FALSE;
+      if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
+        drained = FALSE;
+    }
   }
+
+  freeverb_denormals_restore (fpstate);
   return drained;
 }
 
@@ -833,43 +1000,47 @@ gst_freeverb_transform_s2s_float (GstFreeverb * filter,
     gfloat * idata, gfloat * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1l, input_1r;
+  gfloat input_1l[FREEVERB_BLOCK_SIZE], input_1r[FREEVERB_BLOCK_SIZE];
+  gfloat out_l1[FREEVERB_BLOCK_SIZE], out_r1[FREEVERB_BLOCK_SIZE];
   gfloat out_l2, out_r2, input_2l, input_2r;
+  freeverb_fpstate fpstate;
   gboolean drained = TRUE;
+  guint j, k, n;
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  fpstate = freeverb_denormals_disable ();
 
-    input_2l = *idata++;
-    input_2r = *idata++;
-    input_1l = (input_2l + DC_OFFSET) * priv->gain;
-    input_1r = (input_2r + DC_OFFSET) * priv->gain;
+  for (k = 0; k < num_samples; k += n) {
+    n = MIN (num_samples - k, priv->block_size);
 
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    for (j = 0; j < n; j++) {
+      input_1l[j] = (idata[2 * j] + DC_OFFSET) * priv->gain;
+      input_1r[j] = (idata[2 * j + 1] + DC_OFFSET) * priv->gain;
     }
 
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
+    freeverb_revmodel_process (priv, input_1l, input_1r, out_l1, out_r1, n);
+
+    for (j = 0; j < n; j++) {
+      input_2l = *idata++;
+      input_2r = *idata++;
 
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2l * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2r * priv->dry;
-    *odata++ = out_l2;
-    *odata++ = out_r2;
+      /* Remove the DC offset */
+      out_l1[j] -= (gfloat) DC_OFFSET;
+      out_r1[j] -= (gfloat) DC_OFFSET;
 
-    if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
-      drained = FALSE;
+      /* Calculate output */
+      out_l2 = out_l1[j] * priv->wet1 + out_r1[j] * priv->wet2 +
+          input_2l * priv->dry;
+      out_r2 = out_r1[j] * priv->wet1 + out_l1[j] * priv->wet2 +
+          input_2r * priv->dry;
+      *odata++ = out_l2;
+      *odata++ = out_r2;
+
+      if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
+        drained = FALSE;
+    }
   }
+
+  freeverb_denormals_restore (fpstate);
   return drained;
 }
 
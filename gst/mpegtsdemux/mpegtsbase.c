@@ -1145,6 +1145,7 @@ same_program:
 static void
 mpegts_base_handle_psi (MpegTSBase * base, GstMpegtsSection * section)
 {
+  MpegTSBaseClass *klass = GST_MPEGTS_BASE_GET_CLASS (base);
   gboolean post_message = TRUE;
 
   GST_DEBUG ("Handling PSI (pid: 0x%04x , table_id: 0x%02x)",
@@ -1174,6 +1175,10 @@ mpegts_base_handle_psi (MpegTSBase * base, GstMpegtsSection * section)
       break;
   }
 
+  /* Let subclasses filter or forward the section */
+  if (post_message && klass->handle_section)
+    post_message = klass->handle_section (base, section);
+
   /* Finally post message (if it wasn't corrupted) */
   if (post_message)
     gst_element_post_message (GST_ELEMENT_CAST (base),
@@ -1422,8 +1427,9 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
       GstMpegtsSection *section;
 
       section = mpegts_packetizer_push_section (packetizer, &packet, &others);
+      /* keep a reference for the push below, handling consumes one */
       if (section)
-        mpegts_base_handle_psi (base, section);
+        mpegts_base_handle_psi (base, gst_mpegts_section_ref (section));
       if (G_UNLIKELY (others)) {
         for (tmp = others; tmp; tmp = tmp->next)
           mpegts_base_handle_psi (base, (GstMpegtsSection *) tmp->data);
@@ -1433,6 +1439,8 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
       /* we need to push section packet downstream */
       if (base->push_section)
         res = klass->push (base, &packet, section);
+      if (section)
+        gst_mpegts_section_unref (section);
 
     } else if (packet.payload && packet.pid != 0x1fff)
       GST_LOG ("PID 0x%04x Saw packet on a pid we don't handle", packet.pid);
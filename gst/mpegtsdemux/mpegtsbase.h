@@ -205,6 +205,10 @@ struct _MpegTSBaseClass {
   /* Notifies subclasses input buffer has been handled */
   GstFlowReturn (*input_done) (MpegTSBase *base, GstBuffer *buffer);
 
+  /* Called for each section before it is posted on the bus, returns FALSE
+   * if it should not be posted */
+  gboolean (*handle_section) (MpegTSBase *base, GstMpegtsSection *section);
+
   /* signals */
   void (*pat_info) (GstStructure *pat);
   void (*pmt_info) (GstStructure *pmt);
@@ -135,20 +135,21 @@ mpegts_packetizer_get_current_time (MpegTSPacketizer2 * packetizer,
 }
 
 static inline MpegTSPacketizerStreamSubtable *
-find_subtable (GSList * subtables, guint8 table_id, guint16 subtable_extension)
+find_subtable (MpegTSPacketizerStream * stream, guint8 table_id,
+    guint16 subtable_extension)
 {
-  GSList *tmp;
+  MpegTSPacketizerStreamSubtable *sub = stream->last_subtable;
 
-  /* FIXME: Make this an array ! */
-  for (tmp = subtables; tmp; tmp = tmp->next) {
-    MpegTSPacketizerStreamSubtable *sub =
-        (MpegTSPacketizerStreamSubtable *) tmp->data;
-    if (sub->table_id == table_id
-        && sub->subtable_extension == subtable_extension)
-      return sub;
-  }
+  if (sub && sub->table_id == table_id
+      && sub->subtable_extension == subtable_extension)
+    return sub;
+
+  sub = g_hash_table_lookup (stream->subtables,
+      SUBTABLE_KEY (table_id, subtable_extension));
+  if (sub)
+    stream->last_subtable = sub;
 
-  return NULL;
+  return sub;
 }
 
 static gboolean
@@ -159,7 +160,7 @@ seen_section_before (MpegTSPacketizerStream * stream, guint8 table_id,
   MpegTSPacketizerStreamSubtable *subtable;
 
   /* Check if we've seen this table_id/subtable_extension first */
-  subtable = find_subtable (stream->subtables, table_id, subtable_extension);
+  subtable = find_subtable (stream, table_id, subtable_extension);
   if (!subtable) {
     GST_DEBUG ("Haven't seen subtable");
     return FALSE;
@@ -192,6 +193,13 @@ mpegts_packetizer_stream_subtable_new (guint8 table_id,
   return subtable;
 }
 
+static void
+mpegts_packetizer_stream_subtable_free (MpegTSPacketizerStreamSubtable *
+    subtable)
+{
+  g_free (subtable);
+}
+
 static MpegTSPacketizerStream *
 mpegts_packetizer_stream_new (guint16 pid)
 {
@@ -199,7 +207,8 @@ mpegts_packetizer_stream_new (guint16 pid)
 
   stream = (MpegTSPacketizerStream *) g_new0 (MpegTSPacketizerStream, 1);
   stream->continuity_counter = CONTINUITY_UNSET;
-  stream->subtables = NULL;
+  stream->subtables = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) mpegts_packetizer_stream_subtable_free);
   stream->table_id = TABLE_ID_UNSET;
   stream->pid = pid;
   return stream;
@@ -216,20 +225,11 @@ mpegts_packetizer_clear_section (MpegTSPacketizerStream * stream)
   stream->section_data = NULL;
 }
 
-static void
-mpegts_packetizer_stream_subtable_free (MpegTSPacketizerStreamSubtable *
-    subtable)
-{
-  g_free (subtable);
-}
-
 static void
 mpegts_packetizer_stream_free (MpegTSPacketizerStream * stream)
 {
   mpegts_packetizer_clear_section (stream);
-  g_slist_foreach (stream->subtables,
-      (GFunc) mpegts_packetizer_stream_subtable_free, NULL);
-  g_slist_free (stream->subtables);
+  g_hash_table_unref (stream->subtables);
   g_free (stream);
 }
 
@@ -498,8 +498,7 @@ mpegts_packetizer_parse_section_header (MpegTSPacketizer2 * packetizer,
   GstMpegtsSection *res;
 
   subtable =
-      find_subtable (stream->subtables, stream->table_id,
-      stream->subtable_extension);
+      find_subtable (stream, stream->table_id, stream->subtable_extension);
   if (subtable) {
     GST_DEBUG ("Found previous subtable_extension:0x%04x",
         stream->subtable_extension);
@@ -516,7 +515,9 @@ mpegts_packetizer_parse_section_header (MpegTSPacketizer2 * packetizer,
         stream->subtable_extension, stream->last_section_number);
     subtable->version_number = stream->version_number;
 
-    stream->subtables = g_slist_prepend (stream->subtables, subtable);
+    g_hash_table_insert (stream->subtables,
+        SUBTABLE_KEY (stream->table_id, stream->subtable_extension), subtable);
+    stream->last_subtable = subtable;
   }
 
   GST_MEMDUMP ("Full section data", stream->section_data,
@@ -65,6 +65,7 @@ G_BEGIN_DECLS
 
 typedef struct _MpegTSPacketizer2 MpegTSPacketizer2;
 typedef struct _MpegTSPacketizer2Class MpegTSPacketizer2Class;
+typedef struct _MpegTSPacketizerStreamSubtable MpegTSPacketizerStreamSubtable;
 
 typedef struct
 {
@@ -85,7 +86,11 @@ typedef struct
   guint8  section_number;
   guint8  last_section_number;
 
-  GSList *subtables;
+  /* MpegTSPacketizerStreamSubtable indexed by SUBTABLE_KEY() */
+  GHashTable *subtables;
+  /* The subtable last looked up, consecutive sections mostly belong to the
+   * same one */
+  MpegTSPacketizerStreamSubtable *last_subtable;
 
   /* Upstream offset of the data contained in the section */
   guint64 offset;
@@ -310,7 +315,10 @@ typedef struct
   guint64 offset;
 } MpegTSPacketizerPacket;
 
-typedef struct
+#define SUBTABLE_KEY(table_id, subtable_extension) \
+  GUINT_TO_POINTER (((guint) (table_id) << 16) | (subtable_extension))
+
+struct _MpegTSPacketizerStreamSubtable
 {
   guint8 table_id;
   /* the spec says sub_table_extension is the fourth and fifth byte of a 
@@ -323,7 +331,7 @@ typedef struct
    * Use MPEGTS_BIT_* macros to check */
   /* Size is 32, because there's a maximum of 256 (32*8) section_number */
   guint8   seen_section[32];
-} MpegTSPacketizerStreamSubtable;
+};
 
 #define MPEGTS_BIT_SET(field, offs)    ((field)[(offs) >> 3] |=  (1 << ((offs) & 0x7)))
 #define MPEGTS_BIT_UNSET(field, offs)  ((field)[(offs) >> 3] &= ~(1 << ((offs) & 0x7)))
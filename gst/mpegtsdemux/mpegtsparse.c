@@ -78,12 +78,20 @@ GST_STATIC_PAD_TEMPLATE ("program_%u", GST_PAD_SRC,
     GST_STATIC_CAPS ("video/mpegts, " "systemstream = (boolean) true ")
     );
 
+static GstStaticPadTemplate section_template =
+GST_STATIC_PAD_TEMPLATE ("sections", GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS ("application/x-mpegts-section")
+    );
+
 enum
 {
   PROP_0,
   PROP_SET_TIMESTAMPS,
   PROP_SMOOTHING_LATENCY,
   PROP_PCR_PID,
+  PROP_SECTION_PIDS,
+  PROP_SECTION_TABLE_IDS,
   /* FILL ME */
 };
 
@@ -123,6 +131,9 @@ static GstFlowReturn mpegts_parse_input_done (MpegTSBase * base,
     GstBuffer * buffer);
 static GstFlowReturn
 drain_pending_buffers (MpegTSParse2 * parse, gboolean drain_all);
+static void mpegts_parse_flush (MpegTSBase * base, gboolean hard);
+static gboolean mpegts_parse_handle_section (MpegTSBase * base,
+    GstMpegtsSection * section);
 
 static void
 mpegts_parse_dispose (GObject * object)
@@ -130,6 +141,9 @@ mpegts_parse_dispose (GObject * object)
   MpegTSParse2 *parse = (MpegTSParse2 *) object;
 
   gst_flow_combiner_free (parse->flowcombiner);
+  g_clear_pointer (&parse->section_pids, g_free);
+  g_clear_pointer (&parse->section_table_ids, g_free);
+  g_clear_pointer (&parse->section_crcs, g_hash_table_unref);
 
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 }
@@ -159,6 +173,18 @@ mpegts_parse_class_init (MpegTSParse2Class * klass)
       g_param_spec_int ("pcr-pid", "PID containing PCR",
           "Set the PID to use for PCR values (-1 for auto)",
           -1, G_MAXINT, -1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SECTION_PIDS,
+      g_param_spec_string ("section-pids", "Section PIDs",
+          "Colon-separated list of PIDs (eg. 0x12:0x14) whose sections are "
+          "posted on the bus and pushed on the sections pad, empty for all",
+          NULL, GST_PARAM_MUTABLE_PLAYING | G_PARAM_READWRITE |
+          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SECTION_TABLE_IDS,
+      g_param_spec_string ("section-table-ids", "Section table ids",
+          "Colon-separated list of table ids (eg. 0x4e:0x50) of the sections "
+          "posted on the bus and pushed on the sections pad, empty for all",
+          NULL, GST_PARAM_MUTABLE_PLAYING | G_PARAM_READWRITE |
+          G_PARAM_STATIC_STRINGS));
 
   element_class = GST_ELEMENT_CLASS (klass);
   element_class->pad_removed = mpegts_parse_pad_removed;
@@ -167,6 +193,7 @@ mpegts_parse_class_init (MpegTSParse2Class * klass)
 
   gst_element_class_add_static_pad_template (element_class, &src_template);
   gst_element_class_add_static_pad_template (element_class, &program_template);
+  gst_element_class_add_static_pad_template (element_class, &section_template);
 
   gst_element_class_set_static_metadata (element_class,
       "MPEG transport stream parser", "Codec/Parser",
@@ -182,6 +209,8 @@ mpegts_parse_class_init (MpegTSParse2Class * klass)
   ts_class->reset = GST_DEBUG_FUNCPTR (mpegts_parse_reset);
   ts_class->input_done = GST_DEBUG_FUNCPTR (mpegts_parse_input_done);
   ts_class->inspect_packet = GST_DEBUG_FUNCPTR (mpegts_parse_inspect_packet);
+  ts_class->flush = GST_DEBUG_FUNCPTR (mpegts_parse_flush);
+  ts_class->handle_section = GST_DEBUG_FUNCPTR (mpegts_parse_handle_section);
 }
 
 static void
@@ -207,6 +236,9 @@ mpegts_parse_init (MpegTSParse2 * parse)
 
   parse->have_group_id = FALSE;
   parse->group_id = G_MAXUINT;
+
+  parse->section_crcs =
+      g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, NULL);
 }
 
 static void
@@ -250,6 +282,65 @@ mpegts_parse_reset (MpegTSBase * base)
   parse->bytes_since_pcr = 0;
   parse->pcr_pid = parse->user_pcr_pid;
   parse->ts_offset = 0;
+
+  g_hash_table_remove_all (parse->section_crcs);
+}
+
+static void
+mpegts_parse_flush (MpegTSBase * base, gboolean hard)
+{
+  MpegTSParse2 *parse = (MpegTSParse2 *) base;
+
+  /* the packetizer forgets the seen sections too */
+  if (hard)
+    g_hash_table_remove_all (parse->section_crcs);
+}
+
+/* Parses a colon-separated list of values up to @max into a bit array,
+ * NULL for an empty list */
+static guint8 *
+mpegts_parse_filter_from_string (MpegTSParse2 * parse, const gchar * str,
+    guint max)
+{
+  guint8 *filter = NULL;
+  gchar **values;
+  guint i;
+
+  if (str == NULL || *str == '\0')
+    return NULL;
+
+  values = g_strsplit (str, ":", -1);
+  for (i = 0; values[i]; i++) {
+    gchar *end;
+    guint64 value = g_ascii_strtoull (values[i], &end, 0);
+
+    if (end == values[i] || *end != '\0' || value > max) {
+      GST_WARNING_OBJECT (parse, "Ignoring invalid filter value '%s'",
+          values[i]);
+      continue;
+    }
+
+    if (filter == NULL)
+      filter = g_new0 (guint8, (max + 1) / 8);
+    MPEGTS_BIT_SET (filter, value);
+  }
+  g_strfreev (values);
+
+  return filter;
+}
+
+static gchar *
+mpegts_parse_filter_to_string (const guint8 * filter, guint max)
+{
+  GString *str = g_string_new (NULL);
+  guint i;
+
+  for (i = 0; filter && i <= max; i++) {
+    if (MPEGTS_BIT_IS_SET (filter, i))
+      g_string_append_printf (str, "%s0x%x", str->len ? ":" : "", i);
+  }
+
+  return g_string_free (str, FALSE);
 }
 
 static void
@@ -270,6 +361,26 @@ mpegts_parse_set_property (GObject * object, guint prop_id,
     case PROP_PCR_PID:
       parse->pcr_pid = parse->user_pcr_pid = g_value_get_int (value);
       break;
+    case PROP_SECTION_PIDS:{
+      guint8 *filter = mpegts_parse_filter_from_string (parse,
+          g_value_get_string (value), 0x1fff);
+
+      GST_OBJECT_LOCK (parse);
+      g_free (parse->section_pids);
+      parse->section_pids = filter;
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    }
+    case PROP_SECTION_TABLE_IDS:{
+      guint8 *filter = mpegts_parse_filter_from_string (parse,
+          g_value_get_string (value), 0xff);
+
+      GST_OBJECT_LOCK (parse);
+      g_free (parse->section_table_ids);
+      parse->section_table_ids = filter;
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -291,6 +402,18 @@ mpegts_parse_get_property (GObject * object, guint prop_id,
     case PROP_PCR_PID:
       g_value_set_int (value, parse->pcr_pid);
       break;
+    case PROP_SECTION_PIDS:
+      GST_OBJECT_LOCK (parse);
+      g_value_take_string (value,
+          mpegts_parse_filter_to_string (parse->section_pids, 0x1fff));
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    case PROP_SECTION_TABLE_IDS:
+      GST_OBJECT_LOCK (parse);
+      g_value_take_string (value,
+          mpegts_parse_filter_to_string (parse->section_table_ids, 0xff));
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -361,6 +484,7 @@ static gboolean
 push_event (MpegTSBase * base, GstEvent * event)
 {
   MpegTSParse2 *parse = (MpegTSParse2 *) base;
+  GstPad *sectionpad;
   GList *tmp;
 
   if (G_UNLIKELY (parse->first)) {
@@ -385,6 +509,14 @@ push_event (MpegTSBase * base, GstEvent * event)
     }
   }
 
+  GST_OBJECT_LOCK (parse);
+  sectionpad = parse->sectionpad ? gst_object_ref (parse->sectionpad) : NULL;
+  GST_OBJECT_UNLOCK (parse);
+  if (sectionpad) {
+    gst_pad_push_event (sectionpad, gst_event_ref (event));
+    gst_object_unref (sectionpad);
+  }
+
   gst_pad_push_event (parse->srcpad, event);
 
   return TRUE;
@@ -445,6 +577,48 @@ mpegts_parse_pad_removed (GstElement * element, GstPad * pad)
     GST_ELEMENT_CLASS (parent_class)->pad_removed (element, pad);
 }
 
+static GstPad *
+mpegts_parse_request_section_pad (MpegTSParse2 * parse)
+{
+  GstPad *pad;
+  GstEvent *event;
+  GstCaps *caps;
+  gchar *stream_id;
+
+  GST_OBJECT_LOCK (parse);
+  if (parse->sectionpad) {
+    GST_OBJECT_UNLOCK (parse);
+    GST_WARNING_OBJECT (parse, "The sections pad was already requested");
+    return NULL;
+  }
+  GST_OBJECT_UNLOCK (parse);
+
+  pad = gst_pad_new_from_static_template (&section_template, "sections");
+  gst_pad_set_query_function (pad,
+      GST_DEBUG_FUNCPTR (mpegts_parse_src_pad_query));
+  gst_pad_set_active (pad, TRUE);
+
+  stream_id = gst_pad_create_stream_id (pad, GST_ELEMENT_CAST (parse),
+      "sections");
+  event = gst_event_new_stream_start (stream_id);
+  if (parse->have_group_id)
+    gst_event_set_group_id (event, parse->group_id);
+  gst_pad_push_event (pad, event);
+  g_free (stream_id);
+
+  caps = gst_caps_new_empty_simple ("application/x-mpegts-section");
+  gst_pad_set_caps (pad, caps);
+  gst_caps_unref (caps);
+
+  gst_element_add_pad (GST_ELEMENT_CAST (parse), pad);
+
+  GST_OBJECT_LOCK (parse);
+  parse->sectionpad = pad;
+  GST_OBJECT_UNLOCK (parse);
+
+  return pad;
+}
+
 static GstPad *
 mpegts_parse_request_new_pad (GstElement * element, GstPadTemplate * template,
     const gchar * padname, const GstCaps * caps)
@@ -460,6 +634,11 @@ mpegts_parse_request_new_pad (GstElement * element, GstPadTemplate * template,
 
   g_return_val_if_fail (template != NULL, NULL);
   g_return_val_if_fail (GST_IS_MPEGTS_PARSE (element), NULL);
+
+  if (template == gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS
+          (element), "sections"))
+    return mpegts_parse_request_section_pad (GST_MPEGTS_PARSE (element));
+
   g_return_val_if_fail (padname != NULL, NULL);
 
   sscanf (padname + 8, "%d", &program_num);
@@ -519,12 +698,115 @@ mpegts_parse_release_pad (GstElement * element, GstPad * pad)
 {
   MpegTSParse2 *parse = (MpegTSParse2 *) element;
 
+  GST_OBJECT_LOCK (parse);
+  if (pad == parse->sectionpad)
+    parse->sectionpad = NULL;
+  GST_OBJECT_UNLOCK (parse);
+
   gst_pad_set_active (pad, FALSE);
   /* we do the cleanup in GstElement::pad-removed */
   gst_flow_combiner_remove_pad (parse->flowcombiner, pad);
   gst_element_remove_pad (element, pad);
 }
 
+/* Returns FALSE for a repeat of the last section with the same pid,
+ * table_id, subtable_extension and section_number */
+static gboolean
+mpegts_parse_section_changed (MpegTSParse2 * parse, GstMpegtsSection * section)
+{
+  guint64 key;
+  gpointer value;
+  guint32 crc;
+
+  key = ((guint64) section->pid << 32) | ((guint64) section->table_id << 24) |
+      ((guint64) section->subtable_extension << 8) | section->section_number;
+
+  if (section->short_section) {
+    crc = gst_mpegts_crc32 (section->data, section->section_length);
+    /* sections carrying their own CRC_32 give 0, use that one instead */
+    if (crc == 0 && section->section_length >= 4)
+      crc = GST_READ_UINT32_BE (section->data + section->section_length - 4);
+  } else {
+    crc = section->crc;
+  }
+
+  if (g_hash_table_lookup_extended (parse->section_crcs, &key, NULL, &value)
+      && GPOINTER_TO_UINT (value) == crc)
+    return FALSE;
+
+  g_hash_table_insert (parse->section_crcs, g_memdup (&key, sizeof (key)),
+      GUINT_TO_POINTER (crc));
+
+  return TRUE;
+}
+
+static void
+mpegts_parse_push_section_buffer (MpegTSParse2 * parse, GstPad * pad,
+    GstMpegtsSection * section)
+{
+  MpegTSBase *base = (MpegTSBase *) parse;
+  GstEvent *event;
+  GstBuffer *buf;
+  GstFlowReturn ret;
+
+  /* segments are only forwarded once the main source pad started */
+  event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+  if (event)
+    gst_event_unref (event);
+  else
+    gst_pad_push_event (pad, gst_event_new_segment (&base->segment));
+
+  /* the buffer keeps the section alive instead of copying its data */
+  buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, section->data,
+      section->section_length, 0, section->section_length,
+      gst_mpegts_section_ref (section),
+      (GDestroyNotify) gst_mpegts_section_unref);
+  GST_BUFFER_OFFSET (buf) = section->offset;
+
+  /* like the bus messages, the sections are side information and failing
+   * to push them doesn't stop the stream */
+  ret = gst_pad_push (pad, buf);
+  if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED &&
+      ret != GST_FLOW_FLUSHING)
+    GST_WARNING_OBJECT (parse, "Pushing section returned %s",
+        gst_flow_get_name (ret));
+}
+
+static gboolean
+mpegts_parse_handle_section (MpegTSBase * base, GstMpegtsSection * section)
+{
+  MpegTSParse2 *parse = (MpegTSParse2 *) base;
+  GstPad *pad = NULL;
+  gboolean wanted;
+
+  GST_OBJECT_LOCK (parse);
+  wanted = (parse->section_pids == NULL ||
+      MPEGTS_BIT_IS_SET (parse->section_pids, section->pid)) &&
+      (parse->section_table_ids == NULL ||
+      MPEGTS_BIT_IS_SET (parse->section_table_ids, section->table_id));
+  if (wanted && parse->sectionpad)
+    pad = gst_object_ref (parse->sectionpad);
+  GST_OBJECT_UNLOCK (parse);
+
+  if (!wanted)
+    return FALSE;
+
+  if (!mpegts_parse_section_changed (parse, section)) {
+    GST_LOG_OBJECT (parse, "Dropping unchanged section, pid 0x%04x "
+        "table_id 0x%02x", section->pid, section->table_id);
+    if (pad)
+      gst_object_unref (pad);
+    return FALSE;
+  }
+
+  if (pad) {
+    mpegts_parse_push_section_buffer (parse, pad, section);
+    gst_object_unref (pad);
+  }
+
+  return TRUE;
+}
+
 static GstFlowReturn
 mpegts_parse_tspad_push_section (MpegTSParse2 * parse, MpegTSParsePad * tspad,
     GstMpegtsSection * section, MpegTSPacketizerPacket * packet)
@@ -65,6 +65,17 @@ struct _MpegTSParse2 {
   /* Request source (single program) pads */
   GList *srcpads;
 
+  /* Request pad for the sections, protected by the OBJECT_LOCK */
+  GstPad *sectionpad;
+
+  /* Section filters as bit arrays, NULL to let all through. Protected by
+   * the OBJECT_LOCK */
+  guint8 *section_pids;
+  guint8 *section_table_ids;
+
+  /* Last CRC of each section, to drop unchanged repeats */
+  GHashTable *section_crcs;
+
   GstFlowCombiner *flowcombiner;
   
   /* state */
@@ -56,6 +56,8 @@
 
 #include <string.h>
 
+#include <gst/base/gstbytereader.h>
+
 static GstStaticPadTemplate mxf_sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -79,6 +81,7 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, guint64 offset);
 
 static void collect_index_table_segments (GstMXFDemux * demux);
+static void free_pending_index_table_segments (GstMXFDemux * demux);
 
 GType gst_mxf_demux_pad_get_type (void);
 G_DEFINE_TYPE (GstMXFDemuxPad, gst_mxf_demux_pad, GST_TYPE_PAD);
@@ -116,9 +119,22 @@ enum
   PROP_0,
   PROP_PACKAGE,
   PROP_MAX_DRIFT,
-  PROP_STRUCTURE
+  PROP_STRUCTURE,
+  PROP_INDEX_CACHE_LOCATION
 };
 
+/* Small reads in pull mode are served from blocks of this size, so that the
+ * key, length and value of consecutive KLV packets, and the interleaved
+ * essence elements of all tracks, are read as one sequential stream */
+#define MXF_DEMUX_READ_AHEAD (256 * 1024)
+/* Reads up to this size are copied out of the block, so that buffers kept
+ * downstream don't hold on to all of it. Bigger ones share the block's memory
+ * when it has all of their data, and are pulled directly otherwise */
+#define MXF_DEMUX_READ_AHEAD_MAX_COPY (MXF_DEMUX_READ_AHEAD / 4)
+
+#define MXF_INDEX_CACHE_MAGIC "GstMXFIx"
+#define MXF_INDEX_CACHE_VERSION 2
+
 static gboolean gst_mxf_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_mxf_demux_src_event (GstPad * pad, GstObject * parent,
@@ -246,6 +262,12 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
   demux->footer_partition_pack_offset = 0;
   demux->offset = 0;
 
+  if (demux->read_ahead) {
+    gst_buffer_unref (demux->read_ahead);
+    demux->read_ahead = NULL;
+  }
+  demux->read_ahead_offset = 0;
+
   demux->pull_footer_metadata = TRUE;
 
   demux->run_in = -1;
@@ -268,17 +290,7 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
     demux->random_index_pack = NULL;
   }
 
-  if (demux->pending_index_table_segments) {
-    GList *l;
-
-    for (l = demux->pending_index_table_segments; l; l = l->next) {
-      MXFIndexTableSegment *s = l->data;
-      mxf_index_table_segment_reset (s);
-      g_free (s);
-    }
-    g_list_free (demux->pending_index_table_segments);
-    demux->pending_index_table_segments = NULL;
-  }
+  free_pending_index_table_segments (demux);
 
   if (demux->index_tables) {
     GList *l;
@@ -306,6 +318,60 @@ gst_mxf_demux_pull_range (GstMXFDemux * demux, guint64 offset,
     guint size, GstBuffer ** buffer)
 {
   GstFlowReturn ret;
+  GstMapInfo map;
+
+  if (size > MXF_DEMUX_READ_AHEAD_MAX_COPY) {
+    /* e.g. the value of a big element whose key and length were just read
+     * from the block, don't read it a second time */
+    if (demux->read_ahead && offset >= demux->read_ahead_offset
+        && offset + size <= demux->read_ahead_offset +
+        gst_buffer_get_size (demux->read_ahead)) {
+      *buffer = gst_buffer_copy_region (demux->read_ahead,
+          GST_BUFFER_COPY_MEMORY, offset - demux->read_ahead_offset, size);
+      return GST_FLOW_OK;
+    }
+  } else {
+    gsize avail = 0;
+
+    if (demux->read_ahead && offset >= demux->read_ahead_offset)
+      avail =
+          gst_buffer_get_size (demux->read_ahead) - MIN (offset -
+          demux->read_ahead_offset, gst_buffer_get_size (demux->read_ahead));
+
+    if (avail < size) {
+      if (demux->read_ahead) {
+        gst_buffer_unref (demux->read_ahead);
+        demux->read_ahead = NULL;
+      }
+
+      ret = gst_pad_pull_range (demux->sinkpad, offset, MXF_DEMUX_READ_AHEAD,
+          &demux->read_ahead);
+      if (ret == GST_FLOW_OK) {
+        demux->read_ahead_offset = offset;
+        avail = gst_buffer_get_size (demux->read_ahead);
+      } else {
+        /* Some sources refuse reads beyond the end instead of returning
+         * less, ask for exactly what is needed below */
+        demux->read_ahead = NULL;
+        if (ret != GST_FLOW_EOS) {
+          GST_WARNING_OBJECT (demux,
+              "failed when pulling %u bytes from offset %" G_GUINT64_FORMAT
+              ": %s", size, offset, gst_flow_get_name (ret));
+          *buffer = NULL;
+          return ret;
+        }
+      }
+    }
+
+    if (avail >= size) {
+      *buffer = gst_buffer_new_allocate (NULL, size, NULL);
+      gst_buffer_map (*buffer, &map, GST_MAP_WRITE);
+      gst_buffer_extract (demux->read_ahead, offset - demux->read_ahead_offset,
+          map.data, size);
+      gst_buffer_unmap (*buffer, &map);
+      return GST_FLOW_OK;
+    }
+  }
 
   ret = gst_pad_pull_range (demux->sinkpad, offset, size, buffer);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
@@ -1681,6 +1747,40 @@ gst_mxf_demux_pad_set_component (GstMXFDemux * demux, GstMXFDemuxPad * pad,
   return ret;
 }
 
+/* Edit units are stored in the order of the file, so the offsets in the
+ * index increase with the position. Entries that are not known yet are
+ * skipped. */
+static gint64
+find_edit_unit_for_offset (GArray * offsets, guint64 offset)
+{
+  guint lo = 0, hi = offsets->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    guint probe = mid;
+    GstMXFDemuxIndex *idx;
+
+    idx = &g_array_index (offsets, GstMXFDemuxIndex, probe);
+    while (probe > lo && (!idx->initialized || idx->offset == 0)) {
+      probe--;
+      idx = &g_array_index (offsets, GstMXFDemuxIndex, probe);
+    }
+
+    if (!idx->initialized || idx->offset == 0) {
+      /* nothing known in [lo, mid] */
+      lo = mid + 1;
+    } else if (idx->offset == offset) {
+      return probe;
+    } else if (idx->offset < offset) {
+      lo = mid + 1;
+    } else {
+      hi = probe;
+    }
+  }
+
+  return -1;
+}
+
 static GstFlowReturn
 gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, gboolean peek)
@@ -1747,18 +1847,10 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   if (etrack->position == -1) {
     GST_DEBUG_OBJECT (demux,
         "Unknown essence track position, looking into index");
-    if (etrack->offsets) {
-      for (i = 0; i < etrack->offsets->len; i++) {
-        GstMXFDemuxIndex *idx =
-            &g_array_index (etrack->offsets, GstMXFDemuxIndex, i);
-
-        if (idx->initialized && idx->offset != 0
-            && idx->offset == demux->offset - demux->run_in) {
-          etrack->position = i;
-          break;
-        }
-      }
-    }
+    if (etrack->offsets)
+      etrack->position =
+          find_edit_unit_for_offset (etrack->offsets,
+          demux->offset - demux->run_in);
 
     if (etrack->position == -1) {
       GST_WARNING_OBJECT (demux, "Essence track position not in index");
@@ -3663,6 +3755,262 @@ no_new_offset:
   }
 }
 
+static void
+free_pending_index_table_segments (GstMXFDemux * demux)
+{
+  GList *l;
+
+  for (l = demux->pending_index_table_segments; l; l = l->next) {
+    MXFIndexTableSegment *s = l->data;
+    mxf_index_table_segment_reset (s);
+    g_free (s);
+  }
+  g_list_free (demux->pending_index_table_segments);
+  demux->pending_index_table_segments = NULL;
+}
+
+/* Identifies the file an index cache belongs to by its size and the
+ * partitions listed in the random index pack. Files without one have no
+ * cache: their partitions are only known once the demuxer has walked
+ * through them, and their index is only built while scanning the essence */
+static gchar *
+index_cache_fingerprint (GstMXFDemux * demux)
+{
+  GChecksum *checksum;
+  gint64 filesize = -1;
+  guint8 data[12];
+  gchar *ret;
+  guint i;
+
+  if (!demux->random_index_pack ||
+      !gst_pad_peer_query_duration (demux->sinkpad, GST_FORMAT_BYTES,
+          &filesize) || filesize == -1)
+    return NULL;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA1);
+  GST_WRITE_UINT64_BE (data, filesize);
+  g_checksum_update (checksum, data, 8);
+  for (i = 0; i < demux->random_index_pack->len; i++) {
+    MXFRandomIndexPackEntry *e =
+        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
+
+    GST_WRITE_UINT32_BE (data, e->body_sid);
+    GST_WRITE_UINT64_BE (data + 4, e->offset);
+    g_checksum_update (checksum, data, 12);
+  }
+  ret = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
+  return ret;
+}
+
+/* Cache file layout, all numbers big endian:
+ *   magic (8 bytes), version (u32), fingerprint (40 bytes)
+ *   partition count (u32)
+ *   per partition: this partition (u64), body offset (u64),
+ *     essence container offset (u64), body sid (u32), index sid (u32)
+ *   table count (u32)
+ *   per table: body sid (u32), index sid (u32), entry count (u32)
+ *   per entry: offset (u64), pts (u64), dts (u64), flags (u8)
+ */
+static gboolean
+load_index_cache (GstMXFDemux * demux)
+{
+  GstByteReader reader;
+  gchar *fingerprint = NULL, *contents = NULL;
+  const guint8 *magic, *file_fingerprint;
+  const guint8 *partitions;
+  GList *tables = NULL, *l;
+  gsize length;
+  guint32 version, n_partitions, n_tables;
+  GError *err = NULL;
+  guint i, j;
+
+  if (!g_file_get_contents (demux->index_cache_location, &contents, &length,
+          &err)) {
+    GST_DEBUG_OBJECT (demux, "No index cache: %s", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  fingerprint = index_cache_fingerprint (demux);
+  if (!fingerprint)
+    goto invalid;
+
+  gst_byte_reader_init (&reader, (const guint8 *) contents, length);
+  if (!gst_byte_reader_get_data (&reader, 8, &magic) ||
+      memcmp (magic, MXF_INDEX_CACHE_MAGIC, 8) != 0 ||
+      !gst_byte_reader_get_uint32_be (&reader, &version) ||
+      version != MXF_INDEX_CACHE_VERSION ||
+      !gst_byte_reader_get_data (&reader, 40, &file_fingerprint) ||
+      memcmp (file_fingerprint, fingerprint, 40) != 0 ||
+      !gst_byte_reader_get_uint32_be (&reader, &n_partitions) ||
+      gst_byte_reader_get_remaining (&reader) / 32 < n_partitions ||
+      !gst_byte_reader_get_data (&reader, n_partitions * 32, &partitions) ||
+      !gst_byte_reader_get_uint32_be (&reader, &n_tables))
+    goto invalid;
+
+  for (i = 0; i < n_tables; i++) {
+    GstMXFDemuxIndexTable *t;
+    guint32 n_entries;
+
+    t = g_new0 (GstMXFDemuxIndexTable, 1);
+    t->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+    tables = g_list_prepend (tables, t);
+
+    if (!gst_byte_reader_get_uint32_be (&reader, &t->body_sid) ||
+        !gst_byte_reader_get_uint32_be (&reader, &t->index_sid) ||
+        !gst_byte_reader_get_uint32_be (&reader, &n_entries) ||
+        gst_byte_reader_get_remaining (&reader) / 25 < n_entries)
+      goto invalid;
+
+    g_array_set_size (t->offsets, n_entries);
+    for (j = 0; j < n_entries; j++) {
+      GstMXFDemuxIndex *index = &g_array_index (t->offsets, GstMXFDemuxIndex, j);
+      guint8 flags;
+
+      index->offset = gst_byte_reader_get_uint64_be_unchecked (&reader);
+      index->pts = gst_byte_reader_get_uint64_be_unchecked (&reader);
+      index->dts = gst_byte_reader_get_uint64_be_unchecked (&reader);
+      flags = gst_byte_reader_get_uint8_unchecked (&reader);
+      index->keyframe = ! !(flags & 0x01);
+      index->initialized = ! !(flags & 0x02);
+    }
+  }
+
+  /* The partition headers are not read when the cache is used, but the
+   * partitions are needed to find the body of the essence after seeking.
+   * Their packs replace these entries once they are parsed */
+  for (i = 0; i < n_partitions; i++) {
+    const guint8 *data = partitions + i * 32;
+    guint64 this_partition = GST_READ_UINT64_BE (data);
+    GstMXFDemuxPartition *p = NULL;
+
+    for (l = demux->partitions; l; l = l->next) {
+      GstMXFDemuxPartition *tmp = l->data;
+
+      if (tmp->partition.this_partition == this_partition) {
+        p = tmp;
+        break;
+      }
+    }
+
+    if (!p) {
+      p = g_new0 (GstMXFDemuxPartition, 1);
+      p->partition.this_partition = this_partition;
+      p->partition.body_offset = GST_READ_UINT64_BE (data + 8);
+      p->partition.body_sid = GST_READ_UINT32_BE (data + 24);
+      p->partition.index_sid = GST_READ_UINT32_BE (data + 28);
+      demux->partitions =
+          g_list_insert_sorted (demux->partitions, p,
+          (GCompareFunc) gst_mxf_demux_partition_compare);
+    }
+
+    if (p->essence_container_offset == 0)
+      p->essence_container_offset = GST_READ_UINT64_BE (data + 16);
+  }
+
+  for (l = demux->partitions; l && l->next; l = l->next) {
+    GstMXFDemuxPartition *a = l->data, *b = l->next->data;
+
+    b->partition.prev_partition = a->partition.this_partition;
+  }
+
+  demux->index_tables = g_list_concat (demux->index_tables, tables);
+  GST_DEBUG_OBJECT (demux, "Loaded %u partitions and %u index tables from %s",
+      n_partitions, n_tables, demux->index_cache_location);
+
+  g_free (fingerprint);
+  g_free (contents);
+  return TRUE;
+
+invalid:
+  {
+    GList *l;
+
+    GST_WARNING_OBJECT (demux, "Index cache %s does not belong to this file",
+        demux->index_cache_location);
+    for (l = tables; l; l = l->next) {
+      GstMXFDemuxIndexTable *t = l->data;
+      g_array_free (t->offsets, TRUE);
+      g_free (t);
+    }
+    g_list_free (tables);
+    g_free (fingerprint);
+    g_free (contents);
+    return FALSE;
+  }
+}
+
+static void
+save_index_cache (GstMXFDemux * demux)
+{
+  GByteArray *data;
+  gchar *fingerprint;
+  guint8 tmp[32];
+  GError *err = NULL;
+  GList *l;
+  guint i;
+
+  fingerprint = index_cache_fingerprint (demux);
+  if (!fingerprint)
+    return;
+
+  data = g_byte_array_new ();
+  g_byte_array_append (data, (const guint8 *) MXF_INDEX_CACHE_MAGIC, 8);
+  GST_WRITE_UINT32_BE (tmp, MXF_INDEX_CACHE_VERSION);
+  g_byte_array_append (data, tmp, 4);
+  g_byte_array_append (data, (const guint8 *) fingerprint, 40);
+
+  GST_WRITE_UINT32_BE (tmp, g_list_length (demux->partitions));
+  g_byte_array_append (data, tmp, 4);
+  for (l = demux->partitions; l; l = l->next) {
+    GstMXFDemuxPartition *p = l->data;
+
+    GST_WRITE_UINT64_BE (tmp, p->partition.this_partition);
+    GST_WRITE_UINT64_BE (tmp + 8, p->partition.body_offset);
+    GST_WRITE_UINT64_BE (tmp + 16, p->essence_container_offset);
+    GST_WRITE_UINT32_BE (tmp + 24, p->partition.body_sid);
+    GST_WRITE_UINT32_BE (tmp + 28, p->partition.index_sid);
+    g_byte_array_append (data, tmp, 32);
+  }
+
+  GST_WRITE_UINT32_BE (tmp, g_list_length (demux->index_tables));
+  g_byte_array_append (data, tmp, 4);
+
+  for (l = demux->index_tables; l; l = l->next) {
+    GstMXFDemuxIndexTable *t = l->data;
+
+    GST_WRITE_UINT32_BE (tmp, t->body_sid);
+    GST_WRITE_UINT32_BE (tmp + 4, t->index_sid);
+    GST_WRITE_UINT32_BE (tmp + 8, t->offsets->len);
+    g_byte_array_append (data, tmp, 12);
+
+    for (i = 0; i < t->offsets->len; i++) {
+      GstMXFDemuxIndex *index = &g_array_index (t->offsets, GstMXFDemuxIndex, i);
+
+      GST_WRITE_UINT64_BE (tmp, index->offset);
+      GST_WRITE_UINT64_BE (tmp + 8, index->pts);
+      GST_WRITE_UINT64_BE (tmp + 16, index->dts);
+      tmp[24] = (index->keyframe ? 0x01 : 0) | (index->initialized ? 0x02 : 0);
+      g_byte_array_append (data, tmp, 25);
+    }
+  }
+
+  if (!g_file_set_contents (demux->index_cache_location,
+          (const gchar *) data->data, data->len, &err)) {
+    GST_WARNING_OBJECT (demux, "Failed to save index cache: %s",
+        err->message);
+    g_clear_error (&err);
+  } else {
+    GST_DEBUG_OBJECT (demux, "Saved index cache to %s",
+        demux->index_cache_location);
+  }
+
+  g_byte_array_unref (data);
+  g_free (fingerprint);
+}
+
 static void
 collect_index_table_segments (GstMXFDemux * demux)
 {
@@ -3670,10 +4018,20 @@ collect_index_table_segments (GstMXFDemux * demux)
   guint i;
   guint64 old_offset = demux->offset;
   GstMXFDemuxPartition *old_partition = demux->current_partition;
+  /* partitions (GList nodes) of the current body, by increasing offset */
+  GPtrArray *body_partitions;
+  guint32 body_partitions_sid = 0;
 
   if (!demux->random_index_pack)
     return;
 
+  /* The cached index replaces reading the header of every partition */
+  if (demux->index_cache_location && !demux->index_tables &&
+      load_index_cache (demux)) {
+    free_pending_index_table_segments (demux);
+    return;
+  }
+
   for (i = 0; i < demux->random_index_pack->len; i++) {
     MXFRandomIndexPackEntry *e =
         &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
@@ -3690,12 +4048,25 @@ collect_index_table_segments (GstMXFDemux * demux)
   demux->offset = old_offset;
   demux->current_partition = old_partition;
 
+  body_partitions = g_ptr_array_new ();
+
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *segment = l->data;
     GstMXFDemuxIndexTable *t = NULL;
     GList *k;
     guint64 start, end;
 
+    if (body_partitions->len == 0 || body_partitions_sid != segment->body_sid) {
+      g_ptr_array_set_size (body_partitions, 0);
+      for (k = demux->partitions; k; k = k->next) {
+        GstMXFDemuxPartition *partition = k->data;
+
+        if (partition->partition.body_sid == segment->body_sid)
+          g_ptr_array_add (body_partitions, k);
+      }
+      body_partitions_sid = segment->body_sid;
+    }
+
     for (k = demux->index_tables; k; k = k->next) {
       GstMXFDemuxIndexTable *tmp = k->data;
 
@@ -3729,22 +4100,26 @@ collect_index_table_segments (GstMXFDemux * demux)
     for (i = 0; i < segment->n_index_entries && start + i < t->offsets->len;
         i++) {
       guint64 offset = segment->index_entries[i].stream_offset;
-      GList *m;
       GstMXFDemuxPartition *offset_partition = NULL, *next_partition = NULL;
+      guint lo = 0, hi = body_partitions->len;
 
-      for (m = demux->partitions; m; m = m->next) {
+      /* Last partition of the body that starts before the offset */
+      while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        GList *m = g_ptr_array_index (body_partitions, mid);
         GstMXFDemuxPartition *partition = m->data;
 
-        if (!next_partition && offset_partition)
-          next_partition = partition;
-
-        if (partition->partition.body_sid != t->body_sid)
-          continue;
         if (partition->partition.body_offset > offset)
-          break;
+          hi = mid;
+        else
+          lo = mid + 1;
+      }
+      if (lo > 0) {
+        GList *m = g_ptr_array_index (body_partitions, lo - 1);
 
-        offset_partition = partition;
-        next_partition = NULL;
+        offset_partition = m->data;
+        if (m->next)
+          next_partition = m->next->data;
       }
 
       if (offset_partition && offset >= offset_partition->partition.body_offset) {
@@ -3799,13 +4174,11 @@ collect_index_table_segments (GstMXFDemux * demux)
     }
   }
 
-  for (l = demux->pending_index_table_segments; l; l = l->next) {
-    MXFIndexTableSegment *s = l->data;
-    mxf_index_table_segment_reset (s);
-    g_free (s);
-  }
-  g_list_free (demux->pending_index_table_segments);
-  demux->pending_index_table_segments = NULL;
+  g_ptr_array_free (body_partitions, TRUE);
+  free_pending_index_table_segments (demux);
+
+  if (demux->index_cache_location && demux->index_tables)
+    save_index_cache (demux);
 }
 
 static gboolean
@@ -4549,6 +4922,10 @@ gst_mxf_demux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       demux->max_drift = g_value_get_uint64 (value);
       break;
+    case PROP_INDEX_CACHE_LOCATION:
+      g_free (demux->index_cache_location);
+      demux->index_cache_location = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4568,6 +4945,9 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       g_value_set_uint64 (value, demux->max_drift);
       break;
+    case PROP_INDEX_CACHE_LOCATION:
+      g_value_set_string (value, demux->index_cache_location);
+      break;
     case PROP_STRUCTURE:{
       GstStructure *s;
 
@@ -4619,6 +4999,8 @@ gst_mxf_demux_finalize (GObject * object)
   demux->current_package_string = NULL;
   g_free (demux->requested_package_string);
   demux->requested_package_string = NULL;
+  g_free (demux->index_cache_location);
+  demux->index_cache_location = NULL;
 
   g_ptr_array_free (demux->src, TRUE);
   demux->src = NULL;
@@ -4662,6 +5044,15 @@ gst_mxf_demux_class_init (GstMXFDemuxClass * klass)
           "Structural metadata of the MXF file",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_INDEX_CACHE_LOCATION,
+      g_param_spec_string ("index-cache-location", "Index cache location",
+          "File to load the index tables of the MXF file from in pull mode, "
+          "instead of reading the header of every partition. It is written "
+          "when it does not match the file. Only used for files with a random "
+          "index pack and index table segments, the index built while "
+          "scanning other files is not cached", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_mxf_demux_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_mxf_demux_query);
@@ -170,6 +170,10 @@ struct _GstMXFDemux
 
   guint64 offset;
 
+  /* pull mode: block of the file that small reads are served from */
+  GstBuffer *read_ahead;
+  guint64 read_ahead_offset;
+
   gboolean random_access;
   gboolean flushing;
 
@@ -208,6 +212,7 @@ struct _GstMXFDemux
   /* Properties */
   gchar *requested_package_string;
   GstClockTime max_drift;
+  gchar *index_cache_location;
 };
 
 struct _GstMXFDemuxClass
@@ -27,6 +27,11 @@
  * |[
  * gst-launch-1.0 -v filesrc location=/path/to/audio ! decodebin ! queue ! mxfmux name=m ! filesink location=file.mxf   filesrc location=/path/to/video ! decodebin ! queue ! m.
  * ]| This pipeline muxes an audio and video file into a single MXF file.
+ * |[
+ * gst-launch-1.0 -e v4l2src ! videoconvert ! x264enc ! h264parse ! mxfmux partition-interval=10000000000 ! filesink location=file.mxf
+ * ]| This pipeline records into a growing MXF file that gets a new body
+ * partition with the index of the previous ten seconds every ten seconds,
+ * so that it can be read while it is being recorded.
  *
  */
 
@@ -113,15 +118,25 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
     GST_STATIC_CAPS ("application/mxf")
     );
 
+#define DEFAULT_PARTITION_INTERVAL 0
+
+/* Index table segments have at most this many entries */
+#define MAX_INDEX_SEGMENT_SIZE (G_MAXUINT16 / 11)
+
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_PARTITION_INTERVAL
 };
 
 #define gst_mxf_mux_parent_class parent_class
 G_DEFINE_TYPE (GstMXFMux, gst_mxf_mux, GST_TYPE_AGGREGATOR);
 
 static void gst_mxf_mux_finalize (GObject * object);
+static void gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_mxf_mux_aggregate (GstAggregator * aggregator,
     gboolean timeout);
@@ -163,6 +178,18 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
   gstaggregator_class = (GstAggregatorClass *) klass;
 
   gobject_class->finalize = gst_mxf_mux_finalize;
+  gobject_class->set_property = gst_mxf_mux_set_property;
+  gobject_class->get_property = gst_mxf_mux_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_PARTITION_INTERVAL,
+      g_param_spec_uint64 ("partition-interval", "Partition interval",
+          "Start a new body partition at the first keyframe after this much "
+          "time (in nanoseconds), containing the index of the essence since "
+          "the previous one, so the file can be read while it is growing "
+          "and the index doesn't have to be kept until the end "
+          "(0 = single body partition, index in the footer)",
+          0, G_MAXUINT64, DEFAULT_PARTITION_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstaggregator_class->create_new_pad =
       GST_DEBUG_FUNCPTR (gst_mxf_mux_create_new_pad);
@@ -191,9 +218,44 @@ static void
 gst_mxf_mux_init (GstMXFMux * mux)
 {
   mux->index_table = g_array_new (FALSE, FALSE, sizeof (MXFIndexTableSegment));
+  mux->partitions =
+      g_array_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry));
+  mux->partition_interval = DEFAULT_PARTITION_INTERVAL;
   gst_mxf_mux_reset (mux);
 }
 
+static void
+gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      mux->partition_interval = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      g_value_set_uint64 (value, mux->partition_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_mxf_mux_finalize (GObject * object)
 {
@@ -217,6 +279,11 @@ gst_mxf_mux_finalize (GObject * object)
     mux->index_table = NULL;
   }
 
+  if (mux->partitions) {
+    g_array_free (mux->partitions, TRUE);
+    mux->partitions = NULL;
+  }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -268,6 +335,11 @@ gst_mxf_mux_reset (GstMXFMux * mux)
   g_array_set_size (mux->index_table, 0);
   mux->current_index_pos = 0;
   mux->last_keyframe_pos = 0;
+  mux->index_start_position = 0;
+
+  if (mux->partitions)
+    g_array_set_size (mux->partitions, 0);
+  mux->last_partition_timestamp = 0;
 }
 
 static gboolean
@@ -1205,6 +1277,144 @@ static const guint8 _gc_essence_element_ul[] = {
   0x0d, 0x01, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00
 };
 
+static void
+gst_mxf_mux_add_index_table_segment (GstMXFMux * mux, GstMXFMuxPad * pad)
+{
+  MXFIndexTableSegment s;
+
+  memset (&s, 0, sizeof (s));
+
+  mxf_uuid_init (&s.instance_id, mux->metadata);
+  memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
+      sizeof (s.index_edit_rate));
+  if (mux->index_table->len > 0)
+    s.index_start_position =
+        g_array_index (mux->index_table, MXFIndexTableSegment,
+        mux->index_table->len - 1).index_start_position +
+        MAX_INDEX_SEGMENT_SIZE;
+  else
+    s.index_start_position = mux->index_start_position;
+  s.index_duration = 0;
+  s.edit_unit_byte_count = 0;
+  s.index_sid =
+      mux->preface->content_storage->essence_container_data[0]->index_sid;
+  s.body_sid =
+      mux->preface->content_storage->essence_container_data[0]->body_sid;
+  s.slice_count = 0;
+  s.pos_table_count = 0;
+  s.n_delta_entries = 0;
+  s.delta_entries = NULL;
+  s.n_index_entries = 0;
+  s.index_entries = g_new0 (MXFIndexEntry, MAX_INDEX_SEGMENT_SIZE);
+  g_array_append_val (mux->index_table, s);
+}
+
+/* Starts a new body partition that carries the index table segments of the
+ * essence written since the previous partition. The segments are freed
+ * afterwards. Must be called before the next edit unit of the indexed @pad
+ * is written. */
+static GstFlowReturn
+gst_mxf_mux_write_growing_body_partition (GstMXFMux * mux, GstMXFMuxPad * pad)
+{
+  MXFIndexTableSegment *current;
+  MXFRandomIndexPackEntry entry;
+  GList *segments = NULL, *l;
+  guint index_byte_count = 0;
+  gint8 carry[128];
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buf;
+  guint i;
+
+  /* Temporal offsets of edit units that are not written yet have to go
+   * into the next segment */
+  current =
+      &g_array_index (mux->index_table, MXFIndexTableSegment,
+      mux->current_index_pos);
+  for (i = 0; i < G_N_ELEMENTS (carry); i++) {
+    guint slot = current->n_index_entries + i;
+    guint seg = mux->current_index_pos + slot / MAX_INDEX_SEGMENT_SIZE;
+
+    if (seg < mux->index_table->len)
+      carry[i] =
+          g_array_index (mux->index_table, MXFIndexTableSegment,
+          seg).index_entries[slot % MAX_INDEX_SEGMENT_SIZE].temporal_offset;
+    else
+      carry[i] = 0;
+  }
+
+  for (i = 0; i <= mux->current_index_pos; i++) {
+    MXFIndexTableSegment *segment =
+        &g_array_index (mux->index_table, MXFIndexTableSegment, i);
+
+    if (segment->index_duration == 0)
+      continue;
+
+    buf = mxf_index_table_segment_to_buffer (segment);
+    index_byte_count += gst_buffer_get_size (buf);
+    segments = g_list_prepend (segments, buf);
+  }
+  segments = g_list_reverse (segments);
+
+  for (i = 0; i < mux->index_table->len; i++)
+    g_free (g_array_index (mux->index_table, MXFIndexTableSegment,
+            i).index_entries);
+  g_array_set_size (mux->index_table, 0);
+  mux->current_index_pos = 0;
+  mux->index_start_position = pad->pos;
+
+  /* The essence stream offset in partition.body_offset carries on */
+  mux->partition.type = MXF_PARTITION_PACK_BODY;
+  mux->partition.closed = TRUE;
+  mux->partition.complete = TRUE;
+  mux->partition.prev_partition =
+      g_array_index (mux->partitions, MXFRandomIndexPackEntry,
+      mux->partitions->len - 1).offset;
+  mux->partition.this_partition = mux->offset;
+  mux->partition.footer_partition = 0;
+  mux->partition.header_byte_count = 0;
+  mux->partition.index_byte_count = index_byte_count;
+  mux->partition.index_sid = index_byte_count > 0 ?
+      mux->preface->content_storage->essence_container_data[0]->index_sid : 0;
+  mux->partition.body_sid =
+      mux->preface->content_storage->essence_container_data[0]->body_sid;
+
+  GST_DEBUG_OBJECT (mux, "Starting body partition at offset %"
+      G_GUINT64_FORMAT " with %u bytes of index", mux->offset,
+      index_byte_count);
+
+  entry.offset = mux->offset;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->partitions, entry);
+
+  buf = mxf_partition_pack_to_buffer (&mux->partition);
+  if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+    GST_ERROR_OBJECT (mux, "Failed pushing body partition");
+    g_list_free_full (segments, (GDestroyNotify) gst_mini_object_unref);
+    return ret;
+  }
+
+  for (l = segments; l; l = l->next) {
+    buf = l->data;
+    l->data = NULL;
+    if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+      GST_ERROR_OBJECT (mux, "Failed pushing index table segment");
+      g_list_free_full (l->next, (GDestroyNotify) gst_mini_object_unref);
+      l->next = NULL;
+      break;
+    }
+  }
+  g_list_free (segments);
+
+  gst_mxf_mux_add_index_table_segment (mux, pad);
+  current = &g_array_index (mux->index_table, MXFIndexTableSegment, 0);
+  for (i = 0; i < G_N_ELEMENTS (carry); i++)
+    current->index_entries[i].temporal_offset = carry[i];
+
+  mux->last_partition_timestamp = pad->last_timestamp;
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
 {
@@ -1268,7 +1478,20 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   /* We currently only index the first essence stream */
   if (pad == (GstMXFMuxPad *) GST_ELEMENT_CAST (mux)->sinkpads->data) {
     MXFIndexTableSegment *segment;
-    const gint max_segment_size = G_MAXUINT16 / 11;
+    const gint max_segment_size = MAX_INDEX_SEGMENT_SIZE;
+
+    /* New partitions start with a keyframe of the indexed stream, so that
+     * readers can start decoding there */
+    if (mux->partition_interval > 0 && is_keyframe
+        && mux->index_table->len > 0
+        && pad->last_timestamp >=
+        mux->last_partition_timestamp + mux->partition_interval) {
+      if ((ret = gst_mxf_mux_write_growing_body_partition (mux, pad))
+          != GST_FLOW_OK) {
+        gst_buffer_unref (buf);
+        return ret;
+      }
+    }
 
     if (mux->index_table->len == 0 ||
         g_array_index (mux->index_table, MXFIndexTableSegment,
@@ -1277,34 +1500,8 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
       if (mux->index_table->len > 0)
         mux->current_index_pos++;
 
-      if (mux->index_table->len <= mux->current_index_pos) {
-        MXFIndexTableSegment s;
-
-        memset (&segment, 0, sizeof (segment));
-
-        mxf_uuid_init (&s.instance_id, mux->metadata);
-        memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-            sizeof (s.index_edit_rate));
-        if (mux->index_table->len > 0)
-          s.index_start_position =
-              g_array_index (mux->index_table, MXFIndexTableSegment,
-              mux->index_table->len - 1).index_start_position;
-        else
-          s.index_start_position = 0;
-        s.index_duration = 0;
-        s.edit_unit_byte_count = 0;
-        s.index_sid =
-            mux->preface->content_storage->essence_container_data[0]->index_sid;
-        s.body_sid =
-            mux->preface->content_storage->essence_container_data[0]->body_sid;
-        s.slice_count = 0;
-        s.pos_table_count = 0;
-        s.n_delta_entries = 0;
-        s.delta_entries = NULL;
-        s.n_index_entries = 0;
-        s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-        g_array_append_val (mux->index_table, s);
-      }
+      if (mux->index_table->len <= mux->current_index_pos)
+        gst_mxf_mux_add_index_table_segment (mux, pad);
     }
     segment =
         &g_array_index (mux->index_table, MXFIndexTableSegment,
@@ -1332,36 +1529,8 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
           pts_segment_pos = 0;
           pts_index_pos++;
 
-          if (pts_index_pos >= mux->index_table->len) {
-            MXFIndexTableSegment s;
-
-            memset (&segment, 0, sizeof (segment));
-
-            mxf_uuid_init (&s.instance_id, mux->metadata);
-            memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-                sizeof (s.index_edit_rate));
-            if (mux->index_table->len > 0)
-              s.index_start_position =
-                  g_array_index (mux->index_table, MXFIndexTableSegment,
-                  mux->index_table->len - 1).index_start_position;
-            else
-              s.index_start_position = 0;
-            s.index_duration = 0;
-            s.edit_unit_byte_count = 0;
-            s.index_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->index_sid;
-            s.body_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->body_sid;
-            s.slice_count = 0;
-            s.pos_table_count = 0;
-            s.n_delta_entries = 0;
-            s.delta_entries = NULL;
-            s.n_index_entries = 0;
-            s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-            g_array_append_val (mux->index_table, s);
-          }
+          if (pts_index_pos >= mux->index_table->len)
+            gst_mxf_mux_add_index_table_segment (mux, pad);
         }
       } else {
         while (pts_segment_pos + index_pos_diff <= 0) {
@@ -1431,6 +1600,7 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
 static GstFlowReturn
 gst_mxf_mux_write_body_partition (GstMXFMux * mux)
 {
+  MXFRandomIndexPackEntry entry;
   GstBuffer *buf;
 
   mux->partition.type = MXF_PARTITION_PACK_BODY;
@@ -1446,6 +1616,14 @@ gst_mxf_mux_write_body_partition (GstMXFMux * mux)
   mux->partition.body_sid =
       mux->preface->content_storage->essence_container_data[0]->body_sid;
 
+  /* header partition and this one */
+  entry.offset = 0;
+  entry.body_sid = 0;
+  g_array_append_val (mux->partitions, entry);
+  entry.offset = mux->offset;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->partitions, entry);
+
   buf = mxf_partition_pack_to_buffer (&mux->partition);
   return gst_mxf_mux_push (mux, buf);
 }
@@ -1564,10 +1742,10 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
   }
 
   {
-    guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
+    guint64 body_partition =
+        g_array_index (mux->partitions, MXFRandomIndexPackEntry, 1).offset;
+    guint64 last_partition = mux->partition.this_partition;
     guint64 footer_partition = mux->offset;
-    GArray *rip;
     GstFlowReturn ret;
     GstSegment segment;
     MXFRandomIndexPackEntry entry;
@@ -1589,7 +1767,7 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     mux->partition.closed = TRUE;
     mux->partition.complete = TRUE;
     mux->partition.this_partition = mux->offset;
-    mux->partition.prev_partition = body_partition;
+    mux->partition.prev_partition = last_partition;
     mux->partition.footer_partition = mux->offset;
     mux->partition.header_byte_count = 0;
     mux->partition.index_byte_count = index_byte_count;
@@ -1608,22 +1786,14 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     }
     g_list_free (index_entries);
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
-    entry.offset = 0;
-    entry.body_sid = 0;
-    g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
     entry.offset = footer_partition;
     entry.body_sid = 0;
-    g_array_append_val (rip, entry);
+    g_array_append_val (mux->partitions, entry);
 
-    packet = mxf_random_index_pack_to_buffer (rip);
+    packet = mxf_random_index_pack_to_buffer (mux->partitions);
     if ((ret = gst_mxf_mux_push (mux, packet)) != GST_FLOW_OK) {
       GST_ERROR_OBJECT (mux, "Failed pushing random index pack");
     }
-    g_array_free (rip, TRUE);
 
     /* Rewrite header partition with updated values */
     gst_segment_init (&segment, GST_FORMAT_BYTES);
@@ -72,6 +72,15 @@ typedef struct _GstMXFMux {
   GArray *index_table;
   guint current_index_pos;
   guint64 last_keyframe_pos;
+  /* edit unit of the first index entry not written yet */
+  guint64 index_start_position;
+
+  /* random index pack entries of the partitions written so far */
+  GArray *partitions;
+  GstClockTime last_partition_timestamp;
+
+  /* Properties */
+  GstClockTime partition_interval;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
@@ -66,6 +66,11 @@ enum
   PROP_MAX_KBPS,
   PROP_MAX_BUCKET_SIZE,
   PROP_ALLOW_REORDERING,
+  PROP_SEED,
+  PROP_BURST_ENTER_PROBABILITY,
+  PROP_BURST_EXIT_PROBABILITY,
+  PROP_BURST_DROP_PROBABILITY,
+  PROP_BANDWIDTH_SCHEDULE,
 };
 
 /* these numbers are nothing but wild guesses and dont reflect any reality */
@@ -79,6 +84,11 @@ enum
 #define DEFAULT_MAX_KBPS -1
 #define DEFAULT_MAX_BUCKET_SIZE -1
 #define DEFAULT_ALLOW_REORDERING TRUE
+#define DEFAULT_SEED -1
+#define DEFAULT_BURST_ENTER_PROBABILITY 0.0
+#define DEFAULT_BURST_EXIT_PROBABILITY 0.0
+#define DEFAULT_BURST_DROP_PROBABILITY 1.0
+#define DEFAULT_BANDWIDTH_SCHEDULE NULL
 
 static GstStaticPadTemplate gst_net_sim_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
@@ -94,148 +104,189 @@ GST_STATIC_PAD_TEMPLATE ("src",
 
 G_DEFINE_TYPE (GstNetSim, gst_net_sim, GST_TYPE_ELEMENT);
 
-static gboolean
-gst_net_sim_source_dispatch (GSource * source,
-    GSourceFunc callback, gpointer user_data)
+typedef struct
 {
-  callback (user_data);
-  return FALSE;
-}
+  GstClockTime time;
+  guint64 seqnum;
+  GstBuffer *buf;
+} NetSimPacket;
 
-GSourceFuncs gst_net_sim_source_funcs = {
-  NULL,                         /* prepare */
-  NULL,                         /* check */
-  gst_net_sim_source_dispatch,
-  NULL                          /* finalize */
-};
+typedef struct
+{
+  GstClockTime offset;
+  gint kbps;
+} NetSimBandwidth;
 
-static void
-gst_net_sim_loop (GstNetSim * netsim)
+/* earlier time first, and arrival order for equal times */
+#define PACKET_BEFORE(a,b) ((a)->time < (b)->time || \
+    ((a)->time == (b)->time && (a)->seqnum < (b)->seqnum))
+
+#define QUEUE_HEAD(netsim) (&g_array_index ((netsim)->queue, NetSimPacket, 0))
+
+/* The pipeline clock, or the system clock while there is none. Using the
+ * element's clock makes the delays follow a test clock. */
+static GstClock *
+gst_net_sim_get_clock (GstNetSim * netsim)
 {
-  GMainLoop *loop;
-
-  GST_TRACE_OBJECT (netsim, "TASK: begin");
-
-  g_mutex_lock (&netsim->loop_mutex);
-  loop = g_main_loop_ref (netsim->main_loop);
-  netsim->running = TRUE;
-  GST_TRACE_OBJECT (netsim, "TASK: signal start");
-  g_cond_signal (&netsim->start_cond);
-  g_mutex_unlock (&netsim->loop_mutex);
-
-  GST_TRACE_OBJECT (netsim, "TASK: run");
-  g_main_loop_run (loop);
-  g_main_loop_unref (loop);
-
-  g_mutex_lock (&netsim->loop_mutex);
-  GST_TRACE_OBJECT (netsim, "TASK: pause");
-  gst_pad_pause_task (netsim->srcpad);
-  netsim->running = FALSE;
-  GST_TRACE_OBJECT (netsim, "TASK: signal end");
-  g_cond_signal (&netsim->start_cond);
-  g_mutex_unlock (&netsim->loop_mutex);
-  GST_TRACE_OBJECT (netsim, "TASK: end");
+  GstClock *clock = gst_element_get_clock (GST_ELEMENT_CAST (netsim));
+
+  if (clock == NULL)
+    clock = gst_system_clock_obtain ();
+
+  return clock;
 }
 
-static gboolean
-_main_loop_quit_and_remove_source (gpointer user_data)
+static void
+gst_net_sim_queue_push (GstNetSim * netsim, GstClockTime time, GstBuffer * buf)
 {
-  GMainLoop *main_loop = user_data;
-  GST_DEBUG ("MAINLOOP: Quit %p", main_loop);
-  g_main_loop_quit (main_loop);
-  g_assert (!g_main_loop_is_running (main_loop));
-  return FALSE;                 /* Remove source */
+  NetSimPacket packet, *heap;
+  guint i, parent;
+
+  packet.time = time;
+  packet.seqnum = netsim->queue_seqnum++;
+  packet.buf = buf;
+
+  i = netsim->queue->len;
+  g_array_set_size (netsim->queue, i + 1);
+  heap = (NetSimPacket *) netsim->queue->data;
+
+  while (i > 0) {
+    parent = (i - 1) / 2;
+    if (!PACKET_BEFORE (&packet, &heap[parent]))
+      break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = packet;
 }
 
-static gboolean
-gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
-    GstPadMode mode, gboolean active)
+static GstBuffer *
+gst_net_sim_queue_pop (GstNetSim * netsim)
 {
-  GstNetSim *netsim = GST_NET_SIM (parent);
-  gboolean result = FALSE;
-
-  g_mutex_lock (&netsim->loop_mutex);
-  if (active) {
-    if (netsim->main_loop == NULL) {
-      GMainContext *main_context = g_main_context_new ();
-      netsim->main_loop = g_main_loop_new (main_context, FALSE);
-      g_main_context_unref (main_context);
-
-      GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
-      result = gst_pad_start_task (netsim->srcpad,
-          (GstTaskFunction) gst_net_sim_loop, netsim, NULL);
-
-      GST_TRACE_OBJECT (netsim, "ACT: Wait for task to start");
-      g_assert (!netsim->running);
-      while (!netsim->running)
-        g_cond_wait (&netsim->start_cond, &netsim->loop_mutex);
-      GST_TRACE_OBJECT (netsim, "ACT: Task on srcpad started");
-    }
-  } else {
-    if (netsim->main_loop != NULL) {
-      GSource *source;
-      guint id;
-
-      /* Adds an Idle Source which quits the main loop from within.
-       * This removes the possibility for run/quit race conditions. */
-      GST_TRACE_OBJECT (netsim, "DEACT: Stopping main loop on deactivate");
-      source = g_idle_source_new ();
-      g_source_set_callback (source, _main_loop_quit_and_remove_source,
-          g_main_loop_ref (netsim->main_loop),
-          (GDestroyNotify) g_main_loop_unref);
-      id = g_source_attach (source,
-          g_main_loop_get_context (netsim->main_loop));
-      g_source_unref (source);
-      g_assert_cmpuint (id, >, 0);
-      g_main_loop_unref (netsim->main_loop);
-      netsim->main_loop = NULL;
-
-      GST_TRACE_OBJECT (netsim, "DEACT: Wait for mainloop and task to pause");
-      g_assert (netsim->running);
-      while (netsim->running)
-        g_cond_wait (&netsim->start_cond, &netsim->loop_mutex);
-
-      GST_TRACE_OBJECT (netsim, "DEACT: Stopping task on srcpad");
-      result = gst_pad_stop_task (netsim->srcpad);
-      GST_TRACE_OBJECT (netsim, "DEACT: Mainloop and GstTask stopped");
-    }
+  NetSimPacket *heap = (NetSimPacket *) netsim->queue->data;
+  guint n = netsim->queue->len - 1;
+  NetSimPacket last = heap[n];
+  GstBuffer *buf = heap[0].buf;
+  guint i = 0, child;
+
+  while ((child = 2 * i + 1) < n) {
+    if (child + 1 < n && PACKET_BEFORE (&heap[child + 1], &heap[child]))
+      child++;
+    if (!PACKET_BEFORE (&heap[child], &last))
+      break;
+    heap[i] = heap[child];
+    i = child;
   }
-  g_mutex_unlock (&netsim->loop_mutex);
+  heap[i] = last;
+  g_array_set_size (netsim->queue, n);
 
-  return result;
+  return buf;
 }
 
-typedef struct
+static void
+gst_net_sim_queue_clear (GstNetSim * netsim)
 {
-  GstPad *pad;
-  GstBuffer *buf;
-} PushBufferCtx;
+  guint i;
 
-G_INLINE_FUNC PushBufferCtx *
-push_buffer_ctx_new (GstPad * pad, GstBuffer * buf)
-{
-  PushBufferCtx *ctx = g_slice_new (PushBufferCtx);
-  ctx->pad = gst_object_ref (pad);
-  ctx->buf = gst_buffer_ref (buf);
-  return ctx;
+  for (i = 0; i < netsim->queue->len; i++)
+    gst_buffer_unref (g_array_index (netsim->queue, NetSimPacket, i).buf);
+  g_array_set_size (netsim->queue, 0);
 }
 
-G_INLINE_FUNC void
-push_buffer_ctx_free (PushBufferCtx * ctx)
+/* Waits for the earliest delayed buffer and pushes all buffers that are due
+ * by then as one list, so a busy link costs one wakeup per batch instead of
+ * one per buffer. */
+static void
+gst_net_sim_loop (GstNetSim * netsim)
 {
-  if (G_LIKELY (ctx != NULL)) {
-    gst_buffer_unref (ctx->buf);
-    gst_object_unref (ctx->pad);
-    g_slice_free (PushBufferCtx, ctx);
+  GstBufferList *list;
+  GstClock *clock;
+  GstClockTime now;
+  GstClockID id;
+
+  g_mutex_lock (&netsim->queue_mutex);
+  while (netsim->running && netsim->queue->len == 0)
+    g_cond_wait (&netsim->queue_cond, &netsim->queue_mutex);
+
+  if (!netsim->running) {
+    GST_TRACE_OBJECT (netsim, "TASK: pause");
+    gst_pad_pause_task (netsim->srcpad);
+    g_mutex_unlock (&netsim->queue_mutex);
+    return;
   }
+
+  clock = gst_net_sim_get_clock (netsim);
+  now = gst_clock_get_time (clock);
+
+  if (QUEUE_HEAD (netsim)->time > now) {
+    /* woken up early by an earlier buffer or by deactivation */
+    id = gst_clock_new_single_shot_id (clock, QUEUE_HEAD (netsim)->time);
+    netsim->clock_id = id;
+    g_mutex_unlock (&netsim->queue_mutex);
+
+    GST_TRACE_OBJECT (netsim, "TASK: wait");
+    gst_clock_id_wait (id, NULL);
+
+    g_mutex_lock (&netsim->queue_mutex);
+    netsim->clock_id = NULL;
+    g_mutex_unlock (&netsim->queue_mutex);
+    gst_clock_id_unref (id);
+    gst_object_unref (clock);
+    return;
+  }
+  gst_object_unref (clock);
+
+  list = gst_buffer_list_new ();
+  while (netsim->queue->len > 0 && QUEUE_HEAD (netsim)->time <= now)
+    gst_buffer_list_add (list, gst_net_sim_queue_pop (netsim));
+  g_mutex_unlock (&netsim->queue_mutex);
+
+  GST_DEBUG_OBJECT (netsim, "Pushing %u delayed buffers",
+      gst_buffer_list_length (list));
+  gst_pad_push_list (netsim->srcpad, list);
 }
 
 static gboolean
-push_buffer_ctx_push (PushBufferCtx * ctx)
+gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
 {
-  GST_DEBUG_OBJECT (ctx->pad, "Pushing buffer now");
-  gst_pad_push (ctx->pad, gst_buffer_ref (ctx->buf));
-  return FALSE;
+  GstNetSim *netsim = GST_NET_SIM (parent);
+  gboolean result;
+
+  if (active) {
+    g_mutex_lock (&netsim->queue_mutex);
+    netsim->running = TRUE;
+    netsim->last_ready_time = 0;
+    netsim->burst = FALSE;
+    netsim->delay_state.generate = FALSE;
+    if (netsim->seed >= 0)
+      g_rand_set_seed (netsim->rand_seed, netsim->seed);
+    g_mutex_unlock (&netsim->queue_mutex);
+
+    GST_OBJECT_LOCK (netsim);
+    netsim->schedule_start = GST_CLOCK_TIME_NONE;
+    GST_OBJECT_UNLOCK (netsim);
+
+    GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
+    result = gst_pad_start_task (netsim->srcpad,
+        (GstTaskFunction) gst_net_sim_loop, netsim, NULL);
+  } else {
+    g_mutex_lock (&netsim->queue_mutex);
+    netsim->running = FALSE;
+    if (netsim->clock_id)
+      gst_clock_id_unschedule (netsim->clock_id);
+    g_cond_signal (&netsim->queue_cond);
+    g_mutex_unlock (&netsim->queue_mutex);
+
+    GST_TRACE_OBJECT (netsim, "DEACT: Stopping task on srcpad");
+    result = gst_pad_stop_task (netsim->srcpad);
+
+    g_mutex_lock (&netsim->queue_mutex);
+    gst_net_sim_queue_clear (netsim);
+    g_mutex_unlock (&netsim->queue_mutex);
+  }
+
+  return result;
 }
 
 static gint
@@ -331,13 +382,12 @@ gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
 {
   GstFlowReturn ret = GST_FLOW_OK;
 
-  g_mutex_lock (&netsim->loop_mutex);
-  if (netsim->main_loop != NULL && netsim->delay_probability > 0 &&
+  g_mutex_lock (&netsim->queue_mutex);
+  if (netsim->running && netsim->delay_probability > 0 &&
       g_rand_double (netsim->rand_seed) < netsim->delay_probability) {
     gint delay;
-    PushBufferCtx *ctx;
-    GSource *source;
-    gint64 ready_time, now_time;
+    GstClock *clock;
+    GstClockTime ready_time, now_time;
 
     switch (netsim->delay_distribution) {
       case DISTRIBUTION_UNIFORM:
@@ -360,27 +410,32 @@ gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
     if (delay < 0)
       delay = 0;
 
-    ctx = push_buffer_ctx_new (netsim->srcpad, buf);
+    clock = gst_net_sim_get_clock (netsim);
+    now_time = gst_clock_get_time (clock);
+    gst_object_unref (clock);
 
-    source = g_source_new (&gst_net_sim_source_funcs, sizeof (GSource));
-    now_time = g_get_monotonic_time ();
-    ready_time = now_time + delay * 1000;
+    ready_time = now_time + delay * GST_MSECOND;
+    /* equal times keep the arrival order */
     if (!netsim->allow_reordering && ready_time < netsim->last_ready_time)
-      ready_time = netsim->last_ready_time + 1;
+      ready_time = netsim->last_ready_time;
 
     netsim->last_ready_time = ready_time;
-    GST_DEBUG_OBJECT (netsim, "Delaying packet by %" G_GINT64_FORMAT "ms",
-        (ready_time - now_time) / 1000);
-
-    g_source_set_ready_time (source, ready_time);
-    g_source_set_callback (source, (GSourceFunc) push_buffer_ctx_push,
-        ctx, (GDestroyNotify) push_buffer_ctx_free);
-    g_source_attach (source, g_main_loop_get_context (netsim->main_loop));
-    g_source_unref (source);
+    GST_DEBUG_OBJECT (netsim, "Delaying packet by %" G_GUINT64_FORMAT "ms",
+        (ready_time - now_time) / GST_MSECOND);
+
+    gst_net_sim_queue_push (netsim, ready_time, gst_buffer_ref (buf));
+
+    /* the task waits for the previous head, wake it up to wait for this one */
+    if (QUEUE_HEAD (netsim)->seqnum == netsim->queue_seqnum - 1) {
+      if (netsim->clock_id)
+        gst_clock_id_unschedule (netsim->clock_id);
+      g_cond_signal (&netsim->queue_cond);
+    }
+    g_mutex_unlock (&netsim->queue_mutex);
   } else {
+    g_mutex_unlock (&netsim->queue_mutex);
     ret = gst_pad_push (netsim->srcpad, gst_buffer_ref (buf));
   }
-  g_mutex_unlock (&netsim->loop_mutex);
 
   return ret;
 }
@@ -468,12 +523,134 @@ gst_net_sim_token_bucket (GstNetSim * netsim, GstBuffer * buf)
   return TRUE;
 }
 
+static gint
+compare_bandwidth (gconstpointer a, gconstpointer b)
+{
+  const NetSimBandwidth *bw_a = a, *bw_b = b;
+
+  if (bw_a->offset < bw_b->offset)
+    return -1;
+  return bw_a->offset > bw_b->offset;
+}
+
+/* Parses a list of <time-ms>:<kbps> pairs */
+static GArray *
+gst_net_sim_parse_schedule (const gchar * str)
+{
+  GArray *schedule = g_array_new (FALSE, FALSE, sizeof (NetSimBandwidth));
+  gchar **entries = g_strsplit (str, ",", -1);
+  NetSimBandwidth bw;
+  gchar *entry, *end;
+  gint64 kbps;
+  guint i;
+
+  for (i = 0; entries[i] != NULL; i++) {
+    entry = g_strstrip (entries[i]);
+
+    bw.offset = g_ascii_strtoull (entry, &end, 10) * GST_MSECOND;
+    if (end == entry || *end != ':')
+      goto error;
+
+    entry = end + 1;
+    kbps = g_ascii_strtoll (entry, &end, 10);
+    if (end == entry || *end != '\0' || kbps == 0 || kbps < -1 ||
+        kbps > G_MAXINT)
+      goto error;
+
+    bw.kbps = kbps;
+    g_array_append_val (schedule, bw);
+  }
+
+  g_strfreev (entries);
+  g_array_sort (schedule, compare_bandwidth);
+  return schedule;
+
+error:
+  g_strfreev (entries);
+  g_array_free (schedule, TRUE);
+  return NULL;
+}
+
+/* Applies the bandwidth-schedule entry that is due since the first buffer */
+static void
+gst_net_sim_update_bandwidth (GstNetSim * netsim)
+{
+  NetSimBandwidth *bw, *current = NULL;
+  GstClock *clock;
+  GstClockTime now, elapsed;
+  guint i;
+
+  if (netsim->schedule == NULL)
+    return;
+
+  clock = gst_net_sim_get_clock (netsim);
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
+
+  GST_OBJECT_LOCK (netsim);
+  if (netsim->schedule == NULL)
+    goto done;
+
+  if (!GST_CLOCK_TIME_IS_VALID (netsim->schedule_start))
+    netsim->schedule_start = now;
+  elapsed = now > netsim->schedule_start ? now - netsim->schedule_start : 0;
+
+  for (i = 0; i < netsim->schedule->len; i++) {
+    bw = &g_array_index (netsim->schedule, NetSimBandwidth, i);
+    if (bw->offset > elapsed)
+      break;
+    current = bw;
+  }
+
+  if (current != NULL && current->kbps != netsim->max_kbps) {
+    GST_DEBUG_OBJECT (netsim, "Changing max-kbps from %d to %d at %"
+        GST_TIME_FORMAT, netsim->max_kbps, current->kbps,
+        GST_TIME_ARGS (elapsed));
+    netsim->max_kbps = current->kbps;
+  }
+
+done:
+  GST_OBJECT_UNLOCK (netsim);
+}
+
+/* Gilbert-Elliott model: a two state Markov chain, changing state with
+ * burst-enter-probability and burst-exit-probability before each packet.
+ * drop-probability applies in the good state, burst-drop-probability in the
+ * bad one. Without burst-enter-probability this is plain random loss. */
+static gboolean
+gst_net_sim_random_drop (GstNetSim * netsim)
+{
+  gfloat probability = netsim->drop_probability;
+
+  if (netsim->burst_enter_probability > 0 || netsim->burst) {
+    if (!netsim->burst) {
+      if (g_rand_double (netsim->rand_seed) <
+          (gdouble) netsim->burst_enter_probability) {
+        GST_DEBUG_OBJECT (netsim, "Entering loss burst");
+        netsim->burst = TRUE;
+      }
+    } else if (g_rand_double (netsim->rand_seed) <
+        (gdouble) netsim->burst_exit_probability) {
+      GST_DEBUG_OBJECT (netsim, "Leaving loss burst");
+      netsim->burst = FALSE;
+    }
+
+    if (netsim->burst)
+      probability = netsim->burst_drop_probability;
+  }
+
+  return probability > 0 &&
+      g_rand_double (netsim->rand_seed) < (gdouble) probability;
+}
+
 static GstFlowReturn
 gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
   GstNetSim *netsim = GST_NET_SIM (parent);
   GstFlowReturn ret = GST_FLOW_OK;
 
+  gst_net_sim_update_bandwidth (netsim);
+
   if (!gst_net_sim_token_bucket (netsim, buf))
     goto done;
 
@@ -481,9 +658,7 @@ gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     netsim->drop_packets--;
     GST_DEBUG_OBJECT (netsim, "Dropping packet (%d left)",
         netsim->drop_packets);
-  } else if (netsim->drop_probability > 0
-      && g_rand_double (netsim->rand_seed) <
-      (gdouble) netsim->drop_probability) {
+  } else if (gst_net_sim_random_drop (netsim)) {
     GST_DEBUG_OBJECT (netsim, "Dropping packet");
   } else if (netsim->duplicate_probability > 0 &&
       g_rand_double (netsim->rand_seed) <
@@ -540,6 +715,42 @@ gst_net_sim_set_property (GObject * object,
     case PROP_ALLOW_REORDERING:
       netsim->allow_reordering = g_value_get_boolean (value);
       break;
+    case PROP_SEED:
+      netsim->seed = g_value_get_int64 (value);
+      if (netsim->seed >= 0)
+        g_rand_set_seed (netsim->rand_seed, netsim->seed);
+      break;
+    case PROP_BURST_ENTER_PROBABILITY:
+      netsim->burst_enter_probability = g_value_get_float (value);
+      break;
+    case PROP_BURST_EXIT_PROBABILITY:
+      netsim->burst_exit_probability = g_value_get_float (value);
+      break;
+    case PROP_BURST_DROP_PROBABILITY:
+      netsim->burst_drop_probability = g_value_get_float (value);
+      break;
+    case PROP_BANDWIDTH_SCHEDULE:{
+      const gchar *str = g_value_get_string (value);
+      GArray *schedule = NULL;
+
+      if (str != NULL && *str != '\0') {
+        schedule = gst_net_sim_parse_schedule (str);
+        if (schedule == NULL) {
+          GST_WARNING_OBJECT (netsim, "Invalid bandwidth schedule '%s'", str);
+          break;
+        }
+      }
+
+      GST_OBJECT_LOCK (netsim);
+      if (netsim->schedule)
+        g_array_free (netsim->schedule, TRUE);
+      netsim->schedule = schedule;
+      netsim->schedule_start = GST_CLOCK_TIME_NONE;
+      g_free (netsim->bandwidth_schedule);
+      netsim->bandwidth_schedule = g_strdup (str);
+      GST_OBJECT_UNLOCK (netsim);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -583,6 +794,23 @@ gst_net_sim_get_property (GObject * object,
     case PROP_ALLOW_REORDERING:
       g_value_set_boolean (value, netsim->allow_reordering);
       break;
+    case PROP_SEED:
+      g_value_set_int64 (value, netsim->seed);
+      break;
+    case PROP_BURST_ENTER_PROBABILITY:
+      g_value_set_float (value, netsim->burst_enter_probability);
+      break;
+    case PROP_BURST_EXIT_PROBABILITY:
+      g_value_set_float (value, netsim->burst_exit_probability);
+      break;
+    case PROP_BURST_DROP_PROBABILITY:
+      g_value_set_float (value, netsim->burst_drop_probability);
+      break;
+    case PROP_BANDWIDTH_SCHEDULE:
+      GST_OBJECT_LOCK (netsim);
+      g_value_set_string (value, netsim->bandwidth_schedule);
+      GST_OBJECT_UNLOCK (netsim);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -601,11 +829,12 @@ gst_net_sim_init (GstNetSim * netsim)
   gst_element_add_pad (GST_ELEMENT (netsim), netsim->srcpad);
   gst_element_add_pad (GST_ELEMENT (netsim), netsim->sinkpad);
 
-  g_mutex_init (&netsim->loop_mutex);
-  g_cond_init (&netsim->start_cond);
+  g_mutex_init (&netsim->queue_mutex);
+  g_cond_init (&netsim->queue_cond);
+  netsim->queue = g_array_new (FALSE, FALSE, sizeof (NetSimPacket));
   netsim->rand_seed = g_rand_new ();
-  netsim->main_loop = NULL;
   netsim->prev_time = GST_CLOCK_TIME_NONE;
+  netsim->schedule_start = GST_CLOCK_TIME_NONE;
 
   GST_OBJECT_FLAG_SET (netsim->sinkpad,
       GST_PAD_FLAG_PROXY_CAPS | GST_PAD_FLAG_PROXY_ALLOCATION);
@@ -621,9 +850,14 @@ gst_net_sim_finalize (GObject * object)
 {
   GstNetSim *netsim = GST_NET_SIM (object);
 
+  gst_net_sim_queue_clear (netsim);
+  g_array_free (netsim->queue, TRUE);
+  if (netsim->schedule)
+    g_array_free (netsim->schedule, TRUE);
+  g_free (netsim->bandwidth_schedule);
   g_rand_free (netsim->rand_seed);
-  g_mutex_clear (&netsim->loop_mutex);
-  g_cond_clear (&netsim->start_cond);
+  g_mutex_clear (&netsim->queue_mutex);
+  g_cond_clear (&netsim->queue_cond);
 
   G_OBJECT_CLASS (gst_net_sim_parent_class)->finalize (object);
 }
@@ -633,7 +867,7 @@ gst_net_sim_dispose (GObject * object)
 {
   GstNetSim *netsim = GST_NET_SIM (object);
 
-  g_assert (netsim->main_loop == NULL);
+  g_assert (!netsim->running);
 
   G_OBJECT_CLASS (gst_net_sim_parent_class)->dispose (object);
 }
@@ -755,6 +989,84 @@ gst_net_sim_class_init (GstNetSimClass * klass)
           DEFAULT_ALLOW_REORDERING,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstNetSim:seed:
+   *
+   * Seed for the random number generator behind delay, drop and
+   * duplication decisions. The generator is reseeded each time the element
+   * starts, so that runs with the same input and properties are
+   * reproducible. Delays follow the pipeline clock, which makes their
+   * timing reproducible too when that is a #GstTestClock.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_SEED,
+      g_param_spec_int64 ("seed", "Seed",
+          "Seed for the random number generator (-1 = random)",
+          -1, G_MAXUINT32, DEFAULT_SEED,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:burst-enter-probability:
+   *
+   * Probability per packet of moving from the good to the bad state of a
+   * Gilbert-Elliott loss model. In the good state packets are dropped with
+   * "drop-probability", in the bad state with "burst-drop-probability". The
+   * mean burst length is 1 / "burst-exit-probability" packets.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_BURST_ENTER_PROBABILITY,
+      g_param_spec_float ("burst-enter-probability",
+          "Burst Enter Probability",
+          "The Probability of moving into the loss burst state per buffer",
+          0.0, 1.0, DEFAULT_BURST_ENTER_PROBABILITY,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:burst-exit-probability:
+   *
+   * Probability per packet of leaving the bad state of the Gilbert-Elliott
+   * loss model, see "burst-enter-probability".
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_BURST_EXIT_PROBABILITY,
+      g_param_spec_float ("burst-exit-probability", "Burst Exit Probability",
+          "The Probability of leaving the loss burst state per buffer",
+          0.0, 1.0, DEFAULT_BURST_EXIT_PROBABILITY,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:burst-drop-probability:
+   *
+   * Probability a buffer is dropped in the bad state of the Gilbert-Elliott
+   * loss model, see "burst-enter-probability".
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_BURST_DROP_PROBABILITY,
+      g_param_spec_float ("burst-drop-probability", "Burst Drop Probability",
+          "The Probability a buffer is dropped in the loss burst state",
+          0.0, 1.0, DEFAULT_BURST_DROP_PROBABILITY,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:bandwidth-schedule:
+   *
+   * Changes of "max-kbps" over time, as a comma separated list of
+   * time:kbps pairs with the time in milliseconds since the first buffer,
+   * e.g. "0:2000,10000:500,20000:-1". Like "max-kbps", this needs a
+   * "max-bucket-size".
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_BANDWIDTH_SCHEDULE,
+      g_param_spec_string ("bandwidth-schedule", "Bandwidth Schedule",
+          "Comma separated list of time-ms:kbps changes of max-kbps",
+          DEFAULT_BANDWIDTH_SCHEDULE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (netsim_debug, "netsim", 0, "Network simulator");
 }
 
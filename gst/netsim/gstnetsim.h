@@ -67,15 +67,22 @@ struct _GstNetSim
   GstPad *sinkpad;
   GstPad *srcpad;
 
-  GMutex loop_mutex;
-  GCond start_cond;
-  GMainLoop *main_loop;
+  /* delayed buffers, a binary heap ordered by time and arrival */
+  GMutex queue_mutex;
+  GCond queue_cond;
+  GArray *queue;
+  guint64 queue_seqnum;
+  GstClockID clock_id;
   gboolean running;
+  GstClockTime last_ready_time;
+
   GRand *rand_seed;
   gsize bucket_size;
   GstClockTime prev_time;
   NormalDistributionState delay_state;
-  gint64 last_ready_time;
+  gboolean burst;
+  GArray *schedule;
+  GstClockTime schedule_start;
 
   /* properties */
   gint min_delay;
@@ -88,6 +95,11 @@ struct _GstNetSim
   gint max_kbps;
   gint max_bucket_size;
   gboolean allow_reordering;
+  gint64 seed;
+  gfloat burst_enter_probability;
+  gfloat burst_exit_probability;
+  gfloat burst_drop_probability;
+  gchar *bandwidth_schedule;
 };
 
 struct _GstNetSimClass
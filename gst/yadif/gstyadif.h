@@ -53,6 +53,18 @@ struct _GstYadif
   GstVideoFrame cur_frame;
   GstVideoFrame next_frame;
   GstVideoFrame dest_frame;
+
+  guint n_threads;
+
+  /* slices of a field are filtered in parallel, the streaming thread
+   * takes the first one */
+  GThreadPool *pool;
+  guint n_slices;
+  int parity;
+  int tff;
+  GMutex slice_lock;
+  GCond slice_cond;
+  guint slices_pending;
 };
 
 struct _GstYadifClass
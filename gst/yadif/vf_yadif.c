@@ -23,9 +23,11 @@
 
 #include "config.h"
 
-#include <gstyadif.h>
+#include "gstyadif.h"
 #include <string.h>
 
+#include "yadif.h"
+
 #undef NDEBUG
 #include <assert.h>
 
@@ -46,8 +48,10 @@
             spatial_score= score;\
             spatial_pred= (cur[mrefs  +(j)] + cur[prefs  -(j)])>>1;\
 
-#define FILTER \
-    for (x = 0;  x < w; x++) { \
+/* The spatial check looks at 3 pixels to each side, so it is only done
+ * when not at the line edges */
+#define FILTER(start, end, is_not_edge) \
+    for (x = start;  x < end; x++) { \
         int c = cur[mrefs]; \
         int d = (prev2[0] + next2[0])>>1; \
         int e = cur[prefs]; \
@@ -56,11 +60,10 @@
         int temporal_diff2 =(FFABS(next[mrefs] - c) + FFABS(next[prefs] - e) )>>1; \
         int diff = FFMAX3(temporal_diff0 >> 1, temporal_diff1, temporal_diff2); \
         int spatial_pred = (c+e) >> 1; \
-        int spatial_score = -1; \
  \
-        if (mrefs > 0 && prefs > 0) { \
-            spatial_score = FFABS(cur[mrefs - 1] - cur[prefs - 1]) + FFABS(c-e) \
-                            + FFABS(cur[mrefs + 1] - cur[prefs + 1]) - 1; \
+        if (is_not_edge) { \
+            int spatial_score = FFABS(cur[mrefs - 1] - cur[prefs - 1]) + FFABS(c-e) \
+                              + FFABS(cur[mrefs + 1] - cur[prefs + 1]) - 1; \
  \
             CHECK(-1) CHECK(-2) }} }} \
             CHECK( 1) CHECK( 2) }} }} \
@@ -89,75 +92,182 @@
         next2++; \
     }
 
+#define SKIP(n) \
+    dst += (n); \
+    cur += (n); \
+    prev += (n); \
+    next += (n); \
+    prev2 += (n); \
+    next2 += (n);
+
+void
+yadif_filter_line_c (void *dst1, const void *prev1, const void *cur1,
+    const void *next1, int w, int prefs, int mrefs, int parity, int mode)
+{
+  int x;
+  guint8 *dst = dst1;
+  const guint8 *prev = prev1;
+  const guint8 *cur = cur1;
+  const guint8 *next = next1;
+  const guint8 *prev2 = parity ? prev : cur;
+  const guint8 *next2 = parity ? cur : next;
+
+FILTER (0, w, 1)}
+
+/* The 3 pixels at both ends of a line */
 static void
-filter_line_c (guint8 * dst,
-    guint8 * prev, guint8 * cur, guint8 * next,
-    int w, int prefs, int mrefs, int parity, int mode)
+filter_edges_c (void *dst1, const void *prev1, const void *cur1,
+    const void *next1, int w, int prefs, int mrefs, int parity, int mode)
 {
   int x;
-  guint8 *prev2 = parity ? prev : cur;
-  guint8 *next2 = parity ? cur : next;
+  guint8 *dst = dst1;
+  const guint8 *prev = prev1;
+  const guint8 *cur = cur1;
+  const guint8 *next = next1;
+  const guint8 *prev2 = parity ? prev : cur;
+  const guint8 *next2 = parity ? cur : next;
 
-FILTER}
+  FILTER (0, MIN (w, 3), 0)
+  if (w > 6) {
+    SKIP (w - 6)
+  }
+  FILTER (MAX (w - 3, 3), w, 0)
+}
+
+void
+yadif_filter_line_c_16bit (void *dst1, const void *prev1, const void *cur1,
+    const void *next1, int w, int prefs, int mrefs, int parity, int mode)
+{
+  int x;
+  guint16 *dst = dst1;
+  const guint16 *prev = prev1;
+  const guint16 *cur = cur1;
+  const guint16 *next = next1;
+  const guint16 *prev2 = parity ? prev : cur;
+  const guint16 *next2 = parity ? cur : next;
+
+FILTER (0, w, 1)}
 
-#if 0
 static void
-filter_line_c_16bit (guint16 * dst,
-    guint16 * prev, guint16 * cur, guint16 * next,
-    int w, int prefs, int mrefs, int parity, int mode)
+filter_edges_c_16bit (void *dst1, const void *prev1, const void *cur1,
+    const void *next1, int w, int prefs, int mrefs, int parity, int mode)
 {
   int x;
-  guint16 *prev2 = parity ? prev : cur;
-  guint16 *next2 = parity ? cur : next;
-  mrefs /= 2;
-  prefs /= 2;
+  guint16 *dst = dst1;
+  const guint16 *prev = prev1;
+  const guint16 *cur = cur1;
+  const guint16 *next = next1;
+  const guint16 *prev2 = parity ? prev : cur;
+  const guint16 *next2 = parity ? cur : next;
 
-FILTER}
-#endif
+  FILTER (0, MIN (w, 3), 0)
+  if (w > 6) {
+    SKIP (w - 6)
+  }
+  FILTER (MAX (w - 3, 3), w, 0)
+}
+
+typedef struct
+{
+  /* SIMD kernel for whole steps of the inner part of a line, can be NULL */
+  YadifFilterLineFunc simd;
+  int step;
+  YadifFilterLineFunc line;
+  YadifFilterLineFunc edges;
+} YadifLineFilter;
+
+static YadifLineFilter line_filters[2];
+
+static gpointer
+yadif_init_line_filters (gpointer data)
+{
+  line_filters[0].line = yadif_filter_line_c;
+  line_filters[0].edges = filter_edges_c;
+  line_filters[1].line = yadif_filter_line_c_16bit;
+  line_filters[1].edges = filter_edges_c_16bit;
 
-void yadif_filter (GstYadif * yadif, int parity, int tff);
 #ifdef HAVE_CPU_X86_64
-void filter_line_x86_64 (guint8 * dst,
-    guint8 * prev, guint8 * cur, guint8 * next,
-    int w, int prefs, int mrefs, int parity, int mode);
+  line_filters[0].simd = filter_line_x86_64;
+  line_filters[0].step = YADIF_SSE2_STEP;
+#endif
+#ifdef HAVE_YADIF_AVX2
+  if (yadif_have_avx2 ()) {
+    line_filters[0].simd = yadif_filter_line_avx2;
+    line_filters[0].step = YADIF_AVX2_STEP;
+    line_filters[1].simd = yadif_filter_line_16bit_avx2;
+    line_filters[1].step = YADIF_AVX2_STEP;
+  }
+#endif
+#ifdef HAVE_YADIF_NEON
+  line_filters[0].simd = yadif_filter_line_neon;
+  line_filters[0].step = YADIF_NEON_STEP;
+  line_filters[1].simd = yadif_filter_line_16bit_neon;
+  line_filters[1].step = YADIF_NEON_STEP;
 #endif
 
-void
-yadif_filter (GstYadif * yadif, int parity, int tff)
+  return NULL;
+}
+
+/* @df is the size of a pixel, @prefs and @mrefs are in pixels */
+static void
+filter_line (const YadifLineFilter * filter, guint8 * dst,
+    const guint8 * prev, const guint8 * cur, const guint8 * next, int df,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+  int inner = w > 6 ? w - 6 : 0;
+  int done = 0;
+
+  if (filter->simd && inner >= filter->step) {
+    done = inner - inner % filter->step;
+    filter->simd (dst + 3 * df, prev + 3 * df, cur + 3 * df, next + 3 * df,
+        done, prefs, mrefs, parity, mode);
+  }
+  if (done < inner) {
+    int o = (3 + done) * df;
+
+    filter->line (dst + o, prev + o, cur + o, next + o, inner - done,
+        prefs, mrefs, parity, mode);
+  }
+  filter->edges (dst, prev, cur, next, w, prefs, mrefs, parity, mode);
+}
+
+/* Filters the lines of slice @slice out of @n_slices of every plane */
+static void
+yadif_filter_slice (GstYadif * yadif, int parity, int tff, guint slice,
+    guint n_slices)
 {
+  static GOnce init_once = G_ONCE_INIT;
   int y, i;
   const GstVideoInfo *vi = &yadif->video_info;
   const GstVideoFormatInfo *vfi = vi->finfo;
+  const YadifLineFilter *filter;
+
+  g_once (&init_once, yadif_init_line_filters, NULL);
+  filter = &line_filters[GST_VIDEO_FORMAT_INFO_DEPTH (vfi, 0) > 8 ? 1 : 0];
 
   for (i = 0; i < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (vfi); i++) {
     int w = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (vfi, i, vi->width);
     int h = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (vfi, i, vi->height);
     int refs = GST_VIDEO_INFO_COMP_STRIDE (vi, i);
     int df = GST_VIDEO_INFO_COMP_PSTRIDE (vi, i);
+    int prefs = refs / df;
+    int y_start = (gint64) h * slice / n_slices;
+    int y_end = (gint64) h * (slice + 1) / n_slices;
     guint8 *prev_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->prev_frame, i);
     guint8 *cur_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->cur_frame, i);
     guint8 *next_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->next_frame, i);
     guint8 *dest_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->dest_frame, i);
 
-    for (y = 0; y < h; y++) {
+    for (y = y_start; y < y_end; y++) {
       if ((y ^ parity) & 1) {
         guint8 *prev = prev_data + y * refs;
         guint8 *cur = cur_data + y * refs;
         guint8 *next = next_data + y * refs;
         guint8 *dst = dest_data + y * refs;
         int mode = ((y == 1) || (y + 2 == h)) ? 2 : yadif->mode;
-#if HAVE_CPU_X86_64
-        if (0) {
-          filter_line_c (dst, prev, cur, next, w,
-              y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-        } else {
-          filter_line_x86_64 (dst, prev, cur, next, w,
-              y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-        }
-#else
-        filter_line_c (dst, prev, cur, next, w,
-            y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-#endif
+
+        filter_line (filter, dst, prev, cur, next, df, w,
+            y + 1 < h ? prefs : -prefs, y ? -prefs : prefs, parity ^ tff, mode);
       } else {
         guint8 *dst = dest_data + y * refs;
         guint8 *cur = cur_data + y * refs;
@@ -166,8 +276,46 @@ yadif_filter (GstYadif * yadif, int parity, int tff)
       }
     }
   }
+}
 
-#if 0
-  emms_c ();
-#endif
+void yadif_filter (GstYadif * yadif, int parity, int tff);
+void yadif_filter_worker (gpointer data, gpointer user_data);
+
+void
+yadif_filter_worker (gpointer data, gpointer user_data)
+{
+  GstYadif *yadif = user_data;
+
+  yadif_filter_slice (yadif, yadif->parity, yadif->tff,
+      GPOINTER_TO_UINT (data) - 1, yadif->n_slices);
+
+  g_mutex_lock (&yadif->slice_lock);
+  if (--yadif->slices_pending == 0)
+    g_cond_signal (&yadif->slice_cond);
+  g_mutex_unlock (&yadif->slice_lock);
+}
+
+void
+yadif_filter (GstYadif * yadif, int parity, int tff)
+{
+  guint i;
+
+  if (!yadif->pool || yadif->n_slices < 2) {
+    yadif_filter_slice (yadif, parity, tff, 0, 1);
+    return;
+  }
+
+  /* The pool takes all slices but the first, which is done here */
+  yadif->parity = parity;
+  yadif->tff = tff;
+  yadif->slices_pending = yadif->n_slices - 1;
+  for (i = 1; i < yadif->n_slices; i++)
+    g_thread_pool_push (yadif->pool, GUINT_TO_POINTER (i + 1), NULL);
+
+  yadif_filter_slice (yadif, parity, tff, 0, yadif->n_slices);
+
+  g_mutex_lock (&yadif->slice_lock);
+  while (yadif->slices_pending > 0)
+    g_cond_wait (&yadif->slice_cond, &yadif->slice_lock);
+  g_mutex_unlock (&yadif->slice_lock);
 }
@@ -22,6 +22,8 @@
 
 #include <glib.h>
 
+#include "yadif.h"
+
 #if HAVE_CPU_X86_64
 
 typedef struct xmm_reg
@@ -78,14 +80,9 @@ DECLARE_ASM_CONST (16, xmm_reg, pw_1) = {
 #endif
 
 
-void filter_line_x86_64 (guint8 * dst,
-    guint8 * prev, guint8 * cur, guint8 * next,
-    int w, int prefs, int mrefs, int parity, int mode);
-
 void
-filter_line_x86_64 (guint8 * dst,
-    guint8 * prev, guint8 * cur, guint8 * next,
-    int w, int prefs, int mrefs, int parity, int mode)
+filter_line_x86_64 (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode)
 {
 #if 0
 #if HAVE_MMXEXT_INLINE
@@ -101,7 +98,8 @@ filter_line_x86_64 (guint8 * dst,
     yadif->filter_line = yadif_filter_line_ssse3;
 #endif
 #endif
-  yadif_filter_line_sse2 (dst, prev, cur, next, w, prefs, mrefs, parity, mode);
+  yadif_filter_line_sse2 ((guint8 *) dst, (guint8 *) prev, (guint8 *) cur,
+      (guint8 *) next, w, prefs, mrefs, parity, mode);
 }
 
 #endif
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __YADIF_H__
+#define __YADIF_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Filters @w pixels of a line that are at least 3 pixels away from both
+ * line ends, @prefs and @mrefs are in pixels. Line kernels only handle whole
+ * steps of their width, the C code takes care of the rest. */
+typedef void (*YadifFilterLineFunc) (void *dst, const void *prev,
+    const void *cur, const void *next, int w, int prefs, int mrefs,
+    int parity, int mode);
+
+/* The reference the kernels below have to match bit for bit */
+void yadif_filter_line_c (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode);
+void yadif_filter_line_c_16bit (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode);
+
+#ifdef HAVE_CPU_X86_64
+#define YADIF_SSE2_STEP 8
+void filter_line_x86_64 (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode);
+
+/* Built with target attributes, no compiler flags needed */
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || \
+    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define HAVE_YADIF_AVX2 1
+#endif
+#endif
+
+#ifdef HAVE_YADIF_AVX2
+#define YADIF_AVX2_STEP 16
+gboolean yadif_have_avx2 (void);
+void yadif_filter_line_avx2 (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode);
+void yadif_filter_line_16bit_avx2 (void *dst, const void *prev,
+    const void *cur, const void *next, int w, int prefs, int mrefs,
+    int parity, int mode);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_YADIF_NEON 1
+#define YADIF_NEON_STEP 8
+void yadif_filter_line_neon (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode);
+void yadif_filter_line_16bit_neon (void *dst, const void *prev,
+    const void *cur, const void *next, int w, int prefs, int mrefs,
+    int parity, int mode);
+#endif
+
+G_END_DECLS
+
+#endif /* __YADIF_H__ */
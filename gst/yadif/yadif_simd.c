@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* AVX2 and NEON versions of the line filter of vf_yadif.c. Both work on
+ * 16 bit lanes, 8 bit pixels are widened on load, so the same code handles
+ * the 8 bit and the high bit depth formats. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "yadif.h"
+
+#ifdef HAVE_YADIF_AVX2
+
+#include <immintrin.h>
+
+#define AVX2_FUNC __attribute__ ((target ("avx2")))
+#define AVX2_INLINE static inline __attribute__ ((always_inline, target ("avx2")))
+
+gboolean
+yadif_have_avx2 (void)
+{
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("avx2");
+}
+
+AVX2_INLINE __m256i
+load_avx2 (const guint8 * p, int is16)
+{
+  if (is16)
+    return _mm256_loadu_si256 ((const __m256i *) p);
+
+  return _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) p));
+}
+
+AVX2_INLINE __m256i
+absdiff_avx2 (__m256i a, __m256i b)
+{
+  return _mm256_abs_epi16 (_mm256_sub_epi16 (a, b));
+}
+
+AVX2_INLINE void
+filter_line_avx2 (void *dst1, const void *prev1, const void *cur1,
+    const void *next1, int w, int prefs, int mrefs, int parity, int mode,
+    int is16)
+{
+  const int size = is16 ? 2 : 1;
+  const guint8 *prev = prev1;
+  const guint8 *cur = cur1;
+  const guint8 *next = next1;
+  const guint8 *prev2 = parity ? prev : cur;
+  const guint8 *next2 = parity ? cur : next;
+  guint8 *dst = dst1;
+  const __m256i one = _mm256_set1_epi16 (1);
+  int x;
+
+  for (x = 0; x < w; x += YADIF_AVX2_STEP) {
+    const int o = x * size;
+#define L(p, refs) load_avx2 ((p) + o + (refs) * size, is16)
+#define SCORE(j) \
+    _mm256_add_epi16 (_mm256_add_epi16 ( \
+        absdiff_avx2 (L (cur, mrefs - 1 + (j)), L (cur, prefs - 1 - (j))), \
+        absdiff_avx2 (L (cur, mrefs + (j)), L (cur, prefs - (j)))), \
+        absdiff_avx2 (L (cur, mrefs + 1 + (j)), L (cur, prefs + 1 - (j))))
+#define PRED(j) \
+    _mm256_srli_epi16 (_mm256_add_epi16 (L (cur, mrefs + (j)), \
+        L (cur, prefs - (j))), 1)
+    __m256i c = L (cur, mrefs);
+    __m256i e = L (cur, prefs);
+    __m256i p2 = L (prev2, 0);
+    __m256i n2 = L (next2, 0);
+    __m256i d = _mm256_srli_epi16 (_mm256_add_epi16 (p2, n2), 1);
+    __m256i temporal_diff0 = absdiff_avx2 (p2, n2);
+    __m256i temporal_diff1 =
+        _mm256_srli_epi16 (_mm256_add_epi16 (absdiff_avx2 (L (prev, mrefs), c),
+            absdiff_avx2 (L (prev, prefs), e)), 1);
+    __m256i temporal_diff2 =
+        _mm256_srli_epi16 (_mm256_add_epi16 (absdiff_avx2 (L (next, mrefs), c),
+            absdiff_avx2 (L (next, prefs), e)), 1);
+    __m256i diff =
+        _mm256_max_epi16 (_mm256_max_epi16 (_mm256_srli_epi16 (temporal_diff0,
+                1), temporal_diff1), temporal_diff2);
+    __m256i spatial_pred = _mm256_srli_epi16 (_mm256_add_epi16 (c, e), 1);
+    __m256i spatial_score, score, better;
+
+    spatial_score =
+        _mm256_sub_epi16 (_mm256_add_epi16 (_mm256_add_epi16 (absdiff_avx2 (L
+                    (cur, mrefs - 1), L (cur, prefs - 1)), absdiff_avx2 (c,
+                    e)), absdiff_avx2 (L (cur, mrefs + 1), L (cur,
+                    prefs + 1))), one);
+
+    /* The second direction only counts if the first one was better */
+    score = SCORE (-1);
+    better = _mm256_cmpgt_epi16 (spatial_score, score);
+    spatial_score = _mm256_blendv_epi8 (spatial_score, score, better);
+    spatial_pred = _mm256_blendv_epi8 (spatial_pred, PRED (-1), better);
+    score = SCORE (-2);
+    better = _mm256_and_si256 (better,
+        _mm256_cmpgt_epi16 (spatial_score, score));
+    spatial_score = _mm256_blendv_epi8 (spatial_score, score, better);
+    spatial_pred = _mm256_blendv_epi8 (spatial_pred, PRED (-2), better);
+
+    score = SCORE (1);
+    better = _mm256_cmpgt_epi16 (spatial_score, score);
+    spatial_score = _mm256_blendv_epi8 (spatial_score, score, better);
+    spatial_pred = _mm256_blendv_epi8 (spatial_pred, PRED (1), better);
+    score = SCORE (2);
+    better = _mm256_and_si256 (better,
+        _mm256_cmpgt_epi16 (spatial_score, score));
+    spatial_pred = _mm256_blendv_epi8 (spatial_pred, PRED (2), better);
+
+    if (mode < 2) {
+      __m256i b = _mm256_srli_epi16 (_mm256_add_epi16 (L (prev2, 2 * mrefs),
+              L (next2, 2 * mrefs)), 1);
+      __m256i f = _mm256_srli_epi16 (_mm256_add_epi16 (L (prev2, 2 * prefs),
+              L (next2, 2 * prefs)), 1);
+      __m256i dc = _mm256_sub_epi16 (d, c);
+      __m256i de = _mm256_sub_epi16 (d, e);
+      __m256i bc = _mm256_sub_epi16 (b, c);
+      __m256i fe = _mm256_sub_epi16 (f, e);
+      __m256i max = _mm256_max_epi16 (_mm256_max_epi16 (de, dc),
+          _mm256_min_epi16 (bc, fe));
+      __m256i min = _mm256_min_epi16 (_mm256_min_epi16 (de, dc),
+          _mm256_max_epi16 (bc, fe));
+
+      diff = _mm256_max_epi16 (_mm256_max_epi16 (diff, min),
+          _mm256_sub_epi16 (_mm256_setzero_si256 (), max));
+    }
+
+    /* diff is never negative, so this is the same as the C clipping */
+    spatial_pred = _mm256_max_epi16 (_mm256_min_epi16 (spatial_pred,
+            _mm256_add_epi16 (d, diff)), _mm256_sub_epi16 (d, diff));
+
+    if (is16) {
+      _mm256_storeu_si256 ((__m256i *) (dst + o), spatial_pred);
+    } else {
+      __m256i packed = _mm256_packus_epi16 (spatial_pred, spatial_pred);
+
+      packed = _mm256_permute4x64_epi64 (packed, 0xd8);
+      _mm_storeu_si128 ((__m128i *) (dst + o),
+          _mm256_castsi256_si128 (packed));
+    }
+#undef L
+#undef SCORE
+#undef PRED
+  }
+}
+
+AVX2_FUNC void
+yadif_filter_line_avx2 (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode)
+{
+  filter_line_avx2 (dst, prev, cur, next, w, prefs, mrefs, parity, mode, 0);
+}
+
+AVX2_FUNC void
+yadif_filter_line_16bit_avx2 (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode)
+{
+  filter_line_avx2 (dst, prev, cur, next, w, prefs, mrefs, parity, mode, 1);
+}
+
+#endif /* HAVE_YADIF_AVX2 */
+
+#ifdef HAVE_YADIF_NEON
+
+#include <arm_neon.h>
+
+static inline int16x8_t
+load_neon (const guint8 * p, int is16)
+{
+  if (is16)
+    return vreinterpretq_s16_u16 (vld1q_u16 ((const uint16_t *) p));
+
+  return vreinterpretq_s16_u16 (vmovl_u8 (vld1_u8 (p)));
+}
+
+static inline void
+filter_line_neon (void *dst1, const void *prev1, const void *cur1,
+    const void *next1, int w, int prefs, int mrefs, int parity, int mode,
+    int is16)
+{
+  const int size = is16 ? 2 : 1;
+  const guint8 *prev = prev1;
+  const guint8 *cur = cur1;
+  const guint8 *next = next1;
+  const guint8 *prev2 = parity ? prev : cur;
+  const guint8 *next2 = parity ? cur : next;
+  guint8 *dst = dst1;
+  int x;
+
+  for (x = 0; x < w; x += YADIF_NEON_STEP) {
+    const int o = x * size;
+#define L(p, refs) load_neon ((p) + o + (refs) * size, is16)
+#define SCORE(j) \
+    vaddq_s16 (vaddq_s16 ( \
+        vabdq_s16 (L (cur, mrefs - 1 + (j)), L (cur, prefs - 1 - (j))), \
+        vabdq_s16 (L (cur, mrefs + (j)), L (cur, prefs - (j)))), \
+        vabdq_s16 (L (cur, mrefs + 1 + (j)), L (cur, prefs + 1 - (j))))
+#define PRED(j) \
+    vshrq_n_s16 (vaddq_s16 (L (cur, mrefs + (j)), L (cur, prefs - (j))), 1)
+    int16x8_t c = L (cur, mrefs);
+    int16x8_t e = L (cur, prefs);
+    int16x8_t p2 = L (prev2, 0);
+    int16x8_t n2 = L (next2, 0);
+    int16x8_t d = vshrq_n_s16 (vaddq_s16 (p2, n2), 1);
+    int16x8_t temporal_diff0 = vabdq_s16 (p2, n2);
+    int16x8_t temporal_diff1 =
+        vshrq_n_s16 (vaddq_s16 (vabdq_s16 (L (prev, mrefs), c),
+            vabdq_s16 (L (prev, prefs), e)), 1);
+    int16x8_t temporal_diff2 =
+        vshrq_n_s16 (vaddq_s16 (vabdq_s16 (L (next, mrefs), c),
+            vabdq_s16 (L (next, prefs), e)), 1);
+    int16x8_t diff = vmaxq_s16 (vmaxq_s16 (vshrq_n_s16 (temporal_diff0, 1),
+            temporal_diff1), temporal_diff2);
+    int16x8_t spatial_pred = vshrq_n_s16 (vaddq_s16 (c, e), 1);
+    int16x8_t spatial_score, score;
+    uint16x8_t better;
+
+    spatial_score =
+        vsubq_s16 (vaddq_s16 (vaddq_s16 (vabdq_s16 (L (cur, mrefs - 1),
+                    L (cur, prefs - 1)), vabdq_s16 (c, e)),
+            vabdq_s16 (L (cur, mrefs + 1), L (cur, prefs + 1))),
+        vdupq_n_s16 (1));
+
+    /* The second direction only counts if the first one was better */
+    score = SCORE (-1);
+    better = vcgtq_s16 (spatial_score, score);
+    spatial_score = vbslq_s16 (better, score, spatial_score);
+    spatial_pred = vbslq_s16 (better, PRED (-1), spatial_pred);
+    score = SCORE (-2);
+    better = vandq_u16 (better, vcgtq_s16 (spatial_score, score));
+    spatial_score = vbslq_s16 (better, score, spatial_score);
+    spatial_pred = vbslq_s16 (better, PRED (-2), spatial_pred);
+
+    score = SCORE (1);
+    better = vcgtq_s16 (spatial_score, score);
+    spatial_score = vbslq_s16 (better, score, spatial_score);
+    spatial_pred = vbslq_s16 (better, PRED (1), spatial_pred);
+    score = SCORE (2);
+    better = vandq_u16 (better, vcgtq_s16 (spatial_score, score));
+    spatial_pred = vbslq_s16 (better, PRED (2), spatial_pred);
+
+    if (mode < 2) {
+      int16x8_t b = vshrq_n_s16 (vaddq_s16 (L (prev2, 2 * mrefs),
+              L (next2, 2 * mrefs)), 1);
+      int16x8_t f = vshrq_n_s16 (vaddq_s16 (L (prev2, 2 * prefs),
+              L (next2, 2 * prefs)), 1);
+      int16x8_t dc = vsubq_s16 (d, c);
+      int16x8_t de = vsubq_s16 (d, e);
+      int16x8_t bc = vsubq_s16 (b, c);
+      int16x8_t fe = vsubq_s16 (f, e);
+      int16x8_t max = vmaxq_s16 (vmaxq_s16 (de, dc), vminq_s16 (bc, fe));
+      int16x8_t min = vminq_s16 (vminq_s16 (de, dc), vmaxq_s16 (bc, fe));
+
+      diff = vmaxq_s16 (vmaxq_s16 (diff, min), vnegq_s16 (max));
+    }
+
+    /* diff is never negative, so this is the same as the C clipping */
+    spatial_pred = vmaxq_s16 (vminq_s16 (spatial_pred, vaddq_s16 (d, diff)),
+        vsubq_s16 (d, diff));
+
+    if (is16)
+      vst1q_u16 ((uint16_t *) (dst + o), vreinterpretq_u16_s16 (spatial_pred));
+    else
+      vst1_u8 (dst + o, vqmovun_s16 (spatial_pred));
+#undef L
+#undef SCORE
+#undef PRED
+  }
+}
+
+void
+yadif_filter_line_neon (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode)
+{
+  filter_line_neon (dst, prev, cur, next, w, prefs, mrefs, parity, mode, 0);
+}
+
+void
+yadif_filter_line_16bit_neon (void *dst, const void *prev, const void *cur,
+    const void *next, int w, int prefs, int mrefs, int parity, int mode)
+{
+  filter_line_neon (dst, prev, cur, next, w, prefs, mrefs, parity, mode, 1);
+}
+
+#endif /* HAVE_YADIF_NEON */
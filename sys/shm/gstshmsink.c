@@ -58,17 +58,23 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_USE_RING,
+  PROP_HIGH_WATER_MARK,
+  PROP_FRAGMENTATION
 };
 
 struct GstShmClient
 {
   ShmClient *client;
   GstPollFD pollfd;
+  /* signalled when the client acks through the ring */
+  GstPollFD notifypollfd;
 };
 
 #define DEFAULT_SIZE ( 64 * 1024 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_USE_RING (FALSE)
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -353,6 +359,7 @@ gst_shm_sink_init (GstShmSink * self)
   g_cond_init (&self->cond);
   self->size = DEFAULT_SIZE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
+  self->use_ring = DEFAULT_USE_RING;
   self->perms = DEFAULT_PERMS;
 
   gst_allocation_params_init (&self->params);
@@ -416,6 +423,26 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_USE_RING,
+      g_param_spec_boolean ("use-ring",
+          "Use shared memory rings",
+          "Pass buffers to new clients through a ring in shared memory instead "
+          "of the socket, needs a shmsrc that supports it (Linux only)",
+          DEFAULT_USE_RING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_HIGH_WATER_MARK,
+      g_param_spec_uint64 ("high-water-mark",
+          "High water mark of the shm area",
+          "Most bytes of the shared memory area that were in use at once",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FRAGMENTATION,
+      g_param_spec_double ("fragmentation",
+          "Fragmentation of the shm area",
+          "Part of the free space of the shared memory area that is not in "
+          "the largest free block (0 = not fragmented)",
+          0.0, 1.0, 0.0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL,
       g_cclosure_marshal_VOID__INT, G_TYPE_NONE, 1, G_TYPE_INT);
@@ -504,6 +531,13 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (&self->cond);
       break;
+    case PROP_USE_RING:
+      GST_OBJECT_LOCK (object);
+      self->use_ring = g_value_get_boolean (value);
+      if (self->pipe && sp_writer_set_ring (self->pipe, self->use_ring) < 0)
+        GST_WARNING_OBJECT (object, "Shared memory rings are not supported");
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       break;
   }
@@ -533,6 +567,29 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_USE_RING:
+      g_value_set_boolean (value, self->use_ring);
+      break;
+    case PROP_HIGH_WATER_MARK:
+    case PROP_FRAGMENTATION:
+    {
+      size_t used = 0, high_water_mark = 0, largest_free = 0;
+      gdouble fragmentation = 0.0;
+
+      if (self->pipe && sp_writer_get_alloc_stats (self->pipe, &used,
+              &high_water_mark, &largest_free) == 0) {
+        size_t free_size = sp_writer_get_max_buf_size (self->pipe) - used;
+
+        if (free_size > 0)
+          fragmentation = 1.0 - (gdouble) largest_free / free_size;
+      }
+
+      if (prop_id == PROP_HIGH_WATER_MARK)
+        g_value_set_uint64 (value, high_water_mark);
+      else
+        g_value_set_double (value, CLAMP (fragmentation, 0.0, 1.0));
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -569,6 +626,9 @@ gst_shm_sink_start (GstBaseSink * bsink)
   }
 
   sp_set_data (self->pipe, self);
+  if (self->use_ring && sp_writer_set_ring (self->pipe, TRUE) < 0)
+    GST_WARNING_OBJECT (self, "Shared memory rings are not supported, "
+        "using the socket");
   g_free (self->socket_path);
   self->socket_path = g_strdup (sp_writer_get_path (self->pipe));
 
@@ -875,6 +935,12 @@ pollthread_func (gpointer data)
       gclient->pollfd.fd = sp_writer_get_client_fd (client);
       gst_poll_add_fd (self->poll, &gclient->pollfd);
       gst_poll_fd_ctl_read (self->poll, &gclient->pollfd, TRUE);
+      gst_poll_fd_init (&gclient->notifypollfd);
+      gclient->notifypollfd.fd = sp_writer_get_client_notify_fd (client);
+      if (gclient->notifypollfd.fd >= 0) {
+        gst_poll_add_fd (self->poll, &gclient->notifypollfd);
+        gst_poll_fd_ctl_read (self->poll, &gclient->notifypollfd, TRUE);
+      }
       self->clients = g_list_prepend (self->clients, gclient);
       g_signal_emit (self, signals[SIGNAL_CLIENT_CONNECTED], 0,
           gclient->pollfd.fd);
@@ -919,6 +985,29 @@ pollthread_func (gpointer data)
         if (rv == 0)
           gst_buffer_unref (tag);
       }
+
+      /* Everything that is in the ring, the client only signals the
+       * eventfd once we found it empty */
+      while (gclient->notifypollfd.fd >= 0) {
+        int rv;
+        gpointer tag = NULL;
+
+        GST_OBJECT_LOCK (self);
+        rv = sp_writer_recv_ring (self->pipe, gclient->client, &tag);
+        GST_OBJECT_UNLOCK (self);
+
+        if (rv == -1)
+          break;
+
+        if (rv < 0) {
+          GST_WARNING_OBJECT (self, "One client acked an unknown buffer,"
+              " closing (retval: %d)", rv);
+          goto close_client;
+        }
+
+        if (rv == 0)
+          gst_buffer_unref (tag);
+      }
       continue;
     close_client:
       {
@@ -931,6 +1020,8 @@ pollthread_func (gpointer data)
       }
 
       gst_poll_remove_fd (self->poll, &gclient->pollfd);
+      if (gclient->notifypollfd.fd >= 0)
+        gst_poll_remove_fd (self->poll, &gclient->notifypollfd);
       self->clients = g_list_remove (self->clients, gclient);
 
       g_signal_emit (self, signals[SIGNAL_CLIENT_DISCONNECTED], 0,
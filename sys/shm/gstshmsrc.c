@@ -155,6 +155,7 @@ gst_shm_src_init (GstShmSrc * self)
 {
   self->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&self->pollfd);
+  gst_poll_fd_init (&self->notifyfd);
 }
 
 static void
@@ -275,9 +276,12 @@ gst_shm_src_stop_reading (GstShmSrc * self)
     self->pipe = NULL;
 
     gst_poll_remove_fd (self->poll, &self->pollfd);
+    if (self->notifyfd.fd >= 0)
+      gst_poll_remove_fd (self->poll, &self->notifyfd);
   }
 
   gst_poll_fd_init (&self->pollfd);
+  gst_poll_fd_init (&self->notifyfd);
   gst_poll_set_flushing (self->poll, TRUE);
 }
 
@@ -327,6 +331,20 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   struct GstShmBuffer *gsb;
 
   do {
+    /* Buffers from the ring don't need the socket */
+    if (self->notifyfd.fd >= 0) {
+      GST_OBJECT_LOCK (self);
+      rv = sp_client_recv_ring (self->pipe->pipe, &buf);
+      GST_OBJECT_UNLOCK (self);
+      if (rv < -1) {
+        GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
+            ("Error reading from ring: %d", rv));
+        return GST_FLOW_ERROR;
+      }
+      if (buf)
+        break;
+    }
+
     if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
       if (errno == EBUSY)
         return GST_FLOW_FLUSHING;
@@ -361,6 +379,13 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
             ("Error reading control data: %d", rv));
         return GST_FLOW_ERROR;
       }
+
+      if (self->notifyfd.fd < 0 && sp_get_notify_fd (self->pipe->pipe) >= 0) {
+        GST_DEBUG_OBJECT (self, "Receiving buffers through the ring");
+        self->notifyfd.fd = sp_get_notify_fd (self->pipe->pipe);
+        gst_poll_add_fd (self->poll, &self->notifyfd);
+        gst_poll_fd_ctl_read (self->poll, &self->notifyfd, TRUE);
+      }
     }
   } while (buf == NULL);
 
@@ -52,6 +52,8 @@ struct _GstShmSrc
   GstShmPipe *pipe;
   GstPoll *poll;
   GstPollFD pollfd;
+  /* signalled by the writer when the ring has buffers again */
+  GstPollFD notifyfd;
 
 
   GstFlowReturn flow_return;
@@ -33,14 +33,54 @@
 #include <string.h>
 #include <assert.h>
 
+/*
+ * The space is cut into blocks that are multiples of a granule. Free blocks
+ * are kept in segregated lists by size class (two-level segregated fit): the
+ * first level is the power of two of the size, the second level splits that
+ * range into SL_COUNT classes. Finding a free block that is big enough, and
+ * merging a freed block with its free neighbours, takes constant time.
+ */
+#define GRANULE_SHIFT 9
+#define GRANULE_SIZE (1UL << GRANULE_SHIFT)
+/* Only the last block of a space can end in a partial granule, it takes
+ * the granule in the space but is filed by the full granules it holds */
+#define BLOCK_GRANULES(b) (((b)->size + GRANULE_SIZE - 1) >> GRANULE_SHIFT)
+#define BLOCK_FULL_GRANULES(b) ((b)->size >> GRANULE_SHIFT)
+
+#define SL_LOG2 4
+#define SL_COUNT (1 << SL_LOG2)
+#define FL_COUNT 32
+
+/* Allocated blocks are also recorded for every page they cover the start of,
+ * so finding the block of an offset never scans more than a page */
+#define PAGE_SHIFT 16
+
 /* This is the allocated space to hold multiple blocks */
 struct _ShmAllocSpace
 {
   /* The total size of this space */
   size_t size;
 
-  /* chained list of the blocks contained in this space */
-  ShmAllocBlock *blocks;
+  /* The number of granules and pages in this space */
+  unsigned long n_granules;
+  unsigned long n_pages;
+
+  /* The block starting at each granule, free or allocated */
+  ShmAllocBlock **starts;
+  /* The allocated block covering the start of each page */
+  ShmAllocBlock **pages;
+  /* The block at the end of the space */
+  ShmAllocBlock *last;
+
+  /* Free lists by size class, with bitmaps of the non-empty ones */
+  unsigned int fl_bitmap;
+  unsigned int sl_bitmap[FL_COUNT];
+  ShmAllocBlock *free_lists[FL_COUNT][SL_COUNT];
+
+  /* Statistics */
+  unsigned long used;
+  unsigned long high_water_mark;
+  unsigned int n_blocks;
 };
 
 /* A single block of data */
@@ -56,19 +96,156 @@ struct _ShmAllocBlock
   /* The size of the block */
   unsigned long size;
 
-  /* Pointer to the next block in the chain */
-  ShmAllocBlock *next;
+  int is_free;
+  /* The block right before this one in the space */
+  ShmAllocBlock *prev_phys;
+  /* The free list of the size class of this block */
+  ShmAllocBlock *prev_free;
+  ShmAllocBlock *next_free;
 };
 
+static int
+find_last_set (unsigned long word)
+{
+  int bit = -1;
+
+  while (word) {
+    word >>= 1;
+    bit++;
+  }
+
+  return bit;
+}
+
+static int
+find_first_set (unsigned int word)
+{
+#if defined(__GNUC__)
+  return word ? __builtin_ctz (word) : -1;
+#else
+  int bit = 0;
+
+  if (!word)
+    return -1;
+  while (!(word & 1)) {
+    word >>= 1;
+    bit++;
+  }
+
+  return bit;
+#endif
+}
+
+/* The size class a free block of n granules is kept in */
+static void
+mapping_insert (unsigned long n, int *fl, int *sl)
+{
+  if (n < SL_COUNT) {
+    *fl = 0;
+    *sl = n;
+  } else {
+    int t = find_last_set (n);
+    *sl = (n >> (t - SL_LOG2)) ^ SL_COUNT;
+    *fl = t - (SL_LOG2 - 1);
+  }
+}
+
+/* The first size class whose blocks all hold at least n granules */
+static void
+mapping_search (unsigned long n, int *fl, int *sl)
+{
+  if (n >= SL_COUNT)
+    n += (1UL << (find_last_set (n) - SL_LOG2)) - 1;
+  mapping_insert (n, fl, sl);
+}
+
+static void
+free_list_insert (ShmAllocSpace * self, ShmAllocBlock * block)
+{
+  int fl, sl;
+
+  mapping_insert (BLOCK_FULL_GRANULES (block), &fl, &sl);
+
+  block->is_free = 1;
+  block->prev_free = NULL;
+  block->next_free = self->free_lists[fl][sl];
+  if (block->next_free)
+    block->next_free->prev_free = block;
+  self->free_lists[fl][sl] = block;
+
+  self->fl_bitmap |= 1U << fl;
+  self->sl_bitmap[fl] |= 1U << sl;
+}
+
+static void
+free_list_remove (ShmAllocSpace * self, ShmAllocBlock * block)
+{
+  int fl, sl;
+
+  mapping_insert (BLOCK_FULL_GRANULES (block), &fl, &sl);
+
+  if (block->prev_free)
+    block->prev_free->next_free = block->next_free;
+  else
+    self->free_lists[fl][sl] = block->next_free;
+  if (block->next_free)
+    block->next_free->prev_free = block->prev_free;
+
+  if (!self->free_lists[fl][sl]) {
+    self->sl_bitmap[fl] &= ~(1U << sl);
+    if (!self->sl_bitmap[fl])
+      self->fl_bitmap &= ~(1U << fl);
+  }
+
+  block->is_free = 0;
+  block->prev_free = block->next_free = NULL;
+}
+
+static ShmAllocBlock *
+next_phys (ShmAllocBlock * block)
+{
+  ShmAllocSpace *self = block->space;
+  unsigned long end = (block->offset >> GRANULE_SHIFT) + BLOCK_GRANULES (block);
+
+  return end < self->n_granules ? self->starts[end] : NULL;
+}
+
+/* Record an allocated block (or clear it with NULL) in the page map */
+static void
+set_pages (ShmAllocSpace * self, ShmAllocBlock * block, unsigned long offset,
+    unsigned long size)
+{
+  unsigned long page = (offset + (1UL << PAGE_SHIFT) - 1) >> PAGE_SHIFT;
+
+  for (; page < self->n_pages && (page << PAGE_SHIFT) < offset + size; page++)
+    self->pages[page] = block;
+}
 
 ShmAllocSpace *
 shm_alloc_space_new (size_t size)
 {
   ShmAllocSpace *self = spalloc_new (ShmAllocSpace);
+  ShmAllocBlock *block;
 
   memset (self, 0, sizeof (ShmAllocSpace));
 
   self->size = size;
+  self->n_granules = (size + GRANULE_SIZE - 1) >> GRANULE_SHIFT;
+  self->n_pages = (size >> PAGE_SHIFT) + 1;
+
+  self->starts = calloc (self->n_granules + 1, sizeof (ShmAllocBlock *));
+  self->pages = calloc (self->n_pages, sizeof (ShmAllocBlock *));
+
+  if (self->n_granules > 0) {
+    block = spalloc_new (ShmAllocBlock);
+    memset (block, 0, sizeof (ShmAllocBlock));
+    block->space = self;
+    block->offset = 0;
+    block->size = size;
+    self->starts[0] = block;
+    self->last = block;
+    free_list_insert (self, block);
+  }
 
   return self;
 }
@@ -76,7 +253,14 @@ shm_alloc_space_new (size_t size)
 void
 shm_alloc_space_free (ShmAllocSpace * self)
 {
-  assert (self && self->blocks == NULL);
+  assert (self && self->n_blocks == 0);
+
+  if (self->starts[0]) {
+    assert (self->starts[0]->is_free);
+    spalloc_free (ShmAllocBlock, self->starts[0]);
+  }
+  free (self->starts);
+  free (self->pages);
   spalloc_free (ShmAllocSpace, self);
 }
 
@@ -84,43 +268,75 @@ shm_alloc_space_free (ShmAllocSpace * self)
 ShmAllocBlock *
 shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
 {
-  ShmAllocBlock *block;
-  ShmAllocBlock *item = NULL;
-  ShmAllocBlock *prev_item = NULL;
-  unsigned long prev_end_offset = 0;
-
-
-  for (item = self->blocks; item; item = item->next) {
-    unsigned long max_size = 0;
+  ShmAllocBlock *block, *rest, *next;
+  unsigned long n;
+  unsigned int sl_map, fl_map;
+  int fl, sl;
+
+  n = (size + GRANULE_SIZE - 1) >> GRANULE_SHIFT;
+  if (n == 0)
+    n = 1;
+  if (size > self->size)
+    return NULL;
 
-    max_size = item->offset - prev_end_offset;
+  /* Find the first non-empty size class that fits n granules */
+  mapping_search (n, &fl, &sl);
+  if (fl >= FL_COUNT)
+    return NULL;
+  sl_map = self->sl_bitmap[fl] & (~0U << sl);
+  if (!sl_map) {
+    fl_map = fl + 1 < FL_COUNT ? self->fl_bitmap & (~0U << (fl + 1)) : 0;
+    fl = find_first_set (fl_map);
+    sl_map = fl_map ? self->sl_bitmap[fl] : 0;
+  }
 
-    if (max_size >= size)
-      break;
+  if (sl_map) {
+    sl = find_first_set (sl_map);
+    block = self->free_lists[fl][sl];
+    assert (block && BLOCK_FULL_GRANULES (block) >= n);
+  } else {
+    /* The class n is filed in can still hold a block that is big enough,
+     * like one of exactly n granules */
+    mapping_insert (n, &fl, &sl);
+    for (block = self->free_lists[fl][sl]; block; block = block->next_free) {
+      if (BLOCK_FULL_GRANULES (block) >= n)
+        break;
+    }
 
-    prev_end_offset = item->offset + item->size;
-    prev_item = item;
+    /* The partial granule at the end is only counted in the last block */
+    if (!block) {
+      block = self->last;
+      if (!block || !block->is_free || block->size < size)
+        return NULL;
+    }
+  }
+  free_list_remove (self, block);
+
+  /* Give back what isn't needed */
+  if (BLOCK_GRANULES (block) > n) {
+    rest = spalloc_new (ShmAllocBlock);
+    memset (rest, 0, sizeof (ShmAllocBlock));
+    rest->space = self;
+    rest->offset = block->offset + (n << GRANULE_SHIFT);
+    rest->size = block->size - (n << GRANULE_SHIFT);
+    rest->prev_phys = block;
+    next = next_phys (block);
+    if (next)
+      next->prev_phys = rest;
+    else
+      self->last = rest;
+    block->size = n << GRANULE_SHIFT;
+    self->starts[rest->offset >> GRANULE_SHIFT] = rest;
+    free_list_insert (self, rest);
   }
 
-  /* Return NULL if there is no big enough space, otherwise, there is space
-   * at the end */
-  assert (prev_end_offset <= self->size);
-  if (!item && self->size - prev_end_offset < size)
-    return NULL;
-
-  block = spalloc_new (ShmAllocBlock);
-  memset (block, 0, sizeof (ShmAllocBlock));
-  block->offset = prev_end_offset;
-  block->size = size;
   block->use_count = 1;
-  block->space = self;
-
-  if (prev_item)
-    prev_item->next = block;
-  else
-    self->blocks = block;
+  set_pages (self, block, block->offset, block->size);
 
-  block->next = item;
+  self->used += block->size;
+  if (self->used > self->high_water_mark)
+    self->high_water_mark = self->used;
+  self->n_blocks++;
 
   return block;
 }
@@ -131,35 +347,72 @@ shm_alloc_space_alloc_block_get_offset (ShmAllocBlock * block)
   return block->offset;
 }
 
+/* Merge @block into @prev, both are free and out of the free lists */
+static void
+merge_blocks (ShmAllocBlock * prev, ShmAllocBlock * block)
+{
+  ShmAllocSpace *self = block->space;
+  ShmAllocBlock *next = next_phys (block);
+
+  if (next)
+    next->prev_phys = prev;
+  else
+    self->last = prev;
+  prev->size += block->size;
+  self->starts[block->offset >> GRANULE_SHIFT] = NULL;
+  spalloc_free (ShmAllocBlock, block);
+}
+
 static void
 shm_alloc_space_free_block (ShmAllocBlock * block)
 {
-  ShmAllocBlock *item = NULL;
-  ShmAllocBlock *prev_item = NULL;
   ShmAllocSpace *self = block->space;
+  ShmAllocBlock *prev, *next;
 
-  for (item = self->blocks; item; item = item->next) {
-    if (item == block) {
-      if (prev_item)
-        prev_item->next = item->next;
-      else
-        self->blocks = item->next;
-      break;
-    }
-    prev_item = item;
+  set_pages (self, NULL, block->offset, block->size);
+  self->used -= block->size;
+  self->n_blocks--;
+
+  next = next_phys (block);
+  if (next && next->is_free) {
+    free_list_remove (self, next);
+    merge_blocks (block, next);
   }
 
-  spalloc_free (ShmAllocBlock, block);
+  prev = block->prev_phys;
+  if (prev && prev->is_free) {
+    free_list_remove (self, prev);
+    merge_blocks (prev, block);
+    block = prev;
+  }
+
+  free_list_insert (self, block);
 }
 
 ShmAllocBlock *
 shm_alloc_space_block_get (ShmAllocSpace * self, unsigned long offset)
 {
-  ShmAllocBlock *block = NULL;
+  ShmAllocBlock *block;
+  unsigned long granule, first;
+
+  if (offset >= self->size)
+    return NULL;
 
-  for (block = self->blocks; block; block = block->next) {
-    if (block->offset <= offset && (block->offset + block->size) > offset)
-      return block;
+  /* A block that started before the page covers its start */
+  block = self->pages[offset >> PAGE_SHIFT];
+  if (block && offset < block->offset + block->size)
+    return block;
+
+  /* Otherwise it starts in the same page */
+  granule = offset >> GRANULE_SHIFT;
+  first = (offset >> PAGE_SHIFT) << (PAGE_SHIFT - GRANULE_SHIFT);
+  for (;; granule--) {
+    block = self->starts[granule];
+    if (block)
+      return !block->is_free && offset < block->offset + block->size ?
+          block : NULL;
+    if (granule == first)
+      break;
   }
 
   return NULL;
@@ -180,3 +433,26 @@ shm_alloc_space_block_dec (ShmAllocBlock * block)
   if (block->use_count <= 0)
     shm_alloc_space_free_block (block);
 }
+
+void
+shm_alloc_space_get_stats (ShmAllocSpace * self, ShmAllocStats * stats)
+{
+  ShmAllocBlock *block;
+  int fl, sl;
+
+  stats->size = self->size;
+  stats->used = self->used;
+  stats->high_water_mark = self->high_water_mark;
+  stats->n_blocks = self->n_blocks;
+  stats->largest_free = 0;
+
+  /* The biggest free block is in the highest non-empty size class */
+  if (self->fl_bitmap) {
+    fl = find_last_set (self->fl_bitmap);
+    sl = find_last_set (self->sl_bitmap[fl]);
+    for (block = self->free_lists[fl][sl]; block; block = block->next_free) {
+      if (block->size > stats->largest_free)
+        stats->largest_free = block->size;
+    }
+  }
+}
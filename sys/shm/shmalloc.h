@@ -53,6 +53,17 @@ extern "C" {
 typedef struct _ShmAllocSpace ShmAllocSpace;
 typedef struct _ShmAllocBlock ShmAllocBlock;
 
+typedef struct
+{
+  size_t size;
+  unsigned long used;
+  /* Most bytes ever allocated at once */
+  unsigned long high_water_mark;
+  /* The biggest block that can currently be allocated */
+  unsigned long largest_free;
+  unsigned int n_blocks;
+} ShmAllocStats;
+
 ShmAllocSpace *shm_alloc_space_new (size_t size);
 void shm_alloc_space_free (ShmAllocSpace * self);
 
@@ -66,6 +77,8 @@ void shm_alloc_space_block_dec (ShmAllocBlock * block);
 ShmAllocBlock * shm_alloc_space_block_get (ShmAllocSpace * space,
     unsigned long offset);
 
+void shm_alloc_space_get_stats (ShmAllocSpace * self, ShmAllocStats * stats);
+
 
 #ifdef __cplusplus
 }
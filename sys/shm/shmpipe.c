@@ -35,6 +35,10 @@
 
 #include "shmpipe.h"
 
+#ifdef SHM_PIPE_HAVE_RING
+#include <sys/eventfd.h>
+#endif
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -67,9 +71,23 @@
  * type 4: ack buffer
  * offset
  *
+ * type 5: new ring
+ * Ring area length
+ * Passes the ring area and two eventfds as SCM_RIGHTS
+ *
  * Type 4 goes from the client to the server
  * The rest are from the server to the client
  * The client should never write in the SHM
+ *
+ * When the writer has rings enabled, every client gets its own small shared
+ * area with two single producer, single consumer rings after type 5: one
+ * with the buffers for the client and one with the acks going back. The
+ * consumer of a ring sets its waiting flag before it goes to sleep, the
+ * producer only signals the eventfd of the ring when it sees that flag, so
+ * a busy peer doesn't cost any syscalls. Buffers are then no longer sent
+ * over the socket, the close of an area also goes through the ring to keep
+ * it ordered with the buffers of that area. The socket is kept for new
+ * areas and to notice when the peer is gone.
  */
 
 
@@ -80,9 +98,54 @@ enum
   COMMAND_NEW_SHM_AREA = 1,
   COMMAND_CLOSE_SHM_AREA = 2,
   COMMAND_NEW_BUFFER = 3,
-  COMMAND_ACK_BUFFER = 4
+  COMMAND_ACK_BUFFER = 4,
+  COMMAND_NEW_RING = 5
 };
 
+#ifdef SHM_PIPE_HAVE_RING
+
+#define SHM_RING_SLOTS 1024
+
+enum
+{
+  RING_SLOT_BUFFER = 1,
+  RING_SLOT_CLOSE_SHM_AREA = 2
+};
+
+typedef struct
+{
+  uint32_t type;
+  int32_t area_id;
+  uint64_t offset;
+  uint64_t size;
+} ShmRingSlot;
+
+/* head and tail/waiting are in different cache lines, they are written
+ * from different processes */
+typedef struct
+{
+  /* Written by the producer */
+  uint32_t head;
+  char pad0[60];
+  /* Written by the consumer */
+  uint32_t tail;
+  uint32_t waiting;
+  char pad1[56];
+  ShmRingSlot slots[SHM_RING_SLOTS];
+} ShmRingQueue;
+
+typedef struct
+{
+  /* From the writer to the client */
+  ShmRingQueue buffers;
+  /* From the client to the writer */
+  ShmRingQueue acks;
+} ShmRingArea;
+
+#endif
+
+typedef struct _ShmRing ShmRing;
+
 typedef struct _ShmArea ShmArea;
 
 struct _ShmArea
@@ -141,15 +204,33 @@ struct _ShmPipe
   ShmClient *clients;
 
   mode_t perms;
+
+  /* Writer: give rings to new clients, client: the ring from the writer */
+  int use_ring;
+  ShmRing *ring;
 };
 
 struct _ShmClient
 {
   int fd;
 
+  ShmRing *ring;
+
   ShmClient *next;
 };
 
+struct _ShmRing
+{
+#ifdef SHM_PIPE_HAVE_RING
+  ShmRingArea *area;
+#endif
+  int shm_fd;
+  /* Signalled when there is something in the buffers ring */
+  int buffers_fd;
+  /* Signalled when there is something in the acks ring */
+  int acks_fd;
+};
+
 struct _ShmBlock
 {
   ShmPipe *pipe;
@@ -179,6 +260,10 @@ struct CommandBuffer
     {
       unsigned long offset;
     } ack_buffer;
+    struct
+    {
+      size_t size;
+    } new_ring;
   } payload;
 };
 
@@ -187,6 +272,11 @@ static void sp_close_shm (ShmArea * area);
 static int sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf,
     ShmBuffer * prev_buf, ShmClient * client, void **tag);
 static void sp_shm_area_dec (ShmPipe * self, ShmArea * area);
+static void sp_ring_free (ShmRing * ring);
+#ifdef SHM_PIPE_HAVE_RING
+static int sp_ring_push (ShmRingQueue * queue, int notify_fd,
+    const ShmRingSlot * slot);
+#endif
 
 
 
@@ -452,6 +542,11 @@ sp_writer_close (ShmPipe * self, sp_buffer_free_callback callback,
 void
 sp_client_close (ShmPipe * self)
 {
+  if (self->ring) {
+    sp_ring_free (self->ring);
+    self->ring = NULL;
+  }
+
   sp_writer_close (self, NULL, NULL);
 }
 
@@ -511,6 +606,16 @@ sp_writer_resize (ShmPipe * self, size_t size)
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
 
+#ifdef SHM_PIPE_HAVE_RING
+    if (client->ring) {
+      ShmRingSlot slot = { RING_SLOT_CLOSE_SHM_AREA, old_current->id, 0, 0 };
+
+      /* Ordered after the buffers of the old area, if the ring is full the
+       * client just keeps the old area mapped until it disconnects */
+      sp_ring_push (&client->ring->area->buffers, client->ring->buffers_fd,
+          &slot);
+    } else
+#endif
     if (!send_command (client->fd, &cb, COMMAND_CLOSE_SHM_AREA,
             old_current->id))
       continue;
@@ -615,6 +720,21 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
 
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
+
+#ifdef SHM_PIPE_HAVE_RING
+    if (client->ring) {
+      ShmRingSlot slot = { RING_SLOT_BUFFER, area->id, offset, bsize };
+
+      /* A client that is a whole ring behind doesn't get this buffer */
+      if (!sp_ring_push (&client->ring->area->buffers,
+              client->ring->buffers_fd, &slot))
+        continue;
+      sb->clients[i++] = client->fd;
+      c++;
+      continue;
+    }
+#endif
+
     cb.payload.buffer.offset = offset;
     cb.payload.buffer.size = bsize;
     if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, self->shm_area->id))
@@ -652,6 +772,240 @@ recv_command (int fd, struct CommandBuffer *cb)
   }
 }
 
+#ifdef SHM_PIPE_HAVE_RING
+
+#define RING_N_FDS 3
+
+/* Like recv_command() but also receives the fds passed along */
+static int
+recv_command_with_fds (int fd, struct CommandBuffer *cb, int *fds)
+{
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int) * RING_N_FDS)];
+  } control;
+  struct iovec iov;
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+  int n_fds = 0;
+  int retval;
+  int i;
+
+  for (i = 0; i < RING_N_FDS; i++)
+    fds[i] = -1;
+
+  memset (&msg, 0, sizeof (msg));
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  retval = recvmsg (fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+  if (retval < 0)
+    msg.msg_controllen = 0;
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      int *cfds = (int *) CMSG_DATA (cmsg);
+      int n = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+
+      for (i = 0; i < n; i++) {
+        if (n_fds < RING_N_FDS)
+          fds[n_fds++] = cfds[i];
+        else
+          close (cfds[i]);
+      }
+    }
+  }
+
+  if (retval != sizeof (struct CommandBuffer) || cb->type != COMMAND_NEW_RING
+      || n_fds != RING_N_FDS) {
+    for (i = 0; i < n_fds; i++)
+      close (fds[i]);
+    for (i = 0; i < RING_N_FDS; i++)
+      fds[i] = -1;
+  }
+
+  return retval == sizeof (struct CommandBuffer);
+}
+
+static int
+send_command_with_fds (int fd, struct CommandBuffer *cb,
+    unsigned short int type, int area_id, const int *fds)
+{
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int) * RING_N_FDS)];
+  } control;
+  struct iovec iov;
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+
+  cb->type = type;
+  cb->area_id = area_id;
+
+  memset (&msg, 0, sizeof (msg));
+  memset (&control, 0, sizeof (control));
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int) * RING_N_FDS);
+  memcpy (CMSG_DATA (cmsg), fds, sizeof (int) * RING_N_FDS);
+
+  if (sendmsg (fd, &msg, MSG_NOSIGNAL) != sizeof (struct CommandBuffer))
+    return 0;
+
+  return 1;
+}
+
+static int
+sp_ring_push (ShmRingQueue * queue, int notify_fd, const ShmRingSlot * slot)
+{
+  uint32_t head = queue->head;
+  uint32_t tail = __atomic_load_n (&queue->tail, __ATOMIC_ACQUIRE);
+
+  if (head - tail >= SHM_RING_SLOTS)
+    return 0;
+
+  queue->slots[head % SHM_RING_SLOTS] = *slot;
+  __atomic_store_n (&queue->head, head + 1, __ATOMIC_RELEASE);
+
+  /* Pairs with the fence in sp_ring_peek(): either the consumer sees the
+   * new head or we see that it is waiting */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (__atomic_load_n (&queue->waiting, __ATOMIC_RELAXED) &&
+      __atomic_exchange_n (&queue->waiting, 0, __ATOMIC_ACQ_REL)) {
+    uint64_t one = 1;
+    ssize_t written;
+
+    /* Can only fail if the counter overflows, it's woken up anyway then */
+    written = write (notify_fd, &one, sizeof (one));
+    (void) written;
+  }
+
+  return 1;
+}
+
+/* Returns 1 and the next slot, without consuming it, or 0 when the ring is
+ * empty and the producer will signal @notify_fd for the next one */
+static int
+sp_ring_peek (ShmRingQueue * queue, int notify_fd, ShmRingSlot * slot)
+{
+  uint32_t tail = queue->tail;
+
+  if (__atomic_load_n (&queue->head, __ATOMIC_ACQUIRE) == tail) {
+    uint64_t count;
+
+    /* Clear an old wakeup before asking for a new one */
+    if (read (notify_fd, &count, sizeof (count)) < 0 && errno != EAGAIN)
+      return 0;
+
+    __atomic_store_n (&queue->waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+    if (__atomic_load_n (&queue->head, __ATOMIC_ACQUIRE) == tail)
+      return 0;
+    __atomic_store_n (&queue->waiting, 0, __ATOMIC_RELAXED);
+  }
+
+  *slot = queue->slots[tail % SHM_RING_SLOTS];
+
+  return 1;
+}
+
+static void
+sp_ring_advance (ShmRingQueue * queue)
+{
+  __atomic_store_n (&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+}
+
+static ShmRing *
+sp_ring_new (int shm_fd, int buffers_fd, int acks_fd)
+{
+  ShmRing *ring = spalloc_new (ShmRing);
+
+  ring->shm_fd = shm_fd;
+  ring->buffers_fd = buffers_fd;
+  ring->acks_fd = acks_fd;
+  ring->area = mmap (NULL, sizeof (ShmRingArea), PROT_READ | PROT_WRITE,
+      MAP_SHARED, shm_fd, 0);
+
+  if (ring->area == MAP_FAILED) {
+    ring->area = NULL;
+    sp_ring_free (ring);
+    return NULL;
+  }
+
+  return ring;
+}
+
+/* Creates the ring of a new client, the shm object is unlinked right away
+ * and only passed around as fd */
+static ShmRing *
+sp_writer_ring_create (ShmPipe * self)
+{
+  char tmppath[32];
+  int shm_fd, buffers_fd, acks_fd;
+  int i = 0;
+
+  do {
+    snprintf (tmppath, sizeof (tmppath), "/shmring.%5d.%5d", getpid (), i++);
+    shm_fd = shm_open (tmppath, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+        self->perms);
+  } while (shm_fd < 0 && errno == EEXIST);
+
+  if (shm_fd < 0)
+    return NULL;
+
+  shm_unlink (tmppath);
+
+  if (ftruncate (shm_fd, sizeof (ShmRingArea))) {
+    close (shm_fd);
+    return NULL;
+  }
+
+  buffers_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  acks_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (buffers_fd < 0 || acks_fd < 0) {
+    if (buffers_fd >= 0)
+      close (buffers_fd);
+    if (acks_fd >= 0)
+      close (acks_fd);
+    close (shm_fd);
+    return NULL;
+  }
+
+  return sp_ring_new (shm_fd, buffers_fd, acks_fd);
+}
+
+#endif
+
+static void
+sp_ring_free (ShmRing * ring)
+{
+#ifdef SHM_PIPE_HAVE_RING
+  if (ring->area)
+    munmap (ring->area, sizeof (ShmRingArea));
+#endif
+  if (ring->shm_fd >= 0)
+    close (ring->shm_fd);
+  if (ring->buffers_fd >= 0)
+    close (ring->buffers_fd);
+  if (ring->acks_fd >= 0)
+    close (ring->acks_fd);
+  spalloc_free (ShmRing, ring);
+}
+
 long int
 sp_client_recv (ShmPipe * self, char **buf)
 {
@@ -660,11 +1014,34 @@ sp_client_recv (ShmPipe * self, char **buf)
   ShmArea *area;
   struct CommandBuffer cb;
   int retval;
+#ifdef SHM_PIPE_HAVE_RING
+  int fds[RING_N_FDS];
 
+  if (!recv_command_with_fds (self->main_socket, &cb, fds))
+    return -1;
+#else
   if (!recv_command (self->main_socket, &cb))
     return -1;
+#endif
 
   switch (cb.type) {
+#ifdef SHM_PIPE_HAVE_RING
+    case COMMAND_NEW_RING:
+      if (fds[0] < 0 || self->ring ||
+          cb.payload.new_ring.size != sizeof (ShmRingArea)) {
+        int i;
+
+        for (i = 0; i < RING_N_FDS; i++)
+          if (fds[i] >= 0)
+            close (fds[i]);
+        return -5;
+      }
+      self->ring = sp_ring_new (fds[0], fds[1], fds[2]);
+      if (!self->ring)
+        return -5;
+      break;
+#endif
+
     case COMMAND_NEW_SHM_AREA:
       assert (cb.payload.new_shm_area.path_size > 0);
       assert (cb.payload.new_shm_area.size > 0);
@@ -761,6 +1138,18 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
 
   offset = buf - shm_area->shm_area_buf;
 
+#ifdef SHM_PIPE_HAVE_RING
+  if (self->ring) {
+    ShmRingSlot slot = { RING_SLOT_BUFFER, shm_area->id, offset, 0 };
+
+    /* Acks can come in any order, if the ring is full use the socket */
+    if (sp_ring_push (&self->ring->area->acks, self->ring->acks_fd, &slot)) {
+      sp_shm_area_dec (self, shm_area);
+      return 1;
+    }
+  }
+#endif
+
   sp_shm_area_dec (self, shm_area);
 
   cb.payload.ack_buffer.offset = offset;
@@ -836,6 +1225,31 @@ sp_writer_accept_client (ShmPipe * self)
 
   client = spalloc_new (ShmClient);
   client->fd = fd;
+  client->ring = NULL;
+
+#ifdef SHM_PIPE_HAVE_RING
+  if (self->use_ring) {
+    client->ring = sp_writer_ring_create (self);
+
+    if (client->ring) {
+      int fds[RING_N_FDS] = { client->ring->shm_fd, client->ring->buffers_fd,
+        client->ring->acks_fd
+      };
+
+      memset (&cb, 0, sizeof (cb));
+      cb.payload.new_ring.size = sizeof (ShmRingArea);
+      if (!send_command_with_fds (fd, &cb, COMMAND_NEW_RING, 0, fds)) {
+        fprintf (stderr, "Sending new ring failed: %s", strerror (errno));
+        sp_ring_free (client->ring);
+        spalloc_free (ShmClient, client);
+        goto error;
+      }
+    } else {
+      fprintf (stderr, "Could not create ring, using the socket: %s",
+          strerror (errno));
+    }
+  }
+#endif
 
   /* Prepend ot linked list */
   client->next = self->clients;
@@ -933,6 +1347,8 @@ again:
 
   self->num_clients--;
 
+  if (client->ring)
+    sp_ring_free (client->ring);
   spalloc_free (ShmClient, client);
 }
 
@@ -995,3 +1411,110 @@ sp_writer_get_max_buf_size (ShmPipe * self)
 
   return self->shm_area->shm_area_len;
 }
+
+int
+sp_writer_get_alloc_stats (ShmPipe * self, size_t * used,
+    size_t * high_water_mark, size_t * largest_free)
+{
+  ShmAllocStats stats;
+
+  if (self->shm_area == NULL)
+    return -1;
+
+  shm_alloc_space_get_stats (self->shm_area->allocspace, &stats);
+  *used = stats.used;
+  *high_water_mark = stats.high_water_mark;
+  *largest_free = stats.largest_free;
+
+  return 0;
+}
+
+int
+sp_writer_set_ring (ShmPipe * self, int use_ring)
+{
+#ifdef SHM_PIPE_HAVE_RING
+  self->use_ring = use_ring;
+  return 0;
+#else
+  return use_ring ? -1 : 0;
+#endif
+}
+
+int
+sp_writer_get_client_notify_fd (ShmClient * client)
+{
+  return client->ring ? client->ring->acks_fd : -1;
+}
+
+int
+sp_writer_recv_ring (ShmPipe * self, ShmClient * client, void **tag)
+{
+#ifdef SHM_PIPE_HAVE_RING
+  ShmBuffer *buf = NULL, *prev_buf = NULL;
+  ShmRingSlot slot;
+
+  if (!client->ring ||
+      !sp_ring_peek (&client->ring->area->acks, client->ring->acks_fd, &slot))
+    return -1;
+  sp_ring_advance (&client->ring->area->acks);
+
+  for (buf = self->buffers; buf; buf = buf->next) {
+    if (buf->shm_area->id == slot.area_id && buf->offset == slot.offset)
+      return sp_shmbuf_dec (self, buf, prev_buf, client, tag);
+    prev_buf = buf;
+  }
+
+  return -2;
+#else
+  return -1;
+#endif
+}
+
+int
+sp_get_notify_fd (ShmPipe * self)
+{
+  return self->ring ? self->ring->buffers_fd : -1;
+}
+
+long int
+sp_client_recv_ring (ShmPipe * self, char **buf)
+{
+#ifdef SHM_PIPE_HAVE_RING
+  ShmArea *area;
+  ShmRingSlot slot;
+
+  if (!self->ring)
+    return -1;
+
+  while (sp_ring_peek (&self->ring->area->buffers, self->ring->buffers_fd,
+          &slot)) {
+    for (area = self->shm_area; area; area = area->next) {
+      if (area->id == slot.area_id)
+        break;
+    }
+
+    /* The new area is still in the socket, leave the buffer in the ring */
+    if (!area)
+      return -1;
+
+    sp_ring_advance (&self->ring->area->buffers);
+
+    switch (slot.type) {
+      case RING_SLOT_CLOSE_SHM_AREA:
+        sp_shm_area_dec (self, area);
+        break;
+      case RING_SLOT_BUFFER:
+        if (slot.offset > area->shm_area_len ||
+            slot.size > area->shm_area_len - slot.offset)
+          return -2;
+        *buf = area->shm_area_buf + slot.offset;
+        sp_shm_area_inc (area);
+        return slot.size;
+      default:
+        return -99;
+    }
+  }
+#endif
+
+  return -1;
+}
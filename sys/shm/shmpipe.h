@@ -69,6 +69,10 @@
 #include <fcntl.h>
 
 
+#if defined(__linux__) && defined(__GNUC__)
+#define SHM_PIPE_HAVE_RING 1
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -100,6 +104,8 @@ int sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void * tag);
 char *sp_writer_block_get_buf (ShmBlock *block);
 ShmPipe *sp_writer_block_get_pipe (ShmBlock *block);
 size_t sp_writer_get_max_buf_size (ShmPipe * self);
+int sp_writer_get_alloc_stats (ShmPipe * self, size_t * used,
+    size_t * high_water_mark, size_t * largest_free);
 
 ShmClient * sp_writer_accept_client (ShmPipe * self);
 void sp_writer_close_client (ShmPipe *self, ShmClient * client,
@@ -108,6 +114,10 @@ int sp_writer_recv (ShmPipe * self, ShmClient * client, void ** tag);
 
 int sp_writer_pending_writes (ShmPipe * self);
 
+int sp_writer_set_ring (ShmPipe * self, int use_ring);
+int sp_writer_get_client_notify_fd (ShmClient * client);
+int sp_writer_recv_ring (ShmPipe * self, ShmClient * client, void ** tag);
+
 ShmBuffer *sp_writer_get_pending_buffers (ShmPipe * self);
 ShmBuffer *sp_writer_get_next_buffer (ShmBuffer * buffer);
 void *sp_writer_buf_get_tag (ShmBuffer * buffer);
@@ -117,6 +127,9 @@ long int sp_client_recv (ShmPipe * self, char **buf);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
 void sp_client_close (ShmPipe * self);
 
+int sp_get_notify_fd (ShmPipe * self);
+long int sp_client_recv_ring (ShmPipe * self, char **buf);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,151 @@
+/* GStreamer
+ *
+ * Benchmark for bayer2rgb throughput
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures frames per second decoded by bayer2rgb for 4K in each
+ * combination of input depth, output format and method.
+ *
+ *   bayer2rgb [num-frames] [n-threads]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+
+#include <stdlib.h>
+
+#define WIDTH 3840
+#define HEIGHT 2160
+
+static const struct
+{
+  const gchar *in;
+  guint depth;
+  const gchar *out;
+} formats[] = {
+  {"bggr", 8, "BGRx"},
+  {"bggr", 8, "ARGB64"},
+  {"bggr10le", 10, "BGRx"},
+  {"bggr12le", 12, "ARGB64"},
+  {"bggr16le", 16, "ARGB64"},
+};
+
+static const gchar *methods[] = { "bilinear", "edge-directed" };
+
+/* Noise within the range of the depth */
+static GstBuffer *
+create_frame (guint depth)
+{
+  guint bpp = depth > 8 ? 2 : 1;
+  gsize size = GST_ROUND_UP_4 (WIDTH * bpp) * HEIGHT;
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, size, NULL);
+  GRand *rand = g_rand_new_with_seed (42);
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  if (depth > 8) {
+    for (i = 0; i < map.size / 2; i++)
+      GST_WRITE_UINT16_LE (map.data + 2 * i,
+          g_rand_int_range (rand, 0, 1 << depth));
+  } else {
+    for (i = 0; i < map.size; i++)
+      map.data[i] = g_rand_int_range (rand, 0, 256);
+  }
+  gst_buffer_unmap (buf, &map);
+  g_rand_free (rand);
+
+  return buf;
+}
+
+static gboolean
+run (guint f, const gchar * method, guint num_frames, guint n_threads)
+{
+  GstHarness *h;
+  GstBuffer *frame;
+  gchar *caps;
+  gint64 start, elapsed;
+  gdouble secs;
+  guint i;
+
+  h = gst_harness_new ("bayer2rgb");
+  if (!h)
+    return FALSE;
+
+  gst_util_set_object_arg (G_OBJECT (h->element), "method", method);
+  g_object_set (h->element, "n-threads", n_threads, NULL);
+
+  caps = g_strdup_printf ("video/x-bayer,format=%s,width=%d,height=%d,"
+      "framerate=60/1", formats[f].in, WIDTH, HEIGHT);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+  caps = g_strdup_printf ("video/x-raw,format=%s", formats[f].out);
+  gst_harness_set_sink_caps_str (h, caps);
+  g_free (caps);
+  gst_harness_set_drop_buffers (h, TRUE);
+
+  frame = create_frame (formats[f].depth);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < num_frames; i++)
+    gst_harness_push (h, gst_buffer_ref (frame));
+  elapsed = g_get_monotonic_time () - start;
+
+  secs = elapsed / (gdouble) G_USEC_PER_SEC;
+  g_print ("%-9s -> %-7s %-14s %u frames in %7.3f s: %7.1f frames/s\n",
+      formats[f].in, formats[f].out, method, num_frames, secs,
+      num_frames / secs);
+
+  gst_buffer_unref (frame);
+  gst_harness_teardown (h);
+
+  return TRUE;
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  guint num_frames = 200, n_threads = 1;
+  guint i, j;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    num_frames = atoi (argv[1]);
+  if (argc > 2)
+    n_threads = atoi (argv[2]);
+
+  g_print ("%ux%u, %u thread(s)\n", WIDTH, HEIGHT, n_threads);
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    for (j = 0; j < G_N_ELEMENTS (methods); j++) {
+      if (!run (i, methods[j], num_frames, n_threads)) {
+        g_printerr ("bayer2rgb not available\n");
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,143 @@
+/* GStreamer
+ *
+ * Benchmark for freeverb throughput
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the frames per second freeverb processes at 44.1kHz for each
+ * of its input formats, on noise and on the silence after a short burst,
+ * where the tails of the filters decay into denormals.
+ *
+ *   freeverb [seconds]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+#include <gst/audio/audio.h>
+
+#include <stdlib.h>
+
+#define RATE 44100
+#define FRAMES_PER_BUFFER 1024
+
+static const GstAudioFormat formats[] = {
+  GST_AUDIO_FORMAT_F32,
+  GST_AUDIO_FORMAT_S16,
+};
+
+/* Noise, or silence after the first @n_noise frames */
+static GstBuffer *
+create_buffer (GstAudioFormat format, gint channels, GRand * rand,
+    guint n_noise)
+{
+  guint i, n = FRAMES_PER_BUFFER * channels;
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = gst_buffer_new_allocate (NULL,
+      n * (format == GST_AUDIO_FORMAT_F32 ? 4 : 2), NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (i = 0; i < n; i++) {
+    gdouble v = i / channels < n_noise ?
+        g_rand_double_range (rand, -0.5, 0.5) : 0;
+
+    if (format == GST_AUDIO_FORMAT_F32)
+      ((gfloat *) map.data)[i] = v;
+    else
+      ((gint16 *) map.data)[i] = v * G_MAXINT16;
+  }
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static gboolean
+run (GstAudioFormat format, gint channels, gboolean decay, guint seconds)
+{
+  guint i, num_buffers = seconds * RATE / FRAMES_PER_BUFFER;
+  GRand *rand = g_rand_new_with_seed (42);
+  GstBuffer *noise, *silence;
+  GstHarness *h;
+  GstAudioInfo info;
+  gint64 start, elapsed;
+  gdouble secs;
+
+  h = gst_harness_new ("freeverb");
+  if (!h)
+    return FALSE;
+
+  gst_audio_info_set_format (&info, format, RATE, channels, NULL);
+  gst_harness_set_src_caps (h, gst_audio_info_to_caps (&info));
+  gst_harness_set_drop_buffers (h, TRUE);
+
+  /* a burst of 10ms in the first buffer */
+  noise = create_buffer (format, channels, rand,
+      decay ? RATE / 100 : FRAMES_PER_BUFFER);
+  silence = create_buffer (format, channels, rand, 0);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < num_buffers; i++)
+    gst_harness_push (h, gst_buffer_ref (i == 0 || !decay ? noise : silence));
+  elapsed = g_get_monotonic_time () - start;
+
+  secs = elapsed / (gdouble) G_USEC_PER_SEC;
+  g_print ("%-5s %-6s %-6s %u frames in %7.3f s: %12.1f frames/s\n",
+      gst_audio_format_to_string (format), channels == 1 ? "mono" : "stereo",
+      decay ? "decay" : "noise", num_buffers * FRAMES_PER_BUFFER, secs,
+      num_buffers * FRAMES_PER_BUFFER / secs);
+
+  gst_buffer_unref (noise);
+  gst_buffer_unref (silence);
+  g_rand_free (rand);
+  gst_harness_teardown (h);
+
+  return TRUE;
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  guint seconds = 60;
+  guint i;
+  gint channels;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    seconds = atoi (argv[1]);
+
+  g_print ("%u s at %u Hz, %u frames per buffer\n", seconds, RATE,
+      FRAMES_PER_BUFFER);
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    for (channels = 1; channels <= 2; channels++) {
+      if (!run (formats[i], channels, FALSE, seconds) ||
+          !run (formats[i], channels, TRUE, seconds)) {
+        g_printerr ("freeverb not available\n");
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
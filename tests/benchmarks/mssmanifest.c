@@ -0,0 +1,145 @@
+/* GStreamer
+ *
+ * Benchmark for the Smooth Streaming manifest handling
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures parsing, seeking in and refreshing a live manifest with a DVR
+ * window of several hours of 2 second fragments. The durations alternate
+ * like those of AAC fragments, so none of them can be merged into runs.
+ *
+ *   mssmanifest [window-hours] [iterations]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+
+#include <stdlib.h>
+
+#include "../../ext/smoothstreaming/gstmssmanifest.h"
+
+GST_DEBUG_CATEGORY (mssdemux_debug);
+
+#define TIMESCALE 10000000
+#define DURATION_A 20053333
+#define DURATION_B 19946667
+
+/* A live manifest with @count fragments, starting with fragment @first */
+static GstBuffer *
+create_manifest (guint first, guint count)
+{
+  GString *s = g_string_new (NULL);
+  guint64 t = (guint64) (first / 2) * (DURATION_A + DURATION_B);
+  gsize len;
+  guint i;
+
+  if (first & 1)
+    t += DURATION_A;
+
+  g_string_append_printf (s, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+      "<SmoothStreamingMedia MajorVersion=\"2\" MinorVersion=\"0\" "
+      "TimeScale=\"%d\" Duration=\"0\" IsLive=\"TRUE\" "
+      "LookAheadFragmentCount=\"2\" DVRWindowLength=\"%" G_GUINT64_FORMAT
+      "\"><StreamIndex Type=\"audio\" Language=\"eng\" QualityLevels=\"1\" "
+      "Chunks=\"%u\" Url=\"QualityLevels({bitrate})/"
+      "Fragments(audio_eng={start time})\"><QualityLevel Index=\"0\" "
+      "Bitrate=\"128000\" FourCC=\"AACL\" SamplingRate=\"48000\" "
+      "Channels=\"2\" BitsPerSample=\"16\" PacketSize=\"4\" AudioTag=\"255\" "
+      "CodecPrivateData=\"1190\" />", TIMESCALE,
+      (guint64) count * 2 * TIMESCALE, count);
+
+  g_string_append_printf (s, "<c t=\"%" G_GUINT64_FORMAT "\" d=\"%d\" />", t,
+      (first & 1) ? DURATION_B : DURATION_A);
+  for (i = first + 1; i < first + count; i++)
+    g_string_append_printf (s, "<c d=\"%d\" />",
+        (i & 1) ? DURATION_B : DURATION_A);
+
+  g_string_append (s, "</StreamIndex></SmoothStreamingMedia>");
+
+  len = s->len;
+  return gst_buffer_new_wrapped (g_string_free (s, FALSE), len);
+}
+
+static void
+report (const gchar * name, guint n, gint64 elapsed)
+{
+  g_print ("%-8s %6u x %10.3f us\n", name, n, elapsed / (gdouble) n);
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  guint hours = 4, iterations = 1000, count;
+  GstMssManifest *manifest;
+  GstMssStream *stream;
+  GstBuffer *buf;
+  guint64 window, final_time;
+  gint64 start, elapsed;
+  GRand *rand;
+  guint i;
+
+  gst_init (&argc, &argv);
+  GST_DEBUG_CATEGORY_INIT (mssdemux_debug, "mssdemux", 0, "mssdemux");
+
+  if (argc > 1)
+    hours = atoi (argv[1]);
+  if (argc > 2)
+    iterations = atoi (argv[2]);
+
+  count = hours * 3600 / 2;
+  window = (guint64) (count / 2) * (DURATION_A + DURATION_B);
+  g_print ("%u fragments, %u iterations\n", count, iterations);
+
+  buf = create_manifest (0, count);
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations / 100 + 1; i++)
+    gst_mss_manifest_free (gst_mss_manifest_new (buf));
+  report ("parse", i, g_get_monotonic_time () - start);
+
+  manifest = gst_mss_manifest_new (buf);
+  gst_buffer_unref (buf);
+  stream = gst_mss_manifest_get_streams (manifest)->data;
+  gst_mss_stream_set_active (stream, TRUE);
+
+  rand = g_rand_new_with_seed (42);
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    gst_mss_stream_seek (stream, i & 1, 0, g_rand_int_range (rand, 0,
+            window / 100) * 100, &final_time);
+  report ("seek", iterations, g_get_monotonic_time () - start);
+  g_rand_free (rand);
+
+  /* each refresh slides the window by one fragment */
+  elapsed = 0;
+  for (i = 0; i < iterations; i++) {
+    buf = create_manifest (i + 1, count);
+    start = g_get_monotonic_time ();
+    gst_mss_manifest_reload_fragments (manifest, buf);
+    elapsed += g_get_monotonic_time () - start;
+    gst_buffer_unref (buf);
+  }
+  report ("refresh", iterations, elapsed);
+
+  gst_mss_manifest_free (manifest);
+
+  return 0;
+}
@@ -458,6 +458,9 @@ testSeekPreTestCallback (GstAdaptiveDemuxTestEngine * engine,
   g_signal_connect (bus, "message::state-changed",
       G_CALLBACK (testSeekOnStateChanged), testData);
   gst_object_unref (bus);
+
+  if (testData->callbacks.pre_test)
+    testData->callbacks.pre_test (engine, user_data);
 }
 
 static void
@@ -472,6 +475,9 @@ testSeekPostTestCallback (GstAdaptiveDemuxTestEngine * engine,
 
     fail_if (td->segment_verification_needed);
   }
+
+  if (testData->callbacks.post_test)
+    testData->callbacks.post_test (engine, user_data);
 }
 
 /* function to check total size of data received by AppSink
@@ -507,10 +513,28 @@ void gst_adaptive_demux_test_download_error_size_of_received_data
 void
 gst_adaptive_demux_test_seek (const gchar * element_name,
     const gchar * manifest_uri, GstAdaptiveDemuxTestCase * testData)
+{
+  gst_adaptive_demux_test_seek_full (element_name, manifest_uri, NULL,
+      testData);
+}
+
+void
+gst_adaptive_demux_test_seek_full (const gchar * element_name,
+    const gchar * manifest_uri,
+    const GstAdaptiveDemuxTestCallbacks * callbacks,
+    GstAdaptiveDemuxTestCase * testData)
 {
   GstAdaptiveDemuxTestCallbacks cb = { 0 };
-  cb.appsink_received_data = gst_adaptive_demux_test_check_received_data;
-  cb.appsink_eos = gst_adaptive_demux_test_check_size_of_received_data;
+
+  if (callbacks)
+    testData->callbacks = *callbacks;
+
+  cb.appsink_received_data = testData->callbacks.appsink_received_data ?
+      testData->callbacks.appsink_received_data :
+      gst_adaptive_demux_test_check_received_data;
+  cb.appsink_eos = testData->callbacks.appsink_eos ?
+      testData->callbacks.appsink_eos :
+      gst_adaptive_demux_test_check_size_of_received_data;
   cb.appsink_event = testSeekAdaptiveAppSinkEvent;
   cb.pre_test = testSeekPreTestCallback;
   cb.post_test = testSeekPostTestCallback;
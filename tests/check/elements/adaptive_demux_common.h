@@ -115,6 +115,10 @@ typedef struct _GstAdaptiveDemuxTestCase
   GstEvent *seek_event;
   gboolean seeked;
 
+  /* the callbacks of the test itself, set by
+   * gst_adaptive_demux_test_seek_full() */
+  GstAdaptiveDemuxTestCallbacks callbacks;
+
   gpointer signal_context;
 } GstAdaptiveDemuxTestCase;
 
@@ -150,6 +154,19 @@ void gst_adaptive_demux_test_seek (const gchar * element_name,
     const gchar * manifest_uri,
     GstAdaptiveDemuxTestCase *testData);
 
+/**
+ * gst_adaptive_demux_test_seek_full: like gst_adaptive_demux_test_seek()
+ * @callbacks: (allow none) callbacks of the test
+ *
+ * The appsink_received_data and appsink_eos callbacks of @callbacks replace
+ * the default size and data checks. Its pre_test and post_test callbacks
+ * are called after the ones of the seek test.
+ */
+void gst_adaptive_demux_test_seek_full (const gchar * element_name,
+    const gchar * manifest_uri,
+    const GstAdaptiveDemuxTestCallbacks * callbacks,
+    GstAdaptiveDemuxTestCase *testData);
+
 /* Utility functions for use within a unit test */
 
 /**
@@ -0,0 +1,514 @@
+/* GStreamer
+ *
+ * Unit test for bayer2rgb
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstharness.h>
+#include <gst/check/gstcheck.h>
+
+#include <stdlib.h>
+
+/* The line functions, with the SSE2 or NEON loops where available */
+#include "../../gst/bayer/gstbayerdemosaic.c"
+
+/* Odd sizes, so that the SIMD loops have tails and the slices differ */
+#define WIDTH 38
+#define HEIGHT 23
+
+static const gchar *patterns[] = { "bggr", "gbrg", "grbg", "rggb" };
+static const guint depths[] = { 8, 10, 12, 14, 16 };
+
+/* 8 bit output formats with the byte offsets of red, green, blue and alpha */
+static const struct
+{
+  const gchar *name;
+  gint r, g, b, a;
+} formats_8[] = {
+  {"BGRx", 2, 1, 0, 3},
+  {"RGBA", 0, 1, 2, 3},
+  {"xRGB", 1, 2, 3, 0},
+  {"ABGR", 3, 2, 1, 0},
+};
+
+/* Reference implementations, one pixel at a time, of the bilinear and
+ * edge-directed methods, with the rows and columns outside the frame
+ * mirrored */
+
+typedef struct
+{
+  const guint16 *data;
+  gint width, height;
+  gint max;
+  gint r_x, r_y;                /* column and row parity of red */
+} Frame;
+
+static gint
+mirror (gint v, gint size)
+{
+  if (v < 0)
+    v = -v;
+  if (v >= size)
+    v = 2 * (size - 1) - v;
+  return v;
+}
+
+static gint
+S (const Frame * f, gint x, gint y)
+{
+  return f->data[mirror (y, f->height) * f->width + mirror (x, f->width)];
+}
+
+/* Column parity of the red or blue samples of row @y */
+static gint
+own_parity (const Frame * f, gint y)
+{
+  return (y & 1) == (f->r_y & 1) ? f->r_x : !f->r_x;
+}
+
+/* Row @y upsampled horizontally for the color at column parity @p */
+static gint
+H (const Frame * f, gint x, gint y, gint p)
+{
+  if ((x & 1) == p)
+    return S (f, x, y);
+  return AVG (S (f, x - 1, y), S (f, x + 1, y));
+}
+
+static void
+ref_bilinear (const Frame * f, gint x, gint y, gint * r, gint * g, gint * b)
+{
+  gint own_odd = own_parity (f, y);
+  gint own, other;
+
+  own = H (f, x, y, own_odd);
+  other = AVG (H (f, x, y - 1, !own_odd), H (f, x, y + 1, !own_odd));
+  if ((x & 1) == !own_odd)
+    *g = S (f, x, y);
+  else
+    *g = AVG (AVG (H (f, x, y - 1, own_odd), H (f, x, y + 1, own_odd)),
+        H (f, x, y, !own_odd));
+
+  *r = (y & 1) == f->r_y ? own : other;
+  *b = (y & 1) == f->r_y ? other : own;
+}
+
+static gint
+G (const Frame * f, gint x, gint y)
+{
+  gint gh, gv, lh, lv, dh, dv, v;
+
+  x = mirror (x, f->width);
+  y = mirror (y, f->height);
+
+  if ((x & 1) != own_parity (f, y))
+    return S (f, x, y);
+
+  gh = S (f, x - 1, y) + S (f, x + 1, y);
+  gv = S (f, x, y - 1) + S (f, x, y + 1);
+  lh = 2 * S (f, x, y) - S (f, x - 2, y) - S (f, x + 2, y);
+  lv = 2 * S (f, x, y) - S (f, x, y - 2) - S (f, x, y + 2);
+  dh = abs (S (f, x - 1, y) - S (f, x + 1, y)) + abs (lh);
+  dv = abs (S (f, x, y - 1) - S (f, x, y + 1)) + abs (lv);
+
+  if (dh < dv)
+    v = (2 * gh + lh) / 4;
+  else if (dv < dh)
+    v = (2 * gv + lv) / 4;
+  else
+    v = (2 * (gh + gv) + lh + lv) / 8;
+
+  return CLAMP (v, 0, f->max);
+}
+
+/* Color difference to green */
+static gint
+D (const Frame * f, gint x, gint y)
+{
+  return S (f, x, y) - G (f, x, y);
+}
+
+static void
+ref_edge_directed (const Frame * f, gint x, gint y, gint * r, gint * g,
+    gint * b)
+{
+  gint own, other;
+
+  *g = G (f, x, y);
+  if ((x & 1) == own_parity (f, y)) {
+    own = S (f, x, y);
+    other = *g + (D (f, x - 1, y - 1) + D (f, x + 1, y - 1) +
+        D (f, x - 1, y + 1) + D (f, x + 1, y + 1)) / 4;
+  } else {
+    own = *g + (D (f, x - 1, y) + D (f, x + 1, y)) / 2;
+    other = *g + (D (f, x, y - 1) + D (f, x, y + 1)) / 2;
+  }
+  own = CLAMP (own, 0, f->max);
+  other = CLAMP (other, 0, f->max);
+
+  *r = (y & 1) == f->r_y ? own : other;
+  *b = (y & 1) == f->r_y ? other : own;
+}
+
+/* Scales a sample of @depth bits to 16 bits by repeating its top bits */
+static gint
+scale_16 (gint v, guint depth)
+{
+  gint up = 16 - depth;
+
+  return up ? (v << up) | (v >> (depth - up)) : v;
+}
+
+static void
+frame_init (Frame * f, const guint16 * data, const gchar * pattern,
+    guint depth)
+{
+  f->data = data;
+  f->width = WIDTH;
+  f->height = HEIGHT;
+  f->max = (1 << depth) - 1;
+  f->r_x = g_str_equal (pattern, "bggr") || g_str_equal (pattern, "grbg");
+  f->r_y = g_str_equal (pattern, "bggr") || g_str_equal (pattern, "gbrg");
+}
+
+/* The bayer buffer for @samples, with rows padded to 4 bytes */
+static GstBuffer *
+create_bayer_buffer (const guint16 * samples, guint depth)
+{
+  guint bpp = depth > 8 ? 2 : 1;
+  guint stride = GST_ROUND_UP_4 (WIDTH * bpp);
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, stride * HEIGHT, NULL);
+  GstMapInfo map;
+  gint x, y;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0, map.size);
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      if (bpp == 2)
+        GST_WRITE_UINT16_LE (map.data + y * stride + 2 * x,
+            samples[y * WIDTH + x]);
+      else
+        map.data[y * stride + x] = samples[y * WIDTH + x];
+    }
+  }
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstBuffer *
+decode (const guint16 * samples, const gchar * pattern, guint depth,
+    const gchar * format, const gchar * method, guint n_threads)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  gchar *caps;
+
+  h = gst_harness_new ("bayer2rgb");
+  gst_util_set_object_arg (G_OBJECT (h->element), "method", method);
+  g_object_set (h->element, "n-threads", n_threads, NULL);
+
+  caps = g_strdup_printf ("video/x-bayer,format=%s%s,width=%d,height=%d,"
+      "framerate=25/1", pattern, depth == 8 ? "" :
+      depth == 10 ? "10le" : depth == 12 ? "12le" : depth == 14 ? "14le" :
+      "16le", WIDTH, HEIGHT);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+  caps = g_strdup_printf ("video/x-raw,format=%s", format);
+  gst_harness_set_sink_caps_str (h, caps);
+  g_free (caps);
+
+  buf = gst_harness_push_and_pull (h, create_bayer_buffer (samples, depth));
+  fail_unless (buf != NULL);
+  gst_harness_teardown (h);
+
+  return buf;
+}
+
+typedef void (*RefFunc) (const Frame * f, gint x, gint y, gint * r, gint * g,
+    gint * b);
+
+/* Checks the decoded frame @buf against the reference */
+static void
+check_frame (GstBuffer * buf, const Frame * f, guint depth,
+    const gchar * format, RefFunc ref)
+{
+  GstMapInfo map;
+  gint x, y, r, g, b;
+  guint i;
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+
+  if (g_str_equal (format, "ARGB64")) {
+    const guint16 *d = (const guint16 *) map.data;
+
+    fail_unless_equals_int (map.size, WIDTH * HEIGHT * 8);
+    for (y = 0; y < HEIGHT; y++) {
+      for (x = 0; x < WIDTH; x++, d += 4) {
+        ref (f, x, y, &r, &g, &b);
+        fail_unless_equals_int (d[0], 0xffff);
+        fail_unless (d[1] == scale_16 (r, depth) &&
+            d[2] == scale_16 (g, depth) && d[3] == scale_16 (b, depth),
+            "pixel %d,%d: %04x %04x %04x instead of %04x %04x %04x", x, y,
+            d[1], d[2], d[3], scale_16 (r, depth), scale_16 (g, depth),
+            scale_16 (b, depth));
+      }
+    }
+  } else {
+    const guint8 *d = map.data;
+
+    for (i = 0; !g_str_equal (formats_8[i].name, format); i++);
+
+    fail_unless_equals_int (map.size, WIDTH * HEIGHT * 4);
+    for (y = 0; y < HEIGHT; y++) {
+      for (x = 0; x < WIDTH; x++, d += 4) {
+        ref (f, x, y, &r, &g, &b);
+        r >>= depth - 8;
+        g >>= depth - 8;
+        b >>= depth - 8;
+        fail_unless_equals_int (d[formats_8[i].a], 0xff);
+        fail_unless (d[formats_8[i].r] == r && d[formats_8[i].g] == g &&
+            d[formats_8[i].b] == b,
+            "pixel %d,%d: %02x %02x %02x instead of %02x %02x %02x", x, y,
+            d[formats_8[i].r], d[formats_8[i].g], d[formats_8[i].b], r, g, b);
+      }
+    }
+  }
+
+  gst_buffer_unmap (buf, &map);
+}
+
+static guint16 *
+create_noise (guint depth, guint32 seed)
+{
+  guint16 *samples = g_new (guint16, WIDTH * HEIGHT);
+  GRand *rand = g_rand_new_with_seed (seed);
+  guint i;
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    samples[i] = g_rand_int_range (rand, 0, 1 << depth);
+  g_rand_free (rand);
+
+  return samples;
+}
+
+/* Random lines, of all lengths that leave a tail after the vector loop,
+ * through the line functions and one pixel at a time */
+GST_START_TEST (test_line_functions)
+{
+  guint16 src[4][64 + 2 * BAYER16_PAD], d0[64], d1[64];
+  GRand *rand = g_rand_new_with_seed (1);
+  gint n, x, i, odd;
+
+  for (n = 1; n <= 64; n++) {
+    for (i = 0; i < 4; i++)
+      for (x = 0; x < n + 2 * BAYER16_PAD; x++)
+        src[i][x] = g_rand_int_range (rand, 0, 0x10000);
+
+    bayer16_split_and_upsample_horiz (d0, d1, src[0] + BAYER16_PAD, n);
+    for (x = 0; x < n; x++) {
+      const guint16 *s = src[0] + BAYER16_PAD;
+      guint a = AVG (s[x - 1], s[x + 1]);
+
+      fail_unless_equals_int (d0[x], (x & 1) ? a : s[x]);
+      fail_unless_equals_int (d1[x], (x & 1) ? s[x] : a);
+    }
+
+    for (odd = 0; odd < 2; odd++) {
+      bayer16_merge (d0, d1, src[0], src[1], src[2], src[3], src[0] + 1,
+          odd, n);
+      for (x = 0; x < n; x++) {
+        fail_unless_equals_int (d0[x], AVG (src[0][x], src[1][x]));
+        if ((x & 1) == odd)
+          fail_unless_equals_int (d1[x], src[3][x]);
+        else
+          fail_unless_equals_int (d1[x], AVG (AVG (src[2][x], src[0][x + 1]),
+                  src[3][x]));
+      }
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* A single color has to come out unchanged, for every pattern, depth,
+ * output format, method and number of slices */
+GST_START_TEST (test_flat_color)
+{
+  static const gchar *methods[] = { "bilinear", "edge-directed" };
+  guint16 samples[WIDTH * HEIGHT];
+  guint p, d, f, m, t;
+  gint x, y;
+
+  for (p = 0; p < G_N_ELEMENTS (patterns); p++) {
+    for (d = 0; d < G_N_ELEMENTS (depths); d++) {
+      guint depth = depths[d];
+      gint color[3] = { (1 << depth) - 1, (1 << depth) / 3, 5 };
+      Frame frame;
+
+      /* each sample gets the value of the color at its position */
+      frame_init (&frame, samples, patterns[p], depth);
+      for (y = 0; y < HEIGHT; y++) {
+        for (x = 0; x < WIDTH; x++) {
+          gint c = 1;
+
+          if ((y & 1) == frame.r_y && (x & 1) == frame.r_x)
+            c = 0;
+          else if ((y & 1) != frame.r_y && (x & 1) != frame.r_x)
+            c = 2;
+          samples[y * WIDTH + x] = color[c];
+        }
+      }
+
+      for (f = 0; f <= G_N_ELEMENTS (formats_8); f++) {
+        const gchar *format =
+            f < G_N_ELEMENTS (formats_8) ? formats_8[f].name : "ARGB64";
+
+        for (m = 0; m < G_N_ELEMENTS (methods); m++) {
+          for (t = 1; t <= 3; t += 2) {
+            GstBuffer *buf = decode (samples, patterns[p], depth, format,
+                methods[m], t);
+
+            check_frame (buf, &frame, depth, format,
+                m == 0 ? ref_bilinear : ref_edge_directed);
+            gst_buffer_unref (buf);
+          }
+        }
+      }
+    }
+  }
+}
+
+GST_END_TEST;
+
+/* Noise against the bilinear reference, through the Orc path for 8 bit
+ * input and output and through the 16 bit line functions otherwise */
+GST_START_TEST (test_bilinear)
+{
+  guint p, d, t;
+
+  for (p = 0; p < G_N_ELEMENTS (patterns); p++) {
+    for (d = 0; d < G_N_ELEMENTS (depths); d++) {
+      guint16 *samples = create_noise (depths[d], p * 16 + d);
+      Frame frame;
+
+      frame_init (&frame, samples, patterns[p], depths[d]);
+      for (t = 1; t <= 4; t += 3) {
+        GstBuffer *buf;
+
+        buf = decode (samples, patterns[p], depths[d], "BGRx", "bilinear", t);
+        check_frame (buf, &frame, depths[d], "BGRx", ref_bilinear);
+        gst_buffer_unref (buf);
+
+        buf = decode (samples, patterns[p], depths[d], "ARGB64", "bilinear",
+            t);
+        check_frame (buf, &frame, depths[d], "ARGB64", ref_bilinear);
+        gst_buffer_unref (buf);
+      }
+      g_free (samples);
+    }
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_edge_directed)
+{
+  guint p, d, t;
+
+  for (p = 0; p < G_N_ELEMENTS (patterns); p++) {
+    for (d = 0; d < G_N_ELEMENTS (depths); d++) {
+      guint16 *samples = create_noise (depths[d], 1000 + p * 16 + d);
+      Frame frame;
+
+      frame_init (&frame, samples, patterns[p], depths[d]);
+      for (t = 1; t <= 4; t += 3) {
+        GstBuffer *buf;
+
+        buf = decode (samples, patterns[p], depths[d], "RGBA",
+            "edge-directed", t);
+        check_frame (buf, &frame, depths[d], "RGBA", ref_edge_directed);
+        gst_buffer_unref (buf);
+
+        buf = decode (samples, patterns[p], depths[d], "ARGB64",
+            "edge-directed", t);
+        check_frame (buf, &frame, depths[d], "ARGB64", ref_edge_directed);
+        gst_buffer_unref (buf);
+      }
+      g_free (samples);
+    }
+  }
+}
+
+GST_END_TEST;
+
+/* Grey with a sharp vertical and a sharp horizontal edge is reproduced
+ * exactly by the edge-directed method, without colour fringes */
+static void
+ref_grey_edges (const Frame * f, gint x, gint y, gint * r, gint * g, gint * b)
+{
+  *r = *g = *b = f->data[y * f->width + x];
+}
+
+GST_START_TEST (test_edge_directed_edges)
+{
+  guint16 samples[WIDTH * HEIGHT];
+  guint p, edge;
+  gint x, y;
+
+  for (edge = 0; edge < 2; edge++) {
+    for (y = 0; y < HEIGHT; y++)
+      for (x = 0; x < WIDTH; x++)
+        samples[y * WIDTH + x] =
+            (edge ? y >= HEIGHT / 2 : x >= WIDTH / 2) ? 0xe00 : 0x100;
+
+    for (p = 0; p < G_N_ELEMENTS (patterns); p++) {
+      GstBuffer *buf;
+      Frame frame;
+
+      frame_init (&frame, samples, patterns[p], 12);
+      buf = decode (samples, patterns[p], 12, "ARGB64", "edge-directed", 1);
+      check_frame (buf, &frame, 12, "ARGB64", ref_grey_edges);
+      gst_buffer_unref (buf);
+    }
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+bayer2rgb_suite (void)
+{
+  Suite *s = suite_create ("bayer2rgb");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_line_functions);
+  tcase_add_test (tc_chain, test_flat_color);
+  tcase_add_test (tc_chain, test_bilinear);
+  tcase_add_test (tc_chain, test_edge_directed);
+  tcase_add_test (tc_chain, test_edge_directed_edges);
+
+  return s;
+}
+
+GST_CHECK_MAIN (bayer2rgb);
@@ -0,0 +1,259 @@
+/* GStreamer
+ *
+ * unit test for the CEA-708 caption decoder of cc708overlay
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#include "../../ext/closedcaption/gstcea708decoder.h"
+
+#define WINDOW_ROWS 2
+#define WINDOW_COLUMNS 32
+
+typedef struct
+{
+  guchar *data;
+  gint width;
+  gint height;
+} WindowImage;
+
+static PangoContext *
+create_pango_context (void)
+{
+  return pango_font_map_create_context (pango_cairo_font_map_get_default ());
+}
+
+/* Wraps @block into a DTVCC packet of service 1 and decodes it */
+static gboolean
+process_block (Cea708Dec * decoder, const guint8 * block, guint len)
+{
+  /* commands look at the byte after them, keep the rest zeroed */
+  guint8 packet[DTVCC_LENGTH] = { 0, };
+
+  g_assert (len < 32);
+  packet[0] = (len + 3) / 2;    /* sequence number 0, packet size */
+  packet[1] = (1 << 5) | len;   /* service number 1, block size */
+  memcpy (packet + 2, block, len);
+
+  return gst_cea708dec_process_dtvcc_packet (decoder, packet, len + 2);
+}
+
+/* A decoder with a visible window 0 of WINDOW_ROWS rows */
+static Cea708Dec *
+create_decoder (PangoContext * context)
+{
+  static const guint8 define_window[] = {
+    CC_COMMAND_DF0,
+    0x20,                       /* visible, priority 0 */
+    0x80 | 80,                  /* relative position, 80% down */
+    50,                         /* 50% across */
+    WINDOW_ROWS - 1,            /* anchor point 0, row count */
+    WINDOW_COLUMNS - 1,
+    0x09                        /* window style 1, pen style 1 */
+  };
+  Cea708Dec *decoder = gst_cea708dec_create (context);
+
+  gst_cea708dec_set_video_width_height (decoder, 640, 480);
+  process_block (decoder, define_window, sizeof (define_window));
+
+  return decoder;
+}
+
+/* Clears window 0, writes @row0 and @row1 into it and ends the text, which
+ * renders the window */
+static void
+show_rows (Cea708Dec * decoder, const gchar * row0, const gchar * row1)
+{
+  guint8 block[32];
+  guint len = 0;
+
+  block[len++] = 0x0C;          /* form feed: clear, pen to row 0 column 0 */
+  memcpy (block + len, row0, strlen (row0));
+  len += strlen (row0);
+  block[len++] = CC_COMMAND_SPL;
+  block[len++] = 1;
+  block[len++] = 0;
+  memcpy (block + len, row1, strlen (row1));
+  len += strlen (row1);
+  block[len++] = CC_COMMAND_ETX;
+
+  fail_unless (process_block (decoder, block, len));
+  fail_unless (decoder->cc_windows[0]->text_image != NULL);
+}
+
+static void
+window_image_init (WindowImage * image, Cea708Dec * decoder)
+{
+  cea708Window *window = decoder->cc_windows[0];
+
+  image->width = window->image_width;
+  image->height = window->image_height;
+  image->data = g_memdup (window->text_image, 4 * image->width *
+      image->height);
+}
+
+static void
+check_window_image (Cea708Dec * decoder, const WindowImage * image)
+{
+  cea708Window *window = decoder->cc_windows[0];
+
+  fail_unless_equals_int (window->image_width, image->width);
+  fail_unless_equals_int (window->image_height, image->height);
+  fail_unless (memcmp (window->text_image, image->data,
+          4 * image->width * image->height) == 0);
+}
+
+/* A window made from rows rendered for earlier captions looks the same as
+ * one rendered from scratch */
+GST_START_TEST (test_warm_cache)
+{
+  PangoContext *context = create_pango_context ();
+  Cea708Dec *cold, *warm;
+  WindowImage image;
+  guint serial, n_rows;
+
+  gst_cea708_decoder_init_debug ();
+
+  cold = create_decoder (context);
+  show_rows (cold, "FIRST LINE", "SECOND LINE");
+  window_image_init (&image, cold);
+
+  warm = create_decoder (context);
+  show_rows (warm, "FIRST LINE", "OTHER LINE");
+  show_rows (warm, "ANOTHER LINE", "SECOND LINE");
+  serial = warm->cc_windows[0]->image_serial;
+  n_rows = g_hash_table_size (warm->row_cache);
+
+  show_rows (warm, "FIRST LINE", "SECOND LINE");
+  /* the window was drawn again, but both rows came from the cache */
+  fail_unless (warm->cc_windows[0]->image_serial != serial);
+  fail_unless_equals_int (g_hash_table_size (warm->row_cache), n_rows);
+  check_window_image (warm, &image);
+
+  g_free (image.data);
+  gst_cea708dec_free (cold);
+  gst_cea708dec_free (warm);
+  g_object_unref (context);
+}
+
+GST_END_TEST;
+
+/* Showing the same text again keeps the window image, which is what lets
+ * the overlay keep the window's rectangle */
+GST_START_TEST (test_redisplay)
+{
+  static const guint8 display_window[] = { CC_COMMAND_DSW, 0x01 };
+  PangoContext *context = create_pango_context ();
+  Cea708Dec *decoder;
+  WindowImage image;
+  guint serial;
+
+  gst_cea708_decoder_init_debug ();
+
+  decoder = create_decoder (context);
+  show_rows (decoder, "FIRST LINE", "SECOND LINE");
+  serial = decoder->cc_windows[0]->image_serial;
+  window_image_init (&image, decoder);
+
+  fail_unless (process_block (decoder, display_window,
+          sizeof (display_window)));
+  fail_unless_equals_int (decoder->cc_windows[0]->image_serial, serial);
+  check_window_image (decoder, &image);
+
+  show_rows (decoder, "FIRST LINE", "SECOND LINE");
+  fail_unless_equals_int (decoder->cc_windows[0]->image_serial, serial);
+  check_window_image (decoder, &image);
+
+  show_rows (decoder, "SECOND LINE", "FIRST LINE");
+  fail_unless (decoder->cc_windows[0]->image_serial != serial);
+  fail_unless_equals_int (g_hash_table_size (decoder->row_cache), 2);
+
+  g_free (image.data);
+  gst_cea708dec_free (decoder);
+  g_object_unref (context);
+}
+
+GST_END_TEST;
+
+/* Rows that weren't used recently are dropped once there are too many of
+ * them, and are rendered again the same way when they come back */
+GST_START_TEST (test_row_cache_eviction)
+{
+  PangoContext *context = create_pango_context ();
+  Cea708Dec *decoder;
+  WindowImage image;
+  gboolean pruned = FALSE;
+  guint i, n_rows, prev_n_rows = 0;
+
+  gst_cea708_decoder_init_debug ();
+
+  decoder = create_decoder (context);
+  show_rows (decoder, "ROW A", "ROW B");
+  window_image_init (&image, decoder);
+
+  for (i = 0; i < CEA708_ROW_CACHE_SIZE; i++) {
+    gchar *row0 = g_strdup_printf ("ROW %u A", i);
+    gchar *row1 = g_strdup_printf ("ROW %u B", i);
+
+    show_rows (decoder, row0, row1);
+    n_rows = g_hash_table_size (decoder->row_cache);
+    fail_unless (n_rows <= CEA708_ROW_CACHE_SIZE);
+    if (n_rows < prev_n_rows)
+      pruned = TRUE;
+    prev_n_rows = n_rows;
+
+    g_free (row0);
+    g_free (row1);
+  }
+  fail_unless (pruned);
+
+  /* the rows of the first caption are gone and rendered again */
+  show_rows (decoder, "ROW A", "ROW B");
+  fail_unless (g_hash_table_size (decoder->row_cache) != prev_n_rows);
+  check_window_image (decoder, &image);
+
+  g_free (image.data);
+  gst_cea708dec_free (decoder);
+  g_object_unref (context);
+}
+
+GST_END_TEST;
+
+static Suite *
+cea708decoder_suite (void)
+{
+  Suite *s = suite_create ("cea708decoder");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_warm_cache);
+  tcase_add_test (tc_chain, test_redisplay);
+  tcase_add_test (tc_chain, test_row_cache_eviction);
+
+  return s;
+}
+
+GST_CHECK_MAIN (cea708decoder);
@@ -4,7 +4,13 @@
 
 #include <gst/check/gstcheck.h>
 #include <glib/gstdio.h>
+#include <gio/gio.h>
 #include <curl/curl.h>
+#include <string.h>
+
+#define NUM_BUFFERS 64
+#define BUFFER_SIZE (16 * 1024)
+#define DROP_AFTER 100000
 
 static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -125,6 +131,250 @@ GST_START_TEST (test_properties)
 
 GST_END_TEST;
 
+/* A minimal passive mode FTP server keeping a single uploaded file, the data
+ * connection of the first upload is dropped after DROP_AFTER bytes */
+typedef struct
+{
+  GSocketService *service;
+  guint16 port;
+  GMutex lock;
+  GByteArray *file;
+  gboolean have_file;
+  gboolean dropped;
+  gint stors;
+  gint appes;
+} TestServer;
+
+static guint8
+pattern_byte (guint offset)
+{
+  return (guint8) ((offset % 251) ^ (offset >> 12));
+}
+
+static gboolean
+send_reply (GOutputStream * out, const gchar * format, ...)
+{
+  gboolean ret;
+  va_list args;
+  gchar *reply;
+
+  va_start (args, format);
+  reply = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  ret = g_output_stream_write_all (out, reply, strlen (reply), NULL, NULL,
+      NULL);
+  g_free (reply);
+
+  return ret;
+}
+
+/* Returns FALSE if the data connection was dropped */
+static gboolean
+receive_file (TestServer * server, GSocketListener * data_listener,
+    gboolean append)
+{
+  GSocketConnection *data;
+  GInputStream *in;
+  guint8 buf[4096];
+  gsize limit = G_MAXSIZE, received = 0;
+  gssize n;
+
+  data = g_socket_listener_accept (data_listener, NULL, NULL, NULL);
+  fail_unless (data != NULL);
+  in = g_io_stream_get_input_stream (G_IO_STREAM (data));
+
+  g_mutex_lock (&server->lock);
+  if (!append)
+    g_byte_array_set_size (server->file, 0);
+  server->have_file = TRUE;
+  if (!server->dropped)
+    limit = DROP_AFTER;
+  g_mutex_unlock (&server->lock);
+
+  while (received < limit && (n = g_input_stream_read (in, buf,
+              MIN (sizeof (buf), limit - received), NULL, NULL)) > 0) {
+    g_mutex_lock (&server->lock);
+    g_byte_array_append (server->file, buf, n);
+    g_mutex_unlock (&server->lock);
+    received += n;
+  }
+
+  /* closing with unread data resets the connection */
+  g_io_stream_close (G_IO_STREAM (data), NULL, NULL);
+  g_object_unref (data);
+
+  if (received < limit)
+    return TRUE;
+
+  g_mutex_lock (&server->lock);
+  server->dropped = TRUE;
+  g_mutex_unlock (&server->lock);
+
+  return FALSE;
+}
+
+static gboolean
+server_run (GThreadedSocketService * service, GSocketConnection * connection,
+    GObject * source_object, TestServer * server)
+{
+  GSocketListener *data_listener = g_socket_listener_new ();
+  GDataInputStream *in;
+  GOutputStream *out;
+  guint16 data_port = 0;
+  gboolean ok;
+  gchar *line;
+
+  in = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (connection)));
+  g_data_input_stream_set_newline_type (in, G_DATA_STREAM_NEWLINE_TYPE_CR_LF);
+  out = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+  ok = send_reply (out, "220 Ready\r\n");
+  while (ok && (line = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+    if (g_str_has_prefix (line, "USER")) {
+      ok = send_reply (out, "331 Password required\r\n");
+    } else if (g_str_has_prefix (line, "PASS")) {
+      ok = send_reply (out, "230 Logged in\r\n");
+    } else if (g_str_has_prefix (line, "PWD")) {
+      ok = send_reply (out, "257 \"/\"\r\n");
+    } else if (g_str_has_prefix (line, "TYPE")) {
+      ok = send_reply (out, "200 Type set\r\n");
+    } else if (g_str_has_prefix (line, "EPSV")) {
+      if (data_port == 0)
+        data_port = g_socket_listener_add_any_inet_port (data_listener, NULL,
+            NULL);
+      ok = send_reply (out, "229 Entering Extended Passive Mode (|||%u|)\r\n",
+          data_port);
+    } else if (g_str_has_prefix (line, "SIZE")) {
+      g_mutex_lock (&server->lock);
+      if (server->have_file)
+        ok = send_reply (out, "213 %u\r\n", server->file->len);
+      else
+        ok = send_reply (out, "550 No such file\r\n");
+      g_mutex_unlock (&server->lock);
+    } else if (g_str_has_prefix (line, "STOR") ||
+        g_str_has_prefix (line, "APPE")) {
+      gboolean append = g_str_has_prefix (line, "APPE");
+
+      g_atomic_int_inc (append ? &server->appes : &server->stors);
+      ok = send_reply (out, "150 Ok to send data\r\n");
+      if (ok && receive_file (server, data_listener, append)) {
+        ok = send_reply (out, "226 Transfer complete\r\n");
+      } else {
+        /* the client has to reconnect */
+        send_reply (out, "426 Connection closed; transfer aborted\r\n");
+        ok = FALSE;
+      }
+    } else if (g_str_has_prefix (line, "QUIT")) {
+      send_reply (out, "221 Bye\r\n");
+      ok = FALSE;
+    } else {
+      ok = send_reply (out, "502 Command not implemented\r\n");
+    }
+    g_free (line);
+  }
+
+  g_io_stream_close (G_IO_STREAM (connection), NULL, NULL);
+  g_socket_listener_close (data_listener);
+  g_object_unref (data_listener);
+  g_object_unref (in);
+
+  return TRUE;
+}
+
+static TestServer *
+test_server_new (void)
+{
+  TestServer *server = g_new0 (TestServer, 1);
+  GError *err = NULL;
+
+  g_mutex_init (&server->lock);
+  server->file = g_byte_array_new ();
+  server->service = g_threaded_socket_service_new (4);
+  server->port =
+      g_socket_listener_add_any_inet_port (G_SOCKET_LISTENER
+      (server->service), NULL, &err);
+  fail_unless (server->port != 0, "Couldn't listen: %s",
+      err ? err->message : "");
+  g_signal_connect (server->service, "run", G_CALLBACK (server_run), server);
+  g_socket_service_start (server->service);
+
+  return server;
+}
+
+static void
+test_server_free (TestServer * server)
+{
+  g_socket_service_stop (server->service);
+  g_socket_listener_close (G_SOCKET_LISTENER (server->service));
+  g_object_unref (server->service);
+  g_byte_array_unref (server->file);
+  g_mutex_clear (&server->lock);
+  g_free (server);
+}
+
+static void
+push_pattern_buffer (guint offset)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint i;
+
+  buffer = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_WRITE));
+  for (i = 0; i < BUFFER_SIZE; i++)
+    map.data[i] = pattern_byte (offset + i);
+  gst_buffer_unmap (buffer, &map);
+
+  fail_unless_equals_int (gst_pad_push (srcpad, buffer), GST_FLOW_OK);
+}
+
+GST_START_TEST (test_resume_upload)
+{
+  TestServer *server = test_server_new ();
+  GstElement *sink;
+  GstCaps *caps;
+  gchar *location;
+  guint i;
+
+  sink = setup_curlftpsink ();
+
+  location = g_strdup_printf ("ftp://127.0.0.1:%u/", server->port);
+  g_object_set (G_OBJECT (sink), "location", location,
+      "file-name", "upload.bin", "resume-attempts", 2, NULL);
+  g_free (location);
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (srcpad, sink, caps, GST_FORMAT_BYTES);
+
+  for (i = 0; i < NUM_BUFFERS; i++)
+    push_pattern_buffer (i * BUFFER_SIZE);
+
+  /* the upload continues with APPE where the server lost the connection */
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_eos ()));
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+
+  gst_caps_unref (caps);
+  cleanup_curlftpsink (sink);
+
+  g_mutex_lock (&server->lock);
+  fail_unless (server->dropped);
+  fail_unless_equals_int (server->stors, 1);
+  fail_unless_equals_int (server->appes, 1);
+  fail_unless_equals_int (server->file->len, NUM_BUFFERS * BUFFER_SIZE);
+  for (i = 0; i < NUM_BUFFERS * BUFFER_SIZE; i++) {
+    if (server->file->data[i] != pattern_byte (i))
+      fail ("Wrong data at offset %u", i);
+  }
+  g_mutex_unlock (&server->lock);
+
+  test_server_free (server);
+}
+
+GST_END_TEST;
+
 static Suite *
 curlsink_suite (void)
 {
@@ -134,6 +384,7 @@ curlsink_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_set_timeout (tc_chain, 20);
   tcase_add_test (tc_chain, test_properties);
+  tcase_add_test (tc_chain, test_resume_upload);
 
   return s;
 }
@@ -4,7 +4,12 @@
 
 #include <gst/check/gstcheck.h>
 #include <glib/gstdio.h>
+#include <gio/gio.h>
 #include <curl/curl.h>
+#include <string.h>
+
+#define NUM_BUFFERS 32
+#define BUFFER_SIZE 1000
 
 static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -118,7 +123,201 @@ GST_START_TEST (test_properties)
 
 GST_END_TEST;
 
-static Suite *
+/* A minimal HTTP/1.1 server storing the chunked body of each request */
+typedef struct
+{
+  GSocketService *service;
+  guint16 port;
+  GMutex lock;
+  GByteArray *body;
+  gint requests;
+} TestServer;
+
+static guint8
+pattern_byte (guint offset)
+{
+  return (guint8) (offset % 251);
+}
+
+static gboolean
+read_chunked_body (GDataInputStream * in, GByteArray * body)
+{
+  gchar *line;
+  gsize size, n;
+
+  while ((line = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+    size = g_ascii_strtoull (line, NULL, 16);
+    g_free (line);
+
+    if (size > 0) {
+      g_byte_array_set_size (body, body->len + size);
+      if (!g_input_stream_read_all (G_INPUT_STREAM (in),
+              body->data + body->len - size, size, &n, NULL, NULL)
+          || n != size)
+        return FALSE;
+    }
+
+    /* CRLF after the chunk data, or the end of the trailer */
+    line = g_data_input_stream_read_line (in, NULL, NULL, NULL);
+    if (line == NULL)
+      return FALSE;
+    g_free (line);
+
+    if (size == 0)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static gboolean
+serve_request (TestServer * server, GDataInputStream * in, GOutputStream * out)
+{
+  const gchar *reply = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+  const gchar *cont = "HTTP/1.1 100 Continue\r\n\r\n";
+  gboolean chunked = FALSE;
+  gboolean ret;
+  gchar *line;
+
+  line = g_data_input_stream_read_line (in, NULL, NULL, NULL);
+  if (line == NULL)
+    return FALSE;
+  g_free (line);
+
+  while ((line = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+    g_strchomp (line);
+    if (*line == '\0') {
+      g_free (line);
+      break;
+    }
+    if (g_ascii_strncasecmp (line, "Expect:", 7) == 0)
+      g_output_stream_write_all (out, cont, strlen (cont), NULL, NULL, NULL);
+    else if (g_ascii_strncasecmp (line, "Transfer-Encoding:", 18) == 0)
+      chunked = strstr (line, "chunked") != NULL;
+    g_free (line);
+  }
+  if (!chunked)
+    return FALSE;
+
+  g_mutex_lock (&server->lock);
+  server->requests++;
+  ret = read_chunked_body (in, server->body);
+  g_mutex_unlock (&server->lock);
+
+  return ret && g_output_stream_write_all (out, reply, strlen (reply), NULL,
+      NULL, NULL);
+}
+
+static gboolean
+server_run (GThreadedSocketService * service, GSocketConnection * connection,
+    GObject * source_object, TestServer * server)
+{
+  GDataInputStream *in;
+  GOutputStream *out;
+
+  in = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (connection)));
+  g_data_input_stream_set_newline_type (in, G_DATA_STREAM_NEWLINE_TYPE_CR_LF);
+  out = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+  while (serve_request (server, in, out));
+
+  g_object_unref (in);
+
+  return TRUE;
+}
+
+static TestServer *
+test_server_new (void)
+{
+  TestServer *server = g_new0 (TestServer, 1);
+  GError *err = NULL;
+
+  g_mutex_init (&server->lock);
+  server->body = g_byte_array_new ();
+  server->service = g_threaded_socket_service_new (4);
+  server->port =
+      g_socket_listener_add_any_inet_port (G_SOCKET_LISTENER
+      (server->service), NULL, &err);
+  fail_unless (server->port != 0, "Couldn't listen: %s",
+      err ? err->message : "");
+  g_signal_connect (server->service, "run", G_CALLBACK (server_run), server);
+  g_socket_service_start (server->service);
+
+  return server;
+}
+
+static void
+test_server_free (TestServer * server)
+{
+  g_socket_service_stop (server->service);
+  g_socket_listener_close (G_SOCKET_LISTENER (server->service));
+  g_object_unref (server->service);
+  g_byte_array_unref (server->body);
+  g_mutex_clear (&server->lock);
+  g_free (server);
+}
+
+static void
+push_pattern_buffer (guint offset)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint i;
+
+  buffer = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_WRITE));
+  for (i = 0; i < BUFFER_SIZE; i++)
+    map.data[i] = pattern_byte (offset + i);
+  gst_buffer_unmap (buffer, &map);
+
+  fail_unless_equals_int (gst_pad_push (srcpad, buffer), GST_FLOW_OK);
+}
+
+GST_START_TEST (test_queued_upload)
+{
+  TestServer *server = test_server_new ();
+  GstElement *sink;
+  GstCaps *caps;
+  gchar *location;
+  guint i;
+
+  sink = setup_curlhttpsink ();
+
+  location = g_strdup_printf ("http://127.0.0.1:%u/", server->port);
+  g_object_set (G_OBJECT (sink), "location", location, "file-name", "upload",
+      "queue-size", 4, NULL);
+  g_free (location);
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (srcpad, sink, caps, GST_FORMAT_BYTES);
+
+  /* the buffers are sent from the transfer thread in the background, one
+   * chunked POST for all of them */
+  for (i = 0; i < NUM_BUFFERS; i++)
+    push_pattern_buffer (i * BUFFER_SIZE);
+
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_eos ()));
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+
+  gst_caps_unref (caps);
+  cleanup_curlhttpsink (sink);
+
+  g_mutex_lock (&server->lock);
+  fail_unless_equals_int (server->requests, 1);
+  fail_unless_equals_int (server->body->len, NUM_BUFFERS * BUFFER_SIZE);
+  for (i = 0; i < NUM_BUFFERS * BUFFER_SIZE; i++) {
+    if (server->body->data[i] != pattern_byte (i))
+      fail ("Wrong data at offset %u", i);
+  }
+  g_mutex_unlock (&server->lock);
+
+  test_server_free (server);
+}
+
+GST_END_TEST;
+
 curlsink_suite (void)
 {
   Suite *s = suite_create ("curlhttpsink");
@@ -127,6 +326,7 @@ curlsink_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_set_timeout (tc_chain, 20);
   tcase_add_test (tc_chain, test_properties);
+  tcase_add_test (tc_chain, test_queued_upload);
 
   return s;
 }
@@ -0,0 +1,398 @@
+/*
+ * Unittest for curlhttpsrc
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gio/gio.h>
+#include <string.h>
+
+#include "../../ext/curl/gstcurlhttpsrc.h"
+
+#define RESOURCE_SIZE (1000 * 1000)
+#define N_LOOPS 2
+
+/* A minimal HTTP/1.1 server serving RESOURCE_SIZE bytes of a fixed pattern */
+typedef struct
+{
+  GSocketService *service;
+  guint16 port;
+  gboolean ranges;
+  gint requests;
+  gint range_requests;
+} TestServer;
+
+static guint8
+pattern_byte (guint64 offset)
+{
+  return (guint8) ((offset % 251) ^ (offset >> 16));
+}
+
+static gboolean
+parse_range (const gchar * value, guint64 * first, guint64 * last)
+{
+  gchar *end;
+
+  if (g_ascii_strncasecmp (value, "bytes=", 6) != 0)
+    return FALSE;
+  *first = g_ascii_strtoull (value + 6, &end, 10);
+  if (*end != '-')
+    return FALSE;
+  if (g_ascii_isdigit (end[1]))
+    *last = g_ascii_strtoull (end + 1, NULL, 10);
+  else
+    *last = RESOURCE_SIZE - 1;
+  if (*last >= RESOURCE_SIZE)
+    *last = RESOURCE_SIZE - 1;
+
+  return *first <= *last;
+}
+
+static gboolean
+serve_request (TestServer * server, GDataInputStream * in, GOutputStream * out)
+{
+  guint64 first = 0, last = RESOURCE_SIZE - 1, i;
+  gboolean ranged = FALSE;
+  gchar *line, *head;
+  guint8 *body;
+  gboolean ret;
+
+  line = g_data_input_stream_read_line (in, NULL, NULL, NULL);
+  if (line == NULL)
+    return FALSE;
+  g_free (line);
+
+  /* headers up to the empty line */
+  while ((line = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+    g_strchomp (line);
+    if (*line == '\0') {
+      g_free (line);
+      break;
+    }
+    if (g_ascii_strncasecmp (line, "Range:", 6) == 0) {
+      g_atomic_int_inc (&server->range_requests);
+      if (server->ranges)
+        ranged = parse_range (g_strstrip (line + 6), &first, &last);
+    }
+    g_free (line);
+  }
+  g_atomic_int_inc (&server->requests);
+
+  if (ranged) {
+    head = g_strdup_printf ("HTTP/1.1 206 Partial Content\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Range: bytes %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT
+        "/%d\r\nContent-Length: %" G_GUINT64_FORMAT "\r\n\r\n", first, last,
+        RESOURCE_SIZE, last - first + 1);
+  } else {
+    head = g_strdup_printf ("HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Length: %d\r\n\r\n", RESOURCE_SIZE);
+  }
+
+  body = g_malloc (last - first + 1);
+  for (i = first; i <= last; i++)
+    body[i - first] = pattern_byte (i);
+
+  ret = g_output_stream_write_all (out, head, strlen (head), NULL, NULL, NULL)
+      && g_output_stream_write_all (out, body, last - first + 1, NULL, NULL,
+      NULL);
+
+  g_free (head);
+  g_free (body);
+
+  return ret;
+}
+
+static gboolean
+server_run (GThreadedSocketService * service, GSocketConnection * connection,
+    GObject * source_object, TestServer * server)
+{
+  GDataInputStream *in;
+  GOutputStream *out;
+
+  in = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (connection)));
+  out = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+  /* keep-alive, serve until the client closes the connection */
+  while (serve_request (server, in, out));
+
+  g_object_unref (in);
+
+  return TRUE;
+}
+
+static TestServer *
+test_server_new (gboolean ranges)
+{
+  TestServer *server = g_new0 (TestServer, 1);
+  GError *err = NULL;
+
+  server->ranges = ranges;
+  server->service = g_threaded_socket_service_new (16);
+  server->port =
+      g_socket_listener_add_any_inet_port (G_SOCKET_LISTENER
+      (server->service), NULL, &err);
+  fail_unless (server->port != 0, "Couldn't listen: %s",
+      err ? err->message : "");
+  g_signal_connect (server->service, "run", G_CALLBACK (server_run), server);
+  g_socket_service_start (server->service);
+
+  return server;
+}
+
+static void
+test_server_free (TestServer * server)
+{
+  g_socket_service_stop (server->service);
+  g_socket_listener_close (G_SOCKET_LISTENER (server->service));
+  g_object_unref (server->service);
+  g_free (server);
+}
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad, GByteArray * data)
+{
+  GstMapInfo map;
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  g_byte_array_append (data, map.data, map.size);
+  gst_buffer_unmap (buf, &map);
+}
+
+/* Runs curlhttpsrc against @server and checks the received body */
+static GstStructure *
+fetch_resource (TestServer * server, guint parallel_ranges, guint range_size)
+{
+  GstElement *pipeline, *src, *sink;
+  GByteArray *data = g_byte_array_new ();
+  GstStructure *stats;
+  GstMessage *msg;
+  gchar *uri;
+  guint64 i;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("curlhttpsrc", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (src != NULL && sink != NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  uri = g_strdup_printf ("http://127.0.0.1:%u/resource", server->port);
+  g_object_set (src, "location", uri, "proxy", NULL,
+      "parallel-ranges", parallel_ranges, NULL);
+  if (range_size)
+    g_object_set (src, "range-size", range_size, NULL);
+  g_free (uri);
+
+  g_object_set (sink, "signal-handoffs", TRUE, "sync", FALSE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), data);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      10 * GST_SECOND, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL, "No EOS");
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  g_object_get (src, "stats", &stats, NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  fail_unless_equals_int (data->len, RESOURCE_SIZE);
+  for (i = 0; i < RESOURCE_SIZE; i++) {
+    if (data->data[i] != pattern_byte (i))
+      fail ("Wrong data at offset %" G_GUINT64_FORMAT, i);
+  }
+  g_byte_array_unref (data);
+
+  return stats;
+}
+
+GST_START_TEST (test_single_stream)
+{
+  TestServer *server = test_server_new (TRUE);
+  GstStructure *stats;
+  guint64 bytes;
+
+  stats = fetch_resource (server, 1, 0);
+  fail_unless_equals_int (g_atomic_int_get (&server->requests), 1);
+  fail_unless_equals_int (g_atomic_int_get (&server->range_requests), 0);
+
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-received", &bytes));
+  fail_unless_equals_uint64 (bytes, RESOURCE_SIZE);
+  gst_structure_free (stats);
+
+  test_server_free (server);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parallel_ranges)
+{
+  TestServer *server = test_server_new (TRUE);
+  GstStructure *stats;
+  guint64 bytes;
+
+  /* 16 ranges of 64 KiB, the last one shorter */
+  stats = fetch_resource (server, 4, 64 * 1024);
+  fail_unless_equals_int (g_atomic_int_get (&server->requests), 16);
+  fail_unless_equals_int (g_atomic_int_get (&server->range_requests), 16);
+
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-received", &bytes));
+  fail_unless_equals_uint64 (bytes, RESOURCE_SIZE);
+  gst_structure_free (stats);
+
+  test_server_free (server);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ranges_unsupported)
+{
+  TestServer *server = test_server_new (FALSE);
+  GstStructure *stats;
+
+  /* The server ignores the range and sends everything in the first reply */
+  stats = fetch_resource (server, 4, 64 * 1024);
+  fail_unless_equals_int (g_atomic_int_get (&server->requests), 1);
+  fail_unless_equals_int (g_atomic_int_get (&server->range_requests), 1);
+  gst_structure_free (stats);
+
+  test_server_free (server);
+}
+
+GST_END_TEST;
+
+static gint
+get_loop_thread (GstElement * src)
+{
+  GstStructure *stats;
+  gint loop;
+
+  g_object_get (src, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_int (stats, "loop-thread", &loop));
+  gst_structure_free (stats);
+
+  return loop;
+}
+
+static void
+check_loop (GstCurlHttpSrcClass * klass, guint loop, guint users)
+{
+  GstCurlHttpSrcMultiTaskContext *context = &klass->multi_task_contexts[loop];
+
+  g_mutex_lock (&context->mutex);
+  fail_unless_equals_int (context->refcount, users);
+  if (users > 0) {
+    fail_unless (context->task != NULL);
+    fail_unless_equals_int (gst_task_get_state (context->task),
+        GST_TASK_STARTED);
+  } else {
+    fail_unless (context->task == NULL, "Loop %u still has a task", loop);
+  }
+  g_mutex_unlock (&context->mutex);
+}
+
+GST_START_TEST (test_multi_loops)
+{
+  TestServer *server = test_server_new (TRUE);
+  GstCurlHttpSrcClass *klass;
+  GstElement *srcs[5];
+  GstStructure *stats;
+  gint loop;
+  guint i;
+
+  for (i = 0; i < 4; i++) {
+    srcs[i] = gst_element_factory_make ("curlhttpsrc", NULL);
+    fail_unless (srcs[i] != NULL);
+    /* The loop is picked when going to READY */
+    fail_unless_equals_int (get_loop_thread (srcs[i]), -1);
+    fail_unless_equals_int (gst_element_set_state (srcs[i], GST_STATE_READY),
+        GST_STATE_CHANGE_SUCCESS);
+  }
+
+  klass = (GstCurlHttpSrcClass *) G_OBJECT_GET_CLASS (srcs[0]);
+  fail_unless_equals_int (klass->n_multi_task_contexts, N_LOOPS);
+
+  /* Each source goes to the loop with the fewest users */
+  fail_unless_equals_int (get_loop_thread (srcs[0]), 0);
+  fail_unless_equals_int (get_loop_thread (srcs[1]), 1);
+  fail_unless_equals_int (get_loop_thread (srcs[2]), 0);
+  fail_unless_equals_int (get_loop_thread (srcs[3]), 1);
+  check_loop (klass, 0, 2);
+  check_loop (klass, 1, 2);
+
+  /* A loop keeps running until its last user goes away */
+  gst_element_set_state (srcs[0], GST_STATE_NULL);
+  fail_unless_equals_int (get_loop_thread (srcs[0]), -1);
+  check_loop (klass, 0, 1);
+  gst_element_set_state (srcs[2], GST_STATE_NULL);
+  check_loop (klass, 0, 0);
+  check_loop (klass, 1, 2);
+
+  /* The next source restarts the idle loop */
+  srcs[4] = gst_element_factory_make ("curlhttpsrc", NULL);
+  fail_unless_equals_int (gst_element_set_state (srcs[4], GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (get_loop_thread (srcs[4]), 0);
+  check_loop (klass, 0, 1);
+
+  /* and transfers still go through it */
+  stats = fetch_resource (server, 1, 0);
+  fail_unless (gst_structure_get_int (stats, "loop-thread", &loop));
+  fail_unless_equals_int (loop, 0);
+  gst_structure_free (stats);
+  check_loop (klass, 0, 1);
+
+  for (i = 0; i < 5; i++) {
+    gst_element_set_state (srcs[i], GST_STATE_NULL);
+    gst_object_unref (srcs[i]);
+  }
+  check_loop (klass, 0, 0);
+  check_loop (klass, 1, 0);
+
+  test_server_free (server);
+}
+
+GST_END_TEST;
+
+static Suite *
+curlhttpsrc_suite (void)
+{
+  Suite *s = suite_create ("curlhttpsrc");
+  TCase *tc_chain = tcase_create ("general");
+
+  /* Read when the element class is initialised, in the first test */
+  g_setenv ("GST_CURL_LOOP_THREADS", G_STRINGIFY (N_LOOPS), TRUE);
+
+  suite_add_tcase (s, tc_chain);
+  tcase_set_timeout (tc_chain, 20);
+  tcase_add_test (tc_chain, test_single_stream);
+  tcase_add_test (tc_chain, test_parallel_ranges);
+  tcase_add_test (tc_chain, test_ranges_unsupported);
+  tcase_add_test (tc_chain, test_multi_loops);
+
+  return s;
+}
+
+GST_CHECK_MAIN (curlhttpsrc);
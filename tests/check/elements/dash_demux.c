@@ -1520,6 +1520,173 @@ GST_START_TEST (testContentProtection)
 
 GST_END_TEST;
 
+/* A SIDX box of 4 subsegments of 1000 bytes and 1 second, at the start of
+ * both representations of testSidxCacheSwitch */
+static const guint8 sidx_cache_test_sidx[] = {
+  0x00, 0x00, 0x00, 0x50, 's', 'i', 'd', 'x',
+  0x00, 0x00, 0x00, 0x00,       /* version 0, no flags */
+  0x00, 0x00, 0x00, 0x01,       /* reference ID */
+  0x00, 0x00, 0x03, 0xe8,       /* timescale 1000 */
+  0x00, 0x00, 0x00, 0x00,       /* earliest presentation time */
+  0x00, 0x00, 0x00, 0x00,       /* first offset */
+  0x00, 0x00, 0x00, 0x04,       /* reserved, reference count */
+  0x00, 0x00, 0x03, 0xe8, 0x00, 0x00, 0x03, 0xe8, 0x90, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x03, 0xe8, 0x00, 0x00, 0x03, 0xe8, 0x90, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x03, 0xe8, 0x00, 0x00, 0x03, 0xe8, 0x90, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x03, 0xe8, 0x00, 0x00, 0x03, 0xe8, 0x90, 0x00, 0x00, 0x00,
+};
+
+#define SIDX_CACHE_TEST_SIZE (sizeof (sidx_cache_test_sidx) + 4 * 1000)
+
+typedef struct
+{
+  GstElement *demux;
+  gint low_index_downloads;
+  gint high_index_downloads;
+  gboolean switched_up;
+  gboolean switched_down;
+} SidxCacheTestState;
+
+static SidxCacheTestState sidx_cache_test_state;
+
+static void
+testSidxCachePreTest (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  sidx_cache_test_state.demux = engine->demux;
+  g_object_set (engine->demux, "connection-speed", 150, NULL);
+}
+
+/* Serves the SIDX at the start of the files and counts its downloads. Asks
+ * for the high bandwidth representation once the media of the low one is
+ * downloaded, and for the low one again once the high one is */
+static GstFlowReturn
+testSidxCacheSrcCreate (GstTestHTTPSrc * src, guint64 offset, guint length,
+    GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  const GstDashDemuxTestInputData *input =
+      (const GstDashDemuxTestInputData *) context;
+  gboolean high = g_str_has_suffix (input->uri, "high.webm");
+  GstFlowReturn ret;
+
+  ret = gst_dashdemux_http_src_create (src, offset, length, retbuf, context,
+      user_data);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  if (offset < sizeof (sidx_cache_test_sidx)) {
+    if (offset == 0)
+      g_atomic_int_inc (high ? &sidx_cache_test_state.high_index_downloads :
+          &sidx_cache_test_state.low_index_downloads);
+    gst_buffer_fill (*retbuf, 0, sidx_cache_test_sidx + offset,
+        MIN (length, sizeof (sidx_cache_test_sidx) - offset));
+  } else if (!high && !sidx_cache_test_state.switched_up) {
+    sidx_cache_test_state.switched_up = TRUE;
+    g_object_set (sidx_cache_test_state.demux, "connection-speed", 10000,
+        NULL);
+  } else if (high && !sidx_cache_test_state.switched_down) {
+    sidx_cache_test_state.switched_down = TRUE;
+    g_object_set (sidx_cache_test_state.demux, "connection-speed", 150, NULL);
+  }
+
+  return GST_FLOW_OK;
+}
+
+static void
+testSidxCacheCheckEOS (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  GstAdaptiveDemuxTestCase *testData = GST_ADAPTIVE_DEMUX_TEST_CASE (user_data);
+
+  /* all subsegments and at least the index of the first representation */
+  fail_unless (stream->total_received_size >= SIDX_CACHE_TEST_SIZE);
+
+  testData->count_of_finished_streams++;
+  g_main_loop_quit (engine->loop);
+}
+
+/*
+ * Test that the index of a representation is restored from the cache when
+ * switching back to it, instead of being downloaded again
+ *
+ */
+GST_START_TEST (testSidxCacheSwitch)
+{
+  const gchar *mpd =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<MPD xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+      "     xmlns=\"urn:mpeg:DASH:schema:MPD:2011\""
+      "     xsi:schemaLocation=\"urn:mpeg:DASH:schema:MPD:2011 DASH-MPD.xsd\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-on-demand:2011\""
+      "     type=\"static\""
+      "     minBufferTime=\"PT1.500S\""
+      "     mediaPresentationDuration=\"PT4S\">"
+      "  <Period>"
+      "    <AdaptationSet mimeType=\"audio/webm\""
+      "                   subsegmentAlignment=\"true\">"
+      "      <Representation id=\"low\""
+      "                      codecs=\"vorbis\""
+      "                      audioSamplingRate=\"44100\""
+      "                      startWithSAP=\"1\""
+      "                      bandwidth=\"100000\">"
+      "        <BaseURL>low.webm</BaseURL>"
+      "        <SegmentBase indexRange=\"0-79\""
+      "                     indexRangeExact=\"true\" />"
+      "      </Representation>"
+      "      <Representation id=\"high\""
+      "                      codecs=\"vorbis\""
+      "                      audioSamplingRate=\"44100\""
+      "                      startWithSAP=\"1\""
+      "                      bandwidth=\"1000000\">"
+      "        <BaseURL>high.webm</BaseURL>"
+      "        <SegmentBase indexRange=\"0-79\""
+      "                     indexRangeExact=\"true\" />"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  GstDashDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/test.mpd", (guint8 *) mpd, 0},
+    {"http://unit.test/low.webm", NULL, SIDX_CACHE_TEST_SIZE},
+    {"http://unit.test/high.webm", NULL, SIDX_CACHE_TEST_SIZE},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"audio_00", SIDX_CACHE_TEST_SIZE, NULL},
+  };
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstTestHTTPSrcTestData http_src_test_data = { 0 };
+  GstAdaptiveDemuxTestCallbacks test_callbacks = { 0 };
+  GstDashDemuxTestCase *testData;
+
+  memset (&sidx_cache_test_state, 0, sizeof (sidx_cache_test_state));
+
+  http_src_callbacks.src_start = gst_dashdemux_http_src_start;
+  http_src_callbacks.src_create = testSidxCacheSrcCreate;
+  http_src_test_data.input = inputTestData;
+  gst_test_http_src_install_callbacks (&http_src_callbacks,
+      &http_src_test_data);
+
+  test_callbacks.pre_test = testSidxCachePreTest;
+  test_callbacks.appsink_eos = testSidxCacheCheckEOS;
+
+  testData = gst_dash_demux_test_case_new ();
+  COPY_OUTPUT_TEST_DATA (outputTestData, testData);
+
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME, "http://unit.test/test.mpd",
+      &test_callbacks, testData);
+
+  fail_unless (sidx_cache_test_state.switched_up);
+  fail_unless (sidx_cache_test_state.switched_down);
+  /* the index of the low representation was only downloaded before the
+   * first switch, the high one by the prefetch and/or the switch to it */
+  fail_unless_equals_int (sidx_cache_test_state.low_index_downloads, 1);
+  fail_unless (sidx_cache_test_state.high_index_downloads >= 1);
+
+  g_object_unref (testData);
+  if (http_src_test_data.data)
+    gst_structure_free (http_src_test_data.data);
+}
+
+GST_END_TEST;
+
 static Suite *
 dash_demux_suite (void)
 {
@@ -1545,6 +1712,7 @@ dash_demux_suite (void)
   tcase_add_test (tc_basicTest, testMediaDownloadErrorMiddleFragment);
   tcase_add_test (tc_basicTest, testQuery);
   tcase_add_test (tc_basicTest, testContentProtection);
+  tcase_add_test (tc_basicTest, testSidxCacheSwitch);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
@@ -4253,6 +4253,96 @@ GST_START_TEST (dash_mpdparser_headers)
 
 GST_END_TEST;
 
+/*
+ * Test getting the index of a representation other than the active one
+ *
+ */
+GST_START_TEST (dash_mpdparser_representation_index)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstRepresentationNode *representation;
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-on-demand:2011\""
+      "     mediaPresentationDuration=\"P0Y0M0DT3H3M30S\">"
+      "  <BaseURL>http://example.com/</BaseURL>"
+      "  <Period id=\"Period0\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <BaseURL>low.mp4</BaseURL>"
+      "        <SegmentBase indexRange=\"10-20\">"
+      "        </SegmentBase>"
+      "      </Representation>"
+      "      <Representation id=\"2\" bandwidth=\"500000\">"
+      "        <BaseURL>high.mp4</BaseURL>"
+      "        <SegmentBase indexRange=\"30-40\">"
+      "        </SegmentBase>"
+      "      </Representation>"
+      "      <Representation id=\"3\" bandwidth=\"750000\">"
+      "        <BaseURL>noindex.mp4</BaseURL>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  gboolean ret;
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  /* process the xml data */
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  /* get the list of adaptation sets of the first period */
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+
+  /* setup streaming from the first adaptation set */
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_string (activeStream->cur_representation->id, "1");
+
+  /* the index of the second representation resolves against its own
+   * BaseURL, not the one of the active representation */
+  representation = g_list_nth_data (adapt_set->Representations, 1);
+  ret =
+      gst_mpd_client_get_representation_index (mpdclient, activeStream,
+      representation, &uri, &range_start, &range_end);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (uri, "http://example.com/high.mp4");
+  assert_equals_int64 (range_start, 30);
+  assert_equals_int64 (range_end, 40);
+  g_free (uri);
+
+  /* the active stream is left untouched */
+  assert_equals_string (activeStream->cur_representation->id, "1");
+
+  /* no indexRange, nothing to prefetch */
+  representation = g_list_nth_data (adapt_set->Representations, 2);
+  ret =
+      gst_mpd_client_get_representation_index (mpdclient, activeStream,
+      representation, &uri, &range_start, &range_end);
+  assert_equals_int (ret, FALSE);
+  fail_unless (uri == NULL);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test handling fragments
  *
@@ -5995,6 +6085,7 @@ dash_suite (void)
   tcase_add_test (tc_complexMPD, dash_mpdparser_get_streamPresentationOffset);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segments);
   tcase_add_test (tc_complexMPD, dash_mpdparser_headers);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_representation_index);
   tcase_add_test (tc_complexMPD, dash_mpdparser_fragments);
   tcase_add_test (tc_complexMPD, dash_mpdparser_inherited_segmentBase);
   tcase_add_test (tc_complexMPD, dash_mpdparser_inherited_segmentURL);
@@ -0,0 +1,217 @@
+/* GStreamer
+ *
+ * unit test for the detection worker of the opencv plugin
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+#include "../../ext/opencv/detectionworker.hpp"
+
+/* The analysis of the tests reports the first pixel of the frame as the x
+ * of a region, and can be held back to let frames pile up */
+static GMutex analysis_lock;
+static GCond analysis_cond;
+static gboolean analysis_blocked;
+static gboolean analysis_running;
+static GArray *analysed_pts;
+
+static void
+test_analysis (GstElement * element, GstBuffer * info, cv::Mat & frame)
+{
+  GstClockTime pts = GST_BUFFER_PTS (info);
+
+  g_mutex_lock (&analysis_lock);
+  analysis_running = TRUE;
+  g_cond_broadcast (&analysis_cond);
+  while (analysis_blocked)
+    g_cond_wait (&analysis_cond, &analysis_lock);
+  analysis_running = FALSE;
+  g_array_append_val (analysed_pts, pts);
+  g_mutex_unlock (&analysis_lock);
+
+  gst_buffer_add_video_region_of_interest_meta (info, "test",
+      frame.at<guchar> (0, 0), 0, 1, 1);
+}
+
+static void
+setup_analysis (void)
+{
+  analysis_blocked = FALSE;
+  analysis_running = FALSE;
+  analysed_pts = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+}
+
+static void
+cleanup_analysis (void)
+{
+  g_array_free (analysed_pts, TRUE);
+  analysed_pts = NULL;
+}
+
+static void
+push_frame (GstDetectionWorker * worker, GstClockTime pts, guchar value)
+{
+  cv::Mat frame (4, 4, CV_8UC1, cv::Scalar (value));
+  GstBuffer *buf = gst_buffer_new ();
+
+  GST_BUFFER_PTS (buf) = pts;
+  gst_detection_worker_push (worker, buf, frame);
+  gst_buffer_unref (buf);
+}
+
+/* Attaches the result to a buffer of @pts, returns the x of its region or
+ * -1 if nothing was attached */
+static gint
+attach_result (GstDetectionWorker * worker, GstClockTime pts,
+    GstClockTime max_latency)
+{
+  GstBuffer *buf = gst_buffer_new ();
+  GstVideoRegionOfInterestMeta *meta;
+  gint x = -1;
+
+  GST_BUFFER_PTS (buf) = pts;
+  if (gst_detection_worker_attach (worker, buf, max_latency) > 0) {
+    meta = gst_buffer_get_video_region_of_interest_meta_id (buf, 0);
+    fail_unless (meta != NULL);
+    x = meta->x;
+  }
+  gst_buffer_unref (buf);
+
+  return x;
+}
+
+/* The result is stored right after the analysis returns, poll for it */
+static void
+wait_for_result (GstDetectionWorker * worker, GstClockTime pts, gint x)
+{
+  while (attach_result (worker, pts, GST_CLOCK_TIME_NONE) != x)
+    g_usleep (1000);
+}
+
+/* Frames that come in while the worker is busy replace each other, the
+ * worker continues with the newest one */
+GST_START_TEST (test_newest_frame_wins)
+{
+  GstElement *element = gst_element_factory_make ("identity", NULL);
+  GstDetectionWorker *worker;
+
+  setup_analysis ();
+  worker = gst_detection_worker_new (element, test_analysis);
+  fail_unless (worker != NULL);
+
+  g_mutex_lock (&analysis_lock);
+  analysis_blocked = TRUE;
+  g_mutex_unlock (&analysis_lock);
+
+  push_frame (worker, 0, 10);
+  g_mutex_lock (&analysis_lock);
+  while (!analysis_running)
+    g_cond_wait (&analysis_cond, &analysis_lock);
+  g_mutex_unlock (&analysis_lock);
+
+  /* the first frame is being analysed, these wait for the worker */
+  push_frame (worker, 40 * GST_MSECOND, 20);
+  push_frame (worker, 80 * GST_MSECOND, 30);
+  push_frame (worker, 120 * GST_MSECOND, 40);
+
+  g_mutex_lock (&analysis_lock);
+  analysis_blocked = FALSE;
+  g_cond_broadcast (&analysis_cond);
+  g_mutex_unlock (&analysis_lock);
+
+  wait_for_result (worker, 120 * GST_MSECOND, 40);
+
+  g_mutex_lock (&analysis_lock);
+  fail_unless_equals_int (analysed_pts->len, 2);
+  fail_unless_equals_uint64 (g_array_index (analysed_pts, GstClockTime, 0), 0);
+  fail_unless_equals_uint64 (g_array_index (analysed_pts, GstClockTime, 1),
+      120 * GST_MSECOND);
+  g_mutex_unlock (&analysis_lock);
+
+  /* a reset drops the result */
+  gst_detection_worker_reset (worker);
+  fail_unless_equals_int (attach_result (worker, 120 * GST_MSECOND,
+          GST_CLOCK_TIME_NONE), -1);
+
+  gst_detection_worker_free (worker);
+  gst_object_unref (element);
+  cleanup_analysis ();
+}
+
+GST_END_TEST;
+
+/* The result is only attached to frames that are not older than it and at
+ * most max-latency newer */
+GST_START_TEST (test_max_latency)
+{
+  GstElement *element = gst_element_factory_make ("identity", NULL);
+  GstDetectionWorker *worker;
+  GstClockTime pts = 100 * GST_MSECOND;
+
+  setup_analysis ();
+  worker = gst_detection_worker_new (element, test_analysis);
+  fail_unless (worker != NULL);
+
+  push_frame (worker, pts, 10);
+  wait_for_result (worker, pts, 10);
+
+  fail_unless_equals_int (attach_result (worker, pts +
+          GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY,
+          GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY), 10);
+  fail_unless_equals_int (attach_result (worker, pts +
+          GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY + 1,
+          GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY), -1);
+  fail_unless_equals_int (attach_result (worker, pts + 20 * GST_MSECOND,
+          10 * GST_MSECOND), -1);
+  fail_unless_equals_int (attach_result (worker, pts + 20 * GST_MSECOND,
+          20 * GST_MSECOND), 10);
+  /* the result of a later frame, e.g. after a seek back */
+  fail_unless_equals_int (attach_result (worker, pts - 1,
+          GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY), -1);
+  /* without timestamps there is nothing to compare */
+  fail_unless_equals_int (attach_result (worker, GST_CLOCK_TIME_NONE,
+          GST_DETECTION_WORKER_DEFAULT_MAX_LATENCY), 10);
+
+  gst_detection_worker_free (worker);
+  gst_object_unref (element);
+  cleanup_analysis ();
+}
+
+GST_END_TEST;
+
+static Suite *
+detectionworker_suite (void)
+{
+  Suite *s = suite_create ("detectionworker");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_newest_frame_wins);
+  tcase_add_test (tc_chain, test_max_latency);
+
+  return s;
+}
+
+GST_CHECK_MAIN (detectionworker);
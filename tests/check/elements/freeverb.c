@@ -0,0 +1,370 @@
+/* GStreamer
+ *
+ * unit test for freeverb
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/audio/audio.h>
+
+#include <float.h>
+#include <math.h>
+
+/* The element sums the combs in a different order than the reference and
+ * flushes denormals, so it may be off by a few rounding errors */
+#define TOLERANCE 1.5e-7
+
+#define NUM_COMBS 8
+#define NUM_ALLPASSES 4
+#define STEREO_SPREAD 23
+
+static const gint comb_tuning[NUM_COMBS] = {
+  1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617
+};
+
+static const gint allpass_tuning[NUM_ALLPASSES] = { 556, 441, 341, 225 };
+
+/* Buffer sizes, in frames, that cross the processing blocks and the ends
+ * of the delay lines at different places */
+static const guint buffer_sizes[] = { 1, 63, 64, 65, 225, 1000, 4096, 441, 3 };
+
+/* The reference: the original Freeverb, one sample and one filter at a time
+ * and without a DC offset */
+
+typedef struct
+{
+  gfloat feedback;
+  gfloat filterstore;
+  gfloat damp1, damp2;
+  gfloat *buffer;
+  gint bufsize;
+  gint bufidx;
+} RefComb;
+
+typedef struct
+{
+  gfloat feedback;
+  gfloat *buffer;
+  gint bufsize;
+  gint bufidx;
+} RefAllpass;
+
+typedef struct
+{
+  RefComb combL[NUM_COMBS], combR[NUM_COMBS];
+  RefAllpass allpassL[NUM_ALLPASSES], allpassR[NUM_ALLPASSES];
+  gfloat gain;
+  gfloat wet1, wet2, dry;
+} RefModel;
+
+static void
+ref_comb_init (RefComb * comb, gint size, gfloat feedback, gfloat damp)
+{
+  comb->feedback = feedback;
+  comb->filterstore = 0;
+  comb->damp1 = damp;
+  comb->damp2 = 1 - damp;
+  comb->bufsize = MAX (size, 1);
+  comb->bufidx = 0;
+  comb->buffer = g_new0 (gfloat, comb->bufsize);
+}
+
+static gfloat
+ref_comb_process (RefComb * comb, gfloat input)
+{
+  gfloat output = comb->buffer[comb->bufidx];
+
+  comb->filterstore = (output * comb->damp2) +
+      (comb->filterstore * comb->damp1);
+  comb->buffer[comb->bufidx] = input + (comb->filterstore * comb->feedback);
+  if (++comb->bufidx >= comb->bufsize)
+    comb->bufidx = 0;
+
+  return output;
+}
+
+static void
+ref_allpass_init (RefAllpass * allpass, gint size)
+{
+  allpass->feedback = 0.5f;
+  allpass->bufsize = MAX (size, 1);
+  allpass->bufidx = 0;
+  allpass->buffer = g_new0 (gfloat, allpass->bufsize);
+}
+
+static gfloat
+ref_allpass_process (RefAllpass * allpass, gfloat input)
+{
+  gfloat bufout = allpass->buffer[allpass->bufidx];
+
+  allpass->buffer[allpass->bufidx] = input + (bufout * allpass->feedback);
+  if (++allpass->bufidx >= allpass->bufsize)
+    allpass->bufidx = 0;
+
+  return bufout - input;
+}
+
+/* Sets up @model like the element with these property values */
+static void
+ref_model_init (RefModel * model, gint rate, gfloat room_size,
+    gfloat damping, gfloat width, gfloat level)
+{
+  gfloat srfactor = rate / 44100.0f;
+  gfloat feedback = room_size * 0.28f + 0.7f;
+  gfloat wet = level;
+  gint i;
+
+  for (i = 0; i < NUM_COMBS; i++) {
+    ref_comb_init (&model->combL[i], comb_tuning[i] * srfactor, feedback,
+        damping);
+    ref_comb_init (&model->combR[i], (comb_tuning[i] + STEREO_SPREAD) *
+        srfactor, feedback, damping);
+  }
+  for (i = 0; i < NUM_ALLPASSES; i++) {
+    ref_allpass_init (&model->allpassL[i], allpass_tuning[i] * srfactor);
+    ref_allpass_init (&model->allpassR[i], (allpass_tuning[i] +
+            STEREO_SPREAD) * srfactor);
+  }
+
+  model->gain = 0.015f;
+  model->wet1 = wet * (width / 2.0f + 0.5f);
+  model->wet2 = wet * ((1.0f - width) / 2.0f);
+  model->dry = 1.0 - level;
+}
+
+static void
+ref_model_clear (RefModel * model)
+{
+  gint i;
+
+  for (i = 0; i < NUM_COMBS; i++) {
+    g_free (model->combL[i].buffer);
+    g_free (model->combR[i].buffer);
+  }
+  for (i = 0; i < NUM_ALLPASSES; i++) {
+    g_free (model->allpassL[i].buffer);
+    g_free (model->allpassR[i].buffer);
+  }
+}
+
+/* Runs one frame through the reverb. For mono input @in_l and @in_r are
+ * the same sample */
+static void
+ref_model_process (RefModel * model, gfloat in_l, gfloat in_r,
+    gboolean mono, gfloat * out_l, gfloat * out_r)
+{
+  gfloat input_l, input_r, wet_l = 0, wet_r = 0;
+  gint i;
+
+  if (mono) {
+    input_l = input_r = 2.0f * in_l * model->gain;
+  } else {
+    input_l = in_l * model->gain;
+    input_r = in_r * model->gain;
+  }
+
+  for (i = 0; i < NUM_COMBS; i++) {
+    wet_l += ref_comb_process (&model->combL[i], input_l);
+    wet_r += ref_comb_process (&model->combR[i], input_r);
+  }
+  for (i = 0; i < NUM_ALLPASSES; i++) {
+    wet_l = ref_allpass_process (&model->allpassL[i], wet_l);
+    wet_r = ref_allpass_process (&model->allpassR[i], wet_r);
+  }
+
+  *out_l = wet_l * model->wet1 + wet_r * model->wet2 + in_l * model->dry;
+  *out_r = wet_r * model->wet1 + wet_l * model->wet2 + in_r * model->dry;
+}
+
+/* The element only flushes denormals while it processes a buffer, the
+ * calling thread has to get its floating point state back */
+static void
+check_denormals_kept (void)
+{
+  volatile gfloat tiny = FLT_MIN;
+
+  fail_unless (tiny / 4.0f > 0.0f);
+}
+
+static GstHarness *
+setup_freeverb (gint rate, gint channels)
+{
+  GstHarness *h = gst_harness_new ("freeverb");
+  gchar *caps;
+
+  caps = g_strdup_printf ("audio/x-raw, format=(string) %s, rate=(int) %d, "
+      "channels=(int) %d, layout=(string) interleaved",
+      GST_AUDIO_NE (F32), rate, channels);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+
+  return h;
+}
+
+/* Pushes @n_frames of @data through the element and compares the output
+ * with the reference, sample by sample */
+static void
+push_and_compare (GstHarness * h, RefModel * model, gint channels,
+    const gfloat * data, guint n_frames)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  const gfloat *out;
+  guint i;
+
+  buf = gst_buffer_new_wrapped (g_memdup (data,
+          n_frames * channels * sizeof (gfloat)),
+      n_frames * channels * sizeof (gfloat));
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  check_denormals_kept ();
+
+  buf = gst_harness_pull (h);
+  fail_unless (buf != NULL);
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, n_frames * 2 * sizeof (gfloat));
+  out = (const gfloat *) map.data;
+
+  for (i = 0; i < n_frames; i++) {
+    gfloat ref_l, ref_r;
+
+    if (channels == 1)
+      ref_model_process (model, data[i], data[i], TRUE, &ref_l, &ref_r);
+    else
+      ref_model_process (model, data[2 * i], data[2 * i + 1], FALSE, &ref_l,
+          &ref_r);
+
+    /* no fail_unless() per sample, it is too slow for this many */
+    if (G_UNLIKELY (fabs (out[2 * i] - ref_l) > TOLERANCE))
+      fail ("frame %u left: %g instead of %g", i, out[2 * i], ref_l);
+    if (G_UNLIKELY (fabs (out[2 * i + 1] - ref_r) > TOLERANCE))
+      fail ("frame %u right: %g instead of %g", i, out[2 * i + 1], ref_r);
+  }
+
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+}
+
+/* Pushes noise of up to +-0.5 in buffers of all the sizes until @n_frames
+ * went through, then @n_silent frames of silence for the tails */
+static void
+run_noise (GstHarness * h, RefModel * model, gint channels, guint n_frames,
+    guint n_silent)
+{
+  GRand *rand = g_rand_new_with_seed (channels);
+  gfloat *data = g_new (gfloat, 4096 * channels);
+  guint i, n, done, size = 0;
+
+  for (done = 0; done < n_frames + n_silent; done += n) {
+    n = buffer_sizes[size++ % G_N_ELEMENTS (buffer_sizes)];
+    for (i = 0; i < n * channels; i++) {
+      if (done + i / channels < n_frames)
+        data[i] = g_rand_double_range (rand, -0.5, 0.5);
+      else
+        data[i] = 0;
+    }
+    push_and_compare (h, model, channels, data, n);
+  }
+
+  g_free (data);
+  g_rand_free (rand);
+}
+
+GST_START_TEST (test_stereo)
+{
+  GstHarness *h = setup_freeverb (44100, 2);
+  RefModel model;
+
+  ref_model_init (&model, 44100, 0.5f, 0.2f, 1.0f, 0.5f);
+  run_noise (h, &model, 2, 2 * 44100, 0);
+
+  ref_model_clear (&model);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_stereo_narrow)
+{
+  GstHarness *h = setup_freeverb (44100, 2);
+  RefModel model;
+
+  g_object_set (h->element, "room-size", 0.9f, "damping", 0.6f,
+      "width", 0.3f, "level", 0.8f, NULL);
+  ref_model_init (&model, 44100, 0.9f, 0.6f, 0.3f, 0.8f);
+  run_noise (h, &model, 2, 44100, 0);
+
+  ref_model_clear (&model);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* other rates scale the delay lines */
+GST_START_TEST (test_mono)
+{
+  GstHarness *h = setup_freeverb (48000, 1);
+  RefModel model;
+
+  ref_model_init (&model, 48000, 0.5f, 0.2f, 1.0f, 0.5f);
+  run_noise (h, &model, 1, 2 * 48000, 0);
+
+  ref_model_clear (&model);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* A short burst and a long silence, so the tails go down into denormals.
+ * The small rate keeps the delay lines short and the tails quick */
+GST_START_TEST (test_decay)
+{
+  GstHarness *h = setup_freeverb (8000, 2);
+  RefModel model;
+
+  g_object_set (h->element, "room-size", 0.0f, "damping", 0.0f, NULL);
+  ref_model_init (&model, 8000, 0.0f, 0.0f, 1.0f, 0.5f);
+  run_noise (h, &model, 2, 1000, 60000);
+
+  ref_model_clear (&model);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+freeverb_suite (void)
+{
+  Suite *s = suite_create ("freeverb");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_stereo);
+  tcase_add_test (tc_chain, test_stereo_narrow);
+  tcase_add_test (tc_chain, test_mono);
+  tcase_add_test (tc_chain, test_decay);
+
+  return s;
+}
+
+GST_CHECK_MAIN (freeverb);
@@ -726,6 +726,221 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+/* Key unit trick modes use the I-frame variants of this master playlist.
+ * Every media playlist has @n_fragments fragments of @duration seconds,
+ * named after the playlist. */
+static const gchar *iframe_test_playlists[] = {
+  "1000", "2000", "iframe-100", "iframe-300", "iframe-800"
+};
+
+static GstHlsDemuxTestInputData *
+create_iframe_test_input (guint n_fragments, const gchar * duration)
+{
+  GstHlsDemuxTestInputData *input;
+  guint n_playlists = G_N_ELEMENTS (iframe_test_playlists);
+  guint i, j, k = 0;
+
+  input = g_new0 (GstHlsDemuxTestInputData,
+      2 + n_playlists * (n_fragments + 1));
+
+  input[k].uri = g_strdup ("http://unit.test/master.m3u8");
+  input[k++].payload = (guint8 *) g_strdup ("#EXTM3U\n"
+      "#EXT-X-VERSION:4\n"
+      "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=1000000\n"
+      "1000.m3u8\n"
+      "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=2000000\n"
+      "2000.m3u8\n"
+      "#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=100000,URI=\"iframe-100.m3u8\"\n"
+      "#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=300000,URI=\"iframe-300.m3u8\"\n"
+      "#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=800000,URI=\"iframe-800.m3u8\"\n");
+
+  for (i = 0; i < n_playlists; i++) {
+    const gchar *name = iframe_test_playlists[i];
+    GString *playlist = g_string_new ("#EXTM3U\n"
+        "#EXT-X-VERSION:4\n" "#EXT-X-TARGETDURATION:1\n");
+
+    if (g_str_has_prefix (name, "iframe"))
+      g_string_append (playlist, "#EXT-X-I-FRAMES-ONLY\n");
+
+    for (j = 0; j < n_fragments; j++) {
+      g_string_append_printf (playlist, "#EXTINF:%s,Test\n%s-%03u.ts\n",
+          duration, name, j + 1);
+      input[k].uri = g_strdup_printf ("http://unit.test/%s-%03u.ts", name,
+          j + 1);
+      input[k++].size = 30 * TS_PACKET_LEN;
+    }
+    g_string_append (playlist, "#EXT-X-ENDLIST\n");
+
+    input[k].uri = g_strdup_printf ("http://unit.test/%s.m3u8", name);
+    input[k++].payload = (guint8 *) g_string_free (playlist, FALSE);
+  }
+
+  return input;
+}
+
+static void
+free_iframe_test_input (GstHlsDemuxTestInputData * input)
+{
+  guint i;
+
+  for (i = 0; input[i].uri; i++) {
+    if (!g_str_has_suffix (input[i].uri, ".ts"))
+      g_free ((gpointer) input[i].payload);
+    g_free ((gpointer) input[i].uri);
+  }
+  g_free (input);
+}
+
+static guint
+count_requests (const GstHlsDemuxTestCase * test_case, const gchar * prefix)
+{
+  const GValue *requests;
+  guint i, n = 0;
+
+  requests = gst_structure_get_value (test_case->state, "requests");
+  fail_unless (requests != NULL);
+  for (i = 0; i < gst_value_array_get_size (requests); i++) {
+    const GValue *uri = gst_value_array_get_value (requests, i);
+
+    if (g_str_has_prefix (g_value_get_string (uri), prefix))
+      n++;
+  }
+
+  return n;
+}
+
+/* 1.5 Mbps, the 1000 variant is used until the seek */
+static void
+iframe_test_set_connection_speed (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  g_object_set (engine->demux, "connection-speed", 1500, NULL);
+}
+
+static GstEvent *
+new_key_units_seek (gdouble rate)
+{
+  return gst_event_new_seek (rate, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_TRICKMODE |
+      GST_SEEK_FLAG_TRICKMODE_KEY_UNITS, GST_SEEK_TYPE_SET, 0,
+      GST_SEEK_TYPE_NONE, 0);
+}
+
+/*
+ * Test that a key unit trick mode seek switches straight to the I-frame
+ * variant matching the bitrate divided by the rate
+ */
+GST_START_TEST (testKeyUnitsIFrameVariant)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  GstHlsDemuxTestInputData *inputTestData = create_iframe_test_input (4, "1");
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 4 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = iframe_test_set_connection_speed;
+
+  /* once the first fragment is done the download rate is known */
+  engineTestData->threshold_for_seek = segment_size + 1;
+  engineTestData->seek_event = new_key_units_seek (4.0);
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_seek_full (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  /* 1.5 Mbps at 4x, the 300 kbps I-frame variant is the best match and
+   * the other ones are never loaded */
+  fail_unless_equals_int (count_requests (&hlsTestCase,
+          "http://unit.test/iframe-100"), 0);
+  fail_unless_equals_int (count_requests (&hlsTestCase,
+          "http://unit.test/iframe-800"), 0);
+  fail_unless (count_requests (&hlsTestCase,
+          "http://unit.test/iframe-300.m3u8") > 0);
+  fail_unless_equals_int (count_requests (&hlsTestCase,
+          "http://unit.test/iframe-300-"), 4);
+
+  TESTCASE_UNREF_BOILERPLATE;
+  free_iframe_test_input (inputTestData);
+}
+
+GST_END_TEST;
+
+#define SLOW_IFRAME_DOWNLOAD_TIME (100 * GST_MSECOND)
+
+static GstFlowReturn
+gst_hlsdemux_test_slow_iframe_src_create (GstTestHTTPSrc * src,
+    guint64 offset,
+    guint length, GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  GstHlsDemuxTestInputData *input = (GstHlsDemuxTestInputData *) context;
+
+  if (offset == 0 && g_str_has_prefix (input->uri, "http://unit.test/iframe")
+      && g_str_has_suffix (input->uri, ".ts"))
+    g_usleep (GST_TIME_AS_USECONDS (SLOW_IFRAME_DOWNLOAD_TIME));
+
+  return gst_hlsdemux_test_src_create (src, offset, length, retbuf, context,
+      user_data);
+}
+
+static void
+iframe_test_eos (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  GstAdaptiveDemuxTestCase *testData = GST_ADAPTIVE_DEMUX_TEST_CASE (user_data);
+
+  testData->count_of_finished_streams++;
+  if (testData->count_of_finished_streams ==
+      g_list_length (testData->output_streams)) {
+    g_main_loop_quit (engine->loop);
+  }
+}
+
+/*
+ * Test that the I-frames that can't be downloaded in time for the rate are
+ * skipped
+ */
+GST_START_TEST (testKeyUnitsSkipIFrames)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  GstHlsDemuxTestInputData *inputTestData =
+      create_iframe_test_input (10, "0.1");
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 10 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  guint n_iframes;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_slow_iframe_src_create;
+  engine_callbacks.pre_test = iframe_test_set_connection_speed;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos = iframe_test_eos;
+
+  /* At 8x, each 100ms I-frame download covers 800ms of I-frames */
+  engineTestData->threshold_for_seek = segment_size + 1;
+  engineTestData->seek_event = new_key_units_seek (8.0);
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_seek_full (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  /* 1.5 Mbps at 8x picks the 100 kbps I-frame variant */
+  n_iframes = count_requests (&hlsTestCase, "http://unit.test/iframe-100-");
+  fail_unless (n_iframes > 0);
+  fail_unless (n_iframes < 10, "no I-frame was skipped");
+
+  TESTCASE_UNREF_BOILERPLATE;
+  free_iframe_test_input (inputTestData);
+}
+
+GST_END_TEST;
+
 static Suite *
 hls_demux_suite (void)
 {
@@ -745,6 +960,8 @@ hls_demux_suite (void)
   tcase_add_test (tc_basicTest, testSeekSnapAfterPosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapBeforePosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapAfterPosition);
+  tcase_add_test (tc_basicTest, testKeyUnitsIFrameVariant);
+  tcase_add_test (tc_basicTest, testKeyUnitsSkipIFrames);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
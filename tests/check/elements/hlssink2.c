@@ -0,0 +1,461 @@
+/* GStreamer
+ *
+ * unit test for hlssink2
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+
+#include "../../ext/hls/gstm3u8playlist.h"
+
+/* used by the playlist code built into the test */
+GST_DEBUG_CATEGORY (hls_debug);
+
+#define PART_DURATION (200 * GST_MSECOND)
+#define FRAME_DURATION (20 * GST_MSECOND)
+#define FRAME_SIZE 417
+#define NUM_FRAMES 150
+
+static void
+add_segment (GstM3U8Playlist * playlist, guint index)
+{
+  gchar *url = g_strdup_printf ("segment%05u.ts", index);
+  guint i;
+
+  for (i = 0; i < 5; i++)
+    gst_m3u8_playlist_add_part (playlist, url, PART_DURATION, i * 1000, 1000,
+        i == 0);
+  gst_m3u8_playlist_add_entry (playlist, url, NULL, 5 * PART_DURATION, index,
+      FALSE);
+  g_free (url);
+}
+
+GST_START_TEST (test_playlist_parts)
+{
+  GstM3U8Playlist *playlist;
+  gchar *str;
+
+  playlist = gst_m3u8_playlist_new (6, 0, FALSE);
+  playlist->part_target = PART_DURATION;
+
+  fail_if (gst_m3u8_playlist_has_part (playlist, 0, 0));
+
+  add_segment (playlist, 0);
+  gst_m3u8_playlist_add_part (playlist, "segment00001.ts", PART_DURATION, 0,
+      1000, TRUE);
+  gst_m3u8_playlist_set_preload_hint (playlist, "segment00001.ts", 1000);
+
+  fail_unless (gst_m3u8_playlist_has_part (playlist, 0, -1));
+  fail_unless (gst_m3u8_playlist_has_part (playlist, 1, 0));
+  fail_if (gst_m3u8_playlist_has_part (playlist, 1, 1));
+  fail_if (gst_m3u8_playlist_has_part (playlist, 1, -1));
+  fail_if (gst_m3u8_playlist_has_part (playlist, 2, 0));
+
+  str = gst_m3u8_playlist_render (playlist);
+  assert_equals_string (str, "#EXTM3U\n"
+      "#EXT-X-VERSION:6\n"
+      "#EXT-X-ALLOW-CACHE:NO\n"
+      "#EXT-X-MEDIA-SEQUENCE:0\n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,CAN-SKIP-UNTIL=6,"
+      "PART-HOLD-BACK=0.600\n"
+      "#EXT-X-PART-INF:PART-TARGET=0.200\n"
+      "\n"
+      "#EXT-X-PART:DURATION=0.200,URI=\"segment00000.ts\","
+      "BYTERANGE=\"1000@0\",INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.200,URI=\"segment00000.ts\","
+      "BYTERANGE=\"1000@1000\"\n"
+      "#EXT-X-PART:DURATION=0.200,URI=\"segment00000.ts\","
+      "BYTERANGE=\"1000@2000\"\n"
+      "#EXT-X-PART:DURATION=0.200,URI=\"segment00000.ts\","
+      "BYTERANGE=\"1000@3000\"\n"
+      "#EXT-X-PART:DURATION=0.200,URI=\"segment00000.ts\","
+      "BYTERANGE=\"1000@4000\"\n"
+      "#EXTINF:1,\n"
+      "segment00000.ts\n"
+      "#EXT-X-PART:DURATION=0.200,URI=\"segment00001.ts\","
+      "BYTERANGE=\"1000@0\",INDEPENDENT=YES\n"
+      "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"segment00001.ts\","
+      "BYTERANGE-START=1000\n");
+  g_free (str);
+
+  gst_m3u8_playlist_free (playlist);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_playlist_old_parts_and_delta)
+{
+  GstM3U8Playlist *playlist;
+  gchar *str, *pos;
+  guint i;
+
+  playlist = gst_m3u8_playlist_new (6, 0, FALSE);
+  playlist->part_target = PART_DURATION;
+
+  for (i = 0; i < 10; i++)
+    add_segment (playlist, i);
+
+  /* parts are only listed for the last three target durations */
+  str = gst_m3u8_playlist_render (playlist);
+  fail_if (strstr (str, "URI=\"segment00005.ts\"") != NULL);
+  fail_unless (strstr (str, "URI=\"segment00006.ts\"") != NULL);
+  fail_unless (strstr (str, "URI=\"segment00009.ts\"") != NULL);
+  fail_unless (strstr (str, "\nsegment00000.ts\n") != NULL);
+  fail_if (strstr (str, "EXT-X-SKIP") != NULL);
+  g_free (str);
+
+  /* segments starting more than six target durations before the end are
+   * skipped in a delta update */
+  str = gst_m3u8_playlist_render_delta (playlist);
+  fail_unless (strstr (str, "#EXT-X-VERSION:9\n") != NULL);
+  pos = strstr (str, "#EXT-X-SKIP:SKIPPED-SEGMENTS=4\n");
+  fail_unless (pos != NULL);
+  fail_unless (strstr (pos, "#EXTINF:1,\nsegment00004.ts\n") == pos + 31);
+  fail_if (strstr (str, "segment00003.ts") != NULL);
+  g_free (str);
+
+  /* trimming the window drops the rendered entries too */
+  playlist->window_size = 3;
+  add_segment (playlist, 10);
+  str = gst_m3u8_playlist_render (playlist);
+  fail_unless (strstr (str, "#EXT-X-MEDIA-SEQUENCE:8\n") != NULL);
+  fail_if (strstr (str, "segment00007.ts") != NULL);
+  fail_unless (strstr (str, "URI=\"segment00008.ts\"") != NULL);
+  g_free (str);
+
+  playlist->end_list = TRUE;
+  gst_m3u8_playlist_set_preload_hint (playlist, "segment00011.ts", 0);
+  str = gst_m3u8_playlist_render (playlist);
+  fail_if (strstr (str, "EXT-X-PRELOAD-HINT") != NULL);
+  fail_unless (g_str_has_suffix (str, "segment00010.ts\n#EXT-X-ENDLIST"));
+  g_free (str);
+
+  gst_m3u8_playlist_free (playlist);
+}
+
+GST_END_TEST;
+
+static gchar *
+get_playlist (GstElement * sink, guint variant, guint msn, gint part,
+    GstClockTime timeout)
+{
+  gchar *playlist = NULL;
+
+  g_signal_emit_by_name (sink, "get-playlist", variant, msn, part, FALSE,
+      timeout, &playlist);
+
+  return playlist;
+}
+
+/* Checks the parts written for each segment against the segment files */
+static void
+check_parts (const gchar * dir, const gchar * playlist)
+{
+  gchar **lines, **l;
+  gdouble parts_duration = 0;
+  guint64 offset = 0;
+  guint n_parts = 0, n_segments = 0;
+
+  lines = g_strsplit (playlist, "\n", -1);
+  for (l = lines; *l; l++) {
+    if (g_str_has_prefix (*l, "#EXT-X-PART:")) {
+      gdouble duration;
+      guint64 length, part_offset;
+      gchar *s;
+
+      duration = g_ascii_strtod (*l + strlen ("#EXT-X-PART:DURATION="), NULL);
+      fail_unless (duration > 0);
+      fail_unless (duration <= 0.2, "part of %f s in '%s'", duration, *l);
+
+      s = strstr (*l, "BYTERANGE=\"");
+      fail_unless (s != NULL);
+      length = g_ascii_strtoull (s + strlen ("BYTERANGE=\""), &s, 10);
+      fail_unless (*s == '@');
+      part_offset = g_ascii_strtoull (s + 1, NULL, 10);
+      fail_unless_equals_uint64 (part_offset, offset);
+      fail_unless (length > 0);
+
+      if (n_parts == 0)
+        fail_unless (strstr (*l, "INDEPENDENT=YES") != NULL);
+
+      parts_duration += duration;
+      offset += length;
+      n_parts++;
+    } else if (g_str_has_prefix (*l, "#EXTINF:")) {
+      gdouble duration = g_ascii_strtod (*l + strlen ("#EXTINF:"), NULL);
+      gchar *location;
+      GStatBuf st;
+
+      fail_unless (n_parts >= 4);
+      fail_unless (ABS (parts_duration - duration) < 0.001 * n_parts);
+
+      location = g_build_filename (dir, l[1], NULL);
+      fail_unless (g_stat (location, &st) == 0);
+      fail_unless_equals_uint64 (st.st_size, offset);
+      g_free (location);
+
+      parts_duration = 0;
+      offset = 0;
+      n_parts = 0;
+      n_segments++;
+    }
+  }
+  g_strfreev (lines);
+
+  fail_unless (n_segments >= 2);
+}
+
+static void
+remove_dir (const gchar * dir)
+{
+  GDir *d = g_dir_open (dir, 0, NULL);
+  const gchar *name;
+
+  while ((name = g_dir_read_name (d))) {
+    gchar *path = g_build_filename (dir, name, NULL);
+    g_remove (path);
+    g_free (path);
+  }
+  g_dir_close (d);
+  g_rmdir (dir);
+}
+
+GST_START_TEST (test_part_timing)
+{
+  GstHarness *h;
+  gchar *dir, *location, *playlist_location, *playlist, *contents;
+  guint i;
+
+  dir = g_dir_make_tmp ("hlssink2-XXXXXX", NULL);
+  fail_unless (dir != NULL);
+  location = g_build_filename (dir, "segment%05d.ts", NULL);
+  playlist_location = g_build_filename (dir, "playlist.m3u8", NULL);
+
+  h = gst_harness_new_with_padnames ("hlssink2", "audio", NULL);
+  g_object_set (h->element, "location", location, "playlist-location",
+      playlist_location, "target-duration", 1, "playlist-length", 0,
+      "max-files", 0, "part-duration", PART_DURATION, NULL);
+  gst_harness_set_src_caps_str (h, "audio/mpeg, mpegversion=(int)1, "
+      "layer=(int)3, parsed=(boolean)true, rate=(int)48000, channels=(int)2");
+
+  /* nothing to wait for yet */
+  fail_unless (get_playlist (h->element, 0, 0, 0, 10 * GST_MSECOND) == NULL);
+
+  for (i = 0; i < NUM_FRAMES; i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, FRAME_SIZE, NULL);
+
+    gst_buffer_memset (buf, 0, i, FRAME_SIZE);
+    GST_BUFFER_PTS (buf) = i * FRAME_DURATION;
+    GST_BUFFER_DURATION (buf) = FRAME_DURATION;
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+
+  /* a blocking reload returns as soon as the first part is written */
+  playlist = get_playlist (h->element, 0, 0, 0, 5 * GST_SECOND);
+  fail_unless (playlist != NULL);
+  fail_unless (strstr (playlist, "#EXT-X-PART:") != NULL);
+  fail_unless (strstr (playlist, "#EXT-X-PRELOAD-HINT:TYPE=PART") != NULL);
+  g_free (playlist);
+
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  /* and with the whole playlist once the stream ended */
+  playlist = get_playlist (h->element, 0, G_MAXUINT, -1, 5 * GST_SECOND);
+  fail_unless (playlist != NULL);
+  fail_unless (g_str_has_suffix (playlist, "#EXT-X-ENDLIST"));
+
+  /* the file has the same content */
+  fail_unless (g_file_get_contents (playlist_location, &contents, NULL,
+          NULL));
+  assert_equals_string (contents, playlist);
+  g_free (contents);
+
+  check_parts (dir, playlist);
+  g_free (playlist);
+
+  gst_harness_teardown (h);
+
+  remove_dir (dir);
+  g_free (location);
+  g_free (playlist_location);
+  g_free (dir);
+}
+
+GST_END_TEST;
+
+static void
+push_video_frames (GstHarness * h, guint offset)
+{
+  guint i;
+
+  /* key frames every half second in both variants */
+  for (i = 0; i < NUM_FRAMES; i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, FRAME_SIZE + offset, NULL);
+
+    gst_buffer_memset (buf, 0, i, FRAME_SIZE + offset);
+    GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = i * FRAME_DURATION;
+    GST_BUFFER_DURATION (buf) = FRAME_DURATION;
+    if (i % 25 != 0)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+}
+
+static gchar **
+get_segment_lines (const gchar * playlist)
+{
+  GPtrArray *extinfs = g_ptr_array_new ();
+  gchar **lines, **l;
+
+  lines = g_strsplit (playlist, "\n", -1);
+  for (l = lines; *l; l++) {
+    if (g_str_has_prefix (*l, "#EXTINF:"))
+      g_ptr_array_add (extinfs, g_strdup (*l));
+  }
+  g_strfreev (lines);
+  g_ptr_array_add (extinfs, NULL);
+
+  return (gchar **) g_ptr_array_free (extinfs, FALSE);
+}
+
+GST_START_TEST (test_ladder)
+{
+  GstHarness *h0, *h1;
+  GstPad *pad;
+  gchar *dir, *location, *playlist_location, *master_location;
+  gchar *master, *playlist0, *playlist1;
+  gchar **segments0, **segments1;
+  const gchar *name;
+  GDir *d;
+  guint i;
+
+  dir = g_dir_make_tmp ("hlssink2-XXXXXX", NULL);
+  fail_unless (dir != NULL);
+  master_location = g_build_filename (dir, "master.m3u8", NULL);
+
+  h0 = gst_harness_new_with_padnames ("hlssink2", "video_0", NULL);
+  h1 = gst_harness_new_with_element (h0->element, "video_1", NULL);
+  g_object_set (h0->element, "master-playlist-location", master_location,
+      "target-duration", 1, "playlist-length", 0, NULL);
+
+  for (i = 0; i < 2; i++) {
+    gchar *pad_name = g_strdup_printf ("video_%u", i);
+    gchar *file;
+
+    pad = gst_element_get_static_pad (h0->element, pad_name);
+    fail_unless (pad != NULL);
+
+    file = g_strdup_printf ("%s_segment%%05d.ts", pad_name);
+    location = g_build_filename (dir, file, NULL);
+    g_free (file);
+    file = g_strdup_printf ("%s.m3u8", pad_name);
+    playlist_location = g_build_filename (dir, file, NULL);
+    g_free (file);
+
+    g_object_set (pad, "location", location, "playlist-location",
+        playlist_location, NULL);
+
+    g_free (location);
+    g_free (playlist_location);
+    g_free (pad_name);
+    gst_object_unref (pad);
+  }
+
+  gst_harness_set_src_caps_str (h0, "video/x-h264, "
+      "stream-format=(string)byte-stream, alignment=(string)au, "
+      "width=(int)1280, height=(int)720");
+  gst_harness_set_src_caps_str (h1, "video/x-h264, "
+      "stream-format=(string)byte-stream, alignment=(string)au, "
+      "width=(int)640, height=(int)360");
+
+  push_video_frames (h0, 1000);
+  push_video_frames (h1, 0);
+  fail_unless (gst_harness_push_event (h0, gst_event_new_eos ()));
+  fail_unless (gst_harness_push_event (h1, gst_event_new_eos ()));
+
+  playlist0 = get_playlist (h0->element, 0, G_MAXUINT, -1, 5 * GST_SECOND);
+  playlist1 = get_playlist (h0->element, 1, G_MAXUINT, -1, 5 * GST_SECOND);
+  fail_unless (playlist0 != NULL);
+  fail_unless (playlist1 != NULL);
+
+  /* the segments of both variants are aligned */
+  segments0 = get_segment_lines (playlist0);
+  segments1 = get_segment_lines (playlist1);
+  fail_unless (g_strv_length (segments0) >= 2);
+  fail_unless_equals_int (g_strv_length (segments0),
+      g_strv_length (segments1));
+  for (i = 0; segments0[i]; i++)
+    assert_equals_string (segments0[i], segments1[i]);
+  g_strfreev (segments0);
+  g_strfreev (segments1);
+
+  fail_unless (g_file_get_contents (master_location, &master, NULL, NULL));
+  fail_unless (strstr (master,
+          ",RESOLUTION=1280x720\nvideo_0.m3u8\n") != NULL);
+  fail_unless (strstr (master,
+          ",RESOLUTION=640x360\nvideo_1.m3u8\n") != NULL);
+  fail_unless (strstr (master, "#EXT-X-STREAM-INF:BANDWIDTH=") != NULL);
+  g_free (master);
+
+  /* only the renamed playlists are left */
+  d = g_dir_open (dir, 0, NULL);
+  while ((name = g_dir_read_name (d)))
+    fail_if (g_str_has_suffix (name, ".tmp"), "%s left over", name);
+  g_dir_close (d);
+
+  g_free (playlist0);
+  g_free (playlist1);
+
+  gst_harness_teardown (h1);
+  gst_harness_teardown (h0);
+
+  remove_dir (dir);
+  g_free (master_location);
+  g_free (dir);
+}
+
+GST_END_TEST;
+
+static Suite *
+hlssink2_suite (void)
+{
+  Suite *s = suite_create ("hlssink2");
+  TCase *tc_chain = tcase_create ("general");
+  GstRegistry *reg = gst_registry_get ();
+
+  GST_DEBUG_CATEGORY_INIT (hls_debug, "hlssink2_test", 0, "hlssink2 test");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_playlist_parts);
+  tcase_add_test (tc_chain, test_playlist_old_parts_and_delta);
+
+  if (gst_registry_check_feature_version (reg, "splitmuxsink", 1, 0, 0)
+      && gst_registry_check_feature_version (reg, "mpegtsmux", 1, 0, 0)) {
+    tcase_add_test (tc_chain, test_part_timing);
+    tcase_add_test (tc_chain, test_ladder);
+  }
+
+  return s;
+}
+
+GST_CHECK_MAIN (hlssink2);
@@ -0,0 +1,196 @@
+/* GStreamer
+ *
+ * Unit test for tsparse
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstharness.h>
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#define TS_CAPS "video/mpegts, systemstream = (boolean) true, " \
+    "packetsize = (int) 188"
+#define TS_PACKET_SIZE 188
+#define NULL_PACKETS 4
+
+/* A TDT section (table_id 0x70, PID 0x14) without CRC */
+static void
+write_tdt (guint8 * packet, guint cc, guint8 seconds)
+{
+  static const guint8 header[] = {
+    0x47, 0x40, 0x14, 0x10,     /* PUSI, PID 0x14, payload only */
+    0x00,                       /* pointer_field */
+    0x70, 0x70, 0x05,           /* table_id, short section of 5 bytes */
+    0xe4, 0x3c, 0x12, 0x00      /* UTC_time without the seconds */
+  };
+
+  memset (packet, 0xff, TS_PACKET_SIZE);
+  memcpy (packet, header, sizeof (header));
+  packet[3] |= cc & 0xf;
+  packet[sizeof (header)] = seconds;
+}
+
+static void
+write_null_packet (guint8 * packet)
+{
+  memset (packet, 0xff, TS_PACKET_SIZE);
+  packet[0] = 0x47;
+  packet[1] = 0x1f;
+  packet[2] = 0xff;
+  packet[3] = 0x10;
+}
+
+/* One TDT per entry of @seconds, followed by enough null packets for the
+ * packet size detection and resync to get through all of them */
+static GstBuffer *
+create_tdt_stream (const guint8 * seconds, guint n)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  guint i;
+
+  buf = gst_buffer_new_allocate (NULL, (n + NULL_PACKETS) * TS_PACKET_SIZE,
+      NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (i = 0; i < n; i++)
+    write_tdt (map.data + i * TS_PACKET_SIZE, i, seconds[i]);
+  for (; i < n + NULL_PACKETS; i++)
+    write_null_packet (map.data + i * TS_PACKET_SIZE);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static guint
+count_section_messages (GstBus * bus)
+{
+  GstMessage *msg;
+  guint n = 0;
+
+  while ((msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT))) {
+    if (gst_structure_has_field (gst_message_get_structure (msg), "section"))
+      n++;
+    gst_message_unref (msg);
+  }
+
+  return n;
+}
+
+static GstHarness *
+setup_tsparse (GstBus * bus)
+{
+  GstHarness *h;
+
+  h = gst_harness_new_with_padnames ("tsparse", "sink", "sections");
+  gst_element_set_bus (h->element, bus);
+  gst_harness_set_src_caps_str (h, TS_CAPS);
+
+  return h;
+}
+
+GST_START_TEST (test_sections_pad)
+{
+  static const guint8 seconds[] = { 0x00, 0x00, 0x00, 0x01 };
+  GstBus *bus = gst_bus_new ();
+  GstHarness *h = setup_tsparse (bus);
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  /* the src pad isn't linked, only the sections are looked at */
+  gst_harness_push (h, create_tdt_stream (seconds, G_N_ELEMENTS (seconds)));
+
+  /* the unchanged repeats are dropped */
+  fail_unless_equals_int (gst_harness_buffers_received (h), 2);
+  fail_unless_equals_int (count_section_messages (bus), 2);
+
+  buf = gst_harness_pull (h);
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, 8);
+  fail_unless_equals_int (map.data[0], 0x70);
+  fail_unless_equals_int (map.data[7], 0x00);
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+
+  buf = gst_harness_pull (h);
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.data[7], 0x01);
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+  gst_object_unref (bus);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_section_filter)
+{
+  static const guint8 seconds[] = { 0x00, 0x01 };
+  GstBus *bus = gst_bus_new ();
+  GstHarness *h = setup_tsparse (bus);
+  gchar *str;
+
+  /* only TOTs */
+  g_object_set (h->element, "section-table-ids", "0x73", NULL);
+  g_object_get (h->element, "section-table-ids", &str, NULL);
+  fail_unless_equals_string (str, "0x73");
+  g_free (str);
+
+  gst_harness_push (h, create_tdt_stream (seconds, G_N_ELEMENTS (seconds)));
+  fail_unless_equals_int (gst_harness_buffers_received (h), 0);
+  fail_unless_equals_int (count_section_messages (bus), 0);
+
+  /* anything on the TDT/TOT PID, invalid values are ignored */
+  g_object_set (h->element, "section-table-ids", "", "section-pids",
+      "20:0x2000:foo", NULL);
+  g_object_get (h->element, "section-pids", &str, NULL);
+  fail_unless_equals_string (str, "0x14");
+  g_free (str);
+
+  gst_harness_push (h, create_tdt_stream (seconds, G_N_ELEMENTS (seconds)));
+  fail_unless_equals_int (gst_harness_buffers_received (h), 2);
+  fail_unless_equals_int (count_section_messages (bus), 2);
+
+  /* some other PID */
+  g_object_set (h->element, "section-pids", "0x12", NULL);
+  gst_harness_push (h, create_tdt_stream (seconds, G_N_ELEMENTS (seconds)));
+  fail_unless_equals_int (gst_harness_buffers_received (h), 2);
+  fail_unless_equals_int (count_section_messages (bus), 0);
+
+  gst_harness_teardown (h);
+  gst_object_unref (bus);
+}
+
+GST_END_TEST;
+
+static Suite *
+mpegtsparse_suite (void)
+{
+  Suite *s = suite_create ("mpegtsparse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_sections_pad);
+  tcase_add_test (tc_chain, test_section_filter);
+
+  return s;
+}
+
+GST_CHECK_MAIN (mpegtsparse);
@@ -20,7 +20,11 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/base/gstbytewriter.h>
 #include "adaptive_demux_common.h"
+#include "../../ext/smoothstreaming/gstmssmanifest.h"
+
+GST_DEBUG_CATEGORY (mssdemux_debug);
 
 #define DEMUX_ELEMENT_NAME "mssdemux"
 
@@ -606,11 +610,504 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+/* A fragment of N_SAMPLES samples: a moof with a trun giving the data
+ * offset, the flags of the first sample and the sample sizes, then the mdat.
+ * In key unit trick mode only the moof and the first sample are pushed. */
+#define N_SAMPLES 3
+#define SAMPLE_SIZE(i) (1000 * ((i) + 1))
+#define TRUN_SIZE (24 + 4 * N_SAMPLES)
+#define TRAF_SIZE (8 + 16 + TRUN_SIZE)
+#define MOOF_SIZE (8 + 16 + TRAF_SIZE)
+#define MDAT_SIZE (8 + SAMPLE_SIZE (0) + SAMPLE_SIZE (1) + SAMPLE_SIZE (2))
+#define FRAGMENT_SIZE (MOOF_SIZE + MDAT_SIZE)
+#define SYNC_SAMPLE_END (MOOF_SIZE + 8 + SAMPLE_SIZE (0))
+
+static guint8 *
+create_fragment (gboolean sync)
+{
+  GstByteWriter bw;
+  guint i;
+
+  gst_byte_writer_init_with_size (&bw, FRAGMENT_SIZE, TRUE);
+
+  gst_byte_writer_put_uint32_be (&bw, MOOF_SIZE);
+  gst_byte_writer_put_uint32_le (&bw, GST_MAKE_FOURCC ('m', 'o', 'o', 'f'));
+  gst_byte_writer_put_uint32_be (&bw, 16);
+  gst_byte_writer_put_uint32_le (&bw, GST_MAKE_FOURCC ('m', 'f', 'h', 'd'));
+  gst_byte_writer_put_uint32_be (&bw, 0);
+  gst_byte_writer_put_uint32_be (&bw, 1);
+  gst_byte_writer_put_uint32_be (&bw, TRAF_SIZE);
+  gst_byte_writer_put_uint32_le (&bw, GST_MAKE_FOURCC ('t', 'r', 'a', 'f'));
+  gst_byte_writer_put_uint32_be (&bw, 16);
+  gst_byte_writer_put_uint32_le (&bw, GST_MAKE_FOURCC ('t', 'f', 'h', 'd'));
+  gst_byte_writer_put_uint32_be (&bw, 0);
+  gst_byte_writer_put_uint32_be (&bw, 1);
+  gst_byte_writer_put_uint32_be (&bw, TRUN_SIZE);
+  gst_byte_writer_put_uint32_le (&bw, GST_MAKE_FOURCC ('t', 'r', 'u', 'n'));
+  /* data offset, first sample flags and sample sizes present */
+  gst_byte_writer_put_uint32_be (&bw, 0x000205);
+  gst_byte_writer_put_uint32_be (&bw, N_SAMPLES);
+  gst_byte_writer_put_uint32_be (&bw, MOOF_SIZE + 8);
+  /* sample_depends_on 2, or 1 and sample_is_non_sync_sample */
+  gst_byte_writer_put_uint32_be (&bw, sync ? 0x02000000 : 0x01010000);
+  for (i = 0; i < N_SAMPLES; i++)
+    gst_byte_writer_put_uint32_be (&bw, SAMPLE_SIZE (i));
+
+  gst_byte_writer_put_uint32_be (&bw, MDAT_SIZE);
+  gst_byte_writer_put_uint32_le (&bw, GST_MAKE_FOURCC ('m', 'd', 'a', 't'));
+  for (i = 8; i < MDAT_SIZE; i++)
+    gst_byte_writer_put_uint8 (&bw, i & 0xff);
+
+  fail_unless_equals_int (gst_byte_writer_get_pos (&bw), FRAGMENT_SIZE);
+  return gst_byte_writer_reset_and_get_data (&bw);
+}
+
+/* A video only manifest of @n_fragments fragments of @duration (in 100ns
+ * units), all of them served with @fragment */
+static GstMssDemuxTestInputData *
+create_video_input (guint n_fragments, guint64 duration,
+    const guint8 * fragment)
+{
+  GstMssDemuxTestInputData *input;
+  GString *mpd;
+  guint i;
+
+  input = g_new0 (GstMssDemuxTestInputData, n_fragments + 2);
+  mpd = g_string_new (NULL);
+  g_string_append_printf (mpd, "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<SmoothStreamingMedia MajorVersion=\"2\" MinorVersion=\"0\" "
+      "Duration=\"%" G_GUINT64_FORMAT "\">"
+      "<StreamIndex Type=\"video\" QualityLevels=\"1\" Chunks=\"%u\" "
+      "Url=\"QualityLevels({bitrate})/Fragments(video={start time})\">"
+      "<QualityLevel Index=\"0\" Bitrate=\"480111\" FourCC=\"H264\" "
+      "MaxWidth=\"1024\" MaxHeight=\"436\" CodecPrivateData=\"000\" />",
+      n_fragments * duration, n_fragments);
+
+  for (i = 0; i < n_fragments; i++) {
+    g_string_append_printf (mpd, "<c n=\"%u\" d=\"%" G_GUINT64_FORMAT
+        "\" />", i, duration);
+    input[i + 1].uri =
+        g_strdup_printf ("http://unit.test/QualityLevels(480111)/"
+        "Fragments(video=%" G_GUINT64_FORMAT ")", i * duration);
+    input[i + 1].payload = fragment;
+    input[i + 1].size = FRAGMENT_SIZE;
+  }
+  g_string_append (mpd, "</StreamIndex></SmoothStreamingMedia>");
+
+  input[0].uri = g_strdup ("http://unit.test/Manifest");
+  input[0].payload = (guint8 *) g_string_free (mpd, FALSE);
+
+  return input;
+}
+
+static void
+free_video_input (GstMssDemuxTestInputData * input)
+{
+  guint i;
+
+  g_free ((gpointer) input[0].payload);
+  for (i = 0; input[i].uri; i++)
+    g_free ((gpointer) input[i].uri);
+  g_free (input);
+}
+
+static gboolean
+testKeyUnitsCheckSyncSample (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream,
+    GstBuffer * buffer, gpointer user_data)
+{
+  GstAdaptiveDemuxTestCase *testData = GST_ADAPTIVE_DEMUX_TEST_CASE (user_data);
+
+  /* After the seek every fragment ends right after its sync sample, and
+   * the next one starts with a discont */
+  if (testData->seeked) {
+    assert_equals_uint64 (stream->segment_received_size, 0);
+    assert_equals_uint64 (gst_buffer_get_size (buffer), SYNC_SAMPLE_END);
+    fail_unless (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DISCONT));
+  }
+
+  return gst_adaptive_demux_test_check_received_data (engine, stream, buffer,
+      user_data);
+}
+
+/*
+ * Test that in key unit trick mode only the moof and the first sample of
+ * each fragment are downloaded. The fragments arrive in small buffers so
+ * that the moof is parsed across many of them.
+ */
+GST_START_TEST (testKeyUnitsSyncSample)
+{
+  guint8 *fragment = create_fragment (TRUE);
+  GstMssDemuxTestInputData *inputTestData =
+      create_video_input (4, 10000000, fragment);
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"video_00", 4 * SYNC_SAMPLE_END, NULL},
+  };
+  GstAdaptiveDemuxTestCallbacks test_callbacks = { 0 };
+  GstAdaptiveDemuxTestCase *testData;
+
+  testData = gst_adaptive_demux_test_case_new ();
+  http_src_callbacks.src_start = gst_mssdemux_http_src_start;
+  http_src_callbacks.src_create = gst_mssdemux_http_src_create;
+  outputTestData[0].expected_data = fragment;
+  COPY_OUTPUT_TEST_DATA (outputTestData, testData);
+  test_callbacks.appsink_received_data = testKeyUnitsCheckSyncSample;
+
+  gst_test_http_src_set_default_blocksize (10);
+
+  testData->threshold_for_seek = 1;
+  testData->seek_event =
+      gst_event_new_seek (2.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_TRICKMODE |
+      GST_SEEK_FLAG_TRICKMODE_KEY_UNITS, GST_SEEK_TYPE_SET, 0,
+      GST_SEEK_TYPE_NONE, 0);
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, inputTestData);
+  gst_adaptive_demux_test_seek_full (DEMUX_ELEMENT_NAME,
+      "http://unit.test/Manifest", &test_callbacks, testData);
+  g_object_unref (testData);
+  free_video_input (inputTestData);
+  g_free (fragment);
+}
+
+GST_END_TEST;
+
+/* 100ms fragments that take at least as long to download */
+#define SLOW_FRAGMENT_DURATION 1000000
+#define SLOW_FRAGMENT_DOWNLOAD_TIME (100 * GST_MSECOND)
+
+static GstClockTime slow_fragment_last_pts;
+static guint slow_fragment_skipped;
+
+static GstFlowReturn
+test_slow_fragment_src_create (GstTestHTTPSrc * src,
+    guint64 offset,
+    guint length, GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  const GstMssDemuxTestInputData *input =
+      (const GstMssDemuxTestInputData *) context;
+
+  if (offset == 0 && strstr (input->uri, "Fragments(") != NULL)
+    g_usleep (GST_TIME_AS_USECONDS (SLOW_FRAGMENT_DOWNLOAD_TIME));
+
+  return gst_mssdemux_http_src_create (src, offset, length, retbuf, context,
+      user_data);
+}
+
+static gboolean
+testKeyUnitsSkipCheckReceivedData (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream,
+    GstBuffer * buffer, gpointer user_data)
+{
+  GstAdaptiveDemuxTestCase *testData = GST_ADAPTIVE_DEMUX_TEST_CASE (user_data);
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+
+  /* Only the first buffer of each fragment is timestamped */
+  if (testData->seeked && stream->segment_received_size == 0) {
+    fail_unless (GST_CLOCK_TIME_IS_VALID (pts));
+    if (GST_CLOCK_TIME_IS_VALID (slow_fragment_last_pts)) {
+      fail_unless (pts > slow_fragment_last_pts);
+      /* the duration is in 100ns units */
+      if (pts - slow_fragment_last_pts > SLOW_FRAGMENT_DURATION * 100)
+        slow_fragment_skipped++;
+    }
+    slow_fragment_last_pts = pts;
+  }
+
+  return gst_adaptive_demux_test_check_received_data (engine, stream, buffer,
+      user_data);
+}
+
+static void
+testKeyUnitsSkipCheckEOS (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  GstAdaptiveDemuxTestCase *testData = GST_ADAPTIVE_DEMUX_TEST_CASE (user_data);
+
+  fail_unless (slow_fragment_skipped > 0,
+      "no fragment was skipped despite the download time");
+
+  testData->count_of_finished_streams++;
+  if (testData->count_of_finished_streams ==
+      g_list_length (testData->output_streams)) {
+    g_main_loop_quit (engine->loop);
+  }
+}
+
+/*
+ * Test that in key unit trick mode the fragments that can't be downloaded
+ * in time for the rate are skipped. The first samples of these fragments
+ * aren't sync samples, so the fragments are downloaded completely.
+ */
+GST_START_TEST (testKeyUnitsSkipByDownloadTime)
+{
+  guint8 *fragment = create_fragment (FALSE);
+  GstMssDemuxTestInputData *inputTestData =
+      create_video_input (10, SLOW_FRAGMENT_DURATION, fragment);
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"video_00", 10 * FRAGMENT_SIZE, NULL},
+  };
+  GstAdaptiveDemuxTestCallbacks test_callbacks = { 0 };
+  GstAdaptiveDemuxTestCase *testData;
+
+  slow_fragment_last_pts = GST_CLOCK_TIME_NONE;
+  slow_fragment_skipped = 0;
+
+  testData = gst_adaptive_demux_test_case_new ();
+  http_src_callbacks.src_start = gst_mssdemux_http_src_start;
+  http_src_callbacks.src_create = test_slow_fragment_src_create;
+  outputTestData[0].expected_data = fragment;
+  COPY_OUTPUT_TEST_DATA (outputTestData, testData);
+  test_callbacks.appsink_received_data = testKeyUnitsSkipCheckReceivedData;
+  test_callbacks.appsink_eos = testKeyUnitsSkipCheckEOS;
+
+  /* At 8x, each 100ms fragment download covers 800ms of fragments */
+  testData->threshold_for_seek = 1;
+  testData->seek_event =
+      gst_event_new_seek (8.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_TRICKMODE |
+      GST_SEEK_FLAG_TRICKMODE_KEY_UNITS, GST_SEEK_TYPE_SET, 0,
+      GST_SEEK_TYPE_NONE, 0);
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, inputTestData);
+  gst_adaptive_demux_test_seek_full (DEMUX_ELEMENT_NAME,
+      "http://unit.test/Manifest", &test_callbacks, testData);
+  g_object_unref (testData);
+  free_video_input (inputTestData);
+  g_free (fragment);
+}
+
+GST_END_TEST;
+
+/******************** Live manifest refreshes ****************************/
+
+/* A live manifest with one video stream made of @chunks, in tenths of a
+ * second */
+static GstBuffer *
+create_live_manifest (const gchar * chunks)
+{
+  gchar *manifest = g_strdup_printf ("<?xml version=\"1.0\" "
+      "encoding=\"utf-8\"?><SmoothStreamingMedia MajorVersion=\"2\" "
+      "MinorVersion=\"0\" TimeScale=\"10\" Duration=\"0\" IsLive=\"TRUE\" "
+      "LookAheadFragmentCount=\"2\" DVRWindowLength=\"0\">"
+      "<StreamIndex Type=\"video\" QualityLevels=\"1\" Chunks=\"0\" "
+      "Url=\"QualityLevels({bitrate})/Fragments(video={start time})\">"
+      "<QualityLevel Index=\"0\" Bitrate=\"480000\" FourCC=\"AVC1\" "
+      "MaxWidth=\"640\" MaxHeight=\"480\" />%s</StreamIndex>"
+      "</SmoothStreamingMedia>", chunks);
+
+  return gst_buffer_new_wrapped (manifest, strlen (manifest));
+}
+
+static GstMssStream *
+setup_live_manifest (GstMssManifest ** manifest, const gchar * chunks)
+{
+  GstBuffer *buf = create_live_manifest (chunks);
+  GstMssStream *stream;
+
+  GST_DEBUG_CATEGORY_INIT (mssdemux_debug, "mssdemux", 0, "mssdemux plugin");
+
+  *manifest = gst_mss_manifest_new (buf);
+  gst_buffer_unref (buf);
+  fail_unless (*manifest != NULL);
+  fail_unless (gst_mss_manifest_is_live (*manifest));
+
+  stream = gst_mss_manifest_get_streams (*manifest)->data;
+  gst_mss_stream_set_active (stream, TRUE);
+
+  return stream;
+}
+
+static void
+reload_live_manifest (GstMssManifest * manifest, const gchar * chunks)
+{
+  GstBuffer *buf = create_live_manifest (chunks);
+
+  gst_mss_manifest_reload_fragments (manifest, buf);
+  gst_buffer_unref (buf);
+}
+
+static void
+advance_fragments (GstMssStream * stream, guint count)
+{
+  while (count--)
+    fail_unless_equals_int (gst_mss_stream_advance_fragment (stream),
+        GST_FLOW_OK);
+}
+
+/* Checks that the fragments left in @stream start at @starts, in seconds */
+static void
+check_remaining_fragments (GstMssStream * stream, const guint * starts,
+    guint n_starts)
+{
+  guint i;
+
+  for (i = 0; i < n_starts; i++) {
+    fail_unless (gst_mss_stream_has_next_fragment (stream));
+    fail_unless_equals_uint64 (gst_mss_stream_get_fragment_gst_timestamp
+        (stream), starts[i] * GST_SECOND);
+    gst_mss_stream_advance_fragment (stream);
+  }
+  fail_if (gst_mss_stream_has_next_fragment (stream));
+}
+
+/*
+ * Test that the runs of fragments that left the DVR window are dropped
+ * when the manifest is refreshed, without moving the current fragment
+ */
+GST_START_TEST (testLiveReloadDropsOldFragments)
+{
+  static const guint starts[] = { 6, 7, 8, 9 };
+  GstMssManifest *manifest;
+  GstMssStream *stream;
+  gint64 start, stop;
+
+  stream = setup_live_manifest (&manifest,
+      "<c t=\"0\" d=\"20\" r=\"3\" /><c d=\"10\" r=\"2\" />");
+  advance_fragments (stream, 3);
+
+  reload_live_manifest (manifest, "<c t=\"60\" d=\"10\" r=\"4\" />");
+  fail_unless (gst_mss_manifest_get_live_seek_range (manifest, &start, &stop));
+  assert_equals_int64 (start, 6 * GST_SECOND);
+  assert_equals_int64 (stop, 10 * GST_SECOND);
+  check_remaining_fragments (stream, starts, G_N_ELEMENTS (starts));
+
+  gst_mss_manifest_free (manifest);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that a current fragment that left the DVR window is replaced by
+ * the first one still in it
+ */
+GST_START_TEST (testLiveReloadCurrentFragmentDropped)
+{
+  static const guint starts[] = { 6, 8, 10 };
+  GstMssManifest *manifest;
+  GstMssStream *stream;
+
+  stream = setup_live_manifest (&manifest, "<c t=\"0\" d=\"20\" r=\"3\" />");
+
+  reload_live_manifest (manifest, "<c t=\"60\" d=\"20\" r=\"3\" />");
+  check_remaining_fragments (stream, starts, G_N_ELEMENTS (starts));
+
+  gst_mss_manifest_free (manifest);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that a run that got longer since the last refresh is extended
+ * with only its new fragments
+ */
+GST_START_TEST (testLiveReloadExtendsLastRun)
+{
+  static const guint starts[] = { 4, 6, 8 };
+  GstMssManifest *manifest;
+  GstMssStream *stream;
+  gchar *url;
+
+  stream = setup_live_manifest (&manifest, "<c t=\"0\" d=\"20\" r=\"3\" />");
+  advance_fragments (stream, 2);
+
+  reload_live_manifest (manifest, "<c t=\"0\" d=\"20\" r=\"5\" />");
+  fail_unless_equals_int (gst_mss_stream_get_fragment_url (stream, &url),
+      GST_FLOW_OK);
+  fail_unless_equals_string (url, "QualityLevels(480000)/Fragments(video=40)");
+  g_free (url);
+  check_remaining_fragments (stream, starts, G_N_ELEMENTS (starts));
+
+  gst_mss_manifest_free (manifest);
+}
+
+GST_END_TEST;
+
+#ifndef GST_DISABLE_GST_DEBUG
+static guint overlap_warnings;
+
+static void
+count_overlap_warnings (GstDebugCategory * category, GstDebugLevel level,
+    const gchar * file, const gchar * function, gint line, GObject * object,
+    GstDebugMessage * message, gpointer user_data)
+{
+  if (category == mssdemux_debug && level == GST_LEVEL_WARNING &&
+      strstr (gst_debug_message_get (message), "overlaps") != NULL)
+    overlap_warnings++;
+}
+#endif
+
+/*
+ * Test that fragments that don't line up with the known ones are ignored
+ * with a warning
+ */
+GST_START_TEST (testLiveReloadOverlap)
+{
+  static const guint starts[] = { 0, 2, 4 };
+  GstMssManifest *manifest;
+  GstMssStream *stream;
+
+  stream = setup_live_manifest (&manifest, "<c t=\"0\" d=\"20\" r=\"3\" />");
+
+#ifndef GST_DISABLE_GST_DEBUG
+  overlap_warnings = 0;
+  gst_debug_category_set_threshold (mssdemux_debug, GST_LEVEL_WARNING);
+  gst_debug_add_log_function (count_overlap_warnings, NULL, NULL);
+#endif
+
+  reload_live_manifest (manifest, "<c t=\"50\" d=\"20\" r=\"2\" />");
+
+#ifndef GST_DISABLE_GST_DEBUG
+  gst_debug_remove_log_function (count_overlap_warnings);
+  fail_unless_equals_int (overlap_warnings, 1);
+#endif
+
+  check_remaining_fragments (stream, starts, G_N_ELEMENTS (starts));
+
+  gst_mss_manifest_free (manifest);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that a stream that played all its fragments continues with the
+ * ones a refresh adds, whether they extend the last run or start a new one
+ */
+GST_START_TEST (testLiveReloadPastTheEnd)
+{
+  static const guint extended_starts[] = { 6, 8 };
+  static const guint new_run_starts[] = { 10, 11 };
+  GstMssManifest *manifest;
+  GstMssStream *stream;
+
+  stream = setup_live_manifest (&manifest, "<c t=\"0\" d=\"20\" r=\"3\" />");
+  advance_fragments (stream, 2);
+  fail_unless_equals_int (gst_mss_stream_advance_fragment (stream),
+      GST_FLOW_EOS);
+  fail_if (gst_mss_stream_has_next_fragment (stream));
+
+  reload_live_manifest (manifest, "<c t=\"0\" d=\"20\" r=\"5\" />");
+  check_remaining_fragments (stream, extended_starts,
+      G_N_ELEMENTS (extended_starts));
+
+  reload_live_manifest (manifest,
+      "<c t=\"0\" d=\"20\" r=\"5\" /><c d=\"10\" r=\"2\" />");
+  check_remaining_fragments (stream, new_run_starts,
+      G_N_ELEMENTS (new_run_starts));
+
+  gst_mss_manifest_free (manifest);
+}
+
+GST_END_TEST;
+
 static Suite *
 mss_demux_suite (void)
 {
   Suite *s = suite_create ("mss_demux");
   TCase *tc_basicTest = tcase_create ("basicTest");
+  TCase *tc_manifestTest = tcase_create ("manifestTest");
 
   tcase_add_test (tc_basicTest, simpleTest);
   tcase_add_test (tc_basicTest, testSeek);
@@ -624,12 +1121,21 @@ mss_demux_suite (void)
   tcase_add_test (tc_basicTest, testDownloadError);
   tcase_add_test (tc_basicTest, testFragmentDownloadError);
   tcase_add_test (tc_basicTest, testQuery);
+  tcase_add_test (tc_basicTest, testKeyUnitsSyncSample);
+  tcase_add_test (tc_basicTest, testKeyUnitsSkipByDownloadTime);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
 
   suite_add_tcase (s, tc_basicTest);
 
+  tcase_add_test (tc_manifestTest, testLiveReloadDropsOldFragments);
+  tcase_add_test (tc_manifestTest, testLiveReloadCurrentFragmentDropped);
+  tcase_add_test (tc_manifestTest, testLiveReloadExtendsLastRun);
+  tcase_add_test (tc_manifestTest, testLiveReloadOverlap);
+  tcase_add_test (tc_manifestTest, testLiveReloadPastTheEnd);
+  suite_add_tcase (s, tc_manifestTest);
+
   return s;
 }
 
@@ -21,13 +21,16 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
+#include <unistd.h>
 #include "mxfdemux.h"
 
 static GstPad *mysrcpad, *mysinkpad;
 static GMainLoop *loop = NULL;
 static gboolean have_eos = FALSE;
 static gboolean have_data = FALSE;
+static guint n_pulls = 0;
 
 static GstStaticPadTemplate mysrctemplate =
 GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
@@ -65,10 +68,19 @@ _sink_check_caps (GstPad * pad, GstCaps * caps)
 static GstFlowReturn
 _sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
+  gsize maxsize;
+
   fail_unless_equals_int (gst_buffer_get_size (buffer), sizeof (mxf_essence));
   fail_unless (gst_buffer_memcmp (buffer, 0, mxf_essence,
           sizeof (mxf_essence)) == 0);
 
+  /* Small reads are copied out of the read-ahead block, not kept as part
+   * of it */
+  if (n_pulls > 0) {
+    gst_buffer_get_sizes (buffer, NULL, &maxsize);
+    fail_unless (maxsize < sizeof (mxf_file) / 2);
+  }
+
   fail_unless (GST_BUFFER_TIMESTAMP (buffer) == 0);
   fail_unless (GST_BUFFER_DURATION (buffer) == 200 * GST_MSECOND);
 
@@ -143,6 +155,24 @@ _src_getrange (GstPad * pad, GstObject * parent, guint64 offset, guint length,
   return GST_FLOW_OK;
 }
 
+/* Like filesrc, returns what is left instead of failing reads that go
+ * beyond the end */
+static GstFlowReturn
+_src_getrange_short (GstPad * pad, GstObject * parent, guint64 offset,
+    guint length, GstBuffer ** buffer)
+{
+  n_pulls++;
+
+  if (offset >= sizeof (mxf_file))
+    return GST_FLOW_EOS;
+
+  length = MIN (length, sizeof (mxf_file) - offset);
+  *buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      (guint8 *) (mxf_file + offset), length, 0, length, NULL, NULL);
+
+  return GST_FLOW_OK;
+}
+
 static gboolean
 _src_query (GstPad * pad, GstObject * parent, GstQuery * query)
 {
@@ -192,6 +222,7 @@ GST_START_TEST (test_pull)
 
   have_eos = FALSE;
   have_data = FALSE;
+  n_pulls = 0;
   loop = g_main_loop_new (NULL, FALSE);
 
   mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
@@ -232,6 +263,212 @@ GST_START_TEST (test_pull)
 
 GST_END_TEST;
 
+GST_START_TEST (test_pull_read_ahead)
+{
+  GstStateChangeReturn sret;
+  GstElement *mxfdemux;
+  GstPad *sinkpad;
+
+  have_eos = FALSE;
+  have_data = FALSE;
+  n_pulls = 0;
+  loop = g_main_loop_new (NULL, FALSE);
+
+  mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
+  fail_unless (mxfdemux != NULL);
+  g_signal_connect (mxfdemux, "pad-added", G_CALLBACK (_pad_added), NULL);
+  sinkpad = gst_element_get_static_pad (mxfdemux, "sink");
+  fail_unless (sinkpad != NULL);
+
+  mysinkpad = _create_sink_pad ();
+  fail_unless (mysinkpad != NULL);
+  mysrcpad = _create_src_pad_pull ();
+  fail_unless (mysrcpad != NULL);
+  gst_pad_set_getrange_function (mysrcpad, _src_getrange_short);
+
+  fail_unless (gst_pad_link (mysrcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_pad_set_active (mysinkpad, TRUE);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  sret = gst_element_set_state (mxfdemux, GST_STATE_PLAYING);
+  fail_unless_equals_int (sret, GST_STATE_CHANGE_SUCCESS);
+
+  g_main_loop_run (loop);
+  fail_unless (have_eos == TRUE);
+  fail_unless (have_data == TRUE);
+
+  /* The whole file fits into one read-ahead block, only the reads before
+   * its start need their own */
+  GST_INFO ("%u pulls", n_pulls);
+  fail_unless (n_pulls < 10);
+
+  gst_element_set_state (mxfdemux, GST_STATE_NULL);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_pad_set_active (mysrcpad, FALSE);
+
+  gst_object_unref (mxfdemux);
+  gst_object_unref (mysinkpad);
+  gst_object_unref (mysrcpad);
+  g_main_loop_unref (loop);
+  loop = NULL;
+}
+
+GST_END_TEST;
+
+static void
+run_pipeline (GstElement * pipeline)
+{
+  GstMessage *msg;
+  GstBus *bus;
+
+  bus = gst_element_get_bus (pipeline);
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+}
+
+/* 10 seconds of moving video with a body partition, and the index table
+ * segments of the previous one, every second */
+static gchar *
+create_partitioned_file (void)
+{
+  GstElement *pipeline;
+  gchar *location, *str;
+  gint fd;
+
+  fd = g_file_open_tmp ("mxfdemux-XXXXXX.mxf", &location, NULL);
+  fail_unless (fd != -1);
+  close (fd);
+
+  str = g_strdup_printf ("videotestsrc num-buffers=250 pattern=ball ! "
+      "video/x-raw,format=(string)v308,width=64,height=48,framerate=25/1 ! "
+      "mxfmux partition-interval=1000000000 ! filesink location=\"%s\"",
+      location);
+  pipeline = gst_parse_launch (str, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (str);
+
+  run_pipeline (pipeline);
+  gst_object_unref (pipeline);
+
+  return location;
+}
+
+/* Returns the checksum of the first frame after a key unit seek */
+static gchar *
+seek_frame (const gchar * location, const gchar * cache_location,
+    GstClockTime position)
+{
+  GstElement *pipeline, *demux, *sink;
+  GstSample *sample;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gchar *str, *checksum;
+
+  str = g_strdup_printf ("filesrc location=\"%s\" ! mxfdemux name=demux ! "
+      "fakesink name=sink", location);
+  pipeline = gst_parse_launch (str, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (str);
+
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "demux");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  if (cache_location)
+    g_object_set (demux, "index-cache-location", cache_location, NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, position));
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  g_object_get (sink, "last-sample", &sample, NULL);
+  fail_unless (sample != NULL);
+  buffer = gst_sample_get_buffer (sample);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), position);
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, map.data,
+      map.size);
+  gst_buffer_unmap (buffer, &map);
+  gst_sample_unref (sample);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (demux);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+
+  return checksum;
+}
+
+GST_START_TEST (test_index_cache)
+{
+  static const GstClockTime positions[] = {
+    0, 40 * GST_MSECOND, 2 * GST_SECOND + 520 * GST_MSECOND,
+    6 * GST_SECOND, 9 * GST_SECOND + 960 * GST_MSECOND
+  };
+  gchar *location, *cache_location, *contents;
+  gsize length;
+  guint i;
+
+  location = create_partitioned_file ();
+  cache_location = g_strconcat (location, ".index", NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (positions); i++) {
+    gchar *expected, *checksum;
+
+    /* The partition headers and index table segments of the file */
+    expected = seek_frame (location, NULL, positions[i]);
+
+    /* The same, written to the cache */
+    g_unlink (cache_location);
+    checksum = seek_frame (location, cache_location, positions[i]);
+    fail_unless_equals_string (checksum, expected);
+    g_free (checksum);
+
+    /* The partitions and index tables from the cache */
+    fail_unless (g_file_get_contents (cache_location, &contents, &length,
+            NULL));
+    fail_unless (length > 56);
+    fail_unless (memcmp (contents, "GstMXFIx", 8) == 0);
+    fail_unless_equals_int (GST_READ_UINT32_BE (contents + 8), 2);
+    /* the header, the body partitions and the footer */
+    fail_unless (GST_READ_UINT32_BE (contents + 52) > 3);
+    g_free (contents);
+
+    checksum = seek_frame (location, cache_location, positions[i]);
+    fail_unless_equals_string (checksum, expected);
+    g_free (checksum);
+
+    g_free (expected);
+  }
+
+  /* A cache of some other file is not used, but replaced */
+  fail_unless (g_file_set_contents (cache_location, "GstMXFIx", 8, NULL));
+  g_free (seek_frame (location, cache_location, 6 * GST_SECOND));
+  fail_unless (g_file_get_contents (cache_location, &contents, &length,
+          NULL));
+  fail_unless (length > 56);
+  g_free (contents);
+
+  g_unlink (cache_location);
+  g_unlink (location);
+  g_free (cache_location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_push)
 {
   GstElement *mxfdemux;
@@ -241,6 +478,7 @@ GST_START_TEST (test_push)
 
   have_data = FALSE;
   have_eos = FALSE;
+  n_pulls = 0;
 
   mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
   fail_unless (mxfdemux != NULL);
@@ -301,6 +539,8 @@ mxfdemux_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_set_timeout (tc_chain, 180);
   tcase_add_test (tc_chain, test_pull);
+  tcase_add_test (tc_chain, test_pull_read_ahead);
+  tcase_add_test (tc_chain, test_index_cache);
   tcase_add_test (tc_chain, test_push);
 
   return s;
@@ -21,7 +21,9 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
+#include <unistd.h>
 
 static const gchar *
 get_mpeg2enc_element_name (void)
@@ -142,6 +144,205 @@ GST_START_TEST (test_raw_video_raw_audio)
 
 GST_END_TEST;
 
+static const guint8 partition_pack_key[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01
+};
+
+static const guint8 index_table_segment_key[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x53, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01, 0x10, 0x01, 0x00
+};
+
+static const guint8 random_index_pack_key[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01, 0x11, 0x01, 0x00
+};
+
+typedef struct
+{
+  guint64 offset;
+  guint8 type;                  /* 0x02 header, 0x03 body, 0x04 footer */
+  guint64 prev_partition;
+  guint64 index_byte_count;
+  guint32 index_sid;
+  guint32 body_sid;
+
+  guint n_index_segments;
+  guint64 index_bytes;
+} Partition;
+
+/* Returns the size of the KLV packet at @offset and its value */
+static gsize
+read_klv (const guint8 * data, gsize size, gsize offset,
+    const guint8 ** value, gsize * value_size)
+{
+  gsize len, n, i;
+
+  fail_unless (offset + 17 <= size);
+  len = data[offset + 16];
+  n = 17;
+  if (len & 0x80) {
+    fail_unless (offset + 17 + (len & 0x7f) <= size);
+    for (i = 0, n = len & 0x7f, len = 0; i < n; i++)
+      len = (len << 8) | data[offset + 17 + i];
+    n += 17;
+  }
+  fail_unless (offset + n + len <= size);
+
+  *value = data + offset + n;
+  *value_size = len;
+
+  return n + len;
+}
+
+/* Start position and duration of an index table segment */
+static void
+parse_index_table_segment (const guint8 * data, gsize size,
+    guint64 * start, guint64 * duration)
+{
+  gsize i = 0;
+
+  *start = *duration = G_MAXUINT64;
+  while (i + 4 <= size) {
+    guint16 tag = GST_READ_UINT16_BE (data + i);
+    guint16 len = GST_READ_UINT16_BE (data + i + 2);
+
+    fail_unless (i + 4 + len <= size);
+    if (tag == 0x3f0c && len == 8)
+      *start = GST_READ_UINT64_BE (data + i + 4);
+    else if (tag == 0x3f0d && len == 8)
+      *duration = GST_READ_UINT64_BE (data + i + 4);
+    i += 4 + len;
+  }
+  fail_unless (*start != G_MAXUINT64 && *duration != G_MAXUINT64);
+}
+
+GST_START_TEST (test_growing_file)
+{
+  GArray *partitions;
+  Partition *p = NULL;
+  gchar *pipeline, *location, *contents;
+  const guint8 *data, *value;
+  gsize size, offset, klv_size, value_size, rip_offset = 0, rip_size = 0;
+  guint64 index_end = 0;
+  guint i, n_body = 0;
+  gint fd;
+
+  fd = g_file_open_tmp ("mxfmux-XXXXXX.mxf", &location, NULL);
+  fail_unless (fd != -1);
+  close (fd);
+
+  pipeline = g_strdup_printf ("videotestsrc num-buffers=250 ! "
+      "video/x-raw,format=(string)v308,width=320,height=240,framerate=25/1 ! "
+      "mxfmux name=mux partition-interval=1000000000 ! "
+      "filesink location=\"%s\" "
+      "audiotestsrc num-buffers=250 ! "
+      "audioconvert ! " "audio/x-raw,rate=48000,channels=2 ! " "mux. ",
+      location);
+
+  run_test (pipeline);
+  g_free (pipeline);
+
+  fail_unless (g_file_get_contents (location, &contents, &size, NULL));
+  data = (const guint8 *) contents;
+
+  /* Walk all KLV packets of the file */
+  partitions = g_array_new (FALSE, TRUE, sizeof (Partition));
+  for (offset = 0; offset < size; offset += klv_size) {
+    fail_unless (rip_size == 0, "Data after the random index pack");
+
+    klv_size = read_klv (data, size, offset, &value, &value_size);
+
+    if (memcmp (data + offset, partition_pack_key,
+            sizeof (partition_pack_key)) == 0
+        && data[offset + 13] >= 0x02 && data[offset + 13] <= 0x04) {
+      Partition partition = { 0, };
+
+      fail_unless (value_size >= 64);
+      partition.offset = offset;
+      partition.type = data[offset + 13];
+      fail_unless_equals_uint64 (GST_READ_UINT64_BE (value + 8), offset);
+      partition.prev_partition = GST_READ_UINT64_BE (value + 16);
+      partition.index_byte_count = GST_READ_UINT64_BE (value + 40);
+      partition.index_sid = GST_READ_UINT32_BE (value + 48);
+      partition.body_sid = GST_READ_UINT32_BE (value + 60);
+      g_array_append_val (partitions, partition);
+      p = &g_array_index (partitions, Partition, partitions->len - 1);
+    } else if (memcmp (data + offset, index_table_segment_key,
+            sizeof (index_table_segment_key)) == 0) {
+      guint64 start, duration;
+
+      fail_unless (p != NULL);
+      p->n_index_segments++;
+      p->index_bytes += klv_size;
+
+      /* The segments of all partitions cover the essence without gaps */
+      parse_index_table_segment (value, value_size, &start, &duration);
+      fail_unless_equals_uint64 (start, index_end);
+      fail_unless (duration > 0);
+      index_end = start + duration;
+    } else if (memcmp (data + offset, random_index_pack_key,
+            sizeof (random_index_pack_key)) == 0) {
+      rip_offset = offset;
+      rip_size = klv_size;
+    }
+  }
+
+  /* header, body partitions, footer */
+  fail_unless (partitions->len > 2);
+  p = &g_array_index (partitions, Partition, 0);
+  fail_unless_equals_int (p->type, 0x02);
+  fail_unless (p->body_sid != 0);
+
+  for (i = 1; i < partitions->len; i++) {
+    p = &g_array_index (partitions, Partition, i);
+
+    fail_unless_equals_uint64 (p->prev_partition,
+        g_array_index (partitions, Partition, i - 1).offset);
+
+    /* Every further partition carries the index of the essence since the
+     * previous one, the footer that of the rest */
+    fail_unless (p->n_index_segments > 0);
+    fail_unless_equals_uint64 (p->index_bytes, p->index_byte_count);
+    fail_unless (p->index_sid != 0);
+
+    if (i < partitions->len - 1) {
+      fail_unless_equals_int (p->type, 0x03);
+      fail_unless (p->body_sid != 0);
+      n_body++;
+    } else {
+      fail_unless_equals_int (p->type, 0x04);
+    }
+  }
+  /* at least one partition for every second of the shorter stream */
+  fail_unless (n_body >= 4);
+  fail_unless (index_end > 0);
+
+  /* The random index pack at the end lists every partition */
+  fail_unless (rip_size > 0);
+  fail_unless_equals_uint64 (rip_offset + rip_size, size);
+  read_klv (data, size, rip_offset, &value, &value_size);
+  fail_unless_equals_int (value_size, partitions->len * 12 + 4);
+  fail_unless_equals_int (GST_READ_UINT32_BE (value + value_size - 4),
+      rip_size);
+  for (i = 0; i < partitions->len; i++) {
+    p = &g_array_index (partitions, Partition, i);
+
+    fail_unless_equals_int (GST_READ_UINT32_BE (value + i * 12),
+        p->body_sid);
+    fail_unless_equals_uint64 (GST_READ_UINT64_BE (value + i * 12 + 4),
+        p->offset);
+  }
+
+  g_array_free (partitions, TRUE);
+  g_free (contents);
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_raw_video_stride_transform)
 {
   gchar *pipeline;
@@ -277,6 +478,7 @@ mxfmux_suite (void)
   tcase_add_test (tc_chain, test_mpeg2);
   tcase_add_test (tc_chain, test_raw_video_raw_audio);
   tcase_add_test (tc_chain, test_raw_video_stride_transform);
+  tcase_add_test (tc_chain, test_growing_file);
   tcase_add_test (tc_chain, test_jpeg2000_alaw);
   tcase_add_test (tc_chain, test_dnxhd_mp3);
   tcase_add_test (tc_chain, test_h264_raw_audio);
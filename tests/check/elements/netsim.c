@@ -49,6 +49,103 @@ GST_START_TEST (netsim_stress_delayed)
 
 GST_END_TEST;
 
+static GstBuffer *
+create_buffer (GstHarness * h, guint64 offset)
+{
+  GstBuffer *buf = gst_harness_create_buffer (h, 100);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  return buf;
+}
+
+static GList *
+push_and_pull_offsets (const gchar * launch, guint n)
+{
+  GstHarness *h = gst_harness_new_parse (launch);
+  GstBuffer *buf;
+  GList *offsets = NULL;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+  for (i = 0; i < n; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_buffer (h, i)),
+        GST_FLOW_OK);
+
+  while ((buf = gst_harness_try_pull (h))) {
+    offsets = g_list_append (offsets,
+        GUINT_TO_POINTER (GST_BUFFER_OFFSET (buf)));
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+  return offsets;
+}
+
+GST_START_TEST (netsim_seed)
+{
+  const gchar *launch = "netsim seed=42 drop-probability=0.5";
+  GList *a = push_and_pull_offsets (launch, 100);
+  GList *b = push_and_pull_offsets (launch, 100);
+  GList *la, *lb;
+
+  fail_unless (g_list_length (a) > 0);
+  fail_unless (g_list_length (a) < 100);
+  fail_unless_equals_int (g_list_length (a), g_list_length (b));
+
+  for (la = a, lb = b; la; la = la->next, lb = lb->next)
+    fail_unless_equals_pointer (la->data, lb->data);
+
+  g_list_free (a);
+  g_list_free (b);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_burst_loss)
+{
+  /* switching state before every buffer drops every other buffer */
+  GList *offsets = push_and_pull_offsets ("netsim "
+      "burst-enter-probability=1.0 burst-exit-probability=1.0", 10);
+  GList *l;
+  guint i;
+
+  fail_unless_equals_int (g_list_length (offsets), 5);
+  for (l = offsets, i = 1; l; l = l->next, i += 2)
+    fail_unless_equals_int (GPOINTER_TO_UINT (l->data), i);
+
+  g_list_free (offsets);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_delay_batch)
+{
+  GstHarness *h = gst_harness_new_parse ("netsim delay-probability=1.0 "
+      "min-delay=100 max-delay=100 allow-reordering=false");
+  GstBuffer *buf;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_buffer (h, i)),
+        GST_FLOW_OK);
+
+  /* nothing goes out before the delay has passed on the test clock */
+  fail_unless (gst_harness_wait_for_clock_id_waits (h, 1, 60));
+  fail_unless_equals_int (gst_harness_buffers_received (h), 0);
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  for (i = 0; i < 3; i++) {
+    buf = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), i);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 netsim_suite (void)
 {
@@ -58,6 +155,9 @@ netsim_suite (void)
   suite_add_tcase (s, (tc_chain = tcase_create ("general")));
   tcase_add_test (tc_chain, netsim_stress);
   tcase_add_test (tc_chain, netsim_stress_delayed);
+  tcase_add_test (tc_chain, netsim_seed);
+  tcase_add_test (tc_chain, netsim_burst_loss);
+  tcase_add_test (tc_chain, netsim_delay_batch);
 
   return s;
 }
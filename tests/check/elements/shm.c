@@ -27,6 +27,9 @@
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
 
+/* for testing the allocator on its own */
+#include "../../sys/shm/shmalloc.h"
+
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -42,7 +45,7 @@ GstElement *src, *sink;
 GstPad *sinkpad, *srcpad;
 
 static void
-setup_shm (void)
+setup_shm_full (gboolean use_ring)
 {
   gchar *socket_path = NULL;
 
@@ -52,7 +55,8 @@ setup_shm (void)
   srcpad = gst_check_setup_src_pad (sink, &src_template);
   sinkpad = gst_check_setup_sink_pad (src, &sink_template);
 
-  g_object_set (sink, "socket-path", "shm-unit-test", NULL);
+  g_object_set (sink, "socket-path", "shm-unit-test", "use-ring", use_ring,
+      NULL);
 
   fail_unless (gst_element_set_state (sink, GST_STATE_PLAYING) ==
       GST_STATE_CHANGE_ASYNC);
@@ -69,6 +73,20 @@ setup_shm (void)
       GST_STATE_CHANGE_SUCCESS);
 }
 
+static void
+setup_shm (void)
+{
+  setup_shm_full (FALSE);
+}
+
+#ifdef __linux__
+static void
+setup_shm_ring (void)
+{
+  setup_shm_full (TRUE);
+}
+#endif
+
 static void
 teardown_shm (void)
 {
@@ -123,6 +141,7 @@ GST_START_TEST (test_shm_alloc)
   GstAllocator *alloc;
   GstAllocationParams params;
   guint size;
+  guint64 high_water_mark;
   GstSegment segment;
 
   gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
@@ -163,12 +182,87 @@ GST_START_TEST (test_shm_alloc)
   buf = buffers->data;
   fail_unless (gst_buffer_get_size (buf) == size);
 
+  /* the whole area was in use while the buffer was out */
+  g_object_get (sink, "high-water-mark", &high_water_mark, NULL);
+  fail_unless (high_water_mark >= size);
+
   gst_check_drop_buffers ();
   teardown_shm ();
 }
 
 GST_END_TEST;
 
+#ifdef __linux__
+GST_START_TEST (test_shm_ring)
+{
+  GstBuffer *buf;
+  GstSegment segment;
+  GstMapInfo map;
+  GList *l;
+  guint i;
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  /* more buffers than the ring holds, they are released as they come in */
+  for (i = 0; i < 3000; i++) {
+    buf = gst_buffer_new_allocate (NULL, 100, NULL);
+    gst_buffer_memset (buf, 0, i & 0xff, 100);
+    fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+
+    g_mutex_lock (&check_mutex);
+    while (buffers == NULL)
+      g_cond_wait (&check_cond, &check_mutex);
+    g_mutex_unlock (&check_mutex);
+
+    l = buffers;
+    fail_unless (gst_buffer_map (l->data, &map, GST_MAP_READ));
+    fail_unless_equals_int (map.size, 100);
+    fail_unless_equals_int (map.data[0], i & 0xff);
+    fail_unless_equals_int (map.data[99], i & 0xff);
+    gst_buffer_unmap (l->data, &map);
+    gst_check_drop_buffers ();
+  }
+
+  teardown_shm ();
+}
+
+GST_END_TEST;
+#endif
+
+GST_START_TEST (test_shm_alloc_space_reuse)
+{
+  const unsigned long frame = 1920 * 1080 * 3 / 2;
+  ShmAllocSpace *space = shm_alloc_space_new (3 * frame);
+  ShmAllocBlock *a, *b, *c;
+
+  a = shm_alloc_space_alloc_block (space, frame);
+  b = shm_alloc_space_alloc_block (space, frame);
+  c = shm_alloc_space_alloc_block (space, frame);
+  fail_unless (a != NULL && b != NULL && c != NULL);
+  fail_unless (shm_alloc_space_alloc_block (space, 1) == NULL);
+
+  /* a free block of exactly the size asked for is found again */
+  shm_alloc_space_block_dec (a);
+  a = shm_alloc_space_alloc_block (space, frame);
+  fail_unless (a != NULL);
+  fail_unless_equals_int (shm_alloc_space_alloc_block_get_offset (a), 0);
+
+  /* and so is one merged from its free neighbours */
+  shm_alloc_space_block_dec (b);
+  shm_alloc_space_block_dec (c);
+  b = shm_alloc_space_alloc_block (space, 2 * frame);
+  fail_unless (b != NULL);
+  fail_unless_equals_int (shm_alloc_space_alloc_block_get_offset (b), frame);
+
+  shm_alloc_space_block_dec (a);
+  shm_alloc_space_block_dec (b);
+  shm_alloc_space_free (space);
+}
+
+GST_END_TEST;
+
 static Suite *
 shm_suite (void)
 {
@@ -181,6 +275,17 @@ shm_suite (void)
   tcase_add_test (tc, test_shm_alloc);
   suite_add_tcase (s, tc);
 
+  tc = tcase_create ("shmalloc");
+  tcase_add_test (tc, test_shm_alloc_space_reuse);
+  suite_add_tcase (s, tc);
+
+#ifdef __linux__
+  tc = tcase_create ("ring");
+  tcase_add_checked_fixture (tc, setup_shm_ring, NULL);
+  tcase_add_test (tc, test_shm_ring);
+  suite_add_tcase (s, tc);
+#endif
+
   return s;
 }
 
@@ -23,6 +23,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <string.h>
 
 #define CAPS_TMPL   "video/x-raw, format=(string)BGR"
 
@@ -156,6 +157,170 @@ GST_START_TEST (test_match_blue_square)
 
 GST_END_TEST;
 
+#define STRIDED_WIDTH 26
+#define STRIDED_HEIGHT 20
+#define STRIDED_STRIDE GST_ROUND_UP_4 (STRIDED_WIDTH * 3)
+#define SQUARE_X 10
+#define SQUARE_Y 8
+
+/* A grey frame whose rows are padded, with the blue 8x8 square at
+ * SQUARE_X,SQUARE_Y. The padding bytes are set to 0xaa. */
+static GstBuffer *
+create_strided_buffer (void)
+{
+  guint8 *data;
+  gsize size;
+  gint i, j;
+
+  size = STRIDED_STRIDE * STRIDED_HEIGHT;
+  data = g_malloc (size);
+  memset (data, 0xaa, size);
+
+  for (j = 0; j < STRIDED_HEIGHT; j++) {
+    guint8 *line = data + j * STRIDED_STRIDE;
+
+    for (i = 0; i < STRIDED_WIDTH; i++) {
+      gboolean blue = i >= SQUARE_X && i < SQUARE_X + 8 && j >= SQUARE_Y
+          && j < SQUARE_Y + 8;
+
+      line[3 * i] = blue ? 255 : 64;
+      line[3 * i + 1] = blue ? 0 : 64;
+      line[3 * i + 2] = blue ? 0 : 64;
+    }
+  }
+
+  return gst_buffer_new_wrapped (data, size);
+}
+
+/* Pushes the strided frame through templatematch, checks the reported
+ * match and returns the output frame */
+static GstBuffer *
+run_strided_match (gboolean display)
+{
+  GstElement *element;
+  GstPad *sinkpad, *srcpad;
+  GstCaps *caps;
+  GstBus *bus;
+  GstMessage *msg;
+  const GstStructure *structure;
+  gchar *path;
+  GstBuffer *outbuf;
+  guint x, y;
+
+  caps = gst_caps_from_string (CAPS_TMPL ", framerate=1/1");
+  gst_caps_set_simple (caps, "width", G_TYPE_INT, STRIDED_WIDTH, "height",
+      G_TYPE_INT, STRIDED_HEIGHT, NULL);
+
+  element = gst_check_setup_element ("templatematch");
+  srcpad = gst_check_setup_src_pad (element, &srctemplate);
+  sinkpad = gst_check_setup_sink_pad (element, &sinktemplate);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_check_setup_events (srcpad, element, caps, GST_FORMAT_TIME);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (element, bus);
+
+  path = g_build_filename (GST_TEST_FILES_PATH, "blue-square.png", NULL);
+  g_object_set (element, "template", path, "display", display, NULL);
+  g_free (path);
+
+  fail_unless (gst_element_set_state (element,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE,
+      "could not set to playing");
+
+  fail_unless (gst_pad_push (srcpad, create_strided_buffer ()) == GST_FLOW_OK);
+
+  /* The cv::Mat view has to step over the padding of each row to find the
+   * square where it is */
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL);
+  structure = gst_message_get_structure (msg);
+  fail_unless (gst_structure_has_name (structure, "template_match"));
+  fail_unless (gst_structure_get_uint (structure, "x", &x));
+  fail_unless (gst_structure_get_uint (structure, "y", &y));
+  fail_unless_equals_int (x, SQUARE_X);
+  fail_unless_equals_int (y, SQUARE_Y);
+  gst_message_unref (msg);
+
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  outbuf = gst_buffer_ref (GST_BUFFER (buffers->data));
+  fail_unless_equals_int (gst_buffer_get_size (outbuf),
+      STRIDED_STRIDE * STRIDED_HEIGHT);
+
+  gst_element_set_state (element, GST_STATE_NULL);
+  gst_bus_set_flushing (bus, TRUE);
+  gst_object_unref (bus);
+  gst_caps_unref (caps);
+  gst_check_drop_buffers ();
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+  gst_check_teardown_src_pad (element);
+  gst_check_teardown_sink_pad (element);
+  gst_check_teardown_element (element);
+
+  return outbuf;
+}
+
+/* Matching works on a view of the frame, it must come out untouched */
+GST_START_TEST (test_match_strided_frame)
+{
+  GstBuffer *inbuf, *outbuf;
+  GstMapInfo in, out;
+
+  inbuf = create_strided_buffer ();
+  outbuf = run_strided_match (FALSE);
+
+  fail_unless (gst_buffer_map (inbuf, &in, GST_MAP_READ));
+  fail_unless (gst_buffer_map (outbuf, &out, GST_MAP_READ));
+  fail_unless (memcmp (in.data, out.data, in.size) == 0);
+  gst_buffer_unmap (outbuf, &out);
+  gst_buffer_unmap (inbuf, &in);
+
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (inbuf);
+}
+
+GST_END_TEST;
+
+/* The match is drawn into the frame itself, around the square, without
+ * touching the rest of the frame nor the row padding */
+GST_START_TEST (test_match_strided_frame_display)
+{
+  GstBuffer *outbuf;
+  GstMapInfo out;
+  guint8 *pixel;
+  gint j;
+
+  outbuf = run_strided_match (TRUE);
+  fail_unless (gst_buffer_map (outbuf, &out, GST_MAP_READ));
+
+  /* top left corner of the rectangle, drawn in BGR (32, x, 255) */
+  pixel = out.data + SQUARE_Y * STRIDED_STRIDE + SQUARE_X * 3;
+  fail_unless_equals_int (pixel[0], 32);
+  fail_unless_equals_int (pixel[2], 255);
+
+  /* far from the rectangle */
+  pixel = out.data;
+  fail_unless_equals_int (pixel[0], 64);
+  fail_unless_equals_int (pixel[1], 64);
+  fail_unless_equals_int (pixel[2], 64);
+
+  for (j = 0; j < STRIDED_HEIGHT; j++) {
+    guint8 *padding = out.data + j * STRIDED_STRIDE + STRIDED_WIDTH * 3;
+
+    fail_unless_equals_int (padding[0], 0xaa);
+    fail_unless_equals_int (padding[1], 0xaa);
+  }
+
+  gst_buffer_unmap (outbuf, &out);
+  gst_buffer_unref (outbuf);
+}
+
+GST_END_TEST;
+
 static Suite *
 templatematch_suite (void)
 {
@@ -164,6 +329,8 @@ templatematch_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_match_blue_square);
+  tcase_add_test (tc_chain, test_match_strided_frame);
+  tcase_add_test (tc_chain, test_match_strided_frame_display);
 
   return s;
 }
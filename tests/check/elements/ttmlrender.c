@@ -0,0 +1,308 @@
+/* GStreamer
+ *
+ * unit test for the render cache of ttmlrender
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+
+#include <string.h>
+
+#include "../../ext/ttml/gstttmlrender.h"
+
+#define WIDTH 320
+#define HEIGHT 240
+#define VIDEO_CAPS "video/x-raw, format=(string) BGRA, width=(int) 320, " \
+    "height=(int) 240, framerate=(fraction) 25/1"
+#define FRAME_SIZE (WIDTH * HEIGHT * 4)
+
+/* Two regions of the same size, so that only their position differs */
+#define TTML_HEAD \
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>" \
+    "<tt xmlns=\"http://www.w3.org/ns/ttml\" " \
+    "xmlns:tts=\"http://www.w3.org/ns/ttml#styling\" xml:lang=\"en\">" \
+    "<head><layout>" \
+    "<region xml:id=\"top\" tts:origin=\"10% 10%\" tts:extent=\"80% 20%\"/>" \
+    "<region xml:id=\"bottom\" tts:origin=\"10% 70%\" " \
+    "tts:extent=\"80% 20%\"/>" \
+    "</layout></head><body><div>"
+#define TTML_TAIL "</div></body></tt>"
+
+/* Appends a cue showing @text in @region from @second for a second */
+static void
+add_cue (GString * doc, const gchar * region, guint second, const gchar * text)
+{
+  g_string_append_printf (doc, "<p region=\"%s\" "
+      "begin=\"%02u:%02u:%02u.000\" end=\"%02u:%02u:%02u.000\">%s</p>",
+      region, second / 3600, second / 60 % 60, second % 60,
+      (second + 1) / 3600, (second + 1) / 60 % 60, (second + 1) % 60, text);
+}
+
+/* Runs @doc through ttmlparse and returns the scenes it made of it */
+static GList *
+parse_cues (GString * doc)
+{
+  GstHarness *parse = gst_harness_new ("ttmlparse");
+  GList *cues = NULL;
+  GstBuffer *buf;
+  gsize len;
+
+  g_string_append (doc, TTML_TAIL);
+  len = doc->len;
+  buf = gst_buffer_new_wrapped (g_string_free (doc, FALSE), len);
+  GST_BUFFER_PTS (buf) = 0;
+
+  gst_harness_set_src_caps_str (parse, "application/ttml+xml");
+  fail_unless_equals_int (gst_harness_push (parse, buf), GST_FLOW_OK);
+  while ((buf = gst_harness_try_pull (parse)))
+    cues = g_list_append (cues, buf);
+
+  gst_harness_teardown (parse);
+
+  return cues;
+}
+
+static GstHarness *
+setup_ttmlrender (GstHarness ** text)
+{
+  GstHarness *h;
+
+  h = gst_harness_new_with_padnames ("ttmlrender", "video_sink", "src");
+  gst_harness_set_src_caps_str (h, VIDEO_CAPS);
+
+  *text = gst_harness_new_with_element (h->element, "text_sink", NULL);
+  gst_harness_set_src_caps_str (*text, "text/x-raw(meta:GstSubtitleMeta)");
+
+  return h;
+}
+
+/* Pushes @cue and a black frame for as long as it lasts, and returns the
+ * frame with the cue rendered on it */
+static GstBuffer *
+render_cue (GstHarness * h, GstHarness * text, GstBuffer * cue)
+{
+  GstBuffer *frame = gst_buffer_new_allocate (NULL, FRAME_SIZE, NULL);
+
+  gst_buffer_memset (frame, 0, 0, FRAME_SIZE);
+  GST_BUFFER_PTS (frame) = GST_BUFFER_PTS (cue);
+  GST_BUFFER_DURATION (frame) = GST_BUFFER_DURATION (cue);
+
+  fail_unless_equals_int (gst_harness_push (text, gst_buffer_ref (cue)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_push (h, frame), GST_FLOW_OK);
+
+  return gst_harness_pull (h);
+}
+
+static gboolean
+frame_is_black (GstBuffer * frame)
+{
+  guint8 *black = g_malloc0 (FRAME_SIZE);
+  gboolean ret;
+
+  ret = gst_buffer_memcmp (frame, 0, black, FRAME_SIZE) == 0;
+  g_free (black);
+
+  return ret;
+}
+
+static void
+check_frames_equal (GstBuffer * a, GstBuffer * b)
+{
+  GstMapInfo map;
+
+  fail_unless (gst_buffer_map (a, &map, GST_MAP_READ));
+  fail_unless_equals_int (gst_buffer_get_size (b), map.size);
+  fail_unless (gst_buffer_memcmp (b, 0, map.data, map.size) == 0);
+  gst_buffer_unmap (a, &map);
+}
+
+/* A region showing what it showed before keeps its composition */
+GST_START_TEST (test_cache_hit)
+{
+  GstHarness *h, *text;
+  GstTtmlRender *render;
+  GstVideoOverlayComposition *composition;
+  GstBuffer *first, *out;
+  GString *doc = g_string_new (TTML_HEAD);
+  GList *cues;
+  guint n_entries;
+
+  add_cue (doc, "top", 0, "Hello");
+  add_cue (doc, "top", 1, "World");
+  add_cue (doc, "top", 2, "Hello");
+  cues = parse_cues (doc);
+  fail_unless_equals_int (g_list_length (cues), 3);
+
+  h = setup_ttmlrender (&text);
+  render = (GstTtmlRender *) h->element;
+
+  first = render_cue (h, text, g_list_nth_data (cues, 0));
+  fail_if (frame_is_black (first));
+  fail_unless (render->compositions != NULL);
+  composition =
+      gst_video_overlay_composition_ref (render->compositions->data);
+
+  out = render_cue (h, text, g_list_nth_data (cues, 1));
+  fail_unless (render->compositions->data != composition);
+  n_entries = g_hash_table_size (render->cache);
+  gst_buffer_unref (out);
+
+  out = render_cue (h, text, g_list_nth_data (cues, 2));
+  fail_unless (render->compositions->data == composition);
+  fail_unless_equals_int (g_hash_table_size (render->cache), n_entries);
+  check_frames_equal (out, first);
+  gst_buffer_unref (out);
+
+  gst_video_overlay_composition_unref (composition);
+  gst_buffer_unref (first);
+  gst_harness_teardown (text);
+  gst_harness_teardown (h);
+  g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_END_TEST;
+
+/* A region that reuses the lines and text of another one looks the same as
+ * one rendered from scratch */
+GST_START_TEST (test_warm_cache)
+{
+  GstHarness *h, *text;
+  GstTtmlRender *render;
+  GstBuffer *cold, *warm;
+  GString *doc;
+  GList *cues;
+  guint n_entries, n_cold_entries;
+
+  doc = g_string_new (TTML_HEAD);
+  add_cue (doc, "bottom", 1, "Hello");
+  cues = parse_cues (doc);
+  fail_unless_equals_int (g_list_length (cues), 1);
+
+  h = setup_ttmlrender (&text);
+  render = (GstTtmlRender *) h->element;
+  cold = render_cue (h, text, g_list_nth_data (cues, 0));
+  fail_if (frame_is_black (cold));
+  n_cold_entries = g_hash_table_size (render->cache);
+  gst_harness_teardown (text);
+  gst_harness_teardown (h);
+  g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+
+  doc = g_string_new (TTML_HEAD);
+  add_cue (doc, "top", 0, "Hello");
+  add_cue (doc, "bottom", 1, "Hello");
+  cues = parse_cues (doc);
+  fail_unless_equals_int (g_list_length (cues), 2);
+
+  h = setup_ttmlrender (&text);
+  render = (GstTtmlRender *) h->element;
+  gst_buffer_unref (render_cue (h, text, g_list_nth_data (cues, 0)));
+  n_entries = g_hash_table_size (render->cache);
+  warm = render_cue (h, text, g_list_nth_data (cues, 1));
+  /* only the region itself had to be rendered again */
+  fail_unless (g_hash_table_size (render->cache) - n_entries <
+      n_cold_entries);
+  check_frames_equal (warm, cold);
+
+  gst_buffer_unref (cold);
+  gst_buffer_unref (warm);
+  gst_harness_teardown (text);
+  gst_harness_teardown (h);
+  g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_END_TEST;
+
+/* Entries that weren't used recently are dropped once there are too many
+ * of them, and are rendered again the same way when they come back */
+GST_START_TEST (test_cache_eviction)
+{
+  GstHarness *h, *text;
+  GstTtmlRender *render;
+  GstVideoOverlayComposition *composition;
+  GstBuffer *first, *out;
+  GString *doc = g_string_new (TTML_HEAD);
+  GList *cues, *l;
+  gboolean pruned = FALSE;
+  guint i, n_entries, prev_n_entries = 0;
+
+  for (i = 0; i < GST_TTML_RENDER_CACHE_SIZE; i++) {
+    gchar *cue_text = g_strdup_printf ("Cue %u", i);
+
+    add_cue (doc, "top", i, cue_text);
+    g_free (cue_text);
+  }
+  add_cue (doc, "top", i, "Cue 0");
+  cues = parse_cues (doc);
+  fail_unless_equals_int (g_list_length (cues),
+      GST_TTML_RENDER_CACHE_SIZE + 1);
+
+  h = setup_ttmlrender (&text);
+  render = (GstTtmlRender *) h->element;
+
+  first = render_cue (h, text, cues->data);
+  composition =
+      gst_video_overlay_composition_ref (render->compositions->data);
+
+  for (l = cues->next; l->next; l = l->next) {
+    gst_buffer_unref (render_cue (h, text, l->data));
+    n_entries = g_hash_table_size (render->cache);
+    fail_unless (n_entries <= GST_TTML_RENDER_CACHE_SIZE);
+    if (n_entries < prev_n_entries)
+      pruned = TRUE;
+    prev_n_entries = n_entries;
+  }
+  fail_unless (pruned);
+
+  /* the first cue is gone from the cache and rendered again */
+  out = render_cue (h, text, l->data);
+  fail_unless (render->compositions->data != composition);
+  check_frames_equal (out, first);
+
+  gst_buffer_unref (out);
+  gst_buffer_unref (first);
+  gst_video_overlay_composition_unref (composition);
+  gst_harness_teardown (text);
+  gst_harness_teardown (h);
+  g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_END_TEST;
+
+static Suite *
+ttmlrender_suite (void)
+{
+  Suite *s = suite_create ("ttmlrender");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_cache_hit);
+  tcase_add_test (tc_chain, test_warm_cache);
+  tcase_add_test (tc_chain, test_cache_eviction);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ttmlrender);
@@ -0,0 +1,251 @@
+/* GStreamer
+ *
+ * Unit tests for webrtcfanout
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/rtp/rtp.h>
+#include <gst/video/video.h>
+
+#define VP8_RTP_CAPS "application/x-rtp,payload=96,encoding-name=VP8,media=video,clock-rate=90000,ssrc=(uint)3484078950"
+#define INPUT_SSRC 3484078950u
+#define NUM_PEERS 50
+
+static GstBuffer *
+create_rtp_buffer (guint16 seqnum, guint32 rtptime, gboolean keyframe)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf = gst_rtp_buffer_new_allocate (1200, 0, 0);
+
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, 96);
+  gst_rtp_buffer_set_seq (&rtp, seqnum);
+  gst_rtp_buffer_set_timestamp (&rtp, rtptime);
+  gst_rtp_buffer_set_ssrc (&rtp, INPUT_SSRC);
+  memset (gst_rtp_buffer_get_payload (&rtp), seqnum & 0xff, 1200);
+  gst_rtp_buffer_unmap (&rtp);
+
+  if (!keyframe)
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  return buf;
+}
+
+static guint
+count_force_key_unit (GstHarness * h)
+{
+  GstEvent *event;
+  guint n = 0;
+
+  while ((event = gst_harness_try_pull_upstream_event (h))) {
+    if (gst_video_event_is_force_key_unit (event))
+      n++;
+    gst_event_unref (event);
+  }
+
+  return n;
+}
+
+static GstHarness *
+setup_input (guint64 min_keyframe_interval)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("webrtcfanout", "sink", NULL);
+
+  g_object_set (h->element, "min-keyframe-interval", min_keyframe_interval,
+      NULL);
+  gst_harness_set_src_caps_str (h, VP8_RTP_CAPS);
+
+  return h;
+}
+
+GST_START_TEST (test_fanout_many_peers)
+{
+  GstHarness *h = setup_input (0);
+  GstHarness *peers[NUM_PEERS];
+  GHashTable *ssrcs = g_hash_table_new (NULL, NULL);
+  guint i, j;
+
+  for (i = 0; i < NUM_PEERS; i++)
+    peers[i] = gst_harness_new_with_element (h->element, NULL, "src_%u");
+
+  for (j = 0; j < 10; j++) {
+    GstBuffer *buf = create_rtp_buffer (1000 + j, 90000 + j * 3000, j == 0);
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+
+  for (i = 0; i < NUM_PEERS; i++) {
+    GstPad *srcpad = GST_PAD_PEER (peers[i]->sinkpad);
+    guint ssrc, caps_ssrc, seqnum_offset, ts_offset;
+    GstCaps *caps;
+    GstStructure *s;
+
+    g_object_get (srcpad, "ssrc", &ssrc, "seqnum-offset", &seqnum_offset,
+        "timestamp-offset", &ts_offset, NULL);
+    fail_if (g_hash_table_contains (ssrcs, GUINT_TO_POINTER (ssrc)));
+    g_hash_table_add (ssrcs, GUINT_TO_POINTER (ssrc));
+
+    caps = gst_pad_get_current_caps (peers[i]->sinkpad);
+    fail_unless (caps != NULL);
+    s = gst_caps_get_structure (caps, 0);
+    fail_unless (gst_structure_get_uint (s, "ssrc", &caps_ssrc));
+    fail_unless_equals_int (caps_ssrc, ssrc);
+    gst_caps_unref (caps);
+
+    for (j = 0; j < 10; j++) {
+      GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+      GstBuffer *buf = gst_harness_pull (peers[i]);
+      guint8 *payload;
+
+      /* header is per peer, payload is shared */
+      fail_unless_equals_int (gst_buffer_n_memory (buf), 2);
+
+      fail_unless (gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp));
+      fail_unless_equals_int (gst_rtp_buffer_get_ssrc (&rtp), ssrc);
+      fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp),
+          (guint16) (1000 + j + seqnum_offset));
+      fail_unless_equals_int (gst_rtp_buffer_get_timestamp (&rtp),
+          (guint32) (90000 + j * 3000 + ts_offset));
+      fail_unless_equals_int (gst_rtp_buffer_get_payload_type (&rtp), 96);
+      fail_unless_equals_int (gst_rtp_buffer_get_payload_len (&rtp), 1200);
+      payload = gst_rtp_buffer_get_payload (&rtp);
+      fail_unless_equals_int (payload[0], (1000 + j) & 0xff);
+      fail_unless_equals_int (payload[1199], (1000 + j) & 0xff);
+      gst_rtp_buffer_unmap (&rtp);
+
+      gst_buffer_unref (buf);
+    }
+  }
+  fail_unless_equals_int (g_hash_table_size (ssrcs), NUM_PEERS);
+  g_hash_table_unref (ssrcs);
+
+  for (i = 0; i < NUM_PEERS; i++)
+    gst_harness_teardown (peers[i]);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_fanout_keyframe_aggregation)
+{
+  GstHarness *h = setup_input (0);
+  GstHarness *peers[NUM_PEERS];
+  GstStructure *stats;
+  guint64 received, forwarded;
+  guint i;
+
+  for (i = 0; i < NUM_PEERS; i++)
+    peers[i] = gst_harness_new_with_element (h->element, NULL, "src_%u");
+
+  fail_unless_equals_int (gst_harness_push (h,
+          create_rtp_buffer (0, 0, TRUE)), GST_FLOW_OK);
+  count_force_key_unit (h);
+
+  /* every peer asks for a key unit, only one request makes it upstream */
+  for (i = 0; i < NUM_PEERS; i++) {
+    fail_unless (gst_harness_push_upstream_event (peers[i],
+            gst_video_event_new_upstream_force_key_unit (GST_CLOCK_TIME_NONE,
+                TRUE, 0)));
+  }
+  fail_unless_equals_int (count_force_key_unit (h), 1);
+
+  /* once the key unit was sent, the next request goes through again */
+  fail_unless_equals_int (gst_harness_push (h,
+          create_rtp_buffer (1, 0, TRUE)), GST_FLOW_OK);
+  for (i = 0; i < NUM_PEERS; i++) {
+    fail_unless (gst_harness_push_upstream_event (peers[i],
+            gst_video_event_new_upstream_force_key_unit (GST_CLOCK_TIME_NONE,
+                TRUE, 0)));
+  }
+  fail_unless_equals_int (count_force_key_unit (h), 1);
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "keyframe-requests-received",
+          &received));
+  fail_unless (gst_structure_get_uint64 (stats, "keyframe-requests-forwarded",
+          &forwarded));
+  fail_unless_equals_int (received, 2 * NUM_PEERS);
+  fail_unless_equals_int (forwarded, 2);
+  gst_structure_free (stats);
+
+  for (i = 0; i < NUM_PEERS; i++)
+    gst_harness_teardown (peers[i]);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_fanout_late_peer_waits_for_keyframe)
+{
+  GstHarness *h = setup_input (0);
+  GstHarness *early, *late;
+
+  early = gst_harness_new_with_element (h->element, NULL, "src_%u");
+
+  fail_unless_equals_int (gst_harness_push (h,
+          create_rtp_buffer (0, 0, TRUE)), GST_FLOW_OK);
+  count_force_key_unit (h);
+
+  late = gst_harness_new_with_element (h->element, NULL, "src_%u");
+
+  /* the new peer can't decode deltas, it asks for a key unit instead */
+  fail_unless_equals_int (gst_harness_push (h,
+          create_rtp_buffer (1, 3000, FALSE)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (early), 2);
+  fail_unless_equals_int (gst_harness_buffers_received (late), 0);
+  fail_unless_equals_int (count_force_key_unit (h), 1);
+
+  /* further deltas don't cause more requests */
+  fail_unless_equals_int (gst_harness_push (h,
+          create_rtp_buffer (2, 6000, FALSE)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (late), 0);
+  fail_unless_equals_int (count_force_key_unit (h), 0);
+
+  fail_unless_equals_int (gst_harness_push (h,
+          create_rtp_buffer (3, 9000, TRUE)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (early), 4);
+  fail_unless_equals_int (gst_harness_buffers_received (late), 1);
+
+  gst_harness_teardown (early);
+  gst_harness_teardown (late);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+webrtcfanout_suite (void)
+{
+  Suite *s = suite_create ("webrtcfanout");
+  TCase *tc = tcase_create ("general");
+
+  tcase_add_test (tc, test_fanout_many_peers);
+  tcase_add_test (tc, test_fanout_keyframe_aggregation);
+  tcase_add_test (tc, test_fanout_late_peer_waits_for_keyframe);
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+GST_CHECK_MAIN (webrtcfanout);
@@ -0,0 +1,196 @@
+/* GStreamer
+ *
+ * unit test for the yadif line filters
+ *
+ * Copyright (C) 2018 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#include "../../gst/yadif/yadif.h"
+
+/* Most pixels a kernel is asked to filter. The lines have some slack on
+ * both sides for the pixels the filter looks at around the filtered ones,
+ * and for the kernels' loads */
+#define MAX_WIDTH 256
+#define SLACK 32
+#define STRIDE (MAX_WIDTH + 2 * SLACK)
+/* The filter looks two lines up and down */
+#define N_LINES 5
+#define N_RUNS 100
+
+typedef struct
+{
+  guint8 *prev, *cur, *next;
+  guint8 *dst_ref, *dst;
+} TestLines;
+
+static void
+test_lines_init (TestLines * lines, gint pixel_size)
+{
+  lines->prev = g_malloc (N_LINES * STRIDE * pixel_size);
+  lines->cur = g_malloc (N_LINES * STRIDE * pixel_size);
+  lines->next = g_malloc (N_LINES * STRIDE * pixel_size);
+  lines->dst_ref = g_malloc (STRIDE * pixel_size);
+  lines->dst = g_malloc (STRIDE * pixel_size);
+}
+
+static void
+test_lines_clear (TestLines * lines)
+{
+  g_free (lines->prev);
+  g_free (lines->cur);
+  g_free (lines->next);
+  g_free (lines->dst_ref);
+  g_free (lines->dst);
+}
+
+/* Noise of @depth bits, or only black and white pixels to hit the ends of
+ * the range */
+static void
+fill_random (GRand * rand, guint8 * data, gint depth, gboolean extremes)
+{
+  gint max = (1 << depth) - 1;
+  gint i;
+
+  for (i = 0; i < N_LINES * STRIDE; i++) {
+    gint v;
+
+    if (extremes)
+      v = g_rand_boolean (rand) ? max : 0;
+    else
+      v = g_rand_int_range (rand, 0, max + 1);
+
+    if (depth > 8)
+      ((guint16 *) data)[i] = v;
+    else
+      data[i] = v;
+  }
+}
+
+/* Runs @kernel and the C filter on random lines of @depth bits, in every
+ * mode and parity, and compares the destination lines byte for byte */
+static void
+check_kernel (YadifFilterLineFunc kernel, gint step, gint depth)
+{
+  YadifFilterLineFunc reference;
+  gint pixel_size = depth > 8 ? 2 : 1;
+  gsize offset = (2 * STRIDE + SLACK) * pixel_size;
+  GRand *rand = g_rand_new_with_seed (depth);
+  TestLines lines;
+  gint run;
+
+  reference = depth > 8 ? yadif_filter_line_c_16bit : yadif_filter_line_c;
+  test_lines_init (&lines, pixel_size);
+
+  for (run = 0; run < N_RUNS; run++) {
+    gint w = step * g_rand_int_range (rand, 1, MAX_WIDTH / step + 1);
+    gboolean extremes = run % 4 == 3;
+    gint mode, parity, i;
+
+    fill_random (rand, lines.prev, depth, extremes);
+    fill_random (rand, lines.cur, depth, extremes);
+    fill_random (rand, lines.next, depth, extremes);
+
+    for (mode = 0; mode < 4; mode++) {
+      for (parity = 0; parity < 2; parity++) {
+        memset (lines.dst_ref, 0xa5, STRIDE * pixel_size);
+        memset (lines.dst, 0xa5, STRIDE * pixel_size);
+
+        reference (lines.dst_ref + SLACK * pixel_size, lines.prev + offset,
+            lines.cur + offset, lines.next + offset, w, STRIDE, -STRIDE,
+            parity, mode);
+        kernel (lines.dst + SLACK * pixel_size, lines.prev + offset,
+            lines.cur + offset, lines.next + offset, w, STRIDE, -STRIDE,
+            parity, mode);
+
+        for (i = 0; i < STRIDE * pixel_size; i++) {
+          if (lines.dst[i] != lines.dst_ref[i])
+            fail ("%d bit, width %d, mode %d, parity %d: byte %d of pixel %d "
+                "is %u instead of %u", depth, w, mode, parity, i % pixel_size,
+                i / pixel_size - SLACK, lines.dst[i], lines.dst_ref[i]);
+        }
+      }
+    }
+  }
+
+  test_lines_clear (&lines);
+  g_rand_free (rand);
+}
+
+#ifdef HAVE_CPU_X86_64
+GST_START_TEST (test_sse2)
+{
+  check_kernel (filter_line_x86_64, YADIF_SSE2_STEP, 8);
+}
+
+GST_END_TEST;
+#endif
+
+#ifdef HAVE_YADIF_AVX2
+GST_START_TEST (test_avx2)
+{
+  if (!yadif_have_avx2 ())
+    return;
+
+  check_kernel (yadif_filter_line_avx2, YADIF_AVX2_STEP, 8);
+  check_kernel (yadif_filter_line_16bit_avx2, YADIF_AVX2_STEP, 10);
+  check_kernel (yadif_filter_line_16bit_avx2, YADIF_AVX2_STEP, 12);
+}
+
+GST_END_TEST;
+#endif
+
+#ifdef HAVE_YADIF_NEON
+GST_START_TEST (test_neon)
+{
+  check_kernel (yadif_filter_line_neon, YADIF_NEON_STEP, 8);
+  check_kernel (yadif_filter_line_16bit_neon, YADIF_NEON_STEP, 10);
+  check_kernel (yadif_filter_line_16bit_neon, YADIF_NEON_STEP, 12);
+}
+
+GST_END_TEST;
+#endif
+
+static Suite *
+yadif_suite (void)
+{
+  Suite *s = suite_create ("yadif");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+#ifdef HAVE_CPU_X86_64
+  tcase_add_test (tc_chain, test_sse2);
+#endif
+#ifdef HAVE_YADIF_AVX2
+  tcase_add_test (tc_chain, test_avx2);
+#endif
+#ifdef HAVE_YADIF_NEON
+  tcase_add_test (tc_chain, test_neon);
+#endif
+
+  return s;
+}
+
+GST_CHECK_MAIN (yadif);
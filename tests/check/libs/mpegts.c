@@ -560,6 +560,54 @@ GST_START_TEST (test_mpegts_dvb_descriptors)
 
 GST_END_TEST;
 
+/* Bitwise reference implementation */
+static guint32
+crc32_ref (const guint8 * data, gsize size)
+{
+  guint32 crc = 0xffffffff;
+  gint i;
+
+  while (size--) {
+    crc ^= (guint32) * data++ << 24;
+    for (i = 0; i < 8; i++)
+      crc = (crc << 1) ^ ((crc & 0x80000000) ? 0x04c11db7 : 0);
+  }
+
+  return crc;
+}
+
+GST_START_TEST (test_mpegts_crc32)
+{
+  guint8 data[4200];
+  gsize size, offset;
+  guint32 crc;
+  GRand *rand;
+
+  fail_unless_equals_int (gst_mpegts_crc32 ((const guint8 *) "123456789", 9),
+      0x0376e6e7);
+  fail_unless_equals_int (gst_mpegts_crc32 (NULL, 0), 0xffffffff);
+
+  rand = g_rand_new_with_seed (1);
+  for (size = 0; size < sizeof (data); size++)
+    data[size] = g_rand_int_range (rand, 0, 256);
+  g_rand_free (rand);
+
+  /* All the size classes of the folding and the tails, at unaligned
+   * addresses too */
+  for (size = 0; size <= 4096; size++) {
+    for (offset = 0; offset < 4; offset++)
+      fail_unless_equals_int (gst_mpegts_crc32 (data + offset, size),
+          crc32_ref (data + offset, size));
+  }
+
+  /* Over the data and its CRC the result is 0 */
+  crc = gst_mpegts_crc32 (data, 1020);
+  GST_WRITE_UINT32_BE (data + 1020, crc);
+  fail_unless_equals_int (gst_mpegts_crc32 (data, 1024), 0);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegts_suite (void)
 {
@@ -577,6 +625,7 @@ mpegts_suite (void)
   tcase_add_test (tc_chain, test_mpegts_atsc_stt);
   tcase_add_test (tc_chain, test_mpegts_descriptors);
   tcase_add_test (tc_chain, test_mpegts_dvb_descriptors);
+  tcase_add_test (tc_chain, test_mpegts_crc32);
 
   return s;
 }
@@ -1628,6 +1628,104 @@ START_TEST (test_restart)
 
 END_TEST;
 
+static void
+test_preload_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  fail_unless (change != STATE_CHANGE_ERROR);
+}
+
+static void
+time_to_first_frame_cb (GstPlayer * player, GstClockTime ttff,
+    gboolean preloaded, TestPlayerState * state)
+{
+  fail_unless (GST_CLOCK_TIME_IS_VALID (ttff));
+  state->test_data = GINT_TO_POINTER (preloaded ? 2 : 1);
+  g_main_loop_quit (state->loop);
+}
+
+START_TEST (test_preload)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  GstElement *old_pipeline, *pipeline, *sink;
+  GstPlayerMediaInfo *media_info;
+  GstState pipeline_state;
+  gchar *uri, *pipeline_uri;
+  gboolean sync;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_preload_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+  g_signal_connect (player, "time-to-first-frame",
+      G_CALLBACK (time_to_first_frame_cb), &state);
+
+  old_pipeline = gst_player_get_pipeline (player);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_preload_uri (player, uri);
+  gst_player_set_uri (player, uri);
+
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 2);
+
+  /* the standby pipeline replaced the old one and is the one playing */
+  pipeline = gst_player_get_pipeline (player);
+  fail_unless (pipeline != old_pipeline);
+  g_object_get (pipeline, "current-uri", &pipeline_uri, NULL);
+  fail_unless_equals_string (pipeline_uri, uri);
+  g_free (pipeline_uri);
+  fail_unless (gst_element_get_state (pipeline, &pipeline_state, NULL,
+          GST_CLOCK_TIME_NONE) != GST_STATE_CHANGE_FAILURE);
+  fail_unless (pipeline_state >= GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (old_pipeline, &pipeline_state, NULL,
+          0) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (pipeline_state, GST_STATE_NULL);
+
+  /* with a clone of the old video sink */
+  g_object_get (old_pipeline, "video-sink", &sink, NULL);
+  fail_unless (sink != NULL);
+  fail_if (gst_object_has_as_ancestor (GST_OBJECT (sink),
+          GST_OBJECT (pipeline)));
+  gst_object_unref (sink);
+  g_object_get (pipeline, "video-sink", &sink, NULL);
+  fail_unless (sink != NULL);
+  fail_unless (gst_object_has_as_ancestor (GST_OBJECT (sink),
+          GST_OBJECT (pipeline)));
+  g_object_get (sink, "sync", &sync, NULL);
+  fail_unless (sync);
+  gst_object_unref (sink);
+
+  /* the tags and duration posted while in standby reached the player */
+  media_info = gst_player_get_media_info (player);
+  fail_unless (media_info != NULL);
+  fail_unless (gst_player_media_info_get_tags (media_info) != NULL);
+  fail_unless_equals_string (gst_player_media_info_get_container_format
+      (media_info), "Ogg");
+  fail_unless (GST_CLOCK_TIME_IS_VALID (gst_player_media_info_get_duration
+          (media_info)));
+  g_object_unref (media_info);
+  fail_unless (GST_CLOCK_TIME_IS_VALID (gst_player_get_duration (player)));
+
+  gst_object_unref (pipeline);
+  gst_object_unref (old_pipeline);
+  g_free (uri);
+
+  stop_player (player, &state);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
 #define TEST_USER_AGENT "test user agent"
 
 static void
@@ -1722,6 +1820,7 @@ player_suite (void)
   tcase_add_test (tc_general, test_play_backward_rate);
   tcase_add_test (tc_general, test_play_audio_video_seek_done);
   tcase_add_test (tc_general, test_restart);
+  tcase_add_test (tc_general, test_preload);
   tcase_add_test (tc_general, test_user_agent);
 
   suite_add_tcase (s, tc_general);